@@ -0,0 +1,480 @@
+/** ***************************************************************************
+	\file arena.enh.h
+
+	\brief The file to declare class arena, a region allocator released at
+	once, and arena_allocator, the standard allocator over it
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef ARENA_ENH_H
+
+#define ARENA_ENH_H						arena.enh.h
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <string>
+#include <type_traits>
+
+namespace enh
+{
+
+	/**
+		\brief The class for a region of memory that objects are carved from
+		by bumping a pointer, and that is given back all at once.
+
+		Memory comes from an optional buffer given on construction (on the
+		stack for example), then from blocks taken from operator new as
+		needed. Small blocks (upto max_pooled bytes, aligned to at most
+		granularity) that are deallocated go to a free list of their size
+		class and are reused, so containers that allocate and free nodes
+		(like the deque of a queue) do not grow the arena without bound.
+		Other deallocations are ignored till reset.\n\n
+
+		reset rewinds to the start in O(1), keeping every block for the
+		next round of work, release also gives the blocks back. Objects in
+		the arena are not destroyed by either, use it for trivially
+		destructible objects or containers destroyed before the reset.\n\n
+
+		Not thread safe, one arena per thread or per request, or guarded by
+		the user (like queued_process does for its queue).\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class arena
+	{
+	public:
+
+		/**
+			\brief The largest size that is pooled on deallocation.
+		*/
+		static constexpr std::size_t max_pooled = 512;
+
+		/**
+			\brief The size classes of the pool, and the largest alignment
+			pooled.
+		*/
+		static constexpr std::size_t granularity = 16;
+
+	private:
+
+		/**
+			\brief The header of a block from operator new, the memory
+			follows it.
+		*/
+		struct alignas(std::max_align_t) block
+		{
+			block* next;
+			std::size_t size;
+
+			inline char* begin() noexcept { return reinterpret_cast<char*>(this + 1); }
+			inline char* end() noexcept { return begin() + size; }
+		};
+
+		/**
+			\brief A freed small allocation, linked in its size class.
+		*/
+		struct free_node
+		{
+			free_node* next;
+		};
+
+		static constexpr std::size_t class_count = max_pooled / granularity;
+
+		/**
+			\brief The buffer given on construction, nullptr if none.
+		*/
+		char* initial = nullptr;
+
+		/**
+			\brief The size of initial.
+		*/
+		std::size_t initialSize = 0;
+
+		/**
+			\brief The first block from operator new.
+		*/
+		block* head = nullptr;
+
+		/**
+			\brief The block allocated from, nullptr while in initial.
+		*/
+		block* current = nullptr;
+
+		/**
+			\brief The next free byte.
+		*/
+		char* cursor = nullptr;
+
+		/**
+			\brief The end of the memory allocated from.
+		*/
+		char* limit = nullptr;
+
+		/**
+			\brief The size of the next block from operator new.
+		*/
+		std::size_t blockSize;
+
+		/**
+			\brief The free lists of the size classes.
+		*/
+		free_node* pool[class_count] = {};
+
+		/**
+			\brief The bytes handed out since the last reset.
+		*/
+		std::size_t usedBytes = 0;
+
+		static inline char* align_up(char* p, std::size_t align) noexcept
+		{
+			auto at = reinterpret_cast<std::uintptr_t>(p);
+			return p + ((align - at % align) % align);
+		}
+
+		static constexpr inline std::size_t class_of(std::size_t size) noexcept
+		{
+			return (size == 0) ? 0 : (size - 1) / granularity;
+		}
+
+		/**
+			\brief Moves to the next block able to hold size bytes aligned to
+			align, making one if none is left.
+		*/
+		char* allocate_slow(std::size_t size, std::size_t align)
+		{
+			block* next = current ? current->next : head;
+			while (next)
+			{
+				char* p = align_up(next->begin(), align);
+				if (p + size <= next->end())
+				{
+					current = next;
+					limit = next->end();
+					cursor = p + size;
+					return p;
+				}
+				next = next->next;
+			}
+			std::size_t want = size + align;
+			std::size_t bytes = (want > blockSize) ? want : blockSize;
+			void* raw = ::operator new(sizeof(block) + bytes);
+			block* made = ::new (raw) block{ nullptr, bytes };
+			// linked after current, so a reset walks the blocks in the
+			// order they were used
+			if (current)
+			{
+				made->next = current->next;
+				current->next = made;
+			}
+			else
+			{
+				made->next = head;
+				head = made;
+			}
+			if (blockSize < (std::numeric_limits<std::size_t>::max)() / 2 && want <= blockSize)
+				blockSize *= 2;
+			current = made;
+			limit = made->end();
+			char* p = align_up(made->begin(), align);
+			cursor = p + size;
+			return p;
+		}
+
+	public:
+
+		/**
+			\brief An arena taking blocks of blockBytes (doubling as it
+			grows) from operator new.
+		*/
+		explicit arena(
+			std::size_t blockBytes = 4096 /**< : <i>in</i> : The size of the
+										  first block.*/
+		) noexcept : blockSize(blockBytes ? blockBytes : 4096) {}
+
+		/**
+			\brief An arena allocating from buffer first, then from blocks of
+			blockBytes from operator new.
+		*/
+		arena(
+			void* buffer /**< : <i>in</i> : The memory to use first, must
+						 outlive the arena.*/,
+			std::size_t size /**< : <i>in</i> : The size of buffer.*/,
+			std::size_t blockBytes = 4096 /**< : <i>in</i> : The size of the
+										  first block.*/
+		) noexcept : initial(static_cast<char*>(buffer)), initialSize(size),
+			cursor(initial), limit(initial + size), blockSize(blockBytes ? blockBytes : 4096) {}
+
+		arena(const arena&) = delete;
+		arena& operator = (const arena&) = delete;
+
+		~arena()
+		{
+			release();
+		}
+
+		/**
+			\brief Allocates size bytes aligned to align (a power of 2).
+
+			Throws std::bad_alloc if operator new does.
+		*/
+		inline void* allocate(
+			std::size_t size /**< : <i>in</i> : The number of bytes.*/,
+			std::size_t align = alignof(std::max_align_t) /**< : <i>in</i> :
+														  The alignment.*/
+		)
+		{
+			usedBytes += size;
+			if (size <= max_pooled && align <= granularity)
+			{
+				free_node*& list = pool[class_of(size)];
+				if (list)
+				{
+					free_node* n = list;
+					list = n->next;
+					return n;
+				}
+				// pooled sizes are carved whole so they can be reused by any
+				// size of the class
+				size = (class_of(size) + 1) * granularity;
+				align = granularity;
+			}
+			char* p = cursor ? align_up(cursor, align) : nullptr;
+			if (p && p + size <= limit)
+			{
+				cursor = p + size;
+				return p;
+			}
+			return allocate_slow(size, align);
+		}
+
+		/**
+			\brief Gives back an allocation of size bytes aligned to align,
+			reused if it is pooled, otherwise kept till reset.
+		*/
+		inline void deallocate(
+			void* p /**< : <i>in</i> : The allocation.*/,
+			std::size_t size /**< : <i>in</i> : The size it was allocated
+							 with.*/,
+			std::size_t align = alignof(std::max_align_t) /**< : <i>in</i> :
+														  The alignment it
+														  was allocated
+														  with.*/
+		) noexcept
+		{
+			if (!p)
+				return;
+			usedBytes -= size;
+			if (size <= max_pooled && align <= granularity)
+			{
+				free_node* n = ::new (p) free_node{ pool[class_of(size)] };
+				pool[class_of(size)] = n;
+			}
+		}
+
+		/**
+			\brief Makes every allocation free in O(1), keeping the blocks to
+			allocate from again.
+		*/
+		inline void reset() noexcept
+		{
+			for (free_node*& list : pool)
+				list = nullptr;
+			usedBytes = 0;
+			if (initial)
+			{
+				current = nullptr;
+				cursor = initial;
+				limit = initial + initialSize;
+			}
+			else if (head)
+			{
+				current = head;
+				cursor = head->begin();
+				limit = head->end();
+			}
+			else
+				cursor = limit = nullptr;
+		}
+
+		/**
+			\brief Makes every allocation free and gives the blocks back to
+			operator delete.
+		*/
+		inline void release() noexcept
+		{
+			while (head)
+			{
+				block* next = head->next;
+				head->~block();
+				::operator delete(static_cast<void*>(head));
+				head = next;
+			}
+			current = nullptr;
+			reset();
+		}
+
+		/**
+			\brief The bytes allocated and not deallocated since the last
+			reset.
+		*/
+		inline std::size_t used() const noexcept { return usedBytes; }
+
+		/**
+			\brief The bytes held, the buffer and every block.
+		*/
+		inline std::size_t capacity() const noexcept
+		{
+			std::size_t total = initialSize;
+			for (block* b = head; b; b = b->next)
+				total += b->size;
+			return total;
+		}
+	};
+
+	/**
+		\brief The standard allocator that allocates from an enh::arena, for
+		containers and strings whose memory is released with the arena.
+
+		Copies (and rebound copies) share the arena, they compare equal if
+		the arena is the same. The arena must outlive every container using
+		it.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>template</h3>
+		-#  <code>T</code> : The type allocated.\n
+	*/
+	template<class T>
+	class arena_allocator
+	{
+		arena* region;
+
+		template<class U>
+		friend class arena_allocator;
+
+	public:
+
+		using value_type = T;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+		using is_always_equal = std::false_type;
+
+		/**
+			\brief An allocator from a.
+		*/
+		constexpr inline arena_allocator(
+			arena& a /**< : <i>in</i> : The arena.*/
+		) noexcept : region(&a) {}
+
+		/**
+			\brief An allocator from the arena of other.
+		*/
+		template<class U>
+		constexpr inline arena_allocator(
+			const arena_allocator<U>& other /**< : <i>in</i> : The
+											allocator.*/
+		) noexcept : region(other.region) {}
+
+		/**
+			\brief Allocates n objects, throws std::bad_alloc if it fails.
+		*/
+		inline T* allocate(
+			std::size_t n /**< : <i>in</i> : The number of objects.*/
+		)
+		{
+			if (n > (std::numeric_limits<std::size_t>::max)() / sizeof(T))
+				throw std::bad_alloc();
+			return static_cast<T*>(region->allocate(n * sizeof(T), alignof(T)));
+		}
+
+		/**
+			\brief Gives back n objects at p.
+		*/
+		inline void deallocate(
+			T* p /**< : <i>in</i> : The allocation.*/,
+			std::size_t n /**< : <i>in</i> : The number of objects.*/
+		) noexcept
+		{
+			region->deallocate(p, n * sizeof(T), alignof(T));
+		}
+
+		/**
+			\brief The arena allocated from.
+		*/
+		constexpr inline arena& getArena() const noexcept { return *region; }
+
+		template<class U>
+		friend constexpr inline bool operator == (const arena_allocator& lhs,
+			const arena_allocator<U>& rhs) noexcept
+		{
+			return lhs.region == rhs.region;
+		}
+
+		template<class U>
+		friend constexpr inline bool operator != (const arena_allocator& lhs,
+			const arena_allocator<U>& rhs) noexcept
+		{
+			return lhs.region != rhs.region;
+		}
+	};
+
+	/**
+		\brief A string allocated from an arena.
+	*/
+	using arena_string = std::basic_string<char, std::char_traits<char>,
+		arena_allocator<char>>;
+
+	/**
+		\brief The class that resets an arena when it goes out of scope, so
+		the temporary objects of one request are released together.
+
+		hasErrorHandlers        = false;\n
+	*/
+	class arena_scope
+	{
+		arena& region;
+
+	public:
+
+		explicit inline arena_scope(
+			arena& a /**< : <i>in</i> : The arena to reset.*/
+		) noexcept : region(a) {}
+
+		arena_scope(const arena_scope&) = delete;
+		arena_scope& operator = (const arena_scope&) = delete;
+
+		inline ~arena_scope() { region.reset(); }
+
+		/**
+			\brief The allocator of the arena.
+		*/
+		template<class T = char>
+		inline arena_allocator<T> allocator() const noexcept
+		{
+			return arena_allocator<T>(region);
+		}
+	};
+}
+
+#endif
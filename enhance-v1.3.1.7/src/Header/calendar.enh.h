@@ -0,0 +1,201 @@
+/** ***************************************************************************
+	\file calendar.enh.h
+
+	\brief The file to declare constant time Gregorian calendar conversions
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef CALENDAR_ENH_H
+
+#define CALENDAR_ENH_H					calendar.enh.h
+
+#include <string_view>
+
+namespace enh
+{
+	/**
+		\brief Checks if yr is a leap year of the Gregorian calendar.
+	*/
+	inline constexpr bool is_leap_year(
+		long long yr /**< : <i>in</i> : The year count.*/
+	) noexcept
+	{
+		return ((yr % 4) == 0) && (((yr % 100) != 0) || ((yr % 400) == 0));
+	}
+
+	/**
+		\brief The lengths of the months and the days before each, of a 
+		common year (row 0) and a leap year (row 1), built at compile time.
+	*/
+	struct month_table
+	{
+		/**
+			\brief The days in month [0,11].
+		*/
+		unsigned short length[2][12];
+
+		/**
+			\brief The days of the year before month [0,12], the last is the
+			length of the year.
+		*/
+		unsigned short before[2][13];
+	};
+
+	/**
+		\brief Builds month_table from the lengths of the months.
+	*/
+	inline constexpr month_table make_month_table() noexcept
+	{
+		month_table t{};
+		constexpr unsigned short common[12] = { 31, 28, 31, 30, 31, 30, 31, 31,
+			30, 31, 30, 31 };
+		for (int leap = 0; leap < 2; ++leap)
+		{
+			t.before[leap][0] = 0;
+			for (int m = 0; m < 12; ++m)
+			{
+				t.length[leap][m] = static_cast<unsigned short>(common[m] + ((leap && m == 1) ? 1 : 0));
+				t.before[leap][m + 1] = static_cast<unsigned short>(t.before[leap][m] + t.length[leap][m]);
+			}
+		}
+		return t;
+	}
+
+	/**
+		\brief The month lengths and days before each month, a constant.
+	*/
+	inline constexpr month_table month_days = make_month_table();
+
+	static_assert(month_days.before[0][12] == 365 && month_days.before[1][12] == 366,
+		"month_days must add up to the year");
+
+	/**
+		\brief The days of year yr before month mnth [0,11] (the day of the 
+		year of its first day), by table lookup.
+	*/
+	inline constexpr unsigned short days_before_month(
+		unsigned short mnth /**< : <i>in</i> : The month [0,11].*/,
+		long long yr /**< : <i>in</i> : The year.*/
+	) noexcept
+	{
+		return month_days.before[is_leap_year(yr) ? 1 : 0][(mnth < 12) ? mnth : 12];
+	}
+
+	/**
+		\brief The names of the months, January first.
+	*/
+	inline constexpr std::string_view month_names[12] = { "January", "February",
+		"March", "April", "May", "June", "July", "August", "September", "October",
+		"November", "December" };
+
+	/**
+		\brief The three letter names of the months, January first.
+	*/
+	inline constexpr std::string_view short_month_names[12] = { "Jan", "Feb", 
+		"Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+	/**
+		\brief The names of the days of the week, Sunday first.
+	*/
+	inline constexpr std::string_view weekday_names[7] = { "Sunday", "Monday",
+		"Tuesday", "Wednesday", "Thursday", "Friday", "Saturday" };
+
+	/**
+		\brief The three letter names of the days of the week, Sunday first.
+	*/
+	inline constexpr std::string_view short_weekday_names[7] = { "Sun", "Mon",
+		"Tue", "Wed", "Thu", "Fri", "Sat" };
+
+	/**
+		\brief A date of the proleptic Gregorian calendar as year, month 
+		[0,11] and day of month [1,31].
+	*/
+	struct civil_date
+	{
+		/**
+			\brief The year.
+		*/
+		long long year;
+
+		/**
+			\brief The number of months after January [0,11].
+		*/
+		unsigned short month;
+
+		/**
+			\brief The day of the month [1,31].
+		*/
+		unsigned short day;
+	};
+
+	/**
+		\brief The number of days from 01 January 1970 to the date, negative 
+		before it (proleptic Gregorian, constant time).
+	*/
+	inline constexpr long long days_from_civil(
+		long long yr /**< : <i>in</i> : The year.*/,
+		unsigned short mnth /**< : <i>in</i> : The month [0,11].*/,
+		unsigned short dy /**< : <i>in</i> : The day of month [1,31].*/
+	) noexcept
+	{
+		long long m = static_cast<long long>(mnth) + 1;
+		yr -= (m <= 2) ? 1 : 0;
+		long long era = ((yr >= 0) ? yr : yr - 399) / 400;
+		long long yoe = yr - era * 400;
+		long long doy = (153 * (m + ((m > 2) ? -3 : 9)) + 2) / 5 + dy - 1;
+		long long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+		return era * 146097 + doe - 719468;
+	}
+
+	/**
+		\brief The date days after 01 January 1970 (proleptic Gregorian, 
+		constant time).
+	*/
+	inline constexpr civil_date civil_from_days(
+		long long days /**< : <i>in</i> : The days from 01 January 1970.*/
+	) noexcept
+	{
+		days += 719468;
+		long long era = ((days >= 0) ? days : days - 146096) / 146097;
+		long long doe = days - era * 146097;
+		long long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+		long long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+		long long mp = (5 * doy + 2) / 153;
+		long long d = doy - (153 * mp + 2) / 5 + 1;
+		long long m = (mp < 10) ? mp + 3 : mp - 9;
+		return { yoe + era * 400 + ((m <= 2) ? 1 : 0),
+			static_cast<unsigned short>(m - 1), static_cast<unsigned short>(d) };
+	}
+
+	/**
+		\brief The day of the week [0,6] after Sunday, days after 01 January
+		1970.
+	*/
+	inline constexpr unsigned short weekday_from_days(
+		long long days /**< : <i>in</i> : The days from 01 January 1970.*/
+	) noexcept
+	{
+		return static_cast<unsigned short>((days >= -4) ? (days + 4) % 7
+			: (days + 5) % 7 + 6);
+	}
+}
+
+#endif
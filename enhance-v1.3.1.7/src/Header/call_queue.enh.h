@@ -0,0 +1,811 @@
+/** ***************************************************************************
+	\file call_queue.enh.h
+
+	\brief The file to declare class call_process, request and reply over a
+	queued_process with futures from a preallocated slab
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+
+******************************************************************************/
+
+#ifndef CALL_QUEUE_ENH_H
+
+#define CALL_QUEUE_ENH_H						call_queue.enh.h
+
+#include "queued_process.enh.h"
+#include "result.enh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace enh
+{
+
+	/**
+		\brief A fixed number of reply slots, taken by calls and given back
+		when their future is done, so a call allocates nothing.
+
+		The free slots form a lock-free stack, the head is tagged to avoid
+		ABA. A slot also holds the mutex and condition variable a waiter
+		parks on, which are only touched once a waiter parked.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>Template arguments</h3>
+		-#  <code>class reply</code> : The type of the reply, must be move
+		constructible.\n
+	*/
+	template<class reply>
+	class reply_slab
+	{
+	public:
+
+		/**
+			\brief The states of a slot.
+		*/
+		enum slot_state : std::uint32_t
+		{
+			FREE = 0,		/**< : In the free stack.*/
+			PENDING = 1,	/**< : Taken by a call, not yet completed.*/
+			READY = 2,		/**< : Holds the reply.*/
+			FAILED = 3,		/**< : Holds an error code.*/
+			ABANDONED = 4	/**< : The future was dropped before completion.*/
+		};
+
+	private:
+
+		/**
+			\brief A reply slot.
+		*/
+		struct alignas(cache_line_size) slot
+		{
+			std::atomic<std::uint32_t> state{ FREE };
+			std::atomic<bool> parked{ false };
+			std::atomic<std::uint32_t> next{ 0 };
+			unsigned code = 0;
+			std::mutex mtx;
+			std::condition_variable cv;
+			alignas(reply) unsigned char value[sizeof(reply)];
+
+			inline reply* get() noexcept
+			{
+				return std::launder(reinterpret_cast<reply*>(value));
+			}
+		};
+
+		/**
+			\brief The slots.
+		*/
+		std::unique_ptr<slot[]> slots;
+
+		/**
+			\brief The number of slots.
+		*/
+		std::uint32_t count;
+
+		/**
+			\brief The top of the free stack, a tag in the high 32 bits and
+			the index plus 1 (0 for empty) in the low.
+		*/
+		alignas(cache_line_size) std::atomic<std::uint64_t> head;
+
+		/**
+			\brief Sets the state of a completed slot and wakes its waiter if
+			one parked, frees the slot if the future was dropped.
+		*/
+		inline void publish(
+			std::uint32_t index /**< : <i>in</i> : The slot.*/,
+			std::uint32_t state /**< : <i>in</i> : READY or FAILED.*/
+		) noexcept
+		{
+			slot& self = slots[index];
+			std::uint32_t expected = PENDING;
+			if (!self.state.compare_exchange_strong(expected, state))
+			{
+				// the future is gone, nobody takes the reply.
+				if (state == READY)
+					self.get()->~reply();
+				release(index);
+				return;
+			}
+			if (self.parked.load())
+			{
+				{ std::lock_guard<std::mutex> lock(self.mtx); }
+				self.cv.notify_all();
+			}
+		}
+
+	public:
+
+		/**
+			\brief Constructs with size slots, all free.
+		*/
+		explicit reply_slab(
+			std::size_t size /**< : <i>in</i> : The number of slots, at
+							 least 1.*/
+		) : slots(std::make_unique<slot[]>(std::max<std::size_t>(size, 1))),
+			count(static_cast<std::uint32_t>(std::max<std::size_t>(size, 1))),
+			head(0)
+		{
+			for (std::uint32_t i = 0; i < count; ++i)
+				slots[i].next.store(i, std::memory_order_relaxed);
+			head.store(count, std::memory_order_relaxed);
+		}
+
+		reply_slab(const reply_slab&) = delete;
+
+		reply_slab& operator = (const reply_slab&) = delete;
+
+		/**
+			\brief The number of slots.
+		*/
+		inline std::size_t capacity() const noexcept { return count; }
+
+		/**
+			\brief Takes a free slot, marking it pending.
+
+			<h3>Return</h3>
+			false if all slots are taken.\n
+		*/
+		inline bool try_acquire(
+			std::uint32_t& index /**< : <i>out</i> : The slot taken.*/
+		) noexcept
+		{
+			std::uint64_t top = head.load(std::memory_order_acquire);
+			while (true)
+			{
+				std::uint32_t first = static_cast<std::uint32_t>(top);
+				if (first == 0)
+					return false;
+				// a stale next only fails the exchange as the tag moved on.
+				std::uint64_t next = ((top >> 32) + 1) << 32
+					| slots[first - 1].next.load(std::memory_order_relaxed);
+				if (head.compare_exchange_weak(top, next,
+					std::memory_order_acquire, std::memory_order_acquire))
+				{
+					index = first - 1;
+					slots[index].state.store(PENDING, std::memory_order_relaxed);
+					return true;
+				}
+			}
+		}
+
+		/**
+			\brief Gives a slot back to the free stack.
+		*/
+		inline void release(
+			std::uint32_t index /**< : <i>in</i> : The slot.*/
+		) noexcept
+		{
+			slot& self = slots[index];
+			self.state.store(FREE, std::memory_order_relaxed);
+			std::uint64_t top = head.load(std::memory_order_relaxed);
+			do
+			{
+				self.next.store(static_cast<std::uint32_t>(top),
+					std::memory_order_relaxed);
+			} while (!head.compare_exchange_weak(top,
+				((top >> 32) + 1) << 32 | (index + 1),
+				std::memory_order_release, std::memory_order_relaxed));
+		}
+
+		/**
+			\brief Completes a pending slot with a reply.
+		*/
+		template<class... Args>
+		inline void complete(
+			std::uint32_t index /**< : <i>in</i> : The slot.*/,
+			Args&&... args /**< : <i>in</i> : The reply constructor
+						   arguments.*/
+		)
+		{
+			new (slots[index].value) reply(std::forward<Args>(args)...);
+			publish(index, READY);
+		}
+
+		/**
+			\brief Completes a pending slot with an error code.
+		*/
+		inline void fail(
+			std::uint32_t index /**< : <i>in</i> : The slot.*/,
+			unsigned code /**< : <i>in</i> : The error code, not 0.*/
+		) noexcept
+		{
+			slots[index].code = code ? code : result_code::UNKNOWN;
+			publish(index, FAILED);
+		}
+
+		/**
+			\brief The state of a slot.
+		*/
+		inline std::uint32_t state(
+			std::uint32_t index /**< : <i>in</i> : The slot.*/
+		) const noexcept
+		{
+			return slots[index].state.load(std::memory_order_acquire);
+		}
+
+		/**
+			\brief Spins spins times then yields yields times while a slot
+			is pending.
+
+			<h3>Return</h3>
+			true if the slot was completed.\n
+		*/
+		inline bool spin_wait(
+			std::uint32_t index /**< : <i>in</i> : The slot.*/,
+			std::size_t spins /**< : <i>in</i> : Spins before yielding.*/,
+			std::size_t yields /**< : <i>in</i> : Yields after spinning.*/
+		) const noexcept
+		{
+			const slot& self = slots[index];
+			for (std::size_t i = 0; i < spins; ++i)
+			{
+				if (self.state.load(std::memory_order_acquire) != PENDING)
+					return true;
+				cpu_relax();
+			}
+			for (std::size_t i = 0; i < yields; ++i)
+			{
+				if (self.state.load(std::memory_order_acquire) != PENDING)
+					return true;
+				std::this_thread::yield();
+			}
+			return self.state.load(std::memory_order_acquire) != PENDING;
+		}
+
+		/**
+			\brief Waits till a slot is completed, spinning and yielding
+			before parking.
+		*/
+		void wait(
+			std::uint32_t index /**< : <i>in</i> : The slot.*/,
+			std::size_t spins /**< : <i>in</i> : Spins before yielding.*/,
+			std::size_t yields /**< : <i>in</i> : Yields before parking.*/
+		)
+		{
+			if (spin_wait(index, spins, yields))
+				return;
+			slot& self = slots[index];
+			std::unique_lock<std::mutex> lock(self.mtx);
+			self.parked = true;
+			self.cv.wait(lock, [&self]() {
+				return self.state.load() != PENDING;
+				});
+			self.parked = false;
+		}
+
+		/**
+			\brief Waits till a slot is completed or the deadline, spinning
+			and yielding before parking.
+
+			<h3>Return</h3>
+			true if the slot was completed.\n
+		*/
+		template<class Clock, class Duration>
+		bool wait_until(
+			std::uint32_t index /**< : <i>in</i> : The slot.*/,
+			const std::chrono::time_point<Clock, Duration>& deadline /**< :
+							<i>in</i> : The time to stop waiting at.*/,
+			std::size_t spins /**< : <i>in</i> : Spins before yielding.*/,
+			std::size_t yields /**< : <i>in</i> : Yields before parking.*/
+		)
+		{
+			if (spin_wait(index, spins, yields))
+				return true;
+			slot& self = slots[index];
+			std::unique_lock<std::mutex> lock(self.mtx);
+			self.parked = true;
+			bool done = self.cv.wait_until(lock, deadline, [&self]() {
+				return self.state.load() != PENDING;
+				});
+			self.parked = false;
+			return done;
+		}
+
+		/**
+			\brief Takes the outcome of a completed slot and frees it.
+		*/
+		inline result<reply> take(
+			std::uint32_t index /**< : <i>in</i> : The completed slot.*/
+		)
+		{
+			slot& self = slots[index];
+			if (self.state.load(std::memory_order_acquire) == FAILED)
+			{
+				unsigned code = self.code;
+				release(index);
+				return enh::fail(code);
+			}
+			result<reply> ret(std::move(*self.get()));
+			self.get()->~reply();
+			release(index);
+			return ret;
+		}
+
+		/**
+			\brief Drops interest in a slot, frees it now if completed, else
+			when it completes.
+		*/
+		inline void abandon(
+			std::uint32_t index /**< : <i>in</i> : The slot.*/
+		) noexcept
+		{
+			slot& self = slots[index];
+			std::uint32_t expected = PENDING;
+			if (self.state.compare_exchange_strong(expected, ABANDONED))
+				return;
+			if (expected == READY)
+				self.get()->~reply();
+			release(index);
+		}
+	};
+
+	/**
+		\brief The future of a call, the reply or error of the handler.
+
+		Move only, the size of two pointers. Waiting spins briefly, then
+		yields, then parks on the slot. Dropping it without get frees the
+		slot once the call completes.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	template<class reply>
+	class call_future
+	{
+		reply_slab<reply>* slab = nullptr;
+		std::uint32_t index = 0;
+
+		/**
+			\brief Spins before yielding.
+		*/
+		static constexpr std::size_t spin_count = 256;
+
+		/**
+			\brief Yields before parking.
+		*/
+		static constexpr std::size_t yield_count = 16;
+
+	public:
+
+		/**
+			\brief An empty future.
+		*/
+		call_future() noexcept = default;
+
+		/**
+			\brief A future for a pending slot.
+		*/
+		call_future(
+			reply_slab<reply>& s /**< : <i>in</i> : The slab.*/,
+			std::uint32_t i /**< : <i>in</i> : The slot.*/
+		) noexcept : slab(&s), index(i) {}
+
+		call_future(call_future&& other) noexcept
+			: slab(other.slab), index(other.index)
+		{
+			other.slab = nullptr;
+		}
+
+		call_future& operator = (call_future&& other) noexcept
+		{
+			if (this != &other)
+			{
+				reset();
+				slab = other.slab;
+				index = other.index;
+				other.slab = nullptr;
+			}
+			return *this;
+		}
+
+		call_future(const call_future&) = delete;
+
+		call_future& operator = (const call_future&) = delete;
+
+		/**
+			\brief Drops the future.
+		*/
+		~call_future() { reset(); }
+
+		/**
+			\brief Checks if it refers to a call, false after get.
+		*/
+		inline bool valid() const noexcept { return slab != nullptr; }
+
+		/**
+			\brief Checks if the call completed, without waiting.
+		*/
+		inline bool ready() const noexcept
+		{
+			return slab->state(index) != reply_slab<reply>::PENDING;
+		}
+
+		/**
+			\brief Waits till the call completes.
+		*/
+		inline void wait() const
+		{
+			slab->wait(index, spin_count, yield_count);
+		}
+
+		/**
+			\brief Waits till the call completes or the deadline.
+
+			<h3>Return</h3>
+			true if the call completed.\n
+		*/
+		template<class Clock, class Duration>
+		inline bool wait_until(
+			const std::chrono::time_point<Clock, Duration>& deadline /**< :
+							<i>in</i> : The time to stop waiting at.*/
+		) const
+		{
+			return slab->wait_until(index, deadline, spin_count, yield_count);
+		}
+
+		/**
+			\brief Waits then takes the outcome, the future is empty after.
+
+			<h3>Return</h3>
+			The reply, or the error code of the handler (UNKNOWN if the call
+			was destroyed unprocessed, like by force_join).\n
+		*/
+		inline result<reply> get()
+		{
+			wait();
+			reply_slab<reply>* s = slab;
+			slab = nullptr;
+			return s->take(index);
+		}
+
+		/**
+			\brief Drops interest in the call, the future is empty after.
+		*/
+		inline void reset() noexcept
+		{
+			if (slab)
+				slab->abandon(index);
+			slab = nullptr;
+		}
+	};
+
+	/**
+		\brief The message queued by a call, the request and the slot its
+		reply goes to.
+
+		Move only. If destroyed before completion (the queue was cleared)
+		the call fails with result_code::UNKNOWN, so no caller waits for
+		ever.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	template<class info, class reply>
+	struct call_request
+	{
+		/**
+			\brief The request.
+		*/
+		info request;
+
+		/**
+			\brief The slab of the slot, null once completed.
+		*/
+		reply_slab<reply>* slab;
+
+		/**
+			\brief The slot.
+		*/
+		std::uint32_t index;
+
+		call_request(
+			info req /**< : <i>in</i> : The request.*/,
+			reply_slab<reply>& s /**< : <i>in</i> : The slab.*/,
+			std::uint32_t i /**< : <i>in</i> : The slot.*/
+		) : request(std::move(req)), slab(&s), index(i) {}
+
+		call_request(call_request&& other) noexcept(
+			std::is_nothrow_move_constructible_v<info>)
+			: request(std::move(other.request)), slab(other.slab),
+			index(other.index)
+		{
+			other.slab = nullptr;
+		}
+
+		call_request& operator = (call_request&& other) noexcept(
+			std::is_nothrow_move_assignable_v<info>)
+		{
+			if (this != &other)
+			{
+				if (slab)
+					slab->fail(index, result_code::UNKNOWN);
+				request = std::move(other.request);
+				slab = other.slab;
+				index = other.index;
+				other.slab = nullptr;
+			}
+			return *this;
+		}
+
+		call_request(const call_request&) = delete;
+
+		call_request& operator = (const call_request&) = delete;
+
+		~call_request()
+		{
+			if (slab)
+				slab->fail(index, result_code::UNKNOWN);
+		}
+
+		/**
+			\brief Completes the call with the outcome of the handler.
+		*/
+		inline void complete(
+			result<reply> res /**< : <i>in</i> : The outcome.*/
+		)
+		{
+			reply_slab<reply>* s = slab;
+			slab = nullptr;
+			if (res)
+				s->complete(index, std::move(res).value());
+			else
+				s->fail(index, res.error());
+		}
+	};
+
+	/**
+		\brief The class to call a handler on a queued_process and get its
+		reply through a future, without allocating per call.
+
+		Each call takes a slot of a reply_slab made at construction, the
+		processing thread puts the reply in the slot and wakes the caller if
+		it parked. A handler failure (a failed result) goes to the caller and
+		processing goes on.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>Template arguments</h3>
+		-#  <code>class info</code> : The type of the request.\n
+		-#  <code>class reply</code> : The type of the reply.\n
+		-#  <code>class policy</code> : The queue policy of the
+		queued_process, not durable or shared (requests hold pointers).\n
+
+		<h3> How To Use </h3>
+
+		- Construct with the handler, returning `result<reply>` for a request,
+		and the number of slots (the most calls in flight).
+
+		- Call `start_queue_process`, then `call(request)` and `get()` on the
+		future returned. `call` waits while all slots are taken,
+		`try_call` returns an empty future instead.
+
+		- Stop with `safe_join` or `force_join`. Calls not processed fail
+		with result_code::UNKNOWN. Futures must not outlive the call_process.
+	*/
+	template<class info, class reply, class policy = unbounded_queue>
+	class call_process
+	{
+		static_assert(!policy::is_durable && !policy::is_shared,
+			"call_process requests refer to reply slots of this process");
+
+	public:
+
+		/**
+			\brief The type of the request.
+		*/
+		using info_type = info;
+
+		/**
+			\brief The type of the reply.
+		*/
+		using reply_type = reply;
+
+		/**
+			\brief The function type that handles a request.
+		*/
+		using call_method = std::function<result<reply>(info)>;
+
+		/**
+			\brief The type of the future of a call.
+		*/
+		using future_type = call_future<reply>;
+
+		/**
+			\brief The message type of the queue.
+		*/
+		using request_type = call_request<info, reply>;
+
+		/**
+			\brief The queued_process type.
+		*/
+		using queue_type = queued_process<request_type, policy>;
+
+	private:
+
+		/**
+			\brief The reply slots, outlive the queue and its requests.
+		*/
+		reply_slab<reply> slab;
+
+		/**
+			\brief The handler.
+		*/
+		call_method handler;
+
+		/**
+			\brief The queue.
+		*/
+		queue_type queue;
+
+	public:
+
+		/**
+			\brief Constructs with the handler and the number of slots.
+		*/
+		call_process(
+			call_method fn /**< : <i>in</i> : The handler.*/,
+			std::size_t slots = 1024 /**< : <i>in</i> : The most calls in
+									 flight.*/
+		) : slab(slots), handler(std::move(fn)),
+			queue([this](request_type req) -> tristate {
+				req.complete(handler(std::move(req.request)));
+				return tristate::GOOD;
+				})
+		{}
+
+		call_process(const call_process&) = delete;
+
+		call_process& operator = (const call_process&) = delete;
+
+		/**
+			\brief The queued_process, to configure it (like
+			setWaitStrategy).
+		*/
+		inline queue_type& process() noexcept { return queue; }
+
+		/**
+			\brief The number of reply slots.
+		*/
+		inline std::size_t capacity() const noexcept { return slab.capacity(); }
+
+		/**
+			\brief Calls the handler with request on the processing thread,
+			waits while all slots are taken.
+
+			<h3>Return</h3>
+			The future of the reply.\n
+		*/
+		future_type call(
+			info_type request /**< : <i>in</i> : The request.*/
+		)
+		{
+			std::uint32_t index;
+			while (!slab.try_acquire(index))
+				std::this_thread::yield();
+			queue.emplaceMessage(std::move(request), slab, index);
+			return future_type(slab, index);
+		}
+
+		/**
+			\brief Calls the handler with request on the processing thread if
+			a slot is free and, for a bounded policy, the queue has space.
+
+			<h3>Return</h3>
+			The future of the reply, empty (not valid) if not called.\n
+		*/
+		future_type try_call(
+			info_type request /**< : <i>in</i> : The request.*/
+		)
+		{
+			std::uint32_t index;
+			if (!slab.try_acquire(index))
+				return future_type();
+			if (!queue.try_emplaceMessage(std::move(request), slab, index))
+			{
+				// a request made and destroyed failed the slot, else nothing
+				// refers to it.
+				if (slab.state(index) == reply_slab<reply>::PENDING)
+					slab.release(index);
+				else
+					slab.abandon(index);
+				return future_type();
+			}
+			return future_type(slab, index);
+		}
+
+		/**
+			\brief Starts the processing thread.
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if it is already running.\n
+		*/
+		inline tristate start_queue_process() noexcept
+		{
+			return queue.start_queue_process();
+		}
+
+		/**
+			\brief Starts the processing thread, which applies config first.
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if it is already running.\n
+		*/
+		inline tristate start_queue_process(
+			thread_config config /**< : <i>in</i> : The placement, scheduling
+								 and name of the thread.*/
+		) noexcept
+		{
+			return queue.start_queue_process(std::move(config));
+		}
+
+		/**
+			\brief Checks if it is running.
+		*/
+		inline bool isQueueRunning() noexcept { return queue.isQueueRunning(); }
+
+		/**
+			\brief Waits till the calls made are processed, or the deadline.
+
+			<h3>Return</h3>
+			true if all calls were processed.\n
+		*/
+		template<class Clock, class Duration>
+		inline bool WaitForQueueEmpty(
+			const std::chrono::time_point<Clock, Duration>& deadline /**< :
+							<i>in</i> : The time to stop waiting at.*/
+		)
+		{
+			return queue.WaitForQueueEmpty(deadline);
+		}
+
+		/**
+			\brief Waits till the calls are processed or the deadline, then
+			stops and joins.
+
+			<h3>Return</h3>
+			true if all calls were processed before stopping.\n
+		*/
+		template<class Clock, class Duration>
+		inline bool safe_join(
+			const std::chrono::time_point<Clock, Duration>& deadline /**< :
+							<i>in</i> : The time to stop waiting at.*/
+		)
+		{
+			return queue.safe_join(deadline);
+		}
+
+		/**
+			\brief Stops and joins, calls not processed fail.
+		*/
+		inline void force_join() { queue.force_join(); }
+	};
+}
+
+#endif // !CALL_QUEUE_ENH_H
@@ -0,0 +1,712 @@
+/** ***************************************************************************
+	\file checkpoint.enh.h
+
+	\brief The file to declare class checkpoint_file, counters and date
+	times kept in a memory-mapped binary checkpoint
+
+	Created 15 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	<h3> How To Use</h3>
+
+	- Make the file once with create, with the number of counters and date
+	times, then open it at every start. open reads and checks the header
+	and maps the file, values are read from the map as their pages are
+	first touched, nothing is parsed.
+
+	- Read and update the values through the checkpoint from any thread,
+	call snapshot from one thread (a callback_timer for example) to make
+	them durable. Writers are never blocked by a snapshot.
+
+	<h3> Layout </h3>
+
+	A header block then two slots, in the byte order of the machine. A slot
+	holds the total seconds of each counter (as counter_array) then the
+	nanoseconds after the unix epoch of each date time
+	(DateTime::getEpochNanos), 8 bytes each, padded to whole blocks. Each
+	slot has a generation in the header, the slot of the higher generation
+	is current. A snapshot writes the blocks changed since the other slot
+	was written into it, flushes them, then writes its generation, so a
+	crash leaves the current slot whole.
+
+******************************************************************************/
+
+#ifndef CHECKPOINT_ENH_H
+
+#define CHECKPOINT_ENH_H						checkpoint.enh.h
+
+#include "counter.enh.h"
+#include "date_time.enh.h"
+#include "general.enh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace enh
+{
+
+	/**
+		\brief The header of a checkpoint file, at the start of its first
+		block.
+	*/
+	struct checkpoint_header
+	{
+		char magic[8];				/**< : "ENHCKPT" and a 0.*/
+		std::uint32_t version;		/**< : checkpoint_file::version.*/
+		std::uint32_t blockBytes;	/**< : The bytes of the header block and
+									the unit of snapshot writes.*/
+		std::uint64_t counters;		/**< : The counters of a slot.*/
+		std::uint64_t times;		/**< : The date times of a slot.*/
+		std::uint64_t slotBytes;	/**< : The bytes of a slot, whole
+									blocks.*/
+		std::uint32_t checksum;		/**< : FNV-1a of the fields above.*/
+		std::uint32_t reserved;		/**< : 0.*/
+		std::uint64_t generation[2];	/**< : The snapshot held by each
+										slot, the higher is current.*/
+	};
+
+	/**
+		\brief The class to keep counters and date times in a memory-mapped
+		checkpoint file, opened in place and snapshot incrementally.
+
+		The values live in a private copy on write map of the current slot,
+		so open costs the same for any size and only the pages touched are
+		read. Each write is an atomic store (or fetch_add) on the map and
+		marks its block changed for both slots, a load and, the first time
+		after a snapshot, a fetch_or, so writers never lock or wait.\n\n
+
+		snapshot writes the blocks changed since the other slot was last
+		written into it, from the map, then commits it as current. Values
+		are copied one at a time while writers go on, so a snapshot holds
+		each value as of some moment during it, not one instant for all. The
+		first snapshot after open writes the whole slot, its contents may be
+		a snapshot torn by a crash.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class checkpoint_file
+	{
+	public:
+
+		/**
+			\brief The version of the layout written.
+		*/
+		static constexpr std::uint32_t version = 1;
+
+		/**
+			\brief The bytes of a block of files created.
+		*/
+		static constexpr std::uint32_t block_bytes = 4096;
+
+	private:
+
+		/**
+			\brief The most blocks copied and written at once by snapshot.
+		*/
+		static constexpr std::size_t max_run = 256;
+
+		using word = std::atomic<std::uint64_t>;
+
+		static_assert(sizeof(word) == sizeof(std::uint64_t) && word::is_always_lock_free,
+			"values are read and written in place as 64 bit atomics");
+
+		static constexpr char magic[8] = { 'E', 'N', 'H', 'C', 'K', 'P', 'T', '\0' };
+
+		/**
+			\brief The private map of the whole file.
+		*/
+		char* view = nullptr;
+		std::size_t length = 0;
+#if defined(_WIN32)
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+#else
+		int fd = -1;
+#endif
+
+		checkpoint_header head{};
+
+		/**
+			\brief The values, the slot current at open in the map.
+		*/
+		word* values = nullptr;
+
+		/**
+			\brief For each slot, a bit for each block changed since the slot
+			was written.
+		*/
+		std::unique_ptr<word[]> changed[2];
+		std::size_t changedWords = 0;
+
+		/**
+			\brief The slot of the last snapshot.
+		*/
+		std::atomic<unsigned> current{ 0 };
+
+		/**
+			\brief The mutex of snapshot.
+		*/
+		std::mutex snapping;
+
+		/**
+			\brief 32 bit FNV-1a of the bytes.
+		*/
+		static std::uint32_t checksum(
+			const void* data /**< : <i>in</i> : The bytes.*/,
+			std::size_t size /**< : <i>in</i> : The number of bytes.*/
+		) noexcept
+		{
+			const unsigned char* at = static_cast<const unsigned char*>(data);
+			std::uint32_t hash = 2166136261U;
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				hash ^= at[i];
+				hash *= 16777619U;
+			}
+			return hash;
+		}
+
+		static std::uint32_t checksum(const checkpoint_header& h) noexcept
+		{
+			return checksum(&h, offsetof(checkpoint_header, checksum));
+		}
+
+		inline std::size_t slot_offset(unsigned slot) const noexcept
+		{
+			return head.blockBytes + slot * static_cast<std::size_t>(head.slotBytes);
+		}
+
+		/**
+			\brief Marks the block of value index changed for both slots.
+		*/
+		inline void mark(
+			std::size_t index /**< : <i>in</i> : The index in the slot.*/
+		) noexcept
+		{
+			// seq_cst with the store of the value: either snapshot clears the
+			// bit after the value is stored, or this sees it cleared.
+			std::size_t block = index * sizeof(std::uint64_t) / head.blockBytes;
+			std::uint64_t bit = 1ULL << (block % 64);
+			for (auto& slot : changed)
+				if (!(slot[block / 64].load() & bit))
+					slot[block / 64].fetch_or(bit);
+		}
+
+		bool read_at(void* to, std::size_t size, std::size_t offset) noexcept
+		{
+#if defined(_WIN32)
+			OVERLAPPED at{};
+			at.Offset = static_cast<DWORD>(offset);
+			at.OffsetHigh = static_cast<DWORD>(static_cast<std::uint64_t>(offset) >> 32);
+			DWORD done = 0;
+			return ReadFile(file, to, static_cast<DWORD>(size), &done, &at) && done == size;
+#else
+			char* p = static_cast<char*>(to);
+			while (size)
+			{
+				ssize_t done = ::pread(fd, p, size, static_cast<off_t>(offset));
+				if (done <= 0)
+					return false;
+				p += done;
+				size -= static_cast<std::size_t>(done);
+				offset += static_cast<std::size_t>(done);
+			}
+			return true;
+#endif
+		}
+
+		bool write_at(const void* from, std::size_t size, std::size_t offset) noexcept
+		{
+#if defined(_WIN32)
+			const char* p = static_cast<const char*>(from);
+			while (size)
+			{
+				DWORD part = static_cast<DWORD>(std::min<std::size_t>(size, 1U << 30));
+				OVERLAPPED at{};
+				at.Offset = static_cast<DWORD>(offset);
+				at.OffsetHigh = static_cast<DWORD>(static_cast<std::uint64_t>(offset) >> 32);
+				DWORD done = 0;
+				if (!WriteFile(file, p, part, &done, &at) || done == 0)
+					return false;
+				p += done;
+				size -= done;
+				offset += done;
+			}
+			return true;
+#else
+			const char* p = static_cast<const char*>(from);
+			while (size)
+			{
+				ssize_t done = ::pwrite(fd, p, size, static_cast<off_t>(offset));
+				if (done <= 0)
+					return false;
+				p += done;
+				size -= static_cast<std::size_t>(done);
+				offset += static_cast<std::size_t>(done);
+			}
+			return true;
+#endif
+		}
+
+		bool sync() noexcept
+		{
+#if defined(_WIN32)
+			return FlushFileBuffers(file) != 0;
+#elif defined(__linux__)
+			return ::fdatasync(fd) == 0;
+#else
+			return ::fsync(fd) == 0;
+#endif
+		}
+
+		bool open_file(const std::filesystem::path& path, bool create) noexcept
+		{
+#if defined(_WIN32)
+			file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+				FILE_SHARE_READ, nullptr, create ? CREATE_ALWAYS : OPEN_EXISTING,
+				FILE_ATTRIBUTE_NORMAL, nullptr);
+			return file != INVALID_HANDLE_VALUE;
+#else
+			fd = ::open(path.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+			return fd >= 0;
+#endif
+		}
+
+		bool file_size(std::size_t& size) noexcept
+		{
+#if defined(_WIN32)
+			LARGE_INTEGER bytes;
+			if (!GetFileSizeEx(file, &bytes))
+				return false;
+			size = static_cast<std::size_t>(bytes.QuadPart);
+#else
+			struct stat info;
+			if (::fstat(fd, &info) != 0)
+				return false;
+			size = static_cast<std::size_t>(info.st_size);
+#endif
+			return true;
+		}
+
+		/**
+			\brief Maps the open file of head privately and sets up the
+			values of slot current.
+		*/
+		bool map() noexcept
+		{
+			std::size_t size = slot_offset(2);
+#if defined(_WIN32)
+			mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+			if (mapping)
+				view = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, size));
+#else
+			void* at = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+			if (at != MAP_FAILED)
+				view = static_cast<char*>(at);
+#endif
+			if (!view)
+				return false;
+			length = size;
+			values = reinterpret_cast<word*>(view + slot_offset(current.load()));
+			std::size_t blocks = static_cast<std::size_t>(head.slotBytes / head.blockBytes);
+			changedWords = (blocks + 63) / 64;
+			for (auto& slot : changed)
+			{
+				slot.reset(new (std::nothrow) word[changedWords]);
+				if (!slot)
+					return false;
+				for (std::size_t i = 0; i < changedWords; ++i)
+					slot[i].store(0, std::memory_order_relaxed);
+			}
+			return true;
+		}
+
+		/**
+			\brief Marks every block changed for slot.
+		*/
+		void mark_all(unsigned slot) noexcept
+		{
+			std::size_t blocks = static_cast<std::size_t>(head.slotBytes / head.blockBytes);
+			for (std::size_t i = 0; i < changedWords; ++i)
+			{
+				std::size_t left = blocks - i * 64;
+				changed[slot][i].store((left >= 64) ? ~0ULL : ((1ULL << left) - 1));
+			}
+		}
+
+	public:
+
+		checkpoint_file() = default;
+
+		checkpoint_file(const checkpoint_file&) = delete;
+
+		checkpoint_file& operator = (const checkpoint_file&) = delete;
+
+		/**
+			\brief Creates (or truncates) the file at path with counters and
+			times set to 0, and opens it.
+
+			<h3>Return</h3>
+			false if the file could not be created or mapped.\n
+		*/
+		bool create(
+			const std::filesystem::path& path /**< : <i>in</i> : The file.*/,
+			std::size_t counters /**< : <i>in</i> : The number of counters.*/,
+			std::size_t times /**< : <i>in</i> : The number of date times.*/
+		) noexcept
+		{
+			close();
+			head = checkpoint_header{};
+			std::memcpy(head.magic, magic, sizeof(magic));
+			head.version = version;
+			head.blockBytes = block_bytes;
+			head.counters = counters;
+			head.times = times;
+			std::uint64_t bytes = (static_cast<std::uint64_t>(counters) + times)
+				* sizeof(std::uint64_t);
+			head.slotBytes = std::max<std::uint64_t>(1, (bytes + block_bytes - 1)
+				/ block_bytes) * block_bytes;
+			head.checksum = checksum(head);
+			head.generation[0] = 1;
+			current.store(0);
+			std::vector<char> first(block_bytes, 0);
+			std::memcpy(first.data(), &head, sizeof(head));
+			bool good = open_file(path, true);
+#if defined(_WIN32)
+			if (good)
+			{
+				LARGE_INTEGER end;
+				end.QuadPart = static_cast<LONGLONG>(slot_offset(2));
+				good = SetFilePointerEx(file, end, nullptr, FILE_BEGIN) && SetEndOfFile(file);
+			}
+#else
+			// the slots are holes, read as 0 till written.
+			good = good && ::ftruncate(fd, static_cast<off_t>(slot_offset(2))) == 0;
+#endif
+			good = good && write_at(first.data(), first.size(), 0) && sync() && map();
+			if (!good)
+				close();
+			return good;
+		}
+
+		/**
+			\brief Opens the checkpoint at path, checking its header, and maps
+			it. The values are those of the last snapshot.
+
+			<h3>Return</h3>
+			false if the file could not be opened or mapped, or is not a
+			checkpoint of this version and of the size its header gives.\n
+		*/
+		bool open(
+			const std::filesystem::path& path /**< : <i>in</i> : The file.*/
+		) noexcept
+		{
+			close();
+			std::size_t size = 0;
+			bool good = open_file(path, false) && file_size(size)
+				&& size >= sizeof(head) && read_at(&head, sizeof(head), 0)
+				&& std::memcmp(head.magic, magic, sizeof(magic)) == 0
+				&& head.version == version && head.checksum == checksum(head)
+				&& head.blockBytes >= sizeof(head) && head.blockBytes % sizeof(std::uint64_t) == 0
+				&& head.slotBytes % head.blockBytes == 0
+				&& head.counters <= head.slotBytes / sizeof(std::uint64_t)
+				&& head.times <= head.slotBytes / sizeof(std::uint64_t) - head.counters
+				&& size == head.blockBytes + 2 * head.slotBytes;
+			if (good)
+			{
+				current.store((head.generation[1] > head.generation[0]) ? 1 : 0);
+				good = map();
+			}
+			if (!good)
+			{
+				close();
+				return false;
+			}
+			// the other slot may hold a snapshot torn by a crash.
+			mark_all(1 - current.load());
+			return true;
+		}
+
+		/**
+			\brief Unmaps and closes the file, values changed since the last
+			snapshot are lost.
+		*/
+		void close() noexcept
+		{
+#if defined(_WIN32)
+			if (view)
+				UnmapViewOfFile(view);
+			if (mapping)
+				CloseHandle(mapping);
+			if (file != INVALID_HANDLE_VALUE)
+				CloseHandle(file);
+			mapping = nullptr;
+			file = INVALID_HANDLE_VALUE;
+#else
+			if (view)
+				::munmap(view, length);
+			if (fd >= 0)
+				::close(fd);
+			fd = -1;
+#endif
+			view = nullptr;
+			length = 0;
+			values = nullptr;
+			changed[0].reset();
+			changed[1].reset();
+			changedWords = 0;
+		}
+
+		/**
+			\brief Unmaps and closes the file.
+		*/
+		~checkpoint_file() { close(); }
+
+		/**
+			\brief true if a checkpoint is open.
+		*/
+		inline bool isOpen() const noexcept { return values != nullptr; }
+
+		/**
+			\brief The number of counters.
+		*/
+		inline std::size_t counters() const noexcept
+		{
+			return static_cast<std::size_t>(head.counters);
+		}
+
+		/**
+			\brief The number of date times.
+		*/
+		inline std::size_t times() const noexcept
+		{
+			return static_cast<std::size_t>(head.times);
+		}
+
+		/**
+			\brief The generation of the last snapshot, counted from 1 at
+			create.
+		*/
+		inline std::uint64_t generation() const noexcept
+		{
+			return head.generation[current.load()];
+		}
+
+		/**
+			\brief The total seconds of counter index.
+		*/
+		inline unsigned long long get_total_seconds(
+			std::size_t index /**< : <i>in</i> : The index.*/
+		) const noexcept
+		{
+			return values[index].load(std::memory_order_relaxed);
+		}
+
+		/**
+			\brief Returns counter index as an enh::counter.
+		*/
+		inline counter getCounter(
+			std::size_t index /**< : <i>in</i> : The index.*/
+		) const noexcept
+		{
+			counter c;
+			c.set_seconds(get_total_seconds(index));
+			return c;
+		}
+
+		/**
+			\brief Sets counter index to the state of c.
+		*/
+		inline void setCounter(
+			std::size_t index /**< : <i>in</i> : The index.*/,
+			const counter& c /**< : <i>in</i> : The counter.*/
+		) noexcept
+		{
+			values[index].store(c.get_total_seconds());
+			mark(index);
+		}
+
+		/**
+			\brief Adds sec seconds to counter index.
+		*/
+		inline void add_seconds(
+			std::size_t index /**< : <i>in</i> : The index.*/,
+			unsigned long long sec /**< : <i>in</i> : The seconds to be added.*/
+		) noexcept
+		{
+			values[index].fetch_add(sec);
+			mark(index);
+		}
+
+		/**
+			\brief The nanoseconds after the unix epoch of date time index.
+		*/
+		inline long long getEpochNanos(
+			std::size_t index /**< : <i>in</i> : The index.*/
+		) const noexcept
+		{
+			return static_cast<long long>(values[head.counters + index].load(
+				std::memory_order_relaxed));
+		}
+
+		/**
+			\brief Returns date time index as an enh::DateTime (UTC).
+		*/
+		inline DateTime getDateTime(
+			std::size_t index /**< : <i>in</i> : The index.*/
+		) const noexcept
+		{
+			DateTime d;
+			d.setEpochNanos(getEpochNanos(index));
+			return d;
+		}
+
+		/**
+			\brief Sets date time index to ns nanoseconds after the unix
+			epoch.
+		*/
+		inline void setEpochNanos(
+			std::size_t index /**< : <i>in</i> : The index.*/,
+			long long ns /**< : <i>in</i> : The nanoseconds from the epoch.*/
+		) noexcept
+		{
+			values[head.counters + index].store(static_cast<std::uint64_t>(ns));
+			mark(static_cast<std::size_t>(head.counters) + index);
+		}
+
+		/**
+			\brief Sets date time index to d (UTC).
+		*/
+		inline void setDateTime(
+			std::size_t index /**< : <i>in</i> : The index.*/,
+			const DateTime& d /**< : <i>in</i> : The date time.*/
+		) noexcept
+		{
+			setEpochNanos(index, d.getEpochNanos());
+		}
+
+		/**
+			\brief The blocks the next snapshot writes.
+		*/
+		std::size_t pending() const noexcept
+		{
+			std::size_t count = 0;
+			if (!isOpen())
+				return 0;
+			for (std::size_t i = 0; i < changedWords; ++i)
+			{
+				count += popCount(changed[1 - current.load()][i].load(
+					std::memory_order_relaxed));
+			}
+			return count;
+		}
+
+		/**
+			\brief Writes the values to the slot not current and makes it
+			current, writing only the blocks changed since it was last
+			written. Blocks till the file is flushed, writers go on.
+
+			<h3>Return</h3>
+			false if not open or a write failed, the last snapshot is then
+			kept and the blocks are written by the next.\n
+		*/
+		bool snapshot()
+		{
+			std::lock_guard<std::mutex> guard(snapping);
+			if (!isOpen())
+				return false;
+			unsigned now = current.load();
+			unsigned next = 1 - now;
+			std::vector<std::uint64_t> taken(changedWords);
+			std::vector<std::uint64_t> staging;
+			std::size_t perBlock = head.blockBytes / sizeof(std::uint64_t);
+			// copies blocks [first, last) by atomic loads, so no value is
+			// torn by a writer, and writes them to slot next.
+			auto put = [&](std::size_t first, std::size_t last) {
+				staging.resize((last - first) * perBlock);
+				const word* from = values + first * perBlock;
+				for (std::size_t i = 0; i < staging.size(); ++i)
+					staging[i] = from[i].load();
+				return write_at(staging.data(), staging.size() * sizeof(std::uint64_t),
+					slot_offset(next) + first * head.blockBytes);
+			};
+			bool good = true;
+			std::size_t runStart = 0, runEnd = 0;
+			for (std::size_t i = 0; i < changedWords && good; ++i)
+			{
+				taken[i] = changed[next][i].exchange(0);
+				for (std::uint64_t bits = taken[i]; bits && good; bits &= bits - 1)
+				{
+					std::size_t block = i * 64 + countTrailingZeros(bits);
+					if (block == runEnd && runEnd - runStart < max_run)
+					{
+						++runEnd;
+						continue;
+					}
+					if (runEnd != runStart)
+						good = put(runStart, runEnd);
+					runStart = block;
+					runEnd = block + 1;
+				}
+			}
+			if (good && runEnd != runStart)
+				good = put(runStart, runEnd);
+			good = good && sync();
+			if (good)
+			{
+				std::uint64_t gen = head.generation[now] + 1;
+				good = write_at(&gen, sizeof(gen), offsetof(checkpoint_header, generation)
+					+ next * sizeof(gen)) && sync();
+				if (good)
+				{
+					head.generation[next] = gen;
+					current.store(next);
+				}
+			}
+			if (!good)
+				for (std::size_t i = 0; i < changedWords; ++i)
+					if (taken[i])
+						changed[next][i].fetch_or(taken[i]);
+			return good;
+		}
+	};
+}
+
+#endif
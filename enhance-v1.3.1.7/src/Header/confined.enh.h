@@ -27,27 +27,148 @@
 
 #define CONFINED_ENH_H							confined.enh.h
 
+#include "result.enh.h"
+
 #include <functional>
+#include <new>
 #include <stdexcept>
 
 
 namespace enh
 {
+	/**
+		\brief The value and number of wraps of a confined addition or 
+		subtraction.
+	*/
+	template<class integral>
+	struct carry_result
+	{
+		/**
+			\brief The new value.
+		*/
+		integral value;
+
+		/**
+			\brief The number of times the interval wrapped.
+		*/
+		unsigned long long carry;
+	};
+
+	/**
+		\brief Adds n to offset off of an interval of span values, wrapping.
+
+		One division and a conditional subtract, which compile to shifts and
+		masks when span is a constant (power of two or not).
+
+		<h3>Return</h3>
+		The new offset and the number of wraps.\n
+	*/
+	constexpr inline carry_result<unsigned long long> confined_wrap_add(
+		unsigned long long off /**< : <i>in</i> : The offset, below span.*/,
+		unsigned long long n /**< : <i>in</i> : The units to add.*/,
+		unsigned long long span /**< : <i>in</i> : The values in the 
+								interval, not 0.*/
+	) noexcept
+	{
+		unsigned long long sum = off + n % span;
+		bool over = sum >= span;
+		return { sum - (over ? span : 0ULL), n / span + (over ? 1ULL : 0ULL) };
+	}
+
+	/**
+		\brief Subtracts n from offset off of an interval of span values, 
+		wrapping.
+
+		<h3>Return</h3>
+		The new offset and the number of wraps.\n
+	*/
+	constexpr inline carry_result<unsigned long long> confined_wrap_sub(
+		unsigned long long off /**< : <i>in</i> : The offset, below span.*/,
+		unsigned long long n /**< : <i>in</i> : The units to subtract.*/,
+		unsigned long long span /**< : <i>in</i> : The values in the
+								interval, not 0.*/
+	) noexcept
+	{
+		unsigned long long rem = n % span;
+		bool under = rem > off;
+		return { off + (under ? span : 0ULL) - rem, n / span + (under ? 1ULL : 0ULL) };
+	}
+
+	/**
+		\brief The limit getter of a constant value, for confined_base.
+	*/
+	template<long long val>
+	struct confined_constant
+	{
+		constexpr inline long long operator () () const noexcept { return val; }
+	};
+
+	/**
+		\brief The upper limit checker against a limit getter, for 
+		confined_base.
+	*/
+	template<class limit>
+	struct confined_at_most
+	{
+		/**
+			\brief The limit getter.
+		*/
+		limit lim;
+
+		constexpr inline bool operator () (long long a) const noexcept
+		{
+			return a <= static_cast<long long>(lim());
+		}
+	};
+
+	/**
+		\brief The lower limit checker against a limit getter, for 
+		confined_base.
+	*/
+	template<class limit>
+	struct confined_at_least
+	{
+		/**
+			\brief The limit getter.
+		*/
+		limit lim;
+
+		constexpr inline bool operator () (long long a) const noexcept
+		{
+			return a >= static_cast<long long>(lim());
+		}
+	};
+
 	/**
 		\brief Define an integral type that is confined to an interval.
 
 		The interval is specified by two functions set during construction.
 		The interval check is done by other function set during construction.
 
+		The types of the four functions are template parameters, 
+		std::function by default. Stateless or small functors 
+		(see confined_at_most, confined_at_least, confined_constant) are 
+		stored inline and called directly, so the checks can be inlined.
+
 		<h3>template</h3>
-		<code>integral</code> : The integral type of the value.
+		-# <code>integral</code> : The integral type of the value.\n
+		-# <code>upper_pred</code> : The type of the upper limit checker,
+		callable as bool(long long).\n
+		-# <code>lower_pred</code> : The type of the lower limit checker.\n
+		-# <code>upper_limit</code> : The type of the upper limit getter,
+		callable as integral().\n
+		-# <code>lower_limit</code> : The type of the lower limit getter.\n
 
 		<h3>Example</h3>
 
 		\include{lineno} confined_base_ex.cpp
 
 	*/
-	template<class integral>
+	template<class integral, 
+		class upper_pred = std::function<bool(long long)>,
+		class lower_pred = upper_pred,
+		class upper_limit = std::function<integral()>,
+		class lower_limit = upper_limit>
 	class confined_base
 	{
 	public:
@@ -66,6 +187,26 @@ namespace enh
 			\brief The function type of the limit getter.
 		*/
 		using limit_t = std::function<value_type()>;
+
+		/**
+			\brief The type of the upper limit checker.
+		*/
+		using upper_pred_t = upper_pred;
+
+		/**
+			\brief The type of the lower limit checker.
+		*/
+		using lower_pred_t = lower_pred;
+
+		/**
+			\brief The type of the upper limit getter.
+		*/
+		using upper_limit_t = upper_limit;
+
+		/**
+			\brief The type of the lower limit getter.
+		*/
+		using lower_limit_t = lower_limit;
 	private:
 
 		/**
@@ -76,22 +217,22 @@ namespace enh
 		/**
 			\brief The upper limit checker.
 		*/
-		pred_t uLimit_pred;
+		upper_pred_t uLimit_pred;
 
 		/**
 			\brief The lower limit checker.
 		*/
-		pred_t lLimit_pred;
+		lower_pred_t lLimit_pred;
 
 		/**
 			\brief The upper limit.
 		*/
-		limit_t uLimit;
+		upper_limit_t uLimit;
 
 		/**
 			\brief The lower limit.
 		*/
-		limit_t lLimit;
+		lower_limit_t lLimit;
 	public:
 
 		/**
@@ -113,7 +254,7 @@ namespace enh
 		/**
 			\brief Returns upper checking function.
 		*/
-		constexpr inline pred_t getUpperPredicate() const noexcept
+		constexpr inline upper_pred_t getUpperPredicate() const noexcept
 		{
 			return uLimit_pred;
 		}
@@ -121,7 +262,7 @@ namespace enh
 		/**
 			\brief Returns lower checking function.
 		*/
-		constexpr inline pred_t getLowerPredicate() const noexcept
+		constexpr inline lower_pred_t getLowerPredicate() const noexcept
 		{
 			return lLimit_pred;
 		}
@@ -135,14 +276,14 @@ namespace enh
 			Throws <code>std::invalid_argument</code> if ulimit is less than llimit.
 		*/
 		constexpr inline confined_base(
-			pred_t upper_p /**< : <i>in</i> : The upper bounds 
+			upper_pred_t upper_p /**< : <i>in</i> : The upper bounds 
 								  checker.*/,
-			pred_t lower_p /**< : <i>in</i> : The lower bounds
+			lower_pred_t lower_p /**< : <i>in</i> : The lower bounds
 								  checker.*/,
-			limit_t upper_l /**< : <i>in</i> : Get the upper bounds.*/,
-			limit_t lower_l /**< : <i>in</i> : Get the lower bounds.*/,
+			upper_limit_t upper_l /**< : <i>in</i> : Get the upper bounds.*/,
+			lower_limit_t lower_l /**< : <i>in</i> : Get the lower bounds.*/,
 			value_type val /**< : <i>in</i> : The value to be set.*/
-		) :uLimit_pred(upper_p), lLimit_pred(lower_p), value(val),
+		) :value(val), uLimit_pred(upper_p), lLimit_pred(lower_p),
 			uLimit(upper_l), lLimit(lower_l)
 		{
 			if (uLimit() < lLimit())
@@ -161,14 +302,14 @@ namespace enh
 			Throws <code>std::invalid_argument</code> if ulimit is less than llimit.
 		*/
 		constexpr inline confined_base(
-			pred_t upper_p /**< : <i>in</i> : The upper bounds
+			upper_pred_t upper_p /**< : <i>in</i> : The upper bounds
 								  checker.*/,
-			pred_t lower_p /**< : <i>in</i> : The lower bounds
+			lower_pred_t lower_p /**< : <i>in</i> : The lower bounds
 								  checker.*/,
-			limit_t upper_l /**< : <i>in</i> : Get the upper bounds.*/,
-			limit_t lower_l /**< : <i>in</i> : Get the lower bounds.*/
-		) :uLimit_pred(upper_p), lLimit_pred(lower_p),
-			uLimit(upper_l), lLimit(lower_l), value(0)
+			upper_limit_t upper_l /**< : <i>in</i> : Get the upper bounds.*/,
+			lower_limit_t lower_l /**< : <i>in</i> : Get the lower bounds.*/
+		) :value(0), uLimit_pred(upper_p), lLimit_pred(lower_p),
+			uLimit(upper_l), lLimit(lower_l)
 		{
 			if (uLimit() < lLimit())
 				throw std::invalid_argument("upper limit should be greater than lower");
@@ -193,6 +334,24 @@ namespace enh
 			value = val;
 		}
 
+		/**
+			\brief Sets the value, without throwing.
+
+			<h3>Return</h3>
+			A failure of result_code::INVALID_ARG (value unchanged) if val is
+			not within limits.\n
+		*/
+		constexpr inline result<void> set(
+			const value_type &val /**< : <i>in</i> : The value to be set.*/,
+			std::nothrow_t /**< : <i>in</i> : std::nothrow.*/
+		) noexcept
+		{
+			if (!uLimit_pred(val) || !lLimit_pred(val))
+				return fail(result_code::INVALID_ARG);
+			value = val;
+			return {};
+		}
+
 		/**
 			\brief Returns the value held.
 		*/
@@ -224,26 +383,35 @@ namespace enh
 			above upper limit.
 
 			for confining between 2 and 9 (inclusive),
-			from  value 6, add(20) will return 3 and sets value to 5.
+			from  value 6, add(20) will return 3 and sets value to 2.
 		*/
 		constexpr inline unsigned long long add(
 			unsigned long long additional /**< : <i>in</i> : The number of units to
 								  add.*/
 		) noexcept
 		{
-			if (additional == 0)
-				return 0;
-			unsigned long long rem = additional % (uLimit() - lLimit());
-			unsigned long long ret = additional / (uLimit() - lLimit());
+			auto res = add_carry(additional);
+			value = res.value;
+			return res.carry;
+		}
 
-			if (!uLimit_pred((unsigned long long)(value) + rem))
-			{
-				value = value + rem + lLimit() - uLimit() - 1;
-				++ret;
-			}
-			else
-				value += rem;
-			return ret;
+		/**
+			\brief The value and wraps add(additional) would give, without 
+			changing the value held.
+
+			The limits are read once.
+		*/
+		constexpr inline carry_result<value_type> add_carry(
+			unsigned long long additional /**< : <i>in</i> : The number of units to
+								  add.*/
+		) const noexcept
+		{
+			if (additional == 0)
+				return { value, 0 };
+			value_type lo = lLimit();
+			auto res = confined_wrap_add(static_cast<unsigned long long>(value - lo),
+				additional, static_cast<unsigned long long>(uLimit() - lo) + 1ULL);
+			return { static_cast<value_type>(lo + res.value), res.carry };
 		}
 
 		/**
@@ -252,7 +420,7 @@ namespace enh
 			<h3>Return</h3>
 			Reference to current object.
 		*/
-		constexpr inline confined_base<value_type> &operator ++() noexcept
+		constexpr inline confined_base &operator ++() noexcept
 		{
 			add();
 			return *this;
@@ -264,9 +432,9 @@ namespace enh
 			<h3>Return</h3>
 			Previous state of object.
 		*/
-		constexpr inline confined_base<value_type> operator ++(int) noexcept
+		constexpr inline confined_base operator ++(int) noexcept
 		{
-			confined_base<value_type> temp = *this;
+			confined_base temp = *this;
 			add();
 			return temp;
 		}
@@ -275,7 +443,7 @@ namespace enh
 			\brief Adds to current object and returns reference to the 
 			current object.
 		*/
-		constexpr inline confined_base<value_type> &operator += (
+		constexpr inline confined_base &operator += (
 			unsigned long long val /**< : <i>in</i> : The number of units to
 								  add.*/
 		)
@@ -310,26 +478,35 @@ namespace enh
 			above upper limit.
 
 			for confining between 2 and 9 (inclusive),
-			from  value 6, sub(20) will return 3 and set value to 7.
+			from  value 6, sub(20) will return 2 and set value to 2.
 		*/
 		constexpr inline unsigned long long sub(
 			unsigned long long difference /**< : <i>in</i> : The number of units to
 								 subtract.*/
 		) noexcept
 		{
-			if (difference == 0)
-				return 0;
-		    unsigned long long rem = difference % (uLimit() - lLimit());
-			unsigned long long ret = difference / (uLimit() - lLimit());
+			auto res = sub_carry(difference);
+			value = res.value;
+			return res.carry;
+		}
 
-			if (!lLimit_pred(value - rem))
-			{
-				value = value - rem + uLimit() - lLimit() + 1;
-				++ret;
-			}
-			else
-				value = value - rem;
-			return ret;
+		/**
+			\brief The value and wraps sub(difference) would give, without
+			changing the value held.
+
+			The limits are read once.
+		*/
+		constexpr inline carry_result<value_type> sub_carry(
+			unsigned long long difference /**< : <i>in</i> : The number of units to
+								 subtract.*/
+		) const noexcept
+		{
+			if (difference == 0)
+				return { value, 0 };
+			value_type lo = lLimit();
+			auto res = confined_wrap_sub(static_cast<unsigned long long>(value - lo),
+				difference, static_cast<unsigned long long>(uLimit() - lo) + 1ULL);
+			return { static_cast<value_type>(lo + res.value), res.carry };
 		}
 
 		/**
@@ -338,7 +515,7 @@ namespace enh
 			<h3>Return</h3>
 			Reference to current object.
 		*/
-		constexpr inline confined_base<value_type> &operator --() noexcept
+		constexpr inline confined_base &operator --() noexcept
 		{
 			sub();
 			return *this;
@@ -350,9 +527,9 @@ namespace enh
 			<h3>Return</h3>
 			Previous state of object.
 		*/
-		constexpr inline confined_base<value_type> operator --(int) noexcept
+		constexpr inline confined_base operator --(int) noexcept
 		{
-			confined_base<value_type> temp = *this;
+			confined_base temp = *this;
 			sub();
 			return temp;
 		}
@@ -361,7 +538,7 @@ namespace enh
 			\brief Subtracts from the current object and returns reference 
 			to the current object.
 		*/
-		constexpr inline confined_base<value_type> &operator -= (
+		constexpr inline confined_base &operator -= (
 			unsigned long long val /**< : <i>in</i> : The number of units to
 								  subtract.*/
 		)
@@ -404,9 +581,9 @@ namespace enh
 	/**
 		\brief Adds rhs to a copy of lhs then returns the sum. 
 	*/
-	template<class integral>
-	constexpr inline confined_base<integral> operator +(
-		const confined_base<integral> &lhs /**< : <i>in</i> : LHS argument 
+	template<class integral, class... bounds>
+	constexpr inline confined_base<integral, bounds...> operator +(
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : LHS argument 
 										   of operator.*/,
 		const unsigned long long &rhs /**< : <i>in</i> : RHS argument of operator.*/
 	) noexcept
@@ -419,10 +596,10 @@ namespace enh
 	/**
 		\brief Adds lhs to a copy of rhs then returns the sum.
 	*/
-	template<class integral>
-	constexpr inline confined_base<integral> operator +(
+	template<class integral, class... bounds>
+	constexpr inline confined_base<integral, bounds...> operator +(
 		const unsigned long long &lhs  /**< : <i>in</i> : LHS argument of operator.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : RHS argument
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : RHS argument
 										   of operator.*/
 	) noexcept
 	{
@@ -434,9 +611,9 @@ namespace enh
 	/**
 		\brief Subtracts rhs to a copy of lhs then returns the difference.
 	*/
-	template<class integral>
-	constexpr inline confined_base<integral> operator -(
-		const confined_base<integral> &lhs /**< : <i>in</i> : LHS argument
+	template<class integral, class... bounds>
+	constexpr inline confined_base<integral, bounds...> operator -(
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : LHS argument
 										   of operator.*/,
 		const unsigned long long &rhs /**< : <i>in</i> : RHS argument of operator.*/
 		) noexcept
@@ -449,10 +626,10 @@ namespace enh
 	/**
 		\brief Subtracts lhs to a copy of rhs then returns the difference.
 	*/
-	template<class integral>
-	constexpr inline confined_base<integral> operator -(
+	template<class integral, class... bounds>
+	constexpr inline confined_base<integral, bounds...> operator -(
 		const unsigned long long &lhs  /**< : <i>in</i> : LHS argument of operator.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : RHS argument
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : RHS argument
 										   of operator.*/
 		) noexcept
 	{
@@ -467,11 +644,11 @@ namespace enh
 	/**
 		\brief Checks if lhs is equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator == (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand 
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand 
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
@@ -481,11 +658,11 @@ namespace enh
 	/**
 		\brief Checks if lhs is not equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator != (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
@@ -495,11 +672,11 @@ namespace enh
 	/**
 		\brief Checks if lhs is greater than rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator > (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
@@ -509,11 +686,11 @@ namespace enh
 	/**
 		\brief Checks if lhs is greater than or equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator >= (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
@@ -523,11 +700,11 @@ namespace enh
 	/**
 		\brief Checks if lhs is lesser than rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator < (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
@@ -537,11 +714,11 @@ namespace enh
 	/**
 		\brief Checks if lhs is lesser than or equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator <= (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
@@ -554,9 +731,9 @@ namespace enh
 	/**
 		\brief Checks if lhs is equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator == (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
 		const long long &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
@@ -568,9 +745,9 @@ namespace enh
 	/**
 		\brief Checks if lhs is not equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator != (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
 		const long long &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
@@ -582,9 +759,9 @@ namespace enh
 	/**
 		\brief Checks if lhs is greater than rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator > (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
 		const long long &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
@@ -596,9 +773,9 @@ namespace enh
 	/**
 		\brief Checks if lhs is greater than or equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator >= (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
 		const long long &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
@@ -610,9 +787,9 @@ namespace enh
 	/**
 		\brief Checks if lhs is lesser than rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator < (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
 		const long long &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
@@ -624,9 +801,9 @@ namespace enh
 	/**
 		\brief Checks if lhs is lesser than or equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator <= (
-		const confined_base<integral> &lhs /**< : <i>in</i> : The left hand
+		const confined_base<integral, bounds...> &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
 		const long long &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
@@ -640,11 +817,11 @@ namespace enh
 	/**
 		\brief Checks if lhs is equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator == (
 		const long long &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
@@ -654,11 +831,11 @@ namespace enh
 	/**
 		\brief Checks if lhs is not equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator != (
 		const long long &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
@@ -668,11 +845,11 @@ namespace enh
 	/**
 		\brief Checks if lhs is greater than rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator > (
 		const long long &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
@@ -682,11 +859,11 @@ namespace enh
 	/**
 		\brief Checks if lhs is greater than or equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator >= (
 		const long long &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
@@ -696,11 +873,11 @@ namespace enh
 	/**
 		\brief Checks if lhs is lesser than rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator < (
 		const long long &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
@@ -710,17 +887,589 @@ namespace enh
 	/**
 		\brief Checks if lhs is lesser than or equal to rhs.
 	*/
-	template<class integral>
+	template<class integral, class... bounds>
 	constexpr inline bool operator <= (
 		const long long &lhs /**< : <i>in</i> : The left hand
 										   side of the expression.*/,
-		const confined_base<integral> &rhs /**< : <i>in</i> : The right hand
+		const confined_base<integral, bounds...> &rhs /**< : <i>in</i> : The right hand
 										   side of the expression.*/
 		) noexcept
 	{
 		return (lhs < rhs.get());
 	}
 
+
+	/**
+		\brief Define an integral type that is confined to the interval
+		[lower, upper], with the bounds fixed at compile time.
+
+		It holds only the value, and add and sub are an add and a compare
+		(or a division for large steps), all constexpr. Use confined_base
+		when the bounds are only known at run time or change.
+
+		Values wrap around the interval, add(n) from value v is
+		lower + (v - lower + n) % (upper - lower + 1), returning the number
+		of wraps.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>template</h3>
+		-# <code>integral</code> : The integral type of the value.\n
+		-# <code>integral lower</code> : The lowest value (inclusive).\n
+		-# <code>integral upper</code> : The highest value (inclusive).\n
+	*/
+	template<class integral, integral lower, integral upper>
+	class static_confined
+	{
+		static_assert(lower <= upper, "upper limit should be greater than lower");
+
+	public:
+
+		/**
+			\brief An alias of the integral type.
+		*/
+		using value_type = integral;
+
+		/**
+			\brief The number of values in the interval.
+		*/
+		static constexpr unsigned long long span = 
+			static_cast<unsigned long long>(upper - lower) + 1ULL;
+
+	private:
+
+		/**
+			\brief The data.
+		*/
+		value_type value;
+
+	public:
+
+		/**
+			\brief Returns upper limit.
+		*/
+		static constexpr inline value_type getUpperLimit() noexcept { return upper; }
+
+		/**
+			\brief Returns lower limit.
+		*/
+		static constexpr inline value_type getLowerLimit() noexcept { return lower; }
+
+		/**
+			\brief Checks if val is within the limits.
+		*/
+		static constexpr inline bool isWithin(
+			long long val /**< : <i>in</i> : The value to check.*/
+		) noexcept
+		{
+			return (val >= static_cast<long long>(lower)) 
+				&& (val <= static_cast<long long>(upper));
+		}
+
+		/**
+			\brief Construct the object, value as set as lower limit.
+		*/
+		constexpr inline static_confined() noexcept : value(lower) {}
+
+		/**
+			\brief Construct the object.
+
+			<h3>Exceptions</h3>
+			Throws <code>std::invalid_argument</code> if value passed is not
+			within limits.
+		*/
+		constexpr inline static_confined(
+			value_type val /**< : <i>in</i> : The value to be set.*/
+		) : value(lower)
+		{
+			set(val);
+		}
+
+		/**
+			\brief Sets the value.
+
+			<h3>Exception</h3>
+			Throws <code>std::invalid_argument</code> if value is not within
+			limits.
+		*/
+		constexpr inline void set(
+			const value_type &val /**< : <i>in</i> : The value to be set.*/
+		)
+		{
+			if (!isWithin(static_cast<long long>(val)))
+				throw std::invalid_argument("value not within limits");
+			value = val;
+		}
+
+		/**
+			\brief Sets the value, without throwing.
+
+			<h3>Return</h3>
+			A failure of result_code::INVALID_ARG (value unchanged) if val is
+			not within limits.\n
+		*/
+		constexpr inline result<void> set(
+			const value_type &val /**< : <i>in</i> : The value to be set.*/,
+			std::nothrow_t /**< : <i>in</i> : std::nothrow.*/
+		) noexcept
+		{
+			if (!isWithin(static_cast<long long>(val)))
+				return fail(result_code::INVALID_ARG);
+			value = val;
+			return {};
+		}
+
+		/**
+			\brief Constructs the object holding val, without throwing.
+
+			<h3>Return</h3>
+			A failure of result_code::INVALID_ARG if val is not within
+			limits.\n
+		*/
+		static constexpr inline result<static_confined> create(
+			const value_type &val /**< : <i>in</i> : The value.*/
+		) noexcept
+		{
+			if (!isWithin(static_cast<long long>(val)))
+				return fail(result_code::INVALID_ARG);
+			static_confined c;
+			c.value = val;
+			return c;
+		}
+
+		/**
+			\brief Returns the value held.
+		*/
+		constexpr inline value_type get() const noexcept { return value; }
+
+		/**
+			\brief Adds single unit to the value held.
+
+			<h3>Return</h3>
+			Returns 1 if value goes above upper limit and value is set to 
+			lower limit.
+		*/
+		constexpr inline unsigned add() noexcept
+		{
+			if (value == upper)
+			{
+				value = lower;
+				return 1;
+			}
+			++value;
+			return 0;
+		}
+
+		/**
+			\brief Adds to the value held.
+
+			<h3>Return</h3>
+			Returns the number of times the value wrapped past upper limit.
+
+			for confining between 2 and 9 (inclusive),
+			from  value 6, add(20) will return 3 and sets value to 2.
+		*/
+		constexpr inline unsigned long long add(
+			unsigned long long additional /**< : <i>in</i> : The number of units to
+								  add.*/
+		) noexcept
+		{
+			auto res = add_carry(value, additional);
+			value = res.value;
+			return res.carry;
+		}
+
+		/**
+			\brief The value and wraps of adding additional to val.
+
+			span is a constant, so this is a multiply and shift (a mask and 
+			shift if span is a power of two) and a conditional subtract.
+		*/
+		static constexpr inline carry_result<value_type> add_carry(
+			value_type val /**< : <i>in</i> : The value, within limits.*/,
+			unsigned long long additional /**< : <i>in</i> : The number of units to
+								  add.*/
+		) noexcept
+		{
+			auto res = confined_wrap_add(static_cast<unsigned long long>(val - lower),
+				additional, span);
+			return { static_cast<value_type>(lower + res.value), res.carry };
+		}
+
+		/**
+			\brief Subtracts one unit from the value held.
+
+			<h3>Return</h3>
+			Returns 1 if value goes below lower limit and value is set to
+			upper limit.
+		*/
+		constexpr inline unsigned sub() noexcept
+		{
+			if (value == lower)
+			{
+				value = upper;
+				return 1;
+			}
+			--value;
+			return 0;
+		}
+
+		/**
+			\brief Subtracts from the value held.
+
+			<h3>Return</h3>
+			Returns the number of times the value wrapped past lower limit.
+
+			for confining between 2 and 9 (inclusive),
+			from  value 6, sub(20) will return 2 and set value to 2.
+		*/
+		constexpr inline unsigned long long sub(
+			unsigned long long difference /**< : <i>in</i> : The number of units to
+								 subtract.*/
+		) noexcept
+		{
+			auto res = sub_carry(value, difference);
+			value = res.value;
+			return res.carry;
+		}
+
+		/**
+			\brief The value and wraps of subtracting difference from val.
+		*/
+		static constexpr inline carry_result<value_type> sub_carry(
+			value_type val /**< : <i>in</i> : The value, within limits.*/,
+			unsigned long long difference /**< : <i>in</i> : The number of units to
+								 subtract.*/
+		) noexcept
+		{
+			auto res = confined_wrap_sub(static_cast<unsigned long long>(val - lower),
+				difference, span);
+			return { static_cast<value_type>(lower + res.value), res.carry };
+		}
+
+		/**
+			\brief Adds single unit to the value held.
+
+			<h3>Return</h3>
+			Reference to current object.
+		*/
+		constexpr inline static_confined &operator ++() noexcept
+		{
+			add();
+			return *this;
+		}
+
+		/**
+			\brief Adds single unit to the value held.
+
+			<h3>Return</h3>
+			Previous state of object.
+		*/
+		constexpr inline static_confined operator ++(int) noexcept
+		{
+			static_confined temp = *this;
+			add();
+			return temp;
+		}
+
+		/**
+			\brief Adds to current object and returns reference to the 
+			current object.
+		*/
+		constexpr inline static_confined &operator += (
+			unsigned long long val /**< : <i>in</i> : The number of units to
+								  add.*/
+		) noexcept
+		{
+			add(val);
+			return *this;
+		}
+
+		/**
+			\brief Subtracts single unit from the value held.
+
+			<h3>Return</h3>
+			Reference to current object.
+		*/
+		constexpr inline static_confined &operator --() noexcept
+		{
+			sub();
+			return *this;
+		}
+
+		/**
+			\brief Subtracts single unit from the value held.
+
+			<h3>Return</h3>
+			Previous state of object.
+		*/
+		constexpr inline static_confined operator --(int) noexcept
+		{
+			static_confined temp = *this;
+			sub();
+			return temp;
+		}
+
+		/**
+			\brief Subtracts from the current object and returns reference 
+			to the current object.
+		*/
+		constexpr inline static_confined &operator -= (
+			unsigned long long val /**< : <i>in</i> : The number of units to
+								  subtract.*/
+		) noexcept
+		{
+			sub(val);
+			return *this;
+		}
+
+		/**
+			\brief Present for the interface of confined_base, the limits
+			never change.
+
+			<h3>Return</h3>
+			Returns false.
+		*/
+		constexpr inline bool re_eval() noexcept
+		{
+			return false;
+		}
+
+		/**
+			\brief Adds rhs to a copy of lhs then returns the sum. 
+		*/
+		friend constexpr inline static_confined operator +(
+			static_confined lhs /**< : <i>in</i> : LHS argument of operator.*/,
+			unsigned long long rhs /**< : <i>in</i> : RHS argument of operator.*/
+		) noexcept
+		{
+			lhs.add(rhs);
+			return lhs;
+		}
+
+		/**
+			\brief Adds lhs to a copy of rhs then returns the sum. 
+		*/
+		friend constexpr inline static_confined operator +(
+			unsigned long long lhs /**< : <i>in</i> : LHS argument of operator.*/,
+			static_confined rhs /**< : <i>in</i> : RHS argument of operator.*/
+		) noexcept
+		{
+			rhs.add(lhs);
+			return rhs;
+		}
+
+		/**
+			\brief Subtracts rhs from a copy of lhs then returns the 
+			difference. 
+		*/
+		friend constexpr inline static_confined operator -(
+			static_confined lhs /**< : <i>in</i> : LHS argument of operator.*/,
+			unsigned long long rhs /**< : <i>in</i> : RHS argument of operator.*/
+		) noexcept
+		{
+			lhs.sub(rhs);
+			return lhs;
+		}
+
+		/**
+			\brief Checks if lhs is equal to rhs.
+		*/
+		friend constexpr inline bool operator == (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs.get() == rhs.get());
+		}
+
+		/**
+			\brief Checks if lhs is not equal to rhs.
+		*/
+		friend constexpr inline bool operator != (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs.get() != rhs.get());
+		}
+
+		/**
+			\brief Checks if lhs is greater than rhs.
+		*/
+		friend constexpr inline bool operator > (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs.get() > rhs.get());
+		}
+
+		/**
+			\brief Checks if lhs is greater than or equal to rhs.
+		*/
+		friend constexpr inline bool operator >= (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs.get() >= rhs.get());
+		}
+
+		/**
+			\brief Checks if lhs is lesser than rhs.
+		*/
+		friend constexpr inline bool operator < (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs.get() < rhs.get());
+		}
+
+		/**
+			\brief Checks if lhs is lesser than or equal to rhs.
+		*/
+		friend constexpr inline bool operator <= (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs.get() <= rhs.get());
+		}
+
+		/**
+			\brief Checks if lhs is equal to rhs.
+		*/
+		friend constexpr inline bool operator == (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			long long rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (static_cast<long long>(lhs.get()) == rhs);
+		}
+
+		/**
+			\brief Checks if lhs is not equal to rhs.
+		*/
+		friend constexpr inline bool operator != (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			long long rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (static_cast<long long>(lhs.get()) != rhs);
+		}
+
+		/**
+			\brief Checks if lhs is greater than rhs.
+		*/
+		friend constexpr inline bool operator > (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			long long rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (static_cast<long long>(lhs.get()) > rhs);
+		}
+
+		/**
+			\brief Checks if lhs is greater than or equal to rhs.
+		*/
+		friend constexpr inline bool operator >= (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			long long rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (static_cast<long long>(lhs.get()) >= rhs);
+		}
+
+		/**
+			\brief Checks if lhs is lesser than rhs.
+		*/
+		friend constexpr inline bool operator < (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			long long rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (static_cast<long long>(lhs.get()) < rhs);
+		}
+
+		/**
+			\brief Checks if lhs is lesser than or equal to rhs.
+		*/
+		friend constexpr inline bool operator <= (
+			const static_confined &lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			long long rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (static_cast<long long>(lhs.get()) <= rhs);
+		}
+
+		/**
+			\brief Checks if lhs is equal to rhs.
+		*/
+		friend constexpr inline bool operator == (
+			long long lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs == static_cast<long long>(rhs.get()));
+		}
+
+		/**
+			\brief Checks if lhs is not equal to rhs.
+		*/
+		friend constexpr inline bool operator != (
+			long long lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs != static_cast<long long>(rhs.get()));
+		}
+
+		/**
+			\brief Checks if lhs is greater than rhs.
+		*/
+		friend constexpr inline bool operator > (
+			long long lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs > static_cast<long long>(rhs.get()));
+		}
+
+		/**
+			\brief Checks if lhs is greater than or equal to rhs.
+		*/
+		friend constexpr inline bool operator >= (
+			long long lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs >= static_cast<long long>(rhs.get()));
+		}
+
+		/**
+			\brief Checks if lhs is lesser than rhs.
+		*/
+		friend constexpr inline bool operator < (
+			long long lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs < static_cast<long long>(rhs.get()));
+		}
+
+		/**
+			\brief Checks if lhs is lesser than or equal to rhs.
+		*/
+		friend constexpr inline bool operator <= (
+			long long lhs /**< : <i>in</i> : The left hand side of the expression.*/,
+			const static_confined &rhs /**< : <i>in</i> : The right hand side of the expression.*/
+			) noexcept
+		{
+			return (lhs <= static_cast<long long>(rhs.get()));
+		}
+	};
 }
 
 
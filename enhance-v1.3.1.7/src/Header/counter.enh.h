@@ -27,7 +27,14 @@
 
 #define COUNTER_ENH_H			counter.enh.h
 
+#include "result.enh.h"
+
 #include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <system_error>
+#include <cstring>
+#include <stdexcept>
 #include <string>
 #include <exception>
 #include <ostream>
@@ -40,6 +47,10 @@ namespace enh
 	/**
 		\brief The class for counter functionality.
 
+		The state is one atomic count of seconds, so adds from many threads
+		are each a single atomic addition and reads see a consistent state.
+		The days are limited to about 2.1e14 (2^64 seconds).\n\n
+
 		hasErrorHandlers        = false;\n
 
 
@@ -53,30 +64,97 @@ namespace enh
 	class counter
 	{
 		/**
-			\brief Stores the seconds state of counter.
+			\brief Stores the state of counter as total seconds.
 
-			value < 60.\n\n
+			The seconds, minutes, hours and days are derived from it when 
+			read, so every change is one atomic operation.\n\n
 		*/
-		std::atomic<unsigned> seconds;
+		std::atomic<unsigned long long> total;
 
 		/**
-			\brief Stores the minutes state of counter.
+			\brief The seconds in a minute, hour and day.
+		*/
+		static constexpr unsigned long long per_minute = 60ULL;
+		static constexpr unsigned long long per_hour = 3600ULL;
+		static constexpr unsigned long long per_day = 86400ULL;
+
+		/**
+			\brief The total hours of tot seconds, rounded as get_total_hours.
+		*/
+		static constexpr unsigned long long total_hours_of(
+			unsigned long long tot /**< : <i>in</i> : The total seconds.*/
+		) noexcept
+		{
+			unsigned long long min = tot / per_minute % 60;
+			unsigned long long sec = tot % per_minute;
+			return tot / per_hour + (((min >= 45) || ((min >= 44) && (sec >= 45))) 
+				? 1 : 0);
+		}
+
+		/**
+			\brief Writes the low bytes of v to out, least significant first.
+		*/
+		static inline void put_le(
+			char* out /**< : <i>out</i> : The buffer.*/,
+			unsigned long long v /**< : <i>in</i> : The value.*/,
+			unsigned bytes /**< : <i>in</i> : The bytes to write.*/
+		) noexcept
+		{
+			for (unsigned i = 0; i < bytes; ++i)
+				out[i] = static_cast<char>((v >> (8 * i)) & 0xFFU);
+		}
 
-			value < 60.\n\n
+		/**
+			\brief Reads bytes from in, least significant first.
 		*/
-		std::atomic<unsigned> minutes;
+		static inline unsigned long long get_le(
+			const char* in /**< : <i>in</i> : The buffer.*/,
+			unsigned bytes /**< : <i>in</i> : The bytes to read.*/
+		) noexcept
+		{
+			unsigned long long v = 0;
+			for (unsigned i = 0; i < bytes; ++i)
+				v |= static_cast<unsigned long long>(
+					static_cast<unsigned char>(in[i])) << (8 * i);
+			return v;
+		}
 
 		/**
-			\brief Stores the hours state of counter.
+			\brief Appends the decimal of v to [first, last).
 
-			value < 24.\n\n
+			<h3>Return</h3>
+			The end of the written characters, nullptr if it does not fit.\n
 		*/
-		std::atomic<unsigned> hours;
+		static inline char* put_number(
+			char* first /**< : <i>in</i> : The start of the buffer.*/,
+			char* last /**< : <i>in</i> : The end of the buffer.*/,
+			unsigned long long v /**< : <i>in</i> : The value.*/
+		) noexcept
+		{
+			if (!first)
+				return nullptr;
+			auto res = std::to_chars(first, last, v);
+			return (res.ec == std::errc()) ? res.ptr : nullptr;
+		}
 
 		/**
-			\brief Stores the days state of counter.
+			\brief Appends the literal text to [first, last).
+
+			<h3>Return</h3>
+			The end of the written characters, nullptr if it does not fit.\n
 		*/
-		std::atomic<unsigned long long> days;
+		template<std::size_t N>
+		static inline char* put_text(
+			char* first /**< : <i>in</i> : The start of the buffer.*/,
+			char* last /**< : <i>in</i> : The end of the buffer.*/,
+			const char(&text)[N] /**< : <i>in</i> : The text.*/
+		) noexcept
+		{
+			if (!first || static_cast<std::size_t>(last - first) < N - 1)
+				return nullptr;
+			std::memcpy(first, text, N - 1);
+			return first + N - 1;
+		}
 
 	public:
 
@@ -88,31 +166,20 @@ namespace enh
 		/**
 			\brief The constructor of the class sets all to 0.
 		*/
-		inline counter() noexcept : seconds(0), minutes(0), hours(0), days(0)
+		inline counter() noexcept : total(0)
 		{}
 
 		/**
 			\brief default copy constructor.
 		*/
-		inline counter(const counter& c) noexcept
-		{
-			seconds = c.seconds.load();
-			minutes = c.minutes.load();
-			hours = c.hours.load();
-			days = c.days.load();
-
-		}
+		inline counter(const counter& c) noexcept : total(c.total.load())
+		{}
 
 		/**
 			\brief default move constructor.
 		*/
-		inline counter(counter&& c) noexcept
-		{
-			seconds = c.seconds.load();
-			minutes = c.minutes.load();
-			hours = c.hours.load();
-			days = c.days.load();
-		}
+		inline counter(counter&& c) noexcept : total(c.total.load())
+		{}
 
 		/**
 			\brief constructs using these values.
@@ -125,7 +192,7 @@ namespace enh
 			unsigned min /**< : <i>in</i> : The minutes to be set.*/,
 			unsigned hr /**< : <i>in</i> : The hours to be set.*/,
 			unsigned long long dy /**< : <i>in</i> : The days to be set.*/
-		) noexcept
+		) noexcept : total(0)
 		{
 			set(sec, min, hr, dy);
 		}
@@ -135,10 +202,7 @@ namespace enh
 		*/
 		inline counter& operator = (const counter& c) noexcept
 		{
-			seconds = c.seconds.load();
-			minutes = c.minutes.load();
-			hours = c.hours.load();
-			days = c.days.load();
+			total = c.total.load();
 			return *this;
 		}
 
@@ -147,10 +211,7 @@ namespace enh
 		*/
 		inline counter& operator = (counter&& c) noexcept
 		{
-			seconds = c.seconds.load();
-			minutes = c.minutes.load();
-			hours = c.hours.load();
-			days = c.days.load();
+			total = c.total.load();
 			return *this;
 		}
 
@@ -164,10 +225,7 @@ namespace enh
 		*/
 		inline counter& reset() noexcept
 		{
-			seconds = 0;
-			minutes = 0;
-			hours = 0;
-			days = 0;
+			total = 0;
 			return *this;
 		}
 
@@ -195,13 +253,7 @@ namespace enh
 			unsigned long long sec /**< : <i>in</i> : The seconds to be set.*/
 		) noexcept
 		{
-			reset();
-			seconds = sec;
-			if (sec >= 60)
-			{
-				add_minutes((sec / 60));
-				seconds = sec % 60;
-			}
+			total = sec;
 		}
 
 		/**
@@ -209,17 +261,14 @@ namespace enh
 
 			If sec + seconds is more than 60, value is added to minutes,
 			hours, days	also.\n\n
+
+			One atomic addition, safe with concurrent adds.\n\n
 		*/
 		void add_seconds(
 			unsigned long long sec /**< : <i>in</i> : The seconds to be added.*/
 		) noexcept
 		{
-			if ((sec + seconds.load()) >= 60)
-			{
-				add_minutes((sec + seconds.load()) / 60);
-			}
-
-			seconds = (seconds.load() + sec) % 60;
+			total.fetch_add(sec);
 		}
 
 		/**
@@ -233,14 +282,7 @@ namespace enh
 			unsigned long long min/**< : <i>in</i> : The minutes to be set.*/
 		) noexcept
 		{
-			reset();
-			minutes = min;
-			if (min >= 60)
-			{
-				add_hours((min / 60));
-				minutes = min % 60;
-			}
-
+			total = min * per_minute;
 		}
 
 		/**
@@ -253,10 +295,7 @@ namespace enh
 			unsigned long long min /**< : <i>in</i> : The minutes to be added.*/
 		) noexcept
 		{
-			if ((min + minutes.load()) >= 60)
-				add_hours((min + minutes.load()) / 60);
-
-			minutes = (minutes.load() + min) % 60;
+			total.fetch_add(min * per_minute);
 		}
 
 		/**
@@ -270,13 +309,7 @@ namespace enh
 			unsigned long long hr/**< : <i>in</i> : The hours to be set.*/
 		) noexcept
 		{
-			reset();
-			hours = hr;
-			if (hr >= 24)
-			{
-				add_days((hr / 24));
-				hours = hr % 24;
-			}
+			total = hr * per_hour;
 		}
 
 		/**
@@ -289,10 +322,7 @@ namespace enh
 			unsigned long long hr/**< : <i>in</i> : The hours to be added.*/
 		) noexcept
 		{
-			if ((hr + hours.load()) >= 24)
-				add_days((hr + hours.load()) / 24);
-
-			hours = ((hours.load() + hr) % 24);
+			total.fetch_add(hr * per_hour);
 		}
 
 		/**
@@ -302,8 +332,7 @@ namespace enh
 			unsigned long long dy/**< : <i>in</i> : The days to be set.*/
 		) noexcept
 		{
-			reset();
-			days = dy;
+			total = dy * per_day;
 		}
 
 		/**
@@ -314,7 +343,7 @@ namespace enh
 			unsigned long long dy/**< : <i>in</i> : The days to be added.*/
 		) noexcept
 		{
-			days += dy;
+			total.fetch_add(dy * per_day);
 		}
 
 		/**
@@ -324,7 +353,8 @@ namespace enh
 			The number of seconds.\n
 
 		*/
-		inline unsigned get_seconds() const noexcept { return seconds.load();}
+		inline unsigned get_seconds() const noexcept 
+		{ return static_cast<unsigned>(total.load() % per_minute); }
 
 		/**
 			\brief Returns the minutes part of the state.
@@ -333,7 +363,8 @@ namespace enh
 			The number of minutes.\n
 
 		*/
-		inline unsigned get_minutes() const noexcept { return minutes.load();}
+		inline unsigned get_minutes() const noexcept 
+		{ return static_cast<unsigned>(total.load() / per_minute % 60); }
 
 		/**
 			\brief Returns the hours part of the state.
@@ -342,7 +373,8 @@ namespace enh
 			The number of hours.\n
 
 		*/
-		inline unsigned get_hours() const noexcept { return hours.load();}
+		inline unsigned get_hours() const noexcept 
+		{ return static_cast<unsigned>(total.load() / per_hour % 24); }
 
 		/**
 			\brief Returns the days part of the state.
@@ -353,7 +385,17 @@ namespace enh
 
 		*/
 		inline unsigned long long get_days() const noexcept
-		{ return days.load(); }
+		{ return total.load() / per_day; }
+
+		/**
+			\brief Returns the whole state in seconds.
+
+			<h3>Return</h3>
+			The total seconds.\n
+
+		*/
+		inline unsigned long long get_total_seconds() const noexcept
+		{ return total.load(); }
 
 		/**
 			\brief Returns the total hours elapsed.
@@ -364,11 +406,7 @@ namespace enh
 		*/
 		unsigned long long get_total_hours() const noexcept
 		{
-			unsigned long long tot = (unsigned long long)hours.load() +
-				(days.load() * 24ULL);
-			if ((minutes >= 45) || ((minutes >= 44) && (seconds >= 45)))
-				tot += 1;
-			return tot;
+			return total_hours_of(total.load());
 		}
 
 
@@ -385,14 +423,12 @@ namespace enh
 			unsigned long long dy /**< : <i>in</i> : The days to be set.*/
 		) noexcept
 		{
-			seconds = sec % 60;
-			minutes = min % 60;
-			hours = hr % 24;
-			days = dy;
+			total = (sec % 60) + (min % 60) * per_minute + (hr % 24) * per_hour 
+				+ dy * per_day;
 		}
 
 		/**
-			\brief Functon adds inputs to the state.
+			\brief Functon adds inputs to the state, as one atomic addition.
 		*/
 		inline void add(
 			unsigned sec /**< : <i>in</i> : The seconds to be added.*/,
@@ -401,10 +437,7 @@ namespace enh
 			unsigned long long dy /**< : <i>in</i> : The days to be added.*/
 		)
 		{
-			add_seconds(sec);
-			add_minutes(min);
-			add_hours(hr);
-			add_days(dy);
+			total.fetch_add(sec + min * per_minute + hr * per_hour + dy * per_day);
 		}
 
 		/**
@@ -415,11 +448,42 @@ namespace enh
 		*/
 		std::string get_string() const
 		{
-			return std::move(std::to_string(get_seconds()) + "s : "
-				+ std::to_string(get_minutes()) + "min : "
-				+ std::to_string(get_hours()) + "hr : "
-				+ std::to_string(get_days()) + "days ; "
-				+ std::to_string(get_total_hours()) + " total hours");
+			char buf[max_string_size];
+			return std::string(buf, format_to(buf, buf + max_string_size));
+		}
+
+		/**
+			\brief The longest string get_string and format_to produce.
+		*/
+		static constexpr std::size_t max_string_size = 80;
+
+		/**
+			\brief Writes the string of get_string to [first, last), without
+			allocating.
+
+			A buffer of max_string_size always fits. Nothing is null
+			terminated.\n\n
+
+			<h3>Return</h3>
+			The end of the written characters, nullptr if it did not fit
+			(the buffer contents are then unspecified).\n
+		*/
+		char* format_to(
+			char* first /**< : <i>out</i> : The start of the buffer.*/,
+			char* last /**< : <i>in</i> : The end of the buffer.*/
+		) const noexcept
+		{
+			unsigned long long tot = total.load();
+			first = put_number(first, last, tot % per_minute);
+			first = put_text(first, last, "s : ");
+			first = put_number(first, last, tot / per_minute % 60);
+			first = put_text(first, last, "min : ");
+			first = put_number(first, last, tot / per_hour % 24);
+			first = put_text(first, last, "hr : ");
+			first = put_number(first, last, tot / per_day);
+			first = put_text(first, last, "days ; ");
+			first = put_number(first, last, total_hours_of(tot));
+			return put_text(first, last, " total hours");
 		}
 
 
@@ -477,13 +541,73 @@ namespace enh
 			if (size != get_raw_size())
 				throw std::invalid_argument("raw stream should be " 
 					+ std::to_string(get_raw_size()) + " bytes long");
-			seconds.store(*reinterpret_cast<const unsigned*>(raw));
+			try_read_raw(raw, size);
+		}
+
+		/**
+			\brief read raw data written by write_raw or get_raw, without
+			throwing.
+
+			<h3>Return</h3>
+			A failure of result_code::INVALID_ARG (state unchanged) if size
+			is not get_raw_size().\n
+		*/
+		result<void> read_raw(
+			const char* raw /**< : <i>in</i> : The raw data stream.*/,
+			std::size_t size /**< : <i>in</i> : The length of the raw stream.*/,
+			std::nothrow_t /**< : <i>in</i> : std::nothrow.*/
+		) noexcept
+		{
+			if (!try_read_raw(raw, size))
+				return fail(result_code::INVALID_ARG);
+			return {};
+		}
+
+		/**
+			\brief read raw data written by write_raw or get_raw, without
+			throwing.
+
+			<h3>Return</h3>
+			false (state unchanged) if size is not get_raw_size().\n
+		*/
+		bool try_read_raw(
+			const char* raw /**< : <i>in</i> : The raw data stream.*/,
+			std::size_t size /**< : <i>in</i> : The length of the raw stream.*/
+		) noexcept
+		{
+			if (size != get_raw_size())
+				return false;
+			auto sec = get_le(raw, get_seconds_size());
 			raw = &raw[get_seconds_size()];
-			minutes.store(*reinterpret_cast<const unsigned*>(raw));
+			auto min = get_le(raw, get_minutes_size());
 			raw = &raw[get_minutes_size()];
-			hours.store(*reinterpret_cast<const unsigned*>(raw));
+			auto hr = get_le(raw, get_hours_size());
 			raw = &raw[get_hours_size()];
-			days.store(*reinterpret_cast<const unsigned*>(raw));
+			auto dy = get_le(raw, get_days_size());
+			set(static_cast<unsigned>(sec), static_cast<unsigned>(min),
+				static_cast<unsigned>(hr), dy);
+			return true;
+		}
+
+		/**
+			\brief Writes the raw data stream to out, without allocating.
+
+			The layout is little endian seconds (4 bytes), minutes (4),
+			hours (4) and days (8), on every platform.\n\n
+		*/
+		void write_raw(
+			char* out /**< : <i>out</i> : The buffer, at least get_raw_size()
+					  bytes.*/
+		) const noexcept
+		{
+			unsigned long long tot = total.load();
+			put_le(out, tot % per_minute, get_seconds_size());
+			out = &out[get_seconds_size()];
+			put_le(out, tot / per_minute % 60, get_minutes_size());
+			out = &out[get_minutes_size()];
+			put_le(out, tot / per_hour % 24, get_hours_size());
+			out = &out[get_hours_size()];
+			put_le(out, tot / per_day, get_days_size());
 		}
 
 		/**
@@ -491,16 +615,9 @@ namespace enh
 		*/
 		std::string get_raw() const
 		{
-			auto sec = get_seconds();
-			auto min = get_minutes();
-			auto hr = get_hours();
-			auto dy = get_days();
-			return std::move(
-				std::string(reinterpret_cast<char*>(&sec), sizeof(sec))
-				+ std::string(reinterpret_cast<char*>(&min), sizeof(min))
-				+ std::string(reinterpret_cast<char*>(&hr), sizeof(hr))
-				+ std::string(reinterpret_cast<char*>(&dy), sizeof(dy))
-			);
+			char buf[get_raw_size()];
+			write_raw(buf);
+			return std::string(buf, get_raw_size());
 		}
 
 
@@ -516,23 +633,7 @@ namespace enh
 			counter a /**< : <i>in</i> : The argument to check against.*/
 			)  const noexcept
 		{
-			if (days.load() < a.get_days())
-				return true;
-			if (days.load() > a.get_days())
-				return false;
-			if (hours.load() < a.get_hours())
-				return true;
-			if (hours.load() > a.get_hours())
-				return false;
-			if (minutes.load() < a.get_minutes())
-				return true;
-			if (minutes.load() > a.get_minutes())
-				return false;
-			if (seconds.load() < a.get_seconds())
-				return true;
-			if (seconds.load() > a.get_seconds())
-				return false;
-			return false;
+			return total.load() < a.get_total_seconds();
 		}
 
 		/**
@@ -547,23 +648,7 @@ namespace enh
 			counter a /**< : <i>in</i> : The argument to check against.*/
 			)  const noexcept
 		{
-			if (days.load() > a.get_days())
-				return true;
-			if (days.load() < a.get_days())
-				return false;
-			if (hours.load() > a.get_hours())
-				return true;
-			if (hours.load() < a.get_hours())
-				return false;
-			if (minutes.load() > a.get_minutes())
-				return true;
-			if (minutes.load() < a.get_minutes())
-				return false;
-			if (seconds.load() > a.get_seconds())
-				return true;
-			if (seconds.load() < a.get_seconds())
-				return false;
-			return false;
+			return total.load() > a.get_total_seconds();
 		}
 
 		/**
@@ -576,12 +661,7 @@ namespace enh
 			counter a /**< : <i>in</i> : The argument to check against.*/
 			)  const noexcept
 		{
-			if (days.load() == a.get_days())
-				if (hours.load() == a.get_hours())
-					if (minutes.load() == a.get_minutes())
-						if (seconds.load() == a.get_seconds())
-							return true;
-			return false;
+			return total.load() == a.get_total_seconds();
 		}
 		
 
@@ -597,23 +677,7 @@ namespace enh
 			counter a /**< : <i>in</i> : The argument to check against.*/
 			)  const noexcept
 		{
-			if (days.load() < a.get_days())
-				return true;
-			if (days.load() > a.get_days())
-				return false;
-			if (hours.load() < a.get_hours())
-				return true;
-			if (hours.load() > a.get_hours())
-				return false;
-			if (minutes.load() < a.get_minutes())
-				return true;
-			if (minutes.load() > a.get_minutes())
-				return false;
-			if (seconds.load() < a.get_seconds())
-				return true;
-			if (seconds.load() > a.get_seconds())
-				return false;
-			return true;
+			return total.load() <= a.get_total_seconds();
 		}
 		
 
@@ -629,23 +693,7 @@ namespace enh
 			counter a /**< : <i>in</i> : The argument to check against.*/
 			)  const noexcept
 		{
-			if (days.load() > a.get_days())
-				return true;
-			if (days.load() < a.get_days())
-				return false;
-			if (hours.load() > a.get_hours())
-				return true;
-			if (hours.load() < a.get_hours())
-				return false;
-			if (minutes.load() > a.get_minutes())
-				return true;
-			if (minutes.load() < a.get_minutes())
-				return false;
-			if (seconds.load() > a.get_seconds())
-				return true;
-			if (seconds.load() < a.get_seconds())
-				return false;
-			return true;
+			return total.load() >= a.get_total_seconds();
 		}
 
 	};
@@ -0,0 +1,316 @@
+/** ***************************************************************************
+	\file counter_array.enh.h
+
+	\brief The file to declare class counter_array
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef COUNTER_ARRAY_ENH_H
+
+#define COUNTER_ARRAY_ENH_H				counter_array.enh.h
+
+#include "counter.enh.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <numeric>
+#include <vector>
+
+namespace enh
+{
+
+	/**
+		\brief The container for large sets of counters, stored as one
+		contiguous array of total seconds (8 bytes a counter).
+
+		The bulk operations are plain loops over that array, which the
+		compiler vectorises, and comparisons are of one integer. Elements
+		are read and written as enh::counter values.\n\n
+
+		Unlike enh::counter the container is not thread safe, guard it or
+		use it from one thread.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class counter_array
+	{
+		/**
+			\brief The total seconds of each counter.
+		*/
+		std::vector<unsigned long long> totals;
+
+	public:
+
+		/**
+			\brief Constructs count counters set to 0.
+		*/
+		inline explicit counter_array(
+			std::size_t count = 0 /**< : <i>in</i> : The number of counters.*/
+		) : totals(count, 0ULL)
+		{}
+
+		/**
+			\brief The number of counters.
+		*/
+		inline std::size_t size() const noexcept { return totals.size(); }
+
+		/**
+			\brief true if there are no counters.
+		*/
+		inline bool empty() const noexcept { return totals.empty(); }
+
+		/**
+			\brief Changes the number of counters, new ones are 0.
+		*/
+		inline void resize(
+			std::size_t count /**< : <i>in</i> : The number of counters.*/
+		)
+		{
+			totals.resize(count, 0ULL);
+		}
+
+		/**
+			\brief Reserves storage for count counters.
+		*/
+		inline void reserve(
+			std::size_t count /**< : <i>in</i> : The number of counters.*/
+		)
+		{
+			totals.reserve(count);
+		}
+
+		/**
+			\brief Removes all counters.
+		*/
+		inline void clear() noexcept { totals.clear(); }
+
+		/**
+			\brief Appends a counter holding the state of c.
+		*/
+		inline void push_back(
+			const counter& c /**< : <i>in</i> : The counter.*/
+		)
+		{
+			totals.push_back(c.get_total_seconds());
+		}
+
+		/**
+			\brief Returns counter index as an enh::counter.
+		*/
+		inline counter operator [] (
+			std::size_t index /**< : <i>in</i> : The index.*/
+		) const noexcept
+		{
+			counter c;
+			c.set_seconds(totals[index]);
+			return c;
+		}
+
+		/**
+			\brief Sets counter index to the state of c.
+		*/
+		inline void set(
+			std::size_t index /**< : <i>in</i> : The index.*/,
+			const counter& c /**< : <i>in</i> : The counter.*/
+		) noexcept
+		{
+			totals[index] = c.get_total_seconds();
+		}
+
+		/**
+			\brief The total seconds of counter index.
+		*/
+		inline unsigned long long get_total_seconds(
+			std::size_t index /**< : <i>in</i> : The index.*/
+		) const noexcept
+		{
+			return totals[index];
+		}
+
+		/**
+			\brief Adds sec seconds to counter index.
+		*/
+		inline void add_seconds(
+			std::size_t index /**< : <i>in</i> : The index.*/,
+			unsigned long long sec /**< : <i>in</i> : The seconds to be added.*/
+		) noexcept
+		{
+			totals[index] += sec;
+		}
+
+		/**
+			\brief Adds sec seconds to every counter.
+		*/
+		inline void add_all(
+			unsigned long long sec /**< : <i>in</i> : The seconds to be added.*/
+		) noexcept
+		{
+			unsigned long long* p = totals.data();
+			std::size_t n = totals.size();
+			for (std::size_t i = 0; i < n; ++i)
+				p[i] += sec;
+		}
+
+		/**
+			\brief Adds secs[i] seconds to counter i, for every counter.
+		*/
+		inline void add_each(
+			const unsigned long long* secs /**< : <i>in</i> : The seconds, one
+										   for each counter.*/
+		) noexcept
+		{
+			unsigned long long* p = totals.data();
+			std::size_t n = totals.size();
+			for (std::size_t i = 0; i < n; ++i)
+				p[i] += secs[i];
+		}
+
+		/**
+			\brief Adds counter i of other to counter i, for the counters
+			both have.
+		*/
+		inline void add_each(
+			const counter_array& other /**< : <i>in</i> : The counters to be
+									   added.*/
+		) noexcept
+		{
+			unsigned long long* p = totals.data();
+			const unsigned long long* q = other.totals.data();
+			std::size_t n = std::min(totals.size(), other.totals.size());
+			for (std::size_t i = 0; i < n; ++i)
+				p[i] += q[i];
+		}
+
+		/**
+			\brief Resets every counter to 0.
+		*/
+		inline void reset_all() noexcept
+		{
+			std::fill(totals.begin(), totals.end(), 0ULL);
+		}
+
+		/**
+			\brief The index of the lowest counter, the first if tied.
+
+			<h3>Return</h3>
+			size() if empty.\n
+		*/
+		inline std::size_t min_index() const noexcept
+		{
+			return static_cast<std::size_t>(
+				std::min_element(totals.begin(), totals.end()) - totals.begin());
+		}
+
+		/**
+			\brief The index of the highest counter, the first if tied.
+
+			<h3>Return</h3>
+			size() if empty.\n
+		*/
+		inline std::size_t max_index() const noexcept
+		{
+			return static_cast<std::size_t>(
+				std::max_element(totals.begin(), totals.end()) - totals.begin());
+		}
+
+		/**
+			\brief The lowest counter, 0 if empty.
+		*/
+		inline counter min() const noexcept
+		{
+			counter c;
+			if (!totals.empty())
+				c.set_seconds(get_total_seconds(min_index()));
+			return c;
+		}
+
+		/**
+			\brief The highest counter, 0 if empty.
+		*/
+		inline counter max() const noexcept
+		{
+			counter c;
+			if (!totals.empty())
+				c.set_seconds(get_total_seconds(max_index()));
+			return c;
+		}
+
+		/**
+			\brief The sum of all counters.
+		*/
+		inline counter sum() const noexcept
+		{
+			counter c;
+			c.set_seconds(std::accumulate(totals.begin(), totals.end(), 0ULL));
+			return c;
+		}
+
+		/**
+			\brief Sorts the counters in ascending order.
+		*/
+		inline void sort()
+		{
+			std::sort(totals.begin(), totals.end());
+		}
+
+		/**
+			\brief The indices of the k highest counters, highest first.
+
+			<h3>Return</h3>
+			min(k, size()) indices.\n
+		*/
+		inline std::vector<std::size_t> top_k(
+			std::size_t k /**< : <i>in</i> : The number of counters.*/
+		) const
+		{
+			k = std::min(k, totals.size());
+			std::vector<std::size_t> idx(totals.size());
+			std::iota(idx.begin(), idx.end(), std::size_t(0));
+			auto higher = [this](std::size_t a, std::size_t b)
+			{
+				return (totals[a] != totals[b]) ? (totals[a] > totals[b]) : (a < b);
+			};
+			std::partial_sort(idx.begin(), idx.begin() + k, idx.end(), higher);
+			idx.resize(k);
+			return idx;
+		}
+
+		/**
+			\brief The total seconds of the counters, contiguous.
+		*/
+		inline const unsigned long long* data() const noexcept
+		{
+			return totals.data();
+		}
+
+		/**
+			\brief The total seconds of the counters, contiguous, for bulk
+			writes.
+		*/
+		inline unsigned long long* data() noexcept
+		{
+			return totals.data();
+		}
+	};
+}
+
+#endif
@@ -30,7 +30,10 @@
 
 #include "general.enh.h"
 #include "numeral_system.enh.h"
+#include "timezone.enh.h"
 #include <string_view>
+#include <cstdint>
+#include <type_traits>
 #include <ctime>
 #include <exception>
 #include <stdexcept>
@@ -40,9 +43,12 @@
 namespace enh
 {
 	/**
-			\brief wrapper over unsafe localtime function.
+			\brief Thread safe localtime, converting through
+			time_zone::local().
 
-			The Microsoft version localtime_s is called. Please Edit if not working.
+			The zone rules are loaded once and the offset is looked up in
+			the cached transition table, libc and its timezone lock are not
+			used.
 		*/
 	inline void localtime(
 		tm *str_tm /**< : <i>in</i> : The pointer to tm structure to 
@@ -51,65 +57,39 @@ namespace enh
 				   assign time values.*/
 	)
 	{
-		localtime_s(str_tm, arith_tm);
+		bool isDst = false;
+		std::int64_t utc = static_cast<std::int64_t>(*arith_tm);
+		std::int64_t loc = utc + time_zone::local().offsetAt(utc, &isDst);
+		std::int64_t days = loc / 86400;
+		std::int64_t secs = loc % 86400;
+		if (secs < 0)
+		{
+			secs += 86400;
+			--days;
+		}
+		civil_date cd = civil_from_days(days);
+		str_tm->tm_sec = static_cast<int>(secs % 60);
+		str_tm->tm_min = static_cast<int>((secs / 60) % 60);
+		str_tm->tm_hour = static_cast<int>(secs / 3600);
+		str_tm->tm_mday = cd.day;
+		str_tm->tm_mon = cd.month;
+		str_tm->tm_year = static_cast<int>(cd.year - 1900);
+		str_tm->tm_wday = static_cast<int>(weekday_from_days(days));
+		str_tm->tm_yday = days_before_month(cd.month, cd.year) + cd.day - 1;
+		str_tm->tm_isdst = isDst ? 1 : 0;
 	}
 
 	/**
-			\brief The maximum date for that month.
+			\brief The maximum date for that month, from the month_days table.
 	*/
 	inline constexpr unsigned short month_limit(
 		unsigned short mnth /**< : <i>in</i> : The month count.*/,
 		long long yr /**< : <i>in</i> : The year count.*/
 	) noexcept
 	{
-		switch (mnth)
-		{
-
-		case 0:
-			return 31;
-
-		case 1:
-		{
-			if ((yr % 4) == 0)
-				return 29;
-			else
-				return 28;
-		}
-
-		case 2:
-			return 31;
-
-		case 3:
-			return 30;
-
-		case 4:
-			return 31;
-
-		case 5:
-			return 30;
-
-		case 6:
-			return 31;
-
-		case 7:
-			return 31;
-
-		case 8:
-			return 30;
-
-		case 9:
-			return 31;
-
-		case 10:
-			return 30;
-
-		case 11:
-			return 31;
-
-		default:
+		if (mnth > 11)
 			return 165;
-			break;
-		}
+		return month_days.length[is_leap_year(yr) ? 1 : 0][mnth];
 	}
 
 	/**
@@ -119,7 +99,7 @@ namespace enh
 		long long yr /**< : <i>in</i> : The year count.*/
 	) noexcept
 	{
-		if (yr % 4 == 0)
+		if (is_leap_year(yr))
 			return 366;
 		else
 			return 365;
@@ -156,6 +136,59 @@ namespace enh
 		*/
 		using weekday_t = NumericSystem<unsigned short, 7>;
 
+		/**
+			\brief The limit getter of the last day of a month, for day_t.
+		*/
+		struct month_end
+		{
+			/**
+				\brief The month.
+			*/
+			const month_t* mnth;
+
+			/**
+				\brief The year.
+			*/
+			const long long* yr;
+
+			constexpr inline unsigned short operator () () const noexcept
+			{
+				return month_limit(mnth->get(), *yr);
+			}
+		};
+
+		/**
+			\brief The limit getter of the last year day of a year, for 
+			yearday_t.
+		*/
+		struct year_end
+		{
+			/**
+				\brief The year.
+			*/
+			const long long* yr;
+
+			constexpr inline unsigned short operator () () const noexcept
+			{
+				return static_cast<unsigned short>(year_limit(*yr) - 1);
+			}
+		};
+
+		/**
+			\brief The confined_base of day_t, the limits are called directly.
+		*/
+		using day_base = confined_base<unsigned short, 
+			confined_at_most<month_end>, confined_at_least<confined_constant<1>>,
+			month_end, confined_constant<1>>;
+
+		/**
+			\brief The confined_base of yearday_t, the limits are called
+			directly.
+		*/
+		using yearday_base = confined_base<unsigned short,
+			confined_at_most<year_end>, confined_at_least<confined_constant<0>>,
+			year_end, confined_constant<0>>;
+
 		/**
 			\brief Neumerical type that is confined to interval 
 			[1,month_limit].
@@ -165,7 +198,7 @@ namespace enh
 			upper limit for date.
 
 		*/
-		class day_t : public confined_base<unsigned short>
+		class day_t : public day_base
 		{
 			
 		public:
@@ -180,23 +213,11 @@ namespace enh
 				const month_t &mnth /**< : <i>in</i> : The value of month.*/,
 				const long long &yr /**< : <i>in</i> : The value of year.*/,
 				unsigned short dy /**< : <i>in</i> : The value of day.*/
-			) : confined_base(
-					[&mnth, &yr](long long a) 
-					{
-						return (a <= month_limit(mnth.get(), yr));
-					},
-					[](long long a)
-					{
-						return (a >= 1);
-					},
-					[&mnth, &yr]()
-					{
-						return month_limit(mnth.get(), yr);
-					},
-					[]()
-					{
-						return 1;
-					},
+			) : day_base(
+					{ month_end{ &mnth, &yr } },
+					{},
+					month_end{ &mnth, &yr },
+					{},
 					dy)
 			{}
 		};
@@ -211,7 +232,7 @@ namespace enh
 			upper limit for date.
 
 		*/
-		class yearday_t : public confined_base<unsigned short>
+		class yearday_t : public yearday_base
 		{
 
 		public:
@@ -226,23 +247,11 @@ namespace enh
 				const long long &yr /**< : <i>in</i> : The value of year.*/,
 				unsigned short yrdy /**< : <i>in</i> : The value of year 
 									day.*/
-			) : confined_base(
-				[&yr](long long a)
-				{
-					return (a < year_limit(yr));
-				},
-				[](long long a)
-				{
-					return (a >= 0);
-				},
-					[&yr]()
-				{
-					return year_limit(yr) - 1;
-				},
-					[]()
-				{
-					return 0;
-				},
+			) : yearday_base(
+					{ year_end{ &yr } },
+					{},
+					year_end{ &yr },
+					{},
 					yrdy)
 			{}
 		};
@@ -253,9 +262,26 @@ namespace enh
 	{
 		long long year; 
 		dt_type::month_t month;
-		dt_type::day_t day;
+		unsigned short day;
 		dt_type::weekday_t wkday;
-		dt_type::yearday_t yrday;
+		unsigned short yrday;
+
+		/*
+			The day of the month and of the year, checked against month and 
+			year. Held as plain values rather than day_t and yearday_t, whose
+			limits point into the object, so that a date is a literal value
+			that can be copied and returned in constant expressions.
+		*/
+		constexpr inline void setDays(
+			unsigned short dy,
+			unsigned ydy
+		)
+		{
+			if (dy < 1 || dy > month_limit(month.get(), year) || ydy >= year_limit(year))
+				throw std::invalid_argument("value not within limits");
+			day = dy;
+			yrday = static_cast<unsigned short>(ydy);
+		}
 
 	public:
 
@@ -281,9 +307,8 @@ namespace enh
 		{
 			year = yr;
 			month.set(mnth);
-			day.set(dy);			
 			wkday.set(week);
-			yrday.set(ydy);
+			setDays(dy, ydy);
 		}
 
 		/**
@@ -326,8 +351,10 @@ namespace enh
 								Sunday [0,6].*/,
 			unsigned ydy /**< : <i>in</i> : The number of day after 01 January
 						 of that year [1,year_limit).*/
-		) : year(yr), month(mnth), day(month, year, dy), wkday(week),
-			yrday(year, ydy) {}
+		) : year(yr), month(mnth), day(1), wkday(week), yrday(0)
+		{
+			setDays(dy, ydy);
+		}
 
 		/**
 			\brief Sets the date to the date indicated by argument.
@@ -335,8 +362,7 @@ namespace enh
 		inline date(
 			time_t timeStamp /**< : <i>in</i> : The time stamp which
 							 contains the date.*/
-		) : year(2020), month(0), day(month, year, 1), wkday(0),
-			yrday(year, 0)
+		) : year(2020), month(0), day(1), wkday(0), yrday(0)
 		{
 			setDate(timeStamp);
 		}
@@ -344,8 +370,7 @@ namespace enh
 		/**
 			\brief Sets the date to the date current date.
 		*/
-		inline date() : year(2020), month(0), day(month, year, 1), wkday(0),
-			yrday(year, 0)
+		inline date() : year(2020), month(0), day(1), wkday(0), yrday(0)
 		{
 			setDate();
 		}
@@ -355,7 +380,7 @@ namespace enh
 		*/
 		constexpr inline unsigned short getDayOfMonth() const noexcept 
 		{
-			return day.get(); 
+			return day; 
 		}
 
 		/**
@@ -371,22 +396,7 @@ namespace enh
 		*/
 		constexpr inline std::string_view getMonthString() const noexcept
 		{
-			switch (month.get())
-			{
-			case 0: return "January";
-			case 1: return "February";
-			case 2: return "March";
-			case 3: return "April";
-			case 4: return "May";
-			case 5: return "June";
-			case 6: return "July";
-			case 7: return "August";
-			case 8: return "September";
-			case 9: return "October";
-			case 10: return "November";
-			case 11: return "December";
-			default: return "Error";
-			}
+			return (month.get() < 12) ? month_names[month.get()] : "Error";
 		}
 
 		/**
@@ -394,22 +404,7 @@ namespace enh
 		*/
 		constexpr inline std::string_view getShortMonthString() const noexcept
 		{
-			switch (month.get())
-			{
-			case 0: return "Jan";
-			case 1: return "Feb";
-			case 2: return "Mar";
-			case 3: return "Apr";
-			case 4: return "May";
-			case 5: return "Jun";
-			case 6: return "Jul";
-			case 7: return "Aug";
-			case 8: return "Sep";
-			case 9: return "Oct";
-			case 10: return "Nov";
-			case 11: return "Dec";
-			default: return "Error";
-			}
+			return (month.get() < 12) ? short_month_names[month.get()] : "Error";
 		}
 
 		/**
@@ -431,7 +426,7 @@ namespace enh
 		*/
 		constexpr inline unsigned getDayOfYear() const noexcept 
 		{ 
-			return yrday.get();
+			return yrday;
 		}
 
 		/**
@@ -439,17 +434,15 @@ namespace enh
 		*/
 		inline std::string getDayOfWeekString() const
 		{
-			switch (wkday.get())
-			{
-			case 0: return "Sunday";
-			case 1: return "Monday";
-			case 2: return "Tuesday";
-			case 3: return "Wednesday";
-			case 4: return "Thursday";
-			case 5: return "Friday";
-			case 6: return "Saturday";
-			default: return "Error";
-			}
+			return std::string(getDayOfWeekView());
+		}
+
+		/**
+			\brief The name of the day, without allocating.
+		*/
+		constexpr inline std::string_view getDayOfWeekView() const noexcept
+		{
+			return (wkday.get() < 7) ? weekday_names[wkday.get()] : "Error";
 		}
 
 		/**
@@ -457,17 +450,7 @@ namespace enh
 		*/
 		constexpr inline std::string_view getShortDayOfWeekString() const
 		{
-			switch (wkday.get())
-			{
-			case 0: return "Sun";
-			case 1: return "Mon";
-			case 2: return "Tue";
-			case 3: return "Wed";
-			case 4: return "Thu";
-			case 5: return "Fri";
-			case 6: return "Sat";
-			default: return "Error";
-			}
+			return (wkday.get() < 7) ? short_weekday_names[wkday.get()] : "Error";
 		}
 
 		/**
@@ -480,9 +463,77 @@ namespace enh
 		*/
 		inline std::string getStringDate() const
 		{
-			return getDayOfWeekString() + ", " + std::to_string(day.get()) 
-				+ getOrdinalIndicator(day.get()).data() + " " 
-				+ getMonthString().data() + " " + std::to_string(year);
+			char buf[max_string_size];
+			return std::string(buf, format_to(buf, buf + max_string_size));
+		}
+
+		/**
+			\brief The string of getStringDate() allocated by alloc, so it can be 
+			released with an arena.
+		*/
+		template<class Alloc, std::enable_if_t<is_allocator_v<Alloc>, int> = 0>
+		inline alloc_string<Alloc> getStringDate(
+			const Alloc& alloc /**< : <i>in</i> : The allocator of the string.*/
+		) const
+		{
+			char buf[max_string_size];
+			return alloc_string<Alloc>(buf, format_to(buf, buf + max_string_size),
+				typename alloc_string<Alloc>::allocator_type(alloc));
+		}
+
+		/**
+			\brief The longest string of getStringDate and format_to.
+		*/
+		static constexpr std::size_t max_string_size = 56;
+
+		/**
+			\brief Writes the string of getStringDate() to [first, last), 
+			without allocating. Nothing is null terminated.
+
+			<h3>Return</h3>
+			The end of the written characters, nullptr if it did not fit.\n
+		*/
+		inline char* format_to(
+			char* first /**< : <i>out</i> : The start of the buffer.*/,
+			char* last /**< : <i>in</i> : The end of the buffer.*/
+		) const noexcept
+		{
+			first = appendText(first, last, getDayOfWeekView());
+			first = appendText(first, last, ", ");
+			first = appendValue(first, last, day);
+			first = appendText(first, last, getOrdinalIndicator(day));
+			first = appendText(first, last, " ");
+			first = appendText(first, last, getMonthString());
+			first = appendText(first, last, " ");
+			return appendValue(first, last, year);
+		}
+
+		/**
+			\brief Writes the date as ISO-8601 YYYY-MM-DD to [first, last),
+			without allocating.
+
+			<h3>Return</h3>
+			The end of the written characters, nullptr if it did not fit.\n
+		*/
+		inline char* format_iso_to(
+			char* first /**< : <i>out</i> : The start of the buffer.*/,
+			char* last /**< : <i>in</i> : The end of the buffer.*/
+		) const noexcept
+		{
+			if (first && (last - first >= 10) && (year >= 0) && (year <= 9999))
+			{
+				writeDigits4(first, static_cast<unsigned>(year));
+				first[4] = '-';
+				writeDigits2(first + 5, month.get() + 1U);
+				first[7] = '-';
+				writeDigits2(first + 8, day);
+				return first + 10;
+			}
+			first = appendValue(first, last, year, 4);
+			first = appendText(first, last, "-");
+			first = appendValue(first, last, month.get() + 1, 2);
+			first = appendText(first, last, "-");
+			return appendValue(first, last, day, 2);
 		}
 
 		/**
@@ -518,13 +569,13 @@ namespace enh
 
 			pddth = format.find("ddth");
 			if (pddth != std::string::npos)
-				format.replace(pddth, 4, signExtendValue(day.get(), 2) +
-					getOrdinalIndicator(day.get()).data());
+				format.replace(pddth, 4, signExtendValue(day, 2) +
+					getOrdinalIndicator(day).data());
 			else
 			{
 				pdd = format.find("dd");
 				if (pdd != std::string::npos)
-					format.replace(pdd, 2, signExtendValue(day.get(), 2));
+					format.replace(pdd, 2, signExtendValue(day, 2));
 			}
 
 			pshMonth = format.find("shMonth");
@@ -665,59 +716,47 @@ namespace enh
 		}
 
 		/**
-			\brief Add number of days to the current date.
+			\brief The number of days from 01 January 1970, negative before.
+		*/
+		constexpr inline long long getDaysSinceEpoch() const noexcept
+		{
+			return days_from_civil(year, month.get(), day);
+		}
+
+		/**
+			\brief Sets the date days from 01 January 1970, in constant time.
+		*/
+		constexpr inline void setDaysSinceEpoch(
+			long long days /**< : <i>in</i> : The days from 01 January 1970.*/
+		) noexcept
+		{
+			civil_date c = civil_from_days(days);
+			year = c.year;
+			month.set(c.month);
+			day = c.day;
+			wkday.set(weekday_from_days(days));
+			yrday = static_cast<unsigned short>(days_before_month(c.month, c.year) + c.day - 1);
+		}
+
+		/**
+			\brief Add number of days to the current date, in constant time.
 		*/
 		constexpr inline void addDay(
 			unsigned long long dy /**< : <i>in</i> : The days to add.*/
 		) noexcept
 		{
-			wkday.add(dy);
-			unsigned long long additional = dy % (365 + 365 + 365 + 366);
-			unsigned long long yr_add = 4 * (dy / (365 + 365 + 365 + 366));
-			year += yr_add;
-
-			auto current_step = month_limit(month.get(), year) - 1;
-			while (additional > current_step)
-			{
-				auto yr = month.add(day.add(current_step));
-				yrday.add(current_step);
-				year += yr;
-
-				additional -= current_step;
-				current_step = month_limit(month.get(), year) - 1;
-			}
-			
-			auto yr = month.add(day.add(additional));		
-			yrday.add(current_step);
-			year += yr;
+			setDaysSinceEpoch(getDaysSinceEpoch() + static_cast<long long>(dy));
 		}
 
 		/**
-			\brief subtract number of days to the current date.
+			\brief subtract number of days to the current date, in constant 
+			time.
 		*/
 		constexpr inline void subDay(
 			unsigned long long dy /**< : <i>in</i> : The days to subtract.*/
 		) noexcept
 		{
-			wkday.sub(dy);
-			unsigned long long difference = dy % (365 + 365 + 365 + 366);
-			unsigned long long yr_sub = 4 * (dy / (365 + 365 + 365 + 366));
-			year -= yr_sub;
-
-			auto current_step = month_limit(month.get(), year) - 1;
-			while (difference > current_step)
-			{
-				auto yr = month.sub(day.sub(current_step));
-				yrday.sub(current_step);
-				year -= yr;
-
-				difference -= current_step;
-				current_step = month_limit(month.get(), year) - 1;
-			}
-
-			auto yr = month.sub(day.sub(difference));
-			yrday.sub(current_step);
-			year -= yr;
+			setDaysSinceEpoch(getDaysSinceEpoch() - static_cast<long long>(dy));
 		}
 
 
@@ -801,6 +840,228 @@ namespace enh
 	{
 		return lhs.isLesserThanEq(rhs);
 	}
+
+	/**
+		\brief The date as 4 bytes, days from 01 January 1970.
+
+		Trivially copyable, so arrays of it can be written with memcpy, and
+		comparisons are one integer comparison. Converts to and from 
+		enh::date in constant time.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class packed_date
+	{
+		/**
+			\brief The days from 01 January 1970.
+		*/
+		std::int32_t days;
+
+	public:
+
+		/**
+			\brief Constructs 01 January 1970.
+		*/
+		constexpr inline packed_date() noexcept : days(0) {}
+
+		/**
+			\brief Constructs the date dy days from 01 January 1970.
+		*/
+		constexpr inline explicit packed_date(
+			std::int32_t dy /**< : <i>in</i> : The days from 01 January 1970.*/
+		) noexcept : days(dy) {}
+
+		/**
+			\brief Constructs from the year, month and day of dt.
+		*/
+		constexpr inline packed_date(
+			const date& dt /**< : <i>in</i> : The date.*/
+		) noexcept : days(static_cast<std::int32_t>(days_from_civil(dt.getYear(),
+			dt.getMonth(), dt.getDayOfMonth())))
+		{}
+
+		/**
+			\brief Constructs from year, month [0,11] and day of month.
+		*/
+		static constexpr inline packed_date fromCivil(
+			long long yr /**< : <i>in</i> : The year.*/,
+			unsigned short mnth /**< : <i>in</i> : The month [0,11].*/,
+			unsigned short dy /**< : <i>in</i> : The day of month [1,31].*/
+		) noexcept
+		{
+			return packed_date(static_cast<std::int32_t>(days_from_civil(yr, mnth, dy)));
+		}
+
+		/**
+			\brief The days from 01 January 1970.
+		*/
+		constexpr inline std::int32_t getDays() const noexcept { return days; }
+
+		/**
+			\brief The year, month and day.
+		*/
+		constexpr inline civil_date getCivil() const noexcept
+		{
+			return civil_from_days(days);
+		}
+
+		/**
+			\brief The number of days after last Sunday.
+		*/
+		constexpr inline unsigned short getDayOfWeek() const noexcept
+		{
+			return weekday_from_days(days);
+		}
+
+		/**
+			\brief Converts to enh::date.
+		*/
+		constexpr inline date toDate() const
+		{
+			civil_date c = civil_from_days(days);
+			return date(c.day, c.month, static_cast<long>(c.year), 
+				weekday_from_days(days), 
+				static_cast<unsigned>(days_before_month(c.month, c.year) + c.day - 1));
+		}
+
+		/**
+			\brief Adds dy days.
+		*/
+		constexpr inline packed_date& operator += (
+			std::int32_t dy /**< : <i>in</i> : The days.*/
+		) noexcept
+		{
+			days += dy;
+			return *this;
+		}
+
+		/**
+			\brief Subtracts dy days.
+		*/
+		constexpr inline packed_date& operator -= (
+			std::int32_t dy /**< : <i>in</i> : The days.*/
+		) noexcept
+		{
+			days -= dy;
+			return *this;
+		}
+
+		/**
+			\brief The days from rhs to lhs.
+		*/
+		friend constexpr inline std::int32_t operator - (
+			packed_date lhs /**< : <i>in</i> : The left hand side.*/,
+			packed_date rhs /**< : <i>in</i> : The right hand side.*/
+		) noexcept
+		{
+			return lhs.days - rhs.days;
+		}
+
+		friend constexpr inline bool operator == (packed_date lhs, packed_date rhs) noexcept
+		{ return lhs.days == rhs.days; }
+
+		friend constexpr inline bool operator != (packed_date lhs, packed_date rhs) noexcept
+		{ return lhs.days != rhs.days; }
+
+		friend constexpr inline bool operator < (packed_date lhs, packed_date rhs) noexcept
+		{ return lhs.days < rhs.days; }
+
+		friend constexpr inline bool operator <= (packed_date lhs, packed_date rhs) noexcept
+		{ return lhs.days <= rhs.days; }
+
+		friend constexpr inline bool operator > (packed_date lhs, packed_date rhs) noexcept
+		{ return lhs.days > rhs.days; }
+
+		friend constexpr inline bool operator >= (packed_date lhs, packed_date rhs) noexcept
+		{ return lhs.days >= rhs.days; }
+	};
+
+	static_assert(sizeof(packed_date) == 4 
+		&& std::is_trivially_copyable_v<packed_date>, "packed_date must be 4 plain bytes");
+
+	/**
+		\brief A year, from the literal 2020_y, to be followed by / month / 
+		day.
+	*/
+	struct civil_year
+	{
+		/**
+			\brief The year.
+		*/
+		long long year;
+	};
+
+	/**
+		\brief A year and month [0,11], from 2020_y / 4, to be followed by / 
+		day.
+	*/
+	struct civil_year_month
+	{
+		/**
+			\brief The year.
+		*/
+		long long year;
+
+		/**
+			\brief The number of months after January [0,11].
+		*/
+		unsigned short month;
+	};
+
+	/**
+		\brief The month mnth [1,12] (1 is January, as written in dates) of
+		yr.
+
+		<h3>Exception</h3>
+		Throws <code>std::invalid_argument</code> if mnth is not in [1,12],
+		which in a constant expression fails to compile.
+	*/
+	constexpr inline civil_year_month operator / (
+		civil_year yr /**< : <i>in</i> : The year.*/,
+		unsigned mnth /**< : <i>in</i> : The month [1,12].*/
+	)
+	{
+		if (mnth < 1 || mnth > 12)
+			throw std::invalid_argument("month not in [1,12]");
+		return { yr.year, static_cast<unsigned short>(mnth - 1) };
+	}
+
+	/**
+		\brief The date of day dy of the year and month ym.
+
+		<h3>Exception</h3>
+		Throws <code>std::invalid_argument</code> if dy is not in 
+		[1,month_limit], which in a constant expression fails to compile.
+	*/
+	constexpr inline packed_date operator / (
+		civil_year_month ym /**< : <i>in</i> : The year and month.*/,
+		unsigned dy /**< : <i>in</i> : The day of the month [1,month_limit].*/
+	)
+	{
+		if (dy < 1 || dy > month_limit(ym.month, ym.year))
+			throw std::invalid_argument("day not in [1,month_limit]");
+		return packed_date::fromCivil(ym.year, ym.month, static_cast<unsigned short>(dy));
+	}
+
+	/**
+		\brief The user defined literals of enh, brought in by 
+		<code>using namespace enh::literals;</code>.
+	*/
+	inline namespace literals
+	{
+		/**
+			\brief The year yr, 2020_y / 4 / 26 is the packed_date of 26 April
+			2020, checked while compiling where it is a constant expression.
+			Use packed_date::toDate or DateTime::fromDate for the full 
+			classes.
+		*/
+		constexpr inline civil_year operator "" _y(
+			unsigned long long yr /**< : <i>in</i> : The year.*/
+		) noexcept
+		{
+			return { static_cast<long long>(yr) };
+		}
+	}
 }
 
 
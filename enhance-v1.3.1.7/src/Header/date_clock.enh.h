@@ -0,0 +1,271 @@
+/** ***************************************************************************
+	\file date_clock.enh.h
+
+	\brief The file to declare class date_clock, the cached current date and
+	time
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef DATE_CLOCK_ENH_H
+
+#define DATE_CLOCK_ENH_H					date_clock.enh.h
+
+#include "date_time.enh.h"
+#include "timer.enh.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+
+namespace enh
+{
+
+	/**
+		\brief The process wide current local date and time, kept by a
+		callback_timer of the shared timer_service once a second.
+
+		Each tick advances the held DateTime with addSeconds, a full
+		conversion is done only at the start, at day rollover, on a change
+		of the zone offset or when the clock jumps. Readers copy the fields
+		under a seqlock, never blocking the service thread and never making
+		a system call.\n\n
+
+		Call start first, until then (and after stop) now falls back to
+		DateTime(). The time read is at most a second (plus scheduling delay
+		of the service thread) behind.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class date_clock
+	{
+		/**
+			\brief Even when the snapshot is stable, odd while written.
+		*/
+		static inline std::atomic<unsigned> sequence{ 0 };
+
+		/**
+			\brief The year of the snapshot.
+		*/
+		static inline std::atomic<long long> year{ 0 };
+
+		/**
+			\brief The other fields of the snapshot packed, see pack, 0 when
+			not started.
+		*/
+		static inline std::atomic<std::uint64_t> fields{ 0 };
+
+		/**
+			\brief The state of the service thread.
+		*/
+		struct writer_state
+		{
+			DateTime current = DateTime(1, 0, 1970, 4, 0, 0, 0, 0);
+			std::time_t last = 0;
+			std::int32_t offset = 0;
+		};
+
+		static writer_state& writer()
+		{
+			static writer_state state;
+			return state;
+		}
+
+		/**
+			\brief The timer advancing the snapshot.
+		*/
+		static callback_timer& updater()
+		{
+			static callback_timer tick;
+			return tick;
+		}
+
+		static inline std::mutex control;
+
+		/**
+			\brief Packs day, month, weekday, yearday, second, minute and
+			hour, with bit 63 set to mark it valid.
+		*/
+		static constexpr inline std::uint64_t pack(const DateTime& dt) noexcept
+		{
+			return static_cast<std::uint64_t>(dt.getDayOfMonth())
+				| (static_cast<std::uint64_t>(dt.getMonth()) << 8)
+				| (static_cast<std::uint64_t>(dt.getDayOfWeek()) << 12)
+				| (static_cast<std::uint64_t>(dt.getDayOfYear()) << 16)
+				| (static_cast<std::uint64_t>(dt.getSeconds()) << 32)
+				| (static_cast<std::uint64_t>(dt.getMinutes()) << 40)
+				| (static_cast<std::uint64_t>(dt.getHours()) << 48)
+				| (1ULL << 63);
+		}
+
+		/**
+			\brief Publishes dt, called with control held or on the service
+			thread only.
+		*/
+		static inline void publish(const DateTime& dt) noexcept
+		{
+			unsigned seq = sequence.load(std::memory_order_relaxed);
+			sequence.store(seq + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			year.store(dt.getYear(), std::memory_order_relaxed);
+			fields.store(pack(dt), std::memory_order_relaxed);
+			sequence.store(seq + 2, std::memory_order_release);
+		}
+
+		/**
+			\brief Converts t in full, then publishes.
+		*/
+		static inline void refresh(std::time_t t)
+		{
+			writer_state& w = writer();
+			w.current.set(t);
+			w.last = t;
+			w.offset = time_zone::local().offsetAt(static_cast<std::int64_t>(t));
+			publish(w.current);
+		}
+
+		/**
+			\brief The tick, advances the held time by the seconds elapsed.
+		*/
+		static inline void advance()
+		{
+			writer_state& w = writer();
+			std::time_t t = std::time(nullptr);
+			std::time_t elapsed = t - w.last;
+			if (elapsed == 0)
+				return;
+			if (elapsed < 0 || elapsed > 60
+				|| time_zone::local().offsetAt(static_cast<std::int64_t>(t)) != w.offset)
+			{
+				refresh(t);
+				return;
+			}
+			long long day = w.current.getDaysSinceEpoch();
+			w.current.addSeconds(static_cast<unsigned long long>(elapsed));
+			if (w.current.getDaysSinceEpoch() != day)
+			{
+				refresh(t);
+				return;
+			}
+			w.last = t;
+			publish(w.current);
+		}
+
+	public:
+
+		/**
+			\brief Starts (or restarts) keeping the current date and time.
+		*/
+		static void start()
+		{
+			std::lock_guard<std::mutex> guard(control);
+			updater().cancel();
+			refresh(std::time(nullptr));
+			updater().start_every(std::chrono::seconds(1), []() { advance(); });
+		}
+
+		/**
+			\brief Stops keeping the time, now falls back to DateTime().
+		*/
+		static void stop()
+		{
+			std::lock_guard<std::mutex> guard(control);
+			updater().cancel();
+			unsigned seq = sequence.load(std::memory_order_relaxed);
+			sequence.store(seq + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			fields.store(0, std::memory_order_relaxed);
+			sequence.store(seq + 2, std::memory_order_release);
+		}
+
+		/**
+			\brief Checks if the time is being kept.
+		*/
+		static inline bool isRunning() noexcept
+		{
+			return fields.load(std::memory_order_relaxed) != 0;
+		}
+
+		/**
+			\brief Sets out to the cached date and time.
+
+			<h3>Return</h3>
+			false (out unchanged) if not started.\n
+		*/
+		static inline bool now(
+			DateTime& out /**< : <i>out</i> : The date and time.*/
+		) noexcept
+		{
+			unsigned before, after;
+			long long yr;
+			std::uint64_t f;
+			do
+			{
+				before = sequence.load(std::memory_order_acquire);
+				yr = year.load(std::memory_order_relaxed);
+				f = fields.load(std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_acquire);
+				after = sequence.load(std::memory_order_relaxed);
+			} while ((before & 1U) != 0 || before != after);
+			if (f == 0)
+				return false;
+			out.set(static_cast<unsigned short>(f & 0xFF),
+				static_cast<unsigned short>((f >> 8) & 0xF),
+				static_cast<long>(yr),
+				static_cast<unsigned short>((f >> 12) & 0xF),
+				static_cast<unsigned short>((f >> 16) & 0xFFFF),
+				static_cast<unsigned short>((f >> 32) & 0xFF),
+				static_cast<unsigned short>((f >> 40) & 0xFF),
+				static_cast<unsigned short>((f >> 48) & 0xFF));
+			return true;
+		}
+
+		/**
+			\brief The cached date and time, DateTime() if not started.
+		*/
+		static inline DateTime now()
+		{
+			DateTime dt(1, 0, 1970, 4, 0, 0, 0, 0);
+			if (!now(dt))
+				dt.set();
+			return dt;
+		}
+
+		/**
+			\brief The cached date, date() if not started.
+		*/
+		static inline date today()
+		{
+			return now();
+		}
+
+		/**
+			\brief The cached time, time_stamp() if not started.
+		*/
+		static inline time_stamp timeNow()
+		{
+			return now();
+		}
+	};
+}
+
+#endif
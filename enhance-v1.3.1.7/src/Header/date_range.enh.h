@@ -0,0 +1,372 @@
+/** ***************************************************************************
+	\file date_range.enh.h
+
+	\brief The file to declare class date_range for lazy calendar iteration
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef DATE_RANGE_ENH_H
+
+#define DATE_RANGE_ENH_H				date_range.enh.h
+
+#include "date.enh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+namespace enh
+{
+
+	/**
+		\brief The start of the week of d, weeks starting on weekStart.
+	*/
+	constexpr inline packed_date floorToWeek(
+		packed_date d /**< : <i>in</i> : The date.*/,
+		unsigned short weekStart = 1 /**< : <i>in</i> : The first day of the
+									 week after Sunday [0,6], Monday by
+									 default.*/
+	) noexcept
+	{
+		return packed_date(d.getDays() - (d.getDayOfWeek() + 7 - weekStart) % 7);
+	}
+
+	/**
+		\brief The first day of the month of d.
+	*/
+	constexpr inline packed_date floorToMonth(
+		packed_date d /**< : <i>in</i> : The date.*/
+	) noexcept
+	{
+		return packed_date(d.getDays() - d.getCivil().day + 1);
+	}
+
+	/**
+		\brief The first day of the year of d.
+	*/
+	constexpr inline packed_date floorToYear(
+		packed_date d /**< : <i>in</i> : The date.*/
+	) noexcept
+	{
+		return packed_date::fromCivil(d.getCivil().year, 0, 1);
+	}
+
+	/**
+		\brief The months from January 1970 to the month of d, negative
+		before it, for indexing monthly buckets.
+	*/
+	constexpr inline long long monthsSinceEpoch(
+		packed_date d /**< : <i>in</i> : The date.*/
+	) noexcept
+	{
+		civil_date c = d.getCivil();
+		return (c.year - 1970) * 12 + c.month;
+	}
+
+	/**
+		\brief The class for a lazy range of dates at a fixed step of days or
+		of months, such as every day, every Monday or every month start
+		between two dates.
+
+		Nothing is stored but the first element, the step and the count,
+		element i is computed arithmetically on packed_date, so a range of
+		any length costs the same to make. The iterators are random access,
+		so the ranges work with range-for and the parallel algorithms.
+		Ranges are half open, to is not included.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class date_range
+	{
+	public:
+
+		/**
+			\brief The unit of the step.
+		*/
+		enum class unit : unsigned char
+		{
+			day,
+			month
+		};
+
+		/**
+			\brief The random access iterator of date_range, dereferencing
+			to a packed_date value.
+		*/
+		class iterator
+		{
+			long long base = 0;
+			long long step = 1;
+			std::ptrdiff_t index = 0;
+			unit by = unit::day;
+
+			friend class date_range;
+
+			constexpr inline iterator(long long b, long long s, std::ptrdiff_t i,
+				unit u) noexcept : base(b), step(s), index(i), by(u) {}
+
+		public:
+
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type = packed_date;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = packed_date;
+
+			constexpr inline iterator() noexcept = default;
+
+			constexpr inline packed_date operator * () const noexcept
+			{
+				return (*this)[0];
+			}
+
+			constexpr inline packed_date operator [] (difference_type n) const noexcept
+			{
+				long long at = base + (index + n) * step;
+				if (by == unit::day)
+					return packed_date(static_cast<std::int32_t>(at));
+				long long yr = (at >= 0) ? at / 12 : -((-at + 11) / 12);
+				return packed_date::fromCivil(yr, static_cast<unsigned short>(at - yr * 12), 1);
+			}
+
+			constexpr inline iterator& operator ++ () noexcept { ++index; return *this; }
+			constexpr inline iterator& operator -- () noexcept { --index; return *this; }
+
+			constexpr inline iterator operator ++ (int) noexcept
+			{
+				iterator it = *this;
+				++index;
+				return it;
+			}
+
+			constexpr inline iterator operator -- (int) noexcept
+			{
+				iterator it = *this;
+				--index;
+				return it;
+			}
+
+			constexpr inline iterator& operator += (difference_type n) noexcept
+			{
+				index += n;
+				return *this;
+			}
+
+			constexpr inline iterator& operator -= (difference_type n) noexcept
+			{
+				index -= n;
+				return *this;
+			}
+
+			friend constexpr inline iterator operator + (iterator it, difference_type n) noexcept
+			{
+				return it += n;
+			}
+
+			friend constexpr inline iterator operator + (difference_type n, iterator it) noexcept
+			{
+				return it += n;
+			}
+
+			friend constexpr inline iterator operator - (iterator it, difference_type n) noexcept
+			{
+				return it -= n;
+			}
+
+			friend constexpr inline difference_type operator - (const iterator& lhs,
+				const iterator& rhs) noexcept
+			{
+				return lhs.index - rhs.index;
+			}
+
+			friend constexpr inline bool operator == (const iterator& lhs,
+				const iterator& rhs) noexcept { return lhs.index == rhs.index; }
+			friend constexpr inline bool operator != (const iterator& lhs,
+				const iterator& rhs) noexcept { return lhs.index != rhs.index; }
+			friend constexpr inline bool operator < (const iterator& lhs,
+				const iterator& rhs) noexcept { return lhs.index < rhs.index; }
+			friend constexpr inline bool operator <= (const iterator& lhs,
+				const iterator& rhs) noexcept { return lhs.index <= rhs.index; }
+			friend constexpr inline bool operator > (const iterator& lhs,
+				const iterator& rhs) noexcept { return lhs.index > rhs.index; }
+			friend constexpr inline bool operator >= (const iterator& lhs,
+				const iterator& rhs) noexcept { return lhs.index >= rhs.index; }
+		};
+
+		using const_iterator = iterator;
+		using value_type = packed_date;
+		using size_type = std::size_t;
+
+	private:
+
+		/**
+			\brief The days from the epoch (unit::day) or the months from
+			year 0 (unit::month) of the first element.
+		*/
+		long long first = 0;
+
+		/**
+			\brief The step in unit.
+		*/
+		long long step = 1;
+
+		/**
+			\brief The number of elements.
+		*/
+		std::ptrdiff_t count = 0;
+
+		/**
+			\brief The unit of first and step.
+		*/
+		unit by = unit::day;
+
+		constexpr inline date_range(long long f, long long s, std::ptrdiff_t n,
+			unit u) noexcept : first(f), step(s), count(n > 0 ? n : 0), by(u) {}
+
+		/**
+			\brief The months from year 0 of the month of d.
+		*/
+		static constexpr inline long long month_of(packed_date d) noexcept
+		{
+			civil_date c = d.getCivil();
+			return c.year * 12 + c.month;
+		}
+
+	public:
+
+		/**
+			\brief An empty range.
+		*/
+		constexpr inline date_range() noexcept = default;
+
+		/**
+			\brief Every stepDays days from from, before to.
+		*/
+		static constexpr inline date_range days(
+			packed_date from /**< : <i>in</i> : The first date.*/,
+			packed_date to /**< : <i>in</i> : The end, not included.*/,
+			unsigned stepDays = 1 /**< : <i>in</i> : The step, 0 is taken as
+								  1.*/
+		) noexcept
+		{
+			long long s = stepDays ? stepDays : 1;
+			long long span = static_cast<long long>(to.getDays()) - from.getDays();
+			return date_range(from.getDays(), s,
+				static_cast<std::ptrdiff_t>(span > 0 ? (span + s - 1) / s : 0), unit::day);
+		}
+
+		/**
+			\brief Every weekday (after Sunday [0,6]) from from, before to.
+		*/
+		static constexpr inline date_range weekdays(
+			packed_date from /**< : <i>in</i> : The first date.*/,
+			packed_date to /**< : <i>in</i> : The end, not included.*/,
+			unsigned short weekday /**< : <i>in</i> : The day of the week
+								   after Sunday [0,6].*/
+		) noexcept
+		{
+			packed_date start(from.getDays() + (weekday + 7 - from.getDayOfWeek()) % 7);
+			return days(start, (to < start) ? start : to, 7);
+		}
+
+		/**
+			\brief The start of every stepMonths months, from the first at
+			or after from, before to.
+		*/
+		static constexpr inline date_range monthStarts(
+			packed_date from /**< : <i>in</i> : The first date.*/,
+			packed_date to /**< : <i>in</i> : The end, not included.*/,
+			unsigned stepMonths = 1 /**< : <i>in</i> : The step, 0 is taken as
+									1.*/
+		) noexcept
+		{
+			long long s = stepMonths ? stepMonths : 1;
+			long long m0 = month_of(from) + ((from.getCivil().day == 1) ? 0 : 1);
+			if (!(from < to))
+				return date_range(m0, s, 0, unit::month);
+			long long last = month_of(packed_date(to.getDays() - 1));
+			return date_range(m0, s,
+				static_cast<std::ptrdiff_t>((last >= m0) ? (last - m0) / s + 1 : 0),
+				unit::month);
+		}
+
+		/**
+			\brief Every 01 January from from, before to.
+		*/
+		static constexpr inline date_range yearStarts(
+			packed_date from /**< : <i>in</i> : The first date.*/,
+			packed_date to /**< : <i>in</i> : The end, not included.*/
+		) noexcept
+		{
+			civil_date c = from.getCivil();
+			long long yr = c.year + ((c.month == 0 && c.day == 1) ? 0 : 1);
+			return monthStarts(packed_date::fromCivil(yr, 0, 1), to, 12);
+		}
+
+		/**
+			\brief The number of dates.
+		*/
+		constexpr inline size_type size() const noexcept
+		{
+			return static_cast<size_type>(count);
+		}
+
+		/**
+			\brief Checks if there are no dates.
+		*/
+		constexpr inline bool empty() const noexcept { return count == 0; }
+
+		constexpr inline iterator begin() const noexcept
+		{
+			return iterator(first, step, 0, by);
+		}
+
+		constexpr inline iterator end() const noexcept
+		{
+			return iterator(first, step, count, by);
+		}
+
+		/**
+			\brief The date i, not checked.
+		*/
+		constexpr inline packed_date operator [] (
+			size_type i /**< : <i>in</i> : The index.*/
+		) const noexcept
+		{
+			return begin()[static_cast<std::ptrdiff_t>(i)];
+		}
+
+		/**
+			\brief The first date, range must not be empty.
+		*/
+		constexpr inline packed_date front() const noexcept { return (*this)[0]; }
+
+		/**
+			\brief The last date, range must not be empty.
+		*/
+		constexpr inline packed_date back() const noexcept
+		{
+			return (*this)[size() - 1];
+		}
+	};
+}
+
+#endif
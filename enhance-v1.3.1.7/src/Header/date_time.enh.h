@@ -30,8 +30,173 @@
 
 #include "time_stamp.enh.h"
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
 namespace enh
 {
+	/**
+		\brief A time point read by parse_iso8601.
+	*/
+	struct iso8601_time
+	{
+		/**
+			\brief The days from 01 January 1970 of the date as written.
+		*/
+		long long days = 0;
+
+		/**
+			\brief The seconds after midnight as written [0,86400), a leap 
+			second 60 is read as 59.
+		*/
+		unsigned seconds = 0;
+
+		/**
+			\brief The fraction of the second in nanoseconds.
+		*/
+		unsigned nanos = 0;
+
+		/**
+			\brief The offset from UTC in minutes, 0 for Z.
+		*/
+		int offset = 0;
+
+		/**
+			\brief true if a Z or numeric offset was given.
+		*/
+		bool hasOffset = false;
+
+		/**
+			\brief The seconds from the unix epoch (UTC), applying offset.
+		*/
+		constexpr inline long long epochSeconds() const noexcept
+		{
+			return days * 86400LL + seconds - offset * 60LL;
+		}
+	};
+
+	/**
+		\brief The value of count decimal digits at text, -1 if any is not a
+		digit.
+	*/
+	inline constexpr int iso8601_digits(
+		const char* text /**< : <i>in</i> : The digits.*/,
+		int count /**< : <i>in</i> : The number of digits.*/
+	) noexcept
+	{
+		int v = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			unsigned d = static_cast<unsigned char>(text[i]) - static_cast<unsigned>('0');
+			if (d > 9)
+				return -1;
+			v = v * 10 + static_cast<int>(d);
+		}
+		return v;
+	}
+
+	/**
+		\brief Reads an ISO-8601 / RFC-3339 date or date time, without 
+		allocating or throwing.
+
+		Accepts YYYY-MM-DD, optionally followed by 'T', 't' or ' ' and 
+		hh:mm, hh:mm:ss or hh:mm:ss.fraction (any number of digits, read to
+		nanoseconds), then optionally 'Z', 'z', +hh:mm, +hhmm or +hh (or -).
+		The fields are at fixed positions, so there is no scanning.
+
+		<h3>Return</h3>
+		false if text is not such a time or a field is out of range (month,
+		day of the month, hour, minute, second, offset).\n
+	*/
+	inline constexpr bool parse_iso8601(
+		std::string_view text /**< : <i>in</i> : The text.*/,
+		iso8601_time& out /**< : <i>out</i> : The time read.*/
+	) noexcept
+	{
+		const char* p = text.data();
+		std::size_t n = text.size();
+		if (n < 10 || p[4] != '-' || p[7] != '-')
+			return false;
+		int yr = iso8601_digits(p, 4);
+		int mo = iso8601_digits(p + 5, 2);
+		int dy = iso8601_digits(p + 8, 2);
+		if (yr < 0 || mo < 1 || mo > 12 || dy < 1
+			|| dy > month_limit(static_cast<unsigned short>(mo - 1), yr))
+			return false;
+		iso8601_time res;
+		res.days = days_from_civil(yr, static_cast<unsigned short>(mo - 1),
+			static_cast<unsigned short>(dy));
+		std::size_t i = 10;
+		if (i < n)
+		{
+			if ((p[i] != 'T' && p[i] != 't' && p[i] != ' ') || n < i + 6 || p[i + 3] != ':')
+				return false;
+			int hr = iso8601_digits(p + i + 1, 2);
+			int mi = iso8601_digits(p + i + 4, 2);
+			int sc = 0;
+			i += 6;
+			if (i < n && p[i] == ':')
+			{
+				if (n < i + 3)
+					return false;
+				sc = iso8601_digits(p + i + 1, 2);
+				i += 3;
+			}
+			if (hr < 0 || hr > 23 || mi < 0 || mi > 59 || sc < 0 || sc > 60)
+				return false;
+			res.seconds = static_cast<unsigned>(hr * 3600 + mi * 60 + ((sc == 60) ? 59 : sc));
+			if (i < n && (p[i] == '.' || p[i] == ','))
+			{
+				std::size_t start = ++i;
+				unsigned scale = 100000000U;
+				while (i < n && static_cast<unsigned>(static_cast<unsigned char>(p[i]) - '0') <= 9)
+				{
+					res.nanos += static_cast<unsigned>(p[i] - '0') * scale;
+					scale /= 10;
+					++i;
+				}
+				if (i == start)
+					return false;
+			}
+			if (i < n)
+			{
+				if (p[i] == 'Z' || p[i] == 'z')
+				{
+					res.hasOffset = true;
+					++i;
+				}
+				else if (p[i] == '+' || p[i] == '-')
+				{
+					int sign = (p[i] == '-') ? -1 : 1;
+					int oh = -1, om = 0;
+					if (n - i == 3)
+						oh = iso8601_digits(p + i + 1, 2);
+					else if (n - i == 5)
+					{
+						oh = iso8601_digits(p + i + 1, 2);
+						om = iso8601_digits(p + i + 3, 2);
+					}
+					else if (n - i == 6 && p[i + 3] == ':')
+					{
+						oh = iso8601_digits(p + i + 1, 2);
+						om = iso8601_digits(p + i + 4, 2);
+					}
+					if (oh < 0 || oh > 23 || om < 0 || om > 59)
+						return false;
+					res.offset = sign * (oh * 60 + om);
+					res.hasOffset = true;
+					i = n;
+				}
+			}
+		}
+		if (i != n)
+			return false;
+		out = res;
+		return true;
+	}
+
 	/**
 		\brief Class for date and time joint manipulation.
 
@@ -60,11 +225,13 @@ namespace enh
 						 of that year [1,year_limit).*/,
 			unsigned short sec /**< : <i>in</i> : The seconds field [0,60].*/,
 			unsigned short min /**< : <i>in</i> : The minutes field [0,59].*/,
-			unsigned short hr /**< : <i>in</i> : The hours field [0,59].*/
+			unsigned short hr /**< : <i>in</i> : The hours field [0,59].*/,
+			std::uint32_t ns = 0 /**< : <i>in</i> : The fraction of second in
+								 nanoseconds [0,1e9).*/
 		)
 		{
 			setDate(dy, mnth, yr, week, ydy);
-			setTime(sec, min, hr);
+			setTime(sec, min, hr, ns);
 		}
 
 		/**
@@ -86,6 +253,24 @@ namespace enh
 					temp.tm_yday, 59, temp.tm_min, temp.tm_hour);
 		}
 
+		/**
+			\brief Sets the time and date to the local time and date of tp, 
+			with the fraction of second.
+		*/
+		template<class Clock, class Duration>
+		inline void set(
+			std::chrono::time_point<Clock, Duration> tp /**< : <i>in</i> : The
+														time point.*/
+		)
+		{
+			long long ns = epochNanosOf(tp);
+			long long frac = ns % nanos_per_second;
+			long long sec = ns / nanos_per_second - ((frac < 0) ? 1 : 0);
+			set(static_cast<time_t>(sec));
+			setNanoseconds(static_cast<std::uint32_t>((frac < 0) ? frac + nanos_per_second
+				: frac));
+		}
+
 		/**
 			\brief Sets the time and date to the current time and date.
 		*/
@@ -94,6 +279,188 @@ namespace enh
 			set(std::time(nullptr));
 		}
 
+		/**
+			\brief Sets the time and date (UTC) sec seconds after the unix 
+			epoch, without localtime.
+		*/
+		constexpr inline void setEpochSeconds(
+			long long sec /**< : <i>in</i> : The seconds from the epoch.*/
+		) noexcept
+		{
+			long long days = (sec >= 0) ? sec / 86400 : -((-sec + 86399) / 86400);
+			setDaysSinceEpoch(days);
+			setNanosecondsOfDay(static_cast<unsigned long long>(sec - days * 86400)
+				* 1000000000ULL);
+		}
+
+		/**
+			\brief Sets the time and date (UTC) ns nanoseconds after the unix
+			epoch.
+		*/
+		constexpr inline void setEpochNanos(
+			long long ns /**< : <i>in</i> : The nanoseconds from the epoch.*/
+		) noexcept
+		{
+			long long frac = ns % 1000000000LL;
+			long long sec = ns / 1000000000LL;
+			if (frac < 0)
+			{
+				frac += 1000000000LL;
+				--sec;
+			}
+			setEpochSeconds(sec);
+			addNanoseconds(static_cast<unsigned long long>(frac));
+		}
+
+		/**
+			\brief Sets the time and date (UTC) ms milliseconds after the unix
+			epoch.
+		*/
+		constexpr inline void setEpochMillis(
+			long long ms /**< : <i>in</i> : The milliseconds from the epoch.*/
+		) noexcept
+		{
+			long long frac = ms % 1000;
+			long long sec = ms / 1000;
+			if (frac < 0)
+			{
+				frac += 1000;
+				--sec;
+			}
+			setEpochSeconds(sec);
+			addNanoseconds(static_cast<unsigned long long>(frac) * 1000000ULL);
+		}
+
+		/**
+			\brief Sets the time and date (UTC) of tp, of any clock.
+		*/
+		template<class Clock, class Duration>
+		inline void setTimePoint(
+			std::chrono::time_point<Clock, Duration> tp /**< : <i>in</i> : The
+														time point.*/
+		)
+		{
+			setEpochNanos(epochNanosOf(tp));
+		}
+
+		/**
+			\brief The seconds after the unix epoch, taking the time held as
+			UTC.
+		*/
+		constexpr inline long long getEpochSeconds() const noexcept
+		{
+			return getDaysSinceEpoch() * 86400LL + getSecondsOfDay();
+		}
+
+		/**
+			\brief The milliseconds after the unix epoch, taking the time held
+			as UTC.
+		*/
+		constexpr inline long long getEpochMillis() const noexcept
+		{
+			return getEpochSeconds() * 1000LL + getMilliseconds();
+		}
+
+		/**
+			\brief The nanoseconds after the unix epoch, taking the time held
+			as UTC.
+		*/
+		constexpr inline long long getEpochNanos() const noexcept
+		{
+			return getEpochSeconds() * 1000000000LL + getNanoseconds();
+		}
+
+		/**
+			\brief The time point of Clock (enh::time_pt by default), taking
+			the time held as UTC.
+		*/
+		template<class Clock = std::chrono::high_resolution_clock>
+		inline typename Clock::time_point getTimePoint() const
+		{
+			return timePointOfEpochNanos<Clock>(getEpochNanos());
+		}
+
+		/**
+			\brief Sets the time and date from ISO-8601 text, see 
+			parse_iso8601.
+
+			If the text has an offset the time held is UTC, else it is the
+			time as written. The fraction of second is kept.
+
+			<h3>Return</h3>
+			false (nothing changed) if the text is not valid.\n
+		*/
+		constexpr inline bool setIso8601(
+			std::string_view text /**< : <i>in</i> : The text.*/
+		) noexcept
+		{
+			iso8601_time t;
+			if (!parse_iso8601(text, t))
+				return false;
+			setEpochSeconds(t.epochSeconds());
+			addNanoseconds(t.nanos);
+			return true;
+		}
+
+		/**
+			\brief Constructs the time and date (UTC) sec seconds after the 
+			unix epoch.
+		*/
+		static constexpr inline DateTime fromEpochSeconds(
+			long long sec /**< : <i>in</i> : The seconds from the epoch.*/
+		) noexcept
+		{
+			DateTime dt(1, 0, 1970, 4, 0, 0, 0, 0);
+			dt.setEpochSeconds(sec);
+			return dt;
+		}
+
+		/**
+			\brief Constructs the time and date (UTC) ms milliseconds after 
+			the unix epoch.
+		*/
+		static constexpr inline DateTime fromEpochMillis(
+			long long ms /**< : <i>in</i> : The milliseconds from the epoch.*/
+		) noexcept
+		{
+			DateTime dt(1, 0, 1970, 4, 0, 0, 0, 0);
+			dt.setEpochMillis(ms);
+			return dt;
+		}
+
+		/**
+			\brief Constructs the time and date of day d at hr:min:sec, for 
+			constants such as DateTime::fromDate(2020_y / 4 / 26, 0, 30, 9).
+		*/
+		static constexpr inline DateTime fromDate(
+			packed_date d /**< : <i>in</i> : The date.*/,
+			unsigned short sec = 0 /**< : <i>in</i> : The seconds field [0,60].*/,
+			unsigned short min = 0 /**< : <i>in</i> : The minutes field [0,59].*/,
+			unsigned short hr = 0 /**< : <i>in</i> : The hours field [0,23].*/,
+			std::uint32_t ns = 0 /**< : <i>in</i> : The fraction of second in
+								 nanoseconds [0,1e9).*/
+		)
+		{
+			civil_date c = d.getCivil();
+			return DateTime(c.day, c.month, static_cast<long>(c.year), d.getDayOfWeek(),
+				static_cast<unsigned short>(days_before_month(c.month, c.year) + c.day - 1),
+				sec, min, hr, ns);
+		}
+
+		/**
+			\brief Constructs the time and date (UTC) of tp, of any clock.
+		*/
+		template<class Clock, class Duration>
+		static inline DateTime fromTimePoint(
+			std::chrono::time_point<Clock, Duration> tp /**< : <i>in</i> : The
+														time point.*/
+		)
+		{
+			DateTime dt(1, 0, 1970, 4, 0, 0, 0, 0);
+			dt.setTimePoint(tp);
+			return dt;
+		}
+
 		/**
 			\brief Sets the time and date to the time and date indicated by
 			argument.
@@ -110,8 +477,10 @@ namespace enh
 						 of that year [1,year_limit).*/,
 			unsigned short sec /**< : <i>in</i> : The seconds field [0,60].*/,
 			unsigned short min /**< : <i>in</i> : The minutes field [0,59].*/,
-			unsigned short hr /**< : <i>in</i> : The hours field [0,59].*/
-		) : date(dy, mnth, yr, week, ydy), time_stamp(sec, min, hr) {}
+			unsigned short hr /**< : <i>in</i> : The hours field [0,59].*/,
+			std::uint32_t ns = 0 /**< : <i>in</i> : The fraction of second in
+								 nanoseconds [0,1e9).*/
+		) : date(dy, mnth, yr, week, ydy), time_stamp(sec, min, hr, ns) {}
 
 		/**
 			\brief Sets the time and date to the time and date indicated by
@@ -144,7 +513,71 @@ namespace enh
 		*/
 		inline std::string getStringDateTime()
 		{
-			return getStringTime() + " ; " + getStringDate();
+			char buf[max_string_size];
+			return std::string(buf, format_to(buf, buf + max_string_size));
+		}
+
+		/**
+			\brief The string of getStringDateTime() allocated by alloc, so it can be 
+			released with an arena.
+		*/
+		template<class Alloc, std::enable_if_t<is_allocator_v<Alloc>, int> = 0>
+		inline alloc_string<Alloc> getStringDateTime(
+			const Alloc& alloc /**< : <i>in</i> : The allocator of the string.*/
+		) const
+		{
+			char buf[max_string_size];
+			return alloc_string<Alloc>(buf, format_to(buf, buf + max_string_size),
+				typename alloc_string<Alloc>::allocator_type(alloc));
+		}
+
+		/**
+			\brief The longest string of getStringDateTime and format_to.
+		*/
+		static constexpr std::size_t max_string_size = time_stamp::max_string_size
+			+ 3 + date::max_string_size;
+
+		/**
+			\brief The length of the string of format_iso_to, for years 0 to
+			9999.
+		*/
+		static constexpr std::size_t iso_string_size = 19;
+
+		/**
+			\brief Writes the string of getStringDateTime() to [first, last),
+			without allocating. Nothing is null terminated.
+
+			<h3>Return</h3>
+			The end of the written characters, nullptr if it did not fit.\n
+		*/
+		inline char* format_to(
+			char* first /**< : <i>out</i> : The start of the buffer.*/,
+			char* last /**< : <i>in</i> : The end of the buffer.*/
+		) const noexcept
+		{
+			first = time_stamp::format_to(first, last);
+			first = appendText(first, last, " ; ");
+			return date::format_to(first, last);
+		}
+
+		/**
+			\brief Writes the date and time as ISO-8601 YYYY-MM-DDThh:mm:ss to
+			[first, last), without allocating, followed by .fraction if 
+			digits is not 0.
+
+			<h3>Return</h3>
+			The end of the written characters, nullptr if it did not fit.\n
+		*/
+		inline char* format_iso_to(
+			char* first /**< : <i>out</i> : The start of the buffer.*/,
+			char* last /**< : <i>in</i> : The end of the buffer.*/,
+			unsigned digits = 0 /**< : <i>in</i> : The digits of the fraction
+								of second [0,9].*/
+		) const noexcept
+		{
+			first = date::format_iso_to(first, last);
+			first = appendText(first, last, "T");
+			return time_stamp::format_iso_to(first, last, digits);
 		}
 
 
@@ -206,6 +639,17 @@ namespace enh
 			addDay(time_stamp::addSeconds(sec));
 		}
 
+		/**
+			\brief Adds to the fraction of second held (also seconds, minutes
+			and hours).
+		*/
+		constexpr inline void addNanoseconds(
+			unsigned long long ns  /**< : <i>in</i> : The nanoseconds to add.*/
+		) noexcept
+		{
+			addDay(time_stamp::addNanoseconds(ns));
+		}
+
 		/**
 			\brief Reduce the hour part of time held.
 		*/
@@ -236,6 +680,17 @@ namespace enh
 			subDay(time_stamp::subSeconds(sec));
 		}
 
+		/**
+			\brief Reduces the fraction of second held (also seconds, minutes
+			and hours).
+		*/
+		constexpr inline void subNanoseconds(
+			unsigned long long ns /**< : <i>in</i> : The nanoseconds to reduce.*/
+		) noexcept
+		{
+			subDay(time_stamp::subNanoseconds(ns));
+		}
+
 		/**
 			\brief Checks if argument is equal to this object.
 
@@ -274,7 +729,8 @@ namespace enh
 			const DateTime &dt /**< : <i>in</i> : The DateTime to compare with.*/
 		) const noexcept
 		{
-			return date::isLesserThan(dt) && time_stamp::isLesserThan(dt);
+			return date::isLesserThan(dt)
+				|| (date::isEqualTo(dt) && time_stamp::isLesserThan(dt));
 		}
 
 		/**
@@ -287,7 +743,8 @@ namespace enh
 			const DateTime &dt /**< : <i>in</i> : The DateTime to compare with.*/
 		) const noexcept
 		{
-			return date::isLesserThanEq(dt) && time_stamp::isLesserThanEq(dt);
+			return date::isLesserThan(dt)
+				|| (date::isEqualTo(dt) && time_stamp::isLesserThanEq(dt));
 		}
 
 		/**
@@ -0,0 +1,519 @@
+/** ***************************************************************************
+	\file datetime_column.enh.h
+
+	\brief The file to declare class datetime_column, columnar storage of
+	DateTime values
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef DATETIME_COLUMN_ENH_H
+
+#define DATETIME_COLUMN_ENH_H			datetime_column.enh.h
+
+#include "date_time.enh.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace enh
+{
+
+	/**
+		\brief The unit a datetime_column is truncated to.
+	*/
+	enum class time_bucket : unsigned char
+	{
+		second,
+		minute,
+		hour,
+		day,
+		week,
+		month,
+		year
+	};
+
+	/**
+		\brief The kernels of datetime_column::filter and count, compiled 
+		again for AVX2 and AVX-512 (64 bit compares), picked by 
+		cpu_dispatch.
+	*/
+	namespace column_kernel
+	{
+		inline std::size_t filter(const long long* p, std::size_t n, long long from,
+			long long to, std::uint8_t* mask) noexcept
+		{
+			std::size_t hits = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				std::uint8_t in = static_cast<std::uint8_t>((p[i] >= from) & (p[i] < to));
+				mask[i] = in;
+				hits += in;
+			}
+			return hits;
+		}
+
+		inline std::size_t count(const long long* p, std::size_t n, long long from,
+			long long to) noexcept
+		{
+			std::size_t hits = 0;
+			for (std::size_t i = 0; i < n; ++i)
+				hits += static_cast<std::size_t>((p[i] >= from) & (p[i] < to));
+			return hits;
+		}
+
+#ifdef ENH_TARGET_X86
+		ENH_TARGET("avx2") inline std::size_t filter_avx2(const long long* p, 
+			std::size_t n, long long from, long long to, std::uint8_t* mask) noexcept
+		{
+			return filter(p, n, from, to, mask);
+		}
+
+		ENH_TARGET("avx512f,avx512bw") inline std::size_t filter_avx512(const long long* p,
+			std::size_t n, long long from, long long to, std::uint8_t* mask) noexcept
+		{
+			return filter(p, n, from, to, mask);
+		}
+
+		ENH_TARGET("avx2") inline std::size_t count_avx2(const long long* p, 
+			std::size_t n, long long from, long long to) noexcept
+		{
+			return count(p, n, from, to);
+		}
+
+		ENH_TARGET("avx512f,avx512bw") inline std::size_t count_avx512(const long long* p,
+			std::size_t n, long long from, long long to) noexcept
+		{
+			return count(p, n, from, to);
+		}
+#endif
+
+		using filter_t = std::size_t(const long long*, std::size_t, long long, long long,
+			std::uint8_t*) noexcept;
+
+		using count_t = std::size_t(const long long*, std::size_t, long long, long long) noexcept;
+
+		inline constexpr cpu_kernel<filter_t> filter_kernels[] = {
+#ifdef ENH_TARGET_X86
+			{ cpu_feature::avx512f | cpu_feature::avx512bw, &filter_avx512 },
+			{ cpu_feature::avx2, &filter_avx2 },
+#endif
+			{ 0, &filter } };
+
+		inline constexpr cpu_kernel<count_t> count_kernels[] = {
+#ifdef ENH_TARGET_X86
+			{ cpu_feature::avx512f | cpu_feature::avx512bw, &count_avx512 },
+			{ cpu_feature::avx2, &count_avx2 },
+#endif
+			{ 0, &count } };
+
+		/**
+			\brief The filter kernel of this processor.
+		*/
+		inline cpu_dispatch<filter_t> filter_best(filter_kernels);
+
+		/**
+			\brief The count kernel of this processor.
+		*/
+		inline cpu_dispatch<count_t> count_best(count_kernels);
+	}
+
+	/**
+		\brief The read only view of a run of datetime_column, without
+		copying the ticks.
+
+		Elements are read as DateTime (made on access) or as nanoseconds.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class datetime_view
+	{
+		const long long* first = nullptr;
+		std::size_t count = 0;
+
+	public:
+
+		/**
+			\brief Views n ticks at p.
+		*/
+		constexpr inline datetime_view(
+			const long long* p /**< : <i>in</i> : The nanoseconds from the
+							   epoch.*/,
+			std::size_t n /**< : <i>in</i> : The number of elements.*/
+		) noexcept : first(p), count(n) {}
+
+		constexpr inline datetime_view() noexcept = default;
+
+		constexpr inline std::size_t size() const noexcept { return count; }
+
+		constexpr inline bool empty() const noexcept { return count == 0; }
+
+		/**
+			\brief The nanoseconds from the epoch of element i.
+		*/
+		constexpr inline long long nanos(
+			std::size_t i /**< : <i>in</i> : The index.*/
+		) const noexcept
+		{
+			return first[i];
+		}
+
+		/**
+			\brief Element i as a DateTime (UTC).
+		*/
+		constexpr inline DateTime operator [] (
+			std::size_t i /**< : <i>in</i> : The index.*/
+		) const noexcept
+		{
+			DateTime dt(1, 0, 1970, 4, 0, 0, 0, 0);
+			dt.setEpochNanos(first[i]);
+			return dt;
+		}
+
+		constexpr inline const long long* data() const noexcept { return first; }
+
+		constexpr inline const long long* begin() const noexcept { return first; }
+
+		constexpr inline const long long* end() const noexcept { return first + count; }
+	};
+
+	/**
+		\brief The class for large sets of DateTime, stored as one
+		contiguous array of nanoseconds from the unix epoch (UTC).
+
+		Comparisons are of one integer, and the bulk operations are plain
+		loops over the array that the compiler vectorises (filter, truncate
+		to second, minute, hour, day and week), filter and count also for 
+		AVX2 and AVX-512 where this processor has them. Sorting is an LSD radix sort
+		of the offsets from the lowest value, so only the digits spanned by
+		the data are sorted.\n\n
+
+		Not thread safe, guard it or use it from one thread.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class datetime_column
+	{
+		/**
+			\brief The nanoseconds from the epoch.
+		*/
+		std::vector<long long> ticks;
+
+		static constexpr long long per_second = 1000000000LL;
+		static constexpr long long per_day = 86400LL * per_second;
+
+		/**
+			\brief The length in nanoseconds of the fixed buckets, 0 for
+			month or year.
+		*/
+		static constexpr inline long long fixed_length(time_bucket b) noexcept
+		{
+			switch (b)
+			{
+			case time_bucket::second: return per_second;
+			case time_bucket::minute: return 60 * per_second;
+			case time_bucket::hour: return 3600 * per_second;
+			case time_bucket::day: return per_day;
+			case time_bucket::week: return 7 * per_day;
+			default: return 0;
+			}
+		}
+
+		/**
+			\brief Sorts keys ascending, moving payload (if not nullptr)
+			with them.
+		*/
+		template<class payload_t>
+		static inline void radix_sort(long long* keys, payload_t* payload, std::size_t n)
+		{
+			if (n < 2)
+				return;
+			constexpr std::uint64_t sign = 1ULL << 63;
+			constexpr unsigned digit = 11;
+			constexpr std::size_t radix = std::size_t(1) << digit;
+			std::vector<std::uint64_t> a(n), b(n);
+			std::vector<payload_t> pa, pb;
+			if (payload)
+			{
+				pa.assign(payload, payload + n);
+				pb.resize(n);
+			}
+			std::uint64_t low = ~0ULL, high = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				std::uint64_t v = static_cast<std::uint64_t>(keys[i]) ^ sign;
+				low = (v < low) ? v : low;
+				high = (v > high) ? v : high;
+			}
+			// Sorting the offsets from the lowest skips the digits of the
+			// common prefix.
+			for (std::size_t i = 0; i < n; ++i)
+				a[i] = (static_cast<std::uint64_t>(keys[i]) ^ sign) - low;
+			std::uint64_t range = high - low;
+			std::vector<std::size_t> bucket(radix + 1);
+			for (unsigned shift = 0; shift < 64 && (range >> shift) != 0; shift += digit)
+			{
+				std::fill(bucket.begin(), bucket.end(), std::size_t(0));
+				for (std::size_t i = 0; i < n; ++i)
+					++bucket[((a[i] >> shift) & (radix - 1)) + 1];
+				for (std::size_t k = 1; k <= radix; ++k)
+					bucket[k] += bucket[k - 1];
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					std::size_t at = bucket[(a[i] >> shift) & (radix - 1)]++;
+					b[at] = a[i];
+					if (payload)
+						pb[at] = pa[i];
+				}
+				a.swap(b);
+				pa.swap(pb);
+			}
+			for (std::size_t i = 0; i < n; ++i)
+				keys[i] = static_cast<long long>((a[i] + low) ^ sign);
+			if (payload)
+				std::memcpy(payload, pa.data(), n * sizeof(payload_t));
+		}
+
+	public:
+
+		/**
+			\brief Constructs an empty column.
+		*/
+		inline datetime_column() = default;
+
+		/**
+			\brief The number of elements.
+		*/
+		inline std::size_t size() const noexcept { return ticks.size(); }
+
+		/**
+			\brief Checks if there are no elements.
+		*/
+		inline bool empty() const noexcept { return ticks.empty(); }
+
+		/**
+			\brief Reserves storage for count elements.
+		*/
+		inline void reserve(
+			std::size_t count /**< : <i>in</i> : The number of elements.*/
+		)
+		{
+			ticks.reserve(count);
+		}
+
+		/**
+			\brief Removes all elements.
+		*/
+		inline void clear() noexcept { ticks.clear(); }
+
+		/**
+			\brief Appends dt, taken as UTC.
+		*/
+		inline void push_back(
+			const DateTime& dt /**< : <i>in</i> : The date and time.*/
+		)
+		{
+			ticks.push_back(dt.getEpochNanos());
+		}
+
+		/**
+			\brief Appends the time ns nanoseconds after the epoch.
+		*/
+		inline void push_back_nanos(
+			long long ns /**< : <i>in</i> : The nanoseconds from the epoch.*/
+		)
+		{
+			ticks.push_back(ns);
+		}
+
+		/**
+			\brief Element i as a DateTime (UTC).
+		*/
+		inline DateTime operator [] (
+			std::size_t i /**< : <i>in</i> : The index.*/
+		) const noexcept
+		{
+			return view()[i];
+		}
+
+		/**
+			\brief The nanoseconds from the epoch of element i.
+		*/
+		inline long long nanos(
+			std::size_t i /**< : <i>in</i> : The index.*/
+		) const noexcept
+		{
+			return ticks[i];
+		}
+
+		/**
+			\brief The nanoseconds from the epoch of the elements,
+			contiguous.
+		*/
+		inline const long long* data() const noexcept { return ticks.data(); }
+
+		/**
+			\brief The nanoseconds from the epoch of the elements, for bulk
+			writes.
+		*/
+		inline long long* data() noexcept { return ticks.data(); }
+
+		/**
+			\brief A view of all elements.
+		*/
+		inline datetime_view view() const noexcept
+		{
+			return datetime_view(ticks.data(), ticks.size());
+		}
+
+		/**
+			\brief A view of count elements from first, clamped to size().
+		*/
+		inline datetime_view view(
+			std::size_t first /**< : <i>in</i> : The first index.*/,
+			std::size_t count /**< : <i>in</i> : The number of elements.*/
+		) const noexcept
+		{
+			if (first > ticks.size())
+				first = ticks.size();
+			if (count > ticks.size() - first)
+				count = ticks.size() - first;
+			return datetime_view(ticks.data() + first, count);
+		}
+
+		/**
+			\brief Sets mask[i] to 1 if element i is in [from, to), else 0,
+			branch free.
+
+			<h3>Return</h3>
+			The number of elements in range.\n
+		*/
+		inline std::size_t filter(
+			long long from /**< : <i>in</i> : The start in nanoseconds from
+						   the epoch.*/,
+			long long to /**< : <i>in</i> : The end, not included.*/,
+			std::uint8_t* mask /**< : <i>out</i> : size() flags.*/
+		) const noexcept
+		{
+			return column_kernel::filter_best(ticks.data(), ticks.size(), from, to, mask);
+		}
+
+		/**
+			\brief The number of elements in [from, to).
+		*/
+		inline std::size_t count(
+			long long from /**< : <i>in</i> : The start in nanoseconds from
+						   the epoch.*/,
+			long long to /**< : <i>in</i> : The end, not included.*/
+		) const noexcept
+		{
+			return column_kernel::count_best(ticks.data(), ticks.size(), from, to);
+		}
+
+		/**
+			\brief The indices of the elements in [from, to), ascending.
+		*/
+		inline std::vector<std::size_t> select(
+			const DateTime& from /**< : <i>in</i> : The start.*/,
+			const DateTime& to /**< : <i>in</i> : The end, not included.*/
+		) const
+		{
+			std::vector<std::uint8_t> mask(ticks.size());
+			std::vector<std::size_t> out;
+			out.reserve(filter(from.getEpochNanos(), to.getEpochNanos(), mask.data()));
+			for (std::size_t i = 0; i < mask.size(); ++i)
+				if (mask[i])
+					out.push_back(i);
+			return out;
+		}
+
+		/**
+			\brief Truncates every element to the start of its bucket, weeks
+			start on Monday.
+		*/
+		inline void truncate(
+			time_bucket b /**< : <i>in</i> : The bucket.*/
+		) noexcept
+		{
+			long long* p = ticks.data();
+			std::size_t n = ticks.size();
+			long long len = fixed_length(b);
+			if (len != 0)
+			{
+				// 01 January 1970 is a Thursday, weeks are aligned to Monday.
+				long long shift = (b == time_bucket::week) ? 3 * per_day : 0;
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					long long v = p[i] + shift;
+					long long q = v / len;
+					q -= static_cast<long long>((v % len) < 0);
+					p[i] = q * len - shift;
+				}
+				return;
+			}
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				long long day = p[i] / per_day - static_cast<long long>((p[i] % per_day) < 0);
+				civil_date c = civil_from_days(day);
+				p[i] = days_from_civil(c.year, (b == time_bucket::month) ? c.month : 0, 1)
+					* per_day;
+			}
+		}
+
+		/**
+			\brief A copy truncated to bucket b, see truncate.
+		*/
+		inline datetime_column truncated(
+			time_bucket b /**< : <i>in</i> : The bucket.*/
+		) const
+		{
+			datetime_column copy(*this);
+			copy.truncate(b);
+			return copy;
+		}
+
+		/**
+			\brief Sorts the elements ascending (radix sort, stable).
+		*/
+		inline void sort()
+		{
+			radix_sort<std::uint32_t>(ticks.data(), nullptr, ticks.size());
+		}
+
+		/**
+			\brief The permutation that sorts the column, the column is not
+			changed.
+		*/
+		inline std::vector<std::size_t> argsort() const
+		{
+			std::vector<long long> keys(ticks);
+			std::vector<std::size_t> idx(ticks.size());
+			for (std::size_t i = 0; i < idx.size(); ++i)
+				idx[i] = i;
+			radix_sort(keys.data(), idx.data(), keys.size());
+			return idx;
+		}
+	};
+}
+
+#endif
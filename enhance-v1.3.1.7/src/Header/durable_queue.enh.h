@@ -0,0 +1,959 @@
+/** ***************************************************************************
+	\file durable_queue.enh.h
+
+	\brief The file to declare wal_queue, the write-ahead logged storage of
+	queued_process, and its policy durable_queue
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	<h3> How To Use</h3>
+
+	- Construct the queue with the directory of its log :
+	`queued_process<msg, durable_queue> q(proc, wal_config{ "queue.wal" });`
+	The message type must be trivially copyable, it is stored as bytes.
+
+	- postMessage returns once the message is on disk. Producers posting at
+	the same time share one flush (group commit).
+
+	- The processing thread checkpoints its position after every message (or
+	batch) processed successfully. Messages not processed when the program
+	dies, or left over by force_join, are processed again when the queue is
+	next started, in the same program or after reopening the directory.
+
+	- Delivery is at least once : a message processed just before a crash
+	may be processed again, processing functions should tolerate it.
+
+	<h3> Layout </h3>
+
+	The directory holds a checkpoint file and segment files named
+	wal-<first position in hex>.seg. Each segment starts with a 64 byte
+	header followed by records of a 32 bit length, a 32 bit checksum and
+	the message padded to 8 bytes. A zero length ends the segment, all ones
+	seals it. Segments wholly before the checkpoint are deleted, recovery
+	stops a segment at the first record that does not check.
+
+******************************************************************************/
+
+#ifndef DURABLE_QUEUE_ENH_H
+
+#define DURABLE_QUEUE_ENH_H						durable_queue.enh.h
+
+#include "queued_process.enh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace enh
+{
+
+	/**
+		\brief The configuration of a write-ahead logged queue.
+	*/
+	struct wal_config
+	{
+		/**
+			\brief The directory of the log, created if missing.
+		*/
+		std::filesystem::path directory;
+
+		/**
+			\brief The size of a segment file.
+		*/
+		std::size_t segmentBytes = std::size_t(64) << 20;
+	};
+
+	/**
+		\brief The class for a file mapped into memory for the write-ahead log,
+		written through the map and flushed by range.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class wal_file
+	{
+		char* view = nullptr;
+		std::size_t length = 0;
+#if defined(_WIN32)
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+#else
+		int fd = -1;
+#endif
+
+	public:
+
+		wal_file() = default;
+
+		wal_file(const wal_file&) = delete;
+
+		wal_file& operator = (const wal_file&) = delete;
+
+		/**
+			\brief Maps the file, created zero filled of size bytes if create
+			is set, else the existing file whole.
+
+			<h3>Return</h3>
+			false if the file could not be created or mapped.\n
+		*/
+		bool open(
+			const std::filesystem::path& path /**< : <i>in</i> : The file.*/,
+			std::size_t size /**< : <i>in</i> : The size to create.*/,
+			bool create /**< : <i>in</i> : true to create (or truncate)
+						the file.*/
+		) noexcept
+		{
+			close();
+#if defined(_WIN32)
+			file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+				FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+				create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+				return false;
+			if (!create)
+			{
+				LARGE_INTEGER current;
+				size = GetFileSizeEx(file, &current)
+					? static_cast<std::size_t>(current.QuadPart) : 0;
+			}
+			ULARGE_INTEGER bytes;
+			bytes.QuadPart = size;
+			if (size)
+				mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE,
+					bytes.HighPart, bytes.LowPart, nullptr);
+			if (mapping)
+				view = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+#else
+			fd = ::open(path.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+			if (fd < 0)
+				return false;
+			bool sized = false;
+			if (create)
+			{
+#if defined(__linux__)
+				// reserves the blocks, a full disk fails here instead of as
+				// SIGBUS on a write through the map.
+				sized = ::posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0;
+#else
+				sized = ::ftruncate(fd, static_cast<off_t>(size)) == 0;
+#endif
+			}
+			else
+			{
+				struct stat info;
+				sized = ::fstat(fd, &info) == 0;
+				size = sized ? static_cast<std::size_t>(info.st_size) : 0;
+			}
+			if (sized && size)
+			{
+				void* at = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				if (at != MAP_FAILED)
+					view = static_cast<char*>(at);
+			}
+#endif
+			if (!view)
+			{
+				close();
+				return false;
+			}
+			length = size;
+			return true;
+		}
+
+		/**
+			\brief Unmaps and closes the file.
+		*/
+		void close() noexcept
+		{
+#if defined(_WIN32)
+			if (view)
+				UnmapViewOfFile(view);
+			if (mapping)
+				CloseHandle(mapping);
+			if (file != INVALID_HANDLE_VALUE)
+				CloseHandle(file);
+			mapping = nullptr;
+			file = INVALID_HANDLE_VALUE;
+#else
+			if (view)
+				::munmap(view, length);
+			if (fd >= 0)
+				::close(fd);
+			fd = -1;
+#endif
+			view = nullptr;
+			length = 0;
+		}
+
+		/**
+			\brief Writes bytes [from, to) of the map to the disk and waits
+			for it.
+
+			<h3>Return</h3>
+			false if the flush failed.\n
+		*/
+		bool flush(
+			std::size_t from /**< : <i>in</i> : The first byte.*/,
+			std::size_t to /**< : <i>in</i> : One past the last byte.*/
+		) noexcept
+		{
+			if (!view || from >= to)
+				return true;
+			to = std::min(to, length);
+#if defined(_WIN32)
+			return FlushViewOfFile(view + from, to - from) && FlushFileBuffers(file);
+#else
+			static const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+			std::size_t start = from / page * page;
+			return ::msync(view + start, to - start, MS_SYNC) == 0;
+#endif
+		}
+
+		/**
+			\brief The mapped bytes, nullptr if not open.
+		*/
+		inline char* data() const noexcept { return view; }
+
+		/**
+			\brief The number of mapped bytes.
+		*/
+		inline std::size_t size() const noexcept { return length; }
+
+		/**
+			\brief Flushes the entries of a directory, so files created in it
+			survive a crash.
+
+			NTFS journals directory entries, nothing is done on Windows.
+		*/
+		static bool syncDirectory(
+			const std::filesystem::path& dir /**< : <i>in</i> : The directory.*/
+		) noexcept
+		{
+#if defined(_WIN32)
+			(void)dir;
+			return true;
+#else
+			int handle = ::open(dir.c_str(), O_RDONLY);
+			if (handle < 0)
+				return false;
+			bool good = ::fsync(handle) == 0;
+			::close(handle);
+			return good;
+#endif
+		}
+
+		/**
+			\brief Unmaps and closes the file.
+		*/
+		~wal_file() { close(); }
+	};
+
+	/**
+		\brief The storage of queued_process for policy durable_queue, a queue
+		of messages in a segmented write-ahead log on disk.
+
+		Messages are copied into the mapped active segment, sync makes them
+		durable and commit records the read position as the checkpoint.
+		Messages popped and not committed are popped again after clear or
+		when the log is reopened.\n\n
+
+		Not thread safe except sync, queued_process guards the rest with its
+		mutex.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>Template arguments</h3>
+		-#  <code>class T</code> : The message, must be trivially copyable.\n
+	*/
+	template<class T>
+	class wal_queue
+	{
+		static_assert(std::is_trivially_copyable_v<T>,
+			"wal_queue stores messages as bytes, they must be trivially copyable");
+
+		/**
+			\brief The start of a segment file.
+		*/
+		struct segment_header
+		{
+			char magic[8];
+			std::uint64_t base;
+			std::uint64_t capacity;
+			std::uint64_t record;
+			char reserved[32];
+		};
+
+		static_assert(sizeof(segment_header) == 64, "wal segment header layout");
+
+		/**
+			\brief A mapped segment, its file is deleted with it once it is
+			wholly before the checkpoint.
+		*/
+		struct segment
+		{
+			wal_file file;
+			std::filesystem::path path;
+			std::uint64_t base = 0;
+			std::size_t used = sizeof(segment_header);
+			bool discard = false;
+
+			/**
+				\brief The position after the last record.
+			*/
+			inline std::uint64_t end() const noexcept
+			{
+				return base + (used - sizeof(segment_header));
+			}
+
+			~segment()
+			{
+				file.close();
+				if (discard)
+				{
+					std::error_code ec;
+					std::filesystem::remove(path, ec);
+				}
+			}
+		};
+
+		/**
+			\brief The bytes of a record, the length, checksum and message
+			padded to 8 bytes.
+		*/
+		static constexpr std::size_t record_bytes = 8 + (sizeof(T) + 7) / 8 * 8;
+
+		/**
+			\brief The length marking a sealed segment.
+		*/
+		static constexpr std::uint32_t seal_mark = 0xFFFFFFFFU;
+
+		/**
+			\brief The bytes of the checkpoint file.
+		*/
+		static constexpr std::size_t checkpoint_bytes = 4096;
+
+		wal_config config;
+
+		/**
+			\brief The segments oldest first, the last one is written.
+		*/
+		std::deque<std::shared_ptr<segment>> segments;
+
+		/**
+			\brief The segment and offset of the next record to pop.
+		*/
+		std::size_t readIndex = 0;
+		std::size_t readOffset = sizeof(segment_header);
+
+		/**
+			\brief The position of the next record to pop.
+		*/
+		std::uint64_t readPosition = 0;
+
+		/**
+			\brief Records after the read position.
+		*/
+		std::size_t count = 0;
+
+		/**
+			\brief Records popped and not committed.
+		*/
+		std::size_t unacked = 0;
+
+		/**
+			\brief The mapped checkpoint, the position of the first record not
+			processed.
+		*/
+		wal_file checkpointFile;
+
+		/**
+			\brief The position after the last record written.
+		*/
+		std::atomic<std::uint64_t> written{ 0 };
+
+		/**
+			\brief The synchronising mutex for the rest, taken without the
+			queue lock by sync.
+		*/
+		std::mutex mtxSync;
+		std::condition_variable cvSync;
+		std::shared_ptr<segment> activeSegment;
+		std::uint64_t durable = 0;
+		bool syncing = false;
+
+		/**
+			\brief 32 bit FNV-1a of the bytes.
+		*/
+		static std::uint32_t checksum(
+			const char* data /**< : <i>in</i> : The bytes.*/,
+			std::size_t size /**< : <i>in</i> : The number of bytes.*/
+		) noexcept
+		{
+			std::uint32_t hash = 2166136261U;
+			for (std::size_t i = 0; i < size; ++i)
+			{
+				hash ^= static_cast<unsigned char>(data[i]);
+				hash *= 16777619U;
+			}
+			return hash;
+		}
+
+		/**
+			\brief The file of the segment starting at base.
+		*/
+		std::filesystem::path segment_path(
+			std::uint64_t base /**< : <i>in</i> : The first position.*/
+		) const
+		{
+			char name[32];
+			std::snprintf(name, sizeof(name), "wal-%016llx.seg",
+				static_cast<unsigned long long>(base));
+			return config.directory / name;
+		}
+
+		/**
+			\brief The stored checkpoint.
+		*/
+		inline std::uint64_t checkpoint() const noexcept
+		{
+			std::uint64_t position;
+			std::memcpy(&position, checkpointFile.data() + 8, sizeof(position));
+			return position;
+		}
+
+		/**
+			\brief Stores the checkpoint, written back by the system.
+		*/
+		inline void set_checkpoint(
+			std::uint64_t position /**< : <i>in</i> : The position.*/
+		) noexcept
+		{
+			std::memcpy(checkpointFile.data() + 8, &position, sizeof(position));
+		}
+
+		/**
+			\brief Creates the segment starting at base and makes it durable.
+
+			Throws std::runtime_error if the file could not be created.
+		*/
+		std::shared_ptr<segment> create_segment(
+			std::uint64_t base /**< : <i>in</i> : The first position.*/
+		)
+		{
+			auto seg = std::make_shared<segment>();
+			seg->path = segment_path(base);
+			seg->base = base;
+			if (!seg->file.open(seg->path, config.segmentBytes, true))
+			{
+				seg->discard = true;
+				throw std::runtime_error("wal segment could not be created : "
+					+ seg->path.string());
+			}
+			segment_header header = {};
+			std::memcpy(header.magic, "ENHWAL01", 8);
+			header.base = base;
+			header.capacity = config.segmentBytes;
+			header.record = sizeof(T);
+			std::memcpy(seg->file.data(), &header, sizeof(header));
+			seg->file.flush(0, sizeof(header));
+			wal_file::syncDirectory(config.directory);
+			return seg;
+		}
+
+		/**
+			\brief Maps the checkpoint file, created at position 0 if missing
+			or not valid.
+		*/
+		void open_checkpoint()
+		{
+			std::filesystem::path path = config.directory / "checkpoint.wal";
+			if (checkpointFile.open(path, 0, false)
+				&& checkpointFile.size() >= 16
+				&& std::memcmp(checkpointFile.data(), "ENHWALCP", 8) == 0)
+				return;
+			if (!checkpointFile.open(path, checkpoint_bytes, true))
+				throw std::runtime_error("wal checkpoint could not be created : "
+					+ path.string());
+			std::memcpy(checkpointFile.data(), "ENHWALCP", 8);
+			set_checkpoint(0);
+			checkpointFile.flush(0, 16);
+			wal_file::syncDirectory(config.directory);
+		}
+
+		/**
+			\brief Finds the records of seg from offset, sets used after the
+			last one that checks.
+
+			<h3>Return</h3>
+			true if the scan stopped at a record that does not check.\n
+		*/
+		bool scan(
+			segment& seg /**< : <i>in,out</i> : The segment.*/,
+			std::size_t offset /**< : <i>in</i> : The first record.*/,
+			std::size_t& records /**< : <i>out</i> : Records found.*/
+		) const noexcept
+		{
+			const char* data = seg.file.data();
+			std::size_t limit = seg.file.size();
+			records = 0;
+			while (offset + 8 <= limit)
+			{
+				std::uint32_t length, sum;
+				std::memcpy(&length, data + offset, 4);
+				std::memcpy(&sum, data + offset + 4, 4);
+				if (length == 0 || length == seal_mark)
+				{
+					seg.used = offset;
+					return false;
+				}
+				if (length != sizeof(T) || offset + record_bytes + 8 > limit
+					|| checksum(data + offset + 8, sizeof(T)) != sum)
+				{
+					seg.used = offset;
+					return true;
+				}
+				offset += record_bytes;
+				++records;
+			}
+			seg.used = offset;
+			return false;
+		}
+
+		/**
+			\brief Opens the segments of the directory and finds the records
+			after the checkpoint.
+
+			Throws std::runtime_error if a segment holds messages of another
+			size.
+		*/
+		void recover()
+		{
+			std::uint64_t position = checkpoint();
+			for (auto& entry : std::filesystem::directory_iterator(config.directory))
+			{
+				std::string name = entry.path().filename().string();
+				if (name.size() != 24 || name.compare(0, 4, "wal-") != 0
+					|| entry.path().extension() != ".seg")
+					continue;
+				auto seg = std::make_shared<segment>();
+				seg->path = entry.path();
+				segment_header header;
+				if (!seg->file.open(seg->path, 0, false)
+					|| seg->file.size() < sizeof(header))
+					continue;
+				std::memcpy(&header, seg->file.data(), sizeof(header));
+				if (std::memcmp(header.magic, "ENHWAL01", 8) != 0)
+				{
+					// died while creating it, it holds no records.
+					seg->discard = true;
+					continue;
+				}
+				if (header.record != sizeof(T))
+					throw std::runtime_error("wal segment holds messages of "
+						"another size : " + seg->path.string());
+				seg->base = header.base;
+				segments.push_back(std::move(seg));
+			}
+			std::sort(segments.begin(), segments.end(),
+				[](const auto& a, const auto& b) { return a->base < b->base; });
+			while (segments.size() > 1 && segments[1]->base <= position)
+			{
+				segments.front()->discard = true;
+				segments.pop_front();
+			}
+			for (std::size_t i = 0; i < segments.size(); ++i)
+			{
+				segment& seg = *segments[i];
+				std::size_t offset = sizeof(segment_header);
+				if (i == 0 && position > seg.base)
+					offset = static_cast<std::size_t>(std::min<std::uint64_t>(
+						offset + (position - seg.base), seg.file.size()));
+				if (i == 0)
+					readOffset = offset;
+				std::size_t records = 0;
+				bool torn = scan(seg, offset, records);
+				count += records;
+				if (torn && i + 1 == segments.size())
+				{
+					// appends must not follow the remains of a torn record.
+					std::memset(seg.file.data() + seg.used, 0,
+						seg.file.size() - seg.used);
+					seg.file.flush(seg.used, seg.file.size());
+				}
+			}
+			if (segments.empty())
+				segments.push_back(create_segment(position));
+			else if (segments.back()->used + record_bytes + 8 > segments.back()->file.size())
+				segments.push_back(create_segment(segments.back()->end()));
+			else
+			{
+				std::uint32_t length;
+				std::memcpy(&length, segments.back()->file.data()
+					+ segments.back()->used, 4);
+				if (length == seal_mark)
+					segments.push_back(create_segment(segments.back()->end()));
+			}
+			if (readOffset > segments.front()->used)
+				readOffset = segments.front()->used;
+			readPosition = segments.front()->base + (readOffset - sizeof(segment_header));
+			activeSegment = segments.back();
+			written = activeSegment->end();
+			durable = written.load();
+		}
+
+		/**
+			\brief Seals the active segment and starts the next, waits for a
+			flush of the active segment in progress.
+		*/
+		void rotate()
+		{
+			auto old = segments.back();
+			std::uint32_t seal = seal_mark;
+			std::memcpy(old->file.data() + old->used, &seal, 4);
+			old->file.flush(sizeof(segment_header), old->used + 4);
+			auto next = create_segment(old->end());
+			segments.push_back(next);
+			std::unique_lock<std::mutex> lock(mtxSync);
+			cvSync.wait(lock, [this]() { return !syncing; });
+			activeSegment = std::move(next);
+			durable = std::max(durable, old->end());
+		}
+
+		/**
+			\brief Copies the message to the end of the log.
+		*/
+		bool append(
+			const T& value /**< : <i>in</i> : The message.*/
+		)
+		{
+			if (segments.back()->used + record_bytes + 8 > config.segmentBytes)
+				rotate();
+			segment& seg = *segments.back();
+			char* at = seg.file.data() + seg.used;
+			std::memcpy(at + 8, &value, sizeof(T));
+			std::uint32_t sum = checksum(at + 8, sizeof(T));
+			std::uint32_t length = static_cast<std::uint32_t>(sizeof(T));
+			std::memcpy(at + 4, &sum, 4);
+			std::memcpy(at, &length, 4);
+			seg.used += record_bytes;
+			++count;
+			written.store(seg.end(), std::memory_order_release);
+			return true;
+		}
+
+		/**
+			\brief Copies the next record to where and moves past it.
+		*/
+		void read(
+			void* where /**< : <i>out</i> : The bytes of a T.*/
+		) noexcept
+		{
+			while (readOffset >= segments[readIndex]->used
+				&& readIndex + 1 < segments.size())
+			{
+				++readIndex;
+				readOffset = sizeof(segment_header);
+				readPosition = segments[readIndex]->base;
+			}
+			std::memcpy(where, segments[readIndex]->file.data() + readOffset + 8,
+				sizeof(T));
+			readOffset += record_bytes;
+			readPosition += record_bytes;
+			--count;
+			++unacked;
+		}
+
+	public:
+
+		/**
+			\brief Opens the log in config.directory, creating it if missing,
+			records after the checkpoint are popped first.
+
+			Throws std::filesystem::filesystem_error or std::runtime_error if
+			the log could not be opened.
+		*/
+		explicit wal_queue(
+			const wal_config& cfg /**< : <i>in</i> : The configuration.*/
+		) : config(cfg)
+		{
+			config.segmentBytes = std::max(config.segmentBytes,
+				sizeof(segment_header) + 4 * record_bytes);
+			std::filesystem::create_directories(config.directory);
+			open_checkpoint();
+			recover();
+		}
+
+		wal_queue(const wal_queue&) = delete;
+
+		wal_queue& operator = (const wal_queue&) = delete;
+
+		/**
+			\brief Pushes a copy of the value, durable after sync.
+
+			Throws std::runtime_error if a new segment could not be created.
+		*/
+		inline bool try_push(
+			const T& val /**< : <i>in</i> : The value to push.*/
+		)
+		{
+			return append(val);
+		}
+
+		/**
+			\brief Constructs a value from the arguments at the back, durable
+			after sync.
+
+			Throws std::runtime_error if a new segment could not be created.
+		*/
+		template<class... Args>
+		inline bool try_emplace(
+			Args&&... args /**< : <i>in</i> : The constructor arguments.*/
+		)
+		{
+			return append(T(std::forward<Args>(args)...));
+		}
+
+		/**
+			\brief Pops the oldest value, copied out of the log.
+
+			<h3>Return</h3>
+			Returns false if the queue is empty.\n
+		*/
+		inline bool try_pop(
+			std::optional<T>& out /**< : <i>out</i> : Holds the value popped.*/
+		)
+		{
+			if (count == 0)
+				return false;
+			alignas(T) unsigned char bytes[sizeof(T)];
+			read(bytes);
+			out.emplace(*std::launder(reinterpret_cast<T*>(bytes)));
+			return true;
+		}
+
+		/**
+			\brief Pops upto max oldest values (all if max is 0), appending them
+			to out.
+
+			<h3>Return</h3>
+			The number of values popped.\n
+		*/
+		inline std::size_t try_pop_bulk(
+			std::vector<T>& out /**< : <i>out</i> : Holds the values popped.*/,
+			std::size_t max /**< : <i>in</i> : The maximum values to pop.*/
+		)
+		{
+			std::size_t popped = count;
+			if (max != 0 && max < popped)
+				popped = max;
+			alignas(T) unsigned char bytes[sizeof(T)];
+			for (std::size_t i = 0; i < popped; ++i)
+			{
+				read(bytes);
+				out.push_back(*std::launder(reinterpret_cast<T*>(bytes)));
+			}
+			return popped;
+		}
+
+		/**
+			\brief Checks if the queue is empty.
+		*/
+		inline bool empty() const noexcept { return count == 0; }
+
+		/**
+			\brief The number of values after the read position.
+		*/
+		inline std::size_t size() const noexcept { return count; }
+
+		/**
+			\brief Moves the read position back to the checkpoint, the values
+			popped and not committed are popped again. Nothing is removed
+			from the log.
+		*/
+		inline void clear() noexcept
+		{
+			std::uint64_t position = checkpoint();
+			readIndex = 0;
+			while (readIndex + 1 < segments.size()
+				&& segments[readIndex]->end() <= position)
+				++readIndex;
+			segment& seg = *segments[readIndex];
+			readPosition = std::max(position, seg.base);
+			readOffset = static_cast<std::size_t>(readPosition - seg.base)
+				+ sizeof(segment_header);
+			if (readOffset > seg.used)
+			{
+				readOffset = seg.used;
+				readPosition = seg.end();
+			}
+			count += unacked;
+			unacked = 0;
+		}
+
+		/**
+			\brief Makes the read position the checkpoint, deleting the
+			segments wholly before it.
+
+			The checkpoint reaches the disk in the background, it decides
+			only what is popped again after a crash.
+		*/
+		inline void commit() noexcept
+		{
+			set_checkpoint(readPosition);
+			unacked = 0;
+			while (readIndex > 0)
+			{
+				segments.front()->discard = true;
+				segments.pop_front();
+				--readIndex;
+			}
+		}
+
+		/**
+			\brief Waits till every value pushed before the call is on disk.
+
+			The first thread to wait flushes for all that wait meanwhile, the
+			rest wait for it. Safe to call without the queue lock.
+
+			<h3>Return</h3>
+			false if flushing failed.\n
+		*/
+		bool sync() noexcept
+		{
+			std::uint64_t target = written.load(std::memory_order_acquire);
+			std::unique_lock<std::mutex> lock(mtxSync);
+			while (durable < target)
+			{
+				if (syncing)
+				{
+					cvSync.wait(lock);
+					continue;
+				}
+				// rotate waits while syncing, so the segment stays active
+				// and every position written is in it.
+				syncing = true;
+				std::shared_ptr<segment> seg = activeSegment;
+				std::uint64_t from = std::max(durable, seg->base);
+				lock.unlock();
+				std::uint64_t to = written.load(std::memory_order_acquire);
+				bool good = seg->file.flush(
+					static_cast<std::size_t>(from - seg->base) + sizeof(segment_header),
+					static_cast<std::size_t>(to - seg->base) + sizeof(segment_header));
+				lock.lock();
+				syncing = false;
+				if (good)
+					durable = std::max(durable, to);
+				cvSync.notify_all();
+				if (!good)
+					return false;
+			}
+			return true;
+		}
+
+		/**
+			\brief Flushes the log and the checkpoint.
+		*/
+		~wal_queue()
+		{
+			sync();
+			checkpointFile.flush(0, 16);
+		}
+	};
+
+	/**
+		\brief The queue policy of queued_process that stores messages in a
+		write-ahead log on disk, see durable_queue.enh.h.
+
+		postMessage returns once the message is durable, unprocessed messages
+		are processed when the queue is started, after a crash too. Construct
+		queued_process with a wal_config.
+	*/
+	struct durable_queue
+	{
+		/**
+			\brief The storage for messages of type T.
+		*/
+		template<class T>
+		using storage = wal_queue<T>;
+
+		/**
+			\brief Storage needs external locking.
+		*/
+		static constexpr bool is_lock_free = false;
+
+		/**
+			\brief try_push never fails.
+		*/
+		static constexpr bool is_bounded = false;
+
+		/**
+			\brief Messages are FIFO.
+		*/
+		static constexpr bool is_scheduled = false;
+
+		/**
+			\brief No statistics are collected.
+		*/
+		static constexpr bool has_stats = false;
+
+		/**
+			\brief Messages are synced on post and committed when processed.
+		*/
+		static constexpr bool is_durable = true;
+
+		/**
+			\brief Counts and wake-ups are local to the process.
+		*/
+		static constexpr bool is_shared = false;
+
+		/**
+			\brief Every message posted is kept.
+		*/
+		static constexpr bool is_coalescing = false;
+	};
+}
+
+#endif // !DURABLE_QUEUE_ENH_H
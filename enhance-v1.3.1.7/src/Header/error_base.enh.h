@@ -31,8 +31,12 @@
 #define ERROR_BASE_ENH_H				error_base.enh.h
 
 #include <atomic>
+#include <cstddef>
+#include <string_view>
+#include "flag_set.enh.h"
 #include "general.enh.h"
 #include "logger.enh.h"
+#include "result.enh.h"
 
 
 /*
@@ -72,6 +76,312 @@ namespace enh
 		return (e != tristate::GOOD);
 	}
 
+	/**
+		\brief The name of one error bit, an entry of an error_table.
+	*/
+	template<class type>
+	struct error_entry
+	{
+		/**
+			\brief The bit (or bits) of the error code.
+		*/
+		type bit;
+
+		/**
+			\brief The name, such as INVALID_ARG.
+		*/
+		std::string_view name;
+	};
+
+	/**
+		\brief The view of a compile time table of error names, declared by
+		each error class as a static constexpr array of error_entry.
+
+		Looking up and formatting write no heap memory.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	template<class type>
+	class error_table
+	{
+		const error_entry<type>* entries;
+		std::size_t count;
+
+		static constexpr inline char hex_digit(unsigned v) noexcept
+		{
+			return static_cast<char>((v < 10) ? '0' + v : 'A' + (v - 10));
+		}
+
+	public:
+
+		/**
+			\brief Views the static table e.
+		*/
+		template<std::size_t N>
+		constexpr inline error_table(
+			const error_entry<type>(&e)[N] /**< : <i>in</i> : The table, must
+										   outlive the view.*/
+		) noexcept : entries(e), count(N) {}
+
+		constexpr inline std::size_t size() const noexcept { return count; }
+
+		constexpr inline const error_entry<type>* begin() const noexcept { return entries; }
+
+		constexpr inline const error_entry<type>* end() const noexcept
+		{
+			return entries + count;
+		}
+
+		/**
+			\brief The name of bit, SAFE for 0.
+
+			<h3>Return</h3>
+			An empty view if bit is not in the table.\n
+		*/
+		constexpr inline std::string_view nameOf(
+			type bit /**< : <i>in</i> : The error bit.*/
+		) const noexcept
+		{
+			if (bit == 0)
+				return "SAFE";
+			for (std::size_t i = 0; i < count; ++i)
+				if (entries[i].bit == bit)
+					return entries[i].name;
+			return {};
+		}
+
+		/**
+			\brief The longest string of format_to.
+		*/
+		constexpr inline std::size_t max_string_size() const noexcept
+		{
+			std::size_t size = 4 + 3 + 2 + 2 * sizeof(type);
+			for (std::size_t i = 0; i < count; ++i)
+				size += entries[i].name.size() + 3;
+			return size;
+		}
+
+		/**
+			\brief Writes the names of the bits of value to [first, last),
+			joined by " + ", SAFE for 0, and bits not in the table as one 
+			hex number. Nothing is null terminated.
+
+			<h3>Return</h3>
+			The end of the written characters, nullptr if it did not fit.\n
+		*/
+		inline char* format_to(
+			char* first /**< : <i>out</i> : The start of the buffer.*/,
+			char* last /**< : <i>in</i> : The end of the buffer.*/,
+			type value /**< : <i>in</i> : The error flag.*/
+		) const noexcept
+		{
+			if (value == 0)
+				return appendText(first, last, "SAFE");
+			bool prev = false;
+			type rest = value;
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				if (entries[i].bit == 0 || !checkField(value, entries[i].bit))
+					continue;
+				if (prev)
+					first = appendText(first, last, " + ");
+				first = appendText(first, last, entries[i].name);
+				rest = static_cast<type>(rest & ~entries[i].bit);
+				prev = true;
+			}
+			if (rest != 0)
+			{
+				if (prev)
+					first = appendText(first, last, " + ");
+				char hex[2 + 2 * sizeof(type)];
+				char* p = hex + sizeof(hex);
+				auto bits = static_cast<std::make_unsigned_t<type>>(rest);
+				while (bits != 0)
+				{
+					*--p = hex_digit(static_cast<unsigned>(bits & 0xF));
+					bits = static_cast<decltype(bits)>(bits >> 4);
+				}
+				*--p = 'x';
+				*--p = '0';
+				first = appendText(first, last,
+					std::string_view(p, static_cast<std::size_t>(hex + sizeof(hex) - p)));
+			}
+			return first;
+		}
+	};
+
+	/**
+		\brief The class for the number of error_base objects with each
+		error bit set, for objects that join it.
+
+		Counts are kept per thread shard, changed by the flag updates of the
+		joined objects (one relaxed add per bit that changes) and summed on
+		read, so reading all counts is O(bits * shards) whatever the number
+		of objects. Counts read while flags change are each exact at some
+		point, not one snapshot.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>template</h3>
+		-#  <code>type</code> : The error type of the error_base.\n
+		-#  <code>shards</code> : The number of per thread slots.\n
+	*/
+	template<class type, std::size_t shards = 16>
+	class error_registry
+	{
+		static_assert(std::is_integral_v<type>, "error_registry should have integral error type");
+		static_assert(shards > 0, "shards must not be 0");
+
+		using bits_t = std::make_unsigned_t<type>;
+
+	public:
+
+		/**
+			\brief The number of error bits.
+		*/
+		static constexpr std::size_t bit_count = sizeof(type) * 8;
+
+	private:
+
+		/**
+			\brief The counts changed by one thread.
+		*/
+		struct alignas(cache_line_size) slot
+		{
+			std::atomic<long long> bits[bit_count] = {};
+			std::atomic<long long> unsafe{ 0 };
+			std::atomic<long long> members{ 0 };
+		};
+
+		slot slots[shards];
+
+		inline slot& local() noexcept
+		{
+			return slots[threadShard() % shards];
+		}
+
+		inline long long sum(std::atomic<long long> slot::* field) const noexcept
+		{
+			long long total = 0;
+			for (const slot& s : slots)
+				total += (s.*field).load(std::memory_order_relaxed);
+			return total;
+		}
+
+	public:
+
+		inline error_registry() noexcept {}
+
+		error_registry(const error_registry&) = delete;
+
+		error_registry& operator = (const error_registry&) = delete;
+
+		/**
+			\brief Records a flag change of a joined object from before to
+			after.
+		*/
+		inline void changed(
+			type before /**< : <i>in</i> : The flag before.*/,
+			type after /**< : <i>in</i> : The flag after.*/
+		) noexcept
+		{
+			bits_t rise = static_cast<bits_t>(after) & ~static_cast<bits_t>(before);
+			bits_t fall = static_cast<bits_t>(before) & ~static_cast<bits_t>(after);
+			if ((rise | fall) == 0)
+				return;
+			slot& s = local();
+			for (std::size_t i = 0; i < bit_count && (rise | fall) != 0; ++i)
+			{
+				if (rise & 1)
+					s.bits[i].fetch_add(1, std::memory_order_relaxed);
+				else if (fall & 1)
+					s.bits[i].fetch_sub(1, std::memory_order_relaxed);
+				rise = static_cast<bits_t>(rise >> 1);
+				fall = static_cast<bits_t>(fall >> 1);
+			}
+			if ((before == 0) != (after == 0))
+				s.unsafe.fetch_add((after != 0) ? 1 : -1, std::memory_order_relaxed);
+		}
+
+		/**
+			\brief Records an object with flag joining.
+		*/
+		inline void enter(
+			type flag /**< : <i>in</i> : The flag of the object.*/
+		) noexcept
+		{
+			local().members.fetch_add(1, std::memory_order_relaxed);
+			changed(0, flag);
+		}
+
+		/**
+			\brief Records an object with flag leaving.
+		*/
+		inline void exit(
+			type flag /**< : <i>in</i> : The flag of the object.*/
+		) noexcept
+		{
+			changed(flag, 0);
+			local().members.fetch_sub(1, std::memory_order_relaxed);
+		}
+
+		/**
+			\brief The number of joined objects with every bit of check set.
+			Exact for a single bit, for several bits the least count of
+			them (an upper bound).
+		*/
+		inline long long count(
+			type check /**< : <i>in</i> : The error bit.*/
+		) const noexcept
+		{
+			bits_t b = static_cast<bits_t>(check);
+			if (b == 0)
+				return members() - unsafeCount();
+			long long least = -1;
+			for (std::size_t i = 0; i < bit_count; ++i, b = static_cast<bits_t>(b >> 1))
+			{
+				if (!(b & 1))
+					continue;
+				long long total = 0;
+				for (const slot& s : slots)
+					total += s.bits[i].load(std::memory_order_relaxed);
+				least = (least < 0 || total < least) ? total : least;
+			}
+			return least;
+		}
+
+		/**
+			\brief The number of joined objects with any error set.
+		*/
+		inline long long unsafeCount() const noexcept
+		{
+			return sum(&slot::unsafe);
+		}
+
+		/**
+			\brief The number of joined objects.
+		*/
+		inline long long members() const noexcept
+		{
+			return sum(&slot::members);
+		}
+
+		/**
+			\brief Writes the count of every bit to out[0, bit_count).
+		*/
+		inline void counts(
+			long long* out /**< : <i>out</i> : bit_count counts, out[i] for
+						   bit 1 << i.*/
+		) const noexcept
+		{
+			for (std::size_t i = 0; i < bit_count; ++i)
+				out[i] = 0;
+			for (const slot& s : slots)
+				for (std::size_t i = 0; i < bit_count; ++i)
+					out[i] += s.bits[i].load(std::memory_order_relaxed);
+		}
+	};
+
 	/**
 		\brief The class for inheriting error tracking Functionality.
 
@@ -82,6 +392,21 @@ namespace enh
 		Value 0x01 is reserved for unknown errors.\n
 		Value 0x02 is reserved for invalid argument errors.\n\n
 
+		An object may join an error_registry, which then counts its flags,
+		joining and leaving must not race with flag changes of the object.
+		\n\n
+
+		Derived classes name their errors by declaring a static constexpr
+		array of error_entry (starting with base_errors' entries) and
+		overriding error_names to return it, error_string, format_error_to
+		and Log then print them.\n\n
+
+		The flag is one atomic, changed by lock-free read-modify-writes.
+		Every function takes the memory order to use, seq_cst by default,
+		pass std::memory_order_relaxed for status polling that orders
+		nothing else. An order a load or store cannot take is mapped to the
+		nearest it can (see load_order and store_order).\n\n
+
 		<h3>Template Argument</h3>
 		The underlying type to hold error information. (must be integral).
 
@@ -115,6 +440,17 @@ namespace enh
 			\brief <i>0x02</i> : Invalid argument. 
 		*/
 		static constexpr error INVALID_ARG = 0x02;
+
+		static_assert(UNKNOWN == result_code::UNKNOWN && INVALID_ARG == result_code::INVALID_ARG,
+			"error_base codes must match result_code");
+
+		/**
+			\brief The names of the errors of error_base.
+		*/
+		static constexpr error_entry<error> base_errors[] = {
+			{ UNKNOWN, "UNKNOWN" },
+			{ INVALID_ARG, "INVALID_ARG" }
+		};
 	protected:
 
 		/**
@@ -122,6 +458,20 @@ namespace enh
 		*/
 		std::atomic<error> flag;
 
+		/**
+			\brief The registry joined, nullptr if none.
+		*/
+		error_registry<error>* registry = nullptr;
+
+		/**
+			\brief Reports a change to the registry, if joined.
+		*/
+		inline void report(error before, error after) noexcept
+		{
+			if (registry)
+				registry->changed(before, after);
+		}
+
 	public:
 
 
@@ -134,13 +484,50 @@ namespace enh
 			flag = SAFE;
 		}
 
+		/**
+			\brief Leaves the registry if joined.
+		*/
+		virtual ~error_base()
+		{
+			leave();
+		}
+
+		/**
+			\brief Joins reg, leaving the registry joined before.
+		*/
+		inline void join(
+			error_registry<error>& reg /**< : <i>in</i> : The registry, must
+									   outlive the membership.*/
+		) noexcept
+		{
+			leave();
+			registry = &reg;
+			reg.enter(flag.load(std::memory_order_relaxed));
+		}
+
+		/**
+			\brief Leaves the registry joined, if any.
+		*/
+		inline void leave() noexcept
+		{
+			if (registry)
+				registry->exit(flag.load(std::memory_order_relaxed));
+			registry = nullptr;
+		}
+
 		/**
 			\brief The function to clear error flag.
 
 		*/
-		inline void clear() noexcept
+		inline void clear(
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the store.*/
+		) noexcept
 		{
-			flag = SAFE;
+			if (registry)
+				report(flag.exchange(SAFE, order), SAFE);
+			else
+				flag.store(SAFE, store_order(order));
 		}
 
 		/**
@@ -149,9 +536,24 @@ namespace enh
 			<h3> Return </h3>
 			The error flag.\n
 		*/
-		inline error getError() const noexcept
+		inline error getError(
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the load.*/
+		) const noexcept
+		{
+			return flag.load(load_order(order));
+		}
+
+		/**
+			\brief The error flag as a flag_set, one load for any number of
+			tests or iteration over the errors set.
+		*/
+		inline flag_set<error> getFlags(
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the load.*/
+		) const noexcept
 		{
-			return flag;
+			return flag_set<error>(flag.load(load_order(order)));
 		}
 
 		/**
@@ -162,10 +564,12 @@ namespace enh
 
 		*/
 		inline bool checkFlag(
-			error check_flag /**< : <i>in</i> : flag to check if raised.*/
+			error check_flag /**< : <i>in</i> : flag to check if raised.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the load.*/
 		) const noexcept
 		{
-			return checkField(flag.load(), check_flag);
+			return checkField(flag.load(load_order(order)), check_flag);
 		}
 
 		/**
@@ -175,9 +579,12 @@ namespace enh
 			true if no error flags are set.\n
 
 		*/
-		inline bool isSafe() const noexcept
+		inline bool isSafe(
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the load.*/
+		) const noexcept
 		{
-			return (flag.load() == SAFE);
+			return (flag.load(load_order(order)) == SAFE);
 		}
 
 		/*
@@ -188,28 +595,65 @@ namespace enh
 		*/
 		virtual std::string error_string() const
 		{
-			std::string ret = "";
-			if (isSafe())
-				return "SAFE";
-			bool prev = false;
-			bool unkwn = checkFlag(UNKNOWN);
-			if (unkwn)
-			{
-				ret = "UNKNOWN";
-				prev = true;
-			}
-
-			bool inv = checkFlag(INVALID_ARG);	
-			if (inv)
-			{
-				if (prev)
-					ret += " + ";
-				ret += "INVALID_ARG";
-				prev = true;
-			}
+			error_table<error> names = error_names();
+			std::string ret(names.max_string_size(), '\0');
+			char* end = names.format_to(&ret[0], &ret[0] + ret.size(), flag.load());
+			ret.resize(end ? static_cast<std::size_t>(end - &ret[0]) : 0);
+			return ret;
+		}
 
+		/**
+			\brief All error flag(s) set, the string allocated by alloc.
+		*/
+		template<class Alloc, std::enable_if_t<is_allocator_v<Alloc>, int> = 0>
+		inline alloc_string<Alloc> error_string(
+			const Alloc& alloc /**< : <i>in</i> : The allocator of the string.*/
+		) const
+		{
+			error_table<error> names = error_names();
+			alloc_string<Alloc> ret(names.max_string_size(), '\0',
+				typename alloc_string<Alloc>::allocator_type(alloc));
+			char* end = names.format_to(&ret[0], &ret[0] + ret.size(), flag.load());
+			ret.resize(end ? static_cast<std::size_t>(end - &ret[0]) : 0);
 			return ret;
 		}
+
+		/**
+			\brief The table of error names of the class, override to return
+			the table of the derived class.
+		*/
+		virtual error_table<error> error_names() const noexcept
+		{
+			return error_table<error>(base_errors);
+		}
+
+		/**
+			\brief The name of a single error bit, from error_names.
+
+			<h3>Return</h3>
+			An empty view if it is not in the table.\n
+		*/
+		inline std::string_view error_name(
+			error bit /**< : <i>in</i> : The error bit.*/
+		) const noexcept
+		{
+			return error_names().nameOf(bit);
+		}
+
+		/**
+			\brief Writes the string of error_string to [first, last) without
+			allocating. Nothing is null terminated.
+
+			<h3>Return</h3>
+			The end of the written characters, nullptr if it did not fit.\n
+		*/
+		inline char* format_error_to(
+			char* first /**< : <i>out</i> : The start of the buffer.*/,
+			char* last /**< : <i>in</i> : The end of the buffer.*/
+		) const noexcept
+		{
+			return error_names().format_to(first, last, flag.load());
+		}
 	protected:
 		
 		/**
@@ -223,13 +667,87 @@ namespace enh
 
 		*/
 		inline tristate setFlag(
-			error set /**< : <i>in</i> : flag to be added.*/
+			error set /**< : <i>in</i> : flag to be added.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the update.*/
 		) noexcept
 		{
-			flag |= set;
+			error before = flag.fetch_or(set, order);
+			report(before, static_cast<error>(before | set));
 			return tristate::ERROR;
 		}
 
+		/**
+			\brief Adds set to the error flag and returns it as the failure
+			of a result, for <code>return failFlag(INVALID_ARG);</code>.
+		*/
+		inline failure<error> failFlag(
+			error set /**< : <i>in</i> : flag to be added.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the update.*/
+		) noexcept
+		{
+			setFlag(set, order);
+			return fail(set);
+		}
+
+		/**
+			\brief Adds set to the error flag in one fetch_or.
+
+			<h3>Return</h3>
+			The error flag before the change.\n
+		*/
+		inline error fetchSetFlag(
+			error set /**< : <i>in</i> : flag to be added.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the update.*/
+		) noexcept
+		{
+			error before = flag.fetch_or(set, order);
+			report(before, static_cast<error>(before | set));
+			return before;
+		}
+
+		/**
+			\brief Removes bitClear from the error flag in one fetch_and, 
+			whether all of it was set or not.
+
+			<h3>Return</h3>
+			The error flag before the change.\n
+		*/
+		inline error fetchClearFlag(
+			error bitClear /**< : <i>in</i> : flag to be removed.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the update.*/
+		) noexcept
+		{
+			error before = flag.fetch_and(static_cast<error>(~bitClear), order);
+			report(before, static_cast<error>(before & ~bitClear));
+			return before;
+		}
+
+		/**
+			\brief Sets the error flag to set only if it is SAFE, so the first
+			failure recorded is kept (first error wins).
+
+			<h3>Return</h3>
+			Returns true if this call recorded set, false if an error was
+			already set.\n
+		*/
+		inline bool setFirstFlag(
+			error set /**< : <i>in</i> : flag to be recorded.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the update.*/
+		) noexcept
+		{
+			error expected = SAFE;
+			if (!flag.compare_exchange_strong(expected, set, order,
+				std::memory_order_relaxed))
+				return false;
+			report(SAFE, set);
+			return true;
+		}
+
 		/**
 			\brief The function to clear certian fields from error set.
 
@@ -241,12 +759,19 @@ namespace enh
 
 		*/
 		inline tristate clearFlag(
-			error bitClear /**< : <i>in</i> : flag to be removed.*/
+			error bitClear /**< : <i>in</i> : flag to be removed.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the update.*/
 		) noexcept
 		{
-			if (!checkField(flag.load(), bitClear))
-				return tristate::ERROR;
-			flag ^= bitClear;
+			error prev = flag.load(std::memory_order_relaxed);
+			do
+			{
+				if (!checkField(prev, bitClear))
+					return tristate::ERROR;
+			} while (!flag.compare_exchange_weak(prev, static_cast<error>(prev & ~bitClear),
+				order, std::memory_order_relaxed));
+			report(prev, static_cast<error>(prev & ~bitClear));
 			return tristate::GOOD;
 		}
 
@@ -283,8 +808,18 @@ namespace enh
 								 error holder.*/
 		) const noexcept
 		{
-			debug::Log(file, function, line, derived_class() + " " + variable 
-				+ " flag : " + error_string());
+			std::string cls = derived_class();
+			error_table<error> names = error_names();
+			std::string desc(cls.size() + variable.size() + 8 + names.max_string_size(), '\0');
+			char* first = &desc[0];
+			char* last = first + desc.size();
+			first = appendText(first, last, cls);
+			first = appendText(first, last, " ");
+			first = appendText(first, last, variable);
+			first = appendText(first, last, " flag : ");
+			first = names.format_to(first, last, flag.load());
+			desc.resize(first ? static_cast<std::size_t>(first - &desc[0]) : 0);
+			debug::Log(file, function, line, desc);
 		}
 #endif
 	};
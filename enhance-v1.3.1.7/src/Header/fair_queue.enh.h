@@ -0,0 +1,634 @@
+/** ***************************************************************************
+	\file fair_queue.enh.h
+
+	\brief The file to declare class fair_process, one processing thread
+	serving many input queues by weighted deficit round robin
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+
+******************************************************************************/
+
+#ifndef FAIR_QUEUE_ENH_H
+
+#define FAIR_QUEUE_ENH_H						fair_queue.enh.h
+
+#include "queued_process.enh.h"
+#include "ring_buffer.enh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace enh
+{
+
+	/**
+		\brief The class to process messages of many input queues (lanes, like
+		one per tenant) on a single thread, sharing it by weight.
+
+		Every lane has its own lock-free bounded ring. Each round the thread
+		gives every lane with messages its weight in credit and processes
+		messages of the lane while credit lasts (deficit round robin), so a
+		busy lane cannot starve the others and a lane gets a share of the
+		thread in proportion to its weight. Lanes with messages are marked in
+		a bitmap, idle lanes are never visited.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>Template arguments</h3>
+		-#  <code>class instruct</code> : The type to store the instruction,
+		must be move constructible.\n
+		-#  <code>std::size_t capacity</code> : The slots of the ring of each
+		lane, must be a power of 2.\n
+
+		<h3> How To Use </h3>
+
+		- Construct with the processing function, called with the lane and
+		the message, and the number of lanes.
+
+		- Optionally call `setWeight` (messages a lane gets per round, 1 by
+		default) and `setQuota` (messages a lane may have pending, capacity
+		by default) for each lane.
+
+		- Call `start_queue_process`, `postMessage(lane, message)` (or
+		`try_postMessage` to not wait while the lane is at its quota), then
+		`safe_join` or `force_join` as with queued_process.
+
+		<b>Note</b> : If the processing function returns an error the thread
+		exits, as with queued_process.
+	*/
+	template< class instruct, std::size_t capacity = 1024>
+	class fair_process
+	{
+	public:
+
+		/**
+			\brief The type of object to be processed
+		*/
+		using info_type = instruct;
+
+		/**
+			\brief The function type that processes a message of a lane.
+		*/
+		using processing_method = std::function<tristate(std::size_t, info_type)>;
+
+	private:
+
+		/**
+			\brief The state of a single lane.
+		*/
+		struct alignas(cache_line_size) lane
+		{
+			/**
+				\brief The messages of the lane.
+			*/
+			mpsc_ring<info_type, capacity> ring;
+
+			/**
+				\brief Messages posted to the lane and not taken.
+			*/
+			std::atomic<std::size_t> depth{ 0 };
+
+			/**
+				\brief Credit given to the lane every round.
+			*/
+			std::atomic<std::size_t> weight{ 1 };
+
+			/**
+				\brief The most messages the lane may have pending.
+			*/
+			std::atomic<std::size_t> quota{ capacity };
+
+			/**
+				\brief Credit left, only used by the processing thread.
+			*/
+			std::size_t deficit = 0;
+		};
+
+		/**
+			\brief The lanes.
+		*/
+		std::vector<std::unique_ptr<lane>> lanes;
+
+		/**
+			\brief One bit per lane, set while the lane may have messages.
+		*/
+		std::unique_ptr<std::atomic<std::uint64_t>[]> active;
+
+		/**
+			\brief The number of words of active.
+		*/
+		std::size_t words;
+
+		/**
+			\brief The synchronising mutex for cvQueue.
+		*/
+		std::mutex mtxQueue;
+
+		/**
+			\brief The object to notify the processing thread of messages.
+		*/
+		std::condition_variable cvQueue;
+
+		/**
+			\brief true while the processing thread blocks on cvQueue.
+		*/
+		std::atomic<bool> isSleeping{ false };
+
+		/**
+			\brief Number of messages posted and not yet processed.
+		*/
+		std::atomic<std::size_t> pending{ 0 };
+
+		/**
+			\brief Number of threads waiting for the lanes to drain.
+		*/
+		std::atomic<std::size_t> drainWaiters{ 0 };
+
+		/**
+			\brief The synchronising mutex and the object to notify that the
+			lanes drained or the processing thread exited.
+		*/
+		std::mutex mtxDrained;
+		std::condition_variable cvDrained;
+
+		/**
+			\brief The bool variable which signals the thread to stop.
+		*/
+		std::atomic<bool> QueueStop{ false };
+
+		/**
+			\brief sets to true if the thread is active.
+		*/
+		std::atomic<bool> isQueueActive{ false };
+
+		/**
+			\brief true once the processing thread has exited.
+		*/
+		std::atomic<bool> isProcExited{ false };
+
+		/**
+			\brief The function which processes the instruction.
+		*/
+		processing_method msgProc;
+
+		/**
+			\brief The configuration the processing thread applies when it
+			starts, if any.
+		*/
+		std::optional<thread_config> threadConfig;
+
+		/**
+			\brief The thread handle.
+		*/
+		std::thread queue_thread;
+
+		/**
+			\brief Checks if any lane is marked.
+		*/
+		inline bool any_active() const noexcept
+		{
+			for (std::size_t i = 0; i < words; ++i)
+				if (active[i].load() != 0)
+					return true;
+			return false;
+		}
+
+		/**
+			\brief Marks a lane after a push and wakes the thread if it sleeps.
+		*/
+		inline void activate(
+			std::size_t index /**< : <i>in</i> : The lane.*/
+		) noexcept
+		{
+			std::uint64_t bit = std::uint64_t(1) << (index % 64);
+			std::atomic<std::uint64_t>& word = active[index / 64];
+			// orders the push before reading the bit, pairs with deactivate.
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if ((word.load(std::memory_order_relaxed) & bit) == 0)
+				word.fetch_or(bit);
+			if (isSleeping.load())
+			{
+				{ std::lock_guard<std::mutex> lock(mtxQueue); }
+				cvQueue.notify_one();
+			}
+		}
+
+		/**
+			\brief Unmarks an empty lane, marks it again if a push raced.
+		*/
+		inline void deactivate(
+			std::size_t index /**< : <i>in</i> : The lane.*/
+		) noexcept
+		{
+			std::uint64_t bit = std::uint64_t(1) << (index % 64);
+			std::atomic<std::uint64_t>& word = active[index / 64];
+			word.fetch_and(~bit);
+			if (!lanes[index]->ring.empty())
+				word.fetch_or(bit);
+		}
+
+		/**
+			\brief Marks count messages as processed, wakes the waiting
+			threads if that drained the lanes.
+		*/
+		inline void finish_messages(
+			std::size_t count /**< : <i>in</i> : Messages processed.*/
+		) noexcept
+		{
+			if (pending.fetch_sub(count) == count && drainWaiters.load() != 0)
+				notify_drained();
+		}
+
+		/**
+			\brief Wakes all threads waiting for the lanes to drain.
+		*/
+		inline void notify_drained() noexcept
+		{
+			{ std::lock_guard<std::mutex> lock(mtxDrained); }
+			cvDrained.notify_all();
+		}
+
+		/**
+			\brief Gives a lane its weight in credit and processes its
+			messages while credit lasts.
+
+			<h3>Return</h3>
+			false if processing function returned error.\n
+		*/
+		bool serve(
+			std::size_t index /**< : <i>in</i> : The lane.*/,
+			std::optional<info_type>& front /**< : <i>in</i> : Buffer.*/
+		)
+		{
+			lane& self = *lanes[index];
+			self.deficit += self.weight.load(std::memory_order_relaxed);
+			while (self.deficit != 0 && !QueueStop.load())
+			{
+				if (!self.ring.try_pop(front))
+					break;
+				--self.depth;
+				--self.deficit;
+				tristate ret = msgProc(index, std::move(*front));
+				front.reset();
+				finish_messages(1);
+				if (!ret)
+					return false;
+			}
+			if (self.ring.empty())
+			{
+				// an idle lane does not save credit.
+				self.deficit = 0;
+				deactivate(index);
+			}
+			return true;
+		}
+
+		/**
+			\brief Serves the marked lanes round after round until stopped.
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if processing function fails.\n
+		*/
+		tristate queue_exec_process() noexcept
+		{
+			O1_LIB_LOG_LINE;
+			std::optional<info_type> front;
+			while (!QueueStop.load())
+			{
+				O3_LIB_LOG_LINE;
+				bool served = false;
+				for (std::size_t i = 0; i < words && !QueueStop.load(); ++i)
+				{
+					std::uint64_t bits = active[i].load(std::memory_order_acquire);
+					while (bits != 0)
+					{
+						std::size_t index = i * 64 + countTrailingZeros(bits);
+						bits &= bits - 1;
+						served = true;
+						if (!serve(index, front))
+							return (tristate::ERROR);
+					}
+				}
+				if (served)
+					continue;
+				std::unique_lock<std::mutex> lock(mtxQueue);
+				isSleeping = true;
+				cvQueue.wait(lock, [this]() {
+					return QueueStop.load() || any_active();
+					});
+				isSleeping = false;
+			}
+			O4_LIB_LOG_LINE;
+			return (tristate::GOOD);
+		}
+
+		/**
+			\brief Runs queue_exec_process then wakes threads waiting for the
+			lanes to drain.
+		*/
+		void queue_thread_main() noexcept
+		{
+			if (threadConfig)
+				applyThreadConfig(*threadConfig);
+			queue_exec_process();
+			isProcExited = true;
+			notify_drained();
+		}
+
+	public:
+
+		/**
+			\brief Constructs with the procedure and the number of lanes.
+		*/
+		fair_process(
+			processing_method msg /**< : <i>in</i> : The procedure.*/,
+			std::size_t lane_count /**< : <i>in</i> : The number of lanes, at
+								   least 1.*/
+		) : words((std::max<std::size_t>(lane_count, 1) + 63) / 64),
+			msgProc(std::move(msg))
+		{
+			lane_count = std::max<std::size_t>(lane_count, 1);
+			for (std::size_t i = 0; i < lane_count; ++i)
+				lanes.emplace_back(std::make_unique<lane>());
+			active = std::make_unique<std::atomic<std::uint64_t>[]>(words);
+			for (std::size_t i = 0; i < words; ++i)
+				active[i].store(0, std::memory_order_relaxed);
+		}
+
+		fair_process(const fair_process&) = delete;
+
+		fair_process(fair_process&&) = delete;
+
+		fair_process& operator = (fair_process&&) = delete;
+
+		fair_process& operator = (const fair_process&) = delete;
+
+		/**
+			\brief The number of lanes.
+		*/
+		inline std::size_t lane_count() const noexcept { return lanes.size(); }
+
+		/**
+			\brief Sets the messages a lane may process per round, its share
+			of the thread against the other busy lanes.
+		*/
+		inline void setWeight(
+			std::size_t index /**< : <i>in</i> : The lane.*/,
+			std::size_t weight /**< : <i>in</i> : The weight, 0 is taken as 1.*/
+		) noexcept
+		{
+			lanes[index]->weight = weight ? weight : 1;
+		}
+
+		/**
+			\brief Sets the most messages a lane may have pending, posting to
+			a lane at its quota waits (or fails for try_postMessage).
+		*/
+		inline void setQuota(
+			std::size_t index /**< : <i>in</i> : The lane.*/,
+			std::size_t quota /**< : <i>in</i> : The quota, upto capacity.*/
+		) noexcept
+		{
+			lanes[index]->quota = std::clamp<std::size_t>(quota, 1, capacity);
+		}
+
+		/**
+			\brief The number of messages of a lane not yet taken.
+		*/
+		inline std::size_t lane_depth(
+			std::size_t index /**< : <i>in</i> : The lane.*/
+		) const noexcept
+		{
+			return lanes[index]->depth.load(std::memory_order_relaxed);
+		}
+
+		/**
+			\brief starts the processing thread.
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if no procedure was set, or it is
+			already running.\n
+		*/
+		tristate start_queue_process() noexcept
+		{
+			O3_LIB_LOG_LINE;
+			if (!msgProc)
+				return tristate::ERROR;
+			if (isQueueRunning())
+				return tristate::ERROR;
+			QueueStop = false;
+			isProcExited = false;
+			queue_thread = std::thread(&fair_process::queue_thread_main, this);
+			isQueueActive = true;
+			return (tristate::GOOD);
+		}
+
+		/**
+			\brief Starts the processing thread, which applies config first.
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if no procedure was set, or it is
+			running.\n
+		*/
+		tristate start_queue_process(
+			thread_config config /**< : <i>in</i> : The placement, scheduling
+								 and name of the thread.*/
+		) noexcept
+		{
+			if (isQueueRunning())
+				return tristate::ERROR;
+			threadConfig = std::move(config);
+			return start_queue_process();
+		}
+
+		/**
+			\brief Posts a message to a lane if it is below its quota.
+
+			<h3>Return</h3>
+			Returns false if the lane is at its quota, message is not
+			posted.\n
+		*/
+		bool try_postMessage(
+			std::size_t index /**< : <i>in</i> : The lane.*/,
+			info_type Message /**< : <i>in</i> : Message need to be pushed.*/
+		)
+		{
+			lane& target = *lanes[index];
+			if (target.depth.fetch_add(1) >= target.quota.load())
+			{
+				--target.depth;
+				return false;
+			}
+			++pending;
+			// depth below the quota leaves a slot, unless the consumer has
+			// not yet released the one it took.
+			while (!target.ring.try_push(std::move(Message)))
+				std::this_thread::yield();
+			activate(index);
+			return true;
+		}
+
+		/**
+			\brief Posts a message to a lane, waits while the lane is at its
+			quota.
+		*/
+		void postMessage(
+			std::size_t index /**< : <i>in</i> : The lane.*/,
+			info_type Message /**< : <i>in</i> : Message need to be pushed.*/
+		)
+		{
+			lane& target = *lanes[index];
+			while (target.depth.fetch_add(1) >= target.quota.load())
+			{
+				--target.depth;
+				std::this_thread::yield();
+			}
+			++pending;
+			while (!target.ring.try_push(std::move(Message)))
+				std::this_thread::yield();
+			activate(index);
+		}
+
+		/**
+			\brief The function to signal the thread to stop processing.
+		*/
+		inline void stopQueue() noexcept
+		{
+			QueueStop = true;
+			{ std::lock_guard<std::mutex> lock(mtxQueue); }
+			cvQueue.notify_all();
+		}
+
+		/**
+			\brief Checks if it is running.
+		*/
+		inline bool isQueueRunning() noexcept { return isQueueActive.load(); }
+
+		/**
+			\brief Checks if the processing thread has exited and was not yet
+			joined.
+		*/
+		inline bool isQueueExited() noexcept { return isProcExited.load(); }
+
+		/**
+			\brief Waits till the thread stops execution. Then empties lanes.
+		*/
+		inline void WaitForQueueStop() noexcept
+		{
+			if (!isQueueRunning())
+				return;
+			O3_LIB_LOG_LINE;
+			if (queue_thread.joinable())
+				queue_thread.join();
+			O4_LIB_LOG_LINE;
+			std::optional<info_type> temp;
+			for (std::size_t i = 0; i < lanes.size(); ++i)
+			{
+				while (lanes[i]->ring.try_pop(temp))
+					--lanes[i]->depth;
+				temp.reset();
+				lanes[i]->deficit = 0;
+				deactivate(i);
+			}
+			pending = 0;
+			isProcExited = false;
+			isQueueActive = false;
+			QueueStop = false;
+			notify_drained();
+		}
+
+		/**
+			\brief The function to wait till every message posted is
+			processed, the processing thread exits or the deadline is reached.
+
+			<h3>Return</h3>
+			true if all messages posted were processed.\n
+		*/
+		template<class Clock, class Duration>
+		inline bool WaitForQueueEmpty(
+			const std::chrono::time_point<Clock, Duration>& deadline /**< :
+							<i>in</i> : The time to stop waiting at.*/
+		)
+		{
+			++drainWaiters;
+			{
+				std::unique_lock<std::mutex> lock(mtxDrained);
+				cvDrained.wait_until(lock, deadline, [this]() {
+					return pending.load() == 0 || isProcExited.load();
+					});
+			}
+			--drainWaiters;
+			return pending.load() == 0;
+		}
+
+		/**
+			\brief Waits till all messages are processed or deadline is
+			reached then stops and joins.
+
+			<h3>Return</h3>
+			true if all messages were processed before stopping.\n
+		*/
+		template<class Clock, class Duration>
+		inline bool safe_join(
+			const std::chrono::time_point<Clock, Duration>& deadline /**< :
+							<i>in</i> : The time to stop waiting at.*/
+		)
+		{
+			if (!isQueueRunning())
+				return pending.load() == 0;
+			bool drained = WaitForQueueEmpty(deadline);
+			stopQueue();
+			WaitForQueueStop();
+			return drained;
+		}
+
+		/**
+			\brief Signals stop then waits for the thread to join.
+
+			<b>Note</b> : Even if lanes have messages left over, it will exit
+			and messages will be destroyed.
+		*/
+		inline void force_join()
+		{
+			if (!isQueueRunning())
+				return;
+			stopQueue();
+			WaitForQueueStop();
+		}
+
+		/**
+			\brief The destructor. Exits without waiting for lanes to empty.
+		*/
+		~fair_process()
+		{
+			force_join();
+		}
+	};
+}
+
+#endif // !FAIR_QUEUE_ENH_H
@@ -0,0 +1,256 @@
+/** ***************************************************************************
+	\file fast_clock.enh.h
+
+	\brief The file to declare cheap clocks for hot path time stamps
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef FAST_CLOCK_ENH_H
+
+#define FAST_CLOCK_ENH_H					fast_clock.enh.h
+
+#include "timer.enh.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define ENH_HAS_TSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define ENH_HAS_TSC
+#endif
+
+namespace enh
+{
+
+	/**
+		\brief The clock that returns a time stamp cached by the shared
+		timer_service, read with one relaxed atomic load.
+
+		Call start to choose the resolution (1 ms by default), until then
+		now falls back to high_res::now(). The time is at most one
+		resolution (plus scheduling delay of the service thread) behind
+		high_res.\n\n
+
+		Meets the requirements of a clock with time_point enh::time_pt, so
+		it can be used wherever an enh::time_pt is accepted.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class coarse_clock
+	{
+		/**
+			\brief The cached time since the epoch of high_res, 0 if not
+			started.
+		*/
+		static inline std::atomic<high_res::rep> stamp{ 0 };
+
+		/**
+			\brief The timer refreshing stamp.
+		*/
+		static callback_timer& updater()
+		{
+			static callback_timer tick;
+			return tick;
+		}
+
+		static inline std::mutex control;
+
+	public:
+
+		using duration = high_res::duration;
+		using rep = duration::rep;
+		using period = duration::period;
+		using time_point = time_pt;
+		static constexpr bool is_steady = high_res::is_steady;
+
+		/**
+			\brief The cached time.
+		*/
+		static inline time_point now() noexcept
+		{
+			rep at = stamp.load(std::memory_order_relaxed);
+			if (at == 0)
+				return high_res::now();
+			return time_point(duration(at));
+		}
+
+		/**
+			\brief Starts (or restarts) refreshing the cached time every
+			resolution.
+		*/
+		template<class Rep = long long, class Period = std::milli>
+		static void start(
+			std::chrono::duration<Rep, Period> resolution
+				= std::chrono::milliseconds(1) /**< : <i>in</i> : The
+											   resolution.*/
+		)
+		{
+			std::lock_guard<std::mutex> guard(control);
+			updater().cancel();
+			stamp.store(high_res::now().time_since_epoch().count(),
+				std::memory_order_relaxed);
+			updater().start_every(resolution, []() {
+				stamp.store(high_res::now().time_since_epoch().count(),
+					std::memory_order_relaxed);
+			});
+		}
+
+		/**
+			\brief Stops refreshing, now falls back to high_res::now().
+		*/
+		static void stop()
+		{
+			std::lock_guard<std::mutex> guard(control);
+			updater().cancel();
+			stamp.store(0, std::memory_order_relaxed);
+		}
+	};
+
+	/**
+		\brief The clock that reads the processor time stamp counter,
+		calibrated against high_res.
+
+		On x86 now is one rdtsc and a multiply. The first use calibrates
+		for 10 ms, call calibrate earlier (or again with a longer window for
+		more accuracy) to avoid that pause on the hot path. Needs an
+		invariant TSC (all x86 of the last decade), else and on other
+		processors now is high_res::now().\n\n
+
+		Meets the requirements of a clock with time_point enh::time_pt.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class tsc_clock
+	{
+		/**
+			\brief The calibration, replaced whole by calibrate.
+		*/
+		struct calibration
+		{
+			std::uint64_t tsc0 = 0;
+			high_res::rep base = 0;
+			double perTick = 0.0;
+		};
+
+		static inline std::atomic<calibration*> current{ nullptr };
+
+		static inline std::mutex control;
+
+		static inline std::uint64_t read() noexcept
+		{
+#ifdef ENH_HAS_TSC
+			return __rdtsc();
+#else
+			return 0;
+#endif
+		}
+
+		static calibration measure(std::chrono::nanoseconds window) noexcept
+		{
+			calibration cal;
+			time_pt t0 = high_res::now();
+			std::uint64_t c0 = read();
+			std::this_thread::sleep_for(window);
+			time_pt t1 = high_res::now();
+			std::uint64_t c1 = read();
+			cal.tsc0 = c1;
+			cal.base = t1.time_since_epoch().count();
+			cal.perTick = (c1 > c0) ? static_cast<double>(std::chrono::duration_cast<
+				duration>(t1 - t0).count()) / static_cast<double>(c1 - c0) : 0.0;
+			return cal;
+		}
+
+		/**
+			\brief The calibration made by the first now, in static storage
+			and without control so that now cannot throw.
+		*/
+		static calibration* first() noexcept
+		{
+			static calibration initial = measure(std::chrono::milliseconds(10));
+			calibration* none = nullptr;
+			// a calibrate that finished meanwhile is kept.
+			current.compare_exchange_strong(none, &initial, std::memory_order_acq_rel);
+			return current.load(std::memory_order_acquire);
+		}
+
+	public:
+
+		using duration = high_res::duration;
+		using rep = duration::rep;
+		using period = duration::period;
+		using time_point = time_pt;
+		static constexpr bool is_steady = false;
+
+		/**
+			\brief true if the processor counter is used.
+		*/
+		static constexpr bool uses_tsc =
+#ifdef ENH_HAS_TSC
+			true;
+#else
+			false;
+#endif
+
+		/**
+			\brief Calibrates against high_res for window, blocking for it.
+			May throw std::bad_alloc or std::system_error.
+
+			The previous calibration is kept alive (a few bytes) so that
+			concurrent now calls stay valid.
+		*/
+		template<class Rep = long long, class Period = std::milli>
+		static void calibrate(
+			std::chrono::duration<Rep, Period> window
+				= std::chrono::milliseconds(10) /**< : <i>in</i> : The time
+												to measure over.*/
+		)
+		{
+			std::lock_guard<std::mutex> guard(control);
+			current.store(new calibration(measure(std::chrono::duration_cast<
+				std::chrono::nanoseconds>(window))), std::memory_order_release);
+		}
+
+		/**
+			\brief The time from the processor counter.
+		*/
+		static inline time_point now() noexcept
+		{
+			if (!uses_tsc)
+				return high_res::now();
+			calibration* cal = current.load(std::memory_order_acquire);
+			if (!cal)
+				cal = first();
+			if (cal->perTick <= 0.0)
+				return high_res::now();
+			std::uint64_t ticks = read() - cal->tsc0;
+			return time_point(duration(cal->base
+				+ static_cast<rep>(static_cast<double>(ticks) * cal->perTick)));
+		}
+	};
+}
+
+#endif
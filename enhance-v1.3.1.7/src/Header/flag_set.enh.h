@@ -0,0 +1,600 @@
+/** ***************************************************************************
+	\file flag_set.enh.h
+
+	\brief The file to declare class flag_set and atomic_flag_set, bit masks
+	of an enumeration or integral type
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef FLAG_SET_ENH_H
+
+#define FLAG_SET_ENH_H					flag_set.enh.h
+
+#include "general.enh.h"
+
+#include <atomic>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace enh
+{
+
+	namespace detail
+	{
+		template<class T, bool isEnum = std::is_enum_v<T>>
+		struct flag_bits
+		{
+			using type = std::make_unsigned_t<std::underlying_type_t<T>>;
+		};
+
+		template<class T>
+		struct flag_bits<T, false>
+		{
+			static_assert(std::is_integral_v<T>, "flag_set should have enum or integral type");
+			using type = std::make_unsigned_t<T>;
+		};
+	}
+
+	/**
+		\brief The class for a set of flags of an enumeration (or integral)
+		type whose values are bit masks, held as one unsigned integer.
+
+		Every operation is constexpr and a single integer operation, the set
+		bits are iterated lowest first through countTrailingZeros. The free
+		functions anyOf, allOf, noneOf, countOf, unionOf and intersectionOf
+		test many masks at once with one loop of or / and reductions that
+		the compiler vectorises. checkField(base, toCheckFor) is
+		flag_set(base).hasAll(toCheckFor).\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>template</h3>
+		-#  <code>Enum</code> : The enumeration or integral type.\n
+	*/
+	template<class Enum>
+	class flag_set
+	{
+	public:
+
+		/**
+			\brief The unsigned integer holding the bits.
+		*/
+		using bits_type = typename detail::flag_bits<Enum>::type;
+
+		using value_type = Enum;
+
+		/**
+			\brief The set itself, for parameters not deduced from.
+		*/
+		using set_type = flag_set;
+
+	private:
+
+		bits_type bits = 0;
+
+		static constexpr inline bits_type raw(Enum e) noexcept
+		{
+			return static_cast<bits_type>(e);
+		}
+
+	public:
+
+		/**
+			\brief The iterator over the single bit values of the set,
+			lowest first.
+		*/
+		class iterator
+		{
+			bits_type rest = 0;
+
+			friend class flag_set;
+
+			constexpr inline explicit iterator(bits_type r) noexcept : rest(r) {}
+
+		public:
+
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = Enum;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+			using reference = Enum;
+
+			constexpr inline iterator() noexcept = default;
+
+			/**
+				\brief The lowest remaining bit.
+			*/
+			constexpr inline Enum operator * () const noexcept
+			{
+				return static_cast<Enum>(static_cast<bits_type>(rest & (0 - rest)));
+			}
+
+			/**
+				\brief The index of the lowest remaining bit.
+			*/
+			constexpr inline unsigned index() const noexcept
+			{
+				return countTrailingZeros(rest);
+			}
+
+			constexpr inline iterator& operator ++ () noexcept
+			{
+				rest = static_cast<bits_type>(rest & (rest - 1));
+				return *this;
+			}
+
+			constexpr inline iterator operator ++ (int) noexcept
+			{
+				iterator it = *this;
+				++(*this);
+				return it;
+			}
+
+			friend constexpr inline bool operator == (const iterator& lhs,
+				const iterator& rhs) noexcept { return lhs.rest == rhs.rest; }
+			friend constexpr inline bool operator != (const iterator& lhs,
+				const iterator& rhs) noexcept { return lhs.rest != rhs.rest; }
+		};
+
+		/**
+			\brief An empty set.
+		*/
+		constexpr inline flag_set() noexcept = default;
+
+		/**
+			\brief The set of the bits of e.
+		*/
+		constexpr inline flag_set(
+			Enum e /**< : <i>in</i> : The flags.*/
+		) noexcept : bits(raw(e)) {}
+
+		/**
+			\brief The set of the bits b.
+		*/
+		static constexpr inline flag_set fromBits(
+			bits_type b /**< : <i>in</i> : The bits.*/
+		) noexcept
+		{
+			flag_set s;
+			s.bits = b;
+			return s;
+		}
+
+		/**
+			\brief The bits.
+		*/
+		constexpr inline bits_type getBits() const noexcept { return bits; }
+
+		/**
+			\brief The flags as Enum.
+		*/
+		constexpr inline Enum get() const noexcept { return static_cast<Enum>(bits); }
+
+		/**
+			\brief Checks if every bit of f is set.
+		*/
+		constexpr inline bool hasAll(
+			flag_set f /**< : <i>in</i> : The flags.*/
+		) const noexcept
+		{
+			return (bits & f.bits) == f.bits;
+		}
+
+		/**
+			\brief Checks if any bit of f is set.
+		*/
+		constexpr inline bool hasAny(
+			flag_set f /**< : <i>in</i> : The flags.*/
+		) const noexcept
+		{
+			return (bits & f.bits) != 0;
+		}
+
+		/**
+			\brief Checks if no bit of f is set.
+		*/
+		constexpr inline bool hasNone(
+			flag_set f /**< : <i>in</i> : The flags.*/
+		) const noexcept
+		{
+			return (bits & f.bits) == 0;
+		}
+
+		/**
+			\brief Checks if no bit is set.
+		*/
+		constexpr inline bool empty() const noexcept { return bits == 0; }
+
+		constexpr inline explicit operator bool() const noexcept { return bits != 0; }
+
+		/**
+			\brief The number of bits set.
+		*/
+		constexpr inline unsigned count() const noexcept { return popCount(bits); }
+
+		/**
+			\brief The lowest bit set, empty if none.
+		*/
+		constexpr inline flag_set lowest() const noexcept
+		{
+			return fromBits(static_cast<bits_type>(bits & (0 - bits)));
+		}
+
+		/**
+			\brief Sets the bits of f.
+		*/
+		constexpr inline flag_set& set(
+			flag_set f /**< : <i>in</i> : The flags.*/
+		) noexcept
+		{
+			bits = static_cast<bits_type>(bits | f.bits);
+			return *this;
+		}
+
+		/**
+			\brief Clears the bits of f.
+		*/
+		constexpr inline flag_set& reset(
+			flag_set f /**< : <i>in</i> : The flags.*/
+		) noexcept
+		{
+			bits = static_cast<bits_type>(bits & ~f.bits);
+			return *this;
+		}
+
+		/**
+			\brief Clears every bit.
+		*/
+		constexpr inline flag_set& reset() noexcept
+		{
+			bits = 0;
+			return *this;
+		}
+
+		/**
+			\brief Toggles the bits of f.
+		*/
+		constexpr inline flag_set& flip(
+			flag_set f /**< : <i>in</i> : The flags.*/
+		) noexcept
+		{
+			bits = static_cast<bits_type>(bits ^ f.bits);
+			return *this;
+		}
+
+		/**
+			\brief Calls fn(Enum) for each bit set, lowest first.
+		*/
+		template<class Fn>
+		constexpr inline void forEach(
+			Fn&& fn /**< : <i>in</i> : The function.*/
+		) const
+		{
+			for (bits_type rest = bits; rest != 0; rest = static_cast<bits_type>(rest & (rest - 1)))
+				fn(static_cast<Enum>(static_cast<bits_type>(rest & (0 - rest))));
+		}
+
+		constexpr inline iterator begin() const noexcept { return iterator(bits); }
+
+		constexpr inline iterator end() const noexcept { return iterator(0); }
+
+		constexpr inline flag_set& operator |= (flag_set f) noexcept { return set(f); }
+
+		constexpr inline flag_set& operator &= (flag_set f) noexcept
+		{
+			bits = static_cast<bits_type>(bits & f.bits);
+			return *this;
+		}
+
+		constexpr inline flag_set& operator ^= (flag_set f) noexcept { return flip(f); }
+
+		constexpr inline flag_set operator ~ () const noexcept
+		{
+			return fromBits(static_cast<bits_type>(~bits));
+		}
+
+		friend constexpr inline flag_set operator | (flag_set lhs, flag_set rhs) noexcept
+		{
+			return lhs |= rhs;
+		}
+
+		friend constexpr inline flag_set operator & (flag_set lhs, flag_set rhs) noexcept
+		{
+			return lhs &= rhs;
+		}
+
+		friend constexpr inline flag_set operator ^ (flag_set lhs, flag_set rhs) noexcept
+		{
+			return lhs ^= rhs;
+		}
+
+		friend constexpr inline bool operator == (flag_set lhs, flag_set rhs) noexcept
+		{
+			return lhs.bits == rhs.bits;
+		}
+
+		friend constexpr inline bool operator != (flag_set lhs, flag_set rhs) noexcept
+		{
+			return lhs.bits != rhs.bits;
+		}
+	};
+
+	/**
+		\brief Checks if any of the n masks has any bit of f.
+	*/
+	template<class Enum>
+	constexpr inline bool anyOf(
+		const flag_set<Enum>* masks /**< : <i>in</i> : The masks.*/,
+		std::size_t n /**< : <i>in</i> : The number of masks.*/,
+		typename flag_set<Enum>::set_type f /**< : <i>in</i> : The flags.*/
+	) noexcept
+	{
+		typename flag_set<Enum>::bits_type acc = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			acc = static_cast<decltype(acc)>(acc | masks[i].getBits());
+		return (acc & f.getBits()) != 0;
+	}
+
+	/**
+		\brief Checks if all of the n masks have every bit of f, true if n
+		is 0.
+	*/
+	template<class Enum>
+	constexpr inline bool allOf(
+		const flag_set<Enum>* masks /**< : <i>in</i> : The masks.*/,
+		std::size_t n /**< : <i>in</i> : The number of masks.*/,
+		typename flag_set<Enum>::set_type f /**< : <i>in</i> : The flags.*/
+	) noexcept
+	{
+		typename flag_set<Enum>::bits_type acc = static_cast<decltype(acc)>(~0ULL);
+		for (std::size_t i = 0; i < n; ++i)
+			acc = static_cast<decltype(acc)>(acc & masks[i].getBits());
+		return (acc & f.getBits()) == f.getBits();
+	}
+
+	/**
+		\brief Checks if none of the n masks has any bit of f.
+	*/
+	template<class Enum>
+	constexpr inline bool noneOf(
+		const flag_set<Enum>* masks /**< : <i>in</i> : The masks.*/,
+		std::size_t n /**< : <i>in</i> : The number of masks.*/,
+		typename flag_set<Enum>::set_type f /**< : <i>in</i> : The flags.*/
+	) noexcept
+	{
+		return !anyOf(masks, n, f);
+	}
+
+	/**
+		\brief The number of the n masks having every bit of f.
+	*/
+	template<class Enum>
+	constexpr inline std::size_t countOf(
+		const flag_set<Enum>* masks /**< : <i>in</i> : The masks.*/,
+		std::size_t n /**< : <i>in</i> : The number of masks.*/,
+		typename flag_set<Enum>::set_type f /**< : <i>in</i> : The flags.*/
+	) noexcept
+	{
+		std::size_t count = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			count += static_cast<std::size_t>((masks[i].getBits() & f.getBits()) == f.getBits());
+		return count;
+	}
+
+	/**
+		\brief The bits set in any of the n masks.
+	*/
+	template<class Enum>
+	constexpr inline flag_set<Enum> unionOf(
+		const flag_set<Enum>* masks /**< : <i>in</i> : The masks.*/,
+		std::size_t n /**< : <i>in</i> : The number of masks.*/
+	) noexcept
+	{
+		typename flag_set<Enum>::bits_type acc = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			acc = static_cast<decltype(acc)>(acc | masks[i].getBits());
+		return flag_set<Enum>::fromBits(acc);
+	}
+
+	/**
+		\brief The bits set in all of the n masks, every bit if n is 0.
+	*/
+	template<class Enum>
+	constexpr inline flag_set<Enum> intersectionOf(
+		const flag_set<Enum>* masks /**< : <i>in</i> : The masks.*/,
+		std::size_t n /**< : <i>in</i> : The number of masks.*/
+	) noexcept
+	{
+		typename flag_set<Enum>::bits_type acc = static_cast<decltype(acc)>(~0ULL);
+		for (std::size_t i = 0; i < n; ++i)
+			acc = static_cast<decltype(acc)>(acc & masks[i].getBits());
+		return flag_set<Enum>::fromBits(acc);
+	}
+
+	/**
+		\brief The class for a flag_set changed by many threads, one atomic
+		integer.
+
+		Every change is one atomic read-modify-write, testAndSet and
+		testAndReset of a single bit compile to one locked bit test
+		instruction (lock bts / btr) on x86. Each function takes the memory
+		order, seq_cst by default, an order a load or store cannot take is
+		mapped by load_order or store_order.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	template<class Enum>
+	class atomic_flag_set
+	{
+	public:
+
+		using set_type = flag_set<Enum>;
+		using bits_type = typename set_type::bits_type;
+
+	private:
+
+		std::atomic<bits_type> bits{ 0 };
+
+	public:
+
+		/**
+			\brief An empty set.
+		*/
+		constexpr inline atomic_flag_set() noexcept = default;
+
+		/**
+			\brief The set of the bits of f.
+		*/
+		constexpr inline atomic_flag_set(
+			set_type f /**< : <i>in</i> : The flags.*/
+		) noexcept : bits(f.getBits()) {}
+
+		atomic_flag_set(const atomic_flag_set&) = delete;
+		atomic_flag_set& operator = (const atomic_flag_set&) = delete;
+
+		/**
+			\brief The flags set.
+		*/
+		inline set_type load(
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the load.*/
+		) const noexcept
+		{
+			return set_type::fromBits(bits.load(load_order(order)));
+		}
+
+		/**
+			\brief Replaces the flags with f.
+		*/
+		inline void store(
+			set_type f /**< : <i>in</i> : The flags.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the store.*/
+		) noexcept
+		{
+			bits.store(f.getBits(), store_order(order));
+		}
+
+		/**
+			\brief Checks if every bit of f is set.
+		*/
+		inline bool test(
+			set_type f /**< : <i>in</i> : The flags.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order of the load.*/
+		) const noexcept
+		{
+			return load(order).hasAll(f);
+		}
+
+		/**
+			\brief Sets the bits of f.
+
+			<h3>Return</h3>
+			The flags before.\n
+		*/
+		inline set_type set(
+			set_type f /**< : <i>in</i> : The flags.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order.*/
+		) noexcept
+		{
+			return set_type::fromBits(bits.fetch_or(f.getBits(), order));
+		}
+
+		/**
+			\brief Clears the bits of f.
+
+			<h3>Return</h3>
+			The flags before.\n
+		*/
+		inline set_type reset(
+			set_type f /**< : <i>in</i> : The flags.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order.*/
+		) noexcept
+		{
+			return set_type::fromBits(bits.fetch_and(static_cast<bits_type>(~f.getBits()), order));
+		}
+
+		/**
+			\brief Toggles the bits of f.
+
+			<h3>Return</h3>
+			The flags before.\n
+		*/
+		inline set_type flip(
+			set_type f /**< : <i>in</i> : The flags.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order.*/
+		) noexcept
+		{
+			return set_type::fromBits(bits.fetch_xor(f.getBits(), order));
+		}
+
+		/**
+			\brief Sets the bits of f.
+
+			<h3>Return</h3>
+			true if all of them were set before.\n
+		*/
+		inline bool testAndSet(
+			set_type f /**< : <i>in</i> : The flags.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order.*/
+		) noexcept
+		{
+			return (bits.fetch_or(f.getBits(), order) & f.getBits()) == f.getBits();
+		}
+
+		/**
+			\brief Clears the bits of f.
+
+			<h3>Return</h3>
+			true if any of them was set before.\n
+		*/
+		inline bool testAndReset(
+			set_type f /**< : <i>in</i> : The flags.*/,
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order.*/
+		) noexcept
+		{
+			return (bits.fetch_and(static_cast<bits_type>(~f.getBits()), order) & f.getBits()) != 0;
+		}
+
+		/**
+			\brief Clears every bit.
+
+			<h3>Return</h3>
+			The flags before.\n
+		*/
+		inline set_type clear(
+			std::memory_order order = std::memory_order_seq_cst /**< : <i>in</i>
+										: The memory order.*/
+		) noexcept
+		{
+			return set_type::fromBits(bits.exchange(0, order));
+		}
+	};
+}
+
+#endif
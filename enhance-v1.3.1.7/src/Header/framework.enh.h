@@ -1,7 +1,8 @@
 /** ***************************************************************************
 	\file framework.enh.h
 
-	\brief The file to declare version and the version info class
+	\brief The file to declare version and the version info class, and the
+	processor feature probe and kernel dispatch
 
 	Created 10 April 2020
 
@@ -42,7 +43,36 @@
 #define VERSION_INFO_FIN(mj,mn,re,bl)		mj,mn,re,bl,enh::rel_type::RELEASE\
 											,#mj "." #mn "." #re "." #bl ".fin"
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <utility>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+/**
+	\brief Defined where kernels can be compiled for x86 extensions beyond
+	the build flags, with ENH_TARGET.
+*/
+#define ENH_TARGET_X86
+/**
+	\brief Compiles a function for the listed extensions ("avx2", 
+	"avx512f,avx512bw"), to be called only where cpu_features has them.
+	Loops inlined into it are widened where the build vectorises (-O3 on
+	GCC, -O2 on Clang).
+*/
+#define ENH_TARGET(features)				__attribute__((target(features)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define ENH_TARGET(features)
+#else
+#define ENH_TARGET(features)
+#endif
+
+#if defined(__linux__) && defined(__arm__) && !defined(__aarch64__)
+#include <sys/auxv.h>
+#endif
 
 /**
 	\brief The namespace for all the functions and classes of this library.
@@ -249,6 +279,256 @@ namespace enh
 		\brief The version of enhance library.
 	*/
 	constexpr version_info enhance_version = version_info(VERSION_INFO_FIN(1,3,1,7));
+
+	/**
+		\brief The processor extensions cpu_features reports, as bits.
+	*/
+	namespace cpu_feature
+	{
+		constexpr std::uint32_t sse2 = 1U << 0;
+		constexpr std::uint32_t sse41 = 1U << 1;
+		constexpr std::uint32_t sse42 = 1U << 2;
+		constexpr std::uint32_t popcnt = 1U << 3;
+		constexpr std::uint32_t avx = 1U << 4;
+		constexpr std::uint32_t avx2 = 1U << 5;
+		constexpr std::uint32_t fma = 1U << 6;
+		constexpr std::uint32_t bmi2 = 1U << 7;
+		constexpr std::uint32_t avx512f = 1U << 8;
+		constexpr std::uint32_t avx512bw = 1U << 9;
+		constexpr std::uint32_t avx512vl = 1U << 10;
+		constexpr std::uint32_t neon = 1U << 16;
+	}
+
+	/**
+		\brief Reads the extensions of this processor that the operating 
+		system also enables (the AVX and AVX-512 registers saved on a 
+		switch), see cpu_features for the cached result.
+	*/
+	inline std::uint32_t detect_cpu_features() noexcept
+	{
+		std::uint32_t f = 0;
+#if defined(ENH_TARGET_X86) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+		unsigned r[4] = { 0, 0, 0, 0 };
+		auto cpuid = [&r](unsigned leaf, unsigned sub) {
+#if defined(_MSC_VER)
+			int out[4];
+			__cpuidex(out, static_cast<int>(leaf), static_cast<int>(sub));
+			for (int i = 0; i < 4; ++i)
+				r[i] = static_cast<unsigned>(out[i]);
+#else
+			__cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+		};
+		cpuid(0, 0);
+		unsigned maxLeaf = r[0];
+		if (maxLeaf < 1)
+			return f;
+		cpuid(1, 0);
+		unsigned c1 = r[2], d1 = r[3];
+		std::uint64_t xcr0 = 0;
+		if (c1 & (1U << 27))
+		{
+#if defined(_MSC_VER)
+			xcr0 = _xgetbv(0);
+#else
+			unsigned lo = 0, hi = 0;
+			__asm__ volatile ("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+			xcr0 = (static_cast<std::uint64_t>(hi) << 32) | lo;
+#endif
+		}
+		bool ymm = (xcr0 & 0x6) == 0x6;
+		bool zmm = (xcr0 & 0xe6) == 0xe6;
+		if (d1 & (1U << 26))
+			f |= cpu_feature::sse2;
+		if (c1 & (1U << 19))
+			f |= cpu_feature::sse41;
+		if (c1 & (1U << 20))
+			f |= cpu_feature::sse42;
+		if (c1 & (1U << 23))
+			f |= cpu_feature::popcnt;
+		if (ymm && (c1 & (1U << 28)))
+			f |= cpu_feature::avx;
+		if (ymm && (c1 & (1U << 12)))
+			f |= cpu_feature::fma;
+		if (maxLeaf >= 7)
+		{
+			cpuid(7, 0);
+			unsigned b7 = r[1];
+			if (ymm && (b7 & (1U << 5)))
+				f |= cpu_feature::avx2;
+			if (b7 & (1U << 8))
+				f |= cpu_feature::bmi2;
+			if (zmm && (b7 & (1U << 16)))
+				f |= cpu_feature::avx512f;
+			if (zmm && (b7 & (1U << 30)))
+				f |= cpu_feature::avx512bw;
+			if (zmm && (b7 & (1U << 31)))
+				f |= cpu_feature::avx512vl;
+		}
+#elif defined(__aarch64__) || defined(_M_ARM64)
+		f |= cpu_feature::neon;
+#elif defined(__linux__) && defined(__arm__)
+		if (getauxval(AT_HWCAP) & (1UL << 12))
+			f |= cpu_feature::neon;
+#endif
+		return f;
+	}
+
+	/**
+		\brief The mask cpu_features is limited to, see 
+		limit_cpu_features.
+	*/
+	inline std::atomic<std::uint32_t> cpu_feature_mask{ ~0U };
+
+	/**
+		\brief The extensions of this processor, probed once, as 
+		cpu_feature bits.
+	*/
+	inline std::uint32_t cpu_features() noexcept
+	{
+		static const std::uint32_t found = detect_cpu_features();
+		return found & cpu_feature_mask.load(std::memory_order_relaxed);
+	}
+
+	/**
+		\brief Hides the extensions not in mask from cpu_features, to run 
+		(and test) the lower kernels on one machine. Dispatchers already 
+		resolved keep their kernel, call before the first use or 
+		cpu_dispatch::reset them.
+	*/
+	inline void limit_cpu_features(
+		std::uint32_t mask /**< : <i>in</i> : The cpu_feature bits kept.*/
+	) noexcept
+	{
+		cpu_feature_mask.store(mask, std::memory_order_relaxed);
+	}
+
+	/**
+		\brief A kernel of a cpu_dispatch, with the cpu_feature bits it
+		needs.
+	*/
+	template<class Fn>
+	struct cpu_kernel
+	{
+		/**
+			\brief The cpu_feature bits the kernel is compiled for.
+		*/
+		std::uint32_t needs;
+
+		/**
+			\brief The kernel.
+		*/
+		Fn* fn;
+	};
+
+	/**
+		\brief The class to call the best of a list of kernels for this 
+		processor, through one function pointer resolved at first use.
+
+		The list is ordered best first and ends with a kernel needing 
+		nothing, the first whose needs cpu_features has is taken. Declare 
+		the list and the dispatcher static (constant initialised, so no
+		guard on each call):\n
+
+		<code>static constexpr cpu_kernel<fn_t> kernels[] = { { 
+		cpu_feature::avx2, &sum_avx2 }, { 0, &sum } };\n
+		static cpu_dispatch<fn_t> sum_best(kernels);</code>\n\n
+
+		Kernels for an extension beyond the build flags are compiled with
+		ENH_TARGET("avx2") and the like (GCC and Clang on x86), elsewhere
+		the list is only the portable kernel.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>template</h3>
+		-#  <code>class Fn</code> : The function type of the kernels.\n
+	*/
+	template<class Fn>
+	class cpu_dispatch
+	{
+		/**
+			\brief The kernel taken, nullptr till the first call.
+		*/
+		std::atomic<Fn*> chosen;
+
+		/**
+			\brief The kernels, best first.
+		*/
+		const cpu_kernel<Fn>* kernels;
+
+		/**
+			\brief The number of kernels.
+		*/
+		std::size_t count;
+
+	public:
+
+		/**
+			\brief Constructs over list, which must outlive it.
+		*/
+		template<std::size_t n>
+		constexpr inline cpu_dispatch(
+			const cpu_kernel<Fn> (&list)[n] /**< : <i>in</i> : The kernels,
+											best first.*/
+		) noexcept : chosen(nullptr), kernels(list), count(n) {}
+
+		cpu_dispatch(const cpu_dispatch&) = delete;
+
+		cpu_dispatch& operator = (const cpu_dispatch&) = delete;
+
+		/**
+			\brief The kernel for this processor, resolved on the first 
+			call (racing first calls resolve the same kernel).
+		*/
+		inline Fn* get() noexcept
+		{
+			Fn* fn = chosen.load(std::memory_order_relaxed);
+			if (fn)
+				return fn;
+			std::uint32_t have = cpu_features();
+			fn = kernels[count - 1].fn;
+			for (std::size_t i = 0; i < count; ++i)
+				if ((kernels[i].needs & have) == kernels[i].needs)
+				{
+					fn = kernels[i].fn;
+					break;
+				}
+			chosen.store(fn, std::memory_order_relaxed);
+			return fn;
+		}
+
+		/**
+			\brief The cpu_feature bits of the kernel get returns.
+		*/
+		inline std::uint32_t needs() noexcept
+		{
+			Fn* fn = get();
+			for (std::size_t i = 0; i < count; ++i)
+				if (kernels[i].fn == fn)
+					return kernels[i].needs;
+			return 0;
+		}
+
+		/**
+			\brief Resolves the kernel again on the next call, after 
+			limit_cpu_features.
+		*/
+		inline void reset() noexcept
+		{
+			chosen.store(nullptr, std::memory_order_relaxed);
+		}
+
+		/**
+			\brief Calls the kernel with args.
+		*/
+		template<class... Args>
+		inline decltype(auto) operator () (
+			Args&&... args /**< : <i>in</i> : The arguments.*/
+		)
+		{
+			return get()(std::forward<Args>(args)...);
+		}
+	};
 }
 
 
@@ -33,10 +33,129 @@
 #include <atomic>
 #include <type_traits>
 #include <string>
-
+#include <string_view>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace enh
 {
+	/**
+		\brief The assumed size of a cache line in bytes.
+
+		Used to pad data that is written concurrently by different threads so
+		that they do not share a cache line (false sharing).
+	*/
+	constexpr std::size_t cache_line_size = 64;
+
+	/**
+		\brief The shard of the calling thread, threads are assigned shards
+		in turn at their first call.
+	*/
+	inline std::size_t threadShard() noexcept
+	{
+		static std::atomic<std::size_t> next{ 0 };
+		thread_local std::size_t shard = next.fetch_add(1, std::memory_order_relaxed);
+		return shard;
+	}
+
+	/**
+		\brief The number of high bits of value.
+
+		Uses the popcnt builtin where the compiler has one (a single
+		instruction with -mpopcnt or /arch:AVX), a constexpr bit count
+		otherwise and in constant expressions.
+	*/
+	template<class integral>
+	constexpr inline unsigned popCount(
+		integral value /**< : <i>in</i> : The value.*/
+	) noexcept
+	{
+		static_assert(std::is_integral_v<integral>, "popCount is for integral types");
+		auto bits = static_cast<std::make_unsigned_t<integral>>(value);
+#if defined(__GNUC__) || defined(__clang__)
+		if constexpr (sizeof(bits) <= sizeof(unsigned))
+			return static_cast<unsigned>(__builtin_popcount(bits));
+		else
+			return static_cast<unsigned>(__builtin_popcountll(bits));
+#else
+		unsigned count = 0;
+		for (; bits != 0; bits = static_cast<decltype(bits)>(bits & (bits - 1)))
+			++count;
+		return count;
+#endif
+	}
+
+	/**
+		\brief The number of low 0 bits of value, the index of the lowest
+		high bit, its width in bits if value is 0.
+	*/
+	template<class integral>
+	constexpr inline unsigned countTrailingZeros(
+		integral value /**< : <i>in</i> : The value.*/
+	) noexcept
+	{
+		static_assert(std::is_integral_v<integral>, "countTrailingZeros is for integral types");
+		auto bits = static_cast<std::make_unsigned_t<integral>>(value);
+		if (bits == 0)
+			return static_cast<unsigned>(sizeof(bits) * 8);
+#if defined(__GNUC__) || defined(__clang__)
+		if constexpr (sizeof(bits) <= sizeof(unsigned))
+			return static_cast<unsigned>(__builtin_ctz(bits));
+		else
+			return static_cast<unsigned>(__builtin_ctzll(bits));
+#else
+		unsigned count = 0;
+		for (; (bits & 1U) == 0; bits = static_cast<decltype(bits)>(bits >> 1))
+			++count;
+		return count;
+#endif
+	}
+
+	/**
+		\brief The order as a valid order of an atomic load, release is 
+		taken as acquire and acq_rel as acquire.
+	*/
+	constexpr inline std::memory_order load_order(
+		std::memory_order order /**< : <i>in</i> : The order asked for.*/
+	) noexcept
+	{
+		return (order == std::memory_order_release || order == std::memory_order_acq_rel)
+			? std::memory_order_acquire : order;
+	}
+
+	/**
+		\brief The order as a valid order of an atomic store, consume, 
+		acquire and acq_rel are taken as release.
+	*/
+	constexpr inline std::memory_order store_order(
+		std::memory_order order /**< : <i>in</i> : The order asked for.*/
+	) noexcept
+	{
+		return (order == std::memory_order_consume || order == std::memory_order_acquire
+			|| order == std::memory_order_acq_rel) ? std::memory_order_release : order;
+	}
+
+	/**
+		\brief Hints the processor that the thread is in a spin-wait loop.
+
+		Uses the pause instruction on x86, does nothing elsewhere.
+	*/
+	inline void cpu_relax() noexcept
+	{
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) \
+	|| defined(__x86_64__) || defined(__i386__)
+		_mm_pause();
+#endif
+	}
+
 	/**
 		\brief Check if all the bits high in parameter 'toCheckFor' are high in
 		parameter 'base'.\n
@@ -120,7 +239,57 @@ namespace enh
 	)
 	{
 		static_assert(std::is_integral_v<integral>, "inclusive ratio is for integral types");
-		return (num / denom) + signum_fn(num % denom);
+		integral rem = num % denom;
+		return static_cast<integral>((num / denom) + (rem > 0) - (rem < 0));
+	}
+
+	/**
+		\brief The inclusive ratio of each of the n num by its denom, into
+		out, written without branches on the values (x86 has no vector
+		integer division, so only the rounding and masking vectorise).
+
+		Elements with a denominator of 0 are set to 0 in out.
+
+		<h3>Template</h3>
+		<code>class integral</code> : The integral type of the arguments.
+
+		<h3>Return</h3>
+		The number of elements with a denominator of 0, their bits are set
+		in mask (bit i % 64 of word i / 64) if it is not nullptr, it must
+		hold (n + 63) / 64 words.
+	*/
+	template<class integral>
+	inline std::size_t incl_ratio(
+		const integral* num /**< : <i>in</i> : The numerators.*/,
+		const integral* denom /**< : <i>in</i> : The denominators.*/,
+		integral* out /**< : <i>out</i> : The ratios, may be num.*/,
+		std::size_t n /**< : <i>in</i> : The number of elements.*/,
+		std::uint64_t* mask = nullptr /**< : <i>out</i> : The bits of the
+									  elements dividing by 0.*/
+	) noexcept
+	{
+		static_assert(std::is_integral_v<integral>, "inclusive ratio is for integral types");
+		std::size_t bad = 0;
+		for (std::size_t w = 0; w * 64 < n; ++w)
+		{
+			std::size_t end = (n - w * 64 < 64) ? n - w * 64 : 64;
+			std::uint64_t bits = 0;
+			for (std::size_t i = 0; i < end; ++i)
+			{
+				integral d = denom[w * 64 + i];
+				integral zero = static_cast<integral>(d == 0);
+				integral safe = static_cast<integral>(d + zero);
+				integral x = num[w * 64 + i];
+				integral rem = static_cast<integral>(x % safe);
+				integral q = static_cast<integral>(x / safe + (rem > 0) - (rem < 0));
+				out[w * 64 + i] = static_cast<integral>(q * (1 - zero));
+				bits |= static_cast<std::uint64_t>(zero) << i;
+			}
+			bad += static_cast<std::size_t>(popCount(bits));
+			if (mask)
+				mask[w] = bits;
+		}
+		return bad;
 	}
 
 	/**
@@ -170,22 +339,359 @@ namespace enh
 		bool uInclusive = false /*< : <i>in</i> : inclusive upper bound?.*/
 	)
 	{
-		bool lCheck(false), uCheck(false);
+		bool uCheck = (unChecked < uBounds) | (uInclusive & (unChecked == uBounds));
+		bool lCheck = (unChecked > lBounds) | (lInclusive & (unChecked == lBounds));
+		return lCheck & uCheck;
+	}
+
+	/**
+		\brief Checks if the value is within bounds, the inclusivity fixed at
+		compile time so the check is one pair of compares.
+
+		isConfined<true, false>(v, l, u) is isConfined(v, l, u, true, false).
+
+		<h3>Template</h3>
+		-# <code>bool lInclusive</code> : inclusive lower bound?.\n
+		-# <code>bool uInclusive</code> : inclusive upper bound?.\n
+		-# <code>class type</code> : Any type that can be compared using <.\n
+
+		<h3>Return</h3>
+		Returns if unChecked is within the interval.
+	*/
+	template<bool lInclusive, bool uInclusive, class type>
+	constexpr inline bool isConfined(
+		type unChecked /**< : <i>in</i> : The value to check.*/,
+		type lBounds /**< : <i>in</i> : The Lower bound of the interval.*/,
+		type uBounds /**< : <i>in</i> : The Upper bound of the interval.*/
+	)
+	{
+		bool lCheck = false, uCheck = false;
+		if constexpr (lInclusive)
+			lCheck = !(unChecked < lBounds);
+		else
+			lCheck = lBounds < unChecked;
+		if constexpr (uInclusive)
+			uCheck = !(uBounds < unChecked);
+		else
+			uCheck = unChecked < uBounds;
+		return lCheck & uCheck;
+	}
 
-		if (unChecked < uBounds)
-			uCheck = true;
-		else if ((unChecked == uBounds) && uInclusive)
-			uCheck = true;
+	/**
+		\brief Checks each of the n values against the bounds, written
+		without branches so the compiler vectorises it.
 
-		if (unChecked > lBounds)
-			lCheck = true;
-		else if ((unChecked == lBounds) && lInclusive)
-			lCheck = true;
+		<h3>Template</h3>
+		-# <code>bool lInclusive</code> : inclusive lower bound?.\n
+		-# <code>bool uInclusive</code> : inclusive upper bound?.\n
+		-# <code>class type</code> : An arithmetic type.\n
 
-		return lCheck && uCheck;
+		<h3>Return</h3>
+		The number of values out of the interval, their bits are set in mask
+		(bit i % 64 of word i / 64) if it is not nullptr, it must hold 
+		(n + 63) / 64 words.
+	*/
+	template<bool lInclusive, bool uInclusive, class type>
+	inline std::size_t isConfined(
+		const type* values /**< : <i>in</i> : The values to check.*/,
+		std::size_t n /**< : <i>in</i> : The number of values.*/,
+		type lBounds /**< : <i>in</i> : The Lower bound of the interval.*/,
+		type uBounds /**< : <i>in</i> : The Upper bound of the interval.*/,
+		std::uint64_t* mask = nullptr /**< : <i>out</i> : The bits of the
+									  values out of bounds.*/
+	) noexcept
+	{
+		static_assert(std::is_arithmetic_v<type>, "batch isConfined is for arithmetic types");
+		auto outside = [lBounds, uBounds](const type* v, std::size_t end) noexcept
+		{
+			std::uint64_t bits = 0;
+			for (std::size_t i = 0; i < end; ++i)
+				bits |= static_cast<std::uint64_t>(
+					!isConfined<lInclusive, uInclusive>(v[i], lBounds, uBounds)) << i;
+			return bits;
+		};
+		std::size_t bad = 0;
+		std::size_t w = 0;
+		for (; w * 64 + 64 <= n; ++w)
+		{
+			// the fixed count of 64 lets the loop vectorise
+			std::uint64_t bits = outside(values + w * 64, 64);
+			bad += static_cast<std::size_t>(popCount(bits));
+			if (mask)
+				mask[w] = bits;
+		}
+		if (w * 64 < n)
+		{
+			std::uint64_t bits = outside(values + w * 64, n - w * 64);
+			bad += static_cast<std::size_t>(popCount(bits));
+			if (mask)
+				mask[w] = bits;
+		}
+		return bad;
 	}
 
 
+	namespace detail
+	{
+		/**
+			\brief The two digit decimals of 0 to 99, "00" to "99".
+		*/
+		constexpr char digit_pairs[201] =
+			"00010203040506070809"
+			"10111213141516171819"
+			"20212223242526272829"
+			"30313233343536373839"
+			"40414243444546474849"
+			"50515253545556575859"
+			"60616263646566676869"
+			"70717273747576777879"
+			"80818283848586878889"
+			"90919293949596979899";
+	}
+
+	/**
+		\brief Writes the two digits of value at out, not checked.
+
+		<h3>Return</h3>
+		out + 2.\n
+	*/
+	constexpr inline char* writeDigits2(
+		char* out /**< : <i>out</i> : The buffer, at least 2 characters.*/,
+		unsigned value /**< : <i>in</i> : The value [0,99].*/
+	) noexcept
+	{
+		out[0] = detail::digit_pairs[2 * value];
+		out[1] = detail::digit_pairs[2 * value + 1];
+		return out + 2;
+	}
+
+	/**
+		\brief Writes the four digits of value at out, not checked.
+
+		<h3>Return</h3>
+		out + 4.\n
+	*/
+	constexpr inline char* writeDigits4(
+		char* out /**< : <i>out</i> : The buffer, at least 4 characters.*/,
+		unsigned value /**< : <i>in</i> : The value [0,9999].*/
+	) noexcept
+	{
+		writeDigits2(out, value / 100);
+		return writeDigits2(out + 2, value % 100);
+	}
+
+	/**
+		\brief The number of characters of the decimal of value with 0's
+		prepended to width digits, including the sign.
+	*/
+	template<class integral>
+	constexpr inline std::size_t decimalSize(
+		integral value /**< : <i>in</i> : The value.*/,
+		unsigned width = 0 /**< : <i>in</i> : The minimum number of digits.*/
+	) noexcept
+	{
+		static_assert(std::is_integral_v<integral>, "Type should be "
+			"integral type.");
+		std::make_unsigned_t<integral> mag = static_cast<std::make_unsigned_t<integral>>(value);
+		std::size_t sign = 0;
+		if constexpr (std::is_signed_v<integral>)
+			if (value < 0)
+			{
+				mag = 0 - mag;
+				sign = 1;
+			}
+		std::size_t count = 1;
+		for (; mag >= 10; mag /= 10)
+			++count;
+		return sign + ((count < width) ? width : count);
+	}
+
+	/**
+		\brief Writes the decimal of value to [first, last) with 0's
+		prepended to width digits, usable in constant expressions.
+
+		Digits are written two at a time from digit_pairs, appendValue is 
+		the same at run time through std::to_chars.
+
+		<h3>Return</h3>
+		The end of the written characters, nullptr if it does not fit or
+		first is nullptr.\n
+	*/
+	template<class integral>
+	constexpr inline char* formatDecimal(
+		char* first /**< : <i>in</i> : The start of the buffer.*/,
+		char* last /**< : <i>in</i> : The end of the buffer.*/,
+		integral value /**< : <i>in</i> : The value.*/,
+		unsigned width = 0 /**< : <i>in</i> : The minimum number of digits.*/
+	) noexcept
+	{
+		std::size_t size = decimalSize(value, width);
+		if (!first || static_cast<std::size_t>(last - first) < size)
+			return nullptr;
+		std::make_unsigned_t<integral> mag = static_cast<std::make_unsigned_t<integral>>(value);
+		char* stop = first;
+		if constexpr (std::is_signed_v<integral>)
+			if (value < 0)
+			{
+				mag = 0 - mag;
+				*stop++ = '-';
+			}
+		char* end = first + size;
+		char* out = end;
+		while (mag >= 100)
+		{
+			out -= 2;
+			writeDigits2(out, static_cast<unsigned>(mag % 100));
+			mag /= 100;
+		}
+		if (mag >= 10)
+		{
+			out -= 2;
+			writeDigits2(out, static_cast<unsigned>(mag));
+		}
+		else
+			*--out = static_cast<char>('0' + mag);
+		while (out != stop)
+			*--out = '0';
+		return end;
+	}
+
+	/**
+		\brief The decimal of value with 0's prepended to width digits, as
+		a compile time constant string.
+
+		Example : <code>decimal_text<7, 2>::view</code> is <code>"07"</code>\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	template<auto value, unsigned width = 0>
+	struct decimal_text
+	{
+		static constexpr std::size_t size = decimalSize(value, width);
+
+	private:
+
+		struct buffer
+		{
+			char data[size + 1] = {};
+
+			constexpr buffer() noexcept
+			{
+				formatDecimal(data, data + size, value, width);
+			}
+		};
+
+		static constexpr buffer text{};
+
+	public:
+
+		/**
+			\brief The null terminated string.
+		*/
+		static constexpr const char* c_str = text.data;
+
+		/**
+			\brief The string.
+		*/
+		static constexpr std::string_view view{ text.data, size };
+	};
+
+	namespace detail
+	{
+		template<class A, class = void>
+		struct is_allocator : std::false_type {};
+
+		template<class A>
+		struct is_allocator<A, std::void_t<typename A::value_type,
+			decltype(std::declval<A&>().allocate(std::size_t{}))>> : std::true_type {};
+	}
+
+	/**
+		\brief Checks if Alloc is a standard allocator, to tell allocator
+		overloads of the string functions from the format string ones.
+	*/
+	template<class Alloc>
+	constexpr bool is_allocator_v = detail::is_allocator<Alloc>::value;
+
+	/**
+		\brief The string allocated by Alloc (rebound to char).
+	*/
+	template<class Alloc>
+	using alloc_string = std::basic_string<char, std::char_traits<char>,
+		typename std::allocator_traits<Alloc>::template rebind_alloc<char>>;
+
+	/**
+		\brief Copies text to [first, last), without allocating.
+
+		<h3>Return</h3>
+		The end of the written characters, nullptr if it does not fit or 
+		first is nullptr (so calls can be chained).\n
+	*/
+	inline char* appendText(
+		char* first /**< : <i>in</i> : The start of the buffer.*/,
+		char* last /**< : <i>in</i> : The end of the buffer.*/,
+		std::string_view text /**< : <i>in</i> : The text.*/
+	) noexcept
+	{
+		if (!first || static_cast<std::size_t>(last - first) < text.size())
+			return nullptr;
+		for (char c : text)
+			*first++ = c;
+		return first;
+	}
+
+	/**
+		\brief Writes the decimal of value to [first, last) with 0's 
+		prepended to length digits, like signExtendValue, without allocating.
+
+		Values of [0,99] at length 2 and [0,9999] at length 4 (the fields of
+		the date and time) are written from a table, others by std::to_chars.
+
+		<h3>Return</h3>
+		The end of the written characters, nullptr if it does not fit or
+		first is nullptr.\n
+	*/
+	template<class integral>
+	inline char* appendValue(
+		char* first /**< : <i>in</i> : The start of the buffer.*/,
+		char* last /**< : <i>in</i> : The end of the buffer.*/,
+		integral value /**< : <i>in</i> : The value.*/,
+		unsigned length = 0 /**< : <i>in</i> : The minimum number of digits.*/
+	) noexcept
+	{
+		static_assert(std::is_integral_v<integral>, "Type should be "
+			"integral type.");
+		if (!first)
+			return nullptr;
+		bool negative = false;
+		if constexpr (std::is_signed_v<integral>)
+			negative = value < 0;
+		std::size_t room = static_cast<std::size_t>(last - first);
+		if (!negative && length == 2 && value <= 99 && room >= 2)
+			return writeDigits2(first, static_cast<unsigned>(value));
+		if (!negative && length == 4 && value <= 9999 && room >= 4)
+			return writeDigits4(first, static_cast<unsigned>(value));
+		char digits[24];
+		auto res = std::to_chars(digits, digits + sizeof(digits), value);
+		const char* d = digits;
+		if (*d == '-')
+		{
+			if (first == last)
+				return nullptr;
+			*first++ = '-';
+			++d;
+		}
+		std::size_t count = static_cast<std::size_t>(res.ptr - d);
+		std::size_t pad = (count < length) ? length - count : 0;
+		if (static_cast<std::size_t>(last - first) < pad + count)
+			return nullptr;
+		for (; pad > 0; --pad)
+			*first++ = '0';
+		for (; d != res.ptr; ++d)
+			*first++ = *d;
+		return first;
+	}
+
 	/**
 		\brief Prepend 0's to the value according to the number passed.
 
@@ -197,19 +703,18 @@ namespace enh
 		)
 	{
 		if (value.size() < length)
-		{
-			if (value[0] == '-')
-				return '-' + std::string(length - value.size() , '0') + &value.c_str()[1];
-			else
-				return std::string(length - value.size(), '0') + value;
-		}
-		else
-			return value;
+			value.insert((!value.empty() && value[0] == '-') ? 1 : 0,
+				length - value.size(), '0');
+		return value;
 	}
 
 	/**
 		\brief Prepend 0's to the value according to the number passed.
 
+		Integers are written by appendValue, so only the returned string is
+		allocated (and not even that within the small string buffer). The
+		sign counts towards length, unlike appendValue.
+
 		<code>signExtend(25,4)</code> returns <code>"0025"</code>
 	*/
 	template<class arithmetic>
@@ -220,6 +725,18 @@ namespace enh
 	{
 		static_assert(std::is_arithmetic_v<arithmetic>, "Type should be "
 			"arithmetic type.");
+		if constexpr (std::is_integral_v<arithmetic> && !std::is_same_v<arithmetic, bool>)
+		{
+			unsigned digitCount = length;
+			if constexpr (std::is_signed_v<arithmetic>)
+				if (value < 0 && length > 0)
+					--digitCount;
+			char digits[24];
+			char* end = (length <= 20) ? appendValue(digits, digits + sizeof(digits),
+				value, digitCount) : nullptr;
+			if (end)
+				return std::string(digits, end);
+		}
 		return signExtend(std::to_string(value), length);
 	}
 
@@ -242,16 +759,11 @@ namespace enh
 	{
 		static_assert(std::is_integral_v<integral>, "Ordinal Indicator is \
 										for integral types");
-		if ((value / 10) % 10 == 1)
-			return "th";
-		if (value % 10 == 1)
-			return "st";
-		else if (value % 10 == 2)
-			return "nd";
-		else if (value % 10 == 3)
-			return "rd";
-		else
-			return "th";
+		constexpr std::string_view indicators[4] = { "th", "st", "nd", "rd" };
+		integral units = static_cast<integral>(value % 10);
+		bool teen = (value / 10) % 10 == 1;
+		bool named = (units >= 1) & (units <= 3) & !teen;
+		return indicators[named ? static_cast<std::size_t>(units) : 0];
 	}
 
 }
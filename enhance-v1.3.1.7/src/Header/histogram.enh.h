@@ -0,0 +1,289 @@
+/** ***************************************************************************
+	\file histogram.enh.h
+
+	\brief The file to declare class log_histogram
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+
+******************************************************************************/
+
+#ifndef HISTOGRAM_ENH_H
+
+#define HISTOGRAM_ENH_H						histogram.enh.h
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace enh
+{
+
+	/**
+		\brief The index of the highest set bit of val, val must not be 0.
+	*/
+	inline unsigned highest_bit(
+		std::uint64_t val /**< : <i>in</i> : The value, not 0.*/
+	) noexcept
+	{
+#if defined(__GNUC__) || defined(__clang__)
+		return 63u - static_cast<unsigned>(__builtin_clzll(val));
+#elif defined(_MSC_VER) && defined(_M_X64)
+		unsigned long index;
+		_BitScanReverse64(&index, val);
+		return static_cast<unsigned>(index);
+#else
+		unsigned index = 0;
+		while (val >>= 1)
+			++index;
+		return index;
+#endif
+	}
+
+	/**
+		\brief The copy of the state of a log_histogram at some point.
+	*/
+	struct histogram_snapshot
+	{
+		/**
+			\brief The count of values in each bucket.
+		*/
+		std::vector<std::uint64_t> buckets;
+
+		/**
+			\brief The count of values recorded.
+		*/
+		std::uint64_t count = 0;
+
+		/**
+			\brief The sum of values recorded.
+		*/
+		std::uint64_t sum = 0;
+
+		/**
+			\brief The largest value recorded.
+		*/
+		std::uint64_t max = 0;
+
+		/**
+			\brief The mean of the values recorded, 0 if none.
+		*/
+		inline double mean() const noexcept
+		{
+			return count ? static_cast<double>(sum) / count : 0.0;
+		}
+
+		/**
+			\brief The value below which the fraction p of recorded values
+			lie.
+
+			<h3>Return</h3>
+			The upper bound of the bucket holding the percentile (at most
+			max), 0 if no values were recorded.\n
+		*/
+		std::uint64_t percentile(
+			double p /**< : <i>in</i> : The fraction, 0.0 to 1.0.*/
+		) const noexcept;
+	};
+
+	/**
+		\brief The class to implement a histogram of integer values (like
+		latencies in nanoseconds) with bounded relative error.
+
+		Values below 32 have a bucket each, above that every power of 2 is
+		split into 16 buckets, so a value is known within 1/16 (6.25%) of
+		itself, with a fixed memory use of under 1000 counters.\n\n
+
+		Recording is a relaxed atomic increment, safe from any number of
+		threads, and never allocates.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class log_histogram
+	{
+	public:
+
+		/**
+			\brief The number of bits of precision kept for each value.
+		*/
+		static constexpr unsigned sub_bits = 4;
+
+		/**
+			\brief The number of buckets per power of 2.
+		*/
+		static constexpr std::size_t sub_count = std::size_t(1) << sub_bits;
+
+		/**
+			\brief The values below this have a bucket each.
+		*/
+		static constexpr std::size_t linear_count = sub_count * 2;
+
+		/**
+			\brief The total number of buckets.
+		*/
+		static constexpr std::size_t bucket_count = linear_count
+			+ (63 - sub_bits) * sub_count;
+
+		/**
+			\brief The bucket for value.
+		*/
+		static inline std::size_t bucket_of(
+			std::uint64_t val /**< : <i>in</i> : The value.*/
+		) noexcept
+		{
+			if (val < linear_count)
+				return static_cast<std::size_t>(val);
+			unsigned shift = highest_bit(val) - sub_bits;
+			return linear_count + (shift - 1) * sub_count
+				+ static_cast<std::size_t>((val >> shift) - sub_count);
+		}
+
+		/**
+			\brief The largest value that falls in bucket.
+		*/
+		static inline constexpr std::uint64_t bucket_upper(
+			std::size_t bucket /**< : <i>in</i> : The bucket.*/
+		) noexcept
+		{
+			if (bucket < linear_count)
+				return bucket;
+			std::size_t shift = (bucket - linear_count) / sub_count + 1;
+			std::uint64_t mantissa = (bucket - linear_count) % sub_count
+				+ sub_count;
+			return ((mantissa + 1) << shift) - 1;
+		}
+
+	private:
+
+		/**
+			\brief The count of values in each bucket.
+		*/
+		std::atomic<std::uint64_t> buckets[bucket_count];
+
+		/**
+			\brief The count of values recorded.
+		*/
+		std::atomic<std::uint64_t> total;
+
+		/**
+			\brief The sum of values recorded.
+		*/
+		std::atomic<std::uint64_t> sum;
+
+		/**
+			\brief The largest value recorded.
+		*/
+		std::atomic<std::uint64_t> largest;
+
+	public:
+
+		/**
+			\brief Constructs an empty histogram.
+		*/
+		log_histogram() noexcept { reset(); }
+
+		log_histogram(const log_histogram&) = delete;
+
+		log_histogram& operator = (const log_histogram&) = delete;
+
+		/**
+			\brief Records a value.
+		*/
+		inline void record(
+			std::uint64_t val /**< : <i>in</i> : The value.*/
+		) noexcept
+		{
+			buckets[bucket_of(val)].fetch_add(1, std::memory_order_relaxed);
+			total.fetch_add(1, std::memory_order_relaxed);
+			sum.fetch_add(val, std::memory_order_relaxed);
+			std::uint64_t old = largest.load(std::memory_order_relaxed);
+			while (val > old && !largest.compare_exchange_weak(old, val,
+				std::memory_order_relaxed));
+		}
+
+		/**
+			\brief The count of values recorded.
+		*/
+		inline std::uint64_t count() const noexcept
+		{
+			return total.load(std::memory_order_relaxed);
+		}
+
+		/**
+			\brief Copies the current state.
+
+			Values recorded while copying may be partly included.
+		*/
+		histogram_snapshot snapshot() const
+		{
+			histogram_snapshot ret;
+			ret.buckets.resize(bucket_count);
+			for (std::size_t i = 0; i < bucket_count; ++i)
+				ret.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+			ret.count = total.load(std::memory_order_relaxed);
+			ret.sum = sum.load(std::memory_order_relaxed);
+			ret.max = largest.load(std::memory_order_relaxed);
+			return ret;
+		}
+
+		/**
+			\brief Clears all values recorded.
+		*/
+		inline void reset() noexcept
+		{
+			for (auto& b : buckets)
+				b.store(0, std::memory_order_relaxed);
+			total.store(0, std::memory_order_relaxed);
+			sum.store(0, std::memory_order_relaxed);
+			largest.store(0, std::memory_order_relaxed);
+		}
+	};
+
+	inline std::uint64_t histogram_snapshot::percentile(double p) const noexcept
+	{
+		std::uint64_t seen = 0;
+		for (auto b : buckets)
+			seen += b;
+		if (seen == 0)
+			return 0;
+		if (p < 0.0)
+			p = 0.0;
+		std::uint64_t rank = static_cast<std::uint64_t>(p * seen);
+		if (rank >= seen)
+			rank = seen - 1;
+		seen = 0;
+		for (std::size_t i = 0; i < buckets.size(); ++i)
+		{
+			seen += buckets[i];
+			if (seen > rank)
+			{
+				std::uint64_t upper = log_histogram::bucket_upper(i);
+				return (upper < max) ? upper : max;
+			}
+		}
+		return max;
+	}
+}
+
+#endif
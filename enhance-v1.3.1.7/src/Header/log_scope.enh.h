@@ -0,0 +1,452 @@
+/** ***************************************************************************
+	\file log_scope.enh.h
+
+	\brief The file to declare scoped timing probes for the logger
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	<h3> How To Use</h3>
+
+	- Put `LOG_SCOPE("name");` (or one of the O# variants) at the start of
+	a block, the time until the end of the block is logged as `name ns`.
+
+	- Call `debug::setScopeSummary(true)` to keep count, min, mean, max and
+	p99 of each probe in memory instead of logging every run, and call
+	`debug::logScopeSummary` periodically to log them.
+
+	- While `debug::setTracing(true)` is on, each probe logs begin and end 
+	trace events instead, shown as spans by `log_decoder -c`.
+
+******************************************************************************/
+
+#ifndef LOG_SCOPE_ENH_H
+
+#define LOG_SCOPE_ENH_H						log_scope.enh.h
+
+#include "logger.enh.h"
+#include "timer.enh.h"
+#include "histogram.enh.h"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+#if  defined(ENH_DEBUG_CONTROL) && (ENH_OPTIMISATION < 5)
+namespace debug
+{
+
+	/**
+		\brief The durations of one probe aggregated in memory.
+	*/
+	struct scope_stats
+	{
+		/**
+			\brief The logging point of the probe.
+		*/
+		const call_site* site;
+
+		/**
+			\brief The durations in nanoseconds.
+		*/
+		enh::log_histogram durations;
+
+		/**
+			\brief The shortest duration in nanoseconds.
+		*/
+		std::atomic<std::uint64_t> least;
+
+		/**
+			\brief Constructs empty stats for site.
+		*/
+		explicit scope_stats(
+			const call_site* pt /**< : <i>in</i> : The logging point.*/
+		) noexcept : site(pt), least(std::numeric_limits<std::uint64_t>::max()) {}
+
+		/**
+			\brief Records a duration in nanoseconds.
+		*/
+		inline void record(
+			std::uint64_t ns /**< : <i>in</i> : The duration.*/
+		) noexcept
+		{
+			durations.record(ns);
+			std::uint64_t old = least.load(std::memory_order_relaxed);
+			while (ns < old && !least.compare_exchange_weak(old, ns,
+				std::memory_order_relaxed));
+		}
+	};
+
+	/**
+		\brief The summary of one probe, see scopeSummary.
+	*/
+	struct scope_summary
+	{
+		const call_site* site;			/**< : The logging point.*/
+		std::uint64_t count;			/**< : The runs recorded.*/
+		std::uint64_t min;				/**< : The shortest, ns.*/
+		double mean;					/**< : The mean, ns.*/
+		std::uint64_t max;				/**< : The longest, ns.*/
+		std::uint64_t p99;				/**< : The 99th percentile, ns.*/
+	};
+
+	/**
+		\brief The list of all probes that have aggregated stats.
+	*/
+	class scope_registry
+	{
+		std::mutex lock;
+		std::vector<std::unique_ptr<scope_stats>> all;
+
+	public:
+
+		/**
+			\brief Adds stats to the list.
+		*/
+		inline void add(
+			std::unique_ptr<scope_stats> st /**< : <i>in</i> : The stats.*/
+		)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			all.push_back(std::move(st));
+		}
+
+		/**
+			\brief The summary of each probe run at least once, clearing the
+			stats if reset.
+		*/
+		std::vector<scope_summary> summary(
+			bool reset /**< : <i>in</i> : Clear the stats after reading.*/
+		)
+		{
+			std::vector<scope_summary> ret;
+			std::lock_guard<std::mutex> guard(lock);
+			for (auto& st : all)
+			{
+				enh::histogram_snapshot snap = st->durations.snapshot();
+				std::uint64_t least = st->least.load(std::memory_order_relaxed);
+				if (reset)
+				{
+					st->durations.reset();
+					st->least.store(std::numeric_limits<std::uint64_t>::max(),
+						std::memory_order_relaxed);
+				}
+				if (snap.count == 0)
+					continue;
+				ret.push_back({ st->site, snap.count, least, snap.mean(), snap.max,
+					snap.percentile(0.99) });
+			}
+			return ret;
+		}
+	};
+
+	/**
+		\brief The list of probes of the program.
+	*/
+	inline scope_registry& scopeRegistry()
+	{
+		static scope_registry reg;
+		return reg;
+	}
+
+	/**
+		\brief True if probes aggregate instead of logging each run.
+	*/
+	inline std::atomic<bool> scopeAggregate{ false };
+
+	/**
+		\brief Turns aggregation of probes on or off.
+
+		When on, each LOG_SCOPE keeps its durations in memory (a few kB per
+		probe, allocated on its first run) and logs nothing until
+		logScopeSummary is called.
+	*/
+	inline void setScopeSummary(
+		bool aggregate /**< : <i>in</i> : True to aggregate.*/
+	) noexcept
+	{
+		scopeAggregate.store(aggregate, std::memory_order_relaxed);
+	}
+
+	/**
+		\brief The state of a probe kept beside its logging point.
+	*/
+	struct scope_state
+	{
+		/**
+			\brief The aggregated stats, null until first needed.
+		*/
+		std::atomic<scope_stats*> stats;
+
+		constexpr scope_state() noexcept : stats(nullptr) {}
+	};
+
+	/**
+		\brief The class to time a scope and report it when destroyed, use
+		the LOG_SCOPE macros.
+
+		hasErrorHandlers        = false;\n
+	*/
+	class scope_probe
+	{
+		const call_site* site;
+		scope_state* state;
+		enh::time_pt start;
+		bool traced;
+
+		scope_stats& stats()
+		{
+			scope_stats* st = state->stats.load(std::memory_order_acquire);
+			if (st)
+				return *st;
+			auto fresh = std::make_unique<scope_stats>(site);
+			if (state->stats.compare_exchange_strong(st, fresh.get(),
+				std::memory_order_acq_rel))
+			{
+				st = fresh.get();
+				scopeRegistry().add(std::move(fresh));
+			}
+			return *st;
+		}
+
+	public:
+
+		/**
+			\brief Starts timing if the probe is active.
+		*/
+		scope_probe(
+			const call_site& pt /**< : <i>in</i> : The logging point.*/,
+			scope_state& st /**< : <i>in</i> : The state of the probe.*/,
+			int level /**< : <i>in</i> : The optimisation level of the probe,
+					  0 if not gated by level.*/
+		) : site(nullptr), state(&st), traced(false)
+		{
+			if ((level == 0 || levelActive(level)) && isEnabled(pt))
+			{
+				site = &pt;
+				traced = isTracing();
+				if (traced)
+					LogTrace(pt, trace_phase::begin);
+				else
+					start = enh::high_res::now();
+			}
+		}
+
+		scope_probe(const scope_probe&) = delete;
+
+		scope_probe& operator = (const scope_probe&) = delete;
+
+		/**
+			\brief Logs or records the time since construction, or ends the
+			trace span.
+		*/
+		~scope_probe()
+		{
+			if (!site)
+				return;
+			if (traced)
+			{
+				LogTrace(*site, trace_phase::end);
+				return;
+			}
+			auto ns = static_cast<std::uint64_t>(std::chrono::duration_cast<
+				std::chrono::nanoseconds>(enh::high_res::now() - start).count());
+			if (scopeAggregate.load(std::memory_order_relaxed))
+				stats().record(ns);
+			else
+				LogValue(*site, static_cast<unsigned long long>(ns));
+		}
+	};
+
+	/**
+		\brief The aggregated stats of all probes run since the last reset.
+	*/
+	inline std::vector<scope_summary> scopeSummary(
+		bool reset = false /**< : <i>in</i> : Clear the stats after reading.*/
+	)
+	{
+		return scopeRegistry().summary(reset);
+	}
+
+	/**
+		\brief Logs the aggregated stats of each probe at its logging point.
+
+		Each line is `summary count c min a mean m max b p99 p ns`.
+	*/
+	inline void logScopeSummary(
+		bool reset = true /**< : <i>in</i> : Clear the stats after logging.*/
+	)
+	{
+		for (const auto& sum : scopeSummary(reset))
+		{
+			std::ostringstream out;
+			out << "summary count " << sum.count << " min " << sum.min << " mean "
+				<< sum.mean << " max " << sum.max << " p99 " << sum.p99 << " ns";
+			LogDesc(*sum.site, out.str());
+		}
+	}
+}
+#endif
+
+/**
+	\brief Pastes a and b after expanding them.
+*/
+#define ENH_SCOPE_CAT_(a, b)		a##b
+
+/**
+	\brief Pastes a and b after expanding them.
+*/
+#define ENH_SCOPE_CAT(a, b)			ENH_SCOPE_CAT_(a, b)
+
+/**
+	\brief Declares the probe id timing the rest of the enclosing scope,
+	named name (a string literal) and gated at level (0 for none).
+*/
+#define LOG_SCOPE_ID(level, name, id)	static debug::site_state\
+	ENH_SCOPE_CAT(enh_scope_state_, id);\
+	static debug::scope_state ENH_SCOPE_CAT(enh_scope_stats_, id);\
+	static constexpr debug::call_site ENH_SCOPE_CAT(enh_scope_site_, id)(\
+		__FILE__, __func__, __LINE__, name " ns",\
+		&ENH_SCOPE_CAT(enh_scope_state_, id));\
+	debug::scope_probe ENH_SCOPE_CAT(enh_scope_, id)(\
+		ENH_SCOPE_CAT(enh_scope_site_, id),\
+		ENH_SCOPE_CAT(enh_scope_stats_, id), level)
+
+/**
+	\brief Declares a probe with an id unique in the translation unit, see
+	LOG_SCOPE_ID.
+*/
+#define LOG_SCOPE_AT(level, name)	LOG_SCOPE_ID(level, name, __COUNTER__)
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined.
+*/
+#define LOG_SCOPE(name)			REPLACE(LOG_SCOPE_AT(0, name))
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if IGNORE_ENHANCE_DIAGNOSTICS is defined.
+*/
+#define LIB_LOG_SCOPE(name)		LIB_REPLACE(LOG_SCOPE_AT(0, name))
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if ENH_OPTIMISATION is greater than 4.
+*/
+#define O5_LOG_SCOPE(name)		O5_REPLACE(LOG_SCOPE_AT(5, name))
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if ENH_OPTIMISATION is greater than 3.
+*/
+#define O4_LOG_SCOPE(name)		O4_REPLACE(LOG_SCOPE_AT(4, name))
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if ENH_OPTIMISATION is greater than 2.
+*/
+#define O3_LOG_SCOPE(name)		O3_REPLACE(LOG_SCOPE_AT(3, name))
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if ENH_OPTIMISATION is greater than 1.
+*/
+#define O2_LOG_SCOPE(name)		O2_REPLACE(LOG_SCOPE_AT(2, name))
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if ENH_OPTIMISATION is greater than 0.
+*/
+#define O1_LOG_SCOPE(name)		O1_REPLACE(LOG_SCOPE_AT(1, name))
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if IGNORE_ENHANCE_DIAGNOSTICS is defined or if ENH_OPTIMISATION is
+	greater than 4.
+*/
+#define O5_LIB_LOG_SCOPE(name)	O5_LIB_REPLACE(LOG_SCOPE_AT(5, name))
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if IGNORE_ENHANCE_DIAGNOSTICS is defined or if ENH_OPTIMISATION is
+	greater than 3.
+*/
+#define O4_LIB_LOG_SCOPE(name)	O4_LIB_REPLACE(LOG_SCOPE_AT(4, name))
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if IGNORE_ENHANCE_DIAGNOSTICS is defined or if ENH_OPTIMISATION is
+	greater than 2.
+*/
+#define O3_LIB_LOG_SCOPE(name)	O3_LIB_REPLACE(LOG_SCOPE_AT(3, name))
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if IGNORE_ENHANCE_DIAGNOSTICS is defined or if ENH_OPTIMISATION is
+	greater than 1.
+*/
+#define O2_LIB_LOG_SCOPE(name)	O2_LIB_REPLACE(LOG_SCOPE_AT(2, name))
+
+/**
+	\brief The Macro to time the rest of the scope in debug mode.
+
+	Evaluates to a debug::scope_probe if DEBUG is defined.\n\n
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if IGNORE_ENHANCE_DIAGNOSTICS is defined or if ENH_OPTIMISATION is
+	greater than 0.
+*/
+#define O1_LIB_LOG_SCOPE(name)	O1_LIB_REPLACE(LOG_SCOPE_AT(1, name))
+
+#endif
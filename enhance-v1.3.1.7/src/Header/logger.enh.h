@@ -45,6 +45,10 @@
 	optimisation 0, all logging O5, O4, O3, O2, O1 is active but for 
 	optimisation 5 none is active.
 
+	- Call `debug::setOptimisation` (or set the environment variable 
+	`ENH_LOG_OPTIMISATION`) to log less than compiled in, without 
+	rebuilding.
+
 	- Define `ENH_CLEAR_OP__` to use no logging (automatic if `_DEBUG` is not
 	defined).
 
@@ -55,6 +59,42 @@
 	class template, Pass the object with which error_base methods can be 
 	called.
 
+	- Call `debug::setAsync(true)` to write logs from a background thread
+	instead of the calling thread.
+
+	- Call `debug::setWriteBackend(debug::write_backend::uring)` before it to
+	have the background thread write through io_uring on Linux.
+
+	- With asynchronous writing, call `debug::setDeferredFormatting(true)` 
+	to have LOG_VAL of trivially copyable values formatted by the writer
+	thread.
+
+	- Log files are buffered, call `debug::flush` before reading them while
+	the program runs (for example before an expected crash).
+
+	- Call `debug::setFlightRecorder(bytes)` to keep only the latest records
+	of each thread in memory, written out by `debug::dump` or on a crash.
+
+	- Call `debug::setRotation` to bound the size of log files, and 
+	`debug::setSingleFile` to log all threads into one file.
+
+	- Call `debug::setCompression` to write log files as zstd frames (with
+	ENH_LOG_ZSTD defined while compiling `logger.cpp`), and
+	`debug::writeSiteDictionary` to save the logging points of a run as the
+	dictionary of the next.
+
+	- Call `debug::setSiteEnabled(__FILE__, line, false)` to silence the 
+	logging at line, its argument is not evaluated while silenced.
+
+	- Call `debug::setSiteSampling(__FILE__, line, n, k)` to log 1 in n 
+	calls and at most k per second at line, each record says how many calls
+	it stands for.
+
+	- Call `debug::setTracing(true)` to log trace events of `TRACE_BEGIN`, 
+	`TRACE_END`, `TRACE_INSTANT`, `TRACE_FLOW_START` and `TRACE_FLOW_END`
+	(and of LOG_SCOPE, queued_process and timer), then convert the logs with
+	`log_decoder -c` to view them in chrome://tracing or Perfetto.
+
 	- Use `REPLACE` for expressions to be evaluated only during debug.
 
 	- Use `REPLACE_AS` for expression with different values during debug and
@@ -77,11 +117,21 @@
 
 #define LOGGER_ENH_H				logger.enh.h
 
+#include <chrono>
 #include <filesystem>
 #include <thread>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <iomanip>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 
 
@@ -119,6 +169,269 @@
 namespace debug
 {
 
+	/**
+		\brief What a log call does if the queue of the asynchronous writer 
+		is full.
+	*/
+	enum class overflow_policy
+	{
+		block,				/**< : Wait for space (default).*/
+		drop,				/**< : Discard the line.*/
+		count_drops			/**< : Discard the line and count it, see 
+							droppedLogs.*/
+	};
+
+	/**
+		\brief Turns asynchronous logging on or off.
+
+		When on, log calls only push the formatted line to a lock-free queue
+		and a background thread writes them to the files in batches. Turning
+		it off (or exiting the program) waits till every queued line is 
+		written.\n\n
+
+		The queue holds ENH_LOG_QUEUE_SIZE lines (8192 if not defined while 
+		compiling `logger.cpp`, must be a power of 2).
+	*/
+	void setAsync(
+		bool enable /**< : <i>in</i> : true to log asynchronously.*/,
+		overflow_policy overflow = overflow_policy::block /**< : <i>in</i> :
+						What to do when the queue is full.*/
+	);
+
+	/**
+		\brief The number of lines discarded with overflow_policy::count_drops.
+	*/
+	std::size_t droppedLogs();
+
+	/**
+		\brief How the asynchronous writer writes its files.
+	*/
+	enum class write_backend
+	{
+		stream,				/**< : Buffered file streams (default).*/
+		uring				/**< : io_uring writes from two aligned buffers,
+							one filled while the other is written (Linux 5.6
+							or later).*/
+	};
+
+	/**
+		\brief Sets how the asynchronous writer writes files it opens after
+		the call, call before setAsync.
+
+		With write_backend::uring each file has two buffers of
+		ENH_LOG_URING_BUFFER bytes (262144 if not defined while compiling
+		`logger.cpp`), registered with the ring when RLIMIT_MEMLOCK allows.
+		A full buffer is submitted and logging goes on in the other, a flush
+		waits for both. With direct the files are opened with O_DIRECT,
+		bypassing the page cache : whole 4096 byte blocks go through the
+		ring and the part of a block left at a flush is written normally,
+		then again whole. File systems refusing O_DIRECT are written
+		without it, and a file io_uring cannot be used for falls back to a
+		stream.
+
+		<h3>Return</h3>
+		false if io_uring is not compiled in or not permitted here, the
+		backend is then unchanged.\n
+	*/
+	bool setWriteBackend(
+		write_backend backend /**< : <i>in</i> : The backend.*/,
+		bool direct = false /**< : <i>in</i> : Open files with O_DIRECT.*/
+	);
+
+	/**
+		\brief Writes out every buffered log line of all threads, and waits 
+		for asynchronous writing to catch up.
+
+		Each thread keeps its log file open with a buffer of 
+		ENH_LOG_BUFFER_SIZE bytes (65536 if not defined while compiling 
+		`logger.cpp`), flushed at the flush interval and when the thread 
+		exits.
+	*/
+	void flush();
+
+	/**
+		\brief Sets the longest time a logged line may stay in the buffer of
+		a thread (100 ms by default), 0 writes every line at once.
+
+		The buffer is only flushed by a log call, call flush to write it 
+		out while a thread does not log.
+	*/
+	void setFlushInterval(
+		std::chrono::milliseconds interval /**< : <i>in</i> : The interval.*/
+	);
+
+	/**
+		\brief Turns the flight recorder on with a ring of bytes for each
+		thread, 0 turns it off (the default).
+
+		While on, records are encoded in binary format into a memory mapped
+		file `<name>.ring` per thread holding only the latest records, and
+		nothing else is written, a log call only copies the record into 
+		memory of the thread. Being mapped, the file keeps its contents if
+		the program dies. Call dump to write the rings as `.blog` files,
+		`tools/log_decoder.cpp` also reads `.ring` files.\n\n
+
+		The thread and logging points are described apart from the ring in
+		ENH_LOG_SITE_REGION bytes (65536 if not defined while compiling 
+		`logger.cpp`), points past it are not recorded. On a crash the rings
+		of at most ENH_LOG_CRASH_RINGS threads (256 if not defined) are 
+		written.
+	*/
+	void setFlightRecorder(
+		std::size_t bytes /**< : <i>in</i> : The ring size of a thread.*/,
+		bool dumpOnCrash = true /**< : <i>in</i> : On POSIX systems, write
+						the rings as on dump on SIGSEGV, SIGBUS, SIGABRT,
+						SIGFPE and SIGILL with only open and write, then
+						pass the signal on to the handler set before (or
+						the default action). Handlers set later must chain
+						to it.*/
+	);
+
+	/**
+		\brief Writes the flight recorder ring of every running thread to
+		`<name>.dump.blog`, replacing an earlier dump.
+	*/
+	void dump();
+
+	/**
+		\brief The limits past which log files are rotated.
+
+		A rotated file is renamed `<name>.<n>.<ext>` (n counting up) and 
+		logging goes on in a new file of the old name. 0 turns a limit off.
+	*/
+	struct rotation_policy
+	{
+		std::uintmax_t maxFileBytes = 0;		/**< : Size at which a file is
+											rotated.*/
+		std::chrono::seconds maxFileAge{ 0 };	/**< : Time after which a file
+											is rotated.*/
+		std::uintmax_t maxTotalBytes = 0;		/**< : Size the rotated files 
+											may take in total, the oldest 
+											are deleted past it.*/
+	};
+
+	/**
+		\brief Sets the rotation of log files (none by default).
+
+		Files are checked when buffers are flushed, so a file may grow past
+		maxFileBytes by up to a flush interval of logging. Binary files are
+		only rotated while logging synchronously.
+	*/
+	void setRotation(
+		const rotation_policy& policy /**< : <i>in</i> : The limits.*/
+	);
+
+	/**
+		\brief Writes the text logs of all threads to one file, an empty 
+		path goes back to a file per thread (the default).
+
+		Every line starts with the id of the thread that logged it, and 
+		each thread writes its `Thread id` line on first use. Lines are 
+		buffered per thread and appended whole. Call before logging starts,
+		binary logs stay one file per thread.
+	*/
+	void setSingleFile(
+		std::filesystem::path file /**< : <i>in</i> : The file.*/
+	);
+
+	/**
+		\brief The compression of log files.
+	*/
+	enum class log_compression
+	{
+		none,				/**< : Plain files (default).*/
+		zstd				/**< : zstd frames in `<file>.zst`, needs
+							ENH_LOG_ZSTD defined while compiling
+							`logger.cpp` (link libzstd).*/
+	};
+
+	/**
+		\brief How log files are compressed.
+	*/
+	struct compression_policy
+	{
+		log_compression method = log_compression::none;	/**< : The method.*/
+		int level = 3;						/**< : The zstd level, low is
+											fast.*/
+		std::filesystem::path dictionary;	/**< : A zstd dictionary (or
+											any file as raw content, like one
+											from writeSiteDictionary), empty
+											for none.*/
+	};
+
+	/**
+		\brief Sets the compression of log files opened after the call, call
+		before logging starts.
+
+		Text and binary files get `.zst` appended to their names. Writes are
+		gathered in buffers of ENH_LOG_BUFFER_SIZE bytes and each flush of a
+		buffer is compressed as one zstd frame, so a file cut short (like by a
+		crash) loses at most the frame being written. Rotation limits apply
+		to the compressed sizes, flight recorder rings and dumps are not
+		compressed.\n\n
+
+		Read the files with `zstd -d` (`-D` dictionary if one was set), or
+		`tools/log_decoder.cpp` built with ENH_LOG_ZSTD for `.blog.zst`.
+
+		<h3>Return</h3>
+		false if the method is not compiled in or the dictionary cannot be
+		read, compression is then unchanged.\n
+	*/
+	bool setCompression(
+		const compression_policy& policy /**< : <i>in</i> : The compression.*/
+	);
+
+	/**
+		\brief Writes the text and binary layout of every logging point
+		logged so far, to use as the dictionary of a later run.
+
+		Log records repeat the file, function and line of their point, so
+		with the points of a run as the dictionary even small frames
+		compress well.
+
+		<h3>Return</h3>
+		false if the file cannot be written.\n
+	*/
+	bool writeSiteDictionary(
+		const std::filesystem::path& file /**< : <i>in</i> : The file.*/
+	);
+
+	/**
+		\brief The optimisation level applied while running, set through
+		setOptimisation.
+	*/
+	inline std::atomic<int> runtimeOptimisation{ 0 };
+
+	/**
+		\brief Sets the optimisation level applied while running.
+
+		Works like ENH_OPTIMISATION on the logging compiled in : O# logging
+		only logs if # is greater than level, so 0 (the default) logs all
+		and 5 none. The level is one relaxed atomic, checked before the 
+		logged value is evaluated.\n\n
+
+		The environment variable ENH_LOG_OPTIMISATION sets the starting
+		level.
+	*/
+	void setOptimisation(
+		int level /**< : <i>in</i> : The level, 0 to 5.*/
+	);
+
+	/**
+		\brief The optimisation level applied while running.
+	*/
+	int getOptimisation();
+
+	/**
+		\brief Checks if O# logging with # as level logs at the current
+		runtime level.
+	*/
+	inline bool levelActive(
+		int level /**< : <i>in</i> : The level of the logging, 1 to 5.*/
+	) noexcept
+	{
+		return level > runtimeOptimisation.load(std::memory_order_relaxed);
+	}
 
 	/**
 		\brief The file to get which file to log into.
@@ -133,6 +446,442 @@ namespace debug
 	);
 
 
+	/**
+		\brief The formats log records are written in.
+	*/
+	enum class log_format
+	{
+		text,				/**< : Readable lines in `.log` files (default).*/
+		binary				/**< : Compact records in `.blog` files, read them
+							with `tools/log_decoder.cpp`.*/
+	};
+
+	/**
+		\brief Sets the format of log records written after the call.
+
+		In binary format the file, function and line of every logging point
+		are written once per thread, then each record is only the id of the
+		point, a time stamp and the value logged, with no text formatting.
+	*/
+	void setFormat(
+		log_format fmt /**< : <i>in</i> : The format.*/
+	);
+
+	/**
+		\brief Sets how many records of a binary file one entry of its index
+		covers (1024 by default), 0 writes no index.
+
+		Each `.blog` file gets a `.blog.idx` beside it (moved with it on
+		rotation) holding, per block of records, its offset, first and last
+		time and the logging points in it, and where each point is
+		described. `log_decoder -q from until` uses it to decode only the
+		blocks of a time window. Compressed files are not indexed. Applies
+		to files opened after the call.
+	*/
+	void setIndexInterval(
+		std::uint32_t records /**< : <i>in</i> : Records per entry.*/
+	);
+
+	/**
+		\brief The hash identifying the logging point at line of file.
+
+		file is the path as given by `__FILE__` at the point.
+	*/
+	constexpr std::uint64_t site_hash(
+		std::string_view file /**< : <i>in</i> : The file of the point.*/,
+		unsigned long line /**< : <i>in</i> : The line of the point.*/
+	) noexcept
+	{
+		std::uint64_t hash = 14695981039346656037ull;
+		for (char c : file)
+			hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+		for (int i = 0; i < 4; ++i)
+			hash = (hash ^ ((line >> (8 * i)) & 0xff)) * 1099511628211ull;
+		return hash;
+	}
+
+	/**
+		\brief The part of a logging point that changes while running.
+
+		Constant initialised, so it needs no guard on first use.
+	*/
+	struct site_state
+	{
+		std::atomic<std::uint32_t> id;			/**< : The id of the point in
+										binary files, 0 till first needed.*/
+		std::atomic<std::uint32_t> generation;	/**< : The revision of the 
+										setSiteEnabled rules enabled holds.*/
+		std::atomic<bool> enabled;				/**< : false if the point is
+										disabled.*/
+		std::atomic<std::uint32_t> every;		/**< : Log 1 in every calls, 0
+										or 1 for all.*/
+		std::atomic<std::uint32_t> perSecond;	/**< : Most records each 
+										second, 0 for no limit.*/
+		std::atomic<std::int64_t> window;		/**< : The second perSecond is
+										counted in.*/
+		std::atomic<std::uint32_t> inWindow;	/**< : Records logged in 
+										window.*/
+
+		constexpr site_state() noexcept : id(0), generation(0), enabled(true),
+			every(0), perSecond(0), window(0), inWindow(0) 
+		{}
+	};
+
+	/**
+		\brief The sampling state of a logging point in one thread, kept in a
+		`static thread_local` beside the point.
+
+		Constant initialised and trivially destructible, so it needs no guard 
+		on first use.
+	*/
+	struct site_sample
+	{
+		std::uint32_t countdown;	/**< : Calls left to skip plus one, 0 or 1
+									to check the point at the next call.*/
+		std::uint32_t span;			/**< : The calls the countdown was set
+									to.*/
+		std::uint64_t carry;		/**< : Calls skipped by the rate limit, 
+									added to the next record.*/
+
+		constexpr site_sample() noexcept : countdown(0), span(0), carry(0) {}
+	};
+
+	/**
+		\brief A logging point in code, a `static constexpr` object built at 
+		compile time by the logging macros and passed by address.
+	*/
+	struct call_site
+	{
+		std::string_view file;		/**< : The file of the point.*/
+		std::string_view function;	/**< : The function of the point.*/
+		unsigned long line;			/**< : The line of the point.*/
+		std::string_view var;		/**< : The expression logged by LOG_VAL.*/
+		std::uint64_t hash;			/**< : site_hash of file and line.*/
+		site_state* state;			/**< : The runtime state of the point.*/
+
+		/**
+			\brief Creates the point.
+		*/
+		constexpr call_site(
+			std::string_view file_ /**< : <i>in</i> : The file.*/,
+			std::string_view function_ /**< : <i>in</i> : The function.*/,
+			unsigned long line_ /**< : <i>in</i> : The line.*/,
+			std::string_view var_ /**< : <i>in</i> : The expression logged.*/,
+			site_state* state_ /**< : <i>in</i> : The runtime state.*/
+		) noexcept : file(file_), function(function_), line(line_), var(var_),
+			hash(site_hash(file_, line_)), state(state_)
+		{}
+	};
+
+	/**
+		\brief Enables or disables the logging points at line of file.
+
+		file is the path as given by `__FILE__`, the rule also applies to 
+		points not reached yet. Each point looks the rules up again only after
+		they change.
+	*/
+	void setSiteEnabled(
+		std::string_view file /**< : <i>in</i> : The file of the point.*/,
+		unsigned long line /**< : <i>in</i> : The line of the point.*/,
+		bool enable /**< : <i>in</i> : false to stop logging there.*/
+	);
+
+	/**
+		\brief Logs only some calls of the logging points at line of file, 1 
+		in every calls and at most perSecond records each second.
+
+		Skipped calls cost a decrement of a thread local counter and their 
+		argument is not evaluated. Each record logged then says how many 
+		calls it stands for, as `[x n]` at the end in text and a sample 
+		record before it in binary. The count runs per thread, the rate 
+		limit is shared by all threads. Trace points should not be sampled,
+		their begin and end would no longer pair.
+	*/
+	void setSiteSampling(
+		std::string_view file /**< : <i>in</i> : The file of the point.*/,
+		unsigned long line /**< : <i>in</i> : The line of the point.*/,
+		std::uint32_t every /**< : <i>in</i> : Log 1 call in every, 0 or 1 
+							for all.*/,
+		std::uint32_t perSecond = 0 /**< : <i>in</i> : Most records each 
+									second, 0 for no limit.*/
+	);
+
+	/**
+		\brief Enables all logging points again and stops all sampling.
+	*/
+	void clearSiteRules();
+
+	/**
+		\brief Checks if a logging point is enabled.
+	*/
+	bool isEnabled(
+		const call_site& site /**< : <i>in</i> : The logging point.*/
+	);
+
+	/**
+		\brief Checks if this call of a logging point is logged, after the
+		countdown of sample ran out.
+
+		Sets the count of calls the next record of the thread stands for.
+	*/
+	bool isSampled(
+		const call_site& site /**< : <i>in</i> : The logging point.*/,
+		site_sample& sample /**< : <i>inout</i> : The sampling state of the
+							point in this thread.*/
+	);
+
+	/**
+		\brief Logs completion of the line of a logging point.
+	*/
+	void Log(
+		const call_site& site /**< : <i>in</i> : The logging point.*/
+	);
+
+	/**
+		\brief Logs a string at a logging point.
+	*/
+	void LogDesc(
+		const call_site& site /**< : <i>in</i> : The logging point.*/,
+		const std::string& descr /**< : <i>in</i> : The string to log.*/
+	);
+
+	/**
+		\brief The kinds of trace event, with the phase letters of the Chrome 
+		trace event format.
+	*/
+	enum class trace_phase : char
+	{
+		begin = 'B',			/**< : A span starts.*/
+		end = 'E',				/**< : The last span started on the thread
+								ends.*/
+		instant = 'i',			/**< : A point in time.*/
+		flow_start = 's',		/**< : An arrow starts in the enclosing 
+								span.*/
+		flow_end = 'f'			/**< : The arrow of the same id ends in the
+								enclosing span.*/
+	};
+
+	/**
+		\brief true while trace events are logged, see setTracing.
+	*/
+	inline std::atomic<bool> tracingActive{ false };
+
+	/**
+		\brief The last flow id given out by newFlowId.
+	*/
+	inline std::atomic<std::uint64_t> lastFlowId{ 0 };
+
+	/**
+		\brief Turns logging of trace events (the TRACE_ macros, LOG_SCOPE 
+		spans, queue flows and timer ticks) on or off.
+
+		Off by default, every trace point then costs one relaxed load. Use
+		with binary format and asynchronous writing for low overhead, and 
+		`log_decoder -c` to turn the files into a Chrome trace / Perfetto 
+		JSON file.
+	*/
+	inline void setTracing(
+		bool enable /**< : <i>in</i> : true to log trace events.*/
+	) noexcept
+	{
+		tracingActive.store(enable, std::memory_order_relaxed);
+	}
+
+	/**
+		\brief Checks if trace events are logged.
+	*/
+	inline bool isTracing() noexcept
+	{
+		return tracingActive.load(std::memory_order_relaxed);
+	}
+
+	/**
+		\brief A new id to link a flow_start to its flow_end, 0 if not 
+		tracing.
+	*/
+	inline std::uint64_t newFlowId() noexcept
+	{
+		return isTracing() ? lastFlowId.fetch_add(1, std::memory_order_relaxed) + 1 : 0;
+	}
+
+	/**
+		\brief Logs a trace event of the logging point (named by its var) at
+		this time.
+
+		In binary format it is a trace record (see `logger.cpp`), in text 
+		it is a line `trace phase id`.
+	*/
+	void LogTrace(
+		const call_site& site /**< : <i>in</i> : The logging point.*/,
+		trace_phase phase /**< : <i>in</i> : The kind of event.*/,
+		std::uint64_t id = 0 /**< : <i>in</i> : The flow id, 0 for spans
+							 and instants.*/
+	);
+
+	/**
+		\brief Logs a value formatted as a string at a logging point.
+	*/
+	void LogValue(
+		const call_site& site /**< : <i>in</i> : The logging point.*/,
+		std::string_view val /**< : <i>in</i> : The value.*/
+	);
+
+	/**
+		\brief Logs a signed integer at a logging point.
+	*/
+	void LogValue(
+		const call_site& site /**< : <i>in</i> : The logging point.*/,
+		long long val /**< : <i>in</i> : The value.*/
+	);
+
+	/**
+		\brief Logs an unsigned integer at a logging point.
+	*/
+	void LogValue(
+		const call_site& site /**< : <i>in</i> : The logging point.*/,
+		unsigned long long val /**< : <i>in</i> : The value.*/
+	);
+
+	/**
+		\brief Logs a floating point value at a logging point.
+	*/
+	void LogValue(
+		const call_site& site /**< : <i>in</i> : The logging point.*/,
+		double val /**< : <i>in</i> : The value.*/
+	);
+
+	/**
+		\brief Logs a bool at a logging point.
+	*/
+	void LogValue(
+		const call_site& site /**< : <i>in</i> : The logging point.*/,
+		bool val /**< : <i>in</i> : The value.*/
+	);
+
+	/**
+		\brief The function that formats a value copied as raw bytes.
+	*/
+	using value_formatter = void(*)(std::ostream&, const void*);
+
+	/**
+		\brief Formats the value of type T stored as raw bytes at raw (not
+		necessarily aligned).
+	*/
+	template<class T>
+	void format_raw(
+		std::ostream& out /**< : <i>in</i> : The stream to write to.*/,
+		const void* raw /**< : <i>in</i> : The bytes of the value.*/
+	)
+	{
+		alignas(T) unsigned char store[sizeof(T)];
+		std::memcpy(store, raw, sizeof(T));
+		out << *std::launder(reinterpret_cast<const T*>(store));
+	}
+
+	/**
+		\brief Turns deferred formatting of logged values on or off (off by
+		default).
+
+		When on, in text format while logging asynchronously, LOG_VAL of a 
+		trivially copyable value only copies its bytes and the writer thread
+		formats the line. The value must not refer to other memory (a 
+		struct holding a pointer, for example), only pointers and 
+		std::string_view are detected and formatted at once.
+	*/
+	void setDeferredFormatting(
+		bool enable /**< : <i>in</i> : true to defer formatting.*/
+	);
+
+	/**
+		\brief Logs a trivially copyable value at a logging point, formatted
+		by format on the writer thread if deferred formatting applies, else
+		at once.
+	*/
+	void LogDeferred(
+		const call_site& site /**< : <i>in</i> : The logging point.*/,
+		const void* val /**< : <i>in</i> : The bytes of the value.*/,
+		std::size_t size /**< : <i>in</i> : The size of the value.*/,
+		value_formatter format /**< : <i>in</i> : Formats the bytes.*/
+	);
+
+	/**
+		\brief Logs a value at a logging point.
+
+		Numbers are kept as numbers in binary format, other types are 
+		formatted with the stream insertion operator, on the writer thread
+		for trivially copyable types if deferred formatting is on.
+	*/
+	template<class T>
+	void LogVal(
+		const call_site& site /**< : <i>in</i> : The logging point.*/,
+		const T& val /**< : <i>in</i> : The value.*/
+	)
+	{
+		using type = std::decay_t<T>;
+		constexpr bool isChar = std::is_same_v<type, char> 
+			|| std::is_same_v<type, signed char> 
+			|| std::is_same_v<type, unsigned char>
+			|| std::is_same_v<type, wchar_t>;
+		if constexpr (std::is_same_v<type, bool>)
+			LogValue(site, val);
+		else if constexpr (std::is_integral_v<type> && !isChar 
+			&& std::is_signed_v<type>)
+			LogValue(site, static_cast<long long>(val));
+		else if constexpr (std::is_integral_v<type> && !isChar)
+			LogValue(site, static_cast<unsigned long long>(val));
+		else if constexpr (std::is_floating_point_v<type> 
+			&& !std::is_same_v<type, long double>)
+			LogValue(site, static_cast<double>(val));
+		else if constexpr (std::is_trivially_copyable_v<type> 
+			&& !std::is_array_v<T> && !std::is_pointer_v<type>
+			&& !std::is_same_v<type, std::string_view>)
+			LogDeferred(site, std::addressof(val), sizeof(type), 
+				&format_raw<type>);
+		else
+		{
+			std::ostringstream out;
+			out << val;
+			LogValue(site, out.str());
+		}
+	}
+
+	/**
+		\brief Logs a value at a logging point, like LogVal, formatting
+		types without a binary form in a stream buffer from alloc, so the
+		formatting of one request can be released with its arena.
+	*/
+	template<class T, class Alloc>
+	void LogVal(
+		const call_site& site /**< : <i>in</i> : The logging point.*/,
+		const T& val /**< : <i>in</i> : The value.*/,
+		const Alloc& alloc /**< : <i>in</i> : The allocator of the 
+						   formatting buffer.*/
+	)
+	{
+		using type = std::decay_t<T>;
+		if constexpr (std::is_arithmetic_v<type> || (std::is_trivially_copyable_v<type>
+			&& !std::is_array_v<T> && !std::is_pointer_v<type>
+			&& !std::is_same_v<type, std::string_view>))
+			LogVal(site, val);
+		else
+		{
+			using char_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<char>;
+			// the buffer copies the allocator of the (empty) initial string
+			const std::basic_string<char, std::char_traits<char>, char_alloc> text{
+				char_alloc(alloc) };
+			std::basic_ostringstream<char, std::char_traits<char>, char_alloc> out(
+				text, std::ios_base::out);
+			out << val;
+			LogValue(site, std::string_view(out.str()));
+		}
+	}
+
+	/**
+		\brief The threads that have logged, with the function each first 
+		logged from (which names its log file).
+	*/
+	std::vector<std::pair<std::thread::id, std::string>> registeredThreads();
+
 	/**
 		\brief Logs a string to a file indicated byt current thread.
 
@@ -648,343 +1397,462 @@ namespace debug
 */
 #define INFO_FOR_LOG		__FILE__,__func__,__LINE__
 
+/**
+	\brief Declares the logging point at the place of use as enh_log_site_.
+
+	The point is a `static constexpr debug::call_site` for the file, function
+	and line of use, and the expression text var, so nothing is built or 
+	allocated when logging.
+*/
+#define LOG_SITE(var)		static debug::site_state enh_log_state_;\
+	static constexpr debug::call_site enh_log_site_(__FILE__, __func__,\
+		__LINE__, var, &enh_log_state_)
+
+/**
+	\brief Runs the statement x with the logging point declared, if the point
+	is enabled and this call is sampled.
+
+	A call skipped by sampling only decrements a thread local counter.
+*/
+#define LOG_AT_SITE(var, x)	do { LOG_SITE(var);\
+	static thread_local debug::site_sample enh_log_sample_;\
+	if (enh_log_sample_.countdown > 1) --enh_log_sample_.countdown;\
+	else if (debug::isSampled(enh_log_site_, enh_log_sample_)) x; } while (false)
+
+/**
+	\brief Runs the statement x only if logging at level is active at the
+	runtime optimisation level, see debug::setOptimisation.
+*/
+#define LEVEL_GATE(level, x)	do { if (debug::levelActive(level)) { x; }\
+	} while (false)
+
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined.
 */
-#define LOG_LINE REPLACE(debug::Log(INFO_FOR_LOG))
+#define LOG_LINE REPLACE(LOG_AT_SITE("", debug::Log(enh_log_site_)))
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined.
 */
-#define LOG_DESC(x) REPLACE(debug::Log(INFO_FOR_LOG,x))
+#define LOG_DESC(x) REPLACE(LOG_AT_SITE("", debug::LogDesc(enh_log_site_, x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,#x,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined.
 */
-#define LOG_VAL(x) REPLACE(debug::Log(INFO_FOR_LOG,#x,x))
+#define LOG_VAL(x) REPLACE(LOG_AT_SITE(#x, debug::LogVal(enh_log_site_, x)))
 
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined 
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined.
 */
-#define LIB_LOG_LINE LIB_REPLACE(debug::Log(INFO_FOR_LOG))
+#define LIB_LOG_LINE LIB_REPLACE(LOG_AT_SITE("", debug::Log(enh_log_site_)))
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined 
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined.
 */
-#define LIB_LOG_DESC(x) LIB_REPLACE(debug::Log(INFO_FOR_LOG,x))
+#define LIB_LOG_DESC(x) LIB_REPLACE(LOG_AT_SITE("", debug::LogDesc(enh_log_site_, x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,#x,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined 
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined.
 */
-#define LIB_LOG_VAL(x) LIB_REPLACE(debug::Log(INFO_FOR_LOG,#x,x))
+#define LIB_LOG_VAL(x) LIB_REPLACE(LOG_AT_SITE(#x, debug::LogVal(enh_log_site_, x)))
+
+/**
+	\brief Runs debug::LogTrace of phase and id at LOG_SITE(name) if tracing.
+*/
+#define TRACE_AT(phase, name, id)	do { if (debug::isTracing())\
+	LOG_AT_SITE(name, debug::LogTrace(enh_log_site_, phase, id)); } while (false)
+
+/**
+	\brief The Macro to begin a trace span named name on this thread.
+
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if ENH_OPTIMISATION is greater than 4.
+*/
+#define TRACE_BEGIN(name)	O5_REPLACE(TRACE_AT(debug::trace_phase::begin, name, 0))
+
+/**
+	\brief The Macro to end the last trace span begun on this thread.
+
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if ENH_OPTIMISATION is greater than 4.
+*/
+#define TRACE_END(name)		O5_REPLACE(TRACE_AT(debug::trace_phase::end, name, 0))
+
+/**
+	\brief The Macro to mark a trace instant named name.
+
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if ENH_OPTIMISATION is greater than 4.
+*/
+#define TRACE_INSTANT(name)	O5_REPLACE(TRACE_AT(debug::trace_phase::instant, name, 0))
+
+/**
+	\brief The Macro to get a new flow id, evaluates to debug::newFlowId if
+	DEBUG is defined, else to 0.
+*/
+#define TRACE_FLOW_ID		O5_REPLACE_AS(debug::newFlowId(), std::uint64_t(0))
+
+/**
+	\brief The Macro to start a trace arrow of id (from TRACE_FLOW_ID) in the
+	enclosing span.
+
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if ENH_OPTIMISATION is greater than 4.
+*/
+#define TRACE_FLOW_START(name, id)	O5_REPLACE(TRACE_AT(debug::trace_phase::flow_start, name, id))
+
+/**
+	\brief The Macro to end the trace arrow of id in the enclosing span.
+
+	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
+	or if ENH_OPTIMISATION is greater than 4.
+*/
+#define TRACE_FLOW_END(name, id)	O5_REPLACE(TRACE_AT(debug::trace_phase::flow_end, name, id))
+
+/**
+	\brief The Macro to begin a trace span, also blank if 
+	IGNORE_ENHANCE_DIAGNOSTICS is defined.
+*/
+#define LIB_TRACE_BEGIN(name)	O5_LIB_REPLACE(TRACE_AT(debug::trace_phase::begin, name, 0))
+
+/**
+	\brief The Macro to end a trace span, also blank if 
+	IGNORE_ENHANCE_DIAGNOSTICS is defined.
+*/
+#define LIB_TRACE_END(name)		O5_LIB_REPLACE(TRACE_AT(debug::trace_phase::end, name, 0))
+
+/**
+	\brief The Macro to mark a trace instant, also blank if 
+	IGNORE_ENHANCE_DIAGNOSTICS is defined.
+*/
+#define LIB_TRACE_INSTANT(name)	O5_LIB_REPLACE(TRACE_AT(debug::trace_phase::instant, name, 0))
+
+/**
+	\brief The Macro to get a new flow id, also 0 if 
+	IGNORE_ENHANCE_DIAGNOSTICS is defined.
+*/
+#define LIB_TRACE_FLOW_ID		O5_REPLACE_AS(LIB_REPLACE_AS(debug::newFlowId(),\
+	std::uint64_t(0)), std::uint64_t(0))
+
+/**
+	\brief The Macro to start a trace arrow, also blank if 
+	IGNORE_ENHANCE_DIAGNOSTICS is defined.
+*/
+#define LIB_TRACE_FLOW_START(name, id)	O5_LIB_REPLACE(TRACE_AT(debug::trace_phase::flow_start, name, id))
+
+/**
+	\brief The Macro to end a trace arrow, also blank if 
+	IGNORE_ENHANCE_DIAGNOSTICS is defined.
+*/
+#define LIB_TRACE_FLOW_END(name, id)	O5_LIB_REPLACE(TRACE_AT(debug::trace_phase::flow_end, name, id))
 
 
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 4.
 */
-#define O5_LOG_LINE		O5_REPLACE(LOG_LINE)
+#define O5_LOG_LINE		O5_REPLACE(LEVEL_GATE(5, LOG_LINE))
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 4.
 */
-#define O5_LOG_DESC(x)	O5_REPLACE(LOG_DESC(x))
+#define O5_LOG_DESC(x)	O5_REPLACE(LEVEL_GATE(5, LOG_DESC(x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG, #x, x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 4.
 */
-#define O5_LOG_VAL(x)	O5_REPLACE(LOG_VAL(x))
+#define O5_LOG_VAL(x)	O5_REPLACE(LEVEL_GATE(5, LOG_VAL(x)))
 
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 3.
 */
-#define O4_LOG_LINE		O4_REPLACE(LOG_LINE)
+#define O4_LOG_LINE		O4_REPLACE(LEVEL_GATE(4, LOG_LINE))
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 3.
 */
-#define O4_LOG_DESC(x)	O4_REPLACE(LOG_DESC(x))
+#define O4_LOG_DESC(x)	O4_REPLACE(LEVEL_GATE(4, LOG_DESC(x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG, #x, x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 3.
 */
-#define O4_LOG_VAL(x)	O4_REPLACE(LOG_VAL(x))
+#define O4_LOG_VAL(x)	O4_REPLACE(LEVEL_GATE(4, LOG_VAL(x)))
 
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 2.
 */
-#define O3_LOG_LINE		O3_REPLACE(LOG_LINE)
+#define O3_LOG_LINE		O3_REPLACE(LEVEL_GATE(3, LOG_LINE))
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 2.
 */
-#define O3_LOG_DESC(x)	O3_REPLACE(LOG_DESC(x))
+#define O3_LOG_DESC(x)	O3_REPLACE(LEVEL_GATE(3, LOG_DESC(x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG, #x, x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 2.
 */
-#define O3_LOG_VAL(x)	O3_REPLACE(LOG_VAL(x))
+#define O3_LOG_VAL(x)	O3_REPLACE(LEVEL_GATE(3, LOG_VAL(x)))
 
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 1.
 */
-#define O2_LOG_LINE		O2_REPLACE(LOG_LINE)
+#define O2_LOG_LINE		O2_REPLACE(LEVEL_GATE(2, LOG_LINE))
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 1.
 */
-#define O2_LOG_DESC(x)	O2_REPLACE(LOG_DESC(x))
+#define O2_LOG_DESC(x)	O2_REPLACE(LEVEL_GATE(2, LOG_DESC(x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG, #x, x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 1.
 */
-#define O2_LOG_VAL(x)	O2_REPLACE(LOG_VAL(x))
+#define O2_LOG_VAL(x)	O2_REPLACE(LEVEL_GATE(2, LOG_VAL(x)))
 
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 0.
 */
-#define O1_LOG_LINE		O1_REPLACE(LOG_LINE)
+#define O1_LOG_LINE		O1_REPLACE(LEVEL_GATE(1, LOG_LINE))
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 0.
 */
-#define O1_LOG_DESC(x)	O1_REPLACE(LOG_DESC(x))
+#define O1_LOG_DESC(x)	O1_REPLACE(LEVEL_GATE(1, LOG_DESC(x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG, #x, x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if ENH_OPTIMISATION is greater than 0.
 */
-#define O1_LOG_VAL(x)	O1_REPLACE(LOG_VAL(x))
+#define O1_LOG_VAL(x)	O1_REPLACE(LEVEL_GATE(1, LOG_VAL(x)))
 
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is 
 	greater than 4.
 */
-#define O5_LIB_LOG_LINE		O5_LIB_REPLACE(LIB_LOG_LINE)
+#define O5_LIB_LOG_LINE		O5_LIB_REPLACE(LEVEL_GATE(5, LIB_LOG_LINE))
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is 
 	greater than 4.
 */
-#define O5_LIB_LOG_DESC(x)	O5_LIB_REPLACE(LIB_LOG_DESC(x))
+#define O5_LIB_LOG_DESC(x)	O5_LIB_REPLACE(LEVEL_GATE(5, LIB_LOG_DESC(x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,#x,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is 
 	greater than 4.
 */
-#define O5_LIB_LOG_VAL(x)	O5_LIB_REPLACE(LIB_LOG_VAL(x))
+#define O5_LIB_LOG_VAL(x)	O5_LIB_REPLACE(LEVEL_GATE(5, LIB_LOG_VAL(x)))
 
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 3.
 */
-#define O4_LIB_LOG_LINE		O4_LIB_REPLACE(LIB_LOG_LINE)
+#define O4_LIB_LOG_LINE		O4_LIB_REPLACE(LEVEL_GATE(4, LIB_LOG_LINE))
 
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 3.
 */
-#define O4_LIB_LOG_DESC(x)	O4_LIB_REPLACE(LIB_LOG_DESC(x))
+#define O4_LIB_LOG_DESC(x)	O4_LIB_REPLACE(LEVEL_GATE(4, LIB_LOG_DESC(x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,#x,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 3.
 */
-#define O4_LIB_LOG_VAL(x)	O4_LIB_REPLACE(LIB_LOG_VAL(x))
+#define O4_LIB_LOG_VAL(x)	O4_LIB_REPLACE(LEVEL_GATE(4, LIB_LOG_VAL(x)))
 
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 2.
 */
-#define O3_LIB_LOG_LINE		O3_LIB_REPLACE(LIB_LOG_LINE)
+#define O3_LIB_LOG_LINE		O3_LIB_REPLACE(LEVEL_GATE(3, LIB_LOG_LINE))
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 2.
 */
-#define O3_LIB_LOG_DESC(x)	O3_LIB_REPLACE(LIB_LOG_DESC(x))
+#define O3_LIB_LOG_DESC(x)	O3_LIB_REPLACE(LEVEL_GATE(3, LIB_LOG_DESC(x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,#x,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 2.
 */
-#define O3_LIB_LOG_VAL(x)	O3_LIB_REPLACE(LIB_LOG_VAL(x))
+#define O3_LIB_LOG_VAL(x)	O3_LIB_REPLACE(LEVEL_GATE(3, LIB_LOG_VAL(x)))
 
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 1.
 */
-#define O2_LIB_LOG_LINE		O2_LIB_REPLACE(LIB_LOG_LINE)
+#define O2_LIB_LOG_LINE		O2_LIB_REPLACE(LEVEL_GATE(2, LIB_LOG_LINE))
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 1.
 */
-#define O2_LIB_LOG_DESC(x)	O2_LIB_REPLACE(LIB_LOG_DESC(x))
+#define O2_LIB_LOG_DESC(x)	O2_LIB_REPLACE(LEVEL_GATE(2, LIB_LOG_DESC(x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,#x,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 1.
 */
-#define O2_LIB_LOG_VAL(x)	O2_LIB_REPLACE(LIB_LOG_VAL(x))
+#define O2_LIB_LOG_VAL(x)	O2_LIB_REPLACE(LEVEL_GATE(2, LIB_LOG_VAL(x)))
 
 /**
 	\brief The Macro to log line completion in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG) if DEBUG is defined.\n\n
+	Evaluates to debug::Log at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 0.
 */
-#define O1_LIB_LOG_LINE		O1_LIB_REPLACE(LIB_LOG_LINE)
+#define O1_LIB_LOG_LINE		O1_LIB_REPLACE(LEVEL_GATE(1, LIB_LOG_LINE))
 
 /**
 	\brief The Macro to log a string in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogDesc of x at LOG_SITE("") if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 0.
 */
-#define O1_LIB_LOG_DESC(x)	O1_LIB_REPLACE(LIB_LOG_DESC(x))
+#define O1_LIB_LOG_DESC(x)	O1_LIB_REPLACE(LEVEL_GATE(1, LIB_LOG_DESC(x)))
 
 /**
 	\brief The Macro to log a variable state in debug mode.
 
-	Evaluates to debug::Log(INFO_FOR_LOG,#x,x) if DEBUG is defined.\n\n
+	Evaluates to debug::LogVal of x at LOG_SITE(#x) if DEBUG is defined.\n\n
 	Evaluates to blank if DEBUG is not defined or if ENH_CLEAR_OP__ is defined
 	or if IGNORE_ENHANCE_DIAGNOSTICS is defined	or if ENH_OPTIMISATION is
 	greater than 0.
 */
-#define O1_LIB_LOG_VAL(x)	O1_LIB_REPLACE(LIB_LOG_VAL(x))
+#define O1_LIB_LOG_VAL(x)	O1_LIB_REPLACE(LEVEL_GATE(1, LIB_LOG_VAL(x)))
 #endif // !LOGGER_ENH_H
 
 
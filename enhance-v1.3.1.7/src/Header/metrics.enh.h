@@ -0,0 +1,980 @@
+/** ***************************************************************************
+	\file metrics.enh.h
+
+	\brief The file to declare the metrics registry, counters, gauges and
+	histograms registered by name, and their Prometheus and JSON exporters
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	<h3> How To Use</h3>
+
+	- Make a `metrics::counter`, `metrics::gauge` or `metrics::histogram`
+	with a name (and help text), usually static or a member, it is in
+	`metrics::registry::shared()` (or the registry passed) till destroyed.
+
+	- Update it on the hot path with `add`, `set` or `record`, a relaxed
+	atomic operation and nothing else.
+
+	- For statistics the library already keeps (queued_process::getStats,
+	timer::stats, debug::droppedLogs), keep the collector returned by
+	`metrics::collectQueue`, `metrics::collectTimer` or
+	`metrics::collectLogger`, they are read at each snapshot.
+
+	- Call `snapshot` of the registry from any thread, and
+	`metrics::to_prometheus` or `metrics::to_json` on it, or
+	`metrics::logSnapshot` to log the JSON.
+
+	- Define `ENH_CLEAR_OP__` to compile every metric to an empty object
+	with empty functions, snapshots are then empty.
+
+******************************************************************************/
+
+#ifndef METRICS_ENH_H
+
+#define METRICS_ENH_H					metrics.enh.h
+
+#include "general.enh.h"
+#include "histogram.enh.h"
+#include "logger.enh.h"
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace enh
+{
+
+	/**
+		\brief The namespace of the metrics registry and its metrics.
+	*/
+	namespace metrics
+	{
+
+		/**
+			\brief The kinds of metric.
+		*/
+		enum class metric_kind
+		{
+			counter,			/**< : A count that only rises.*/
+			gauge,				/**< : A level that rises and falls.*/
+			histogram			/**< : A distribution of values.*/
+		};
+
+		/**
+			\brief The value of a metric at a snapshot.
+		*/
+		struct sample
+		{
+			/**
+				\brief The name.
+			*/
+			std::string name;
+
+			/**
+				\brief The description.
+			*/
+			std::string help;
+
+			/**
+				\brief The kind.
+			*/
+			metric_kind kind = metric_kind::counter;
+
+			/**
+				\brief The count of a counter.
+			*/
+			std::uint64_t count = 0;
+
+			/**
+				\brief The level of a gauge.
+			*/
+			std::int64_t level = 0;
+
+			/**
+				\brief The values of a histogram.
+			*/
+			histogram_snapshot values;
+		};
+
+		/**
+			\brief A counter sample.
+		*/
+		inline sample counter_sample(
+			std::string name /**< : <i>in</i> : The name.*/,
+			std::string help /**< : <i>in</i> : The description.*/,
+			std::uint64_t count /**< : <i>in</i> : The count.*/
+		)
+		{
+			sample ret;
+			ret.name = std::move(name);
+			ret.help = std::move(help);
+			ret.kind = metric_kind::counter;
+			ret.count = count;
+			return ret;
+		}
+
+		/**
+			\brief A gauge sample.
+		*/
+		inline sample gauge_sample(
+			std::string name /**< : <i>in</i> : The name.*/,
+			std::string help /**< : <i>in</i> : The description.*/,
+			std::int64_t level /**< : <i>in</i> : The level.*/
+		)
+		{
+			sample ret;
+			ret.name = std::move(name);
+			ret.help = std::move(help);
+			ret.kind = metric_kind::gauge;
+			ret.level = level;
+			return ret;
+		}
+
+		/**
+			\brief A histogram sample.
+		*/
+		inline sample histogram_sample(
+			std::string name /**< : <i>in</i> : The name.*/,
+			std::string help /**< : <i>in</i> : The description.*/,
+			histogram_snapshot values /**< : <i>in</i> : The values.*/
+		)
+		{
+			sample ret;
+			ret.name = std::move(name);
+			ret.help = std::move(help);
+			ret.kind = metric_kind::histogram;
+			ret.values = std::move(values);
+			return ret;
+		}
+
+		/**
+			\brief The function type of a collector, appends its samples.
+		*/
+		using collect_method = std::function<void(std::vector<sample>&)>;
+
+#ifndef ENH_CLEAR_OP__
+
+		class registry;
+
+		/**
+			\brief The base of the metrics, reads the value for a snapshot.
+
+			Only the snapshot is virtual, updating a metric is not.\n\n
+
+			hasErrorHandlers        = false;\n
+		*/
+		class metric
+		{
+			friend class registry;
+
+			/**
+				\brief The registry it is in.
+			*/
+			registry* owner;
+
+			/**
+				\brief The name.
+			*/
+			std::string name;
+
+			/**
+				\brief The description.
+			*/
+			std::string help;
+
+		protected:
+
+			metric(registry& r, std::string_view n, std::string_view h);
+
+			~metric();
+
+			/**
+				\brief Writes the value into out.
+			*/
+			virtual void read(
+				sample& out /**< : <i>out</i> : The sample.*/
+			) const = 0;
+
+		public:
+
+			metric(const metric&) = delete;
+			metric& operator = (const metric&) = delete;
+
+			/**
+				\brief The name.
+			*/
+			inline const std::string& getName() const noexcept { return name; }
+		};
+
+		/**
+			\brief The class for the set of metrics and collectors read
+			together at a snapshot.
+
+			Registering, removing and snapshots lock a mutex, updating a
+			metric does not. A collector is called under that mutex, it must
+			not register or remove anything. Names should be unique in a
+			registry, as Prometheus expects.\n\n
+
+			hasErrorHandlers        = false;\n
+		*/
+		class registry
+		{
+			friend class metric;
+			friend class collector;
+
+			/**
+				\brief The mutex guarding metrics and collectors.
+			*/
+			mutable std::mutex mtx;
+
+			/**
+				\brief The metrics in the order registered.
+			*/
+			std::vector<const metric*> metrics;
+
+			/**
+				\brief The collectors with their ids.
+			*/
+			std::vector<std::pair<std::uint64_t, collect_method>> collectors;
+
+			/**
+				\brief The id of the next collector.
+			*/
+			std::uint64_t nextId = 1;
+
+			inline void add(const metric* m)
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				metrics.push_back(m);
+			}
+
+			inline void remove(const metric* m) noexcept
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				for (std::size_t i = 0; i < metrics.size(); ++i)
+					if (metrics[i] == m)
+					{
+						metrics.erase(metrics.begin() + i);
+						return;
+					}
+			}
+
+			inline std::uint64_t add(collect_method fn)
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				collectors.emplace_back(nextId, std::move(fn));
+				return nextId++;
+			}
+
+			inline void remove(std::uint64_t id) noexcept
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				for (std::size_t i = 0; i < collectors.size(); ++i)
+					if (collectors[i].first == id)
+					{
+						collectors.erase(collectors.begin() + i);
+						return;
+					}
+			}
+
+		public:
+
+			registry() = default;
+
+			registry(const registry&) = delete;
+			registry& operator = (const registry&) = delete;
+
+			/**
+				\brief The registry metrics are in if none is given.
+			*/
+			static inline registry& shared()
+			{
+				static registry instance;
+				return instance;
+			}
+
+			/**
+				\brief Reads every metric, then every collector.
+
+				Each value is read on its own with relaxed order, values
+				updated meanwhile may be off by the updates in flight.
+
+				<h3>Return</h3>
+				The samples, metrics in the order registered.\n
+			*/
+			inline std::vector<sample> snapshot() const
+			{
+				std::vector<sample> ret;
+				std::lock_guard<std::mutex> lock(mtx);
+				ret.reserve(metrics.size());
+				for (const metric* m : metrics)
+				{
+					ret.emplace_back();
+					ret.back().name = m->name;
+					ret.back().help = m->help;
+					m->read(ret.back());
+				}
+				for (auto& c : collectors)
+					c.second(ret);
+				return ret;
+			}
+
+			/**
+				\brief The number of metrics registered.
+			*/
+			inline std::size_t size() const
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				return metrics.size();
+			}
+		};
+
+		inline metric::metric(registry& r, std::string_view n, std::string_view h)
+			: owner(&r), name(n), help(h)
+		{
+			owner->add(this);
+		}
+
+		inline metric::~metric()
+		{
+			owner->remove(this);
+		}
+
+		/**
+			\brief The class for a count that only rises, like messages
+			posted.
+
+			hasErrorHandlers        = false;\n
+		*/
+		class counter : public metric
+		{
+			/**
+				\brief The count, on its own cache line.
+			*/
+			alignas(cache_line_size) std::atomic<std::uint64_t> value{ 0 };
+
+			inline void read(sample& out) const override
+			{
+				out.kind = metric_kind::counter;
+				out.count = value.load(std::memory_order_relaxed);
+			}
+
+		public:
+
+			/**
+				\brief A counter of 0 in r.
+			*/
+			explicit inline counter(
+				std::string_view name /**< : <i>in</i> : The name.*/,
+				std::string_view help = {} /**< : <i>in</i> : The
+										   description.*/,
+				registry& r = registry::shared() /**< : <i>in</i> : The
+												 registry, must outlive the
+												 counter.*/
+			) : metric(r, name, help) {}
+
+			~counter() = default;
+
+			/**
+				\brief Adds n, a relaxed atomic add.
+			*/
+			inline void add(
+				std::uint64_t n = 1 /**< : <i>in</i> : The increment.*/
+			) noexcept
+			{
+				value.fetch_add(n, std::memory_order_relaxed);
+			}
+
+			/**
+				\brief The count.
+			*/
+			inline std::uint64_t load() const noexcept
+			{
+				return value.load(std::memory_order_relaxed);
+			}
+		};
+
+		/**
+			\brief The class for a level that rises and falls, like queue
+			depth.
+
+			hasErrorHandlers        = false;\n
+		*/
+		class gauge : public metric
+		{
+			/**
+				\brief The level, on its own cache line.
+			*/
+			alignas(cache_line_size) std::atomic<std::int64_t> value{ 0 };
+
+			inline void read(sample& out) const override
+			{
+				out.kind = metric_kind::gauge;
+				out.level = value.load(std::memory_order_relaxed);
+			}
+
+		public:
+
+			/**
+				\brief A gauge of 0 in r.
+			*/
+			explicit inline gauge(
+				std::string_view name /**< : <i>in</i> : The name.*/,
+				std::string_view help = {} /**< : <i>in</i> : The
+										   description.*/,
+				registry& r = registry::shared() /**< : <i>in</i> : The
+												 registry, must outlive the
+												 gauge.*/
+			) : metric(r, name, help) {}
+
+			~gauge() = default;
+
+			/**
+				\brief Sets the level, a relaxed atomic store.
+			*/
+			inline void set(
+				std::int64_t level /**< : <i>in</i> : The level.*/
+			) noexcept
+			{
+				value.store(level, std::memory_order_relaxed);
+			}
+
+			/**
+				\brief Adds n to the level, a relaxed atomic add.
+			*/
+			inline void add(
+				std::int64_t n = 1 /**< : <i>in</i> : The increment.*/
+			) noexcept
+			{
+				value.fetch_add(n, std::memory_order_relaxed);
+			}
+
+			/**
+				\brief Subtracts n from the level, a relaxed atomic add.
+			*/
+			inline void sub(
+				std::int64_t n = 1 /**< : <i>in</i> : The decrement.*/
+			) noexcept
+			{
+				value.fetch_sub(n, std::memory_order_relaxed);
+			}
+
+			/**
+				\brief The level.
+			*/
+			inline std::int64_t load() const noexcept
+			{
+				return value.load(std::memory_order_relaxed);
+			}
+		};
+
+		/**
+			\brief The class for a distribution of values, like latencies in
+			nanoseconds, kept in an enh::log_histogram.
+
+			hasErrorHandlers        = false;\n
+		*/
+		class histogram : public metric
+		{
+			/**
+				\brief The values.
+			*/
+			log_histogram values;
+
+			inline void read(sample& out) const override
+			{
+				out.kind = metric_kind::histogram;
+				out.values = values.snapshot();
+			}
+
+		public:
+
+			/**
+				\brief An empty histogram in r.
+			*/
+			explicit inline histogram(
+				std::string_view name /**< : <i>in</i> : The name.*/,
+				std::string_view help = {} /**< : <i>in</i> : The
+										   description.*/,
+				registry& r = registry::shared() /**< : <i>in</i> : The
+												 registry, must outlive the
+												 histogram.*/
+			) : metric(r, name, help) {}
+
+			~histogram() = default;
+
+			/**
+				\brief Records a value, relaxed atomic adds to its bucket,
+				count and sum.
+			*/
+			inline void record(
+				std::uint64_t val /**< : <i>in</i> : The value.*/
+			) noexcept
+			{
+				values.record(val);
+			}
+
+			/**
+				\brief The values recorded.
+			*/
+			inline histogram_snapshot snapshot() const
+			{
+				return values.snapshot();
+			}
+		};
+
+		/**
+			\brief The class for a function called at each snapshot of a
+			registry to add samples, for statistics kept elsewhere.
+
+			Removed from the registry when destroyed, move only.\n\n
+
+			hasErrorHandlers        = false;\n
+		*/
+		class collector
+		{
+			/**
+				\brief The registry, nullptr if none.
+			*/
+			registry* owner = nullptr;
+
+			/**
+				\brief The id in owner.
+			*/
+			std::uint64_t id = 0;
+
+		public:
+
+			/**
+				\brief A collector in no registry.
+			*/
+			collector() noexcept = default;
+
+			/**
+				\brief Registers fn in r.
+			*/
+			inline collector(
+				collect_method fn /**< : <i>in</i> : The function, appends
+								  its samples.*/,
+				registry& r = registry::shared() /**< : <i>in</i> : The
+												 registry, must outlive the
+												 collector.*/
+			) : owner(&r), id(r.add(std::move(fn))) {}
+
+			inline collector(collector&& other) noexcept
+				: owner(other.owner), id(other.id)
+			{
+				other.owner = nullptr;
+			}
+
+			inline collector& operator = (collector&& other) noexcept
+			{
+				if (this != &other)
+				{
+					if (owner)
+						owner->remove(id);
+					owner = other.owner;
+					id = other.id;
+					other.owner = nullptr;
+				}
+				return *this;
+			}
+
+			inline ~collector()
+			{
+				if (owner)
+					owner->remove(id);
+			}
+		};
+
+		/**
+			\brief Collects the statistics of a queued_process with a
+			with_stats policy as prefix_enqueued_total, prefix_dequeued_total,
+			prefix_failures_total, prefix_depth, prefix_high_water, and
+			histograms prefix_wait_ns, prefix_process_ns and
+			prefix_lock_hold_ns.
+
+			<h3>Return</h3>
+			The collector, queue must outlive it.\n
+		*/
+		template<class queue>
+		inline collector collectQueue(
+			std::string prefix /**< : <i>in</i> : The prefix of the names.*/,
+			const queue& q /**< : <i>in</i> : The queued_process.*/,
+			registry& r = registry::shared() /**< : <i>in</i> : The
+											 registry.*/
+		)
+		{
+			return collector([prefix, &q](std::vector<sample>& out) {
+				auto stats = q.getStats();
+				out.push_back(counter_sample(prefix + "_enqueued_total",
+					"Messages posted.", stats.enqueued));
+				out.push_back(counter_sample(prefix + "_dequeued_total",
+					"Messages taken by the processing thread.", stats.dequeued));
+				out.push_back(counter_sample(prefix + "_failures_total",
+					"Processing calls that failed.", stats.failures));
+				out.push_back(gauge_sample(prefix + "_depth",
+					"Messages posted and not yet processed.",
+					static_cast<std::int64_t>(stats.depth)));
+				out.push_back(gauge_sample(prefix + "_high_water",
+					"The largest depth seen.", static_cast<std::int64_t>(stats.high_water)));
+				out.push_back(histogram_sample(prefix + "_wait_ns",
+					"Nanoseconds from post to processing.", std::move(stats.wait_ns)));
+				out.push_back(histogram_sample(prefix + "_process_ns",
+					"Nanoseconds in the processing function.", std::move(stats.process_ns)));
+				out.push_back(histogram_sample(prefix + "_lock_hold_ns",
+					"Nanoseconds the queue mutex was held.", std::move(stats.lock_hold_ns)));
+			}, r);
+		}
+
+		/**
+			\brief Collects the statistics of an enh::timer as
+			prefix_ticks_total, prefix_missed_total and the histogram
+			prefix_lateness_ns.
+
+			<h3>Return</h3>
+			The collector, tm must outlive it.\n
+		*/
+		template<class timer_type>
+		inline collector collectTimer(
+			std::string prefix /**< : <i>in</i> : The prefix of the names.*/,
+			const timer_type& tm /**< : <i>in</i> : The timer.*/,
+			registry& r = registry::shared() /**< : <i>in</i> : The
+											 registry.*/
+		)
+		{
+			return collector([prefix, &tm](std::vector<sample>& out) {
+				auto stats = tm.stats();
+				out.push_back(counter_sample(prefix + "_ticks_total",
+					"Notifications sent.", stats.ticks));
+				out.push_back(counter_sample(prefix + "_missed_total",
+					"Periods passed before their notification.", stats.missed));
+				out.push_back(histogram_sample(prefix + "_lateness_ns",
+					"Nanoseconds notifications were late.", std::move(stats.lateness)));
+			}, r);
+		}
+
+		/**
+			\brief Collects the lines the asynchronous logger dropped as
+			prefix_dropped_total, nothing if logging is compiled out.
+
+			<h3>Return</h3>
+			The collector.\n
+		*/
+		inline collector collectLogger(
+			std::string prefix = "enh_log" /**< : <i>in</i> : The prefix of
+										   the names.*/,
+			registry& r = registry::shared() /**< : <i>in</i> : The
+											 registry.*/
+		)
+		{
+#if  defined(ENH_DEBUG_CONTROL) && (ENH_OPTIMISATION < 5)
+			return collector([prefix](std::vector<sample>& out) {
+				out.push_back(counter_sample(prefix + "_dropped_total",
+					"Log lines dropped by the asynchronous writer.",
+					static_cast<std::uint64_t>(debug::droppedLogs())));
+			}, r);
+#else
+			(void)prefix;
+			(void)r;
+			return collector();
+#endif
+		}
+
+#else
+
+		/**
+			\brief The registry, empty as ENH_CLEAR_OP__ is defined.
+		*/
+		class registry
+		{
+		public:
+
+			static inline registry& shared()
+			{
+				static registry instance;
+				return instance;
+			}
+
+			inline std::vector<sample> snapshot() const { return {}; }
+
+			inline std::size_t size() const noexcept { return 0; }
+		};
+
+		/**
+			\brief A counter, empty as ENH_CLEAR_OP__ is defined.
+		*/
+		class counter
+		{
+		public:
+
+			explicit inline counter(std::string_view, std::string_view = {},
+				registry& = registry::shared()) noexcept {}
+
+			inline void add(std::uint64_t = 1) noexcept {}
+
+			inline std::uint64_t load() const noexcept { return 0; }
+		};
+
+		/**
+			\brief A gauge, empty as ENH_CLEAR_OP__ is defined.
+		*/
+		class gauge
+		{
+		public:
+
+			explicit inline gauge(std::string_view, std::string_view = {},
+				registry& = registry::shared()) noexcept {}
+
+			inline void set(std::int64_t) noexcept {}
+
+			inline void add(std::int64_t = 1) noexcept {}
+
+			inline void sub(std::int64_t = 1) noexcept {}
+
+			inline std::int64_t load() const noexcept { return 0; }
+		};
+
+		/**
+			\brief A histogram, empty as ENH_CLEAR_OP__ is defined.
+		*/
+		class histogram
+		{
+		public:
+
+			explicit inline histogram(std::string_view, std::string_view = {},
+				registry& = registry::shared()) noexcept {}
+
+			inline void record(std::uint64_t) noexcept {}
+
+			inline histogram_snapshot snapshot() const { return {}; }
+		};
+
+		/**
+			\brief A collector, empty as ENH_CLEAR_OP__ is defined.
+		*/
+		class collector
+		{
+		public:
+
+			collector() noexcept = default;
+
+			inline collector(collect_method, registry& = registry::shared()) noexcept {}
+
+			// user provided, so keeping an unused collector gives no warning
+			inline ~collector() {}
+		};
+
+		template<class queue>
+		inline collector collectQueue(std::string, const queue&,
+			registry& = registry::shared()) noexcept
+		{
+			return collector();
+		}
+
+		template<class timer_type>
+		inline collector collectTimer(std::string, const timer_type&,
+			registry& = registry::shared()) noexcept
+		{
+			return collector();
+		}
+
+		inline collector collectLogger(std::string = "enh_log",
+			registry& = registry::shared()) noexcept
+		{
+			return collector();
+		}
+
+#endif
+
+		namespace detail
+		{
+			/**
+				\brief The kind as a Prometheus / JSON type name.
+			*/
+			inline const char* kind_name(metric_kind kind) noexcept
+			{
+				switch (kind)
+				{
+				case metric_kind::gauge:
+					return "gauge";
+				case metric_kind::histogram:
+					return "summary";
+				default:
+					return "counter";
+				}
+			}
+
+			/**
+				\brief The quantiles exported of a histogram.
+			*/
+			constexpr double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+			constexpr const char* quantile_labels[] = { "0.5", "0.9", "0.99", "0.999" };
+
+			constexpr const char* quantile_keys[] = { "p50", "p90", "p99", "p999" };
+
+			/**
+				\brief Appends in to out escaped as a JSON string body.
+			*/
+			inline void append_json_escaped(std::string& out, std::string_view in)
+			{
+				for (char c : in)
+				{
+					if (c == '"' || c == '\\')
+					{
+						out += '\\';
+						out += c;
+					}
+					else if (static_cast<unsigned char>(c) < 0x20)
+					{
+						static constexpr char hex[] = "0123456789abcdef";
+						out += "\\u00";
+						out += hex[(c >> 4) & 0xF];
+						out += hex[c & 0xF];
+					}
+					else
+						out += c;
+				}
+			}
+		}
+
+		/**
+			\brief Formats samples in the Prometheus text format.
+
+			Histograms are written as summaries, quantiles 0.5, 0.9, 0.99 and
+			0.999 with _sum and _count.
+
+			<h3>Return</h3>
+			The text.\n
+		*/
+		inline std::string to_prometheus(
+			const std::vector<sample>& samples /**< : <i>in</i> : The
+											   samples.*/
+		)
+		{
+			std::string out;
+			for (const sample& s : samples)
+			{
+				if (!s.help.empty())
+				{
+					out.append("# HELP ").append(s.name).append(" ");
+					for (char c : s.help)
+					{
+						if (c == '\\')
+							out += "\\\\";
+						else if (c == '\n')
+							out += "\\n";
+						else
+							out += c;
+					}
+					out += '\n';
+				}
+				out.append("# TYPE ").append(s.name).append(" ")
+					.append(detail::kind_name(s.kind)).append("\n");
+				switch (s.kind)
+				{
+				case metric_kind::counter:
+					out.append(s.name).append(" ").append(std::to_string(s.count)).append("\n");
+					break;
+				case metric_kind::gauge:
+					out.append(s.name).append(" ").append(std::to_string(s.level)).append("\n");
+					break;
+				case metric_kind::histogram:
+					for (std::size_t q = 0; q < 4; ++q)
+						out.append(s.name).append("{quantile=\"")
+							.append(detail::quantile_labels[q]).append("\"} ")
+							.append(std::to_string(s.values.percentile(detail::quantiles[q])))
+							.append("\n");
+					out.append(s.name).append("_sum ").append(std::to_string(s.values.sum))
+						.append("\n");
+					out.append(s.name).append("_count ").append(std::to_string(s.values.count))
+						.append("\n");
+					break;
+				}
+			}
+			return out;
+		}
+
+		/**
+			\brief Formats samples as a JSON object,
+			`{"metrics":[{"name":..., "type":..., ...}, ...]}` with value for
+			counters and gauges, and count, sum, max, p50, p90, p99 and p999
+			for histograms.
+
+			<h3>Return</h3>
+			The text, on one line.\n
+		*/
+		inline std::string to_json(
+			const std::vector<sample>& samples /**< : <i>in</i> : The
+											   samples.*/
+		)
+		{
+			std::string out = "{\"metrics\":[";
+			for (std::size_t i = 0; i < samples.size(); ++i)
+			{
+				const sample& s = samples[i];
+				out.append(i ? ",{\"name\":\"" : "{\"name\":\"");
+				detail::append_json_escaped(out, s.name);
+				out.append("\",\"type\":\"")
+					.append(s.kind == metric_kind::histogram ? "histogram" : detail::kind_name(s.kind))
+					.append("\"");
+				switch (s.kind)
+				{
+				case metric_kind::counter:
+					out.append(",\"value\":").append(std::to_string(s.count));
+					break;
+				case metric_kind::gauge:
+					out.append(",\"value\":").append(std::to_string(s.level));
+					break;
+				case metric_kind::histogram:
+					out.append(",\"count\":").append(std::to_string(s.values.count))
+						.append(",\"sum\":").append(std::to_string(s.values.sum))
+						.append(",\"max\":").append(std::to_string(s.values.max));
+					for (std::size_t q = 0; q < 4; ++q)
+						out.append(",\"").append(detail::quantile_keys[q]).append("\":")
+							.append(std::to_string(s.values.percentile(detail::quantiles[q])));
+					break;
+				}
+				out += '}';
+			}
+			return out + "]}";
+		}
+
+		/**
+			\brief Logs the JSON of a snapshot of r with O5_LOG_DESC, nothing
+			(not even the snapshot) if logging is compiled out.
+		*/
+		inline void logSnapshot(
+			registry& r = registry::shared() /**< : <i>in</i> : The
+											 registry.*/
+		)
+		{
+			(void)r;
+			O5_LOG_DESC(to_json(r.snapshot()));
+		}
+	}
+}
+
+#endif
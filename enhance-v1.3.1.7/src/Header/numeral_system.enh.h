@@ -28,36 +28,46 @@
 #define NUMERAL_SYSTEM_ENH_H					numeral_system.enh.h
 
 #include "confined.enh.h"
+#include "framework.enh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 
 namespace enh
 {
 	/**
 		\brief The class for a value that stays between 0 and upper.
 
+		The bounds are compile time constants (static_confined), so the 
+		object is the size of integral and add, sub are constexpr.
+
 		<h3>template</h3>
 		-# <code>integral</code> : The type of value.\n
 		-# <code>integral upper</code> : The upper limit for the value.\n
 	*/
 	template<class integral, integral upper>
-	class NumericSystem : public confined_base<integral>
+	class NumericSystem : public static_confined<integral, integral(0), 
+		integral(upper - 1)>
 	{
+		static_assert(upper > 0, "upper must not be 0");
+
+		/**
+			\brief The base type.
+		*/
+		using base = static_confined<integral, integral(0), integral(upper - 1)>;
+
 	public:
 		
 		/**
 			\brief The upper limit for values of this type.
 		*/
-		static constexpr confined_base<integral>::value_type limit = upper;
+		static constexpr typename base::value_type limit = upper;
 
 		/**
 			\brief The constructor the class initialises value to 0.
 		*/
-		constexpr inline NumericSystem() noexcept
-			: confined_base<integral>::confined_base(
-				[&](long long a) {return a < limit; },
-				[&](long long a) { return a >= 0; },
-				[&]() {return limit - 1; },
-				[&]() {return 0; },
-				0)
+		constexpr inline NumericSystem() noexcept : base()
 		{}
 
 		/**
@@ -68,16 +78,230 @@ namespace enh
 			than or equal to upper.
 		*/
 		constexpr inline NumericSystem(
-			confined_base<integral>::value_type val
-		) : confined_base<integral>::confined_base(
-				[&](long long a) {return a < limit; },
-				[&](long long a) { return a >= 0; },
-				[&]() {return limit - 1; },
-				[&]() {return 0; },
-				val)
+			typename base::value_type val /**< : <i>in</i> : The value.*/
+		) : base(val)
 		{}
 	};
 
+	/**
+		\brief The wider type for intermediate values of batch operations on 
+		NumericSystem values.
+	*/
+	template<class integral>
+	using numeric_wide_t = std::conditional_t<(sizeof(integral) < 4), 
+		std::uint32_t, unsigned long long>;
+
+	/**
+		\brief The kernels of the batch operations, one portable loop each
+		compiled again for the x86 extensions that widen it, picked by 
+		cpu_dispatch.
+	*/
+	namespace numeric_kernel
+	{
+		template<class system>
+		inline void add(
+			typename system::value_type* values,
+			const typename system::value_type* offsets,
+			typename system::value_type* carries,
+			std::size_t n
+		) noexcept
+		{
+			using value_type = typename system::value_type;
+			using wide = numeric_wide_t<value_type>;
+			constexpr wide limit = static_cast<wide>(system::limit);
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				wide sum = static_cast<wide>(values[i]) + static_cast<wide>(offsets[i]);
+				values[i] = static_cast<value_type>(sum % limit);
+				carries[i] = static_cast<value_type>(sum / limit);
+			}
+		}
+
+		template<class system>
+		inline void normalize(
+			typename system::value_type* raw,
+			typename system::value_type* carries,
+			std::size_t n
+		) noexcept
+		{
+			using value_type = typename system::value_type;
+			using wide = numeric_wide_t<value_type>;
+			constexpr wide limit = static_cast<wide>(system::limit);
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				wide v = static_cast<wide>(raw[i]);
+				raw[i] = static_cast<value_type>(v % limit);
+				carries[i] = static_cast<value_type>(v / limit);
+			}
+		}
+
+		template<class system>
+		inline void compare(
+			const typename system::value_type* lhs,
+			const typename system::value_type* rhs,
+			signed char* out,
+			std::size_t n
+		) noexcept
+		{
+			for (std::size_t i = 0; i < n; ++i)
+				out[i] = static_cast<signed char>((lhs[i] > rhs[i]) - (lhs[i] < rhs[i]));
+		}
+
+#ifdef ENH_TARGET_X86
+		template<class system>
+		ENH_TARGET("avx2") void add_avx2(typename system::value_type* values,
+			const typename system::value_type* offsets, 
+			typename system::value_type* carries, std::size_t n) noexcept
+		{
+			add<system>(values, offsets, carries, n);
+		}
+
+		template<class system>
+		ENH_TARGET("avx512f,avx512bw") void add_avx512(typename system::value_type* values,
+			const typename system::value_type* offsets,
+			typename system::value_type* carries, std::size_t n) noexcept
+		{
+			add<system>(values, offsets, carries, n);
+		}
+
+		template<class system>
+		ENH_TARGET("avx2") void normalize_avx2(typename system::value_type* raw,
+			typename system::value_type* carries, std::size_t n) noexcept
+		{
+			normalize<system>(raw, carries, n);
+		}
+
+		template<class system>
+		ENH_TARGET("avx512f,avx512bw") void normalize_avx512(typename system::value_type* raw,
+			typename system::value_type* carries, std::size_t n) noexcept
+		{
+			normalize<system>(raw, carries, n);
+		}
+
+		template<class system>
+		ENH_TARGET("avx2") void compare_avx2(const typename system::value_type* lhs,
+			const typename system::value_type* rhs, signed char* out, std::size_t n) noexcept
+		{
+			compare<system>(lhs, rhs, out, n);
+		}
+
+		template<class system>
+		ENH_TARGET("avx512f,avx512bw") void compare_avx512(const typename system::value_type* lhs,
+			const typename system::value_type* rhs, signed char* out, std::size_t n) noexcept
+		{
+			compare<system>(lhs, rhs, out, n);
+		}
+#endif
+
+		/**
+			\brief Batches shorter than this run the portable loop inline,
+			the indirect call would cost more than the wider registers gain.
+		*/
+		constexpr std::size_t dispatch_min = 32;
+	}
+
+	/**
+		\brief Adds offsets[i] to values[i], for n values of NumericSystem 
+		system, and writes the number of wraps to carries[i].
+
+		The values must be within [0, limit). Plain loops over contiguous
+		arrays with a constant divisor, vectorised by the compiler for the
+		build flags, and for AVX2 and AVX-512 where this processor has them
+		(cpu_dispatch, GCC and Clang on x86). carries may be the same array
+		as offsets.
+
+		<h3>template</h3>
+		-# <code>system</code> : The NumericSystem type.\n
+	*/
+	template<class system>
+	inline void batch_add(
+		typename system::value_type* values /**< : <i>in/out</i> : The 
+											values.*/,
+		const typename system::value_type* offsets /**< : <i>in</i> : The 
+												   units to add.*/,
+		typename system::value_type* carries /**< : <i>out</i> : The number 
+											 of wraps.*/,
+		std::size_t n /**< : <i>in</i> : The number of values.*/
+	) noexcept
+	{
+		using value_type = typename system::value_type;
+		using fn_t = void(value_type*, const value_type*, value_type*, std::size_t) noexcept;
+		static constexpr cpu_kernel<fn_t> kernels[] = {
+#ifdef ENH_TARGET_X86
+			{ cpu_feature::avx512f | cpu_feature::avx512bw, &numeric_kernel::add_avx512<system> },
+			{ cpu_feature::avx2, &numeric_kernel::add_avx2<system> },
+#endif
+			{ 0, &numeric_kernel::add<system> } };
+		static cpu_dispatch<fn_t> best(kernels);
+		if (n < numeric_kernel::dispatch_min)
+			numeric_kernel::add<system>(values, offsets, carries, n);
+		else
+			best(values, offsets, carries, n);
+	}
+
+	/**
+		\brief Brings raw[i] within [0, limit) of NumericSystem system, for n
+		values, and writes the number of wraps to carries[i].
+
+		Dispatched as batch_add.
+
+		<h3>template</h3>
+		-# <code>system</code> : The NumericSystem type.\n
+	*/
+	template<class system>
+	inline void batch_normalize(
+		typename system::value_type* raw /**< : <i>in/out</i> : The values.*/,
+		typename system::value_type* carries /**< : <i>out</i> : The number
+											 of wraps.*/,
+		std::size_t n /**< : <i>in</i> : The number of values.*/
+	) noexcept
+	{
+		using value_type = typename system::value_type;
+		using fn_t = void(value_type*, value_type*, std::size_t) noexcept;
+		static constexpr cpu_kernel<fn_t> kernels[] = {
+#ifdef ENH_TARGET_X86
+			{ cpu_feature::avx512f | cpu_feature::avx512bw, &numeric_kernel::normalize_avx512<system> },
+			{ cpu_feature::avx2, &numeric_kernel::normalize_avx2<system> },
+#endif
+			{ 0, &numeric_kernel::normalize<system> } };
+		static cpu_dispatch<fn_t> best(kernels);
+		if (n < numeric_kernel::dispatch_min)
+			numeric_kernel::normalize<system>(raw, carries, n);
+		else
+			best(raw, carries, n);
+	}
+
+	/**
+		\brief Compares lhs[i] with rhs[i], for n values, writing -1, 0 or 1
+		to out[i] for lesser, equal or greater.
+
+		Dispatched as batch_add.
+	*/
+	template<class system>
+	inline void batch_compare(
+		const typename system::value_type* lhs /**< : <i>in</i> : The left
+											   hand side.*/,
+		const typename system::value_type* rhs /**< : <i>in</i> : The right
+											   hand side.*/,
+		signed char* out /**< : <i>out</i> : The results.*/,
+		std::size_t n /**< : <i>in</i> : The number of values.*/
+	) noexcept
+	{
+		using value_type = typename system::value_type;
+		using fn_t = void(const value_type*, const value_type*, signed char*, std::size_t) noexcept;
+		static constexpr cpu_kernel<fn_t> kernels[] = {
+#ifdef ENH_TARGET_X86
+			{ cpu_feature::avx512f | cpu_feature::avx512bw, &numeric_kernel::compare_avx512<system> },
+			{ cpu_feature::avx2, &numeric_kernel::compare_avx2<system> },
+#endif
+			{ 0, &numeric_kernel::compare<system> } };
+		static cpu_dispatch<fn_t> best(kernels);
+		if (n < numeric_kernel::dispatch_min)
+			numeric_kernel::compare<system>(lhs, rhs, out, n);
+		else
+			best(lhs, rhs, out, n);
+	}
+
 	/**
 		\brief The namespace for all aliases for 
 		different upper limited systems.
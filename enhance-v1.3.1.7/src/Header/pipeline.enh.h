@@ -0,0 +1,465 @@
+/** ***************************************************************************
+	\file pipeline.enh.h
+
+	\brief The file to declare class pipeline
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+
+******************************************************************************/
+
+#ifndef PIPELINE_ENH_H
+
+#define PIPELINE_ENH_H						pipeline.enh.h
+
+#include "queued_process.enh.h"
+
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace enh
+{
+
+	/**
+		\brief Checks if T is a std::optional.
+	*/
+	template<class T>
+	struct is_optional : std::false_type {};
+
+	template<class T>
+	struct is_optional<std::optional<T>> : std::true_type {};
+
+	template<class types, std::size_t capacity, class... fns>
+	class pipeline;
+
+	/**
+		\brief The class to implement a chain of stages, each executing on
+		its own thread, that pass messages to the next stage through bounded
+		lock-free queues.
+
+		Every stage is a queued_process with policy bounded_ring<capacity>
+		and its function as a static handler, the queue of a stage is drained
+		in batches and each result is moved straight into the queue of the
+		next stage. A full queue blocks the stage before it, so a slow stage
+		pushes back up to postMessage.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>Template arguments</h3>
+		-#  <code>class... types</code> : The type each stage takes, the
+		first is the type posted to the pipeline.\n
+		-#  <code>std::size_t capacity</code> : The size of the queue of each
+		stage, must be a power of 2.\n
+		-#  <code>class... fns</code> : The function type of each stage,
+		every stage but the last returns the type of the next stage (or a
+		std::optional of it, std::nullopt drops the message), the last
+		returns `tristate`.\n
+
+		<h3> How To Use </h3>
+
+		- Call `make_pipeline<capacity, A, B, C>(fnA, fnB, fnC)` where `fnA`
+		turns `A` into `B`, `fnB` turns `B` into `C` and `fnC` consumes `C`.
+
+		- Call `start_queue_process`, then `postMessage` with messages of
+		type `A`.
+
+		- Call `safe_join` to process every posted message through all
+		stages before stopping, or `force_join` to stop right away.
+
+		<b>Note</b> : If a stage fails (the last stage returns an error),
+		it stops, and so do the stages before it once its queue is full.
+		With `postMessage` waiting for space, use `try_postMessage` if that
+		can happen.
+	*/
+	template<class... types, std::size_t capacity, class... fns>
+	class pipeline<std::tuple<types...>, capacity, fns...>
+	{
+		static_assert(sizeof...(types) == sizeof...(fns) && sizeof...(fns) > 0,
+			"pipeline needs a type for every stage");
+
+	public:
+
+		/**
+			\brief The number of stages.
+		*/
+		static constexpr std::size_t stage_count = sizeof...(fns);
+
+		/**
+			\brief The type of message stage i takes.
+		*/
+		template<std::size_t i>
+		using input_type = std::tuple_element_t<i, std::tuple<types...>>;
+
+		/**
+			\brief The type of object posted to the pipeline.
+		*/
+		using info_type = input_type<0>;
+
+	private:
+
+		/**
+			\brief The processing function of the queued_process for stage i.
+		*/
+		template<std::size_t i>
+		struct stage_handler
+		{
+			/**
+				\brief The pipeline owning the stage.
+			*/
+			pipeline* owner;
+
+			inline tristate operator()(input_type<i> msg)
+			{
+				return owner->template run_stage<i>(std::move(msg));
+			}
+		};
+
+		/**
+			\brief The queued_process for stage i.
+		*/
+		template<std::size_t i>
+		using stage_type = queued_process<input_type<i>, bounded_ring<capacity>,
+			stage_handler<i>>;
+
+		template<class seq>
+		struct stage_tuple;
+
+		template<std::size_t... i>
+		struct stage_tuple<std::index_sequence<i...>>
+		{
+			using type = std::tuple<std::unique_ptr<stage_type<i>>...>;
+		};
+
+		/**
+			\brief The function of each stage.
+		*/
+		std::tuple<fns...> procs;
+
+		/**
+			\brief The queued_process of each stage.
+		*/
+		typename stage_tuple<std::index_sequence_for<fns...>>::type stages;
+
+		/**
+			\brief true while force_join stops the stages, so that no stage
+			waits for space in the next stage.
+		*/
+		std::atomic<bool> isStopping;
+
+		/**
+			\brief Runs the function of stage i and passes the result on.
+		*/
+		template<std::size_t i>
+		tristate run_stage(
+			input_type<i>&& msg /**< : <i>in</i> : The message.*/
+		)
+		{
+			auto& fn = std::get<i>(procs);
+			if constexpr (i + 1 == stage_count)
+				return fn(std::move(msg));
+			else
+			{
+				auto out = fn(std::move(msg));
+				if constexpr (is_optional<decltype(out)>::value)
+				{
+					if (!out)
+						return tristate::GOOD;
+					return forward_to<i + 1>(std::move(*out));
+				}
+				else
+					return forward_to<i + 1>(std::move(out));
+			}
+		}
+
+		/**
+			\brief Moves the message into the queue of stage i, waiting while
+			it is full.
+
+			<h3>Return</h3>
+			tristate::ERROR if stage i exited or the pipeline is stopping.\n
+		*/
+		template<std::size_t i>
+		tristate forward_to(
+			input_type<i>&& msg /**< : <i>in</i> : The message.*/
+		)
+		{
+			auto& next = *std::get<i>(stages);
+			// a failed try_postMessage leaves msg untouched.
+			while (!next.try_postMessage(std::move(msg)))
+			{
+				if (isStopping.load() || next.isQueueExited())
+					return tristate::ERROR;
+				std::this_thread::yield();
+			}
+			return tristate::GOOD;
+		}
+
+		/**
+			\brief Calls fn with every stage in order.
+		*/
+		template<class F, std::size_t... i>
+		inline void for_each_stage(
+			F&& fn /**< : <i>in</i> : The function.*/,
+			std::index_sequence<i...>
+		)
+		{
+			(fn(*std::get<i>(stages)), ...);
+		}
+
+		/**
+			\brief Calls fn with every stage in order.
+		*/
+		template<class F>
+		inline void for_each_stage(
+			F&& fn /**< : <i>in</i> : The function.*/
+		)
+		{
+			for_each_stage(std::forward<F>(fn), std::index_sequence_for<fns...>());
+		}
+
+		/**
+			\brief Creates the queued_process of every stage.
+		*/
+		template<std::size_t... i>
+		inline void make_stages(std::index_sequence<i...>)
+		{
+			((std::get<i>(stages) = std::make_unique<stage_type<i>>(
+				stage_handler<i>{ this })), ...);
+		}
+
+	public:
+
+		/**
+			\brief Constructs the pipeline with the function of each stage,
+			prefer make_pipeline.
+		*/
+		explicit pipeline(
+			fns... in /**< : <i>in</i> : The function of each stage.*/
+		) : procs(std::move(in)...), isStopping(false)
+		{
+			make_stages(std::index_sequence_for<fns...>());
+			setBatchLimit(64);
+		}
+
+		pipeline(const pipeline&) = delete;
+
+		pipeline(pipeline&&) = delete;
+
+		pipeline& operator = (pipeline&&) = delete;
+
+		pipeline& operator = (const pipeline&) = delete;
+
+		/**
+			\brief Sets the maximum messages each stage takes from its queue
+			at once (64 by default, 0 for all pending).
+		*/
+		inline void setBatchLimit(
+			std::size_t limit /**< : <i>in</i> : The maximum batch size.*/
+		) noexcept
+		{
+			for_each_stage([limit](auto& stage) { stage.setBatchLimit(limit); });
+		}
+
+		/**
+			\brief Sets how the thread of every stage waits for messages.
+		*/
+		inline void setWaitStrategy(
+			wait_strategy mode /**< : <i>in</i> : The wait strategy.*/,
+			std::size_t spins = 4096 /**< : <i>in</i> : Number of spins
+									 before yielding or blocking.*/
+		) noexcept
+		{
+			for_each_stage([mode, spins](auto& stage) {
+				stage.setWaitStrategy(mode, spins);
+				});
+		}
+
+		/**
+			\brief starts the threads of all stages.
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if any stage failed to start or was
+			already running.\n
+		*/
+		tristate start_queue_process() noexcept
+		{
+			bool good = true;
+			isStopping = false;
+			for_each_stage([&good](auto& stage) {
+				if (stage.start_queue_process() != tristate::GOOD)
+					good = false;
+				});
+			return good ? tristate::GOOD : tristate::ERROR;
+		}
+
+		/**
+			\brief Checks if pipeline is running.
+		*/
+		inline bool isQueueRunning() noexcept
+		{
+			return std::get<0>(stages)->isQueueRunning();
+		}
+
+		/**
+			\brief The function post a message onto the first stage, waits
+			while its queue is full.
+		*/
+		inline void postMessage(
+			info_type Message /**< : <i>in</i> : Message need to be pushed.*/
+		)
+		{
+			std::get<0>(stages)->postMessage(std::move(Message));
+		}
+
+		/**
+			\brief The function post a message onto the first stage if there
+			is space.
+
+			<h3>Return</h3>
+			Returns false if queue of first stage is full, Message is left
+			untouched and not posted.\n
+		*/
+		inline bool try_postMessage(
+			info_type&& Message /**< : <i>in</i> : Message need to be pushed.*/
+		)
+		{
+			return std::get<0>(stages)->try_postMessage(std::move(Message));
+		}
+
+		/**
+			\brief The function post a copy of message onto the first stage if
+			there is space.
+
+			<h3>Return</h3>
+			Returns false if queue of first stage is full.\n
+		*/
+		inline bool try_postMessage(
+			const info_type& Message /**< : <i>in</i> : Message need to be
+									 pushed.*/
+		)
+		{
+			return std::get<0>(stages)->try_postMessage(Message);
+		}
+
+		/**
+			\brief Waits till every message posted so far has passed through
+			all stages, or the deadline is reached.
+
+			<h3>Return</h3>
+			true if all stages drained.\n
+		*/
+		template<class Clock, class Duration>
+		bool WaitForQueueEmpty(
+			const std::chrono::time_point<Clock, Duration>& deadline /**< :
+							<i>in</i> : The time to stop waiting at.*/
+		)
+		{
+			bool drained = true;
+			for_each_stage([&](auto& stage) {
+				drained = stage.WaitForQueueEmpty(deadline) && drained;
+				});
+			return drained;
+		}
+
+		/**
+			\brief Drains and stops the stages one by one, from the first.
+
+			A stage is only stopped once all of its messages were passed on,
+			so nothing posted is lost.
+		*/
+		void safe_join(
+			std::chrono::nanoseconds ns = std::chrono::nanoseconds(0) /**< :
+							<i>in</i> : Unused, kept for compatibility with
+							queued_process.*/
+		)
+		{
+			for_each_stage([ns](auto& stage) { stage.safe_join(ns); });
+		}
+
+		/**
+			\brief Drains and stops the stages one by one, from the first,
+			stopping the rest right away once the deadline is reached.
+
+			<b>Note</b> : The batch a stage is processing is always finished,
+			so this may return after the deadline.
+
+			<h3>Return</h3>
+			true if all messages passed through all stages.\n
+		*/
+		template<class Clock, class Duration>
+		bool safe_join(
+			const std::chrono::time_point<Clock, Duration>& deadline /**< :
+							<i>in</i> : The time to stop waiting at.*/
+		)
+		{
+			bool drained = true;
+			for_each_stage([&](auto& stage) {
+				drained = stage.safe_join(deadline) && drained;
+				});
+			return drained;
+		}
+
+		/**
+			\brief Stops all stages then waits for them to join.
+
+			<b>Note</b> : Messages left over in any stage are destroyed.
+		*/
+		void force_join()
+		{
+			isStopping = true;
+			for_each_stage([](auto& stage) { stage.stopQueue(); });
+			for_each_stage([](auto& stage) { stage.force_join(); });
+			isStopping = false;
+		}
+
+		/**
+			\brief The destructor. Exits without waiting for stages to drain.
+		*/
+		~pipeline()
+		{
+			force_join();
+		}
+	};
+
+	/**
+		\brief Creates a pipeline.
+
+		<h3>Template arguments</h3>
+		-#  <code>std::size_t capacity</code> : The size of the queue of each
+		stage, must be a power of 2.\n
+		-#  <code>class... types</code> : The type each stage takes.\n
+
+		<h3>Return</h3>
+		The pipeline with a stage for each function.\n
+	*/
+	template<std::size_t capacity, class... types, class... fns>
+	inline pipeline<std::tuple<types...>, capacity, std::decay_t<fns>...>
+		make_pipeline(
+			fns&&... in /**< : <i>in</i> : The function of each stage.*/
+		)
+	{
+		return pipeline<std::tuple<types...>, capacity, std::decay_t<fns>...>(
+			std::forward<fns>(in)...);
+	}
+}
+
+#endif
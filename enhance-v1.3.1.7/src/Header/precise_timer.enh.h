@@ -0,0 +1,455 @@
+/** ***************************************************************************
+	\file precise_timer.enh.h
+
+	\brief The file to declare class precise_timer for sub millisecond
+	periods
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef PRECISE_TIMER_ENH_H
+
+#define PRECISE_TIMER_ENH_H					precise_timer.enh.h
+
+#include "general.enh.h"
+#include "histogram.enh.h"
+#include "thread_config.enh.h"
+#include "timer.enh.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <thread>
+
+namespace enh
+{
+
+	/**
+		\brief The class to create a timer with periods down to tens of
+		microseconds.
+
+		The timer has a thread of its own, which sleeps till the spin
+		window before each notification and then spins on high_res::now(),
+		so a core is busy for the window of every period (all the time if
+		the window is not shorter than the period). The thread can be
+		pinned to a processor, or placed with a thread_config.\n\n
+
+		The lateness of each notification is recorded, see jitter.\n\n
+
+		The interface is that of enh::timer.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>template</h3>
+		-#  <code>unsigned _per</code> : The period of time between each notification.\n
+		-#  <code>unit</code> : The unit of time of period, any of
+		nanoseconds to hours.\n
+	*/
+	template<unsigned _per = 500U, class time_unit = std::chrono::microseconds>
+	class precise_timer
+	{
+	public:
+
+		/**
+			\brief The period of timer.
+		*/
+		static constexpr unsigned period = _per;
+
+		/**
+			\brief The unit of measurement.
+		*/
+		using unit = time_unit;
+
+	private:
+
+		static_assert(isGoodTimerType_v<unit>, "unit type must be time type");
+		static_assert(period > 0, "period must not be 0");
+
+		/**
+			\brief The begining time point of the timer.
+		*/
+		time_pt timer_start;
+
+		/**
+			\brief The time at which next notification is to be sent.
+		*/
+		time_pt timer_next;
+
+		/**
+			\brief The variable to signal the end of the timer loop.
+		*/
+		std::atomic<bool> stopTimer;
+
+		/**
+			\brief The cycles elapsed since timer start.
+		*/
+		cycle_count elapsed_cycles;
+
+		/**
+			\brief The time spun before each notification in nanoseconds.
+		*/
+		std::atomic<std::int64_t> spinNs;
+
+		/**
+			\brief The processor to pin the thread to, -1 for none.
+		*/
+		std::atomic<int> cpu;
+
+		/**
+			\brief true if the last pinning succeeded.
+		*/
+		std::atomic<bool> pinned;
+
+		/**
+			\brief The configuration the thread applies when it starts.
+		*/
+		std::optional<thread_config> config;
+
+		/**
+			\brief true if config was applied at the last start.
+		*/
+		std::atomic<bool> configured;
+
+		/**
+			\brief The lateness of each notification in nanoseconds.
+		*/
+		log_histogram lateness;
+
+		/**
+			\brief the thread handle to the thread running the timer function.
+		*/
+		std::thread timerThread;
+
+		/**
+			\brief true if timer thread is running.
+		*/
+		bool isTimerActive;
+
+		/**
+			\brief Sleeps then spins till timer_next, then notifies.
+		*/
+		inline void single_period() noexcept
+		{
+			auto spin = std::chrono::nanoseconds(spinNs.load(std::memory_order_relaxed));
+			time_pt now = high_res::now();
+			if (timer_next - now > spin)
+				std::this_thread::sleep_until(timer_next - spin);
+			while ((now = high_res::now()) < timer_next)
+				cpu_relax();
+			lateness.record(static_cast<std::uint64_t>(std::chrono::duration_cast<
+				std::chrono::nanoseconds>(now - timer_next).count()));
+			timer_next += unit(period);
+			elapsed_cycles.advance();
+		}
+
+		/**
+			\brief keeps on executing single_period until the time when
+			stopTimer is set.
+		*/
+		void loop() noexcept
+		{
+			configured = config && applyThreadConfig(*config);
+			int pin = cpu.load();
+			pinned = (pin >= 0) && pinThread(pin);
+			timer_start = high_res::now();
+			timer_next = timer_start + unit(period);
+			while (!stopTimer.load())
+				single_period();
+		}
+
+	public:
+
+		/**
+			\brief Constructs and starts the timer.
+		*/
+		inline explicit precise_timer(
+			int pinCpu = -1 /**< : <i>in</i> : The processor to pin the timer
+							thread to, -1 for none.*/
+		) noexcept : stopTimer(false), spinNs(200000), cpu(pinCpu), pinned(false),
+			configured(false), isTimerActive(false)
+		{
+			start_timer();
+		}
+
+		precise_timer(const precise_timer&) = delete;
+
+		precise_timer& operator = (const precise_timer&) = delete;
+
+		/**
+			\brief destructor of the class, invokes force_join.
+		*/
+		inline ~precise_timer() noexcept
+		{
+			force_join();
+		}
+
+		/**
+			\brief Sets the time spun before each notification, used from the
+			next one (default 200 us).
+
+			Longer is more accurate on a loaded system, but uses more
+			processor time.
+		*/
+		template<class Rep, class Period>
+		inline void setSpin(
+			std::chrono::duration<Rep, Period> window /**< : <i>in</i> : The
+													  window.*/
+		) noexcept
+		{
+			spinNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				window).count(), std::memory_order_relaxed);
+		}
+
+		/**
+			\brief Sets the processor the thread is pinned to from the next
+			start_timer, -1 for none.
+		*/
+		inline void setCpu(
+			int pinCpu /**< : <i>in</i> : The processor.*/
+		) noexcept
+		{
+			cpu.store(pinCpu);
+		}
+
+		/**
+			\brief Sets the placement, scheduling and name the thread applies 
+			from the next start_timer, before the processor of setCpu.
+
+			Call while the timer is stopped (after join), or restart it.
+		*/
+		inline void setThreadConfig(
+			thread_config cfg /**< : <i>in</i> : The configuration.*/
+		) noexcept
+		{
+			config = std::move(cfg);
+		}
+
+		/**
+			\brief Checks if the configuration of setThreadConfig was fully
+			applied at the start of the thread.
+		*/
+		inline bool isConfigured() const noexcept { return configured.load(); }
+
+		/**
+			\brief Checks if the thread was pinned at its start.
+		*/
+		inline bool isPinned() const noexcept { return pinned.load(); }
+
+		/**
+			\brief The lateness of the notifications in nanoseconds, check
+			max and percentile(0.99) against the period required.
+		*/
+		inline histogram_snapshot jitter() const
+		{
+			return lateness.snapshot();
+		}
+
+		/**
+			\brief Clears the recorded lateness.
+		*/
+		inline void resetJitter() noexcept
+		{
+			lateness.reset();
+		}
+
+		/**
+			\brief Blocks till the number of cycles elapsed is greater than or
+			equal to expected.
+
+			<h3>Return</h3>
+			The difference between elapsed cycles and expected (the
+			"overshoot").\n
+		*/
+		inline unsigned long long wait(
+			unsigned long long expected /**< : <i>in</i> : The expected cycle
+										count to wait till.*/
+		) noexcept
+		{
+			if (!isTimerActive)
+				start_timer();
+			return elapsed_cycles.wait(expected) - expected;
+		}
+
+		/**
+			\brief Blocks till the next cycle.
+
+			<h3>Return</h3>
+			The overshoot.\n
+		*/
+		inline unsigned long long wait() noexcept
+		{
+			return wait(elapsed_cycles.load() + 1);
+		}
+
+		/**
+			\brief blocks function execution for mult_count number of cycles.
+
+			<h3>Return</h3>
+			The overshoot.\n
+		*/
+		inline unsigned long long wait_for(
+			unsigned long mult_count /**< : <i>in</i> : The cycles to wait for.*/
+		) noexcept
+		{
+			return wait(elapsed_cycles.load() + mult_count);
+		}
+
+		/**
+			\brief The function blocks for a certian cycles unless the
+			condition becomes false, checked every cycle.
+
+			<h3>Return</h3>
+			-1 if the condition fails. The overshoot if it doesnt.
+		*/
+		inline long long wait_for(
+			unsigned mult_count /**< : <i>in</i> : The amount of cycles to
+								wait.*/,
+			std::function<bool()> condition /**< : <i>in</i> : The condition
+											to exit immediately.*/
+		) noexcept
+		{
+			unsigned long long expected = elapsed_cycles.load() + mult_count;
+			while (elapsed_cycles.load() < expected)
+			{
+				if (!condition())
+					return -1;
+				wait();
+			}
+			return elapsed_cycles.load() - expected;
+		}
+
+		/**
+			\brief Returns the number of cycles elapsed from timer start.
+		*/
+		inline unsigned long long elapsed() noexcept { return elapsed_cycles.load(); }
+
+		/**
+			\brief Blocks till expected cycles elapsed, deadline passes or
+			stop is cancelled, whichever is first.
+
+			Unlike the wait_for with a condition, stop wakes the thread at 
+			once, not at the next cycle, and nothing is polled.
+
+			<h3>Return</h3>
+			-1 if stop was cancelled or deadline passed first. The overshoot
+			if it did not.\n
+		*/
+		inline long long wait_until(
+			unsigned long long expected /**< : <i>in</i> : The expected cycle
+										count to wait till.*/,
+			cancel_event& stop /**< : <i>in</i> : The event to stop waiting.*/,
+			time_pt deadline = time_pt::max() /**< : <i>in</i> : The latest 
+											  time to wait till.*/
+		) noexcept
+		{
+			if (!isTimerActive)
+				start_timer();
+			if (!elapsed_cycles.wait_until(expected, deadline, &stop))
+				return -1;
+			return elapsed_cycles.load() - expected;
+		}
+
+		/**
+			\brief Blocks for mult_count cycles unless deadline passes or stop
+			is cancelled first, see wait_until.
+
+			<h3>Return</h3>
+			-1 if stop was cancelled or deadline passed first. The overshoot
+			if it did not.\n
+		*/
+		inline long long wait_for(
+			unsigned mult_count /**< : <i>in</i> : The amount of cycles to 
+								wait.*/,
+			cancel_event& stop /**< : <i>in</i> : The event to stop waiting.*/,
+			time_pt deadline = time_pt::max() /**< : <i>in</i> : The latest 
+											  time to wait till.*/
+		) noexcept
+		{
+			return wait_until(elapsed_cycles.load() + mult_count, stop, deadline);
+		}
+
+		/**
+			\brief sets stopTimer to true.
+		*/
+		inline void stop() noexcept { stopTimer = true; }
+
+		/**
+			\brief sets stopTimer to false.
+		*/
+		inline void clear_stop() noexcept { stopTimer = false; }
+
+		/**
+			\brief Checks if timer is running.
+		*/
+		inline bool isTimerCounting() noexcept { return isTimerActive; }
+
+		/**
+			\brief The function to start timer.
+
+			<h3>Return</h3>
+			Returns false if timer is already running.
+		*/
+		inline bool start_timer() noexcept
+		{
+			if (isTimerActive)
+				return false;
+			O3_LIB_LOG_LINE;
+			clear_stop();
+			elapsed_cycles.reset();
+			timerThread = std::thread(&precise_timer::loop, this);
+			isTimerActive = true;
+			return true;
+		}
+
+		/**
+			\brief overloaded operator !, returns true if the timer is not
+			running.
+		*/
+		inline bool operator !() noexcept
+		{
+			return !isTimerCounting();
+		}
+
+		/**
+			\brief Blocks till the timer thread exits after stop.
+		*/
+		inline void join() noexcept
+		{
+			if (isTimerActive)
+			{
+				timerThread.join();
+				isTimerActive = false;
+			}
+		}
+
+		/**
+			\brief stops the timer and waits for the thread, at most one
+			period.
+		*/
+		inline void force_join() noexcept
+		{
+			stop();
+			join();
+		}
+	};
+}
+
+#endif
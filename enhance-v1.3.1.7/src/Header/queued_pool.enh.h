@@ -0,0 +1,498 @@
+/** ***************************************************************************
+	\file queued_pool.enh.h
+
+	\brief The file to declare class queued_pool
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+
+******************************************************************************/
+
+#ifndef QUEUED_POOL_ENH_H
+
+#define QUEUED_POOL_ENH_H						queued_pool.enh.h
+
+#include "queued_process.enh.h"
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace enh
+{
+
+	/**
+		\brief The class to implement a structure which executes instructions
+		concurrently on multiple worker threads after fetching them through
+		per worker queues.
+
+		Messages are spread over the workers round robin, a worker that runs
+		out of messages steals from the back of the other workers' queues.\n\n
+
+		If a key function is registered, every message is routed to the
+		worker selected by its key and is never stolen, so messages with the
+		same key are processed in the order they were posted.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>Template arguments</h3>
+		-#  <code>class instruct</code> : The type to store the instruction.\n
+
+		<h3> How To Use </h3>
+
+		- Same as queued_process, construct with the number of workers and the
+		processing function.
+
+		- Optionally call `RegisterKey` to keep per key order.
+
+		- Call `start_queue_process`, `postMessage`, then `safe_join` or
+		`force_join` as with queued_process.
+
+		<b>Note</b> : The processing function is called concurrently from all
+		workers. If it returns an error, the whole pool stops.
+	*/
+	template< class instruct>
+	class queued_pool
+	{
+	public:
+
+		/**
+			\brief The type of object to be processed
+		*/
+		using info_type = instruct;
+
+		/**
+			\brief The function type that processes the infomation passed.
+		*/
+		using processing_method = std::function<tristate(info_type)>;
+
+		/**
+			\brief The function type that gives the ordering key of a message.
+		*/
+		using key_method = std::function<std::size_t(const info_type&)>;
+
+	private:
+
+		/**
+			\brief The state of a single worker.
+		*/
+		struct alignas(cache_line_size) worker
+		{
+			/**
+				\brief The synchronising mutex for the queues of this worker.
+			*/
+			std::mutex mtxQueue;
+
+			/**
+				\brief The object to notify update to this worker.
+			*/
+			std::condition_variable cvQueue;
+
+			/**
+				\brief Messages that may be stolen by other workers.
+			*/
+			std::deque<info_type> shared;
+
+			/**
+				\brief Messages routed by key, only this worker processes
+				them.
+			*/
+			std::deque<info_type> pinned;
+
+			/**
+				\brief true while the worker waits for messages.
+			*/
+			std::atomic<bool> isSleeping;
+
+			/**
+				\brief The thread handle for the worker.
+			*/
+			std::thread queue_thread;
+
+			/**
+				\brief Constructs an idle worker.
+			*/
+			worker() : isSleeping(false) {}
+		};
+
+		/**
+			\brief The workers.
+		*/
+		std::vector<std::unique_ptr<worker>> workers;
+
+		/**
+			\brief Number of messages posted in shared queues and not yet taken.
+		*/
+		std::atomic<std::size_t> stealable;
+
+		/**
+			\brief Number of messages posted and not yet processed.
+		*/
+		std::atomic<std::size_t> pending;
+
+		/**
+			\brief The round robin position for the next unkeyed message.
+		*/
+		std::atomic<std::size_t> next;
+
+		/**
+			\brief The bool variable which signals the workers to stop.
+		*/
+		std::atomic<bool> QueueStop;
+
+		/**
+			\brief sets to true if the workers are active.
+		*/
+		std::atomic<bool> isQueueActive;
+
+		/**
+			\brief The function which processes the instruction.
+		*/
+		processing_method msgProc;
+
+		/**
+			\brief The function which gives the ordering key of a message.
+		*/
+		key_method keyOf;
+
+		/**
+			\brief Takes a message from the worker's own queues.
+		*/
+		bool take_own(
+			worker& self /**< : <i>in</i> : The worker.*/,
+			std::optional<info_type>& out /**< : <i>out</i> : The message.*/
+		)
+		{
+			std::lock_guard<std::mutex> lock(self.mtxQueue);
+			if (!self.pinned.empty())
+			{
+				out.emplace(std::move(self.pinned.front()));
+				self.pinned.pop_front();
+				return true;
+			}
+			if (!self.shared.empty())
+			{
+				out.emplace(std::move(self.shared.front()));
+				self.shared.pop_front();
+				--stealable;
+				return true;
+			}
+			return false;
+		}
+
+		/**
+			\brief Steals a message from the back of another worker's shared
+			queue.
+		*/
+		bool steal(
+			std::size_t self /**< : <i>in</i> : Index of the thief.*/,
+			std::optional<info_type>& out /**< : <i>out</i> : The message.*/
+		)
+		{
+			for (std::size_t i = 1; i < workers.size(); ++i)
+			{
+				if (stealable.load() == 0)
+					return false;
+				worker& victim = *workers[(self + i) % workers.size()];
+				std::lock_guard<std::mutex> lock(victim.mtxQueue);
+				if (!victim.shared.empty())
+				{
+					out.emplace(std::move(victim.shared.back()));
+					victim.shared.pop_back();
+					--stealable;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/**
+			\brief Wakes the worker.
+		*/
+		inline void wake(
+			worker& target /**< : <i>in</i> : The worker.*/
+		) noexcept
+		{
+			{ std::lock_guard<std::mutex> lock(target.mtxQueue); }
+			target.cvQueue.notify_one();
+		}
+
+		/**
+			\brief loops and executes tasks from own queue, or stolen from
+			others until stopped.
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if processing function fails.\n
+		*/
+		tristate worker_process(
+			std::size_t index /**< : <i>in</i> : Index of the worker.*/
+		) noexcept
+		{
+			O1_LIB_LOG_LINE;
+			worker& self = *workers[index];
+			std::optional<info_type> front;
+			while (!QueueStop.load())
+			{
+				O3_LIB_LOG_LINE;
+				if (take_own(self, front) || steal(index, front))
+				{
+					tristate ret = msgProc(std::move(*front));
+					front.reset();
+					--pending;
+					if (!ret)
+					{
+						stopQueue();
+						return (tristate::ERROR);
+					}
+					continue;
+				}
+				std::unique_lock<std::mutex> lock(self.mtxQueue);
+				self.isSleeping = true;
+				self.cvQueue.wait(lock, [this, &self]() {
+					return QueueStop.load() || !self.pinned.empty()
+						|| !self.shared.empty() || stealable.load() != 0;
+					});
+				self.isSleeping = false;
+			}
+			O4_LIB_LOG_LINE;
+			return (tristate::GOOD);
+		}
+
+	public:
+
+		/**
+			\brief Constructs the pool with the number of workers and the
+			procedure.
+
+			A worker count of 0 uses std::thread::hardware_concurrency.
+		*/
+		explicit queued_pool(
+			std::size_t worker_count /**< : <i>in</i> : The number of
+									 workers.*/,
+			processing_method msg = processing_method() /**< : <i>in</i> :
+														The procedure.*/
+		) : stealable(0), pending(0), next(0), QueueStop(false),
+			isQueueActive(false), msgProc(msg)
+		{
+			if (worker_count == 0)
+				worker_count = std::thread::hardware_concurrency();
+			if (worker_count == 0)
+				worker_count = 1;
+			for (std::size_t i = 0; i < worker_count; ++i)
+				workers.emplace_back(std::make_unique<worker>());
+		}
+
+		queued_pool(const queued_pool&) = delete;
+
+		queued_pool(queued_pool&&) = delete;
+
+		queued_pool& operator = (queued_pool&&) = delete;
+
+		queued_pool& operator = (const queued_pool&) = delete;
+
+		/**
+			\brief The Function to set a function as the instruction processor.
+		*/
+		inline void RegisterProc(
+			processing_method in /**< : <i>in</i> : The procedure.*/
+		) noexcept
+		{
+			msgProc = in;
+		}
+
+		/**
+			\brief The Function to set the key function, messages with the same
+			key are processed in order by the same worker.
+
+			Must be set before posting messages.
+		*/
+		inline void RegisterKey(
+			key_method in /**< : <i>in</i> : The key function.*/
+		) noexcept
+		{
+			keyOf = in;
+		}
+
+		/**
+			\brief The number of workers.
+		*/
+		inline std::size_t worker_count() const noexcept
+		{
+			return workers.size();
+		}
+
+		/**
+			\brief starts the workers.
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if no procedure was set, or pool is
+			already running.\n
+		*/
+		tristate start_queue_process() noexcept
+		{
+			O3_LIB_LOG_LINE;
+			if (!msgProc)
+				return tristate::ERROR;
+			if (isQueueRunning())
+				return tristate::ERROR;
+			O2_LIB_LOG_LINE;
+			QueueStop = false;
+			for (std::size_t i = 0; i < workers.size(); ++i)
+				workers[i]->queue_thread = std::thread(
+					&queued_pool::worker_process, this, i);
+			isQueueActive = true;
+			return (tristate::GOOD);
+		}
+
+		/**
+			\brief The function post a message onto the queue of a worker.
+		*/
+		void postMessage(
+			info_type Message /**< : <i>in</i> : Message need to be pushed.*/
+		)
+		{
+			++pending;
+			if (keyOf)
+			{
+				worker& target = *workers[keyOf(Message) % workers.size()];
+				{
+					std::lock_guard<std::mutex> lock(target.mtxQueue);
+					target.pinned.push_back(std::move(Message));
+				}
+				target.cvQueue.notify_one();
+				return;
+			}
+			std::size_t index = next++ % workers.size();
+			worker& target = *workers[index];
+			{
+				std::lock_guard<std::mutex> lock(target.mtxQueue);
+				target.shared.push_back(std::move(Message));
+				++stealable;
+			}
+			target.cvQueue.notify_one();
+			if (target.isSleeping.load())
+				return;
+			// target is busy, let an idle worker steal it.
+			for (std::size_t i = 1; i < workers.size(); ++i)
+			{
+				worker& idle = *workers[(index + i) % workers.size()];
+				if (idle.isSleeping.load())
+				{
+					wake(idle);
+					return;
+				}
+			}
+		}
+
+		/**
+			\brief The function to signal the workers to stop processing.
+		*/
+		inline void stopQueue() noexcept
+		{
+			QueueStop = true;
+			for (auto& w : workers)
+				wake(*w);
+		}
+
+		/**
+			\brief Checks if pool is running.
+		*/
+		inline bool isQueueRunning() noexcept { return isQueueActive.load(); }
+
+		/**
+			\brief Waits till workers stop execution. Then empties queues.
+		*/
+		inline void WaitForQueueStop() noexcept
+		{
+			if (!isQueueRunning())
+				return;
+			O3_LIB_LOG_LINE;
+			for (auto& w : workers)
+				if (w->queue_thread.joinable())
+					w->queue_thread.join();
+			O4_LIB_LOG_LINE;
+			for (auto& w : workers)
+			{
+				std::lock_guard<std::mutex> lock(w->mtxQueue);
+				w->shared.clear();
+				w->pinned.clear();
+			}
+			stealable = 0;
+			pending = 0;
+			isQueueActive = false;
+			QueueStop = false;
+		}
+
+		/**
+			\brief The function to wait till all posted messages are
+			processed.
+		*/
+		inline void WaitForQueueEmpty(
+			std::chrono::nanoseconds ns /**< : <i>in</i> : The amount of time
+							to wait between each checks.*/
+		) noexcept
+		{
+			while (pending.load() != 0 && !QueueStop.load())
+			{
+				O3_LIB_LOG_LINE;
+				std::this_thread::sleep_for(ns);
+			}
+		}
+
+		/**
+			\brief Waits till all messages are processed then stops workers
+			and joins.
+		*/
+		inline void safe_join(
+			std::chrono::nanoseconds ns /**< : <i>in</i> : The amount of time
+							to wait between each checks.*/
+		)
+		{
+			if (!isQueueRunning())
+				return;
+			WaitForQueueEmpty(ns);
+			stopQueue();
+			WaitForQueueStop();
+		}
+
+		/**
+			\brief Signals stop then waits for workers to join.
+
+			<b>Note</b> : Even if queues have messages left over, it will exit
+			and messages will be destroyed.
+		*/
+		inline void force_join()
+		{
+			if (!isQueueRunning())
+				return;
+			stopQueue();
+			WaitForQueueStop();
+		}
+
+		/**
+			\brief The destructor. Exits without waiting for queues to empty.
+		*/
+		~queued_pool()
+		{
+			force_join();
+		}
+	};
+}
+
+#endif
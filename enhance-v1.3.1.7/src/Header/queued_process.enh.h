@@ -29,13 +29,26 @@
 #define QUEUED_PROCESS_ENH_H						queued_process.enh.h
 
 #include "error_base.enh.h"
+#include "ring_buffer.enh.h"
+#include "thread_config.enh.h"
+#include "timer.enh.h"
+#include "histogram.enh.h"
 
 #include <mutex>
+#include <deque>
+#include <memory>
 #include <queue>
 #include <condition_variable>
 #include <functional>
 #include <chrono>
+#include <algorithm>
+#include <cstdint>
 #include <new>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 namespace enh
 {
@@ -73,265 +86,2506 @@ namespace enh
 	class blank_t {};
 
 	/**
-		\brief The class to implement a structure which executes instructions
-		concurently after fetching them through a queue for final use
-		including debug calls.
+		\brief The storage of queued_process for policy unbounded_queue, a
+		thin wrapper over std::queue.
 
+		Not thread safe, queued_process guards it with its mutex.
 
-		hasErrorHandlers        = false;\n
+		<h3>Template arguments</h3>
+		-#  <code>class T</code> : The type stored.\n
+		-#  <code>class Alloc</code> : The allocator of the deque under the
+		queue, std::allocator (default) or an arena_allocator through policy
+		allocated_queue.\n
+	*/
+	template<class T, class Alloc = std::allocator<T>>
+	class locked_queue
+	{
+	public:
 
-		The function RegisterProc must be called to setup the processing function
-		before starting the queue process.\n\n
+		using allocator_type = Alloc;
+
+	private:
+
+		using container_type = std::deque<T, Alloc>;
+
+		/**
+			\brief The queue.
+		*/
+		std::queue<T, container_type> queue;
+
+	public:
+
+		locked_queue() = default;
+
+		/**
+			\brief The queue allocating from alloc.
+		*/
+		explicit locked_queue(
+			const Alloc& alloc /**< : <i>in</i> : The allocator.*/
+		) : queue(container_type(alloc)) {}
+
+		/**
+			\brief Pushes the value, always succeeds.
+		*/
+		inline bool try_push(
+			const T& val /**< : <i>in</i> : The value to push.*/
+		)
+		{
+			queue.push(val);
+			return true;
+		}
+
+		/**
+			\brief Pushes the value by moving it, always succeeds.
+		*/
+		inline bool try_push(
+			T&& val /**< : <i>in</i> : The value to push.*/
+		)
+		{
+			queue.push(std::move(val));
+			return true;
+		}
+
+		/**
+			\brief Constructs a value from the arguments at the back, always 
+			succeeds.
+		*/
+		template<class... Args>
+		inline bool try_emplace(
+			Args&&... args /**< : <i>in</i> : The constructor arguments.*/
+		)
+		{
+			queue.emplace(std::forward<Args>(args)...);
+			return true;
+		}
+
+		/**
+			\brief Pops the oldest value.
+
+			<h3>Return</h3>
+			Returns false if the queue is empty.\n
+		*/
+		inline bool try_pop(
+			std::optional<T>& out /**< : <i>out</i> : Holds the value popped.*/
+		)
+		{
+			if (queue.empty())
+				return false;
+			out.emplace(std::move(queue.front()));
+			queue.pop();
+			return true;
+		}
+
+		/**
+			\brief Pops upto max oldest values (all if max is 0), appending them
+			to out.
+
+			<h3>Return</h3>
+			The number of values popped.\n
+		*/
+		inline std::size_t try_pop_bulk(
+			std::vector<T>& out /**< : <i>out</i> : Holds the values popped.*/,
+			std::size_t max /**< : <i>in</i> : The maximum values to pop.*/
+		)
+		{
+			std::size_t count = queue.size();
+			if (max != 0 && max < count)
+				count = max;
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				out.push_back(std::move(queue.front()));
+				queue.pop();
+			}
+			return count;
+		}
+
+		/**
+			\brief Checks if the queue is empty.
+		*/
+		inline bool empty() const noexcept { return queue.empty(); }
+
+		/**
+			\brief The number of values in the queue.
+		*/
+		inline std::size_t size() const noexcept { return queue.size(); }
+
+		/**
+			\brief Removes all values.
+		*/
+		inline void clear()
+		{
+			while (!queue.empty())
+				queue.pop();
+		}
+	};
+
+	/**
+		\brief The queue policy of queued_process that stores messages in an
+		unbounded std::queue guarded by a mutex (default).
+	*/
+	struct unbounded_queue
+	{
+		/**
+			\brief The storage for messages of type T.
+		*/
+		template<class T>
+		using storage = locked_queue<T>;
+
+		/**
+			\brief Storage needs external locking.
+		*/
+		static constexpr bool is_lock_free = false;
+
+		/**
+			\brief try_push never fails.
+		*/
+		static constexpr bool is_bounded = false;
+
+		/**
+			\brief Messages are FIFO.
+		*/
+		static constexpr bool is_scheduled = false;
+
+		/**
+			\brief No statistics are collected.
+		*/
+		static constexpr bool has_stats = false;
+
+		/**
+			\brief Messages are kept in memory only.
+		*/
+		static constexpr bool is_durable = false;
+
+		/**
+			\brief Counts and wake-ups are local to the process.
+		*/
+		static constexpr bool is_shared = false;
+
+		/**
+			\brief Every message posted is kept.
+		*/
+		static constexpr bool is_coalescing = false;
+	};
+
+	/**
+		\brief The queue policy of queued_process that stores messages like
+		unbounded_queue, in memory from the allocator passed on construction
+		of queued_process.
+
+		Use an arena_allocator so the queue storage comes from an arena,
+		recycled through the arena's pool as messages are popped. The queue
+		takes the arena only under its mutex, but the arena must not be used
+		by other threads meanwhile.
 
 		<h3>Template arguments</h3>
-		-#  <code>class instruct</code> : The type to store the instruction.\n
+		-#  <code>class Alloc</code> : The allocator, rebound to the message
+		type.\n
+	*/
+	template<class Alloc>
+	struct allocated_queue : unbounded_queue
+	{
+		/**
+			\brief The storage for messages of type T.
+		*/
+		template<class T>
+		using storage = locked_queue<T,
+			typename std::allocator_traits<Alloc>::template rebind_alloc<T>>;
+	};
 
-		
-		<h3> How To Use </h3>
+	/**
+		\brief The queue policy of queued_process that stores messages in a
+		lock-free bounded multi-producer single-consumer ring.
 
-		- Create a structure that contains information to be sequentially 
-		processed. Let it be `struct info`. You can use structures 
-		`gen_instruct` and `quad_instruct` to merge different types easily.
-		The type must be copy-constructible. Let it be `info`.
+		Posting never takes a lock, postMessage blocks while the ring is full
+		and try_postMessage reports it instead.
 
-		- Create a Function of type queued_process::processing_method returns 
-		`tristate`, takes `info` as argument. The function should return 
-		something other than tristate::GOOD if a fatal error occurs. Let it 
-		be `proc`.
+		<h3>Template arguments</h3>
+		-#  <code>std::size_t capacity</code> : The number of messages that
+		can be pending, must be a power of 2.\n
+	*/
+	template<std::size_t capacity>
+	struct bounded_ring
+	{
+		/**
+			\brief The storage for messages of type T.
+		*/
+		template<class T>
+		using storage = mpsc_ring<T, capacity>;
 
-		- Create object of `queued_process<info>`, construct by passing `proc`
-		 or default construct then call `Register(proc)`.
+		/**
+			\brief Storage is safe for concurrent producers and one consumer.
+		*/
+		static constexpr bool is_lock_free = true;
+
+		/**
+			\brief try_push fails when full.
+		*/
+		static constexpr bool is_bounded = true;
 
-		- Call `start_queue_process` to start waiting on messages.
+		/**
+			\brief Messages are FIFO.
+		*/
+		static constexpr bool is_scheduled = false;
 
-		- Call `postMessage` and pass the message to add message to queue.
+		/**
+			\brief No statistics are collected.
+		*/
+		static constexpr bool has_stats = false;
 
-		- Call `stopQueue` to stop processing.
+		/**
+			\brief Messages are kept in memory only.
+		*/
+		static constexpr bool is_durable = false;
 
-		- Call `WaitForQueueStop` to wait till queued execution thread stops.
-		Will only stop after executing full queue unless function returns 
-		error.
+		/**
+			\brief Counts and wake-ups are local to the process.
+		*/
+		static constexpr bool is_shared = false;
 
+		/**
+			\brief Every message posted is kept.
+		*/
+		static constexpr bool is_coalescing = false;
+	};
 
-		<h3>Example</h3>
-		
-		\include{lineno} queued_process_ex.cpp
+	/**
+		\brief The storage of queued_process for policy priority_schedule,
+		orders messages by priority and the time they are due.
+
+		Messages due in the future wait in a heap ordered by due time, when
+		they come due they move to a heap ordered by priority (higher first,
+		FIFO for same priority). Pushing and popping are O(log n).\n\n
 
+		Not thread safe, queued_process guards it with its mutex.
 	*/
-	template< class instruct>
-	class queued_process 
+	template<class T>
+	class scheduled_queue
 	{
+		/**
+			\brief A message with its schedule.
+		*/
+		struct entry
+		{
+			time_pt due;
+			int priority;
+			std::uint64_t order;
+			T value;
+		};
+
+		/**
+			\brief Heap order for ready, highest priority, then oldest on top.
+		*/
+		struct by_priority
+		{
+			inline bool operator()(const entry& a, const entry& b) const noexcept
+			{
+				return (a.priority != b.priority) ? (a.priority < b.priority)
+					: (a.order > b.order);
+			}
+		};
+
+		/**
+			\brief Heap order for delayed, earliest due, then oldest on top.
+		*/
+		struct by_due
+		{
+			inline bool operator()(const entry& a, const entry& b) const noexcept
+			{
+				return (a.due != b.due) ? (a.due > b.due) : (a.order > b.order);
+			}
+		};
+
+		/**
+			\brief Messages that are due, as a heap by_priority.
+		*/
+		std::vector<entry> ready;
+
+		/**
+			\brief Messages due in the future, as a heap by_due.
+		*/
+		std::vector<entry> delayed;
+
+		/**
+			\brief The count of messages pushed, keeps FIFO order within a 
+			priority.
+		*/
+		std::uint64_t pushed = 0;
+
+		/**
+			\brief Moves messages that are due to ready.
+		*/
+		void promote()
+		{
+			if (delayed.empty())
+				return;
+			time_pt now = high_res::now();
+			while (!delayed.empty() && delayed.front().due <= now)
+			{
+				std::pop_heap(delayed.begin(), delayed.end(), by_due());
+				ready.push_back(std::move(delayed.back()));
+				delayed.pop_back();
+				std::push_heap(ready.begin(), ready.end(), by_priority());
+			}
+		}
+
 	public:
 
 		/**
-			\brief The type of object to be processed
+			\brief Constructs a value from the arguments due at the time and
+			with the priority, always succeeds.
 		*/
-		using info_type = instruct;
+		template<class... Args>
+		inline bool try_emplace_at(
+			time_pt due /**< : <i>in</i> : The earliest time to pop it, 
+						time_pt::min() for now.*/,
+			int priority /**< : <i>in</i> : The priority, higher first.*/,
+			Args&&... args /**< : <i>in</i> : The constructor arguments.*/
+		)
+		{
+			if (due == time_pt::min())
+			{
+				ready.push_back(entry{ due, priority, pushed++,
+					T(std::forward<Args>(args)...) });
+				std::push_heap(ready.begin(), ready.end(), by_priority());
+			}
+			else
+			{
+				delayed.push_back(entry{ due, priority, pushed++,
+					T(std::forward<Args>(args)...) });
+				std::push_heap(delayed.begin(), delayed.end(), by_due());
+			}
+			return true;
+		}
 
 		/**
-			\brief The function type that processes the infomation passed.
+			\brief Constructs a value from the arguments, due now with
+			priority 0, always succeeds.
 		*/
-		using processing_method = std::function<tristate(info_type)>;
+		template<class... Args>
+		inline bool try_emplace(
+			Args&&... args /**< : <i>in</i> : The constructor arguments.*/
+		)
+		{
+			return try_emplace_at(time_pt::min(), 0, std::forward<Args>(args)...);
+		}
 
-	private:
+		/**
+			\brief Pushes a copy of the value, always succeeds.
+		*/
+		inline bool try_push(
+			const T& val /**< : <i>in</i> : The value to push.*/
+		)
+		{
+			return try_emplace(val);
+		}
 
 		/**
-			\brief The synchronising mutex for Queue.
+			\brief Pushes the value by moving it, always succeeds.
 		*/
-		std::mutex mtxQueue;
+		inline bool try_push(
+			T&& val /**< : <i>in</i> : The value to push.*/
+		)
+		{
+			return try_emplace(std::move(val));
+		}
 
 		/**
-			\brief The Queue to pass instruction from main to instruction processor.
+			\brief Pops the highest priority value that is due.
+
+			<h3>Return</h3>
+			Returns false if no value is due.\n
 		*/
-		std::queue<info_type> QueuedMessage;
+		inline bool try_pop(
+			std::optional<T>& out /**< : <i>out</i> : Holds the value popped.*/
+		)
+		{
+			promote();
+			if (ready.empty())
+				return false;
+			std::pop_heap(ready.begin(), ready.end(), by_priority());
+			out.emplace(std::move(ready.back().value));
+			ready.pop_back();
+			return true;
+		}
 
 		/**
-			\brief The object to notify update to queue.
+			\brief Pops upto max values that are due (all if max is 0) in 
+			order, appending them to out.
+
+			<h3>Return</h3>
+			The number of values popped.\n
 		*/
-		std::condition_variable cvQueue;
+		inline std::size_t try_pop_bulk(
+			std::vector<T>& out /**< : <i>out</i> : Holds the values popped.*/,
+			std::size_t max /**< : <i>in</i> : The maximum values to pop.*/
+		)
+		{
+			promote();
+			std::size_t count = 0;
+			while (!ready.empty() && (max == 0 || count < max))
+			{
+				std::pop_heap(ready.begin(), ready.end(), by_priority());
+				out.push_back(std::move(ready.back().value));
+				ready.pop_back();
+				++count;
+			}
+			return count;
+		}
 
 		/**
-			\brief The bool value which indicates whether queue has been
-			updated to avoid false wake-ups.
+			\brief Checks if there are values that are due later.
 		*/
-		std::atomic<bool> isUpdated;
+		inline bool has_delayed() const noexcept { return !delayed.empty(); }
 
 		/**
-			\brief The bool variable which signals the instruction processing
-			function to stop and exit after emptying the queue.
+			\brief The time the earliest delayed value is due, call only if 
+			has_delayed.
 		*/
-		std::atomic<bool> QueueStop;
+		inline time_pt next_due() const noexcept { return delayed.front().due; }
 
 		/**
-			\brief sets to true if Queued instruction processor is active.
+			\brief Checks if the queue is empty (including delayed values).
 		*/
-		std::atomic<bool> isQueueActive;
+		inline bool empty() const noexcept 
+		{ 
+			return ready.empty() && delayed.empty(); 
+		}
 
 		/**
-			\brief The function which processes the instruction then.
+			\brief The number of values in the queue (including delayed 
+			values).
 		*/
-		processing_method msgProc;
+		inline std::size_t size() const noexcept 
+		{ 
+			return ready.size() + delayed.size(); 
+		}
 
 		/**
-			\brief The thread handle for the queue process.
+			\brief Removes all values.
 		*/
-		std::thread queue_thread;
+		inline void clear() 
+		{ 
+			ready.clear(); 
+			delayed.clear(); 
+		}
+	};
+
+	/**
+		\brief The queue policy of queued_process that orders messages by 
+		priority and lets them be posted to run at or after a time.
+
+		Enables postPriorityMessage, postMessageAt and postMessageAfter. The
+		processing thread blocks till the earliest due message instead of 
+		polling, wait strategies other than park are not used.
+	*/
+	struct priority_schedule
+	{
+		/**
+			\brief The storage for messages of type T.
+		*/
+		template<class T>
+		using storage = scheduled_queue<T>;
+
+		/**
+			\brief Storage needs external locking.
+		*/
+		static constexpr bool is_lock_free = false;
+
+		/**
+			\brief try_push never fails.
+		*/
+		static constexpr bool is_bounded = false;
+
+		/**
+			\brief Messages carry a priority and a due time.
+		*/
+		static constexpr bool is_scheduled = true;
 
+		/**
+			\brief No statistics are collected.
+		*/
+		static constexpr bool has_stats = false;
 
+		/**
+			\brief Messages are kept in memory only.
+		*/
+		static constexpr bool is_durable = false;
+
+		/**
+			\brief Counts and wake-ups are local to the process.
+		*/
+		static constexpr bool is_shared = false;
+
+		/**
+			\brief Every message posted is kept.
+		*/
+		static constexpr bool is_coalescing = false;
+	};
+
+	/**
+		\brief The queue policy of queued_process that adds statistics to 
+		another policy.
+
+		Every message is stamped with the time it was posted, the processing 
+		thread records counts, queue depth and latency histograms, read them 
+		with queued_process::getStats. Without this policy none of it is 
+		compiled in.
+
+		<h3>Template arguments</h3>
+		-#  <code>class base</code> : The policy to add statistics to.\n
+	*/
+	template<class base>
+	struct with_stats : base
+	{
+		/**
+			\brief Statistics are collected.
+		*/
+		static constexpr bool has_stats = true;
+	};
+
+	/**
+		\brief The tag to construct a stamped_message with the current time.
+	*/
+	struct stamp_now_t
+	{
+		/**
+			\brief The trace flow id of the message, 0 if not traced.
+		*/
+		std::uint64_t flow = 0;
+	};
+
+	/**
+		\brief A queued message with the time it was posted, stored by 
+		queued_process for a with_stats policy.
+	*/
+	template<class T>
+	struct stamped_message
+	{
+		/**
+			\brief The time the message was posted.
+		*/
+		time_pt posted;
+
+		/**
+			\brief The trace flow id from post to processing, 0 if not traced.
+		*/
+		std::uint64_t flow;
+
+		/**
+			\brief The message.
+		*/
+		T value;
+
+		/**
+			\brief Constructs the message from the arguments, stamped now.
+		*/
+		template<class... Args>
+		explicit stamped_message(
+			stamp_now_t tag /**< : <i>in</i> : The tag.*/,
+			Args&&... args /**< : <i>in</i> : The constructor arguments.*/
+		) noexcept(std::is_nothrow_constructible_v<T, Args&&...>)
+			: posted(high_res::now()), flow(tag.flow), value(std::forward<Args>(args)...)
+		{}
+	};
+
+	/**
+		\brief The message of a stored value, for the key of a coalescing
+		queue.
+	*/
+	template<class T>
+	inline const T& coalesce_message(
+		const T& value /**< : <i>in</i> : The value stored.*/
+	) noexcept
+	{
+		return value;
+	}
+
+	/**
+		\brief The message of a value stamped for statistics.
+	*/
+	template<class T>
+	inline const T& coalesce_message(
+		const stamped_message<T>& value /**< : <i>in</i> : The value stored.*/
+	) noexcept
+	{
+		return value.value;
+	}
+
+	/**
+		\brief The storage of queued_process for policy coalesce_by, keeps
+		only the latest value posted for each key pending.
+
+		A value whose key is already pending replaces the pending value in
+		its place in the queue, so the queue holds at most one value per
+		distinct key and a lagging consumer skips stale values.\n\n
+
+		Not thread safe, queued_process guards it with its mutex.
+
+		<h3>Template arguments</h3>
+		-#  <code>class T</code> : The type stored, move assignable.\n
+		-#  <code>class KeyFn</code> : The function giving the key of a 
+		message, the key must be hashable by std::hash.\n
+	*/
+	template<class T, class KeyFn>
+	class coalescing_queue
+	{
+	public:
+
+		/**
+			\brief The type of the key.
+		*/
+		using key_type = std::decay_t<std::invoke_result_t<const KeyFn&,
+			decltype(coalesce_message(std::declval<const T&>()))>>;
+
+	private:
+
+		/**
+			\brief Gives the key of a message.
+		*/
+		KeyFn keyOf;
+
+		/**
+			\brief The pending keys in the order they were first posted.
+		*/
+		std::deque<key_type> order;
+
+		/**
+			\brief The latest value of every pending key.
+		*/
+		std::unordered_map<key_type, T> values;
+
+		/**
+			\brief true if the last push replaced a pending value.
+		*/
+		bool replaced = false;
+
+		/**
+			\brief Stores value under its key, replacing the pending one.
+		*/
+		inline bool store(
+			T&& value /**< : <i>in</i> : The value.*/
+		)
+		{
+			key_type key = keyOf(coalesce_message(value));
+			auto found = values.find(key);
+			replaced = found != values.end();
+			if (replaced)
+				found->second = std::move(value);
+			else
+			{
+				values.emplace(key, std::move(value));
+				order.push_back(std::move(key));
+			}
+			return true;
+		}
+
+	public:
+
+		coalescing_queue() = default;
+
+		/**
+			\brief The queue keyed by key.
+		*/
+		explicit coalescing_queue(
+			const KeyFn& key /**< : <i>in</i> : The key function.*/
+		) : keyOf(key) {}
+
+		/**
+			\brief Pushes a copy of the value, always succeeds.
+		*/
+		inline bool try_push(
+			const T& val /**< : <i>in</i> : The value to push.*/
+		)
+		{
+			return store(T(val));
+		}
+
+		/**
+			\brief Pushes the value by moving it, always succeeds.
+		*/
+		inline bool try_push(
+			T&& val /**< : <i>in</i> : The value to push.*/
+		)
+		{
+			return store(std::move(val));
+		}
+
+		/**
+			\brief Constructs a value from the arguments and pushes it, always
+			succeeds.
+		*/
+		template<class... Args>
+		inline bool try_emplace(
+			Args&&... args /**< : <i>in</i> : The constructor arguments.*/
+		)
+		{
+			return store(T(std::forward<Args>(args)...));
+		}
+
+		/**
+			\brief Checks if the last push replaced a pending value instead of
+			adding one.
+		*/
+		inline bool coalesced() const noexcept { return replaced; }
+
+		/**
+			\brief Pops the value of the oldest pending key.
+
+			<h3>Return</h3>
+			Returns false if the queue is empty.\n
+		*/
+		inline bool try_pop(
+			std::optional<T>& out /**< : <i>out</i> : Holds the value popped.*/
+		)
+		{
+			if (order.empty())
+				return false;
+			auto found = values.find(order.front());
+			out.emplace(std::move(found->second));
+			values.erase(found);
+			order.pop_front();
+			return true;
+		}
+
+		/**
+			\brief Pops upto max oldest values (all if max is 0), appending them
+			to out.
+
+			<h3>Return</h3>
+			The number of values popped.\n
+		*/
+		inline std::size_t try_pop_bulk(
+			std::vector<T>& out /**< : <i>out</i> : Holds the values popped.*/,
+			std::size_t max /**< : <i>in</i> : The maximum values to pop.*/
+		)
+		{
+			std::size_t count = order.size();
+			if (max != 0 && max < count)
+				count = max;
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				auto found = values.find(order.front());
+				out.push_back(std::move(found->second));
+				values.erase(found);
+				order.pop_front();
+			}
+			return count;
+		}
+
+		/**
+			\brief Checks if the queue is empty.
+		*/
+		inline bool empty() const noexcept { return order.empty(); }
+
+		/**
+			\brief The number of pending keys.
+		*/
+		inline std::size_t size() const noexcept { return order.size(); }
+
+		/**
+			\brief Removes all values.
+		*/
+		inline void clear()
+		{
+			order.clear();
+			values.clear();
+		}
+	};
+
+	/**
+		\brief The queue policy of queued_process that keeps only the latest
+		message of each key pending, like unbounded_queue otherwise.
+
+		Posting a message whose key is pending replaces the pending message in
+		its place, the queue is bounded by the number of distinct keys. Pass 
+		the key function on construction of queued_process if it is not 
+		default constructible.
+
+		<h3>Template arguments</h3>
+		-#  <code>class KeyFn</code> : The function giving the key of a 
+		message, like `struct by_id { int operator()(const msg& m) const 
+		{ return m.id; } };`.\n
+	*/
+	template<class KeyFn>
+	struct coalesce_by : unbounded_queue
+	{
+		/**
+			\brief The storage for messages of type T.
+		*/
+		template<class T>
+		using storage = coalescing_queue<T, KeyFn>;
+
+		/**
+			\brief A message replaces the pending one of its key.
+		*/
+		static constexpr bool is_coalescing = true;
+	};
+
+	/**
+		\brief The counters of a queued_process with a with_stats policy.
+
+		Only enqueued is written by producers, the rest only by the 
+		processing thread, all with relaxed atomics.
+	*/
+	struct queue_counters
+	{
+		/**
+			\brief Messages posted.
+		*/
+		alignas(cache_line_size) std::atomic<std::uint64_t> enqueued{ 0 };
+
+		/**
+			\brief Messages taken by the processing thread.
+		*/
+		alignas(cache_line_size) std::atomic<std::uint64_t> dequeued{ 0 };
+
+		/**
+			\brief Calls of the processing function that did not return 
+			tristate::GOOD.
+		*/
+		std::atomic<std::uint64_t> failures{ 0 };
+
+		/**
+			\brief The largest depth seen by the processing thread.
+		*/
+		std::atomic<std::size_t> highWater{ 0 };
+
+		/**
+			\brief Nanoseconds from post to the start of processing.
+		*/
+		log_histogram waitTime;
+
+		/**
+			\brief Nanoseconds spent in the processing function (per batch 
+			for a batch processor).
+		*/
+		log_histogram procTime;
+
+		/**
+			\brief Nanoseconds mtxQueue was held to push or pop messages, by
+			producers and the processing thread.
+		*/
+		log_histogram lockHold;
+	};
+
+	/**
+		\brief The copy of the statistics of a queued_process.
+	*/
+	struct queue_stats_snapshot
+	{
+		/**
+			\brief Messages posted.
+		*/
+		std::uint64_t enqueued = 0;
+
+		/**
+			\brief Messages taken by the processing thread.
+		*/
+		std::uint64_t dequeued = 0;
+
+		/**
+			\brief Calls of the processing function that did not return 
+			tristate::GOOD.
+		*/
+		std::uint64_t failures = 0;
+
+		/**
+			\brief Messages posted and not yet processed.
+		*/
+		std::size_t depth = 0;
+
+		/**
+			\brief The largest depth seen by the processing thread.
+		*/
+		std::size_t high_water = 0;
+
+		/**
+			\brief Nanoseconds from post to the start of processing.
+		*/
+		histogram_snapshot wait_ns;
+
+		/**
+			\brief Nanoseconds spent in the processing function.
+		*/
+		histogram_snapshot process_ns;
+
+		/**
+			\brief Nanoseconds the queue mutex was held to push or pop 
+			messages, empty for a lock-free policy.
+		*/
+		histogram_snapshot lock_hold_ns;
+	};
+
+	/**
+		\brief The ways the processing thread of queued_process can wait for
+		messages.
+	*/
+	enum class wait_strategy
+	{
+		park,				/**< : Block on the condition variable (default).*/
+		spin_park,			/**< : Spin for a while, then block.*/
+		spin_yield,			/**< : Spin for a while, then yield till a
+							message arrives, never blocks.*/
+		busy_spin			/**< : Spin till a message arrives, never 
+							blocks.*/
+	};
+
+	/**
+		\brief The class to implement a structure which executes instructions
+		concurently after fetching them through a queue for final use
+		including debug calls.
+
+
+		hasErrorHandlers        = false;\n
+
+		The function RegisterProc must be called to setup the processing function
+		before starting the queue process.\n\n
+
+		<h3>Template arguments</h3>
+		-#  <code>class instruct</code> : The type to store the instruction.\n
+		-#  <code>class policy</code> : The queue policy, unbounded_queue
+		(default), bounded_ring<capacity> for a lock-free bounded queue,
+		priority_schedule for priority and time ordered messages or
+		allocated_queue<Alloc> for queue storage from an allocator.\n
+		-#  <code>class handler</code> : The type of the processing function,
+		std::function (default) or any callable type taking `instruct` and
+		returning `tristate`. A concrete type (like a function object class) 
+		lets the compiler inline the call for every message.\n
+
+		
+		<h3> How To Use </h3>
+
+		- Create a structure that contains information to be sequentially 
+		processed. Let it be `struct info`. You can use structures 
+		`gen_instruct` and `quad_instruct` to merge different types easily.
+		The type must be move-constructible, messages are moved from 
+		posting to processing, so move-only types can be used. Let it be 
+		`info`.
+
+		- Create a Function of type queued_process::processing_method returns 
+		`tristate`, takes `info` as argument. The function should return 
+		something other than tristate::GOOD if a fatal error occurs. Let it 
+		be `proc`.
+
+		- Create object of `queued_process<info>`, construct by passing `proc`
+		 or default construct then call `Register(proc)`. If a handler type
+		 is given as template argument that is not default constructible 
+		 (like a lambda), pass `proc` on construction.
+
+		- Call `start_queue_process` to start waiting on messages. Pass a
+		`thread_config` to set the processors, NUMA node, scheduling and name
+		of the processing thread.
+
+		- To share a thread pool instead of owning a thread, pass an 
+		executor_method (like `[&pool](auto task) { pool.post(task); }`) and
+		a quantum to `start_queue_process`. Messages are then drained by 
+		tasks on the pool that yield after a quantum of messages.
+
+		- To process messages in batches, call `setBatchLimit` with the
+		maximum messages taken per queue access (0 for all pending). Pending
+		messages are taken under a single lock and processed without it.
+		Optionally call `RegisterBatchProc` with a queued_process::batch_method
+		to get each batch as an array instead of one call per message.
+		Call `setLinger(n, t)` so that the processing thread waits till n 
+		messages are pending or t passed since the first before taking a 
+		batch, for handlers that gain from large batches (like inserts).
+
+		- With policy priority_schedule call `postPriorityMessage` for 
+		messages that jump ahead, and `postMessageAt` or `postMessageAfter`
+		for messages that should only run once the time comes.
+		`WaitForQueueEmpty` and `safe_join` also wait for delayed messages.
+
+		- To monitor the queue, wrap the policy in `with_stats` (like 
+		`with_stats<unbounded_queue>`) and call `getStats` for counts, depth
+		and histograms of wait, processing and queue lock hold time.
+		With `debug::setTracing(true)` a with_stats queue also logs trace
+		spans of posting and processing, linked per message by flow arrows.
+
+		- For low latency call `setWaitStrategy` so that the processing 
+		thread spins before blocking (or never blocks), instead of being 
+		woken by the condition variable.
+
+		- With C++20 coroutines (ENH_HAS_COROUTINES), pass 
+		`coroutine_method<info>(fn, tasks)` as `proc` where fn is a 
+		coroutine returning `process_task`, so processing that waits (like
+		`co_await tm.sleep(n)`) does not hold the processing thread.
+
+		- For messages that carry the latest state of a key, use policy
+		`coalesce_by<KeyFn>` : a message whose key is pending replaces the 
+		pending one, so a lagging consumer only sees the latest.
+
+		- To take the queue storage from an enh::arena, use policy
+		`allocated_queue<arena_allocator<info>>` and construct passing 
+		`proc` and the allocator.
+
+		- To keep messages across a crash, use policy durable_queue (from
+		durable_queue.enh.h) and construct passing `proc` and a `wal_config`.
+		Messages not processed are processed on the next start.
+
+		- To post from other processes, use policy shared_ring (from 
+		shared_queue.enh.h) in every process with the same `shm_config`, 
+		only the consumer passes `proc` and starts processing.
+
+		- Call `postMessage` and pass the message to add message to queue, 
+		or `emplaceMessage` to construct it in place in the queue.
+		With a bounded policy `postMessage` waits for space, use
+		`try_postMessage` to get back-pressure instead.
+
+		- Call `stopQueue` to stop processing.
+
+		- Call `WaitForQueueStop` to wait till queued execution thread stops.
+		Will only stop after executing full queue unless function returns 
+		error.
+
+		- Call `WaitForQueueEmpty` to block till every posted message is
+		processed, pass a `std::chrono::time_point` to give up at a deadline.
+		`safe_join` waits for the queue to drain the same way before 
+		stopping.
+
+
+		<h3>Example</h3>
+		
+		\include{lineno} queued_process_ex.cpp
+
+	*/
+	template< class instruct, class policy = unbounded_queue,
+		class handler = std::function<tristate(instruct)>>
+	class queued_process 
+	{
+	public:
+
+		/**
+			\brief The type of object to be processed
+		*/
+		using info_type = instruct;
+
+		/**
+			\brief The queue policy.
+		*/
+		using policy_type = policy;
+
+		/**
+			\brief true if statistics are collected.
+		*/
+		static constexpr bool has_stats = policy::has_stats;
+
+		/**
+			\brief The type held by the storage, info_type stamped with post 
+			time if statistics are collected.
+		*/
+		using stored_type = std::conditional_t<has_stats, 
+			stamped_message<info_type>, info_type>;
+
+		/**
+			\brief The type of storage for queued messages.
+		*/
+		using storage_type = typename policy::template storage<stored_type>;
+
+		/**
+			\brief The function type that processes the infomation passed.
+		*/
+		using processing_method = handler;
+
+		/**
+			\brief The function type that processes a batch of messages, takes 
+			pointer to the first message and the number of messages.
+		*/
+		using batch_method = std::function<tristate(info_type*, std::size_t)>;
+
+		/**
+			\brief The function type that runs a task on an executor, like 
+			posting it to a thread pool.
+		*/
+		using executor_method = std::function<void(std::function<void()>)>;
+
+	private:
+
+		/**
+			\brief The synchronising mutex for Queue (only guards the condition
+			variable if the storage is lock-free).
+		*/
+		std::mutex mtxQueue;
+
+		/**
+			\brief The Queue to pass instruction from main to instruction processor.
+		*/
+		storage_type QueuedMessage;
+
+		/**
+			\brief The object to notify update to queue.
+		*/
+		std::condition_variable cvQueue;
+
+		/**
+			\brief The bool value which indicates whether queue has been
+			updated to avoid false wake-ups.
+		*/
+		std::atomic<bool> isUpdated;
+
+		/**
+			\brief true while the processing thread blocks on cvQueue, 
+			producers only notify if set.
+		*/
+		std::atomic<bool> isSleeping;
+
+		/**
+			\brief The way the processing thread waits for messages.
+		*/
+		std::atomic<wait_strategy> waitMode;
+
+		/**
+			\brief Number of spins before yielding or blocking.
+		*/
+		std::atomic<std::size_t> spinLimit;
+
+		/**
+			\brief The messages the processing thread lingers for before 
+			draining, 0 to not linger.
+		*/
+		std::atomic<std::size_t> lingerCount{ 0 };
+
+		/**
+			\brief The longest the processing thread lingers for after it 
+			sees the first pending message.
+		*/
+		std::atomic<std::chrono::nanoseconds> lingerTime{ 
+			std::chrono::nanoseconds(0) };
+
+		/**
+			\brief true while the processing thread lingers, producers only
+			wake it once lingerCount messages are pending.
+		*/
+		std::atomic<bool> isLingering{ false };
+
+		/**
+			\brief The bool variable which signals the instruction processing
+			function to stop and exit after emptying the queue.
+		*/
+		std::atomic<bool> QueueStop;
+
+		/**
+			\brief sets to true if Queued instruction processor is active.
+		*/
+		std::atomic<bool> isQueueActive;
+
+		/**
+			\brief The function which processes the instruction then.
+		*/
+		processing_method msgProc;
+
+		/**
+			\brief The function which processes a batch of instructions, used 
+			instead of msgProc if set.
+		*/
+		batch_method batchProc;
+
+		/**
+			\brief The maximum messages popped per queue access, 0 for all.
+		*/
+		std::atomic<std::size_t> batchLimit;
+
+		/**
+			\brief The consumer-local buffer messages are drained to in batch
+			mode.
+		*/
+		std::vector<stored_type> batch;
+
+		/**
+			\brief The messages of batch unstamped for the batch processor, 
+			only used if statistics are collected.
+		*/
+		std::conditional_t<has_stats, std::vector<info_type>, blank_t> 
+			batchValues;
+
+		/**
+			\brief The statistics, only if policy has_stats.
+		*/
+		std::conditional_t<has_stats, queue_counters, blank_t> stats;
+
+		/**
+			\brief Number of messages posted and not yet processed (including
+			the ones being processed).
+		*/
+		std::atomic<std::size_t> pending;
+
+		/**
+			\brief Number of threads waiting for the queue to drain.
+		*/
+		std::atomic<std::size_t> drainWaiters;
+
+		/**
+			\brief true once the processing thread has exited.
+		*/
+		std::atomic<bool> isProcExited;
+
+		/**
+			\brief The synchronising mutex for cvDrained.
+		*/
+		std::mutex mtxDrained;
+
+		/**
+			\brief The object to notify that the queue drained or the 
+			processing thread exited.
+		*/
+		std::condition_variable cvDrained;
+
+		/**
+			\brief The configuration the processing thread applies when it 
+			starts, if any.
+		*/
+		std::optional<thread_config> threadConfig;
+
+		/**
+			\brief The executor draining runs on instead of queue_thread, if 
+			started with one.
+		*/
+		executor_method executor;
+
+		/**
+			\brief The most messages a drain task processes before it yields
+			the executor thread.
+		*/
+		std::size_t quantum = 64;
+
+		/**
+			\brief true while started on an executor.
+		*/
+		std::atomic<bool> onExecutor{ false };
+
+		/**
+			\brief true while a drain task is submitted or running.
+		*/
+		std::atomic<bool> drainScheduled{ false };
+
+		/**
+			\brief Drain tasks submitted and not returned, changed to 0 only
+			under mtxDrained.
+		*/
+		std::atomic<std::size_t> activeTasks{ 0 };
+
+		/**
+			\brief The thread handle for the queue process.
+		*/
+		std::thread queue_thread;
+
+		/**
+			\brief The lock of mtxQueue for pushing or popping messages, 
+			records how long it was held if statistics are collected.
+		*/
+		class queue_lock
+		{
+			queued_process& owner;
+
+			std::conditional_t<has_stats, time_pt, blank_t> taken;
+
+		public:
+
+			explicit inline queue_lock(
+				queued_process& q /**< : <i>in</i> : The queue to lock.*/
+			) noexcept : owner(q)
+			{
+				owner.mtxQueue.lock();
+				if constexpr (has_stats)
+					taken = high_res::now();
+			}
+
+			queue_lock(const queue_lock&) = delete;
+			queue_lock& operator = (const queue_lock&) = delete;
+
+			inline ~queue_lock()
+			{
+				if constexpr (has_stats)
+				{
+					auto held = high_res::now() - taken;
+					owner.mtxQueue.unlock();
+					owner.stats.lockHold.record(static_cast<std::uint64_t>(
+						std::chrono::duration_cast<std::chrono::nanoseconds>(
+							held).count()));
+				}
+				else
+					owner.mtxQueue.unlock();
+			}
+		};
+
+
+
+		/**
+			\brief loops and executes tasks pushed into message queue until
+			EXIT_QUEUE is pushed into the queue.
+
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if any msg_switch fails.\n
+			Returns tristate::PREV_ERROR if error was flagged in any previous
+			function calls.\n
+
+		*/
+		tristate queue_exec_process() noexcept
+		{
+			O1_LIB_LOG_LINE;
+			if (!hasProc() && !batchProc)
+				return tristate::ERROR;
+			O1_LIB_LOG_LINE;
+			std::optional<stored_type> front;
+			while (!(QueueStop.load()))
+			{
+				O3_LIB_LOG_LINE;
+				if (!(isUpdated.load()) && !wait_for_update())
+					return (tristate::GOOD);
+				isUpdated = false;
+				if constexpr (!policy::is_scheduled && !policy::is_shared)
+					if (lingerCount.load() != 0 && !linger())
+						continue;
+				bool stopNow = QueueStop.load();
+				if (batchProc || batchLimit.load() != 1)
+				{
+					if (!drain_batches())
+						return (tristate::ERROR);
+					continue;
+				}
+				while (!stopNow && pop(front))
+				{
+					O3_LIB_LOG_LINE;
+					tristate ret = process_one(*front);
+					front.reset();
+					if (!ret)
+						return (tristate::ERROR);
+					complete_messages(1);
+					stopNow = QueueStop.load();
+				}
+
+			}
+			O4_LIB_LOG_LINE;
+			return (tristate::GOOD);
+		}
+
+		/**
+			\brief Waits till queue is updated or stop is signalled, as set 
+			by waitMode.
+
+			For a scheduled policy, also wakes when the earliest delayed 
+			message is due.
+
+			<h3>Return</h3>
+			false if woken only by stop.\n
+		*/
+		bool wait_for_update() noexcept
+		{
+			if constexpr (policy::is_shared)
+				return wait_for_shared();
+			auto ready = [this]() {
+				return isUpdated.load() || QueueStop.load();
+			};
+			if constexpr (policy::is_scheduled)
+			{
+				std::unique_lock<std::mutex> lock(mtxQueue);
+				isSleeping = true;
+				bool isDue = false;
+				while (!ready())
+				{
+					if (!QueuedMessage.has_delayed())
+						cvQueue.wait(lock);
+					else if (cvQueue.wait_until(lock, QueuedMessage.next_due())
+						== std::cv_status::timeout)
+					{
+						isDue = true;
+						break;
+					}
+				}
+				isSleeping = false;
+				return isUpdated.load() || isDue;
+			}
+			wait_strategy mode = waitMode.load();
+			if (mode != wait_strategy::park)
+			{
+				std::size_t limit = spinLimit.load();
+				for (std::size_t i = 0; mode == wait_strategy::busy_spin 
+					|| i < limit; ++i)
+				{
+					if (ready())
+						return isUpdated.load();
+					cpu_relax();
+				}
+				if (mode == wait_strategy::spin_yield)
+				{
+					while (!ready())
+						std::this_thread::yield();
+					return isUpdated.load();
+				}
+			}
+			std::unique_lock<std::mutex> lock(mtxQueue);
+			// set under the lock before the predicate is checked, a producer
+			// that misses it is guaranteed to be seen by the predicate.
+			isSleeping = true;
+			cvQueue.wait(lock, ready);
+			isSleeping = false;
+			return isUpdated.load();
+		}
+
+		/**
+			\brief Waits till lingerCount messages are pending, lingerTime 
+			passed or stop is signalled, so they are drained together.
+
+			<h3>Return</h3>
+			false if no message was pending, there is nothing to drain.\n
+		*/
+		bool linger() noexcept
+		{
+			time_pt deadline = high_res::now() + lingerTime.load();
+			std::unique_lock<std::mutex> lock(mtxQueue);
+			if (QueuedMessage.empty())
+				return false;
+			isLingering = true;
+			isSleeping = true;
+			cvQueue.wait_until(lock, deadline, [this]() {
+				return QueuedMessage.size() >= lingerCount.load() 
+					|| QueueStop.load();
+				});
+			isSleeping = false;
+			isLingering = false;
+			return true;
+		}
+
+		/**
+			\brief Checks if a producer should wake the processing thread, not
+			while it lingers for more messages (under mtxQueue if the storage
+			is not lock-free).
+		*/
+		inline bool should_wake() const noexcept
+		{
+			return !isLingering.load() 
+				|| QueuedMessage.size() >= lingerCount.load();
+		}
+
+		/**
+			\brief Waits till the shared storage holds a message or stop is 
+			signalled, as set by waitMode. Producers of other processes do not 
+			set isUpdated, the storage is checked instead.
+
+			<h3>Return</h3>
+			false if woken only by stop.\n
+		*/
+		bool wait_for_shared() noexcept
+		{
+			auto ready = [this]() {
+				return !QueuedMessage.empty() || QueueStop.load();
+			};
+			wait_strategy mode = waitMode.load();
+			if (mode != wait_strategy::park)
+			{
+				std::size_t limit = spinLimit.load();
+				for (std::size_t i = 0; mode == wait_strategy::busy_spin 
+					|| i < limit; ++i)
+				{
+					if (ready())
+						return !QueuedMessage.empty();
+					cpu_relax();
+				}
+				if (mode == wait_strategy::spin_yield)
+				{
+					while (!ready())
+						std::this_thread::yield();
+					return !QueuedMessage.empty();
+				}
+			}
+			return QueuedMessage.wait_nonempty([this]() {
+				return QueueStop.load();
+				});
+		}
+
+		/**
+			\brief Runs queue_exec_process then wakes threads waiting for the 
+			queue to drain.
+		*/
+		void queue_thread_main() noexcept
+		{
+			if (threadConfig)
+				applyThreadConfig(*threadConfig);
+			queue_exec_process();
+			isProcExited = true;
+			notify_drained();
+		}
+
+		/**
+			\brief Wakes all threads waiting for the queue to drain.
+		*/
+		inline void notify_drained() noexcept
+		{
+			{ std::lock_guard<std::mutex> lock(mtxDrained); }
+			cvDrained.notify_all();
+			if constexpr (policy::is_shared)
+				QueuedMessage.wake_drained();
+		}
+
+		/**
+			\brief Marks count messages as processed, wakes the waiting 
+			threads if that drained the queue.
+
+			Waiters register in drainWaiters before checking pending, so the
+			common case with no waiters costs no lock.
+		*/
+		inline void finish_messages(
+			std::size_t count /**< : <i>in</i> : Messages processed.*/
+		) noexcept
+		{
+			if constexpr (policy::is_shared)
+				QueuedMessage.finish(count);
+			else if (pending.fetch_sub(count) == count && drainWaiters.load() != 0)
+				notify_drained();
+		}
+
+		/**
+			\brief Counts a message about to be posted.
+		*/
+		inline void note_posted() noexcept
+		{
+			if constexpr (policy::is_shared)
+				QueuedMessage.note_posted();
+			else
+				++pending;
+		}
+
+		/**
+			\brief The number of messages posted and not processed, by every 
+			process for a shared policy.
+		*/
+		inline std::size_t pending_count() const noexcept
+		{
+			if constexpr (policy::is_shared)
+				return QueuedMessage.unfinished();
+			else
+				return pending.load(std::memory_order_relaxed);
+		}
+
+		/**
+			\brief Marks count messages as processed successfully, commits 
+			them first for a durable policy so they are not replayed.
+		*/
+		inline void complete_messages(
+			std::size_t count /**< : <i>in</i> : Messages processed.*/
+		) noexcept
+		{
+			if constexpr (policy::is_durable)
+			{
+				queue_lock lock(*this);
+				QueuedMessage.commit();
+			}
+			finish_messages(count);
+		}
+
+		/**
+			\brief Records a message taken by the processing thread.
+		*/
+		inline void note_dequeued(
+			time_pt posted /**< : <i>in</i> : Time message was posted.*/,
+			time_pt now /**< : <i>in</i> : Time processing starts.*/
+		) noexcept
+		{
+			stats.dequeued.fetch_add(1, std::memory_order_relaxed);
+			stats.waitTime.record(static_cast<std::uint64_t>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					now - posted).count()));
+			std::size_t depth = pending_count();
+			if (depth > stats.highWater.load(std::memory_order_relaxed))
+				stats.highWater.store(depth, std::memory_order_relaxed);
+		}
+
+		/**
+			\brief Records the time processing took and if it failed.
+		*/
+		inline void note_processed(
+			time_pt start /**< : <i>in</i> : Time processing started.*/,
+			tristate ret /**< : <i>in</i> : The result.*/
+		) noexcept
+		{
+			stats.procTime.record(static_cast<std::uint64_t>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					high_res::now() - start).count()));
+			if (ret != tristate::GOOD)
+				stats.failures.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/**
+			\brief Calls the processing function with a message.
+		*/
+		inline tristate process_one(
+			stored_type& msg /**< : <i>in</i> : The message.*/
+		)
+		{
+			if constexpr (has_stats)
+			{
+				LIB_TRACE_BEGIN("process");
+				LIB_TRACE_FLOW_END("message", msg.flow);
+				time_pt start = high_res::now();
+				note_dequeued(msg.posted, start);
+				tristate ret = msgProc(std::move(msg.value));
+				note_processed(start, ret);
+				LIB_TRACE_END("process");
+				return ret;
+			}
+			else
+				return msgProc(std::move(msg));
+		}
+
+		/**
+			\brief Calls the batch processing function with batch.
+		*/
+		inline tristate process_batch()
+		{
+			if constexpr (has_stats)
+			{
+				LIB_TRACE_BEGIN("process batch");
+				time_pt start = high_res::now();
+				batchValues.clear();
+				for (auto& msg : batch)
+				{
+					LIB_TRACE_FLOW_END("message", msg.flow);
+					note_dequeued(msg.posted, start);
+					batchValues.push_back(std::move(msg.value));
+				}
+				tristate ret = batchProc(batchValues.data(), batchValues.size());
+				note_processed(start, ret);
+				batchValues.clear();
+				LIB_TRACE_END("process batch");
+				return ret;
+			}
+			else
+				return batchProc(batch.data(), batch.size());
+		}
+
+		/**
+			\brief Constructs a message in the storage, stamped if statistics 
+			are collected.
+
+			<h3>Return</h3>
+			false if storage is full.\n
+		*/
+		template<class... Args>
+		inline bool store(
+			Args&&... args /**< : <i>in</i> : The constructor arguments.*/
+		)
+		{
+			if constexpr (has_stats)
+			{
+				std::uint64_t flow = LIB_TRACE_FLOW_ID;
+				LIB_TRACE_BEGIN("post");
+				LIB_TRACE_FLOW_START("message", flow);
+				bool stored = QueuedMessage.try_emplace(stamp_now_t{ flow }, 
+					std::forward<Args>(args)...);
+				LIB_TRACE_END("post");
+				if (!stored)
+					return false;
+				stats.enqueued.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+			else
+				return QueuedMessage.try_emplace(std::forward<Args>(args)...);
+		}
+
+		/**
+			\brief Constructs a scheduled message in the storage, stamped if 
+			statistics are collected.
+		*/
+		template<class... Args>
+		inline void store_at(
+			time_pt due /**< : <i>in</i> : The due time.*/,
+			int priority /**< : <i>in</i> : The priority.*/,
+			Args&&... args /**< : <i>in</i> : The constructor arguments.*/
+		)
+		{
+			if constexpr (has_stats)
+			{
+				QueuedMessage.try_emplace_at(due, priority, stamp_now_t{},
+					std::forward<Args>(args)...);
+				stats.enqueued.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+				QueuedMessage.try_emplace_at(due, priority,
+					std::forward<Args>(args)...);
+		}
+
+		/**
+			\brief Processes pending messages in batches of batchLimit until 
+			queue is empty or stop is signalled, only one batch if lingering.
+
+			Stop is only checked between batches.
+
+			<h3>Return</h3>
+			false if processing function returned error.\n
+		*/
+		bool drain_batches() noexcept
+		{
+			bool stopNow = QueueStop.load();
+			while (!stopNow)
+			{
+				O3_LIB_LOG_LINE;
+				batch.clear();
+				if (pop_bulk(batch, batchLimit.load()) == 0)
+					break;
+				if (!process_drained())
+					return false;
+				complete_messages(batch.size());
+				// lingers again before the next batch, the flag keeps the 
+				// messages left from waiting for a post.
+				if (lingerCount.load() != 0)
+				{
+					if (!queue_empty())
+						isUpdated = true;
+					break;
+				}
+				stopNow = QueueStop.load();
+			}
+			batch.clear();
+			return true;
+		}
+
+		/**
+			\brief Processes the messages drained to batch, with batchProc if
+			set.
+
+			<h3>Return</h3>
+			false if processing function returned error.\n
+		*/
+		inline bool process_drained()
+		{
+			if (batchProc)
+				return process_batch() == tristate::GOOD;
+			// a batch already drained is always finished, so that 
+			// safe_join does not lose it.
+			for (auto& msg : batch)
+				if (!process_one(msg))
+					return false;
+			return true;
+		}
+
+		/**
+			\brief Processes upto quantum messages on the executor, in batches
+			of batchLimit if set.
+
+			<h3>Return</h3>
+			false if processing function returned error.\n
+		*/
+		bool drain_quantum(
+			bool& more /**< : <i>out</i> : true if quantum ran out first.*/
+		) noexcept
+		{
+			std::size_t done = 0;
+			std::optional<stored_type> front;
+			more = false;
+			while (done < quantum && !QueueStop.load())
+			{
+				if (batchProc || batchLimit.load() != 1)
+				{
+					std::size_t limit = batchLimit.load();
+					if (limit == 0 || limit > quantum - done)
+						limit = quantum - done;
+					batch.clear();
+					if (pop_bulk(batch, limit) == 0)
+						return true;
+					if (!process_drained())
+						return false;
+					complete_messages(batch.size());
+					done += batch.size();
+					batch.clear();
+				}
+				else
+				{
+					if (!pop(front))
+						return true;
+					tristate ret = process_one(*front);
+					front.reset();
+					if (!ret)
+						return false;
+					complete_messages(1);
+					++done;
+				}
+			}
+			more = done == quantum;
+			return true;
+		}
+
+		/**
+			\brief Submits a drain task to the executor unless one is
+			submitted already.
+		*/
+		inline void schedule_drain() noexcept
+		{
+			if (onExecutor.load(std::memory_order_acquire) 
+				&& !drainScheduled.exchange(true))
+				submit_drain();
+		}
+
+		/**
+			\brief Submits a drain task, drainScheduled is set.
+		*/
+		inline void submit_drain() noexcept
+		{
+			++activeTasks;
+			executor([this]() { drain_task(); });
+		}
+
+		/**
+			\brief The task run on the executor, processes a quantum then 
+			resubmits itself if messages are left, so queues sharing the
+			executor take turns.
+		*/
+		void drain_task() noexcept
+		{
+			bool more = false;
+			bool good = drain_quantum(more);
+			if (!good)
+			{
+				// cleared first, a restart must be able to submit again.
+				drainScheduled = false;
+				isProcExited = true;
+				notify_drained();
+			}
+			else if (more)
+				// yields the thread, drainScheduled stays set.
+				submit_drain();
+			else
+			{
+				drainScheduled = false;
+				// a message posted after the queue was seen empty may have
+				// found drainScheduled set and not submitted.
+				if (!QueueStop.load() && !queue_empty()
+					&& !drainScheduled.exchange(true))
+					submit_drain();
+			}
+			// pairs with WaitForQueueStop, nothing is touched after this 
+			// task is counted out.
+			std::lock_guard<std::mutex> lock(mtxDrained);
+			if (--activeTasks == 0)
+				cvDrained.notify_all();
+		}
+
+		/**
+			\brief Pops upto max messages under a single lock (if storage is 
+			not lock-free).
+		*/
+		inline std::size_t pop_bulk(
+			std::vector<stored_type>& out /**< : <i>out</i> : The messages.*/,
+			std::size_t max /**< : <i>in</i> : Maximum to pop, 0 for all.*/
+		)
+		{
+			if constexpr (policy::is_lock_free)
+				return QueuedMessage.try_pop_bulk(out, max);
+			else
+			{
+				queue_lock lock(*this);
+				return QueuedMessage.try_pop_bulk(out, max);
+			}
+		}
+
+		/**
+			\brief Checks if a processing function is set.
+
+			Handler types that cannot be tested (like lambdas) are always set.
+		*/
+		inline bool hasProc() const noexcept
+		{
+			if constexpr (std::is_constructible_v<bool, const processing_method&>)
+				return static_cast<bool>(msgProc);
+			else
+				return true;
+		}
+
+		/**
+			\brief Pops the oldest message, locks mtxQueue if storage is not 
+			lock-free.
+		*/
+		inline bool pop(
+			std::optional<stored_type>& out /**< : <i>out</i> : The message.*/
+		)
+		{
+			if constexpr (policy::is_lock_free)
+				return QueuedMessage.try_pop(out);
+			else
+			{
+				queue_lock lock(*this);
+				return QueuedMessage.try_pop(out);
+			}
+		}
+
+		/**
+			\brief Checks if queue is empty, locks mtxQueue if storage is 
+			not lock-free.
+		*/
+		inline bool queue_empty() noexcept
+		{
+			if constexpr (policy::is_lock_free)
+				return QueuedMessage.empty();
+			else
+			{
+				queue_lock lock(*this);
+				return QueuedMessage.empty();
+			}
+		}
+
+		/**
+			\brief Flags the queue as updated and wakes the processing thread 
+			after a lock-free push.
+
+			Only the push that raises isUpdated has to notify, the
+			processing thread has not consumed the flag for the rest. If the
+			processing thread is not blocked it sees the flag without a 
+			notify.
+		*/
+		inline void signal_update() noexcept
+		{
+			if constexpr (policy::is_shared)
+			{
+				// the processing thread may be in another process.
+				QueuedMessage.notify();
+				return;
+			}
+			bool first = !isUpdated.exchange(true);
+			if ((first || isLingering.load()) && isSleeping.load() 
+				&& should_wake())
+			{
+				// pairs with the predicate check under mtxQueue so the 
+				// processing thread cannot miss this notification.
+				{ std::lock_guard<std::mutex> lock(mtxQueue); }
+				cvQueue.notify_one();
+			}
+		}
+
+	public:
+
+		
+
+		/**
+			\brief The default constructor.
+		*/
+		queued_process() noexcept : batchLimit(1), pending(0), 
+			drainWaiters(0), isProcExited(false), queue_thread()
+		{
+			isUpdated = false;
+			isSleeping = false;
+			waitMode = wait_strategy::park;
+			spinLimit = 4096;
+			QueueStop = false;
+			isQueueActive = false;
+		}
+
+		/**
+			\brief Registers the processing method while constructing.
+		*/
+		explicit queued_process(
+			processing_method msg /**< : <i>in</i> : The procedure.*/
+		) noexcept : msgProc(std::move(msg)), batchLimit(1), pending(0),
+			drainWaiters(0), isProcExited(false), queue_thread()
+		{
+			isUpdated = false;
+			isSleeping = false;
+			waitMode = wait_strategy::park;
+			spinLimit = 4096;
+			QueueStop = false;
+			isQueueActive = false;
+		}
+
+		/**
+			\brief Registers the processing method and gives the allocator of
+			the queue storage while constructing, for allocated_queue (or the 
+			wal_config of durable_queue).
+		*/
+		template<class Alloc, std::enable_if_t<
+			std::is_constructible_v<storage_type, const Alloc&>, int> = 0>
+		queued_process(
+			processing_method msg /**< : <i>in</i> : The procedure.*/,
+			const Alloc& alloc /**< : <i>in</i> : The allocator of the queue.*/
+		) : QueuedMessage(alloc), msgProc(std::move(msg)), batchLimit(1), pending(0),
+			drainWaiters(0), isProcExited(false), queue_thread()
+		{
+			isUpdated = false;
+			isSleeping = false;
+			waitMode = wait_strategy::park;
+			spinLimit = 4096;
+			QueueStop = false;
+			isQueueActive = false;
+			// messages replayed from a durable log are pending from the start.
+			if constexpr (policy::is_durable)
+			{
+				pending = QueuedMessage.size();
+				isUpdated = pending.load() != 0;
+			}
+		}
+
+		queued_process(const queued_process&) = delete;
+
+		queued_process(queued_process&&) = delete;
+
+		queued_process& operator = (queued_process&&) = delete;
+
+		queued_process& operator = (const queued_process&) = delete;
+
+		/**
+			\brief The Function to set a function as the instruction processor.
+		*/
+		inline void RegisterProc(
+			processing_method in /**< : <i>in</i> : The procedure.*/
+		) noexcept
+		{
+			msgProc = std::move(in);
+		}
+
+		/**
+			\brief The Function to set a function as the batch processor.
+
+			If set, it is called with every batch drained instead of calling 
+			the instruction processor for each message.
+		*/
+		inline void RegisterBatchProc(
+			batch_method in /**< : <i>in</i> : The procedure.*/
+		) noexcept
+		{
+			batchProc = in;
+		}
+
+		/**
+			\brief Sets the maximum number of messages taken from the queue at 
+			once.
+
+			1 (default) takes one message at a time, 0 takes all pending 
+			messages.
+		*/
+		inline void setBatchLimit(
+			std::size_t limit /**< : <i>in</i> : The maximum batch size.*/
+		) noexcept
+		{
+			batchLimit = limit;
+		}
+
+		/**
+			\brief Makes the processing thread linger till count messages are
+			pending or time passed since it saw the first, then drain them
+			together (in batches of setBatchLimit), trading bounded latency for
+			fewer, larger batches.
+
+			Producers do not wake the lingering thread before count messages
+			are pending. Not used by scheduled or shared policies or on an 
+			executor.
+		*/
+		inline void setLinger(
+			std::size_t count /**< : <i>in</i> : Messages to linger for, 0 
+							  to not linger.*/,
+			std::chrono::nanoseconds time /**< : <i>in</i> : Longest linger.*/
+		) noexcept
+		{
+			lingerTime = time;
+			lingerCount = count;
+		}
+
+		/**
+			\brief Sets how the processing thread waits for messages.
+
+			Spinning gives lower latency at the cost of keeping a core busy 
+			while the queue is idle.
+		*/
+		inline void setWaitStrategy(
+			wait_strategy mode /**< : <i>in</i> : The wait strategy.*/,
+			std::size_t spins = 4096 /**< : <i>in</i> : Number of spins 
+									 before yielding or blocking.*/
+		) noexcept
+		{
+			spinLimit = spins;
+			waitMode = mode;
+		}
+
+		/**
+			\brief starts the function queue_process in another thread.
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if no procedure was set, or queue is
+			already running or if thread allocation failed.\n
+			Returns tristate::PREV_ERROR if error was flagged in any previous
+			function calls.\n
+		*/
+		tristate start_queue_process() noexcept
+		{
+			O3_LIB_LOG_LINE;
+			if (!hasProc() && !batchProc)
+				return tristate::ERROR;
+			if (isQueueRunning())
+				return tristate::ERROR;
+			O2_LIB_LOG_LINE;
+			QueueStop = false;
+			isProcExited = false;
+			queue_thread = std::thread(
+				&queued_process::queue_thread_main, this);
+			isQueueActive = true;
+			O2_LIB_LOG_LINE;
+			return (tristate::GOOD);
+		}
+
+		/**
+			\brief Starts the processing thread, which applies config first.
+
+			The configuration is kept for later starts without one.
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if no procedure was set, or queue is
+			running.\n
+		*/
+		tristate start_queue_process(
+			thread_config config /**< : <i>in</i> : The placement, scheduling 
+								 and name of the thread.*/
+		) noexcept
+		{
+			if (isQueueRunning())
+				return tristate::ERROR;
+			threadConfig = std::move(config);
+			return start_queue_process();
+		}
+
+		/**
+			\brief Starts processing as tasks on exec instead of a thread.
+
+			A drain task is submitted when messages arrive, it processes upto
+			slice messages and submits itself again if more are left, so
+			queues sharing a few threads take turns. At most one task of the
+			queue is submitted at a time. exec must run every task it is given
+			(till WaitForQueueStop returns) and the queue must outlive them, 
+			which the destructor ensures.
+
+			Not for scheduled or shared policies, their messages arrive 
+			without a post in this process.
+
+			<h3>Return</h3>
+			Returns tristate::ERROR if no procedure or executor was set, or 
+			queue is running.\n
+		*/
+		tristate start_queue_process(
+			executor_method exec /**< : <i>in</i> : Runs a task, like on a 
+								 thread pool.*/,
+			std::size_t slice = 64 /**< : <i>in</i> : Most messages per 
+								   task, 0 is taken as 1.*/
+		) noexcept
+		{
+			static_assert(!policy::is_scheduled && !policy::is_shared,
+				"an executor needs a policy whose messages are all posted by "
+				"this process");
+			if ((!hasProc() && !batchProc) || !exec)
+				return tristate::ERROR;
+			if (isQueueRunning())
+				return tristate::ERROR;
+			executor = std::move(exec);
+			quantum = slice ? slice : 1;
+			QueueStop = false;
+			isProcExited = false;
+			drainScheduled = false;
+			isQueueActive = true;
+			onExecutor.store(true, std::memory_order_release);
+			// messages posted before the start, or replayed by a durable 
+			// policy.
+			if (!queue_empty())
+				schedule_drain();
+			return (tristate::GOOD);
+		}
+
+		/**
+			\brief check if queue is updated.
+
+			<h3>Return</h3>
+			Returns isUpdated.\n
+
+		*/
+		inline bool isQueueUpdated() noexcept
+		{
+			return isUpdated.load();
+		}
+
+		/**
+			\brief Constructs a message from the arguments in the storage of 
+			the queue.
+
+			If the queue policy is bounded, waits till there is space in the 
+			queue.
+		*/
+		template<class... Args>
+		inline void emplaceMessage(
+			Args&&... args /**< : <i>in</i> : Arguments to construct message
+						   with.*/
+		)
+		{
+			if constexpr (policy::is_lock_free
+				&& !std::is_nothrow_constructible_v<info_type, Args&&...>)
+			{
+				// a lock-free slot is claimed before the message is built
+				// in it, a throwing constructor must run first.
+				info_type built(std::forward<Args>(args)...);
+				emplaceMessage(std::move(built));
+				return;
+			}
+			// counted before the message is visible, so the processing 
+			// thread can never take pending below zero.
+			note_posted();
+			if constexpr (policy::is_lock_free)
+			{
+				// a failed try_emplace does not consume the arguments.
+				while (!store(std::forward<Args>(args)...))
+					std::this_thread::yield();
+				signal_update();
+				schedule_drain();
+			}
+			else
+			{
+				bool replaced = false;
+				bool wake;
+				{
+					queue_lock lock(*this);
+					store(std::forward<Args>(args)...);
+					if constexpr (policy::is_coalescing)
+						replaced = QueuedMessage.coalesced();
+					isUpdated = true;
+					wake = should_wake();
+				}
+				// a message that replaced a pending one is not pending itself.
+				if (replaced)
+					finish_messages(1);
+				if (wake && isSleeping.load())
+					cvQueue.notify_one();
+				schedule_drain();
+				// the processing thread may start on it while it is flushed,
+				// postMessage returns once it is durable.
+				if constexpr (policy::is_durable)
+					QueuedMessage.sync();
+			}
+		}
 
 		/**
-			\brief loops and executes tasks pushed into message queue until
-			EXIT_QUEUE is pushed into the queue.
+			\brief Constructs a message from the arguments in the storage of
+			the queue if there is space.
 
+			For a lock-free policy and a message constructor that may throw,
+			arguments passed as rvalues are moved from even if the queue is 
+			full.
 
 			<h3>Return</h3>
-			Returns tristate::ERROR if any msg_switch fails.\n
-			Returns tristate::PREV_ERROR if error was flagged in any previous
-			function calls.\n
-
+			Returns false if the queue is full (only possible for a bounded
+			policy), message is not posted.\n
 		*/
-		tristate queue_exec_process() noexcept
+		template<class... Args>
+		inline bool try_emplaceMessage(
+			Args&&... args /**< : <i>in</i> : Arguments to construct message
+						   with.*/
+		)
 		{
-			O1_LIB_LOG_LINE;
-			if (!msgProc)
-				return tristate::ERROR;
-			O1_LIB_LOG_LINE;
-			while (!(QueueStop.load()))
+			if constexpr (policy::is_lock_free
+				&& !std::is_nothrow_constructible_v<info_type, Args&&...>)
 			{
-				O3_LIB_LOG_LINE;
-				while (!(isUpdated.load()))
-				{
-					std::unique_lock<std::mutex> lock(mtxQueue);
-					cvQueue.wait(lock);
-					bool empty = QueuedMessage.empty();
-					lock.unlock();
-					if (!(isUpdated.load()) && QueueStop.load() && empty)
-						return (tristate::GOOD);
-
-				}
-				isUpdated = false;
-				bool stopNow = false;
+				// as in emplaceMessage, the arguments are taken even if full.
+				info_type built(std::forward<Args>(args)...);
+				return try_emplaceMessage(std::move(built));
+			}
+			note_posted();
+			if constexpr (policy::is_lock_free)
+			{
+				if (!store(std::forward<Args>(args)...))
 				{
-					std::lock_guard<std::mutex> lock(mtxQueue);
-					stopNow = QueuedMessage.empty() || QueueStop.load();
+					finish_messages(1);
+					return false;
 				}
-				while (!stopNow)
+				signal_update();
+				schedule_drain();
+			}
+			else
+			{
+				bool replaced = false;
+				bool wake;
 				{
-					O3_LIB_LOG_LINE;
-					mtxQueue.lock();
-					info_type front = QueuedMessage.front();
-					QueuedMessage.pop();
-					mtxQueue.unlock();
-					tristate ret = msgProc(front);
-					if (!ret)
-						return (tristate::ERROR);
-					std::lock_guard<std::mutex> temp_lock(mtxQueue);
-					stopNow = QueuedMessage.empty() || QueueStop.load();
+					queue_lock lock(*this);
+					if (!store(std::forward<Args>(args)...))
+					{
+						finish_messages(1);
+						return false;
+					}
+					if constexpr (policy::is_coalescing)
+						replaced = QueuedMessage.coalesced();
+					isUpdated = true;
+					wake = should_wake();
 				}
-
+				if (replaced)
+					finish_messages(1);
+				if (wake && isSleeping.load())
+					cvQueue.notify_one();
+				schedule_drain();
+				if constexpr (policy::is_durable)
+					QueuedMessage.sync();
 			}
-			O4_LIB_LOG_LINE;
-			return (tristate::GOOD);
+			return true;
 		}
 
-	public:
+		/**
+			\brief The function post a copy of message onto the queue.
 
-		
+			If the queue policy is bounded, waits till there is space in the 
+			queue.
+		*/
+		inline void postMessage(
+			const info_type& Message /**< : <i>in</i> : Message need to be 
+									 pushed.*/
+		)
+		{
+			emplaceMessage(Message);
+		}
 
 		/**
-			\brief The default constructor.
+			\brief The function moves a message onto the queue.
+
+			If the queue policy is bounded, waits till there is space in the
+			queue.
 		*/
-		queued_process() noexcept : queue_thread()
+		inline void postMessage(
+			info_type&& Message /**< : <i>in</i> : Message need to be pushed.*/
+		)
 		{
-			isUpdated = false;
-			QueueStop = false;
-			isQueueActive = false;
+			emplaceMessage(std::move(Message));
 		}
 
 		/**
-			\brief Registers the processing method while constructing.
+			\brief The function post a copy of message onto the queue if there
+			is space.
+
+			<h3>Return</h3>
+			Returns false if the queue is full (only possible for a bounded 
+			policy), message is not posted.\n
 		*/
-		explicit queued_process(
-			processing_method msg /**< : <i>in</i> : The procedure.*/
-		) noexcept : queue_thread()
+		inline bool try_postMessage(
+			const info_type& Message /**< : <i>in</i> : Message need to be
+									 pushed.*/
+		)
 		{
-			isUpdated = false;
-			QueueStop = false;
-			isQueueActive = false;
-			msgProc = msg;
+			return try_emplaceMessage(Message);
 		}
 
-		queued_process(const queued_process&) = delete;
+		/**
+			\brief The function moves a message onto the queue if there is 
+			space.
 
-		queued_process(queued_process&&) = delete;
+			<h3>Return</h3>
+			Returns false if the queue is full (only possible for a bounded
+			policy), Message is left untouched and not posted.\n
+		*/
+		inline bool try_postMessage(
+			info_type&& Message /**< : <i>in</i> : Message need to be pushed.*/
+		)
+		{
+			return try_emplaceMessage(std::move(Message));
+		}
 
-		queued_process& operator = (queued_process&&) = delete;
+		/**
+			\brief Constructs a message from the arguments that is processed 
+			at or after the time due, before lower priority messages that 
+			are due.
 
-		queued_process& operator = (const queued_process&) = delete;
+			Only for a scheduled policy (priority_schedule).
+		*/
+		template<class... Args>
+		inline void emplaceMessageAt(
+			time_pt due /**< : <i>in</i> : The earliest time to process it,
+						time_pt::min() for now.*/,
+			int priority /**< : <i>in</i> : The priority, higher first.*/,
+			Args&&... args /**< : <i>in</i> : Arguments to construct message
+						   with.*/
+		)
+		{
+			static_assert(policy::is_scheduled, 
+				"emplaceMessageAt needs a scheduled queue policy");
+			note_posted();
+			{
+				queue_lock lock(*this);
+				store_at(due, priority, std::forward<Args>(args)...);
+				isUpdated = true;
+			}
+			if (isSleeping.load())
+				cvQueue.notify_one();
+		}
 
 		/**
-			\brief The Function to set a function as the instruction processor.
+			\brief The function post a message that is processed before due
+			messages of lower priority.
+
+			Only for a scheduled policy (priority_schedule).
 		*/
-		inline void RegisterProc(
-			processing_method in /**< : <i>in</i> : The procedure.*/
-		) noexcept
+		inline void postPriorityMessage(
+			int priority /**< : <i>in</i> : The priority, higher first, 
+						 postMessage uses 0.*/,
+			info_type Message /**< : <i>in</i> : Message need to be pushed.*/
+		)
 		{
-			msgProc = in;
+			emplaceMessageAt(time_pt::min(), priority, std::move(Message));
 		}
 
 		/**
-			\brief starts the function queue_process in another thread.
+			\brief The function post a message that is processed at or after
+			the time due.
 
-			<h3>Return</h3>
-			Returns tristate::ERROR if no procedure was set, or queue is
-			already running or if thread allocation failed.\n
-			Returns tristate::PREV_ERROR if error was flagged in any previous
-			function calls.\n
+			Only for a scheduled policy (priority_schedule).
 		*/
-		tristate start_queue_process() noexcept
+		inline void postMessageAt(
+			time_pt due /**< : <i>in</i> : The earliest time to process it.*/,
+			info_type Message /**< : <i>in</i> : Message need to be pushed.*/,
+			int priority = 0 /**< : <i>in</i> : The priority once due.*/
+		)
 		{
-			O3_LIB_LOG_LINE;
-			if (!msgProc)
-				return tristate::ERROR;
-			if (isQueueRunning())
-				return tristate::ERROR;
-			O2_LIB_LOG_LINE;
-			QueueStop = false;
-			queue_thread = std::thread(
-				&queued_process::queue_exec_process, this);
-			isQueueActive = true;
-			O2_LIB_LOG_LINE;
-			return (tristate::GOOD);
+			emplaceMessageAt(due, priority, std::move(Message));
 		}
 
 		/**
-			\brief check if queue is updated.
-
-			<h3>Return</h3>
-			Returns isUpdated.\n
+			\brief The function post a message that is processed after the 
+			delay.
 
+			Only for a scheduled policy (priority_schedule).
 		*/
-		inline bool isQueueUpdated() noexcept
+		template<class Rep, class Period>
+		inline void postMessageAfter(
+			std::chrono::duration<Rep, Period> delay /**< : <i>in</i> : The
+													 delay.*/,
+			info_type Message /**< : <i>in</i> : Message need to be pushed.*/,
+			int priority = 0 /**< : <i>in</i> : The priority once due.*/
+		)
 		{
-			return isUpdated.load();
+			emplaceMessageAt(high_res::now() + 
+				std::chrono::duration_cast<high_res::duration>(delay), 
+				priority, std::move(Message));
 		}
 
 		/**
-			\brief The function post a message onto the queue.
+			\brief Copies the statistics, only for a with_stats policy.
+
+			Safe to call from any thread while the queue runs, counters are
+			read one by one so they may be off by the messages in flight.
 		*/
-		inline void postMessage(
-			info_type Message /**< : <i>in</i> : Message need to be pushed.*/
-		)
+		queue_stats_snapshot getStats() const
 		{
-			{
-				std::lock_guard<std::mutex> lock(mtxQueue);
-				QueuedMessage.push(Message);
-				isUpdated = true;
-			}
-			cvQueue.notify_all();
-			return;
+			static_assert(has_stats, "getStats needs a with_stats policy");
+			queue_stats_snapshot ret;
+			ret.enqueued = stats.enqueued.load(std::memory_order_relaxed);
+			ret.dequeued = stats.dequeued.load(std::memory_order_relaxed);
+			ret.failures = stats.failures.load(std::memory_order_relaxed);
+			ret.depth = pending_count();
+			ret.high_water = stats.highWater.load(std::memory_order_relaxed);
+			ret.wait_ns = stats.waitTime.snapshot();
+			ret.process_ns = stats.procTime.snapshot();
+			ret.lock_hold_ns = stats.lockHold.snapshot();
+			return ret;
 		}
 
+		/**
+			\brief Clears the statistics, only for a with_stats policy.
+		*/
+		void resetStats() noexcept
+		{
+			static_assert(has_stats, "resetStats needs a with_stats policy");
+			stats.enqueued.store(0, std::memory_order_relaxed);
+			stats.dequeued.store(0, std::memory_order_relaxed);
+			stats.failures.store(0, std::memory_order_relaxed);
+			stats.highWater.store(0, std::memory_order_relaxed);
+			stats.waitTime.reset();
+			stats.procTime.reset();
+			stats.lockHold.reset();
+		}
 
 		/**
 			\brief The function to signal the queue to stop processing after
@@ -340,7 +2594,12 @@ namespace enh
 		inline void stopQueue() noexcept
 		{
 			QueueStop = true;
+			{ std::lock_guard<std::mutex> lock(mtxQueue); }
 			cvQueue.notify_all();
+			if constexpr (policy::is_shared)
+				QueuedMessage.wake_consumer();
+			if (onExecutor.load())
+				notify_drained();
 		}
 
 
@@ -353,6 +2612,17 @@ namespace enh
 		*/
 		inline bool isQueueRunning() noexcept { return isQueueActive.load(); };
 
+		/**
+			\brief Checks if the processing thread has exited, because it was
+			stopped or the processing function failed, and was not yet 
+			joined.
+
+		  <h3>Return</h3>
+		  true if processing thread exited.\n
+
+		*/
+		inline bool isQueueExited() noexcept { return isProcExited.load(); }
+
 		/**
 			\brief Waits till Queued process stops execution. Then empties queue.
 		*/
@@ -361,12 +2631,33 @@ namespace enh
 			if (queue_thread.joinable() || isQueueRunning() )
 			{
 				O3_LIB_LOG_LINE;
-				queue_thread.join();
+				if (onExecutor.load())
+				{
+					// waits for the drain tasks instead of a thread.
+					std::unique_lock<std::mutex> lock(mtxDrained);
+					cvDrained.wait(lock, [this]() {
+						return activeTasks.load() == 0 
+							&& (QueueStop.load() || isProcExited.load());
+						});
+					onExecutor = false;
+				}
+				else
+					queue_thread.join();
 				O4_LIB_LOG_LINE;
 				isQueueActive = false;
 				QueueStop = false;
-				std::lock_guard<std::mutex> lock(mtxQueue);
-				QueuedMessage = std::queue<instruct>();
+				std::size_t left = 0;
+				{
+					std::lock_guard<std::mutex> lock(mtxQueue);
+					QueuedMessage.clear();
+					// a durable log keeps them for the next start.
+					if constexpr (policy::is_durable)
+						left = QueuedMessage.size();
+				}
+				isProcExited = false;
+				pending = left;
+				isUpdated = left != 0;
+				notify_drained();
 			}
 
 		}
@@ -375,8 +2666,8 @@ namespace enh
 			\brief Waits till Queue is Empty then stops process and joins.
 		*/
 		inline void safe_join(
-			std::chrono::nanoseconds ns /**< : <i>in</i> : The amount of time
-							to wait between each cecks to the queues size.*/
+			std::chrono::nanoseconds ns /**< : <i>in</i> : Unused, kept for
+							compatibility, see WaitForQueueEmpty.*/
 		)
 		{
 			if (!isQueueRunning())
@@ -386,11 +2677,36 @@ namespace enh
 			WaitForQueueStop();
 		}
 
+		/**
+			\brief Waits till Queue is Empty or deadline is reached then stops 
+			process and joins.
+
+			<b>Note</b> : If the deadline is reached, messages left over are
+			destroyed as in force_join.
+
+			<h3>Return</h3>
+			true if all messages were processed before stopping.\n
+		*/
+		template<class Clock, class Duration>
+		inline bool safe_join(
+			const std::chrono::time_point<Clock, Duration>& deadline /**< : 
+							<i>in</i> : The time to stop waiting at.*/
+		)
+		{
+			if (!isQueueRunning())
+				return queue_empty();
+			bool drained = WaitForQueueEmpty(deadline);
+			stopQueue();
+			WaitForQueueStop();
+			return drained;
+		}
+
 		/**
 			\brief Posts stop queue message then waits for thread to join.
 
 			<b>Note</b> : Even if queue has messages left over, it will exit 
-			and messages will be destroyed.
+			and messages will be destroyed (kept for the next start by 
+			durable_queue).
 		*/
 		inline void force_join()
 		{
@@ -401,27 +2717,66 @@ namespace enh
 		}
 
 		/**
-			\brief The function to wait till instruction queue is empty.
+			\brief The function to wait till every message posted is 
+			processed, or the processing thread exits.
+
+			The processing thread signals when the last pending message 
+			finishes, there is no polling.
 		*/
 		inline void WaitForQueueEmpty(
-			std::chrono::nanoseconds ns /**< : <i>in</i> : The amount of time
-							to wait between each cecks to the queues size.*/
+			std::chrono::nanoseconds /**< : <i>in</i> : Unused, kept for 
+							compatibility with the earlier polling wait.*/
 		) noexcept
 		{
-			while (true)
+			O3_LIB_LOG_LINE;
+			if constexpr (policy::is_shared)
 			{
-				O3_LIB_LOG_LINE;
-				std::this_thread::sleep_for(ns);
-				bool ret = false;
-				{
-					std::lock_guard<std::mutex> lock(mtxQueue);
-					ret = QueuedMessage.empty();
-				}
-				if (ret)
-					return;
-				O3_LIB_LOG_LINE;
+				QueuedMessage.wait_drained([this]() {
+					return isProcExited.load();
+					}, std::chrono::steady_clock::time_point::max());
+				return;
+			}
+			++drainWaiters;
+			{
+				std::unique_lock<std::mutex> lock(mtxDrained);
+				cvDrained.wait(lock, [this]() {
+					return pending.load() == 0 || isProcExited.load();
+					});
+			}
+			--drainWaiters;
+			O3_LIB_LOG_LINE;
+		}
+
+		/**
+			\brief The function to wait till every message posted is
+			processed, the processing thread exits or the deadline is reached.
+
+			<h3>Return</h3>
+			true if all messages posted were processed.\n
+		*/
+		template<class Clock, class Duration>
+		inline bool WaitForQueueEmpty(
+			const std::chrono::time_point<Clock, Duration>& deadline /**< :
+							<i>in</i> : The time to stop waiting at.*/
+		)
+		{
+			O3_LIB_LOG_LINE;
+			if constexpr (policy::is_shared)
+				return QueuedMessage.wait_drained([this]() {
+					return isProcExited.load();
+					}, std::chrono::steady_clock::now() 
+					+ std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+						deadline - Clock::now()));
+			++drainWaiters;
+			{
+				std::unique_lock<std::mutex> lock(mtxDrained);
+				cvDrained.wait_until(lock, deadline, [this]() {
+					return pending.load() == 0 || isProcExited.load();
+					});
 			}
-			return;
+			--drainWaiters;
+			O3_LIB_LOG_LINE;
+			return pending.load() == 0;
 		}
 
 		/**
@@ -433,6 +2788,226 @@ namespace enh
 		}
 	};
 
+#ifdef ENH_HAS_COROUTINES
+	/**
+		\brief Counts the coroutines started by coroutine_method that have 
+		not finished, and their failures.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class coroutine_tasks
+	{
+		std::mutex lock;
+		std::condition_variable idle;
+		std::size_t running = 0;
+		std::atomic<unsigned long long> failed{ 0 };
+
+	public:
+
+		coroutine_tasks() = default;
+
+		coroutine_tasks(const coroutine_tasks&) = delete;
+
+		coroutine_tasks& operator = (const coroutine_tasks&) = delete;
+
+		/**
+			\brief Notes a coroutine started.
+		*/
+		inline void begin() noexcept
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			++running;
+		}
+
+		/**
+			\brief Notes a coroutine finished with result.
+		*/
+		inline void finish(
+			tristate result /**< : <i>in</i> : The result of the coroutine.*/
+		) noexcept
+		{
+			if (result != tristate::GOOD)
+				failed.fetch_add(1, std::memory_order_relaxed);
+			std::lock_guard<std::mutex> guard(lock);
+			if (--running == 0)
+				idle.notify_all();
+		}
+
+		/**
+			\brief The coroutines started and not finished.
+		*/
+		inline std::size_t pending() noexcept
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			return running;
+		}
+
+		/**
+			\brief The coroutines that finished with a result other than 
+			tristate::GOOD or with an exception.
+		*/
+		inline unsigned long long failures() const noexcept
+		{
+			return failed.load(std::memory_order_relaxed);
+		}
+
+		/**
+			\brief Blocks till no coroutine is pending or till deadline.
+
+			Call after the queue is joined so no more are started.
+
+			<h3>Return</h3>
+			true if none is pending.\n
+		*/
+		inline bool wait_idle(
+			time_pt deadline = time_pt::max() /**< : <i>in</i> : The latest
+											  time to wait till.*/
+		)
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			auto done = [this]() { return running == 0; };
+			if (deadline == time_pt::max())
+				idle.wait(guard, done);
+			else
+				idle.wait_until(guard, deadline, done);
+			return running == 0;
+		}
+	};
+
+	/**
+		\brief The return type of a coroutine processing function, see 
+		coroutine_method.
+
+		The coroutine runs on the processing thread till it first suspends,
+		then the next message is processed while it waits (for example on 
+		`co_await tm.next_tick()`). It frees itself when it finishes, its 
+		`co_return` value is counted by coroutine_tasks.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class process_task
+	{
+	public:
+
+		/**
+			\brief The promise of the coroutine.
+		*/
+		struct promise_type
+		{
+			coroutine_tasks* tasks = nullptr;
+			tristate result = tristate::GOOD;
+
+			process_task get_return_object() noexcept
+			{
+				return process_task(std::coroutine_handle<promise_type>::from_promise(*this));
+			}
+
+			std::suspend_always initial_suspend() noexcept { return {}; }
+
+			std::suspend_never final_suspend() noexcept
+			{
+				if (tasks)
+					tasks->finish(result);
+				return {};
+			}
+
+			void return_value(tristate ret) noexcept { result = ret; }
+
+			void unhandled_exception() noexcept { result = tristate::ERROR; }
+		};
+
+		process_task(process_task&& other) noexcept : handle(other.handle)
+		{
+			other.handle = nullptr;
+		}
+
+		process_task(const process_task&) = delete;
+
+		process_task& operator = (const process_task&) = delete;
+
+		/**
+			\brief Destroys the coroutine if it was never started.
+		*/
+		~process_task()
+		{
+			if (handle)
+				handle.destroy();
+		}
+
+		/**
+			\brief Runs the coroutine till it first suspends or finishes,
+			counted in tasks.
+		*/
+		inline void start(
+			coroutine_tasks& tasks /**< : <i>in</i> : The count of running 
+								   coroutines.*/
+		)
+		{
+			std::coroutine_handle<promise_type> run = handle;
+			handle = nullptr;
+			run.promise().tasks = &tasks;
+			tasks.begin();
+			run.resume();
+		}
+
+	private:
+
+		explicit process_task(std::coroutine_handle<promise_type> h) noexcept
+			: handle(h)
+		{}
+
+		std::coroutine_handle<promise_type> handle;
+	};
+
+	/**
+		\brief Makes a processing method for a queued_process of info from a
+		coroutine fn returning process_task, so each message is processed 
+		by a coroutine that does not hold the processing thread while 
+		suspended.
+
+		fn must take the message by value, it is kept in the coroutine 
+		frame. The method returns tristate::GOOD once the coroutine 
+		suspends, failures are counted in tasks. The queue being empty (or 
+		joined) does not mean the coroutines finished, call 
+		tasks.wait_idle for that.
+
+		<h3>Return</h3>
+		The processing method, tasks must outlive all the coroutines.\n
+	*/
+	template<class info, class function>
+	inline std::function<tristate(info)> coroutine_method(
+		function fn /**< : <i>in</i> : The coroutine function.*/,
+		coroutine_tasks& tasks /**< : <i>in</i> : The count of running 
+							   coroutines.*/
+	)
+	{
+		return [fn = std::move(fn), &tasks](info msg) -> tristate {
+			process_task task = fn(std::move(msg));
+			task.start(tasks);
+			return tristate::GOOD;
+		};
+	}
+#endif
+
+	/**
+		\brief Makes a handler for enh::callback_timer that posts a copy of 
+		message to target at each expiry.
+
+		Posting uses try_postMessage so a full bounded queue drops the 
+		message rather than hold up the timer service.
+
+		<h3>Return</h3>
+		The handler, target must outlive the timer.\n
+	*/
+	template<class process, class message>
+	inline std::function<void()> post_handler(
+		process& target /**< : <i>in</i> : The queued_process.*/,
+		message msg /**< : <i>in</i> : The message to post.*/
+	)
+	{
+		return [&target, msg]() { target.try_postMessage(msg); };
+	}
+
 }
 
 #endif
@@ -0,0 +1,251 @@
+/** ***************************************************************************
+	\file rate_limiter.enh.h
+
+	\brief The file to declare class rate_limiter
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef RATE_LIMITER_ENH_H
+
+#define RATE_LIMITER_ENH_H					rate_limiter.enh.h
+
+#include "timer.enh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <thread>
+
+namespace enh
+{
+
+	/**
+		\brief The class to implement a token bucket rate limiter.
+
+		The bucket holds up to burst tokens and refills at rate tokens a
+		second. There is no refill thread, the state is one atomic "time
+		the bucket is full again" (the generic cell rate algorithm), moved
+		forward by each acquire against high_res::now(), so try_acquire is
+		one clock read and a compare exchange.\n\n
+
+		Blocking acquire reserves its tokens first and then sleeps till they
+		are due, so blocked threads are served in order of arrival without
+		a lock.\n\n
+
+		The cost of a token is kept in whole nanoseconds, so rates above
+		1e9 a second are not supported and other rates are rounded to the
+		nearest nanosecond per token. Times past the last time_pt of 
+		high_res saturate there, tokens that would only be refilled after it
+		are never given.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class rate_limiter
+	{
+		/**
+			\brief The nanoseconds one token takes to refill.
+		*/
+		std::int64_t tokenNs;
+
+		/**
+			\brief The nanoseconds to refill the whole bucket.
+		*/
+		std::int64_t burstNs;
+
+		/**
+			\brief The reference of the time stamps.
+		*/
+		time_pt origin;
+
+		/**
+			\brief The nanoseconds from origin to time_pt::max(), no time
+			stamp is later.
+		*/
+		std::int64_t horizon;
+
+		/**
+			\brief The time (nanoseconds from origin) at which the bucket is
+			full again, at or before now if it is full.
+		*/
+		std::atomic<std::int64_t> fullAt;
+
+		inline std::int64_t ns_of(time_pt pt) const noexcept
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(
+				pt - origin).count();
+		}
+
+		/**
+			\brief Takes n tokens if they are available at or before the
+			limit ns.
+
+			<h3>Return</h3>
+			The time the tokens are available, -1 if later than limit (then
+			nothing is taken).\n
+		*/
+		inline std::int64_t reserve(
+			std::uint64_t n /**< : <i>in</i> : The tokens.*/,
+			std::int64_t now /**< : <i>in</i> : The time now.*/,
+			std::int64_t limit /**< : <i>in</i> : The latest acceptable.*/
+		) noexcept
+		{
+			// more than the bucket holds never fits, and the cost below
+			// cannot overflow.
+			if (n > burst())
+				return -1;
+			std::int64_t cost = static_cast<std::int64_t>(n) * tokenNs;
+			std::int64_t full = fullAt.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				std::int64_t start = std::max(full, now);
+				// a bucket saturated at the horizon is never refilled.
+				if (start >= horizon && cost > 0)
+					return -1;
+				std::int64_t next = (cost > horizon - start) ? horizon : start + cost;
+				std::int64_t due = next - burstNs;
+				if (due > limit)
+					return -1;
+				if (fullAt.compare_exchange_weak(full, next,
+					std::memory_order_acq_rel, std::memory_order_relaxed))
+					return std::max(due, now);
+			}
+		}
+
+	public:
+
+		/**
+			\brief Constructs a full bucket.
+		*/
+		inline rate_limiter(
+			double rate /**< : <i>in</i> : The tokens added a second,
+						above 0.*/,
+			std::uint64_t burst /**< : <i>in</i> : The size of the bucket,
+								at least 1.*/
+		) noexcept : origin(high_res::now()), fullAt(0)
+		{
+			horizon = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				time_pt::max() - origin).count();
+			// a token slower than the clock can count is never refilled.
+			double ns = (rate > 0.0) ? 1e9 / rate + 0.5 : 1e18;
+			tokenNs = (ns >= static_cast<double>(horizon)) ? horizon
+				: std::max<std::int64_t>(1, static_cast<std::int64_t>(ns));
+			std::uint64_t tokens = std::max<std::uint64_t>(burst, 1);
+			std::uint64_t most = static_cast<std::uint64_t>(
+				std::numeric_limits<std::int64_t>::max() / tokenNs);
+			burstNs = tokenNs * static_cast<std::int64_t>(std::min(tokens, most));
+		}
+
+		rate_limiter(const rate_limiter&) = delete;
+
+		rate_limiter& operator = (const rate_limiter&) = delete;
+
+		/**
+			\brief Takes n tokens if available now, lock-free.
+
+			<h3>Return</h3>
+			true if taken.\n
+		*/
+		inline bool try_acquire(
+			std::uint64_t n = 1 /**< : <i>in</i> : The tokens.*/
+		) noexcept
+		{
+			std::int64_t now = ns_of(high_res::now());
+			return reserve(n, now, now) >= 0;
+		}
+
+		/**
+			\brief Takes n tokens, blocking till they are available, unless
+			that is later than deadline.
+
+			<h3>Return</h3>
+			false (without blocking or taking tokens) if the tokens would
+			not be available by deadline, or n is above the size of the
+			bucket.\n
+		*/
+		inline bool acquire(
+			std::uint64_t n /**< : <i>in</i> : The tokens.*/,
+			time_pt deadline = time_pt::max() /**< : <i>in</i> : The latest
+											  time to get them.*/
+		) noexcept
+		{
+			std::int64_t now = ns_of(high_res::now());
+			std::int64_t limit = (deadline == time_pt::max()) ? INT64_MAX
+				: ns_of(deadline);
+			std::int64_t due = reserve(n, now, limit);
+			if (due < 0)
+				return false;
+			if (due > now)
+				std::this_thread::sleep_until(origin + std::chrono::nanoseconds(due));
+			return true;
+		}
+
+		/**
+			\brief Takes n tokens, blocking at most timeout, see acquire.
+		*/
+		template<class Rep, class Period>
+		inline bool acquire_for(
+			std::uint64_t n /**< : <i>in</i> : The tokens.*/,
+			std::chrono::duration<Rep, Period> timeout /**< : <i>in</i> : The
+													   longest wait.*/
+		) noexcept
+		{
+			time_pt now = high_res::now();
+			if (timeout <= timeout.zero())
+				return acquire(n, now);
+			// compared in double so that neither side overflows, a timeout
+			// past the end of the clock waits without limit.
+			std::chrono::duration<double, std::nano> wait = timeout;
+			if (wait.count() >= static_cast<double>(std::chrono::duration_cast<
+				std::chrono::nanoseconds>(time_pt::max() - now).count()))
+				return acquire(n, time_pt::max());
+			return acquire(n, now + std::chrono::duration_cast<high_res::duration>(timeout));
+		}
+
+		/**
+			\brief The tokens in the bucket now, negative if blocked
+			acquires have reserved tokens not yet refilled.
+		*/
+		inline double available() const noexcept
+		{
+			std::int64_t now = ns_of(high_res::now());
+			std::int64_t full = fullAt.load(std::memory_order_relaxed);
+			return static_cast<double>(burstNs - std::max<std::int64_t>(full - now, 0))
+				/ tokenNs;
+		}
+
+		/**
+			\brief The tokens added a second.
+		*/
+		inline double rate() const noexcept { return 1e9 / tokenNs; }
+
+		/**
+			\brief The size of the bucket.
+		*/
+		inline std::uint64_t burst() const noexcept
+		{
+			return static_cast<std::uint64_t>(burstNs / tokenNs);
+		}
+	};
+}
+
+#endif
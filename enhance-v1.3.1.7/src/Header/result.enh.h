@@ -0,0 +1,299 @@
+/** ***************************************************************************
+	\file result.enh.h
+
+	\brief The file to declare class result, a value or an error code
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef RESULT_ENH_H
+
+#define RESULT_ENH_H					result.enh.h
+
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace enh
+{
+
+	/**
+		\brief The error codes of the non-throwing functions of the library,
+		the same values as error_base.
+	*/
+	namespace result_code
+	{
+		/**
+			\brief <i>0x00</i> : No error.
+		*/
+		constexpr unsigned SAFE = 0x00;
+
+		/**
+			\brief <i>0x01</i> : Unknown Error.
+		*/
+		constexpr unsigned UNKNOWN = 0x01;
+
+		/**
+			\brief <i>0x02</i> : Invalid argument.
+		*/
+		constexpr unsigned INVALID_ARG = 0x02;
+	}
+
+	/**
+		\brief The error code of a failed result, made by enh::fail.
+	*/
+	template<class E>
+	struct failure
+	{
+		E code;
+	};
+
+	/**
+		\brief Makes a failed result of code, which converts to any result
+		with error type E.
+	*/
+	template<class E>
+	constexpr inline failure<E> fail(
+		E code /**< : <i>in</i> : The error code, not 0.*/
+	) noexcept
+	{
+		return failure<E>{ code };
+	}
+
+	namespace detail
+	{
+		/**
+			\brief The storage of result for trivially copyable T, itself
+			trivially copyable.
+		*/
+		template<class T, class E, bool trivial = std::is_trivially_copyable_v<T>
+			&& std::is_trivially_destructible_v<T>>
+		struct result_storage
+		{
+			union
+			{
+				char none;
+				T val;
+			};
+			E code;
+
+			constexpr inline result_storage(E c) noexcept : none(0), code(c) {}
+
+			template<class... Args>
+			constexpr inline result_storage(std::in_place_t, Args&&... args)
+				: val(std::forward<Args>(args)...), code(0) {}
+		};
+
+		/**
+			\brief The storage of result for other T.
+		*/
+		template<class T, class E>
+		struct result_storage<T, E, false>
+		{
+			union
+			{
+				char none;
+				T val;
+			};
+			E code;
+
+			inline result_storage(E c) noexcept : none(0), code(c) {}
+
+			template<class... Args>
+			inline result_storage(std::in_place_t, Args&&... args)
+				: val(std::forward<Args>(args)...), code(0) {}
+
+			inline result_storage(const result_storage& r) : none(0), code(r.code)
+			{
+				if (code == 0)
+					::new (static_cast<void*>(&val)) T(r.val);
+			}
+
+			inline result_storage(result_storage&& r)
+				noexcept(std::is_nothrow_move_constructible_v<T>) : none(0), code(r.code)
+			{
+				if (code == 0)
+					::new (static_cast<void*>(&val)) T(std::move(r.val));
+			}
+
+			inline result_storage& operator = (const result_storage& r)
+			{
+				if (this != &r)
+				{
+					this->~result_storage();
+					::new (static_cast<void*>(this)) result_storage(r);
+				}
+				return *this;
+			}
+
+			inline result_storage& operator = (result_storage&& r)
+				noexcept(std::is_nothrow_move_constructible_v<T>)
+			{
+				if (this != &r)
+				{
+					this->~result_storage();
+					::new (static_cast<void*>(this)) result_storage(std::move(r));
+				}
+				return *this;
+			}
+
+			inline ~result_storage()
+			{
+				if (code == 0)
+					val.~T();
+			}
+		};
+	}
+
+	/**
+		\brief The class for the outcome of a function, a value or an error
+		code (0 is success, the codes are those of error_base), without
+		exceptions.
+
+		Trivially copyable when T is, so it is returned in registers for
+		small T. Marked [[nodiscard]].\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>template</h3>
+		-#  <code>T</code> : The value type, void for none.\n
+		-#  <code>E</code> : The integral error code type.\n
+	*/
+	template<class T, class E = unsigned>
+	class [[nodiscard]] result
+	{
+		static_assert(std::is_integral_v<E>, "result should have integral error type");
+
+		detail::result_storage<T, E> store;
+
+	public:
+
+		using value_type = T;
+		using error_type = E;
+
+		/**
+			\brief A success holding v.
+		*/
+		constexpr inline result(
+			const T& v /**< : <i>in</i> : The value.*/
+		) : store(std::in_place, v) {}
+
+		/**
+			\brief A success holding v.
+		*/
+		constexpr inline result(
+			T&& v /**< : <i>in</i> : The value.*/
+		) : store(std::in_place, std::move(v)) {}
+
+		/**
+			\brief A failure of f.code (UNKNOWN if 0).
+		*/
+		template<class F>
+		constexpr inline result(
+			failure<F> f /**< : <i>in</i> : The failure.*/
+		) noexcept : store(static_cast<E>(f.code ? f.code : result_code::UNKNOWN)) {}
+
+		/**
+			\brief Checks if it holds a value.
+		*/
+		constexpr inline bool ok() const noexcept { return store.code == 0; }
+
+		constexpr inline explicit operator bool() const noexcept { return ok(); }
+
+		/**
+			\brief The error code, 0 if it holds a value.
+		*/
+		constexpr inline E error() const noexcept { return store.code; }
+
+		/**
+			\brief The value, which must be held (not checked).
+		*/
+		constexpr inline const T& value() const& noexcept { return store.val; }
+
+		constexpr inline T& value() & noexcept { return store.val; }
+
+		constexpr inline T&& value() && noexcept { return std::move(store.val); }
+
+		constexpr inline const T& operator * () const& noexcept { return store.val; }
+
+		constexpr inline T& operator * () & noexcept { return store.val; }
+
+		constexpr inline const T* operator -> () const noexcept { return &store.val; }
+
+		constexpr inline T* operator -> () noexcept { return &store.val; }
+
+		/**
+			\brief The value, or other if it failed.
+		*/
+		template<class U>
+		constexpr inline T value_or(
+			U&& other /**< : <i>in</i> : The value on failure.*/
+		) const&
+		{
+			return ok() ? store.val : static_cast<T>(std::forward<U>(other));
+		}
+	};
+
+	/**
+		\brief The class for the outcome of a function with no value, a
+		success or an error code.
+
+		hasErrorHandlers        = false;\n
+	*/
+	template<class E>
+	class [[nodiscard]] result<void, E>
+	{
+		static_assert(std::is_integral_v<E>, "result should have integral error type");
+
+		E code = 0;
+
+	public:
+
+		using value_type = void;
+		using error_type = E;
+
+		/**
+			\brief A success.
+		*/
+		constexpr inline result() noexcept = default;
+
+		/**
+			\brief A failure of f.code (UNKNOWN if 0).
+		*/
+		template<class F>
+		constexpr inline result(
+			failure<F> f /**< : <i>in</i> : The failure.*/
+		) noexcept : code(static_cast<E>(f.code ? f.code : result_code::UNKNOWN)) {}
+
+		/**
+			\brief Checks if it succeeded.
+		*/
+		constexpr inline bool ok() const noexcept { return code == 0; }
+
+		constexpr inline explicit operator bool() const noexcept { return ok(); }
+
+		/**
+			\brief The error code, 0 on success.
+		*/
+		constexpr inline E error() const noexcept { return code; }
+	};
+}
+
+#endif
@@ -0,0 +1,340 @@
+/** ***************************************************************************
+	\file ring_buffer.enh.h
+
+	\brief The file to declare class mpsc_ring
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+
+******************************************************************************/
+
+#ifndef RING_BUFFER_ENH_H
+
+#define RING_BUFFER_ENH_H						ring_buffer.enh.h
+
+#include "general.enh.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace enh
+{
+
+	/**
+		\brief The class to implement a bounded lock-free queue with multiple
+		producers and a single consumer.
+
+		Every slot of the ring carries a sequence number that tells producers
+		and the consumer whether the slot is free or filled for the current
+		lap, so pushing is a single compare exchange on the write index and
+		popping needs no read-modify-write at all.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>Template arguments</h3>
+		-#  <code>class T</code> : The type to store, must be nothrow move
+		constructible.\n
+		-#  <code>std::size_t capacity</code> : The number of slots, must be a
+		power of 2.\n
+
+		<b>Note</b> : Only one thread may call the consumer functions
+		(try_pop, clear) at a time.
+	*/
+	template<class T, std::size_t capacity>
+	class mpsc_ring
+	{
+		static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0,
+			"mpsc_ring capacity must be a power of 2");
+		static_assert(std::is_nothrow_move_constructible_v<T>,
+			"a value is moved into a claimed slot, which must not throw");
+
+	public:
+
+		/**
+			\brief The type of object stored.
+		*/
+		using value_type = T;
+
+	private:
+
+		/**
+			\brief A single slot in the ring.
+		*/
+		struct cell
+		{
+			/**
+				\brief The lap marker of the slot.
+
+				equal to position : slot is free for the producer at position.\n
+				equal to position + 1 : slot holds the value at position.\n
+			*/
+			std::atomic<std::size_t> sequence;
+
+			/**
+				\brief Raw storage for the value.
+			*/
+			alignas(T) unsigned char storage[sizeof(T)];
+
+			/**
+				\brief The value held in storage.
+			*/
+			inline T* get() noexcept
+			{
+				return std::launder(reinterpret_cast<T*>(storage));
+			}
+		};
+
+		/**
+			\brief mask to convert position to index.
+		*/
+		static constexpr std::size_t mask = capacity - 1;
+
+		/**
+			\brief The slots, allocated once on construction.
+		*/
+		std::unique_ptr<cell[]> buffer;
+
+		/**
+			\brief The next position to be claimed by a producer.
+		*/
+		alignas(cache_line_size) std::atomic<std::size_t> write_pos;
+
+		/**
+			\brief The next position to be read by the consumer.
+		*/
+		alignas(cache_line_size) std::atomic<std::size_t> read_pos;
+
+		/**
+			\brief Claims a slot and constructs the value in place.
+
+			A claimed slot must be published, the consumer waits on it, so
+			only constructors that cannot throw run here.
+		*/
+		template<class... Args>
+		bool claim_and_construct(Args&&... args) noexcept
+		{
+			static_assert(std::is_nothrow_constructible_v<T, Args&&...>,
+				"construct the value before claiming a slot");
+			std::size_t pos = write_pos.load(std::memory_order_relaxed);
+			cell* slot;
+			while (true)
+			{
+				slot = &buffer[pos & mask];
+				std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<std::ptrdiff_t>(seq)
+					- static_cast<std::ptrdiff_t>(pos);
+				if (diff == 0)
+				{
+					if (write_pos.compare_exchange_weak(pos, pos + 1,
+						std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false; // full
+				else
+					pos = write_pos.load(std::memory_order_relaxed);
+			}
+			::new (static_cast<void*>(slot->storage))
+				T(std::forward<Args>(args)...);
+			slot->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+	public:
+
+		/**
+			\brief The constructor, allocates all the slots.
+		*/
+		mpsc_ring() : buffer(new cell[capacity]), write_pos(0), read_pos(0)
+		{
+			for (std::size_t i = 0; i < capacity; ++i)
+				buffer[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		mpsc_ring(const mpsc_ring&) = delete;
+
+		mpsc_ring(mpsc_ring&&) = delete;
+
+		mpsc_ring& operator = (const mpsc_ring&) = delete;
+
+		mpsc_ring& operator = (mpsc_ring&&) = delete;
+
+		/**
+			\brief The destructor, destroys values not popped.
+		*/
+		~mpsc_ring()
+		{
+			clear();
+		}
+
+		/**
+			\brief The number of slots in the ring.
+		*/
+		static constexpr std::size_t max_size() noexcept { return capacity; }
+
+		/**
+			\brief Pushes a copy of the value.
+
+			<h3>Return</h3>
+			Returns false if the ring is full.\n
+		*/
+		inline bool try_push(
+			const T& val /**< : <i>in</i> : The value to push.*/
+		)
+		{
+			if constexpr (std::is_nothrow_copy_constructible_v<T>)
+				return claim_and_construct(val);
+			else
+			{
+				// a throwing copy leaves the ring untouched.
+				T copy(val);
+				return claim_and_construct(std::move(copy));
+			}
+		}
+
+		/**
+			\brief Pushes the value by moving it.
+
+			<h3>Return</h3>
+			Returns false if the ring is full, val is left untouched.\n
+		*/
+		inline bool try_push(
+			T&& val /**< : <i>in</i> : The value to push.*/
+		)
+		{
+			return claim_and_construct(std::move(val));
+		}
+
+		/**
+			\brief Constructs a value from the arguments in the next free slot.
+
+			If that constructor may throw, the value is constructed before a
+			slot is claimed and moved in, so arguments passed as rvalues are
+			moved from even if the ring is full.
+
+			<h3>Return</h3>
+			Returns false if the ring is full.\n
+		*/
+		template<class... Args>
+		inline bool try_emplace(
+			Args&&... args /**< : <i>in</i> : The constructor arguments.*/
+		)
+		{
+			if constexpr (std::is_nothrow_constructible_v<T, Args&&...>)
+				return claim_and_construct(std::forward<Args>(args)...);
+			else
+			{
+				T val(std::forward<Args>(args)...);
+				return claim_and_construct(std::move(val));
+			}
+		}
+
+		/**
+			\brief Pops the oldest value (consumer only).
+
+			<h3>Return</h3>
+			Returns false if the ring is empty.\n
+		*/
+		bool try_pop(
+			std::optional<T>& out /**< : <i>out</i> : Holds the value popped.*/
+		)
+		{
+			std::size_t pos = read_pos.load(std::memory_order_relaxed);
+			cell& slot = buffer[pos & mask];
+			std::size_t seq = slot.sequence.load(std::memory_order_acquire);
+			if (seq != pos + 1)
+				return false;
+			out.emplace(std::move(*slot.get()));
+			slot.get()->~T();
+			read_pos.store(pos + 1, std::memory_order_release);
+			slot.sequence.store(pos + capacity, std::memory_order_release);
+			return true;
+		}
+
+		/**
+			\brief Pops upto max oldest values (all available if max is 0), 
+			appending them to out (consumer only).
+
+			<h3>Return</h3>
+			The number of values popped.\n
+		*/
+		std::size_t try_pop_bulk(
+			std::vector<T>& out /**< : <i>out</i> : Holds the values popped.*/,
+			std::size_t max /**< : <i>in</i> : The maximum values to pop.*/
+		)
+		{
+			std::size_t count = 0;
+			std::size_t pos = read_pos.load(std::memory_order_relaxed);
+			while (max == 0 || count < max)
+			{
+				cell& slot = buffer[pos & mask];
+				if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+					break;
+				out.push_back(std::move(*slot.get()));
+				slot.get()->~T();
+				++pos;
+				read_pos.store(pos, std::memory_order_release);
+				slot.sequence.store(pos - 1 + capacity, 
+					std::memory_order_release);
+				++count;
+			}
+			return count;
+		}
+
+		/**
+			\brief Checks if the ring holds no values.
+
+			A slot claimed by a producer counts as filled even before the 
+			value is published.
+		*/
+		inline bool empty() const noexcept
+		{
+			return read_pos.load(std::memory_order_acquire)
+				== write_pos.load(std::memory_order_acquire);
+		}
+
+		/**
+			\brief The approximate number of values in the ring.
+		*/
+		inline std::size_t size() const noexcept
+		{
+			std::size_t w = write_pos.load(std::memory_order_relaxed);
+			std::size_t r = read_pos.load(std::memory_order_relaxed);
+			return (w > r) ? (w - r) : 0;
+		}
+
+		/**
+			\brief Destroys all values in the ring (consumer only).
+		*/
+		void clear()
+		{
+			std::optional<T> temp;
+			while (try_pop(temp))
+				temp.reset();
+		}
+	};
+}
+
+#endif
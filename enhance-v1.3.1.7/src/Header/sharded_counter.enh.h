@@ -0,0 +1,235 @@
+/** ***************************************************************************
+	\file sharded_counter.enh.h
+
+	\brief The file to declare class sharded_counter
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef SHARDED_COUNTER_ENH_H
+
+#define SHARDED_COUNTER_ENH_H			sharded_counter.enh.h
+
+#include "counter.enh.h"
+#include "general.enh.h"
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <string>
+
+namespace enh
+{
+
+	/**
+		\brief The class for counter functionality with the state split over
+		per thread slots, for counters added to by many threads and read
+		rarely.
+
+		Each thread adds into a slot of its own cache line, so adds do not
+		contend. Reads add up all the slots, they cost shards loads and are
+		not a single snapshot while adds are going on (each add is seen
+		whole, either before or after).\n\n
+
+		The reads match those of enh::counter, use snapshot for the rest.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>template</h3>
+		-#  <code>std::size_t shards</code> : The number of slots, more than
+		the number of adding threads avoids sharing.\n
+	*/
+	template<std::size_t shards = 16>
+	class sharded_counter
+	{
+		static_assert(shards > 0, "shards must not be 0");
+
+		/**
+			\brief The slot of a thread, the total seconds it added.
+		*/
+		struct alignas(cache_line_size) slot
+		{
+			std::atomic<unsigned long long> total{ 0 };
+		};
+
+		/**
+			\brief The slots.
+		*/
+		slot slots[shards];
+
+		/**
+			\brief Adds sec seconds into the slot of the calling thread.
+		*/
+		inline void add_raw(unsigned long long sec) noexcept
+		{
+			slots[threadShard() % shards].total.fetch_add(sec,
+				std::memory_order_relaxed);
+		}
+
+	public:
+
+		/**
+			\brief The constructor of the class sets all to 0.
+		*/
+		inline sharded_counter() noexcept {}
+
+		sharded_counter(const sharded_counter&) = delete;
+
+		sharded_counter& operator = (const sharded_counter&) = delete;
+
+		/**
+			\brief Resets state to 0s 0m 0hr 0day.
+
+			Adds concurrent with reset may be kept or lost.\n\n
+		*/
+		inline void reset() noexcept
+		{
+			for (auto& s : slots)
+				s.total.store(0, std::memory_order_relaxed);
+		}
+
+		/**
+			\brief Functon adds sec seconds to the value of state.
+		*/
+		inline void add_seconds(
+			unsigned long long sec /**< : <i>in</i> : The seconds to be added.*/
+		) noexcept
+		{
+			add_raw(sec);
+		}
+
+		/**
+			\brief Functon adds min minutes to the value of state.
+		*/
+		inline void add_minutes(
+			unsigned long long min /**< : <i>in</i> : The minutes to be added.*/
+		) noexcept
+		{
+			add_raw(min * 60ULL);
+		}
+
+		/**
+			\brief Functon adds hr hours to the value of state.
+		*/
+		inline void add_hours(
+			unsigned long long hr /**< : <i>in</i> : The hours to be added.*/
+		) noexcept
+		{
+			add_raw(hr * 3600ULL);
+		}
+
+		/**
+			\brief Functon adds dy days to the value of state.
+		*/
+		inline void add_days(
+			unsigned long long dy /**< : <i>in</i> : The days to be added.*/
+		) noexcept
+		{
+			add_raw(dy * 86400ULL);
+		}
+
+		/**
+			\brief Functon adds inputs to the state, as one atomic addition.
+		*/
+		inline void add(
+			unsigned sec /**< : <i>in</i> : The seconds to be added.*/,
+			unsigned min /**< : <i>in</i> : The minutes to be added.*/,
+			unsigned hr /**< : <i>in</i> : The hours to be added.*/,
+			unsigned long long dy /**< : <i>in</i> : The days to be added.*/
+		) noexcept
+		{
+			add_raw(sec + min * 60ULL + hr * 3600ULL + dy * 86400ULL);
+		}
+
+		/**
+			\brief Returns the whole state in seconds, the sum of the slots.
+		*/
+		inline unsigned long long get_total_seconds() const noexcept
+		{
+			unsigned long long tot = 0;
+			for (auto& s : slots)
+				tot += s.total.load(std::memory_order_relaxed);
+			return tot;
+		}
+
+		/**
+			\brief Returns the state as an enh::counter.
+		*/
+		inline counter snapshot() const noexcept
+		{
+			counter c;
+			c.set_seconds(get_total_seconds());
+			return c;
+		}
+
+		/**
+			\brief Returns the seconds part of the state.
+		*/
+		inline unsigned get_seconds() const noexcept
+		{ return snapshot().get_seconds(); }
+
+		/**
+			\brief Returns the minutes part of the state.
+		*/
+		inline unsigned get_minutes() const noexcept
+		{ return snapshot().get_minutes(); }
+
+		/**
+			\brief Returns the hours part of the state.
+		*/
+		inline unsigned get_hours() const noexcept
+		{ return snapshot().get_hours(); }
+
+		/**
+			\brief Returns the days part of the state.
+		*/
+		inline unsigned long long get_days() const noexcept
+		{ return snapshot().get_days(); }
+
+		/**
+			\brief Returns the total hours, see counter::get_total_hours.
+		*/
+		inline unsigned long long get_total_hours() const noexcept
+		{ return snapshot().get_total_hours(); }
+
+		/**
+			\brief Returns the state in the format of counter::get_string.
+		*/
+		inline std::string get_string() const
+		{
+			return snapshot().get_string();
+		}
+	};
+
+	/**
+		\brief inserts string representation of a sharded_counter to ostream.
+	*/
+	template<std::size_t shards>
+	inline std::ostream& operator << (
+		std::ostream& out /**< : <i>in</i> : The output stream.*/,
+		const sharded_counter<shards>& c /**< : <i>in</i> : The object to be
+										 printed.*/
+		)
+	{
+		return out << c.get_string();
+	}
+}
+
+#endif
@@ -0,0 +1,673 @@
+/** ***************************************************************************
+	\file shared_queue.enh.h
+
+	\brief The file to declare shm_ring, a lock-free ring in POSIX shared
+	memory for queued_process across processes, and its policy shared_ring
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	<h3> How To Use</h3>
+
+	- In the consumer process construct the queue with its processing
+	function and the name of the region :
+	`queued_process<msg, shared_ring<1024>> q(proc, shm_config{ "/orders" });`
+	then call `start_queue_process`. Only one process may process.
+
+	- In each producer process construct it with no processing function,
+	`queued_process<msg, shared_ring<1024>> q(nullptr, shm_config{ "/orders" });`,
+	and post with `postMessage` as usual. `WaitForQueueEmpty` waits for the
+	consumer to process everything posted by any process.
+
+	- The message type must be trivially copyable, like a gen_instruct of
+	plain types. It is constructed in the region by the producer and copied
+	out once by the consumer, nothing is serialised.
+
+	- The region is created by whichever process comes first and outlives
+	all of them, set `unlinkOnClose` in the process that should remove it
+	or call `shm_ring::remove`. If the creator dies while setting it up,
+	the others fail to open it after `setupTimeout`, remove it then.
+
+	Wake-ups use futexes on Linux, other POSIX systems poll every
+	millisecond while the consumer is idle. A producer that dies between
+	claiming and filling a slot stalls the consumer at that slot. Not
+	available on Windows.
+
+******************************************************************************/
+
+#ifndef SHARED_QUEUE_ENH_H
+
+#define SHARED_QUEUE_ENH_H						shared_queue.enh.h
+
+#include "queued_process.enh.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <ctime>
+#endif
+
+namespace enh
+{
+
+	/**
+		\brief The configuration of a queue in shared memory.
+	*/
+	struct shm_config
+	{
+		/**
+			\brief The name of the region, like "/orders".
+		*/
+		std::string name;
+
+		/**
+			\brief true to remove the region when this process closes it.
+		*/
+		bool unlinkOnClose = false;
+
+		/**
+			\brief The longest wait for the process that created the region
+			to set it up, a region left half set up by a process that died
+			then fails to open.
+		*/
+		std::chrono::milliseconds setupTimeout = std::chrono::seconds(1);
+	};
+
+	/**
+		\brief The storage of queued_process for policy shared_ring, a bounded
+		lock-free multi-producer single-consumer ring in a POSIX shared
+		memory region, with the counters and wake-ups of the queue.
+
+		The slots work like mpsc_ring, with 64 bit positions so they never
+		wrap. Every process maps the same region, there are no pointers in
+		it.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>Template arguments</h3>
+		-#  <code>class T</code> : The message, must be trivially copyable.\n
+		-#  <code>std::size_t capacity</code> : The number of slots, must be a
+		power of 2.\n
+
+		<b>Note</b> : Only one thread of one process may call the consumer
+		functions (try_pop, clear).
+	*/
+	template<class T, std::size_t capacity>
+	class shm_ring
+	{
+		static_assert(std::is_trivially_copyable_v<T>,
+			"shm_ring messages are shared as bytes, they must be trivially copyable");
+		static_assert(capacity >= 2 && (capacity & (capacity - 1)) == 0,
+			"shm_ring capacity must be a power of 2");
+		static_assert(std::atomic<std::uint64_t>::is_always_lock_free
+			&& std::atomic<std::uint32_t>::is_always_lock_free,
+			"shm_ring needs address free atomics");
+		static_assert(alignof(T) <= cache_line_size, "shm_ring message alignment");
+		static_assert(std::is_nothrow_move_constructible_v<T>,
+			"a value is moved into a claimed slot, which must not throw");
+
+		/**
+			\brief The start of the region.
+		*/
+		struct header
+		{
+			std::uint64_t magic;
+			std::atomic<std::uint32_t> state;
+			std::uint32_t element;
+			std::uint64_t slots;
+
+			alignas(cache_line_size) std::atomic<std::uint64_t> write_pos;
+			alignas(cache_line_size) std::atomic<std::uint64_t> read_pos;
+
+			/**
+				\brief Futex bumped to wake the consumer, and if it sleeps.
+			*/
+			alignas(cache_line_size) std::atomic<std::uint32_t> wakeWord;
+			std::atomic<std::uint32_t> sleeping;
+
+			/**
+				\brief Messages posted and not processed, and the futex
+				bumped when it drains, with its number of waiters.
+			*/
+			alignas(cache_line_size) std::atomic<std::uint64_t> unfinished;
+			std::atomic<std::uint32_t> drainWord;
+			std::atomic<std::uint32_t> drainWaiters;
+		};
+
+		/**
+			\brief A single slot, sequence as in mpsc_ring.
+		*/
+		struct cell
+		{
+			std::atomic<std::uint64_t> sequence;
+			alignas(T) unsigned char storage[sizeof(T)];
+
+			inline T* get() noexcept
+			{
+				return std::launder(reinterpret_cast<T*>(storage));
+			}
+		};
+
+		static constexpr std::uint64_t layout_magic = 0x3130474E49524D53ULL; // "SMRING01"
+		static constexpr std::uint64_t mask = capacity - 1;
+		static constexpr std::size_t region_bytes = sizeof(header) + capacity * sizeof(cell);
+
+		header* head = nullptr;
+		cell* cells = nullptr;
+		shm_config config;
+
+		/**
+			\brief Waits while word is seen, at most timeout.
+		*/
+		static void wait_on(
+			std::atomic<std::uint32_t>& word /**< : <i>in</i> : The futex.*/,
+			std::uint32_t seen /**< : <i>in</i> : The value seen.*/,
+			std::chrono::nanoseconds timeout /**< : <i>in</i> : The longest
+											 wait, max for none.*/
+		) noexcept
+		{
+#if defined(__linux__)
+			// not FUTEX_PRIVATE_FLAG, the word is shared between processes.
+			if (timeout == std::chrono::nanoseconds::max())
+				syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+					FUTEX_WAIT, seen, nullptr, nullptr, 0);
+			else
+			{
+				timespec span;
+				span.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+				span.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+				syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+					FUTEX_WAIT, seen, &span, nullptr, 0);
+			}
+#else
+			if (word.load(std::memory_order_acquire) == seen)
+				std::this_thread::sleep_for(std::min<std::chrono::nanoseconds>(
+					timeout, std::chrono::milliseconds(1)));
+#endif
+		}
+
+		/**
+			\brief Bumps word and wakes upto count waiters of every process.
+		*/
+		static void wake(
+			std::atomic<std::uint32_t>& word /**< : <i>in</i> : The futex.*/,
+			int count /**< : <i>in</i> : The waiters to wake.*/
+		) noexcept
+		{
+			word.fetch_add(1, std::memory_order_acq_rel);
+#if defined(__linux__)
+			syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word),
+				FUTEX_WAKE, count, nullptr, nullptr, 0);
+#else
+			(void)count;
+#endif
+		}
+
+		/**
+			\brief Claims a slot and constructs the value in place.
+
+			A claimed slot must be published, the consumer of every process
+			waits on it, so only constructors that cannot throw run here.
+		*/
+		template<class... Args>
+		bool claim_and_construct(Args&&... args) noexcept
+		{
+			static_assert(std::is_nothrow_constructible_v<T, Args&&...>,
+				"construct the value before claiming a slot");
+			std::uint64_t pos = head->write_pos.load(std::memory_order_relaxed);
+			cell* slot;
+			while (true)
+			{
+				slot = &cells[pos & mask];
+				std::uint64_t seq = slot->sequence.load(std::memory_order_acquire);
+				auto diff = static_cast<std::int64_t>(seq - pos);
+				if (diff == 0)
+				{
+					if (head->write_pos.compare_exchange_weak(pos, pos + 1,
+						std::memory_order_relaxed))
+						break;
+				}
+				else if (diff < 0)
+					return false; // full
+				else
+					pos = head->write_pos.load(std::memory_order_relaxed);
+			}
+			::new (static_cast<void*>(slot->storage))
+				T(std::forward<Args>(args)...);
+			slot->sequence.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+	public:
+
+		/**
+			\brief Maps the region named in cfg, creating and setting it up if
+			no process has yet.
+
+			Throws std::runtime_error if the region could not be mapped, 
+			holds a ring of another type or capacity, or was not set up 
+			within setupTimeout.
+		*/
+		explicit shm_ring(
+			const shm_config& cfg /**< : <i>in</i> : The configuration.*/
+		) : config(cfg)
+		{
+			if (config.name.empty() || config.name.front() != '/')
+				config.name.insert(config.name.begin(), '/');
+			int fd = ::shm_open(config.name.c_str(), O_RDWR | O_CREAT, 0600);
+			if (fd < 0)
+				throw std::runtime_error("shared queue could not be opened : "
+					+ config.name);
+			struct stat info;
+			bool sized = ::fstat(fd, &info) == 0;
+			if (sized && static_cast<std::size_t>(info.st_size) < region_bytes)
+				sized = ::ftruncate(fd, static_cast<off_t>(region_bytes)) == 0;
+			void* at = sized ? ::mmap(nullptr, region_bytes, PROT_READ | PROT_WRITE,
+				MAP_SHARED, fd, 0) : MAP_FAILED;
+			::close(fd);
+			if (at == MAP_FAILED)
+				throw std::runtime_error("shared queue could not be mapped : "
+					+ config.name);
+			head = static_cast<header*>(at);
+			cells = reinterpret_cast<cell*>(static_cast<char*>(at) + sizeof(header));
+			// the region starts zero filled, the first process to move
+			// state from 0 sets it up while the rest wait.
+			std::uint32_t fresh = 0;
+			if (head->state.compare_exchange_strong(fresh, 1))
+			{
+				head->magic = layout_magic;
+				head->element = static_cast<std::uint32_t>(sizeof(T));
+				head->slots = capacity;
+				for (std::size_t i = 0; i < capacity; ++i)
+					::new (static_cast<void*>(&cells[i].sequence))
+						std::atomic<std::uint64_t>(i);
+				head->state.store(2, std::memory_order_release);
+			}
+			else
+			{
+				auto limit = std::chrono::steady_clock::now() + config.setupTimeout;
+				while (head->state.load(std::memory_order_acquire) != 2)
+				{
+					if (std::chrono::steady_clock::now() > limit)
+					{
+						::munmap(head, region_bytes);
+						head = nullptr;
+						throw std::runtime_error("shared queue was not set up in "
+							"time, its creator may have died : " + config.name);
+					}
+					std::this_thread::yield();
+				}
+			}
+			if (head->magic != layout_magic || head->element != sizeof(T)
+				|| head->slots != capacity)
+			{
+				::munmap(head, region_bytes);
+				head = nullptr;
+				throw std::runtime_error("shared queue holds another ring : "
+					+ config.name);
+			}
+		}
+
+		shm_ring(const shm_ring&) = delete;
+
+		shm_ring& operator = (const shm_ring&) = delete;
+
+		/**
+			\brief Unmaps the region, removing it if unlinkOnClose is set.
+			Values not popped stay in the region.
+		*/
+		~shm_ring()
+		{
+			if (head)
+				::munmap(head, region_bytes);
+			if (config.unlinkOnClose)
+				::shm_unlink(config.name.c_str());
+		}
+
+		/**
+			\brief Removes the region named name, processes that mapped it
+			keep their map.
+		*/
+		static bool remove(
+			std::string name /**< : <i>in</i> : The name of the region.*/
+		) noexcept
+		{
+			if (name.empty() || name.front() != '/')
+				name.insert(name.begin(), '/');
+			return ::shm_unlink(name.c_str()) == 0;
+		}
+
+		/**
+			\brief The number of slots in the ring.
+		*/
+		static constexpr std::size_t max_size() noexcept { return capacity; }
+
+		/**
+			\brief Pushes a copy of the value.
+
+			<h3>Return</h3>
+			Returns false if the ring is full.\n
+		*/
+		inline bool try_push(
+			const T& val /**< : <i>in</i> : The value to push.*/
+		)
+		{
+			return claim_and_construct(val);
+		}
+
+		/**
+			\brief Constructs a value from the arguments in the next free slot.
+
+			If that constructor may throw, the value is constructed before a
+			slot is claimed and moved in, so arguments passed as rvalues are
+			moved from even if the ring is full.
+
+			<h3>Return</h3>
+			Returns false if the ring is full.\n
+		*/
+		template<class... Args>
+		inline bool try_emplace(
+			Args&&... args /**< : <i>in</i> : The constructor arguments.*/
+		)
+		{
+			if constexpr (std::is_nothrow_constructible_v<T, Args&&...>)
+				return claim_and_construct(std::forward<Args>(args)...);
+			else
+			{
+				T val(std::forward<Args>(args)...);
+				return claim_and_construct(std::move(val));
+			}
+		}
+
+		/**
+			\brief Pops the oldest value (consumer only).
+
+			<h3>Return</h3>
+			Returns false if the ring is empty.\n
+		*/
+		bool try_pop(
+			std::optional<T>& out /**< : <i>out</i> : Holds the value popped.*/
+		)
+		{
+			std::uint64_t pos = head->read_pos.load(std::memory_order_relaxed);
+			cell& slot = cells[pos & mask];
+			if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+				return false;
+			out.emplace(*slot.get());
+			head->read_pos.store(pos + 1, std::memory_order_release);
+			slot.sequence.store(pos + capacity, std::memory_order_release);
+			return true;
+		}
+
+		/**
+			\brief Pops upto max oldest values (all available if max is 0),
+			appending them to out (consumer only).
+
+			<h3>Return</h3>
+			The number of values popped.\n
+		*/
+		std::size_t try_pop_bulk(
+			std::vector<T>& out /**< : <i>out</i> : Holds the values popped.*/,
+			std::size_t max /**< : <i>in</i> : The maximum values to pop.*/
+		)
+		{
+			std::size_t count = 0;
+			std::uint64_t pos = head->read_pos.load(std::memory_order_relaxed);
+			while (max == 0 || count < max)
+			{
+				cell& slot = cells[pos & mask];
+				if (slot.sequence.load(std::memory_order_acquire) != pos + 1)
+					break;
+				out.push_back(*slot.get());
+				++pos;
+				head->read_pos.store(pos, std::memory_order_release);
+				slot.sequence.store(pos - 1 + capacity, std::memory_order_release);
+				++count;
+			}
+			return count;
+		}
+
+		/**
+			\brief Checks if the ring holds no values, a claimed slot counts
+			as filled.
+		*/
+		inline bool empty() const noexcept
+		{
+			return head->read_pos.load(std::memory_order_acquire)
+				== head->write_pos.load(std::memory_order_acquire);
+		}
+
+		/**
+			\brief The approximate number of values in the ring.
+		*/
+		inline std::size_t size() const noexcept
+		{
+			std::uint64_t w = head->write_pos.load(std::memory_order_relaxed);
+			std::uint64_t r = head->read_pos.load(std::memory_order_relaxed);
+			return (w > r) ? static_cast<std::size_t>(w - r) : 0;
+		}
+
+		/**
+			\brief Drops all values in the ring, as processed (consumer only).
+		*/
+		void clear()
+		{
+			std::optional<T> temp;
+			std::size_t dropped = 0;
+			while (try_pop(temp))
+				++dropped;
+			if (dropped)
+				finish(dropped);
+		}
+
+		/**
+			\brief Counts a message about to be posted by any process.
+		*/
+		inline void note_posted() noexcept
+		{
+			head->unfinished.fetch_add(1);
+		}
+
+		/**
+			\brief Marks count messages as processed, wakes the processes
+			waiting for the queue to drain if that drained it.
+		*/
+		inline void finish(
+			std::size_t count /**< : <i>in</i> : Messages processed.*/
+		) noexcept
+		{
+			if (head->unfinished.fetch_sub(count) == count
+				&& head->drainWaiters.load() != 0)
+				wake(head->drainWord, INT32_MAX);
+		}
+
+		/**
+			\brief Messages posted and not processed, by all processes.
+		*/
+		inline std::size_t unfinished() const noexcept
+		{
+			return static_cast<std::size_t>(
+				head->unfinished.load(std::memory_order_relaxed));
+		}
+
+		/**
+			\brief Wakes the consumer if it sleeps, after a value is pushed.
+		*/
+		inline void notify() noexcept
+		{
+			// orders the push before reading sleeping, pairs with the fence
+			// of wait_nonempty.
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (head->sleeping.load(std::memory_order_relaxed) != 0)
+				wake(head->wakeWord, 1);
+		}
+
+		/**
+			\brief Wakes the consumer even if the ring is empty, like to stop
+			it.
+		*/
+		inline void wake_consumer() noexcept
+		{
+			wake(head->wakeWord, 1);
+		}
+
+		/**
+			\brief Wakes the processes waiting for the queue to drain, like
+			when the consumer exits.
+		*/
+		inline void wake_drained() noexcept
+		{
+			wake(head->drainWord, INT32_MAX);
+		}
+
+		/**
+			\brief Blocks the consumer till the ring holds a value or stop
+			returns true.
+
+			<h3>Return</h3>
+			false if woken only by stop.\n
+		*/
+		template<class Pred>
+		bool wait_nonempty(
+			Pred stop /**< : <i>in</i> : Checks if the consumer should stop.*/
+		) noexcept
+		{
+			while (empty() && !stop())
+			{
+				std::uint32_t seen = head->wakeWord.load(std::memory_order_acquire);
+				head->sleeping.store(1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				if (empty() && !stop())
+					wait_on(head->wakeWord, seen, std::chrono::nanoseconds::max());
+				head->sleeping.store(0, std::memory_order_relaxed);
+			}
+			return !empty();
+		}
+
+		/**
+			\brief Blocks till every message posted is processed, exited
+			returns true or deadline is reached.
+
+			<h3>Return</h3>
+			true if every message posted was processed.\n
+		*/
+		template<class Pred>
+		bool wait_drained(
+			Pred exited /**< : <i>in</i> : Checks if waiting is pointless.*/,
+			std::chrono::steady_clock::time_point deadline /**< : <i>in</i> :
+							The time to stop waiting at.*/
+		) noexcept
+		{
+			while (head->unfinished.load() != 0 && !exited())
+			{
+				auto now = std::chrono::steady_clock::now();
+				if (now >= deadline)
+					break;
+				std::uint32_t seen = head->drainWord.load(std::memory_order_acquire);
+				head->drainWaiters.fetch_add(1);
+				if (head->unfinished.load() != 0 && !exited())
+					wait_on(head->drainWord, seen,
+						deadline == std::chrono::steady_clock::time_point::max()
+						? std::chrono::nanoseconds::max()
+						: std::chrono::nanoseconds(deadline - now));
+				head->drainWaiters.fetch_sub(1);
+			}
+			return head->unfinished.load() == 0;
+		}
+	};
+
+	/**
+		\brief The queue policy of queued_process that shares a lock-free
+		bounded ring in shared memory between processes, see
+		shared_queue.enh.h.
+
+		Posting never takes a lock, postMessage blocks while the ring is full
+		and try_postMessage reports it instead. Construct queued_process with
+		an shm_config.
+
+		<h3>Template arguments</h3>
+		-#  <code>std::size_t capacity</code> : The number of messages that
+		can be pending, must be a power of 2.\n
+	*/
+	template<std::size_t capacity>
+	struct shared_ring
+	{
+		/**
+			\brief The storage for messages of type T.
+		*/
+		template<class T>
+		using storage = shm_ring<T, capacity>;
+
+		/**
+			\brief Storage is safe for concurrent producers and one consumer.
+		*/
+		static constexpr bool is_lock_free = true;
+
+		/**
+			\brief try_push fails when full.
+		*/
+		static constexpr bool is_bounded = true;
+
+		/**
+			\brief Messages are FIFO.
+		*/
+		static constexpr bool is_scheduled = false;
+
+		/**
+			\brief No statistics are collected.
+		*/
+		static constexpr bool has_stats = false;
+
+		/**
+			\brief Messages are kept in memory only.
+		*/
+		static constexpr bool is_durable = false;
+
+		/**
+			\brief Counts and wake-ups go through the storage, across
+			processes.
+		*/
+		static constexpr bool is_shared = true;
+
+		/**
+			\brief Every message posted is kept.
+		*/
+		static constexpr bool is_coalescing = false;
+	};
+}
+
+#endif
+
+#endif // !SHARED_QUEUE_ENH_H
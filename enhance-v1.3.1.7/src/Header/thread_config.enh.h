@@ -0,0 +1,485 @@
+/** ***************************************************************************
+	\file thread_config.enh.h
+
+	\brief The file to declare thread_config, the placement, scheduling and
+	name of threads owned by the library, and node_memory
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	<h3> How To Use</h3>
+
+	- Fill a `thread_config` and pass it to
+	`queued_process::start_queue_process`, `timer_service::setThreadConfig`
+	(the thread of every enh::timer of that service) or
+	`precise_timer::setThreadConfig`. The thread applies it when it starts.
+
+	- Set `numaNode` to keep the thread on the processors of a node and
+	have its allocations come from the memory of that node. For queue
+	storage allocated by producers, allocate it from a `node_memory` through
+	an enh::arena (see arena.enh.h) with an `allocated_queue` policy.
+
+	- Call `applyThreadConfig` to apply a configuration to the calling
+	thread.
+
+	Real time policies usually need privileges (CAP_SYS_NICE on Linux), the
+	rest of the configuration is still applied when they fail.
+
+******************************************************************************/
+
+#ifndef THREAD_CONFIG_ENH_H
+
+#define THREAD_CONFIG_ENH_H					thread_config.enh.h
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace enh
+{
+
+	/**
+		\brief The scheduling policy of a thread.
+	*/
+	enum class sched_policy
+	{
+		inherit,			/**< : Left as created (default).*/
+		normal,				/**< : Time shared (SCHED_OTHER, normal
+							priority on Windows).*/
+		batch,				/**< : Time shared, for throughput rather than
+							latency (SCHED_BATCH, below normal on
+							Windows).*/
+		idle,				/**< : Run only when nothing else does
+							(SCHED_IDLE, idle priority on Windows).*/
+		fifo,				/**< : Real time, runs till it blocks
+							(SCHED_FIFO, time critical on Windows).*/
+		round_robin			/**< : Real time with time slices (SCHED_RR,
+							highest priority on Windows).*/
+	};
+
+	/**
+		\brief The placement, scheduling and name of a thread.
+
+		Default constructed it changes nothing.
+	*/
+	struct thread_config
+	{
+		/**
+			\brief The processors the thread may run on, empty for no
+			change.
+		*/
+		std::vector<int> cpus;
+
+		/**
+			\brief The NUMA node whose memory the thread allocates from, and
+			whose processors it runs on if cpus is empty, -1 for none.
+		*/
+		int numaNode = -1;
+
+		/**
+			\brief The scheduling policy.
+		*/
+		sched_policy policy = sched_policy::inherit;
+
+		/**
+			\brief The real time priority for fifo and round_robin (1 to 99
+			on Linux), ignored otherwise.
+		*/
+		int priority = 1;
+
+		/**
+			\brief The name shown by top, perf and debuggers, cut to 15
+			characters on Linux, empty for no change.
+		*/
+		std::string name;
+	};
+
+	/**
+		\brief Pins the calling thread to processor cpu.
+
+		<h3>Return</h3>
+		false if not supported on the platform or it failed.\n
+	*/
+	inline bool pinThread(
+		int cpu /**< : <i>in</i> : The processor, from 0.*/
+	) noexcept
+	{
+		if (cpu < 0)
+			return false;
+#if defined(_WIN32)
+		if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8))
+			return false;
+		return SetThreadAffinityMask(GetCurrentThread(),
+			DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+		if (cpu >= CPU_SETSIZE)
+			return false;
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+		return false;
+#endif
+	}
+
+	/**
+		\brief Lets the calling thread run only on the processors cpus.
+
+		<h3>Return</h3>
+		false if cpus is empty, not supported on the platform or it
+		failed.\n
+	*/
+	inline bool setThreadAffinity(
+		const std::vector<int>& cpus /**< : <i>in</i> : The processors, from
+									 0.*/
+	) noexcept
+	{
+		if (cpus.empty())
+			return false;
+#if defined(_WIN32)
+		DWORD_PTR mask = 0;
+		for (int cpu : cpus)
+		{
+			if (cpu < 0 || cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8))
+				return false;
+			mask |= DWORD_PTR(1) << cpu;
+		}
+		return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int cpu : cpus)
+		{
+			if (cpu < 0 || cpu >= CPU_SETSIZE)
+				return false;
+			CPU_SET(cpu, &set);
+		}
+		return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+		return false;
+#endif
+	}
+
+	/**
+		\brief The processors of NUMA node.
+
+		<h3>Return</h3>
+		The processors, empty if node does not exist or not supported on
+		the platform.\n
+	*/
+	inline std::vector<int> nodeCpus(
+		int node /**< : <i>in</i> : The node, from 0.*/
+	)
+	{
+		std::vector<int> cpus;
+		if (node < 0)
+			return cpus;
+#if defined(_WIN32)
+		ULONGLONG mask = 0;
+		if (node > 0xff || !GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask))
+			return cpus;
+		for (int cpu = 0; cpu < 64; ++cpu)
+			if (mask & (ULONGLONG(1) << cpu))
+				cpus.push_back(cpu);
+#elif defined(__linux__)
+		// a list of ranges like 0-7,16-23
+		std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+		int first = 0;
+		while (in >> first)
+		{
+			int last = first;
+			if (in.peek() == '-')
+			{
+				in.get();
+				in >> last;
+			}
+			for (int cpu = first; cpu <= last; ++cpu)
+				cpus.push_back(cpu);
+			if (in.peek() == ',')
+				in.get();
+		}
+#endif
+		return cpus;
+	}
+
+	/**
+		\brief Has later allocations of the calling thread come from the
+		memory of NUMA node when it has free memory.
+
+		<h3>Return</h3>
+		false if not supported on the platform or it failed.\n
+	*/
+	inline bool preferNode(
+		int node /**< : <i>in</i> : The node, from 0.*/
+	) noexcept
+	{
+		if (node < 0)
+			return false;
+#if defined(__linux__) && defined(SYS_set_mempolicy)
+		constexpr int mpol_preferred = 1;
+		constexpr int bits = static_cast<int>(sizeof(unsigned long) * 8);
+		unsigned long mask[16] = {};
+		if (node >= bits * 16)
+			return false;
+		mask[node / bits] = 1UL << (node % bits);
+		return syscall(SYS_set_mempolicy, mpol_preferred, mask,
+			static_cast<unsigned long>(bits * 16 + 1)) == 0;
+#else
+		// Windows allocates from the node of the processor running the
+		// thread, which setting the affinity takes care of.
+		return false;
+#endif
+	}
+
+	/**
+		\brief Sets the scheduling policy of the calling thread.
+
+		<h3>Return</h3>
+		true if policy is inherit, false if not supported on the platform
+		or it failed (usually for lack of privileges).\n
+	*/
+	inline bool setThreadPolicy(
+		sched_policy policy /**< : <i>in</i> : The policy.*/,
+		int priority = 1 /**< : <i>in</i> : The real time priority, for fifo
+						 and round_robin.*/
+	) noexcept
+	{
+		if (policy == sched_policy::inherit)
+			return true;
+#if defined(_WIN32)
+		int level = THREAD_PRIORITY_NORMAL;
+		switch (policy)
+		{
+		case sched_policy::batch: level = THREAD_PRIORITY_BELOW_NORMAL; break;
+		case sched_policy::idle: level = THREAD_PRIORITY_IDLE; break;
+		case sched_policy::fifo: level = THREAD_PRIORITY_TIME_CRITICAL; break;
+		case sched_policy::round_robin: level = THREAD_PRIORITY_HIGHEST; break;
+		default: break;
+		}
+		(void)priority;
+		return SetThreadPriority(GetCurrentThread(), level) != 0;
+#elif defined(__linux__)
+		int native = SCHED_OTHER;
+		sched_param param{};
+		switch (policy)
+		{
+		case sched_policy::batch: native = SCHED_BATCH; break;
+		case sched_policy::idle: native = SCHED_IDLE; break;
+		case sched_policy::fifo: native = SCHED_FIFO; param.sched_priority = priority; break;
+		case sched_policy::round_robin: native = SCHED_RR; param.sched_priority = priority; break;
+		default: break;
+		}
+		return pthread_setschedparam(pthread_self(), native, &param) == 0;
+#else
+		(void)priority;
+		return false;
+#endif
+	}
+
+	/**
+		\brief Names the calling thread.
+
+		<h3>Return</h3>
+		false if not supported on the platform or it failed.\n
+	*/
+	inline bool setThreadName(
+		const std::string& name /**< : <i>in</i> : The name, cut to 15
+								characters on Linux.*/
+	) noexcept
+	{
+#if defined(_WIN32)
+		// SetThreadDescription is only in Windows 10 1607 and later.
+		using describe = HRESULT(WINAPI*)(HANDLE, PCWSTR);
+		HMODULE kernel = GetModuleHandleW(L"kernel32.dll");
+		auto fn = kernel ? reinterpret_cast<describe>(reinterpret_cast<void*>(
+			GetProcAddress(kernel, "SetThreadDescription"))) : nullptr;
+		if (!fn)
+			return false;
+		wchar_t wide[64] = {};
+		std::size_t len = name.size() < 63 ? name.size() : 63;
+		for (std::size_t i = 0; i < len; ++i)
+			wide[i] = static_cast<unsigned char>(name[i]);
+		return SUCCEEDED(fn(GetCurrentThread(), wide));
+#elif defined(__linux__)
+		char buff[16] = {};
+		name.copy(buff, 15);
+		return pthread_setname_np(pthread_self(), buff) == 0;
+#else
+		(void)name;
+		return false;
+#endif
+	}
+
+	/**
+		\brief Applies config to the calling thread.
+
+		Every part is tried even if one fails.
+
+		<h3>Return</h3>
+		true if every part set was applied.\n
+	*/
+	inline bool applyThreadConfig(
+		const thread_config& config /**< : <i>in</i> : The configuration.*/
+	) noexcept
+	{
+		bool good = true;
+		if (!config.cpus.empty())
+			good = setThreadAffinity(config.cpus) && good;
+		if (config.numaNode >= 0)
+		{
+			if (config.cpus.empty())
+			{
+				try
+				{
+					good = setThreadAffinity(nodeCpus(config.numaNode)) && good;
+				}
+				catch (...)
+				{
+					good = false;
+				}
+			}
+#if defined(__linux__)
+			good = preferNode(config.numaNode) && good;
+#endif
+		}
+		good = setThreadPolicy(config.policy, config.priority) && good;
+		if (!config.name.empty())
+			good = setThreadName(config.name) && good;
+		return good;
+	}
+
+	/**
+		\brief The class for page aligned memory taken from one NUMA node, to
+		back an enh::arena for node local queue storage.
+
+		The memory is preferred from node, and comes from wherever there is
+		free memory if the node has none. Without NUMA support it is plain
+		memory from operator new.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class node_memory
+	{
+		void* base = nullptr;
+		std::size_t bytes = 0;
+
+	public:
+
+		/**
+			\brief Takes size bytes (rounded up to pages) from node.
+
+			Throws std::bad_alloc if no memory could be taken.
+		*/
+		node_memory(
+			std::size_t size /**< : <i>in</i> : The bytes to take.*/,
+			int node /**< : <i>in</i> : The NUMA node, -1 for any.*/
+		)
+		{
+#if defined(_WIN32)
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			std::size_t page = info.dwPageSize;
+			bytes = (size + page - 1) / page * page;
+			base = (node >= 0)
+				? VirtualAllocExNuma(GetCurrentProcess(), nullptr, bytes,
+					MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, static_cast<DWORD>(node))
+				: VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+			if (!base)
+				throw std::bad_alloc();
+#elif defined(__linux__)
+			std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+			bytes = (size + page - 1) / page * page;
+			base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+				MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (base == MAP_FAILED)
+			{
+				base = nullptr;
+				throw std::bad_alloc();
+			}
+#if defined(SYS_mbind)
+			constexpr int mpol_preferred = 1;
+			constexpr int bits = static_cast<int>(sizeof(unsigned long) * 8);
+			unsigned long mask[16] = {};
+			if (node >= 0 && node < bits * 16)
+			{
+				mask[node / bits] = 1UL << (node % bits);
+				// best effort, the memory is still usable if it fails
+				(void)syscall(SYS_mbind, base, bytes, mpol_preferred, mask,
+					static_cast<unsigned long>(bits * 16 + 1), 0U);
+			}
+#endif
+#else
+			(void)node;
+			bytes = size;
+			base = ::operator new(bytes);
+#endif
+		}
+
+		node_memory(const node_memory&) = delete;
+
+		node_memory& operator = (const node_memory&) = delete;
+
+		/**
+			\brief Gives the memory back.
+		*/
+		~node_memory()
+		{
+			if (!base)
+				return;
+#if defined(_WIN32)
+			VirtualFree(base, 0, MEM_RELEASE);
+#elif defined(__linux__)
+			munmap(base, bytes);
+#else
+			::operator delete(base);
+#endif
+		}
+
+		/**
+			\brief The memory.
+		*/
+		inline void* data() const noexcept { return base; }
+
+		/**
+			\brief The size of the memory, size given rounded up to pages.
+		*/
+		inline std::size_t size() const noexcept { return bytes; }
+	};
+}
+
+#endif
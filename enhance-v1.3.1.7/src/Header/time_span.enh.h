@@ -0,0 +1,336 @@
+/** ***************************************************************************
+	\file time_span.enh.h
+
+	\brief The file to declare class time_span, a duration bridging counter,
+	time_stamp and std::chrono
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef TIME_SPAN_ENH_H
+
+#define TIME_SPAN_ENH_H					time_span.enh.h
+
+#include "counter.enh.h"
+#include "date_time.enh.h"
+
+#include <chrono>
+#include <type_traits>
+
+namespace enh
+{
+
+	/**
+		\brief The class for a span of time, signed, held as one count of
+		nanoseconds (about +-292 years).
+
+		Converts to and from std::chrono::duration (implicitly where
+		std::chrono::nanoseconds would, so without loss), enh::counter and
+		the add / sub functions of time_stamp and DateTime, so elapsed time
+		is accumulated as integer adds and converted once.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class time_span
+	{
+		/**
+			\brief The nanoseconds.
+		*/
+		long long ticks = 0;
+
+	public:
+
+		/**
+			\brief The nanoseconds in a second.
+		*/
+		static constexpr long long per_second = 1000000000LL;
+
+		/**
+			\brief Constructs an empty span.
+		*/
+		constexpr inline time_span() noexcept = default;
+
+		/**
+			\brief Constructs from a std::chrono::duration that converts to
+			nanoseconds without loss.
+		*/
+		template<class Rep, class Period, std::enable_if_t<std::is_convertible_v<
+			std::chrono::duration<Rep, Period>, std::chrono::nanoseconds>, int> = 0>
+		constexpr inline time_span(
+			std::chrono::duration<Rep, Period> d /**< : <i>in</i> : The
+												 duration.*/
+		) noexcept : ticks(std::chrono::nanoseconds(d).count()) {}
+
+		/**
+			\brief Constructs from any std::chrono::duration, truncating
+			towards 0 below a nanosecond.
+		*/
+		template<class Rep, class Period>
+		static constexpr inline time_span fromDuration(
+			std::chrono::duration<Rep, Period> d /**< : <i>in</i> : The
+												 duration.*/
+		) noexcept
+		{
+			return fromNanoseconds(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+		}
+
+		/**
+			\brief Constructs a span of ns nanoseconds.
+		*/
+		static constexpr inline time_span fromNanoseconds(
+			long long ns /**< : <i>in</i> : The nanoseconds.*/
+		) noexcept
+		{
+			time_span s;
+			s.ticks = ns;
+			return s;
+		}
+
+		/**
+			\brief Constructs a span of sec seconds.
+		*/
+		static constexpr inline time_span fromSeconds(
+			long long sec /**< : <i>in</i> : The seconds.*/
+		) noexcept
+		{
+			return fromNanoseconds(sec * per_second);
+		}
+
+		/**
+			\brief Constructs the span counted by c.
+
+			Counters past 292 years do not fit.
+		*/
+		static inline time_span fromCounter(
+			const counter& c /**< : <i>in</i> : The counter.*/
+		) noexcept
+		{
+			return fromSeconds(static_cast<long long>(c.get_total_seconds()));
+		}
+
+		/**
+			\brief Constructs the span from midnight to the time held by t.
+		*/
+		static constexpr inline time_span sinceMidnight(
+			const time_stamp& t /**< : <i>in</i> : The time.*/
+		) noexcept
+		{
+			return fromNanoseconds(static_cast<long long>(t.getNanosecondsOfDay()));
+		}
+
+		/**
+			\brief Constructs the span from from to to, negative if to is
+			earlier.
+		*/
+		static constexpr inline time_span between(
+			const DateTime& from /**< : <i>in</i> : The start.*/,
+			const DateTime& to /**< : <i>in</i> : The end.*/
+		) noexcept
+		{
+			return fromNanoseconds(to.getEpochNanos() - from.getEpochNanos());
+		}
+
+		/**
+			\brief The nanoseconds.
+		*/
+		constexpr inline long long count() const noexcept { return ticks; }
+
+		/**
+			\brief The whole seconds, truncated towards 0.
+		*/
+		constexpr inline long long getTotalSeconds() const noexcept
+		{
+			return ticks / per_second;
+		}
+
+		/**
+			\brief The span as a std::chrono::duration, truncated towards 0
+			for units coarser than a nanosecond.
+		*/
+		template<class Duration = std::chrono::nanoseconds>
+		constexpr inline Duration toDuration() const noexcept
+		{
+			return std::chrono::duration_cast<Duration>(std::chrono::nanoseconds(ticks));
+		}
+
+		/**
+			\brief The span as std::chrono::nanoseconds.
+		*/
+		constexpr inline operator std::chrono::nanoseconds() const noexcept
+		{
+			return std::chrono::nanoseconds(ticks);
+		}
+
+		/**
+			\brief The span as an enh::counter, whole seconds, 0 if negative.
+		*/
+		inline counter toCounter() const noexcept
+		{
+			counter c;
+			if (ticks > 0)
+				c.set_seconds(static_cast<unsigned long long>(ticks / per_second));
+			return c;
+		}
+
+		/**
+			\brief Adds the span to t, through addNanoseconds or
+			subNanoseconds.
+
+			<h3>Return</h3>
+			Returns the number of days passed, negative if taken back.\n
+		*/
+		constexpr inline long long addTo(
+			time_stamp& t /**< : <i>in,out</i> : The time.*/
+		) const noexcept
+		{
+			if (ticks >= 0)
+				return static_cast<long long>(
+					t.addNanoseconds(static_cast<unsigned long long>(ticks)));
+			return -static_cast<long long>(
+				t.subNanoseconds(0ULL - static_cast<unsigned long long>(ticks)));
+		}
+
+		/**
+			\brief Adds the span to dt, carrying into the date.
+		*/
+		constexpr inline void addTo(
+			DateTime& dt /**< : <i>in,out</i> : The date and time.*/
+		) const noexcept
+		{
+			if (ticks >= 0)
+				dt.addNanoseconds(static_cast<unsigned long long>(ticks));
+			else
+				dt.subNanoseconds(0ULL - static_cast<unsigned long long>(ticks));
+		}
+
+		/**
+			\brief Adds the span to c, the whole seconds, if not negative.
+		*/
+		inline void addTo(
+			counter& c /**< : <i>in,out</i> : The counter.*/
+		) const noexcept
+		{
+			if (ticks > 0)
+				c.add_seconds(static_cast<unsigned long long>(ticks / per_second));
+		}
+
+		constexpr inline time_span& operator += (const time_span& s) noexcept
+		{
+			ticks += s.ticks;
+			return *this;
+		}
+
+		constexpr inline time_span& operator -= (const time_span& s) noexcept
+		{
+			ticks -= s.ticks;
+			return *this;
+		}
+
+		constexpr inline time_span& operator *= (long long n) noexcept
+		{
+			ticks *= n;
+			return *this;
+		}
+
+		constexpr inline time_span& operator /= (long long n) noexcept
+		{
+			ticks /= n;
+			return *this;
+		}
+
+		constexpr inline time_span operator - () const noexcept
+		{
+			return fromNanoseconds(-ticks);
+		}
+	};
+
+	constexpr inline time_span operator + (time_span lhs, const time_span& rhs) noexcept
+	{
+		return lhs += rhs;
+	}
+
+	constexpr inline time_span operator - (time_span lhs, const time_span& rhs) noexcept
+	{
+		return lhs -= rhs;
+	}
+
+	constexpr inline time_span operator * (time_span lhs, long long n) noexcept
+	{
+		return lhs *= n;
+	}
+
+	constexpr inline time_span operator * (long long n, time_span rhs) noexcept
+	{
+		return rhs *= n;
+	}
+
+	constexpr inline time_span operator / (time_span lhs, long long n) noexcept
+	{
+		return lhs /= n;
+	}
+
+	/**
+		\brief The number of whole rhs in lhs.
+	*/
+	constexpr inline long long operator / (const time_span& lhs,
+		const time_span& rhs) noexcept
+	{
+		return lhs.count() / rhs.count();
+	}
+
+	constexpr inline time_span operator % (const time_span& lhs,
+		const time_span& rhs) noexcept
+	{
+		return time_span::fromNanoseconds(lhs.count() % rhs.count());
+	}
+
+	constexpr inline bool operator == (const time_span& lhs, const time_span& rhs) noexcept
+	{
+		return lhs.count() == rhs.count();
+	}
+
+	constexpr inline bool operator != (const time_span& lhs, const time_span& rhs) noexcept
+	{
+		return lhs.count() != rhs.count();
+	}
+
+	constexpr inline bool operator < (const time_span& lhs, const time_span& rhs) noexcept
+	{
+		return lhs.count() < rhs.count();
+	}
+
+	constexpr inline bool operator <= (const time_span& lhs, const time_span& rhs) noexcept
+	{
+		return lhs.count() <= rhs.count();
+	}
+
+	constexpr inline bool operator > (const time_span& lhs, const time_span& rhs) noexcept
+	{
+		return lhs.count() > rhs.count();
+	}
+
+	constexpr inline bool operator >= (const time_span& lhs, const time_span& rhs) noexcept
+	{
+		return lhs.count() >= rhs.count();
+	}
+}
+
+#endif
@@ -30,6 +30,11 @@
 
 #include "date.enh.h"
 
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
 namespace enh
 {
 	namespace dt_type
@@ -50,6 +55,44 @@ namespace enh
 		using hr_t = enh::NumericSystem<unsigned short, 24>;
 	}
 
+	/**
+		\brief The nanoseconds from the unix epoch of tp, of any clock.
+
+		For clocks other than std::chrono::system_clock, the offset between
+		the clocks is measured at the call.
+	*/
+	template<class Clock, class Duration>
+	inline long long epochNanosOf(
+		std::chrono::time_point<Clock, Duration> tp /**< : <i>in</i> : The
+													time point.*/
+	)
+	{
+		using namespace std::chrono;
+		if constexpr (std::is_same_v<Clock, system_clock>)
+			return duration_cast<nanoseconds>(tp.time_since_epoch()).count();
+		else
+			return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()
+				+ (tp - Clock::now())).count();
+	}
+
+	/**
+		\brief The time point of Clock ns nanoseconds after the unix epoch,
+		the inverse of epochNanosOf.
+	*/
+	template<class Clock = std::chrono::high_resolution_clock>
+	inline typename Clock::time_point timePointOfEpochNanos(
+		long long ns /**< : <i>in</i> : The nanoseconds from the epoch.*/
+	)
+	{
+		using namespace std::chrono;
+		auto since = duration_cast<typename Clock::duration>(nanoseconds(ns));
+		if constexpr (std::is_same_v<Clock, system_clock>)
+			return typename Clock::time_point(since);
+		else
+			return Clock::now() + duration_cast<typename Clock::duration>(
+				since - system_clock::now().time_since_epoch());
+	}
+
 	/**
 		\brief Class for time manipulation.
 
@@ -74,24 +117,39 @@ namespace enh
 		*/
 		dt_type::hr_t hours;
 
+		/**
+			\brief The fraction of the second in nanoseconds [0,1e9).
+		*/
+		std::uint32_t nanos = 0;
+
 	public:
 
+		/**
+			\brief The nanoseconds in a second.
+		*/
+		static constexpr std::uint32_t nanos_per_second = 1000000000U;
+
 		/**
 			\brief Sets the time to the time indicated by arguments.
 
 			<h3>Exception</h3>
-			Throws <code>std::invalid_argument</code> if sec, min, hr is
-			not within bounds. [0,60], [0,59], [0,23] respectively.
+			Throws <code>std::invalid_argument</code> if sec, min, hr, ns is
+			not within bounds. [0,60], [0,59], [0,23], [0,1e9) respectively.
 		*/
 		constexpr inline void setTime(
 			unsigned short sec /**< : <i>in</i> : The seconds field [0,59].*/,
 			unsigned short min /**< : <i>in</i> : The minutes field [0,59].*/,
-			unsigned short hr  /**< : <i>in</i> : The hours field [0,59].*/
+			unsigned short hr  /**< : <i>in</i> : The hours field [0,59].*/,
+			std::uint32_t ns = 0 /**< : <i>in</i> : The fraction of second in 
+								 nanoseconds [0,1e9).*/
 		)
 		{
+			if (ns >= nanos_per_second)
+				throw std::invalid_argument("nanoseconds not within [0,1e9)");
 			seconds.set(sec);
 			minutes.set(min);
 			hours.set(hr);
+			nanos = ns;
 		}
 
 		/**
@@ -109,6 +167,28 @@ namespace enh
 				setTime(59, tm_str.tm_min, tm_str.tm_hour);
 		}
 
+		/**
+			\brief Sets the time to the local time of tp, with the fraction
+			of second.
+		*/
+		template<class Clock, class Duration>
+		inline void setTime(
+			std::chrono::time_point<Clock, Duration> tp /**< : <i>in</i> : The
+														time point.*/
+		)
+		{
+			long long ns = epochNanosOf(tp);
+			long long sec = ns / nanos_per_second;
+			long long frac = ns % nanos_per_second;
+			if (frac < 0)
+			{
+				frac += nanos_per_second;
+				--sec;
+			}
+			setTime(static_cast<time_t>(sec));
+			nanos = static_cast<std::uint32_t>(frac);
+		}
+
 		/**
 			\brief Sets the time to the current time.
 		*/
@@ -121,14 +201,20 @@ namespace enh
 			\brief Sets the time to the time indicated by arguments.
 
 			<h3>Exception</h3>
-			Throws <code>std::invalid_argument</code> if sec, min, hr is
-			not within bounds. [0,60], [0,59], [0,23] respectively.
+			Throws <code>std::invalid_argument</code> if sec, min, hr, ns is
+			not within bounds. [0,60], [0,59], [0,23], [0,1e9) respectively.
 		*/
 		constexpr inline time_stamp(
 			unsigned short sec /**< : <i>in</i> : The seconds field [0,60].*/,
 			unsigned short min /**< : <i>in</i> : The minutes field [0,59].*/,
-			unsigned short hr  /**< : <i>in</i> : The hours field [0,59].*/
-		) : seconds(sec), minutes(min), hours(hr) {}
+			unsigned short hr  /**< : <i>in</i> : The hours field [0,59].*/,
+			std::uint32_t ns = 0 /**< : <i>in</i> : The fraction of second in 
+								 nanoseconds [0,1e9).*/
+		) : seconds(sec), minutes(min), hours(hr), nanos(ns)
+		{
+			if (ns >= nanos_per_second)
+				throw std::invalid_argument("nanoseconds not within [0,1e9)");
+		}
 
 		/**
 			\brief Sets the time to the time indicated by argument.
@@ -190,6 +276,29 @@ namespace enh
 			return addMinutes(seconds.add(sec));
 		}
 
+		/**
+			\brief Adds to the fraction of second held (also seconds, minutes
+			and hours).
+
+			<h3>Return</h3>
+			Returns the number of days passed.
+
+		*/
+		constexpr inline unsigned long long addNanoseconds(
+			unsigned long long ns  /**< : <i>in</i> : The nanoseconds to add.*/
+		) noexcept
+		{
+			unsigned long long total = nanos + ns % nanos_per_second;
+			unsigned long long sec = ns / nanos_per_second;
+			if (total >= nanos_per_second)
+			{
+				total -= nanos_per_second;
+				++sec;
+			}
+			nanos = static_cast<std::uint32_t>(total);
+			return sec ? addSeconds(sec) : 0;
+		}
+
 		/**
 			\brief Reduce the hour part of time held.
 
@@ -232,6 +341,105 @@ namespace enh
 			return subMinutes(seconds.sub(sec));
 		}
 
+		/**
+			\brief Reduces the fraction of second held (also seconds, minutes
+			and hours).
+
+			<h3>Return</h3>
+			Returns the number of days passed.
+
+		*/
+		constexpr inline unsigned long long subNanoseconds(
+			unsigned long long ns /**< : <i>in</i> : The nanoseconds to reduce.*/
+		) noexcept
+		{
+			unsigned long long part = ns % nanos_per_second;
+			unsigned long long sec = ns / nanos_per_second;
+			if (part > nanos)
+			{
+				nanos = static_cast<std::uint32_t>(nanos + nanos_per_second - part);
+				++sec;
+			}
+			else
+				nanos = static_cast<std::uint32_t>(nanos - part);
+			return sec ? subSeconds(sec) : 0;
+		}
+
+		/**
+			\brief The seconds after midnight [0,86400).
+		*/
+		constexpr inline unsigned getSecondsOfDay() const noexcept
+		{
+			return hours.get() * 3600U + minutes.get() * 60U + seconds.get();
+		}
+
+		/**
+			\brief Sets the time to sec seconds after midnight, wrapping past
+			a day.
+		*/
+		constexpr inline void setSecondsOfDay(
+			unsigned long long sec /**< : <i>in</i> : The seconds after 
+								   midnight.*/
+		) noexcept
+		{
+			sec %= 86400ULL;
+			hours.set(static_cast<unsigned short>(sec / 3600));
+			minutes.set(static_cast<unsigned short>(sec / 60 % 60));
+			seconds.set(static_cast<unsigned short>(sec % 60));
+		}
+
+		/**
+			\brief The nanoseconds after midnight [0,86400e9).
+		*/
+		constexpr inline unsigned long long getNanosecondsOfDay() const noexcept
+		{
+			return getSecondsOfDay() * 1000000000ULL + nanos;
+		}
+
+		/**
+			\brief Sets the time to ns nanoseconds after midnight, wrapping 
+			past a day.
+		*/
+		constexpr inline void setNanosecondsOfDay(
+			unsigned long long ns /**< : <i>in</i> : The nanoseconds after 
+								  midnight.*/
+		) noexcept
+		{
+			setSecondsOfDay(ns / nanos_per_second);
+			nanos = static_cast<std::uint32_t>(ns % nanos_per_second);
+		}
+
+		/**
+			\brief Sets the fraction of second in nanoseconds.
+
+			<h3>Exception</h3>
+			Throws <code>std::invalid_argument</code> if ns is not within 
+			[0,1e9).
+		*/
+		constexpr inline void setNanoseconds(
+			std::uint32_t ns /**< : <i>in</i> : The nanoseconds [0,1e9).*/
+		)
+		{
+			if (ns >= nanos_per_second)
+				throw std::invalid_argument("nanoseconds not within [0,1e9)");
+			nanos = ns;
+		}
+
+		/**
+			\brief Get the fraction of second in nanoseconds [0,1e9).
+		*/
+		constexpr inline std::uint32_t getNanoseconds() const noexcept { return nanos; }
+
+		/**
+			\brief Get the fraction of second in microseconds [0,1e6).
+		*/
+		constexpr inline std::uint32_t getMicroseconds() const noexcept { return nanos / 1000U; }
+
+		/**
+			\brief Get the fraction of second in milliseconds [0,1000).
+		*/
+		constexpr inline std::uint32_t getMilliseconds() const noexcept { return nanos / 1000000U; }
+
 		/**
 			\brief Get Seconds field.
 		*/
@@ -258,9 +466,99 @@ namespace enh
 		*/
 		inline std::string getStringTime() const
 		{
-			return signExtendValue(hours.get(), 2) + " : "
-				+ signExtendValue(minutes.get(), 2) + " : "
-				+ signExtendValue(seconds.get(), 2);
+			char buf[max_string_size];
+			return std::string(buf, format_to(buf, buf + max_string_size));
+		}
+
+		/**
+			\brief The string of getStringTime() allocated by alloc, so it can be 
+			released with an arena.
+		*/
+		template<class Alloc, std::enable_if_t<is_allocator_v<Alloc>, int> = 0>
+		inline alloc_string<Alloc> getStringTime(
+			const Alloc& alloc /**< : <i>in</i> : The allocator of the string.*/
+		) const
+		{
+			char buf[max_string_size];
+			return alloc_string<Alloc>(buf, format_to(buf, buf + max_string_size),
+				typename alloc_string<Alloc>::allocator_type(alloc));
+		}
+
+		/**
+			\brief The length of the string of getStringTime and format_to.
+		*/
+		static constexpr std::size_t max_string_size = 12;
+
+		/**
+			\brief Writes two digits of value at out.
+		*/
+		static constexpr inline void put2(
+			char* out /**< : <i>out</i> : The buffer.*/,
+			unsigned value /**< : <i>in</i> : The value [0,99].*/
+		) noexcept
+		{
+			writeDigits2(out, value);
+		}
+
+		/**
+			\brief Writes the string of getStringTime() (hh : mm : ss) to 
+			[first, last), without allocating. Nothing is null terminated.
+
+			<h3>Return</h3>
+			The end of the written characters, nullptr if it did not fit.\n
+		*/
+		inline char* format_to(
+			char* first /**< : <i>out</i> : The start of the buffer.*/,
+			char* last /**< : <i>in</i> : The end of the buffer.*/
+		) const noexcept
+		{
+			if (!first || last - first < 12)
+				return nullptr;
+			put2(first, hours.get());
+			first[2] = ' '; first[3] = ':'; first[4] = ' ';
+			put2(first + 5, minutes.get());
+			first[7] = ' '; first[8] = ':'; first[9] = ' ';
+			put2(first + 10, seconds.get());
+			return first + 12;
+		}
+
+		/**
+			\brief Writes the time as ISO-8601 hh:mm:ss to [first, last), 
+			without allocating, followed by .fraction if digits is not 0.
+
+			<h3>Return</h3>
+			The end of the written characters, nullptr if it did not fit.\n
+		*/
+		inline char* format_iso_to(
+			char* first /**< : <i>out</i> : The start of the buffer.*/,
+			char* last /**< : <i>in</i> : The end of the buffer.*/,
+			unsigned digits = 0 /**< : <i>in</i> : The digits of the fraction
+								of second [0,9].*/
+		) const noexcept
+		{
+			if (digits > 9)
+				digits = 9;
+			std::size_t size = 8 + (digits ? digits + 1 : 0);
+			if (!first || static_cast<std::size_t>(last - first) < size)
+				return nullptr;
+			put2(first, hours.get());
+			first[2] = ':';
+			put2(first + 3, minutes.get());
+			first[5] = ':';
+			put2(first + 6, seconds.get());
+			if (digits)
+			{
+				first[8] = '.';
+				std::uint32_t frac = nanos;
+				for (unsigned i = digits; i < 9; ++i)
+					frac /= 10;
+				for (unsigned i = digits; i > 0; --i)
+				{
+					first[8 + i] = static_cast<char>('0' + frac % 10);
+					frac /= 10;
+				}
+			}
+			return first + size;
 		}
 
 		/**
@@ -303,22 +601,23 @@ namespace enh
 			\brief Checks if argument is equal to this object.
 
 			<h3>Return</h3>
-			Returns true if hours, minutes and seconds of argument is equal to
-			current object.
+			Returns true if hours, minutes, seconds and fraction of second of
+			argument is equal to current object.
 		*/
 		constexpr inline bool isEqualTo(
 			const time_stamp &dt /**< : <i>in</i> : The time_stamp to compare with.*/
 		) const noexcept
 		{
-			return (hours == dt.hours) && (minutes == dt.minutes) && (seconds == dt.seconds);
+			return (hours == dt.hours) && (minutes == dt.minutes) && (seconds == dt.seconds)
+				&& (nanos == dt.nanos);
 		}
 
 		/**
 			\brief Checks if argument is not equal to this object.
 
 			<h3>Return</h3>
-			Returns true if hours, minutes and seconds of argument is not equal to
-			current object.
+			Returns true if hours, minutes, seconds and fraction of second of
+			argument is not equal to current object.
 		*/
 		constexpr inline bool isNotEqualTo(
 			const time_stamp &dt /**< : <i>in</i> : The time_stamp to compare with.*/
@@ -354,7 +653,7 @@ namespace enh
 					else if (seconds > dt.seconds)
 						return false;
 					else
-						return false;
+						return nanos < dt.nanos;
 
 				}
 			}
@@ -387,7 +686,7 @@ namespace enh
 					else if (seconds > dt.seconds)
 						return false;
 					else
-						return true;
+						return nanos <= dt.nanos;
 
 				}
 			}
@@ -29,6 +29,8 @@
 #define TIMER_ENH_H						timer.enh.h
 
 #include "logger.enh.h"
+#include "histogram.enh.h"
+#include "thread_config.enh.h"
 
 #include <chrono>
 #include <type_traits>
@@ -36,6 +38,21 @@
 #include <condition_variable>
 #include <atomic>
 #include <functional>
+#include <thread>
+#include <cstddef>
+#include <climits>
+#include <cstdint>
+
+#if defined(__has_include)
+#if __has_include(<coroutine>) && defined(__cpp_impl_coroutine)
+#include <coroutine>
+/**
+	\brief Defined if C++20 coroutines are supported, enabling the awaitable
+	members of enh::timer and enh::coroutine_method.
+*/
+#define ENH_HAS_COROUTINES
+#endif
+#endif
 
 namespace enh
 {
@@ -108,6 +125,1421 @@ namespace enh
 	constexpr bool isGoodTimerType_v<std::chrono::microseconds> = true;
 
 
+	/**
+		\brief The source of time of a timer_service and of the timers and
+		waits on it.
+
+		timer_clock::real() is high_res, the default. A virtual_clock runs 
+		the timers of a service as fast as the threads using them allow. 
+		The service thread sleeps through service_wait and a thread blocked
+		in a timer wait is attached as a sleeper, so a virtual clock sees 
+		when every thread it drives is blocked.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class timer_clock
+	{
+	public:
+
+		/**
+			\brief A thread blocked in a wait on the clock, kept on its stack
+			while attached.
+		*/
+		struct sleeper
+		{
+			std::mutex* lock;				/**< : The mutex of the wait.*/
+			std::condition_variable* wake;	/**< : Notified under lock once
+											until is reached.*/
+			time_pt until;					/**< : The deadline, 
+											time_pt::max() for none.*/
+			bool expired = false;			/**< : Set under lock once until
+											is reached.*/
+			std::atomic<int> state{ 0 };	/**< : 1 while counted as 
+											blocked, 2 once released.*/
+			std::atomic<std::size_t>* blocked = nullptr;	/**< : The blocked
+											count of the clock.*/
+			sleeper* prev = nullptr;
+			sleeper* next = nullptr;
+
+			sleeper(std::mutex& mtx, std::condition_variable& cv, time_pt deadline) noexcept
+				: lock(&mtx), wake(&cv), until(deadline) {}
+
+			/**
+				\brief Stops counting the thread as blocked, called by the 
+				thread waking it, which may hold lock.
+			*/
+			inline void release() noexcept
+			{
+				if (state.exchange(2) == 1)
+					blocked->fetch_sub(1);
+			}
+		};
+
+		virtual ~timer_clock() = default;
+
+		/**
+			\brief The current time.
+		*/
+		virtual time_pt now() noexcept = 0;
+
+		/**
+			\brief Checks if waits are to be attached, false for real time.
+		*/
+		virtual bool isVirtual() const noexcept { return false; }
+
+		/**
+			\brief Blocks the service thread, guard held, till until or a 
+			notify of wake.
+		*/
+		virtual void service_wait(
+			std::unique_lock<std::mutex>& guard /**< : <i>in</i> : The held
+												lock of the service.*/,
+			std::condition_variable& wake /**< : <i>in</i> : Notified by the
+										  service on a change.*/,
+			time_pt until /**< : <i>in</i> : The next deadline, 
+						  time_pt::max() for none.*/
+		) = 0;
+
+		/**
+			\brief Attaches a thread about to block, the caller must not hold
+			*s.lock.
+		*/
+		virtual void attach(
+			sleeper& s /**< : <i>in</i> : The sleeper.*/
+		) noexcept { (void)s; }
+
+		/**
+			\brief Detaches an attached thread, the caller must not hold 
+			*s.lock.
+		*/
+		virtual void detach(
+			sleeper& s /**< : <i>in</i> : The sleeper.*/
+		) noexcept { (void)s; }
+
+		/**
+			\brief The clock of high_res, shared.
+		*/
+		static timer_clock& real() noexcept;
+	};
+
+	/**
+		\brief The timer_clock of high_res, see timer_clock::real().
+
+		hasErrorHandlers        = false;\n
+	*/
+	class real_clock final : public timer_clock
+	{
+	public:
+
+		time_pt now() noexcept override { return high_res::now(); }
+
+		void service_wait(std::unique_lock<std::mutex>& guard, 
+			std::condition_variable& wake, time_pt until) override
+		{
+			if (until == time_pt::max())
+				wake.wait(guard);
+			else
+				wake.wait_until(guard, until);
+		}
+	};
+
+	inline timer_clock& timer_clock::real() noexcept
+	{
+		static real_clock clock;
+		return clock;
+	}
+
+	/**
+		\brief The timer_clock to replay timer driven work faster than real
+		time, now jumps to the next deadline once every participant is 
+		blocked.
+
+		A thread joins the clock with a participant and is then counted as
+		blocked while in a wait of a timer of the service using the clock
+		(the waits of precise_timer are not). Once every participant is 
+		blocked and the service thread is idle, now jumps to the earliest 
+		deadline of the service and of the timed waits, so the work runs at
+		the speed of the processor and each step sees the same times from 
+		run to run. Join or reserve the participants before starting the 
+		timers. With no participants now jumps whenever the service is 
+		idle, as fast as possible but in no order with other threads, and 
+		with a reservation never joined time moves only by advance_by.\n\n
+
+		A participant blocking on anything else (a queue, a lock) holds 
+		time still, wrap such waits in an idle_scope. A thread woken out of
+		an idle_scope or by a cancel_event is counted as blocked till it
+		leaves the wait, so time may step in between. advance_by moves time
+		by hand. Drives one service.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class virtual_clock final : public timer_clock
+	{
+		/**
+			\brief The current time, ticks of high_res since its epoch.
+		*/
+		std::atomic<high_res::rep> at;
+
+		/**
+			\brief The participants blocked.
+		*/
+		std::atomic<std::size_t> blocked{ 0 };
+
+		/**
+			\brief The mutex over the rest.
+		*/
+		std::mutex lock;
+
+		std::size_t participants = 0;
+		std::size_t reserved = 0;
+		sleeper* sleepers = nullptr;
+		std::mutex* serviceLock = nullptr;
+		std::condition_variable* serviceWake = nullptr;
+		time_pt serviceUntil = time_pt::max();
+		bool serviceWaiting = false;
+
+		/**
+			\brief The clock the thread participates in.
+		*/
+		static inline thread_local virtual_clock* joined = nullptr;
+
+		// wakes the sleepers due, true if the service is due, lock held
+		bool expire() noexcept
+		{
+			time_pt current = now();
+			for (sleeper* s = sleepers; s; s = s->next)
+				if (!s->expired && s->until <= current)
+				{
+					std::lock_guard<std::mutex> waiting(*s->lock);
+					s->expired = true;
+					s->release();
+					s->wake->notify_all();
+				}
+			if (serviceWaiting && serviceUntil <= current)
+			{
+				serviceWaiting = false;
+				return true;
+			}
+			return false;
+		}
+
+		// jumps to the next deadline if all are blocked, lock held
+		bool step() noexcept
+		{
+			if (blocked.load() < participants || !serviceWaiting)
+				return false;
+			time_pt target = serviceUntil;
+			for (sleeper* s = sleepers; s; s = s->next)
+				if (!s->expired && s->until < target)
+					target = s->until;
+			if (target == time_pt::max())
+				return false;
+			if (target > now())
+				at.store(target.time_since_epoch().count());
+			return expire();
+		}
+
+		// the service must not be held by the caller
+		void wake_service(bool due) noexcept
+		{
+			if (!due)
+				return;
+			std::lock_guard<std::mutex> guard(*serviceLock);
+			serviceWake->notify_all();
+		}
+
+	public:
+
+		/**
+			\brief Joins the thread to a clock till destroyed, so the clock
+			waits for it to block before moving time.
+		*/
+		class participant
+		{
+			virtual_clock* clock;
+
+		public:
+
+			/**
+				\brief Joins the calling thread to clk.
+			*/
+			explicit participant(
+				virtual_clock& clk /**< : <i>in</i> : The clock, must 
+								   outlive the participant.*/
+			) noexcept : clock(&clk)
+			{
+				std::lock_guard<std::mutex> guard(clock->lock);
+				if (clock->reserved)
+					--clock->reserved;
+				else
+					++clock->participants;
+				joined = clock;
+			}
+
+			participant(const participant&) = delete;
+
+			participant& operator = (const participant&) = delete;
+
+			/**
+				\brief Leaves the clock, on the thread that joined.
+			*/
+			~participant()
+			{
+				bool due;
+				{
+					std::lock_guard<std::mutex> guard(clock->lock);
+					--clock->participants;
+					joined = nullptr;
+					due = clock->step();
+				}
+				clock->wake_service(due);
+			}
+		};
+
+		/**
+			\brief Counts a participant as blocked while it waits on 
+			something other than a timer.
+		*/
+		class idle_scope
+		{
+			virtual_clock* clock;
+
+		public:
+
+			/**
+				\brief Counts the calling thread as blocked, if it joined 
+				clk.
+			*/
+			explicit idle_scope(
+				virtual_clock& clk /**< : <i>in</i> : The clock.*/
+			) noexcept : clock((joined == &clk) ? &clk : nullptr)
+			{
+				if (!clock)
+					return;
+				bool due;
+				{
+					std::lock_guard<std::mutex> guard(clock->lock);
+					clock->blocked.fetch_add(1);
+					due = clock->step();
+				}
+				clock->wake_service(due);
+			}
+
+			idle_scope(const idle_scope&) = delete;
+
+			idle_scope& operator = (const idle_scope&) = delete;
+
+			~idle_scope()
+			{
+				if (clock)
+					clock->blocked.fetch_sub(1);
+			}
+		};
+
+		/**
+			\brief Constructs a clock at start.
+		*/
+		explicit virtual_clock(
+			time_pt start = high_res::now() /**< : <i>in</i> : The time to 
+											start from.*/
+		) noexcept : at(start.time_since_epoch().count()) {}
+
+		virtual_clock(const virtual_clock&) = delete;
+
+		virtual_clock& operator = (const virtual_clock&) = delete;
+
+		time_pt now() noexcept override
+		{
+			return time_pt(high_res::duration(at.load()));
+		}
+
+		bool isVirtual() const noexcept override { return true; }
+
+		void service_wait(std::unique_lock<std::mutex>& guard,
+			std::condition_variable& wake, time_pt until) override
+		{
+			{
+				// service then clock, wake_service is called without the 
+				// clock lock.
+				std::lock_guard<std::mutex> clk(lock);
+				serviceLock = guard.mutex();
+				serviceWake = &wake;
+				serviceUntil = until;
+				serviceWaiting = true;
+				if (step())
+					return;
+			}
+			wake.wait(guard);
+			std::lock_guard<std::mutex> clk(lock);
+			serviceWaiting = false;
+		}
+
+		void attach(sleeper& s) noexcept override
+		{
+			bool due;
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				s.prev = nullptr;
+				s.next = sleepers;
+				if (sleepers)
+					sleepers->prev = &s;
+				sleepers = &s;
+				s.blocked = &blocked;
+				if (joined == this)
+				{
+					// a release in between leaves the thread uncounted.
+					int idle = 0;
+					blocked.fetch_add(1);
+					if (!s.state.compare_exchange_strong(idle, 1))
+						blocked.fetch_sub(1);
+				}
+				due = step();
+			}
+			wake_service(due);
+		}
+
+		void detach(sleeper& s) noexcept override
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (s.prev)
+				s.prev->next = s.next;
+			else
+				sleepers = s.next;
+			if (s.next)
+				s.next->prev = s.prev;
+			s.release();
+		}
+
+		/**
+			\brief Moves time forward by d, expiring what is due.
+		*/
+		template<class Rep, class Period>
+		void advance_by(
+			std::chrono::duration<Rep, Period> d /**< : <i>in</i> : The 
+												 time, not negative.*/
+		) noexcept
+		{
+			bool due;
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				at.fetch_add(std::chrono::duration_cast<high_res::duration>(d).count());
+				due = expire();
+			}
+			wake_service(due);
+		}
+
+		/**
+			\brief Counts n participants yet to join, so time waits for 
+			them, each then joins with a participant on its thread.
+		*/
+		void reserve(
+			std::size_t n /**< : <i>in</i> : The threads to come.*/
+		)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			reserved += n;
+			participants += n;
+		}
+
+		/**
+			\brief The count of participants, joined or reserved.
+		*/
+		std::size_t size()
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			return participants;
+		}
+	};
+
+	/**
+		\brief The base of a timer registered with a timer_service.
+
+		The service calls expire at deadline, and again every interval while
+		expire returns true.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class timer_entry
+	{
+		friend class timer_service;
+
+		/**
+			\brief Where the entry is in the service.
+		*/
+		enum class entry_state { idle, armed, firing };
+
+		timer_entry* prev = nullptr;
+		timer_entry* next = nullptr;
+		timer_entry** slot = nullptr;
+		entry_state state = entry_state::idle;
+		bool cancelled = false;
+		bool repeat = false;
+
+	public:
+
+		/**
+			\brief The time of the next expiry.
+		*/
+		time_pt deadline;
+
+		/**
+			\brief The time between expiries.
+		*/
+		high_res::duration interval = high_res::duration::zero();
+
+		timer_entry() noexcept = default;
+
+		timer_entry(const timer_entry&) = delete;
+
+		timer_entry& operator = (const timer_entry&) = delete;
+
+		virtual ~timer_entry() = default;
+
+		/**
+			\brief Called by the service thread at the deadline.
+
+			<h3>Return</h3>
+			true to expire again after interval.\n
+		*/
+		virtual bool expire() noexcept = 0;
+	};
+
+	/**
+		\brief The class that drives any number of timers from one thread
+		with a hierarchical timer wheel.
+
+		Entries are kept in 1 ms slots, 256 near slots then 4 levels of 64
+		coarser slots covering about 49 days, entries further away are 
+		placed in the last slot and moved when it comes up. Arming and 
+		cancelling is O(1), the thread sleeps until the earliest deadline 
+		of the next used slot (so expiry is not rounded to the slot) or the
+		next cascade, and sleeps without timeout when nothing is armed.\n\n
+
+		expire runs on the service thread without the service lock held, so
+		a handler may arm or cancel entries. Keep handlers short, all timers
+		of a service share the thread.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class timer_service
+	{
+	public:
+
+		/**
+			\brief The duration of one slot of the wheel.
+		*/
+		using tick = std::chrono::milliseconds;
+
+	private:
+
+		static constexpr unsigned near_bits = 8;
+		static constexpr unsigned far_bits = 6;
+		static constexpr unsigned far_levels = 4;
+		static constexpr std::size_t near_size = std::size_t(1) << near_bits;
+		static constexpr std::size_t far_size = std::size_t(1) << far_bits;
+		static constexpr std::uint64_t span = std::uint64_t(1) 
+			<< (near_bits + far_bits * far_levels);
+
+		std::mutex lock;
+		std::condition_variable wake;
+		std::condition_variable idle;
+		timer_entry* nearSlots[near_size] = {};
+		timer_entry* farSlots[far_levels][far_size] = {};
+		timer_clock* clock;
+		time_pt origin;
+		std::uint64_t current = 0;
+		std::size_t armed = 0;
+		bool quit = false;
+		bool running = false;
+		thread_config config;
+		std::thread worker;
+
+		std::uint64_t tick_of(time_pt pt) const noexcept
+		{
+			if (pt <= origin)
+				return 0;
+			return static_cast<std::uint64_t>((pt - origin) / tick(1));
+		}
+
+		static void link(timer_entry*& head, timer_entry& entry) noexcept
+		{
+			entry.prev = nullptr;
+			entry.next = head;
+			if (head)
+				head->prev = &entry;
+			head = &entry;
+			entry.slot = &head;
+		}
+
+		static void unlink(timer_entry& entry) noexcept
+		{
+			if (entry.prev)
+				entry.prev->next = entry.next;
+			else
+				*entry.slot = entry.next;
+			if (entry.next)
+				entry.next->prev = entry.prev;
+			entry.prev = entry.next = nullptr;
+			entry.slot = nullptr;
+		}
+
+		void insert(timer_entry& entry) noexcept
+		{
+			std::uint64_t at = tick_of(entry.deadline);
+			if (at < current)
+				at = current;
+			if (at - current >= span)
+				at = current + span - 1;
+			std::uint64_t delta = at - current;
+			if (delta < near_size)
+			{
+				link(nearSlots[at & (near_size - 1)], entry);
+				return;
+			}
+			unsigned level = 0;
+			while (delta >= (std::uint64_t(1) << (near_bits + far_bits * (level + 1))))
+				++level;
+			std::size_t index = static_cast<std::size_t>(
+				(at >> (near_bits + far_bits * level)) & (far_size - 1));
+			link(farSlots[level][index], entry);
+		}
+
+		// moves the entries of the coarser slots that come up at current
+		void cascade() noexcept
+		{
+			for (unsigned level = 0; level < far_levels; ++level)
+			{
+				unsigned shift = near_bits + far_bits * level;
+				if (current & ((std::uint64_t(1) << shift) - 1))
+					return;
+				std::size_t index = static_cast<std::size_t>((current >> shift) 
+					& (far_size - 1));
+				timer_entry* list = farSlots[level][index];
+				farSlots[level][index] = nullptr;
+				while (list)
+				{
+					timer_entry* entry = list;
+					list = list->next;
+					insert(*entry);
+				}
+				if (index)
+					return;
+			}
+		}
+
+		// the time to wake for the next used slot or cascade
+		time_pt next_wake() const noexcept
+		{
+			std::uint64_t end = (current | (near_size - 1)) + 1;
+			for (std::uint64_t at = current; at < end; ++at)
+			{
+				timer_entry* entry = nearSlots[at & (near_size - 1)];
+				if (!entry)
+					continue;
+				time_pt earliest = entry->deadline;
+				for (; entry; entry = entry->next)
+					if (entry->deadline < earliest)
+						earliest = entry->deadline;
+				return (earliest < origin + tick(end)) ? earliest : origin + tick(end);
+			}
+			return origin + tick(end);
+		}
+
+		// unlinks the entries due at now into due
+		void collect(time_pt now, timer_entry*& due) noexcept
+		{
+			std::uint64_t last = tick_of(now);
+			for (;;)
+			{
+				timer_entry* entry = nearSlots[current & (near_size - 1)];
+				while (entry)
+				{
+					timer_entry* following = entry->next;
+					if (entry->deadline <= now)
+					{
+						unlink(*entry);
+						entry->state = timer_entry::entry_state::firing;
+						--armed;
+						entry->next = due;
+						due = entry;
+					}
+					else if (tick_of(entry->deadline) > current)
+					{
+						// placed here from beyond the wheel, not due yet
+						unlink(*entry);
+						insert(*entry);
+					}
+					entry = following;
+				}
+				if (current >= last)
+					return;
+				++current;
+				cascade();
+			}
+		}
+
+		void run() noexcept
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			applyThreadConfig(config);
+			while (!quit)
+			{
+				if (armed == 0)
+				{
+					clock->service_wait(guard, wake, time_pt::max());
+					continue;
+				}
+				time_pt until = next_wake();
+				if (clock->now() < until)
+				{
+					clock->service_wait(guard, wake, until);
+					continue;
+				}
+				timer_entry* due = nullptr;
+				collect(clock->now(), due);
+				if (!due)
+					continue;
+				guard.unlock();
+				timer_entry* fired = due;
+				for (timer_entry* entry = due; entry; entry = entry->next)
+					entry->repeat = entry->expire();
+				guard.lock();
+				while (fired)
+				{
+					timer_entry* entry = fired;
+					fired = fired->next;
+					entry->next = nullptr;
+					if (entry->cancelled || !entry->repeat 
+						|| entry->interval <= high_res::duration::zero())
+						entry->state = timer_entry::entry_state::idle;
+					else
+					{
+						entry->deadline += entry->interval;
+						entry->state = timer_entry::entry_state::armed;
+						++armed;
+						insert(*entry);
+					}
+				}
+				idle.notify_all();
+			}
+		}
+
+	public:
+
+		/**
+			\brief Constructs the service, the thread starts on the first 
+			arm.
+		*/
+		timer_service() noexcept : timer_service(timer_clock::real()) {}
+
+		/**
+			\brief Constructs the service on clock clk, a virtual_clock to 
+			replay faster than real time.
+		*/
+		explicit timer_service(
+			timer_clock& clk /**< : <i>in</i> : The clock, must outlive the
+							 service.*/
+		) noexcept : clock(&clk), origin(clk.now()) {}
+
+		timer_service(const timer_service&) = delete;
+
+		timer_service& operator = (const timer_service&) = delete;
+
+		/**
+			\brief Stops and joins the service thread, entries still armed
+			never expire.
+		*/
+		~timer_service()
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				quit = true;
+			}
+			wake.notify_all();
+			if (worker.joinable())
+				worker.join();
+		}
+
+		/**
+			\brief Sets the placement, scheduling and name of the service 
+			thread, applied when it starts on the first arm.
+
+			<h3>Return</h3>
+			false if the thread already started, cfg is then not used.\n
+		*/
+		bool setThreadConfig(
+			thread_config cfg /**< : <i>in</i> : The configuration.*/
+		)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (running)
+				return false;
+			config = std::move(cfg);
+			return true;
+		}
+
+		/**
+			\brief The clock of the service.
+		*/
+		timer_clock& getClock() const noexcept { return *clock; }
+
+		/**
+			\brief The current time of the clock, to compute the deadlines of
+			waits on timers of the service.
+		*/
+		time_pt now() const noexcept { return clock->now(); }
+
+		/**
+			\brief The service shared by all timers of the program.
+		*/
+		static timer_service& shared()
+		{
+			static timer_service service;
+			return service;
+		}
+
+		/**
+			\brief Arms entry to expire at entry.deadline.
+
+			<h3>Return</h3>
+			false if entry is already armed or expiring.\n
+		*/
+		bool arm(
+			timer_entry& entry /**< : <i>in</i> : The entry, must outlive
+							   its arming.*/
+		)
+		{
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				if (entry.state != timer_entry::entry_state::idle)
+					return false;
+				entry.state = timer_entry::entry_state::armed;
+				entry.cancelled = false;
+				++armed;
+				insert(entry);
+				if (!running)
+				{
+					running = true;
+					worker = std::thread(&timer_service::run, this);
+				}
+			}
+			wake.notify_one();
+			return true;
+		}
+
+		/**
+			\brief Disarms entry, if expire is running on the service thread
+			it waits for it to return, unless called from the handler.
+
+			<h3>Return</h3>
+			true if entry was armed or expiring.\n
+		*/
+		bool cancel(
+			timer_entry& entry /**< : <i>in</i> : The entry.*/
+		)
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			if (entry.state == timer_entry::entry_state::idle)
+				return false;
+			if (entry.state == timer_entry::entry_state::armed)
+			{
+				unlink(entry);
+				entry.state = timer_entry::entry_state::idle;
+				--armed;
+				return true;
+			}
+			entry.cancelled = true;
+			if (std::this_thread::get_id() != worker.get_id())
+				idle.wait(guard, [&entry]() { 
+					return entry.state == timer_entry::entry_state::idle; });
+			return true;
+		}
+
+		/**
+			\brief Blocks till entry is neither armed nor expiring.
+		*/
+		void join(
+			timer_entry& entry /**< : <i>in</i> : The entry.*/
+		)
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			idle.wait(guard, [&entry]() {
+				return entry.state == timer_entry::entry_state::idle; });
+		}
+
+		/**
+			\brief Checks if entry is armed or expiring.
+		*/
+		bool isArmed(
+			const timer_entry& entry /**< : <i>in</i> : The entry.*/
+		)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			return entry.state != timer_entry::entry_state::idle;
+		}
+
+		/**
+			\brief The count of entries armed.
+		*/
+		std::size_t size()
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			return armed;
+		}
+	};
+
+
+	/**
+		\brief The class to signal threads blocked in a timer wait to stop
+		waiting at once, like a stop token.
+
+		Once cancel is called all waits given the event return false
+		immediately, till reset.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class cancel_event
+	{
+	public:
+
+		/**
+			\brief A blocked thread, its mutex and condition variable, kept
+			on its stack while attached.
+		*/
+		struct hook
+		{
+			std::mutex* lock;
+			std::condition_variable* wake;
+			hook* prev = nullptr;
+			hook* next = nullptr;
+
+			hook(std::mutex& mtx, std::condition_variable& cv) noexcept
+				: lock(&mtx), wake(&cv) {}
+		};
+
+	private:
+
+		std::atomic<bool> cancelled{ false };
+		std::mutex lock;
+		hook* hooks = nullptr;
+
+	public:
+
+		cancel_event() noexcept = default;
+
+		cancel_event(const cancel_event&) = delete;
+
+		cancel_event& operator = (const cancel_event&) = delete;
+
+		/**
+			\brief Sets the event and wakes all attached threads.
+		*/
+		inline void cancel() noexcept
+		{
+			cancelled.store(true);
+			std::lock_guard<std::mutex> guard(lock);
+			for (hook* at = hooks; at; at = at->next)
+			{
+				// under the waiter's mutex, so it is either waiting or yet
+				// to see the flag.
+				std::lock_guard<std::mutex> waiting(*at->lock);
+				at->wake->notify_all();
+			}
+		}
+
+		/**
+			\brief Clears the event for new waits.
+		*/
+		inline void reset() noexcept { cancelled.store(false); }
+
+		/**
+			\brief Checks if the event is set.
+		*/
+		inline bool isCancelled() const noexcept { return cancelled.load(); }
+
+		/**
+			\brief Attaches a blocked thread, the caller must not hold 
+			*at.lock.
+
+			<h3>Return</h3>
+			false if already cancelled, the hook is not attached.\n
+		*/
+		inline bool attach(
+			hook& at /**< : <i>in</i> : The hook.*/
+		) noexcept
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (cancelled.load())
+				return false;
+			at.prev = nullptr;
+			at.next = hooks;
+			if (hooks)
+				hooks->prev = &at;
+			hooks = &at;
+			return true;
+		}
+
+		/**
+			\brief Detaches an attached thread, the caller must not hold 
+			*at.lock.
+		*/
+		inline void detach(
+			hook& at /**< : <i>in</i> : The hook.*/
+		) noexcept
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (at.prev)
+				at.prev->next = at.next;
+			else
+				hooks = at.next;
+			if (at.next)
+				at.next->prev = at.prev;
+		}
+	};
+
+	/**
+		\brief The class to count cycles of a timer and block threads till a
+		count is reached.
+
+		A blocked thread keeps a node on its stack in a list sorted by target
+		count. advance only takes the mutex when the smallest target is 
+		reached and then wakes just the threads that are due, so many 
+		waiters for later counts cost nothing per cycle. An async_waiter 
+		(a suspended coroutine for example) is kept the same way and fired 
+		by advance after the mutex is released.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class cycle_count
+	{
+		/**
+			\brief A thread blocked in wait, kept on its stack.
+		*/
+		struct waiter
+		{
+			unsigned long long target;
+			bool done = false;
+			std::condition_variable wake;
+			timer_clock::sleeper* sleep = nullptr;
+			waiter* next = nullptr;
+		};
+
+	public:
+
+		/**
+			\brief A waiter that does not block, fired once the count reaches
+			target on the thread calling advance.
+
+			The waiter must stay alive till fired. fire is called with no
+			lock held so it may wait on the count again.
+		*/
+		struct async_waiter
+		{
+			unsigned long long target = 0;	/**< : The count to wait for.*/
+			void (*fire)(async_waiter&) noexcept = nullptr;	/**< : Called 
+											once target is reached.*/
+			async_waiter* next = nullptr;	/**< : The next waiter, used by 
+											cycle_count.*/
+		};
+
+	private:
+
+		/**
+			\brief The mutex to hold ownership over waiters.
+		*/
+		std::mutex lock;
+
+		/**
+			\brief The blocked threads, sorted by target.
+		*/
+		waiter* waiters = nullptr;
+
+		/**
+			\brief The async waiters, sorted by target.
+		*/
+		async_waiter* asyncWaiters = nullptr;
+
+		/**
+			\brief Sets nextTarget to the smallest target waited for, call with
+			lock held.
+		*/
+		inline void update_next() noexcept
+		{
+			unsigned long long next = ULLONG_MAX;
+			if (waiters)
+				next = waiters->target;
+			if (asyncWaiters && asyncWaiters->target < next)
+				next = asyncWaiters->target;
+			nextTarget.store(next);
+		}
+
+		/**
+			\brief The smallest target of waiters, ULLONG_MAX if none.
+		*/
+		std::atomic<unsigned long long> nextTarget;
+
+		/**
+			\brief The count.
+		*/
+		std::atomic<unsigned long long> cycles;
+
+		/**
+			\brief The clock of the waits, null for high_res.
+		*/
+		timer_clock* clock = nullptr;
+
+	public:
+
+		/**
+			\brief Constructs a count of 0.
+		*/
+		cycle_count() noexcept : nextTarget(ULLONG_MAX), cycles(0) {}
+
+		cycle_count(const cycle_count&) = delete;
+
+		cycle_count& operator = (const cycle_count&) = delete;
+
+		/**
+			\brief The count.
+		*/
+		inline unsigned long long load() const noexcept { return cycles.load(); }
+
+		/**
+			\brief Sets the count to 0, blocked threads keep their targets.
+		*/
+		inline void reset() noexcept { cycles.store(0); }
+
+		/**
+			\brief Sets the clock of the deadlines of waits, a virtual clock
+			also sees the threads blocked. Set before any wait.
+		*/
+		inline void setClock(
+			timer_clock* clk /**< : <i>in</i> : The clock, null for 
+							 high_res.*/
+		) noexcept
+		{
+			clock = (clk && clk->isVirtual()) ? clk : nullptr;
+		}
+
+		/**
+			\brief Adds by to the count and wakes the threads now due.
+
+			<h3>Return</h3>
+			The new count.\n
+		*/
+		inline unsigned long long advance(
+			unsigned long long by = 1 /**< : <i>in</i> : The increment.*/
+		) noexcept
+		{
+			unsigned long long now = cycles.fetch_add(by) + by;
+			if (now >= nextTarget.load())
+			{
+				async_waiter* fired = nullptr;
+				{
+					std::lock_guard<std::mutex> guard(lock);
+					while (waiters && waiters->target <= now)
+					{
+						waiter* due = waiters;
+						waiters = due->next;
+						due->done = true;
+						if (due->sleep)
+							due->sleep->release();
+						due->wake.notify_one();
+					}
+					async_waiter** last = &fired;
+					while (asyncWaiters && asyncWaiters->target <= now)
+					{
+						*last = asyncWaiters;
+						last = &asyncWaiters->next;
+						asyncWaiters = asyncWaiters->next;
+					}
+					*last = nullptr;
+					update_next();
+				}
+				while (fired)
+				{
+					async_waiter* due = fired;
+					fired = due->next;
+					due->fire(*due);
+				}
+			}
+			return now;
+		}
+
+		/**
+			\brief Blocks till the count is at least expected, or till 
+			deadline, or till ev is cancelled.
+
+			<h3>Return</h3>
+			true if the count was reached.\n
+		*/
+		inline bool wait_until(
+			unsigned long long expected /**< : <i>in</i> : The count to wait
+										for.*/,
+			time_pt deadline /**< : <i>in</i> : The latest time to wait till,
+							 time_pt::max() for none.*/,
+			cancel_event* ev /**< : <i>in</i> : The event to stop waiting, 
+							 may be null.*/
+		) noexcept
+		{
+			if (cycles.load() >= expected)
+				return true;
+			waiter self;
+			self.target = expected;
+			cancel_event::hook hook(lock, self.wake);
+			timer_clock::sleeper sleep(lock, self.wake, deadline);
+			if (ev && !ev->attach(hook))
+				return false;
+			bool reached = true;
+			bool attached = false;
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				waiter** at = &waiters;
+				while (*at && (*at)->target <= expected)
+					at = &(*at)->next;
+				self.next = *at;
+				*at = &self;
+				update_next();
+				// an advance that missed nextTarget is seen here.
+				if (cycles.load() < expected)
+				{
+					if (clock)
+					{
+						// attached once queued, so an advance releases it.
+						self.sleep = &sleep;
+						guard.unlock();
+						clock->attach(sleep);
+						attached = true;
+						guard.lock();
+					}
+					auto woken = [&self, &sleep, ev]() { 
+						return self.done || sleep.expired || (ev && ev->isCancelled()); };
+					if (deadline == time_pt::max() || attached)
+						self.wake.wait(guard, woken);
+					else
+						self.wake.wait_until(guard, deadline, woken);
+				}
+				if (!self.done)
+				{
+					for (at = &waiters; *at != &self; at = &(*at)->next);
+					*at = self.next;
+					update_next();
+					reached = cycles.load() >= expected;
+				}
+			}
+			if (attached)
+				clock->detach(sleep);
+			if (ev)
+				ev->detach(hook);
+			return reached;
+		}
+
+		/**
+			\brief Blocks till the count is at least expected.
+
+			<h3>Return</h3>
+			The count when woken.\n
+		*/
+		inline unsigned long long wait(
+			unsigned long long expected /**< : <i>in</i> : The count to wait
+										for.*/
+		) noexcept
+		{
+			wait_until(expected, time_pt::max(), nullptr);
+			return cycles.load();
+		}
+
+		/**
+			\brief Adds w to be fired once the count reaches w.target, without
+			blocking.
+
+			<h3>Return</h3>
+			false if the count already reached w.target, w is then not 
+			added and not fired.\n
+		*/
+		inline bool wait_async(
+			async_waiter& w /**< : <i>in</i> : The waiter, with target and 
+							fire set.*/
+		) noexcept
+		{
+			if (cycles.load() >= w.target)
+				return false;
+			std::lock_guard<std::mutex> guard(lock);
+			async_waiter** at = &asyncWaiters;
+			while (*at && (*at)->target <= w.target)
+				at = &(*at)->next;
+			w.next = *at;
+			*at = &w;
+			update_next();
+			// an advance that missed nextTarget is seen here.
+			if (cycles.load() >= w.target)
+			{
+				*at = w.next;
+				update_next();
+				return false;
+			}
+			return true;
+		}
+	};
+
+	/**
+		\brief The class to run a function once after a delay or every 
+		period, on the thread of a timer_service.
+
+		The handler runs on the service thread and holds up every other
+		timer of that service while it runs, to run long work elsewhere post
+		it to a queued_process (see enh::post_handler in 
+		queued_process.enh.h). Cancelling is O(1).\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class callback_timer : public timer_entry
+	{
+		/**
+			\brief The service running the handler.
+		*/
+		timer_service* service;
+
+		/**
+			\brief The function to run.
+		*/
+		std::function<void()> handler;
+
+		bool expire() noexcept override
+		{
+			handler();
+			return interval > high_res::duration::zero();
+		}
+
+	public:
+
+		/**
+			\brief Constructs an idle timer of service serv.
+		*/
+		explicit callback_timer(
+			timer_service& serv = timer_service::shared() /**< : <i>in</i> :
+								The service, must outlive the timer.*/
+		) noexcept : service(&serv) {}
+
+		/**
+			\brief Cancels the timer, waiting for a running handler.
+		*/
+		~callback_timer()
+		{
+			cancel();
+		}
+
+		/**
+			\brief Runs func once after delay.
+
+			<h3>Return</h3>
+			false if the timer is already running, nothing is changed.\n
+		*/
+		template<class Rep, class Period>
+		bool start_after(
+			std::chrono::duration<Rep, Period> delay /**< : <i>in</i> : The 
+													 delay.*/,
+			std::function<void()> func /**< : <i>in</i> : The handler.*/
+		)
+		{
+			if (service->isArmed(*this))
+				return false;
+			handler = std::move(func);
+			deadline = service->now() 
+				+ std::chrono::duration_cast<high_res::duration>(delay);
+			interval = high_res::duration::zero();
+			return service->arm(*this);
+		}
+
+		/**
+			\brief Runs func every period, the first time after first.
+
+			<h3>Return</h3>
+			false if the timer is already running or period is not positive,
+			nothing is changed.\n
+		*/
+		template<class Rep, class Period, class FRep = Rep, class FPeriod = Period>
+		bool start_every(
+			std::chrono::duration<Rep, Period> period /**< : <i>in</i> : The 
+													  period.*/,
+			std::function<void()> func /**< : <i>in</i> : The handler.*/,
+			std::chrono::duration<FRep, FPeriod> first 
+				= std::chrono::duration<FRep, FPeriod>::zero() /**< : <i>in</i> 
+												: The first delay, 0 for
+												period.*/
+		)
+		{
+			auto every = std::chrono::duration_cast<high_res::duration>(period);
+			if (every <= high_res::duration::zero() || service->isArmed(*this))
+				return false;
+			handler = std::move(func);
+			auto delay = std::chrono::duration_cast<high_res::duration>(first);
+			deadline = service->now() 
+				+ (delay > high_res::duration::zero() ? delay : every);
+			interval = every;
+			return service->arm(*this);
+		}
+
+		/**
+			\brief Stops the timer, if the handler is running on another 
+			thread, waits for it to return.
+
+			May be called from the handler to stop a periodic timer.
+
+			<h3>Return</h3>
+			true if the timer was running.\n
+		*/
+		inline bool cancel()
+		{
+			return service->cancel(*this);
+		}
+
+		/**
+			\brief Checks if the timer is waiting or running its handler.
+		*/
+		inline bool isArmed()
+		{
+			return service->isArmed(*this);
+		}
+	};
+
+
+	/**
+		\brief What a timer does when a notification is a period or more 
+		late.
+	*/
+	enum class overrun_policy
+	{
+		catch_up,			/**< : Notify once for each period missed, in a 
+							burst (default).*/
+		skip				/**< : Notify once, adding all periods missed 
+							to the elapsed cycles, and keep to the 
+							schedule from there.*/
+	};
+
+	/**
+		\brief The statistics of a timer, see enh::timer::stats.
+	*/
+	struct timer_stats
+	{
+		/**
+			\brief The lateness of the notifications in nanoseconds, max is
+			the largest lateness.
+		*/
+		histogram_snapshot lateness;
+
+		/**
+			\brief The count of notifications sent.
+		*/
+		std::uint64_t ticks = 0;
+
+		/**
+			\brief The count of periods that passed before their 
+			notification could be sent, skipped or sent late in a burst.
+		*/
+		std::uint64_t missed = 0;
+	};
+
 	/**
 		\brief The class to create a timer that notifies all clients periodically.
 
@@ -125,6 +1557,17 @@ namespace enh
 		But the template can be instanciated with nanoseconds and microseconds,
 		but object cannot be created.
 
+		The timer has no thread of its own, it is an entry of a timer_service
+		(timer_service::shared() by default), so many timers cost one 
+		thread.
+
+		To place or name the thread, call timer_service::setThreadConfig 
+		before the first timer of the service starts.
+
+		With C++20 coroutines (ENH_HAS_COROUTINES), `co_await tm.next_tick()`
+		and `co_await tm.sleep(n)` suspend a coroutine instead of blocking a
+		thread.
+
 
 		hasErrorHandlers        = false;\n
 		
@@ -184,21 +1627,9 @@ namespace enh
 
 
 		/**
-			\brief The mutex to hold ownership over @ref elapsed_cycles and
-			the notifier.
-		*/
-		std::mutex mtxTimer;
-
-		/**
-			\brief The condition_variable to notify all client threads about 
-			the end of that period.
-		*/
-		std::condition_variable cvTimer;
-
-		/**
-			\brief The variable to signal the end of the timer loop, set by 
-			any control thread and read by the timer thread to stop execution
-			and return.
+			\brief The variable to signal the end of the timer, set by 
+			any control thread and read at the next notification to stop 
+			the timer.
 		*/
 		std::atomic<bool> stopTimer;
 
@@ -208,53 +1639,81 @@ namespace enh
 
 			The product of this and period gives time elapsed.
 		*/
-		unsigned long long elapsed_cycles;
+		cycle_count elapsed_cycles;
+
+		/**
+			\brief The entry of the timer in the service.
+		*/
+		struct tick_entry : timer_entry
+		{
+			timer* owner;
 
+			explicit tick_entry(timer* own) noexcept : owner(own) {}
+
+			bool expire() noexcept override { return owner->single_period(); }
+		};
 
 		/**
-			\brief the thread handle to the thread running the timer function.
+			\brief The service driving the timer.
 		*/
-		std::thread timerThread;
+		timer_service* service;
 
 		/**
-			\brief true if timer thread is running.
+			\brief The registration of the timer in service.
 		*/
-		bool isTimerActive;
+		tick_entry entry;
 
+		/**
+			\brief true if timer is registered.
+		*/
+		bool isTimerActive;
 
+		/**
+			\brief What to do when late by a period or more.
+		*/
+		std::atomic<overrun_policy> overrun{ overrun_policy::catch_up };
 
 		/**
-			\brief Blocks execution till the time point described in 
-			timer_next.
+			\brief The lateness of each notification in nanoseconds.
+		*/
+		log_histogram lateness;
 
-			And then notifies the waiting threads.
+		/**
+			\brief The count of periods missed.
 		*/
-		inline void single_period() noexcept
-		{
-			std::this_thread::sleep_until(timer_next);
-			{
-				std::lock_guard<std::mutex> lock(mtxTimer);
-				++elapsed_cycles;
-				timer_next += unit(period);
-			}
-			cvTimer.notify_all();
-		}
+		std::atomic<std::uint64_t> missedTicks{ 0 };
+
 
 
 		/**
-			\brief keeps on executing single_period until the time when 
-			stopTimer is set.
+			\brief Called by the service at timer_next, notifies the waiting
+			threads.
+
+			<h3>Return</h3>
+			false if the timer is to stop.\n
 		*/
-		void loop() noexcept
+		inline bool single_period() noexcept
 		{
-			clear_stop();
-			elapsed_cycles = 0;
-			timer_start = high_res::now();
-			timer_next = timer_start + unit(period);
-			while (!stopTimer.load())
+			auto late = service->now() - timer_next;
+			if (late < high_res::duration::zero())
+				late = high_res::duration::zero();
+			lateness.record(static_cast<std::uint64_t>(std::chrono::duration_cast<
+				std::chrono::nanoseconds>(late).count()));
+			auto missed = static_cast<unsigned long long>(late / unit(period));
+			unsigned long long by = 1;
+			if (missed && overrun.load(std::memory_order_relaxed) == overrun_policy::skip)
 			{
-				single_period();
+				missedTicks.fetch_add(missed, std::memory_order_relaxed);
+				by += missed;
+				timer_next += unit(period) * missed;
+				entry.deadline += entry.interval * missed;
 			}
+			else if (missed)
+				missedTicks.fetch_add(1, std::memory_order_relaxed);	// sent in the burst.
+			timer_next += unit(period);
+			elapsed_cycles.advance(by);
+			LIB_TRACE_INSTANT("timer tick");
+			return !stopTimer.load();
 		}
 
 	public:
@@ -267,12 +1726,24 @@ namespace enh
 
 			Constructor fails assert if it is not a time type > ms.
 		*/
-		inline timer() noexcept
+		inline timer() noexcept : timer(timer_service::shared()) {}
+
+		/**
+			\brief The constructor of the class, for a timer driven by 
+			timer service serv.
+
+			Starts the timer as the default constructor.
+		*/
+		inline explicit timer(
+			timer_service& serv /**< : <i>in</i> : The service, must outlive
+								the timer.*/
+		) noexcept : service(&serv), entry(this)
 		{
 			static_assert(isGoodTimer_v<unit>, "unit type must be std::chrono::milliseconds, seconds or hours");
 			isTimerActive = false;
 			clear_stop();
-			elapsed_cycles = 0;
+			elapsed_cycles.reset();
+			elapsed_cycles.setClock(&serv.getClock());
 			start_timer();
 		}
 		
@@ -280,7 +1751,8 @@ namespace enh
 		/**
 			\brief destructor of the class.
 
-			invokes enh::timer::force_join, waits till the timer Thread joins.
+			invokes enh::timer::force_join, removing the timer from its 
+			service.
 		*/
 		inline ~timer() noexcept
 		{
@@ -293,6 +1765,9 @@ namespace enh
 
 			Invokes enh::timer::start_timer if timer is not active.
 
+			The thread is only woken by the notification that reaches 
+			expected, not by every notification.
+
 			<h3>Return</h3>
 			The difference between elapsed 
 			cycles and expected (the "overshoot").\n
@@ -304,12 +1779,7 @@ namespace enh
 		{
 			if (!isTimerActive)
 				start_timer();
-			std::unique_lock<std::mutex> lock(mtxTimer);
-			cvTimer.wait(lock,
-				[expected, this]() {
-					return elapsed_cycles >= expected;
-				});
-			return (elapsed_cycles - expected);
+			return elapsed_cycles.wait(expected) - expected;
 		}
 
 		/**
@@ -323,8 +1793,88 @@ namespace enh
 		*/
 		inline unsigned long long wait() noexcept
 		{
-			return wait(elapsed_cycles + 1);
+			return wait(elapsed_cycles.load() + 1);
+		}
+
+#ifdef ENH_HAS_COROUTINES
+		/**
+			\brief The awaitable of next_tick and sleep.
+
+			The coroutine is resumed on the timer service thread by the tick
+			that reaches the count, so it holds up the other timers of the 
+			service till it suspends again. `co_await` gives the overshoot, 
+			like wait.\n\n
+
+			hasErrorHandlers        = false;\n
+		*/
+		class tick_awaiter : cycle_count::async_waiter
+		{
+			friend class timer;
+
+			cycle_count* count;
+			std::coroutine_handle<> handle;
+
+			static void resume(cycle_count::async_waiter& w) noexcept
+			{
+				static_cast<tick_awaiter&>(w).handle.resume();
+			}
+
+			tick_awaiter(cycle_count& cc, unsigned long long expected) noexcept
+				: count(&cc)
+			{
+				target = expected;
+				fire = &tick_awaiter::resume;
+			}
+
+		public:
+
+			bool await_ready() const noexcept { return count->load() >= target; }
+
+			bool await_suspend(std::coroutine_handle<> h) noexcept
+			{
+				handle = h;
+				return count->wait_async(*this);
+			}
+
+			unsigned long long await_resume() const noexcept 
+			{ 
+				return count->load() - target; 
+			}
+		};
+
+		/**
+			\brief Suspends the calling coroutine till the elapsed cycles reach
+			the current count + 1, without blocking a thread.
+			
+			Starts the timer if not active.
+
+			<h3>Return</h3>
+			The awaitable, `co_await` it once.\n
+		*/
+		inline tick_awaiter next_tick() noexcept
+		{
+			return sleep(1);
+		}
+
+		/**
+			\brief Suspends the calling coroutine for cycles, without blocking
+			a thread.
+
+			Starts the timer if not active. The timer must outlive the 
+			coroutine suspended on it.
+
+			<h3>Return</h3>
+			The awaitable, `co_await` it once.\n
+		*/
+		inline tick_awaiter sleep(
+			unsigned long long cycles /**< : <i>in</i> : The cycles to wait.*/
+		) noexcept
+		{
+			if (!isTimerActive)
+				start_timer();
+			return tick_awaiter(elapsed_cycles, elapsed_cycles.load() + cycles);
 		}
+#endif
 
 		/**
 			\brief The function blocks for a certian cycles unless the
@@ -346,16 +1896,62 @@ namespace enh
 											to exit immediately.*/
 		) noexcept
 		{
-			unsigned long long expected = elapsed_cycles + mult_count;
-			while (elapsed_cycles < expected)
+			unsigned long long expected = elapsed_cycles.load() + mult_count;
+			while (elapsed_cycles.load() < expected)
 			{
 				if (!condition())
 					return -1;
 				wait();
 			}
-			return elapsed_cycles - expected;
+			return elapsed_cycles.load() - expected;
 		}
 		
+		/**
+			\brief Blocks till expected cycles elapsed, deadline passes or
+			stop is cancelled, whichever is first.
+
+			Unlike the wait_for with a condition, stop wakes the thread at 
+			once, not at the next cycle, and nothing is polled.
+
+			<h3>Return</h3>
+			-1 if stop was cancelled or deadline passed first. The overshoot
+			if it did not.\n
+		*/
+		inline long long wait_until(
+			unsigned long long expected /**< : <i>in</i> : The expected cycle
+										count to wait till.*/,
+			cancel_event& stop /**< : <i>in</i> : The event to stop waiting.*/,
+			time_pt deadline = time_pt::max() /**< : <i>in</i> : The latest 
+											  time to wait till, on the 
+											  clock of the service.*/
+		) noexcept
+		{
+			if (!isTimerActive)
+				start_timer();
+			if (!elapsed_cycles.wait_until(expected, deadline, &stop))
+				return -1;
+			return elapsed_cycles.load() - expected;
+		}
+
+		/**
+			\brief Blocks for mult_count cycles unless deadline passes or stop
+			is cancelled first, see wait_until.
+
+			<h3>Return</h3>
+			-1 if stop was cancelled or deadline passed first. The overshoot
+			if it did not.\n
+		*/
+		inline long long wait_for(
+			unsigned mult_count /**< : <i>in</i> : The amount of cycles to 
+								wait.*/,
+			cancel_event& stop /**< : <i>in</i> : The event to stop waiting.*/,
+			time_pt deadline = time_pt::max() /**< : <i>in</i> : The latest 
+											  time to wait till.*/
+		) noexcept
+		{
+			return wait_until(elapsed_cycles.load() + mult_count, stop, deadline);
+		}
+
 		/**
 			\brief sets stopTimer to true.
 		*/
@@ -385,7 +1981,7 @@ namespace enh
 		/**
 			\brief Returns the number of cycles elapsed from timer start.
 		*/
-		inline unsigned long long elapsed() noexcept { return elapsed_cycles; }
+		inline unsigned long long elapsed() noexcept { return elapsed_cycles.load(); }
 
 		/**
 			\brief blocks function execution for mult_count number of cycles.
@@ -396,7 +1992,40 @@ namespace enh
 			unsigned long mult_count /**< : <i>in</i> : The cycles to wait for.*/
 		)noexcept
 		{
-			return wait(elapsed_cycles + mult_count);
+			return wait(elapsed_cycles.load() + mult_count);
+		}
+
+		/**
+			\brief Sets what the timer does when a notification is a period
+			or more late, see enh::overrun_policy.
+		*/
+		inline void setOverrunPolicy(
+			overrun_policy policy /**< : <i>in</i> : The policy.*/
+		) noexcept
+		{
+			overrun.store(policy, std::memory_order_relaxed);
+		}
+
+		/**
+			\brief The lateness, notification count and missed periods since
+			start or resetStats.
+		*/
+		inline timer_stats stats() const
+		{
+			timer_stats ret;
+			ret.lateness = lateness.snapshot();
+			ret.ticks = ret.lateness.count;
+			ret.missed = missedTicks.load(std::memory_order_relaxed);
+			return ret;
+		}
+
+		/**
+			\brief Clears the statistics.
+		*/
+		inline void resetStats() noexcept
+		{
+			lateness.reset();
+			missedTicks.store(0, std::memory_order_relaxed);
 		}
 
 		/**
@@ -408,28 +2037,16 @@ namespace enh
 		*/
 		inline bool isTimerCounting()
 		{
-			if (isTimerActive)
-			{
-				// isTimer Active is true, thread has finished but thread has 
-				// not been joined.
-				if (timerThread.joinable())
-				{
-					timerThread.join();
-					isTimerActive = false;
-					return false;
-				}
-				else
-					return true;
-			}
-			else
-				return false;
+			if (isTimerActive && !service->isArmed(entry))
+				isTimerActive = false;	// stopped at the last notification.
+			return isTimerActive;
 		}
 
 		/**
 			\brief The function to start timer.
 
 			The function clears the stopTimer flag, sets elapsed_cycles to 
-			0 and then allocates a thread for the timer.
+			0 and then arms the timer in its service.
 
 			<h3>Return</h3>
 			Returns false if timer is already running.
@@ -440,8 +2057,12 @@ namespace enh
 				return false;
 			O3_LIB_LOG_LINE;
 			clear_stop();
-			elapsed_cycles = 0;
-			timerThread = std::thread(&timer<period, unit>::loop, this);
+			elapsed_cycles.reset();
+			timer_start = service->now();
+			timer_next = timer_start + unit(period);
+			entry.deadline = timer_next;
+			entry.interval = std::chrono::duration_cast<high_res::duration>(unit(period));
+			service->arm(entry);
 			isTimerActive = true;
 			return true;
 		}
@@ -456,29 +2077,30 @@ namespace enh
 		}
 
 		/**
-			\brief Waits till timerThread finishes execution.
+			\brief Waits till the timer stops.
 
-			The function blocks till the timer Thread joins.
+			The function blocks till the notification after stop.
 			
-			If the timer Thread is empty, it returns immediately.
+			If the timer is not running, it returns immediately.
 		*/
 		inline void join() noexcept
 		{
 			if (isTimerCounting())
 			{
-				timerThread.join();
+				service->join(entry);
 				isTimerActive = false;
 			}
 		}
 
 		/**
-			\brief sets stopTimer flag to true, then waits for thread to 
-			join via enh::timer::join.
+			\brief sets stopTimer flag to true, and removes the timer from 
+			its service without waiting for the next notification.
 		*/
 		inline void force_join() noexcept
 		{
 			stop();
-			join();
+			service->cancel(entry);
+			isTimerActive = false;
 			return ;
 		}
 	};
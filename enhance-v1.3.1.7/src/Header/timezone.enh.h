@@ -0,0 +1,675 @@
+/** ***************************************************************************
+	\file timezone.enh.h
+
+	\brief The file to declare class time_zone for cached local time
+	conversion
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+******************************************************************************/
+
+#ifndef TIMEZONE_ENH_H
+
+#define TIMEZONE_ENH_H					timezone.enh.h
+
+#include "calendar.enh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace enh
+{
+
+	/**
+		\brief The class for the rules of a time zone, as a table of
+		transitions, converting UTC to local time without libc.
+
+		The rules are loaded once (from a TZif file such as
+		/usr/share/zoneinfo/Europe/London, or a POSIX TZ string) into sorted
+		arrays of transition times and offsets. The POSIX rule at the end of
+		a TZif file, or of a TZ string, is expanded into transitions up to
+		the year 2200, later times are worked out from the rule.\n\n
+
+		offsetAt is a binary search, skipped when the time is in the same
+		interval as the last lookup of the calling thread (kept in a
+		thread_local cache), which is the case for nearly all consecutive
+		time stamps. The object is immutable after construction, so it can
+		be shared between threads.\n\n
+
+		hasErrorHandlers        = false;\n
+	*/
+	class time_zone
+	{
+		/**
+			\brief The UTC seconds of each transition, ascending.
+		*/
+		std::vector<std::int64_t> at;
+
+		/**
+			\brief The offset from UTC in seconds from at[i].
+		*/
+		std::vector<std::int32_t> offsets;
+
+		/**
+			\brief 1 if daylight saving from at[i].
+		*/
+		std::vector<unsigned char> dst;
+
+		/**
+			\brief The offset before the first transition.
+		*/
+		std::int32_t initialOffset = 0;
+
+		/**
+			\brief Daylight saving before the first transition.
+		*/
+		bool initialDst = false;
+
+		/**
+			\brief The identity of the rules for the thread cache, copies share
+			it as they hold the same rules.
+		*/
+		std::uint64_t id = 0;
+
+		/**
+			\brief The last interval looked up by a thread.
+		*/
+		struct cache_entry
+		{
+			std::uint64_t zone = 0;
+			std::int64_t from = 0;
+			std::int64_t to = 0;
+			std::int32_t offset = 0;
+			bool isDst = false;
+		};
+
+		static inline cache_entry& cache() noexcept
+		{
+			thread_local cache_entry entry;
+			return entry;
+		}
+
+		static inline std::uint64_t next_id() noexcept
+		{
+			static std::atomic<std::uint64_t> next{ 1 };
+			return next.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/**
+			\brief The last year transitions are generated for from a POSIX
+			rule.
+		*/
+		static constexpr long long last_rule_year = 2200;
+
+		/**
+			\brief A start or end date of a POSIX rule.
+		*/
+		struct rule_date
+		{
+			char kind = 'M';
+			int month = 0;
+			int week = 0;
+			int day = 0;
+			std::int32_t time = 7200;
+		};
+
+		/**
+			\brief A POSIX TZ rule (offsets east of UTC).
+		*/
+		struct posix_rule
+		{
+			std::int32_t stdOffset = 0;
+			std::int32_t dstOffset = 0;
+			bool hasDst = false;
+			rule_date start;
+			rule_date end;
+		};
+
+		/**
+			\brief The rule in effect after the last transition, used past
+			last_rule_year when it has daylight saving.
+		*/
+		posix_rule tail;
+
+		/**
+			\brief Reads a number at pos.
+
+			<h3>Return</h3>
+			-1 if there is no digit.\n
+		*/
+		static inline long read_number(std::string_view s, std::size_t& pos) noexcept
+		{
+			if (pos >= s.size() || s[pos] < '0' || s[pos] > '9')
+				return -1;
+			long v = 0;
+			while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9' && v < 100000)
+				v = v * 10 + (s[pos++] - '0');
+			return v;
+		}
+
+		/**
+			\brief Reads [+-]hh[:mm[:ss]] at pos as seconds.
+		*/
+		static inline bool read_hms(std::string_view s, std::size_t& pos,
+			std::int32_t& out) noexcept
+		{
+			int sign = 1;
+			if (pos < s.size() && (s[pos] == '+' || s[pos] == '-'))
+				sign = (s[pos++] == '-') ? -1 : 1;
+			long h = read_number(s, pos);
+			if (h < 0 || h > 167)
+				return false;
+			long m = 0, sec = 0;
+			if (pos < s.size() && s[pos] == ':')
+			{
+				++pos;
+				if ((m = read_number(s, pos)) < 0 || m > 59)
+					return false;
+				if (pos < s.size() && s[pos] == ':')
+				{
+					++pos;
+					if ((sec = read_number(s, pos)) < 0 || sec > 59)
+						return false;
+				}
+			}
+			out = static_cast<std::int32_t>(sign * (h * 3600 + m * 60 + sec));
+			return true;
+		}
+
+		/**
+			\brief Skips a zone abbreviation at pos.
+		*/
+		static inline bool skip_name(std::string_view s, std::size_t& pos) noexcept
+		{
+			if (pos < s.size() && s[pos] == '<')
+			{
+				std::size_t close = s.find('>', pos);
+				if (close == std::string_view::npos)
+					return false;
+				pos = close + 1;
+				return true;
+			}
+			std::size_t start = pos;
+			while (pos < s.size() && ((s[pos] >= 'A' && s[pos] <= 'Z')
+				|| (s[pos] >= 'a' && s[pos] <= 'z')))
+				++pos;
+			return pos > start;
+		}
+
+		/**
+			\brief Reads a rule date ( Jn, n or Mm.w.d, then /time ) at pos.
+		*/
+		static inline bool read_rule_date(std::string_view s, std::size_t& pos,
+			rule_date& out) noexcept
+		{
+			if (pos < s.size() && s[pos] == 'M')
+			{
+				++pos;
+				out.kind = 'M';
+				out.month = static_cast<int>(read_number(s, pos));
+				if (pos >= s.size() || s[pos++] != '.')
+					return false;
+				out.week = static_cast<int>(read_number(s, pos));
+				if (pos >= s.size() || s[pos++] != '.')
+					return false;
+				out.day = static_cast<int>(read_number(s, pos));
+				if (out.month < 1 || out.month > 12 || out.week < 1 || out.week > 5
+					|| out.day < 0 || out.day > 6)
+					return false;
+			}
+			else
+			{
+				out.kind = 'D';
+				if (pos < s.size() && s[pos] == 'J')
+				{
+					out.kind = 'J';
+					++pos;
+				}
+				out.day = static_cast<int>(read_number(s, pos));
+				if (out.day < 0 || out.day > 365 || (out.kind == 'J' && out.day < 1))
+					return false;
+			}
+			out.time = 7200;
+			if (pos < s.size() && s[pos] == '/')
+			{
+				++pos;
+				return read_hms(s, pos, out.time);
+			}
+			return true;
+		}
+
+		/**
+			\brief Reads a POSIX TZ string such as CET-1CEST,M3.5.0,M10.5.0/3.
+		*/
+		static inline bool read_posix(std::string_view s, posix_rule& out) noexcept
+		{
+			std::size_t pos = 0;
+			std::int32_t west = 0;
+			if (!skip_name(s, pos) || !read_hms(s, pos, west))
+				return false;
+			out.stdOffset = -west;
+			out.hasDst = false;
+			if (pos == s.size())
+				return true;
+			if (!skip_name(s, pos))
+				return false;
+			out.hasDst = true;
+			out.dstOffset = out.stdOffset + 3600;
+			if (pos < s.size() && s[pos] != ',')
+			{
+				if (!read_hms(s, pos, west))
+					return false;
+				out.dstOffset = -west;
+			}
+			if (pos == s.size())
+			{
+				out.start = { 'M', 3, 2, 0, 7200 };
+				out.end = { 'M', 11, 1, 0, 7200 };
+				return true;
+			}
+			if (s[pos++] != ',' || !read_rule_date(s, pos, out.start)
+				|| pos >= s.size() || s[pos++] != ',' || !read_rule_date(s, pos, out.end))
+				return false;
+			return pos == s.size();
+		}
+
+		/**
+			\brief The days from 01 January 1970 of rule date d in year yr.
+		*/
+		static inline long long rule_day(const rule_date& d, long long yr) noexcept
+		{
+			long long jan1 = days_from_civil(yr, 0, 1);
+			if (d.kind == 'J')
+				return jan1 + d.day - 1 + ((is_leap_year(yr) && d.day >= 60) ? 1 : 0);
+			if (d.kind == 'D')
+				return jan1 + d.day;
+			long long first = days_from_civil(yr, static_cast<unsigned short>(d.month - 1), 1);
+			long long next = (d.month == 12) ? days_from_civil(yr + 1, 0, 1)
+				: days_from_civil(yr, static_cast<unsigned short>(d.month), 1);
+			long long day = first + (d.day - weekday_from_days(first) + 7) % 7
+				+ (d.week - 1) * 7LL;
+			while (day >= next)
+				day -= 7;
+			return day;
+		}
+
+		/**
+			\brief The UTC times daylight saving starts (on) and ends (off)
+			in year yr.
+		*/
+		static inline void year_points(const posix_rule& rule, long long yr,
+			std::int64_t& on, std::int64_t& off) noexcept
+		{
+			on = rule_day(rule.start, yr) * 86400LL + rule.start.time - rule.stdOffset;
+			off = rule_day(rule.end, yr) * 86400LL + rule.end.time - rule.dstOffset;
+		}
+
+		/**
+			\brief Fills c with the interval of utc under tail, for times past
+			the table.
+		*/
+		inline void tail_lookup(std::int64_t utc, cache_entry& c) const noexcept
+		{
+			std::int64_t day = utc / 86400 - ((utc % 86400 < 0) ? 1 : 0);
+			long long yr = civil_from_days(day).year;
+			std::int64_t pts[6];
+			bool pdst[6];
+			for (int k = 0; k < 3; ++k)
+			{
+				year_points(tail, yr - 1 + k, pts[2 * k], pts[2 * k + 1]);
+				pdst[2 * k] = true;
+				pdst[2 * k + 1] = false;
+			}
+			std::int64_t from = std::numeric_limits<std::int64_t>::min();
+			std::int64_t to = std::numeric_limits<std::int64_t>::max();
+			bool isDst = false;
+			for (int k = 0; k < 6; ++k)
+			{
+				if (pts[k] <= utc && pts[k] >= from)
+				{
+					from = pts[k];
+					isDst = pdst[k];
+				}
+				else if (pts[k] > utc && pts[k] < to)
+					to = pts[k];
+			}
+			c.from = from;
+			c.to = to;
+			c.isDst = isDst;
+			c.offset = isDst ? tail.dstOffset : tail.stdOffset;
+		}
+
+		/**
+			\brief Appends the transitions of rule after the last transition,
+			till last_rule_year.
+		*/
+		inline void expand(const posix_rule& rule)
+		{
+			if (!rule.hasDst)
+			{
+				if (at.empty())
+				{
+					initialOffset = rule.stdOffset;
+					initialDst = false;
+				}
+				else if (offsets.back() != rule.stdOffset || dst.back())
+				{
+					at.push_back(at.back() + 1);
+					offsets.push_back(rule.stdOffset);
+					dst.push_back(0);
+				}
+				return;
+			}
+			std::int64_t after = at.empty() ? std::numeric_limits<std::int64_t>::min()
+				: at.back();
+			long long firstYear = at.empty() ? 1900
+				: civil_from_days(at.back() / 86400).year;
+			tail = rule;
+			if (at.empty())
+			{
+				initialOffset = rule.stdOffset;
+				initialDst = false;
+			}
+			for (long long yr = firstYear; yr <= last_rule_year; ++yr)
+			{
+				std::int64_t on, off;
+				year_points(rule, yr, on, off);
+				std::int64_t first = std::min(on, off), second = std::max(on, off);
+				bool firstDst = (first == on);
+				if (first > after)
+				{
+					at.push_back(first);
+					offsets.push_back(firstDst ? rule.dstOffset : rule.stdOffset);
+					dst.push_back(firstDst ? 1 : 0);
+				}
+				if (second > after)
+				{
+					at.push_back(second);
+					offsets.push_back(firstDst ? rule.stdOffset : rule.dstOffset);
+					dst.push_back(firstDst ? 0 : 1);
+				}
+			}
+		}
+
+		static inline std::int64_t read_be(const unsigned char* p, int bytes) noexcept
+		{
+			std::uint64_t v = 0;
+			for (int i = 0; i < bytes; ++i)
+				v = (v << 8) | p[i];
+			if (bytes == 4)
+				return static_cast<std::int32_t>(static_cast<std::uint32_t>(v));
+			return static_cast<std::int64_t>(v);
+		}
+
+	public:
+
+		/**
+			\brief Constructs UTC.
+		*/
+		inline time_zone() : id(next_id()) {}
+
+		/**
+			\brief A zone of a fixed offset.
+		*/
+		static inline time_zone fixed(
+			std::int32_t offset /**< : <i>in</i> : The offset east of UTC in
+								seconds.*/,
+			bool isDst = false /**< : <i>in</i> : If it is daylight saving.*/
+		)
+		{
+			time_zone tz;
+			tz.initialOffset = offset;
+			tz.initialDst = isDst;
+			return tz;
+		}
+
+		/**
+			\brief Builds the zone from a POSIX TZ string, such as
+			EST5EDT,M3.2.0,M11.1.0.
+
+			<h3>Return</h3>
+			false if the string is not valid.\n
+		*/
+		static inline bool fromPosix(
+			std::string_view rule /**< : <i>in</i> : The TZ string.*/,
+			time_zone& out /**< : <i>out</i> : The zone.*/
+		)
+		{
+			posix_rule parsed;
+			if (!read_posix(rule, parsed))
+				return false;
+			time_zone tz;
+			tz.expand(parsed);
+			out = std::move(tz);
+			return true;
+		}
+
+		/**
+			\brief Builds the zone from the contents of a TZif file (RFC 8536,
+			versions 1 to 4).
+
+			<h3>Return</h3>
+			false if the data is not valid.\n
+		*/
+		static inline bool fromTZif(
+			const char* data /**< : <i>in</i> : The file contents.*/,
+			std::size_t size /**< : <i>in</i> : The size of data.*/,
+			time_zone& out /**< : <i>out</i> : The zone.*/
+		)
+		{
+			const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+			const unsigned char* end = p + size;
+			auto header = [&](const unsigned char* h, std::int64_t* counts)
+			{
+				if (end - h < 44 || h[0] != 'T' || h[1] != 'Z' || h[2] != 'i' || h[3] != 'f')
+					return false;
+				for (int i = 0; i < 6; ++i)
+					counts[i] = read_be(h + 20 + 4 * i, 4);
+				for (int i = 0; i < 6; ++i)
+					if (counts[i] < 0)
+						return false;
+				return true;
+			};
+			std::int64_t c[6];
+			if (!header(p, c))
+				return false;
+			int timeBytes = 4;
+			const unsigned char* block = p + 44;
+			auto blockSize = [&](int tb)
+			{
+				return c[3] * tb + c[3] + c[4] * 6 + c[5] + c[2] * (tb + 4) + c[1] + c[0];
+			};
+			if (p[4] >= '2')
+			{
+				if (end - block < blockSize(4))
+					return false;
+				block += blockSize(4);
+				if (!header(block, c))
+					return false;
+				block += 44;
+				timeBytes = 8;
+			}
+			if (end - block < blockSize(timeBytes) || c[4] == 0)
+				return false;
+			const unsigned char* times = block;
+			const unsigned char* idx = times + c[3] * timeBytes;
+			const unsigned char* types = idx + c[3];
+			time_zone tz;
+			tz.initialOffset = static_cast<std::int32_t>(read_be(types, 4));
+			tz.initialDst = types[4] != 0;
+			tz.at.reserve(static_cast<std::size_t>(c[3]));
+			for (std::int64_t i = 0; i < c[3]; ++i)
+			{
+				if (idx[i] >= c[4])
+					return false;
+				const unsigned char* t = types + idx[i] * 6;
+				tz.at.push_back(read_be(times + i * timeBytes, timeBytes));
+				tz.offsets.push_back(static_cast<std::int32_t>(read_be(t, 4)));
+				tz.dst.push_back(t[4]);
+			}
+			const unsigned char* footer = block + blockSize(timeBytes);
+			if (timeBytes == 8 && end - footer > 1 && footer[0] == '\n')
+			{
+				const unsigned char* close = std::find(footer + 1, end, '\n');
+				std::string_view rule(reinterpret_cast<const char*>(footer + 1),
+					static_cast<std::size_t>(close - footer - 1));
+				posix_rule parsed;
+				if (!rule.empty() && read_posix(rule, parsed))
+					tz.expand(parsed);
+			}
+			out = std::move(tz);
+			return true;
+		}
+
+		/**
+			\brief Builds the zone from a TZif file.
+
+			<h3>Return</h3>
+			false if the file can not be read or is not valid.\n
+		*/
+		static inline bool fromFile(
+			const std::string& path /**< : <i>in</i> : The path of the file.*/,
+			time_zone& out /**< : <i>out</i> : The zone.*/
+		)
+		{
+			std::ifstream file(path, std::ios::binary);
+			if (!file)
+				return false;
+			std::vector<char> data((std::istreambuf_iterator<char>(file)),
+				std::istreambuf_iterator<char>());
+			return fromTZif(data.data(), data.size(), out);
+		}
+
+		/**
+			\brief Builds the zone from a name of the tz database, such as
+			Asia/Kolkata, read from /usr/share/zoneinfo.
+
+			<h3>Return</h3>
+			false if it can not be found.\n
+		*/
+		static inline bool fromName(
+			const std::string& name /**< : <i>in</i> : The zone name.*/,
+			time_zone& out /**< : <i>out</i> : The zone.*/
+		)
+		{
+			if (name.empty() || name.find("..") != std::string::npos)
+				return false;
+			return fromFile("/usr/share/zoneinfo/" + name, out);
+		}
+
+		/**
+			\brief The zone of the process, loaded at the first call, then
+			never reloaded.
+
+			Uses the TZ environment variable (a zone name or a POSIX string),
+			then /etc/localtime. On Windows, where there is no tz database,
+			it is the offset libc reports at the first call, held fixed.
+			UTC if nothing is found.
+		*/
+		static inline const time_zone& local()
+		{
+			static const time_zone zone = []()
+			{
+				time_zone tz;
+#if defined(_WIN32)
+				std::time_t now = std::time(nullptr);
+				std::tm l{}, g{};
+				localtime_s(&l, &now);
+				gmtime_s(&g, &now);
+				std::int64_t diff = (days_from_civil(l.tm_year + 1900LL,
+					static_cast<unsigned short>(l.tm_mon), static_cast<unsigned short>(l.tm_mday))
+					- days_from_civil(g.tm_year + 1900LL, static_cast<unsigned short>(g.tm_mon),
+					static_cast<unsigned short>(g.tm_mday))) * 86400LL
+					+ (l.tm_hour - g.tm_hour) * 3600LL + (l.tm_min - g.tm_min) * 60LL
+					+ (l.tm_sec - g.tm_sec);
+				tz = fixed(static_cast<std::int32_t>(diff), l.tm_isdst > 0);
+#else
+				const char* env = std::getenv("TZ");
+				if (env && *env)
+				{
+					std::string name(env[0] == ':' ? env + 1 : env);
+					if (name[0] == '/' ? fromFile(name, tz) : fromName(name, tz))
+						return tz;
+					if (fromPosix(name, tz))
+						return tz;
+				}
+				fromFile("/etc/localtime", tz);
+#endif
+				return tz;
+			}();
+			return zone;
+		}
+
+		/**
+			\brief The offset east of UTC in seconds at UTC time utc.
+		*/
+		inline std::int32_t offsetAt(
+			std::int64_t utc /**< : <i>in</i> : The seconds from the unix
+							 epoch.*/,
+			bool* isDst = nullptr /**< : <i>out</i> : Set to true if daylight
+								  saving, if not nullptr.*/
+		) const noexcept
+		{
+			cache_entry& c = cache();
+			if (c.zone != id || utc < c.from || utc >= c.to)
+			{
+				std::size_t i = static_cast<std::size_t>(
+					std::upper_bound(at.begin(), at.end(), utc) - at.begin());
+				c.zone = id;
+				c.from = (i > 0) ? at[i - 1] : std::numeric_limits<std::int64_t>::min();
+				c.to = (i < at.size()) ? at[i] : std::numeric_limits<std::int64_t>::max();
+				c.offset = (i > 0) ? offsets[i - 1] : initialOffset;
+				c.isDst = (i > 0) ? (dst[i - 1] != 0) : initialDst;
+				if (i == at.size() && tail.hasDst)
+					tail_lookup(utc, c);
+			}
+			if (isDst)
+				*isDst = c.isDst;
+			return c.offset;
+		}
+
+		/**
+			\brief The local time, as seconds from the epoch, of UTC time utc.
+		*/
+		inline std::int64_t toLocal(
+			std::int64_t utc /**< : <i>in</i> : The seconds from the unix
+							 epoch.*/
+		) const noexcept
+		{
+			return utc + offsetAt(utc);
+		}
+
+		/**
+			\brief The number of transitions in the table.
+		*/
+		inline std::size_t transitionCount() const noexcept { return at.size(); }
+	};
+}
+
+#endif
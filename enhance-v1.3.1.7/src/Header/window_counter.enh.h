@@ -0,0 +1,328 @@
+/** ***************************************************************************
+	\file window_counter.enh.h
+
+	\brief The file to declare class window_counter, events and rates over
+	a rolling window of intervals
+
+	Created 15 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+
+******************************************************************************/
+
+#ifndef WINDOW_COUNTER_ENH_H
+
+#define WINDOW_COUNTER_ENH_H					window_counter.enh.h
+
+#include "fast_clock.enh.h"
+#include "timer.enh.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace enh
+{
+
+	/**
+		\brief The class to count events over a rolling window, for rates
+		such as events a second over the last 1, 5 and 15 minutes.
+
+		The window is a ring of buckets, one per interval. Each bucket is
+		one atomic word holding the interval it counts (24 bits) and the
+		count (40 bits), so no head or lock is shared. add reads Clock and
+		does one relaxed fetch_add on the bucket of the interval. Only the
+		first add of an interval, finding the bucket still holding an older
+		one, resets it with a compare exchange. Reads add up the buckets of
+		the intervals asked for, O(buckets) loads without allocating.\n\n
+
+		Buckets are opened lazily by the first add of their interval. Call
+		start_advancing to have the timer service open the next bucket
+		ahead of time instead, so adds never reset. That drops the oldest
+		bucket just before it leaves the window, so the window is then
+		buckets - 1 whole intervals and the current one.\n\n
+
+		Clock is coarse_clock by default, one relaxed load once
+		coarse_clock::start is called. An add racing the end of an interval,
+		or delayed by a whole turn of the ring, may be counted in the next
+		interval. A bucket untouched for a multiple of 2^24 intervals is
+		read as current, which start_advancing rules out. At most 2^40 - 1
+		events fit in one interval.\n\n
+
+		hasErrorHandlers        = false;\n
+
+		<h3>template</h3>
+		-#  <code>std::size_t buckets</code> : The intervals in the window,
+		at least 2.\n
+		-#  <code>class Clock</code> : The clock of the intervals, steady.\n
+	*/
+	template<std::size_t buckets = 60, class Clock = coarse_clock>
+	class window_counter
+	{
+		static_assert(buckets > 1, "buckets must be at least 2");
+
+		static constexpr unsigned count_bits = 40;
+		static constexpr std::uint64_t count_mask = (1ULL << count_bits) - 1;
+		static constexpr std::uint64_t tag_mask = (1ULL << (64 - count_bits)) - 1;
+
+		/**
+			\brief The nanoseconds of an interval.
+		*/
+		std::int64_t widthNs;
+
+		/**
+			\brief The start of interval 0.
+		*/
+		typename Clock::time_point origin;
+
+		/**
+			\brief The buckets, interval i in ring[i % buckets].
+		*/
+		std::atomic<std::uint64_t> ring[buckets];
+
+		/**
+			\brief The timer opening the next bucket, see start_advancing.
+		*/
+		callback_timer ticker;
+
+		static constexpr std::uint64_t tag_of(std::int64_t interval) noexcept
+		{
+			return static_cast<std::uint64_t>(interval) & tag_mask;
+		}
+
+		static constexpr std::uint64_t pack(std::int64_t interval, std::uint64_t n) noexcept
+		{
+			return (tag_of(interval) << count_bits) | (n & count_mask);
+		}
+
+		// how many intervals the bucket word w is behind interval, 0 if it
+		// holds it, above half the tags if it holds a later one
+		static constexpr std::uint64_t behind(std::uint64_t w, std::int64_t interval) noexcept
+		{
+			return (tag_of(interval) - (w >> count_bits)) & tag_mask;
+		}
+
+		static constexpr bool is_later(std::uint64_t lag) noexcept
+		{
+			return lag > (tag_mask >> 1);
+		}
+
+		inline std::int64_t elapsed_ns(typename Clock::time_point now) const noexcept
+		{
+			std::int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+				now - origin).count();
+			return (ns > 0) ? ns : 0;
+		}
+
+		/**
+			\brief Resets the bucket of interval if it holds an earlier one.
+		*/
+		inline void open(
+			std::int64_t interval /**< : <i>in</i> : The interval.*/
+		) noexcept
+		{
+			std::atomic<std::uint64_t>& b = ring[static_cast<std::size_t>(interval) % buckets];
+			std::uint64_t w = b.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				std::uint64_t lag = behind(w, interval);
+				if (lag == 0 || is_later(lag))
+					return;
+				if (b.compare_exchange_weak(w, pack(interval, 0), std::memory_order_relaxed))
+					return;
+			}
+		}
+
+		/**
+			\brief The events of the intervals - 1 before interval at and at.
+		*/
+		inline std::uint64_t count_at(
+			std::int64_t at /**< : <i>in</i> : The last interval.*/,
+			std::size_t intervals /**< : <i>in</i> : The intervals, at most
+								  buckets.*/
+		) const noexcept
+		{
+			std::uint64_t sum = 0;
+			for (const auto& b : ring)
+			{
+				std::uint64_t w = b.load(std::memory_order_relaxed);
+				if (behind(w, at) < intervals)
+					sum += w & count_mask;
+			}
+			return sum;
+		}
+
+	public:
+
+		/**
+			\brief Constructs an empty window of buckets intervals of width.
+		*/
+		template<class Rep = long long, class Period = std::ratio<1>>
+		inline explicit window_counter(
+			std::chrono::duration<Rep, Period> width
+				= std::chrono::seconds(1) /**< : <i>in</i> : The interval,
+										  positive.*/,
+			timer_service& serv = timer_service::shared() /**< : <i>in</i> :
+								The service of start_advancing, must outlive
+								the counter.*/
+		) noexcept : widthNs(std::max<std::int64_t>(1,
+				std::chrono::duration_cast<std::chrono::nanoseconds>(width).count())),
+			origin(Clock::now()), ticker(serv)
+		{
+			// interval 0 open, every other bucket a full turn behind
+			ring[0].store(pack(0, 0), std::memory_order_relaxed);
+			for (std::size_t i = 1; i < buckets; ++i)
+				ring[i].store(pack(static_cast<std::int64_t>(i)
+					- static_cast<std::int64_t>(buckets), 0), std::memory_order_relaxed);
+		}
+
+		window_counter(const window_counter&) = delete;
+
+		window_counter& operator = (const window_counter&) = delete;
+
+		/**
+			\brief Counts n events now, lock-free.
+		*/
+		inline void add(
+			std::uint64_t n = 1 /**< : <i>in</i> : The events.*/
+		) noexcept
+		{
+			std::int64_t at = elapsed_ns(Clock::now()) / widthNs;
+			std::atomic<std::uint64_t>& b = ring[static_cast<std::size_t>(at) % buckets];
+			std::uint64_t w = b.fetch_add(n, std::memory_order_relaxed);
+			if (behind(w, at) == 0)
+				return;
+			// the bucket held an earlier interval, n went into its count
+			w += n;
+			for (;;)
+			{
+				std::uint64_t lag = behind(w, at);
+				// opened by another add, which dropped n with the old count
+				if (lag == 0)
+				{
+					b.fetch_add(n, std::memory_order_relaxed);
+					return;
+				}
+				// this add was late, n stays in the later interval
+				if (is_later(lag))
+					return;
+				if (b.compare_exchange_weak(w, pack(at, n), std::memory_order_relaxed))
+					return;
+			}
+		}
+
+		/**
+			\brief Adds 1 event, see add.
+		*/
+		inline window_counter& operator ++ () noexcept
+		{
+			add(1);
+			return *this;
+		}
+
+		/**
+			\brief The events of the current interval and the intervals - 1
+			before it (at most buckets).
+		*/
+		inline std::uint64_t count(
+			std::size_t intervals = buckets /**< : <i>in</i> : The intervals
+											to add up.*/
+		) const noexcept
+		{
+			std::int64_t at = elapsed_ns(Clock::now()) / widthNs;
+			return count_at(at, std::min(intervals, buckets));
+		}
+
+		/**
+			\brief The events a second over the current interval and the
+			intervals - 1 before it, the part of the current interval gone
+			by is counted as its length.
+		*/
+		inline double rate(
+			std::size_t intervals = buckets /**< : <i>in</i> : The intervals
+											to add up.*/
+		) const noexcept
+		{
+			intervals = std::clamp<std::size_t>(intervals, 1, buckets);
+			std::int64_t ns = elapsed_ns(Clock::now());
+			std::int64_t at = ns / widthNs;
+			std::int64_t span = std::min(ns,
+				static_cast<std::int64_t>(intervals - 1) * widthNs + ns % widthNs);
+			if (span <= 0)
+				return 0.0;
+			return static_cast<double>(count_at(at, intervals)) * 1e9 / static_cast<double>(span);
+		}
+
+		/**
+			\brief The events a second over the last span, rounded up to
+			whole intervals, see rate.
+		*/
+		template<class Rep, class Period>
+		inline double rate_over(
+			std::chrono::duration<Rep, Period> span /**< : <i>in</i> : The
+													time to average over.*/
+		) const noexcept
+		{
+			std::int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(span).count();
+			return rate(static_cast<std::size_t>(std::max<std::int64_t>(1,
+				(ns + widthNs - 1) / widthNs)));
+		}
+
+		/**
+			\brief Opens the bucket of the next interval, so the adds in it
+			are one fetch_add each. Called by start_advancing every interval,
+			may also be called from any other periodic task.
+		*/
+		inline void advance() noexcept
+		{
+			open(elapsed_ns(Clock::now()) / widthNs + 1);
+		}
+
+		/**
+			\brief Calls advance every interval on the timer service.
+
+			<h3>Return</h3>
+			false if already advancing.\n
+		*/
+		inline bool start_advancing()
+		{
+			advance();
+			return ticker.start_every(std::chrono::nanoseconds(widthNs), [this]() { advance(); });
+		}
+
+		/**
+			\brief Stops start_advancing, waiting for a running advance.
+		*/
+		inline void stop_advancing()
+		{
+			ticker.cancel();
+		}
+
+		/**
+			\brief The length of an interval.
+		*/
+		inline std::chrono::nanoseconds width() const noexcept
+		{
+			return std::chrono::nanoseconds(widthNs);
+		}
+	};
+}
+
+#endif
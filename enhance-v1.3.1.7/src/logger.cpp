@@ -27,55 +27,2576 @@
 #include "header/logger.enh.h"
 
 #if  defined(ENH_DEBUG_CONTROL) && (ENH_OPTIMISATION < 5)
+#include "header/ring_buffer.enh.h"
+
+#include <algorithm>
+#include <deque>
 #include <map>
 #include <fstream>
 #include <exception>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#ifndef ENH_LOG_QUEUE_SIZE
+#define ENH_LOG_QUEUE_SIZE				8192
+#endif
+
+#ifndef ENH_LOG_BUFFER_SIZE
+#define ENH_LOG_BUFFER_SIZE				65536
+#endif
+
+#ifndef ENH_LOG_SITE_REGION
+#define ENH_LOG_SITE_REGION				65536
+#endif
+
+#ifndef ENH_LOG_CRASH_RINGS
+#define ENH_LOG_CRASH_RINGS				256
+#endif
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef ENH_LOG_ZSTD
+#include <zstd.h>
+#endif
+
+#ifndef ENH_LOG_URING_BUFFER
+#define ENH_LOG_URING_BUFFER			262144
+#endif
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// IORING_OP_WRITE is in the headers of Linux 5.6 and later, as is this
+#ifdef IORING_FEAT_RW_CUR_POS
+#define ENH_LOG_URING
+#include <cerrno>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+#endif
+
+
+// To store thread id based log-file, sharded so registering threads rarely contend
+class thread_registry
+{
+	static constexpr std::size_t shard_count = 16;
+
+	struct alignas(enh::cache_line_size) shard
+	{
+		std::mutex mtx;
+		std::unordered_map<std::thread::id, std::string> call_info;
+	};
+
+	shard shards[shard_count];
+
+	shard& shard_of(std::thread::id id)
+	{
+		return shards[std::hash<std::thread::id>()(id) % shard_count];
+	}
+
+public:
+	// setup will indicate if id was not registered previously
+	std::string find_or_add(bool& setup, const std::string& function, std::thread::id id)
+	{
+		shard& sh = shard_of(id);
+		std::lock_guard<std::mutex> lock(sh.mtx);
+		auto res = sh.call_info.try_emplace(id, function);
+		setup = res.second;
+		return res.first->second;
+	}
+
+	std::vector<std::pair<std::thread::id, std::string>> list()
+	{
+		std::vector<std::pair<std::thread::id, std::string>> ret;
+		for (auto& sh : shards)
+		{
+			std::lock_guard<std::mutex> lock(sh.mtx);
+			ret.insert(ret.end(), sh.call_info.begin(), sh.call_info.end());
+		}
+		return ret;
+	}
+};
 
+thread_registry& threads()
+{
+	static thread_registry instance;
+	return instance;
+}
+
+// The function this thread was registered with, lookups by a thread of itself 
+// touch no shared state after the first.
+struct thread_name
+{
+	bool known = false;
+	std::string function;
+};
+
+thread_local thread_name ownName;
 
 // setup will indicate if no file existed previously
 std::string Register(bool& setup, std::string function, std::thread::id id = std::this_thread::get_id())
 {
-	static std::map<std::thread::id, std::string> call_info; // To store thread id based log-file
-	std::string ret;
 	setup = false;
-	try {
-		ret = call_info.at(id);
-	}
-	catch (std::out_of_range)
+	bool self = (id == std::this_thread::get_id());
+	if (self && ownName.known)
+		return ownName.function;
+	std::string ret = threads().find_or_add(setup, function, id);
+	if (self)
 	{
-		call_info.emplace(id, function);
-		ret = function;
-		setup = true;
+		ownName.function = ret;
+		ownName.known = true;
 	}
 	return ret;
 }
 
-//write to path
-void write(std::string buff, std::filesystem::path file)
+// What the index of a binary file needs of a chunk of records, see 
+// segment_index
+struct index_note
+{
+	// time and site of the timed record, 0 if none
+	std::int64_t time = 0;
+	std::uint32_t site = 0;
+	// positions in the chunk of its thread and site records, -1 if none
+	std::int32_t threadAt = -1;
+	std::int32_t siteAt = -1;
+};
+
+// A preformatted line (or encoded binary records) and the file it goes to
+struct log_record
+{
+	std::filesystem::path file;
+	std::string line;
+	bool binary = false;
+	index_note note{};
+	// if set, line holds the raw value logged at site and format formats it
+	const debug::call_site* site = nullptr;
+	debug::value_formatter format = nullptr;
+	// calls of site the record stands for, see debug::setSiteSampling
+	std::uint32_t weight = 1;
+};
+
+// the text layout of a record
+void stream_site(std::ostream& out, std::string_view file, std::string_view function, unsigned long line)
 {
-	std::ofstream out(file, std::ios::app | std::ios::out);
-	out << buff << "\n";
+	out << std::setw(80) << file << " : " << std::setw(6) << line << "   " << std::setw(15) << function;
 }
 
-std::filesystem::path debug::getFile(std::thread::id id, std::string function)
+// The format records are written in
+std::atomic<debug::log_format> format{ debug::log_format::text };
+
+// Bytes of the flight recorder ring of each thread, 0 when off
+std::atomic<std::size_t> recorderSize{ 0 };
+
+// Time between flushes of buffered log files in nanoseconds, 0 flushes every line
+std::atomic<long long> flushInterval{ std::chrono::nanoseconds(std::chrono::milliseconds(100)).count() };
+
+// The compression files are opened with, see debug::setCompression
+struct compression_setup
 {
-	auto file = std::filesystem::path("");
-	std::ostringstream out;
-	bool setup = false;
-	out << id << "_thread_fn_" << Register(setup, function, id) << ".log";
-	file = out.str();
-	if (setup)
+	debug::log_compression method = debug::log_compression::none;
+	int level = 3;
+#ifdef ENH_LOG_ZSTD
+	ZSTD_CDict* dict = nullptr;
+
+	~compression_setup() { ZSTD_freeCDict(dict); }
+#endif
+};
+
+class compression_state
+{
+	std::mutex mtx;
+	std::shared_ptr<const compression_setup> current = std::make_shared<compression_setup>();
+
+public:
+	// read by every open, so the suffix check touches no lock
+	std::atomic<bool> active{ false };
+
+	void set(std::shared_ptr<const compression_setup> in)
 	{
-		std::ostringstream buff;
-		buff << "Thread id : " << id << "\n\t\tthread first logging function " << function;
-		write(buff.str(), file);
+		std::lock_guard<std::mutex> lock(mtx);
+		active = in->method != debug::log_compression::none;
+		current = std::move(in);
 	}
+
+	std::shared_ptr<const compression_setup> get()
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return current;
+	}
+};
+
+compression_state& compression()
+{
+	static compression_state instance;
+	return instance;
+}
+
+// the file on disk for the log file path
+std::filesystem::path stored_path(std::filesystem::path file)
+{
+	if (compression().active.load(std::memory_order_relaxed))
+		file += ".zst";
 	return file;
 }
 
-void debug::Log(std::string lg, std::string function)
+// the index of a binary file, see segment_index
+std::filesystem::path index_path(std::filesystem::path file)
+{
+	file += ".idx";
+	return file;
+}
+
+#ifdef ENH_LOG_ZSTD
+// Compresses what is written to it, each sync (or full buffer) becoming one
+// zstd frame written to the file buffer below, so a file cut short loses at
+// most the frame being written.
+class frame_buf : public std::streambuf
+{
+	std::streambuf* file = nullptr;
+	std::vector<char> in;
+	std::vector<char> out;
+	ZSTD_CCtx* ctx = nullptr;
+	std::shared_ptr<const compression_setup> setup;
+
+	// compresses the put area as one frame
+	bool emit()
+	{
+		std::size_t size = static_cast<std::size_t>(pptr() - pbase());
+		if (size == 0)
+			return true;
+		std::size_t packed = setup->dict
+			? ZSTD_compress_usingCDict(ctx, out.data(), out.size(), pbase(), size, setup->dict)
+			: ZSTD_compressCCtx(ctx, out.data(), out.size(), pbase(), size, setup->level);
+		setp(in.data(), in.data() + in.size());
+		if (ZSTD_isError(packed))
+			return false;
+		return file->sputn(out.data(), static_cast<std::streamsize>(packed))
+			== static_cast<std::streamsize>(packed);
+	}
+
+protected:
+	int_type overflow(int_type ch) override
+	{
+		if (!emit())
+			return traits_type::eof();
+		if (!traits_type::eq_int_type(ch, traits_type::eof()))
+		{
+			*pptr() = traits_type::to_char_type(ch);
+			pbump(1);
+		}
+		return traits_type::not_eof(ch);
+	}
+
+	int sync() override
+	{
+		return emit() && file->pubsync() == 0 ? 0 : -1;
+	}
+
+public:
+	~frame_buf()
+	{
+		close();
+		ZSTD_freeCCtx(ctx);
+	}
+
+	// compresses into below, an open file buffer
+	bool open(std::streambuf* below, std::shared_ptr<const compression_setup> with)
+	{
+		close();
+		setup = std::move(with);
+		if (!ctx)
+			ctx = ZSTD_createCCtx();
+		in.resize(ENH_LOG_BUFFER_SIZE);
+		out.resize(ZSTD_compressBound(in.size()));
+		setp(in.data(), in.data() + in.size());
+		file = below;
+		return ctx != nullptr;
+	}
+
+	// writes out the last frame, below stays open
+	void close()
+	{
+		if (!file)
+			return;
+		sync();
+		file = nullptr;
+	}
+};
+#endif
+
+// The backend files of the asynchronous writer are written with, see 
+// debug::setWriteBackend
+std::atomic<debug::write_backend> backend{ debug::write_backend::stream };
+std::atomic<bool> directIO{ false };
+
+#ifdef ENH_LOG_URING
+// An io_uring instance set up with raw system calls, used by one thread
+class uring
+{
+	int fd = -1;
+	void* rings = MAP_FAILED;
+	std::size_t ringsSize = 0;
+	io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+	std::size_t sqesSize = 0;
+	unsigned* sqTail = nullptr;
+	unsigned* sqMask = nullptr;
+	unsigned* sqArray = nullptr;
+	unsigned* cqHead = nullptr;
+	unsigned* cqTail = nullptr;
+	unsigned* cqMask = nullptr;
+	io_uring_cqe* cqes = nullptr;
+	unsigned unsubmitted = 0;
+
+public:
+	uring() = default;
+
+	uring(const uring&) = delete;
+
+	bool ready() const { return fd >= 0; }
+
+	bool setup(unsigned entries)
+	{
+		io_uring_params params{};
+		fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+		if (fd < 0)
+			return false;
+		if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+		{
+			close(fd);
+			fd = -1;
+			return false;
+		}
+		ringsSize = std::max<std::size_t>(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+			params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+		rings = mmap(nullptr, ringsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+		sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+		sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+		if (rings == MAP_FAILED || sqes == MAP_FAILED)
+		{
+			release();
+			return false;
+		}
+		char* base = static_cast<char*>(rings);
+		sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+		sqMask = reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+		sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+		cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+		cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+		cqMask = reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+		cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+		return true;
+	}
+
+	// true if the buffers can be written with IORING_OP_WRITE_FIXED, fails 
+	// past RLIMIT_MEMLOCK
+	bool register_buffers(const iovec* buffers, unsigned count)
+	{
+		return syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+	}
+
+	// queues a write of size bytes of data at offset, fixed is the index of
+	// a registered buffer or -1
+	void write(int file, const char* data, unsigned size, std::uint64_t offset, int fixed, std::uint64_t tag)
+	{
+		// only this thread produces, the kernel reads the tail
+		unsigned tail = *sqTail;
+		unsigned index = tail & *sqMask;
+		io_uring_sqe& sqe = sqes[index];
+		std::memset(&sqe, 0, sizeof(sqe));
+		sqe.opcode = fixed >= 0 ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+		sqe.fd = file;
+		sqe.addr = reinterpret_cast<std::uint64_t>(data);
+		sqe.len = size;
+		sqe.off = offset;
+		sqe.buf_index = static_cast<std::uint16_t>(fixed >= 0 ? fixed : 0);
+		sqe.user_data = tag;
+		sqArray[index] = index;
+		__atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+		++unsubmitted;
+	}
+
+	// submits queued writes, waiting for wait completions
+	bool enter(unsigned wait)
+	{
+		while (true)
+		{
+			long done = syscall(__NR_io_uring_enter, fd, unsubmitted, wait,
+				wait ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+			if (done >= 0)
+			{
+				unsubmitted -= static_cast<unsigned>(done);
+				return true;
+			}
+			if (errno != EINTR)
+				return false;
+		}
+	}
+
+	bool pop(io_uring_cqe& out)
+	{
+		unsigned head = *cqHead;
+		if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+			return false;
+		out = cqes[head & *cqMask];
+		__atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+		return true;
+	}
+
+	void release()
+	{
+		if (sqes != MAP_FAILED)
+			munmap(sqes, sqesSize);
+		if (rings != MAP_FAILED)
+			munmap(rings, ringsSize);
+		if (fd >= 0)
+			close(fd);
+		sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+		rings = MAP_FAILED;
+		fd = -1;
+	}
+
+	~uring() { release(); }
+};
+
+// writes all of size bytes of data at offset, for what a ring write left
+bool write_all(int file, const char* data, std::size_t size, std::uint64_t offset)
+{
+	while (size != 0)
+	{
+		ssize_t done = pwrite(file, data, size, static_cast<off_t>(offset));
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			return false;
+		data += done;
+		size -= static_cast<std::size_t>(done);
+		offset += static_cast<std::uint64_t>(done);
+	}
+	return true;
+}
+
+// Writes through io_uring from two aligned buffers, one filling while the
+// other is written, optionally with O_DIRECT. Under O_DIRECT only whole 
+// blocks go through the ring, a sync writes the part of a block left with 
+// pwrite and keeps it in the buffer, the block is written whole later.
+class uring_buf : public std::streambuf
+{
+	static constexpr std::size_t block = 4096;
+	static constexpr std::size_t capacity = (ENH_LOG_URING_BUFFER + block - 1) / block * block;
+
+	struct buffer
+	{
+		char* data = nullptr;
+		bool busy = false;
+		unsigned size = 0;
+		std::uint64_t at = 0;
+	};
+
+	uring ring;
+	buffer buffers[2];
+	int current = 0;
+	bool fixed = false;
+	int file = -1;
+	// the file without O_DIRECT, for partial blocks, -1 if not direct
+	int plainFile = -1;
+	// offset of the current buffer in the file, a multiple of block if direct
+	std::uint64_t offset = 0;
+	bool failed = false;
+
+	void submit(int index, unsigned size)
+	{
+		buffer& buf = buffers[index];
+		buf.busy = true;
+		buf.size = size;
+		buf.at = offset;
+		ring.write(file, buf.data, size, offset, fixed ? index : -1, static_cast<std::uint64_t>(index));
+		if (!ring.enter(0))
+			failed = true;
+	}
+
+	// takes a completion, waiting for it if none is there
+	void reap()
+	{
+		io_uring_cqe cqe;
+		if (!ring.pop(cqe) && (!ring.enter(1) || !ring.pop(cqe)))
+		{
+			failed = true;
+			return;
+		}
+		buffer& buf = buffers[cqe.user_data & 1];
+		buf.busy = false;
+		// a short or failed write is finished without the ring
+		std::size_t done = cqe.res > 0 ? static_cast<std::size_t>(cqe.res) : 0;
+		if (done < buf.size && !write_all(plainFile >= 0 ? plainFile : file,
+			buf.data + done, buf.size - done, buf.at + done))
+			failed = true;
+	}
+
+	void wait_for(int index)
+	{
+		while (buffers[index].busy && !failed)
+			reap();
+		buffers[index].busy = false;
+	}
+
+	// submits size bytes of the current buffer and moves to the other
+	void flip(std::size_t size)
+	{
+		if (size != 0)
+			submit(current, static_cast<unsigned>(size));
+		offset += size;
+		current ^= 1;
+		wait_for(current);
+		setp(buffers[current].data, buffers[current].data + capacity);
+	}
+
+protected:
+	int_type overflow(int_type ch) override
+	{
+		flip(static_cast<std::size_t>(pptr() - pbase()));
+		if (!traits_type::eq_int_type(ch, traits_type::eof()))
+		{
+			*pptr() = traits_type::to_char_type(ch);
+			pbump(1);
+		}
+		return failed ? traits_type::eof() : traits_type::not_eof(ch);
+	}
+
+	int sync() override
+	{
+		std::size_t size = static_cast<std::size_t>(pptr() - pbase());
+		if (plainFile < 0)
+			flip(size);
+		else
+		{
+			std::size_t whole = size / block * block;
+			std::size_t part = size - whole;
+			if (part != 0 && !write_all(plainFile, pbase() + whole, part, offset + whole))
+				failed = true;
+			if (whole != 0)
+			{
+				// the part goes on at the start of the other buffer
+				const char* left = pbase() + whole;
+				flip(whole);
+				std::memcpy(pbase(), left, part);
+				pbump(static_cast<int>(part));
+			}
+		}
+		wait_for(current ^ 1);
+		return failed ? -1 : 0;
+	}
+
+public:
+	uring_buf() = default;
+
+	uring_buf(const uring_buf&) = delete;
+
+	// false if io_uring is not usable, the file is not opened then
+	bool open(const std::filesystem::path& path, bool direct)
+	{
+		close();
+		if (!ring.ready())
+		{
+			if (!ring.setup(4))
+				return false;
+			iovec vec[2];
+			for (int i = 0; i < 2; ++i)
+			{
+				buffers[i].data = static_cast<char*>(std::aligned_alloc(block, capacity));
+				if (!buffers[i].data)
+				{
+					ring.release();
+					return false;
+				}
+				vec[i] = { buffers[i].data, capacity };
+			}
+			fixed = ring.register_buffers(vec, 2);
+		}
+		file = direct ? ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | O_DIRECT, 0644) : -1;
+		if (file >= 0)
+			plainFile = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+		else
+			file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+		if (file < 0)
+			return false;
+		struct stat info;
+		offset = fstat(file, &info) == 0 ? static_cast<std::uint64_t>(info.st_size) : 0;
+		failed = false;
+		current = 0;
+		setp(buffers[0].data, buffers[0].data + capacity);
+		// an existing file ending inside a block, its last block is written again
+		if (std::size_t part = plainFile >= 0 ? offset % block : 0; part != 0)
+		{
+			offset -= part;
+			if (pread(plainFile, pbase(), part, static_cast<off_t>(offset)) != static_cast<ssize_t>(part))
+				failed = true;
+			pbump(static_cast<int>(part));
+		}
+		return true;
+	}
+
+	bool is_open() const { return file >= 0; }
+
+	void close()
+	{
+		if (file < 0)
+			return;
+		sync();
+		::close(file);
+		if (plainFile >= 0)
+			::close(plainFile);
+		file = plainFile = -1;
+	}
+
+	~uring_buf()
+	{
+		close();
+		ring.release();
+		std::free(buffers[0].data);
+		std::free(buffers[1].data);
+	}
+};
+
+// true if io_uring can be set up here
+bool uring_usable()
+{
+	uring probe;
+	return probe.setup(2);
+}
+#endif
+
+// A log file to append to, through io_uring if asked and possible, written
+// as zstd frames while compression is on
+class log_file
+{
+	std::filebuf plain;
+	std::vector<char> buffer;
+#ifdef ENH_LOG_URING
+	uring_buf ring;
+#endif
+#ifdef ENH_LOG_ZSTD
+	frame_buf packed;
+#endif
+	std::streambuf* file = nullptr;
+
+public:
+	std::ostream out{ nullptr };
+
+	log_file() = default;
+
+	log_file(const log_file&) = delete;
+
+	// opens stored_path(file), with a buffer of size bytes if not 0, through
+	// the backend set by debug::setWriteBackend if useBackend
+	bool open(const std::filesystem::path& name, std::ios::openmode mode, std::size_t size = 0, bool useBackend = false)
+	{
+		close();
+		out.clear();
+#ifdef ENH_LOG_URING
+		if (useBackend && backend.load() == debug::write_backend::uring
+			&& ring.open(stored_path(name), directIO.load()))
+			file = &ring;
+#else
+		(void)useBackend;
+#endif
+		if (!file)
+		{
+			buffer.resize(size);
+			if (size)
+				plain.pubsetbuf(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+			if (!plain.open(stored_path(name), mode | std::ios::app | std::ios::out))
+				return false;
+			file = &plain;
+		}
+#ifdef ENH_LOG_ZSTD
+		if (auto setup = compression().get(); setup->method == debug::log_compression::zstd)
+		{
+			out.rdbuf(&packed);
+			return packed.open(file, std::move(setup));
+		}
+#endif
+		out.rdbuf(file);
+		return true;
+	}
+
+	bool is_open() const { return file != nullptr; }
+
+	void close()
+	{
+		out.rdbuf(nullptr);
+#ifdef ENH_LOG_ZSTD
+		packed.close();
+#endif
+		plain.close();
+#ifdef ENH_LOG_URING
+		ring.close();
+#endif
+		file = nullptr;
+	}
+
+	~log_file() { close(); }
+};
+
+//write to path synchronously
+void write_now(const std::string& buff, const std::filesystem::path& file)
+{
+	log_file log;
+	log.open(file, std::ios::out);
+	log.out << buff << "\n";
+}
+
+// A file opened once with a large buffer
+struct buffered_file
+{
+	std::filesystem::path path;
+	log_file file;
+	std::ostream& out = file.out;
+	bool ready = false;
+
+	void open(std::filesystem::path name, std::ios::openmode mode)
+	{
+		path = std::move(name);
+		file.open(path, mode, ENH_LOG_BUFFER_SIZE);
+		ready = true;
+	}
+
+	void close()
+	{
+		file.close();
+		ready = false;
+	}
+};
+
+// Renames files past the rotation limits and deletes the oldest renamed files
+// over the total, writers holding a file open reopen it when generation moves.
+class rotator
+{
+	std::mutex mtx;
+	debug::rotation_policy policy;
+	std::map<std::filesystem::path, std::chrono::steady_clock::time_point> started;
+	std::deque<std::pair<std::filesystem::path, std::uintmax_t>> rotated;
+	std::uintmax_t rotatedBytes = 0;
+	std::uint64_t sequence = 0;
+
+	// under mtx
+	void trim()
+	{
+		std::error_code ec;
+		while (policy.maxTotalBytes != 0 && rotatedBytes > policy.maxTotalBytes && !rotated.empty())
+		{
+			std::filesystem::remove(rotated.front().first, ec);
+			std::filesystem::remove(index_path(rotated.front().first), ec);
+			rotatedBytes -= rotated.front().second;
+			rotated.pop_front();
+		}
+	}
+
+public:
+	std::atomic<bool> active{ false };
+	std::atomic<std::uint64_t> generation{ 0 };
+
+	void set(const debug::rotation_policy& in)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		policy = in;
+		active = in.maxFileBytes != 0 || in.maxFileAge.count() != 0;
+		trim();
+	}
+
+	// true if the file of path was renamed, the caller reopens it
+	bool rotate_if_due(const std::filesystem::path& path)
+	{
+		if (!active.load(std::memory_order_relaxed))
+			return false;
+		const std::filesystem::path file = stored_path(path);
+		std::lock_guard<std::mutex> lock(mtx);
+		auto now = std::chrono::steady_clock::now();
+		auto it = started.try_emplace(file, now).first;
+		std::error_code ec;
+		std::uintmax_t size = std::filesystem::file_size(file, ec);
+		if (ec || size == 0)
+			return false;
+		bool due = (policy.maxFileBytes != 0 && size >= policy.maxFileBytes)
+			|| (policy.maxFileAge.count() != 0 && now - it->second >= policy.maxFileAge);
+		if (!due)
+			return false;
+		std::filesystem::path target;
+		do
+		{
+			target = file;
+			target.replace_extension(std::to_string(++sequence) + file.extension().string());
+		} while (std::filesystem::exists(target, ec));
+		// fails where open files cannot be renamed, tried again at the next check
+		std::filesystem::rename(file, target, ec);
+		if (ec)
+			return false;
+		// the index of a binary file goes with it
+		std::filesystem::rename(index_path(file), index_path(target), ec);
+		started.erase(it);
+		rotated.emplace_back(std::move(target), size);
+		rotatedBytes += size;
+		trim();
+		++generation;
+		return true;
+	}
+};
+
+rotator& rotation()
+{
+	static rotator instance;
+	return instance;
+}
+
+// The one file all threads write text logs to after setSingleFile
+class single_file
+{
+	std::mutex mtx;
+	log_file out;
+	std::filesystem::path path;
+	std::uint64_t seenGeneration = 0;
+
+public:
+	std::atomic<bool> active{ false };
+
+	void set(std::filesystem::path file)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		out.close();
+		path = std::move(file);
+		active = !path.empty();
+	}
+
+	std::filesystem::path file()
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return path;
+	}
+
+	// appends whole lines, so lines of threads never mix
+	void append(const std::string& chunk)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		std::uint64_t gen = rotation().generation.load();
+		if (!out.is_open() || gen != seenGeneration)
+		{
+			out.open(path, std::ios::out);
+			seenGeneration = gen;
+		}
+		out.out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+		out.out.flush();
+		if (rotation().rotate_if_due(path))
+		{
+			out.close();
+			seenGeneration = rotation().generation.load();
+		}
+	}
+};
+
+single_file& single()
+{
+	static single_file instance;
+	return instance;
+}
+
+std::string thread_header(std::thread::id id, std::string_view function)
+{
+	std::ostringstream buff;
+	buff << "Thread id : " << id << "\n\t\tthread first logging function " << function;
+	return buff.str();
+}
+
+// A file mapped into memory, its contents reach the file even if the program dies
+class mapped_file
+{
+	char* data = nullptr;
+	std::size_t length = 0;
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE;
+	HANDLE mapping = nullptr;
+#else
+	int fd = -1;
+#endif
+
+public:
+	// creates the file of size bytes, zero filled
+	bool open(const std::filesystem::path& path, std::size_t size)
+	{
+		close();
+#if defined(_WIN32)
+		file = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+			CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+		ULARGE_INTEGER bytes;
+		bytes.QuadPart = size;
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, bytes.HighPart, bytes.LowPart, nullptr);
+		if (mapping)
+			data = static_cast<char*>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size));
+#else
+		fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+			return false;
+		if (::ftruncate(fd, static_cast<off_t>(size)) == 0)
+		{
+			void* view = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (view != MAP_FAILED)
+				data = static_cast<char*>(view);
+		}
+#endif
+		if (!data)
+		{
+			close();
+			return false;
+		}
+		length = size;
+		return true;
+	}
+
+	void close()
+	{
+#if defined(_WIN32)
+		if (data)
+			UnmapViewOfFile(data);
+		if (mapping)
+			CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE)
+			CloseHandle(file);
+		mapping = nullptr;
+		file = INVALID_HANDLE_VALUE;
+#else
+		if (data)
+			::munmap(data, length);
+		if (fd >= 0)
+			::close(fd);
+		fd = -1;
+#endif
+		data = nullptr;
+		length = 0;
+	}
+
+	char* get() const { return data; }
+
+	~mapped_file() { close(); }
+};
+
+// The start of a flight recorder file, see the layout below
+struct ring_header
+{
+	char magic[8];
+	std::uint64_t siteCapacity;
+	std::uint64_t ringCapacity;
+	std::atomic<std::uint64_t> siteUsed;
+	std::atomic<std::uint64_t> head;
+	std::atomic<std::uint64_t> tail;
+	char reserved[16];
+};
+
+static_assert(sizeof(ring_header) == 64, "flight recorder header layout");
+
+class flight_recorder;
+
+#if !defined(_WIN32)
+// The open rings, written by the crash handler without a lock
+std::atomic<flight_recorder*> crashRings[ENH_LOG_CRASH_RINGS];
+
+// writes all of size bytes with write, safe in a signal handler
+bool write_all(int fd, const char* src, std::size_t size) noexcept
+{
+	while (size)
+	{
+		ssize_t done = ::write(fd, src, size);
+		if (done < 0 && errno == EINTR)
+			continue;
+		if (done <= 0)
+			return false;
+		src += done;
+		size -= static_cast<std::size_t>(done);
+	}
+	return true;
+}
+#endif
+
+// The records of a thread kept in a mapped ring, only the owning thread writes
+class flight_recorder
+{
+	mapped_file file;
+	ring_header* header = nullptr;
+	char* sites = nullptr;
+	char* ring = nullptr;
+	std::uint64_t capacity = 0;
+#if !defined(_WIN32)
+	// the file of crash_dump, made at open so the handler does not allocate
+	char dumpPath[1024] = {};
+	std::atomic<flight_recorder*>* crashSlot = nullptr;
+#endif
+
+	void write_at(std::uint64_t pos, const void* src, std::size_t size)
+	{
+		std::size_t at = static_cast<std::size_t>(pos % capacity);
+		std::size_t first = std::min<std::size_t>(size, static_cast<std::size_t>(capacity) - at);
+		std::memcpy(ring + at, src, first);
+		std::memcpy(ring, static_cast<const char*>(src) + first, size - first);
+	}
+
+	void read_at(std::uint64_t pos, void* dst, std::size_t size) const
+	{
+		std::size_t at = static_cast<std::size_t>(pos % capacity);
+		std::size_t first = std::min<std::size_t>(size, static_cast<std::size_t>(capacity) - at);
+		std::memcpy(dst, ring + at, first);
+		std::memcpy(static_cast<char*>(dst) + first, ring, size - first);
+	}
+
+public:
+	std::filesystem::path path;
+
+	bool ready() const { return header != nullptr; }
+
+	// starts the site region with the thread record
+	bool open(std::filesystem::path file_, std::size_t bytes, const std::string& thread)
+	{
+		close();
+		path = std::move(file_);
+		if (!file.open(path, sizeof(ring_header) + ENH_LOG_SITE_REGION + bytes))
+			return false;
+		header = ::new (static_cast<void*>(file.get())) ring_header{};
+		std::memcpy(header->magic, "ENHRING1", 8);
+		header->siteCapacity = ENH_LOG_SITE_REGION;
+		header->ringCapacity = bytes;
+		sites = file.get() + sizeof(ring_header);
+		ring = sites + ENH_LOG_SITE_REGION;
+		capacity = bytes;
+		if (!add_site(thread))
+			return false;
+#if !defined(_WIN32)
+		std::filesystem::path dump = path;
+		dump.replace_extension(".dump.blog");
+		const std::string& name = dump.native();
+		if (name.size() >= sizeof(dumpPath))
+			return true;	// not dumped on a crash, the .ring file still holds it
+		std::memcpy(dumpPath, name.c_str(), name.size() + 1);
+		for (auto& slot : crashRings)
+		{
+			flight_recorder* none = nullptr;
+			if (slot.compare_exchange_strong(none, this))
+			{
+				crashSlot = &slot;
+				break;
+			}
+		}
+#endif
+		return true;
+	}
+
+	// false if the site region is full
+	bool add_site(const std::string& record)
+	{
+		std::uint64_t used = header->siteUsed.load(std::memory_order_relaxed);
+		if (used + record.size() > header->siteCapacity)
+			return false;
+		std::memcpy(sites + used, record.data(), record.size());
+		header->siteUsed.store(used + record.size(), std::memory_order_release);
+		return true;
+	}
+
+	// overwrites the oldest records as needed
+	void push(const std::string& record)
+	{
+		std::uint32_t size = static_cast<std::uint32_t>(record.size());
+		std::uint64_t frame = sizeof(size) + size;
+		if (frame > capacity)
+			return;
+		std::uint64_t head = header->head.load(std::memory_order_relaxed);
+		std::uint64_t tail = header->tail.load(std::memory_order_relaxed);
+		while (head + frame - tail > capacity)
+		{
+			std::uint32_t old;
+			read_at(tail, &old, sizeof(old));
+			tail += sizeof(old) + old;
+		}
+		header->tail.store(tail, std::memory_order_release);
+		write_at(head, &size, sizeof(size));
+		write_at(head + sizeof(size), record.data(), size);
+		header->head.store(head + frame, std::memory_order_release);
+	}
+
+	// the contents as a binary log file
+	void copy(std::string& out) const
+	{
+		out.assign("ENHBLOG1");
+		out.append(sites, static_cast<std::size_t>(header->siteUsed.load(std::memory_order_acquire)));
+		std::uint64_t head = header->head.load(std::memory_order_acquire);
+		for (std::uint64_t pos = header->tail.load(std::memory_order_acquire); pos < head;)
+		{
+			std::uint32_t size;
+			read_at(pos, &size, sizeof(size));
+			std::size_t at = out.size();
+			out.resize(at + size);
+			read_at(pos + sizeof(size), &out[at], size);
+			pos += sizeof(size) + size;
+		}
+	}
+
+#if !defined(_WIN32)
+	// writes the ring as dump does with only open, write and close, for a
+	// signal handler. The owner may be writing, a record overwritten while
+	// read ends the dump.
+	void crash_dump() const noexcept
+	{
+		int out = ::open(dumpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		if (out < 0)
+			return;
+		std::uint64_t used = std::min<std::uint64_t>(
+			header->siteUsed.load(std::memory_order_acquire), header->siteCapacity);
+		std::uint64_t head = header->head.load(std::memory_order_acquire);
+		std::uint64_t pos = header->tail.load(std::memory_order_acquire);
+		bool good = write_all(out, "ENHBLOG1", 8)
+			&& write_all(out, sites, static_cast<std::size_t>(used));
+		while (good && pos + sizeof(std::uint32_t) <= head)
+		{
+			std::uint32_t size;
+			read_at(pos, &size, sizeof(size));
+			if (size > capacity || pos + sizeof(size) + size > head)
+				break;
+			std::size_t at = static_cast<std::size_t>((pos + sizeof(size)) % capacity);
+			std::size_t first = std::min<std::size_t>(size, static_cast<std::size_t>(capacity) - at);
+			good = write_all(out, ring + at, first) && write_all(out, ring, size - first);
+			pos += sizeof(size) + size;
+		}
+		::close(out);
+	}
+#endif
+
+	void close()
+	{
+#if !defined(_WIN32)
+		if (crashSlot)
+			crashSlot->store(nullptr);
+		crashSlot = nullptr;
+#endif
+		header = nullptr;
+		file.close();
+	}
+
+	~flight_recorder() { close(); }
+};
+
+// Records of binary files per index block entry, 0 writes no index
+std::atomic<std::uint32_t> indexEvery{ 1024 };
+
+// Writes the index of a binary file to <file>.idx, see the layout below the
+// binary log layout. Offsets count the bytes of the file, so compressed 
+// files are not indexed.
+class segment_index
 {
-	write(lg, getFile(std::this_thread::get_id(), function));
+	std::ofstream out;
+	std::string entry;
+	std::uint64_t offset = 0;
+	std::uint32_t every = 0;
+
+	// the block being gathered
+	std::uint64_t start = 0;
+	std::int64_t first = 0;
+	std::int64_t last = 0;
+	std::uint32_t records = 0;
+	std::vector<std::uint32_t> sites;
+
+	void end_block();
+
+public:
+	void open(const std::filesystem::path& log);
+
+	// notes chunk, whole records about to be appended to the file
+	void add(const std::string& chunk, const index_note& note);
+
+	void flush()
+	{
+		if (out.is_open())
+			out.flush();
+	}
+
+	void close()
+	{
+		if (!out.is_open())
+			return;
+		end_block();
+		out.close();
+	}
+
+	~segment_index() { close(); }
+};
+
+// The log files of a thread, text and binary
+struct thread_log
+{
+	std::mutex mtx;
+	buffered_file text;
+	buffered_file binary;
+	segment_index binaryIndex;
+	std::chrono::steady_clock::time_point lastFlush;
+	bool registered = false;
+
+	// text lines go to the single file, gathered in pending
+	bool shared = false;
+	std::string pending;
+
+	// rotation generation the open files were checked against
+	std::uint64_t seenGeneration = 0;
+
+	// bytes written since the last flush
+	std::size_t unflushed = 0;
+
+	// call sites already described in the binary file, by id
+	std::vector<bool> sitesWritten;
+
+	// the flight recorder ring and the call sites in its site region
+	flight_recorder recorder;
+	std::vector<bool> recorderSites;
+
+	void open(std::filesystem::path path);
+
+	void open_binary(std::filesystem::path path);
+
+	// under mtx
+	void flush_pending()
+	{
+		if (pending.empty())
+			return;
+		single().append(pending);
+		pending.clear();
+	}
+
+	// under mtx, by the owning thread
+	void reopen_text()
+	{
+		bool fresh = !std::filesystem::exists(stored_path(text.path));
+		text.open(std::filesystem::path(text.path), std::ios::out);
+		if (fresh)
+			text.out << thread_header(std::this_thread::get_id(), ownName.function) << "\n";
+	}
+
+	// under mtx, by the owning thread after a flush
+	void check_rotation()
+	{
+		if (!rotation().active.load(std::memory_order_relaxed))
+			return;
+		// a file may have been renamed by another writer
+		if (rotation().generation.load() != seenGeneration && text.ready && !shared)
+			reopen_text();
+		if (text.ready && !shared && rotation().rotate_if_due(text.path))
+			reopen_text();
+		if (binary.ready && rotation().rotate_if_due(binary.path))
+		{
+			// the next record starts a new file, describing the sites again
+			binary.close();
+			binaryIndex.close();
+			sitesWritten.clear();
+		}
+		seenGeneration = rotation().generation.load();
+	}
+
+	// under mtx
+	void flush_if_due()
+	{
+		auto now = std::chrono::steady_clock::now();
+		// with rotation, a buffer full of lines is flushed early to check the size
+		if (now - lastFlush >= std::chrono::nanoseconds(flushInterval.load(std::memory_order_relaxed))
+			|| (unflushed >= ENH_LOG_BUFFER_SIZE && rotation().active.load(std::memory_order_relaxed)))
+		{
+			if (text.ready && !shared)
+				text.out.flush();
+			if (binary.ready)
+				binary.out.flush();
+			binaryIndex.flush();
+			flush_pending();
+			lastFlush = now;
+			unflushed = 0;
+			check_rotation();
+		}
+	}
+
+	void write(const std::string& line)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (shared)
+		{
+			pending.append(line);
+			pending.push_back('\n');
+			if (pending.size() >= ENH_LOG_BUFFER_SIZE)
+				flush_pending();
+		}
+		else
+			text.out << line << "\n";
+		unflushed += line.size() + 1;
+		flush_if_due();
+	}
+
+	void record(const std::string& bytes)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		recorder.push(bytes);
+	}
+
+	// writes the ring to <name>.dump.blog
+	void dump()
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (!recorder.ready())
+			return;
+		std::string bytes;
+		recorder.copy(bytes);
+		std::filesystem::path file = recorder.path;
+		file.replace_extension(".dump.blog");
+		std::ofstream out(file, std::ios::binary | std::ios::trunc | std::ios::out);
+		out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+	}
+
+	void open_recorder(std::filesystem::path path, std::size_t bytes, const std::string& thread);
+
+	void write_raw(const std::string& bytes, const index_note& note)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		binaryIndex.add(bytes, note);
+		binary.out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+		unflushed += bytes.size();
+		flush_if_due();
+	}
+
+	void flush()
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if (text.ready && !shared)
+			text.out.flush();
+		if (binary.ready)
+			binary.out.flush();
+		binaryIndex.flush();
+		flush_pending();
+		lastFlush = std::chrono::steady_clock::now();
+	}
+
+	~thread_log();
+};
+
+// All open thread logs, so debug::flush can reach them
+class thread_log_registry
+{
+	std::mutex mtx;
+	std::set<thread_log*> logs;
+
+public:
+	void add(thread_log* log)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		logs.insert(log);
+	}
+
+	void remove(thread_log* log)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		logs.erase(log);
+	}
+
+	void flush()
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		for (auto log : logs)
+			log->flush();
+	}
+
+	void dump()
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		for (auto log : logs)
+			log->dump();
+	}
+};
+
+thread_log_registry& registry()
+{
+	static thread_log_registry instance;
+	return instance;
+}
+
+void thread_log::open(std::filesystem::path path)
+{
+	if (!registered)
+	{
+		// registry is constructed first so it is destroyed after the last thread_log
+		registry().add(this);
+		registered = true;
+	}
+	std::lock_guard<std::mutex> lock(mtx);
+	shared = single().active.load();
+	if (shared)
+	{
+		text.path = std::move(path);
+		text.ready = true;
+	}
+	else
+		text.open(std::move(path), std::ios::out);
+	seenGeneration = rotation().generation.load();
+	lastFlush = std::chrono::steady_clock::now();
+}
+
+void thread_log::open_binary(std::filesystem::path path)
+{
+	if (!registered)
+	{
+		registry().add(this);
+		registered = true;
+	}
+	std::lock_guard<std::mutex> lock(mtx);
+	binaryIndex.open(path);
+	binary.open(std::move(path), std::ios::binary);
+	lastFlush = std::chrono::steady_clock::now();
+}
+
+void thread_log::open_recorder(std::filesystem::path path, std::size_t bytes, const std::string& thread)
+{
+	if (!registered)
+	{
+		registry().add(this);
+		registered = true;
+	}
+	std::lock_guard<std::mutex> lock(mtx);
+	recorder.open(std::move(path), bytes, thread);
+	recorderSites.clear();
+}
+
+thread_log::~thread_log()
+{
+	if (registered)
+		registry().remove(this);
+	flush_pending();
+}
+
+thread_local thread_log own;
+
+// Background writer, log calls push records, one thread writes them in batches
+class async_sink
+{
+	enh::mpsc_ring<log_record, ENH_LOG_QUEUE_SIZE> records;
+	std::mutex mtx;
+	std::condition_variable cv;
+	std::atomic<bool> running{ false };
+	std::atomic<bool> isSleeping{ false };
+	std::atomic<std::size_t> pushed{ 0 };
+	std::atomic<std::size_t> written{ 0 };
+	// records debug::flush waits to reach the files, and records flushed
+	std::atomic<std::size_t> flushTarget{ 0 };
+	std::atomic<std::size_t> flushed{ 0 };
+	std::thread writer;
+
+	// a file open here and the index of a binary one
+	struct sink_file
+	{
+		log_file file;
+		segment_index index;
+	};
+
+	// writer only, files stay open between batches
+	std::map<std::filesystem::path, sink_file> files;
+	std::chrono::steady_clock::time_point lastFlush;
+	std::chrono::steady_clock::time_point lastRotation;
+	std::uint64_t seenGeneration = 0;
+	std::size_t sinceRotation = 0;
+
+	// rotates the text files open here, binary ones are rotated by their thread
+	void check_rotation()
+	{
+		auto now = std::chrono::steady_clock::now();
+		if (!rotation().active.load(std::memory_order_relaxed)
+			|| (now - lastRotation < std::chrono::milliseconds(100) && sinceRotation < ENH_LOG_BUFFER_SIZE))
+			return;
+		lastRotation = now;
+		sinceRotation = 0;
+		// another writer renamed a file, reopen them all
+		if (rotation().generation.load() != seenGeneration)
+			files.clear();
+		for (auto it = files.begin(); it != files.end();)
+		{
+			if (it->first.extension() != ".blog" && rotation().rotate_if_due(it->first))
+				it = files.erase(it);
+			else
+				++it;
+		}
+		seenGeneration = rotation().generation.load();
+	}
+
+	void write_batch(std::vector<log_record>& batch)
+	{
+		if (files.size() > 64)
+			files.clear();
+		std::ostream* out = nullptr;
+		segment_index* index = nullptr;
+		const std::filesystem::path* current = nullptr;
+		for (auto& rec : batch)
+		{
+			// consecutive records of a thread mostly share the file
+			if (!current || *current != rec.file)
+			{
+				auto it = files.find(rec.file);
+				if (it == files.end())
+				{
+					it = files.try_emplace(rec.file).first;
+					if (rec.binary)
+						it->second.index.open(rec.file);
+					it->second.file.open(rec.file, rec.binary ? std::ios::binary : std::ios::openmode(), 0, true);
+				}
+				out = &it->second.file.out;
+				index = &it->second.index;
+				current = &it->first;
+			}
+			sinceRotation += rec.line.size();
+			if (rec.binary)
+			{
+				index->add(rec.line, rec.note);
+				out->write(rec.line.data(), static_cast<std::streamsize>(rec.line.size()));
+			}
+			else if (rec.site)
+			{
+				stream_site(*out, rec.site->file, rec.site->function, rec.site->line);
+				*out << "  " << rec.site->var << " = ";
+				rec.format(*out, rec.line.data());
+				if (rec.weight > 1)
+					*out << "  [x " << rec.weight << "]";
+				*out << "\n";
+			}
+			else
+				*out << rec.line << "\n";
+		}
+		flush_if_due(written.load() + batch.size());
+		written += batch.size();
+		batch.clear();
+	}
+
+	// writes out the files at the flush interval or when flush waits for
+	// records past the last flush, so compressed frames span many batches
+	void flush_if_due(std::size_t count)
+	{
+		if (count == flushed)
+			return;
+		auto now = std::chrono::steady_clock::now();
+		if (flushTarget.load() <= flushed
+			&& now - lastFlush < std::chrono::nanoseconds(flushInterval.load(std::memory_order_relaxed)))
+			return;
+		for (auto& f : files)
+		{
+			f.second.file.out.flush();
+			f.second.index.flush();
+		}
+		lastFlush = now;
+		flushed = count;
+		check_rotation();
+	}
+
+	void run()
+	{
+		std::vector<log_record> batch;
+		batch.reserve(256);
+		while (true)
+		{
+			if (records.try_pop_bulk(batch, 256) != 0)
+			{
+				write_batch(batch);
+				continue;
+			}
+			if (!running.load())
+			{
+				files.clear();
+				return;
+			}
+			flush_if_due(written.load());
+			std::unique_lock<std::mutex> lock(mtx);
+			isSleeping = true;
+			cv.wait_for(lock, std::chrono::milliseconds(50), [this]() {
+				return !records.empty() || !running.load() || flushTarget.load() > flushed.load();
+				});
+			isSleeping = false;
+		}
+	}
+
+public:
+
+	std::atomic<debug::overflow_policy> overflow{ debug::overflow_policy::block };
+	std::atomic<std::size_t> dropped{ 0 };
+
+	void start()
+	{
+		// constructed before the sink may use them during exit
+		rotation();
+		single();
+		if (running.exchange(true))
+			return;
+		writer = std::thread(&async_sink::run, this);
+	}
+
+	// waits till every record pushed so far is written and flushed
+	void flush()
+	{
+		std::size_t target = pushed.load();
+		std::size_t asked = flushTarget.load();
+		while (asked < target && !flushTarget.compare_exchange_weak(asked, target))
+			;
+		while (running.load() && flushed.load() < target)
+		{
+			wake();
+			std::this_thread::yield();
+		}
+	}
+
+	// drains all records then joins the writer
+	void stop()
+	{
+		if (!running.exchange(false))
+			return;
+		wake();
+		writer.join();
+	}
+
+	void wake()
+	{
+		{ std::lock_guard<std::mutex> lock(mtx); }
+		cv.notify_one();
+	}
+
+	void push(log_record&& rec)
+	{
+		switch (overflow.load())
+		{
+		case debug::overflow_policy::block:
+			// a failed try_push leaves rec untouched
+			while (!records.try_push(std::move(rec)))
+			{
+				wake();
+				std::this_thread::yield();
+			}
+			++pushed;
+			break;
+		case debug::overflow_policy::drop:
+			if (!records.try_push(std::move(rec)))
+				return;
+			++pushed;
+			break;
+		case debug::overflow_policy::count_drops:
+			if (!records.try_push(std::move(rec)))
+			{
+				++dropped;
+				return;
+			}
+			++pushed;
+			break;
+		}
+		if (isSleeping.load())
+			wake();
+	}
+
+	// flush on exit
+	~async_sink() { stop(); }
+};
+
+// set while log calls go to the sink, trivially destructible so it is safe 
+// to read during static destruction.
+std::atomic<bool> asyncActive{ false };
+
+// number of log calls pushing to the sink
+std::atomic<std::size_t> asyncPushing{ 0 };
+
+async_sink& sink()
+{
+	static async_sink instance;
+	return instance;
+}
+
+// pushes to the sink if asynchronous logging is on
+bool write_async(std::string& buff, const std::filesystem::path& file, bool binary = false, const index_note& note = {})
+{
+	if (!asyncActive.load())
+		return false;
+	++asyncPushing;
+	bool pushed = asyncActive.load();
+	if (pushed)
+		sink().push(log_record{ file, std::move(buff), binary, note });
+	--asyncPushing;
+	return pushed;
+}
+
+//write to path, through the sink if asynchronous logging is on
+void write(std::string buff, std::filesystem::path file)
+{
+	if (write_async(buff, file))
+		return;
+	if (own.text.ready && own.text.path == file)
+		own.write(buff);
+	else if (single().active.load() && file == single().file())
+		single().append(buff + "\n");
+	else
+		write_now(buff, file);
+}
+
+std::string format_site(std::string_view file, std::string_view function, unsigned long line)
+{
+	std::ostringstream out;
+	stream_site(out, file, function, line);
+	return out.str();
+}
+
+std::uint32_t site_id(const debug::call_site& site);
+
+// the text layout of site, giving it an id so it is in the site table
+std::string format_site(const debug::call_site& site)
+{
+	site_id(site);
+	return format_site(site.file, site.function, site.line);
+}
+
+// the text layout of a value record up to the value
+std::string value_prefix(const debug::call_site& site)
+{
+	std::string out = format_site(site);
+	out.append("  ").append(site.var).append(" = ");
+	return out;
+}
+
+// the id of this thread starting its lines in the single file
+const std::string& thread_tag()
+{
+	thread_local std::string tag = []() {
+		std::ostringstream out;
+		out << std::this_thread::get_id() << " : ";
+		return out.str();
+	}();
+	return tag;
+}
+
+// the file of a thread when each thread logs to its own
+std::filesystem::path thread_path(std::thread::id id, std::string function, bool& setup)
+{
+	std::ostringstream out;
+	out << id << "_thread_fn_" << Register(setup, function, id) << ".log";
+	return out.str();
+}
+
+// calls the next record of this thread stands for, set by debug::isSampled
+thread_local std::uint32_t sampleWeight = 1;
+
+std::uint32_t take_weight()
+{
+	std::uint32_t weight = sampleWeight;
+	sampleWeight = 1;
+	return weight;
+}
+
+// writes a text line to the log file of this thread
+void log_text(std::string line, std::string_view function)
+{
+	if (std::uint32_t weight = take_weight(); weight > 1)
+		line.append("  [x ").append(std::to_string(weight)).append("]");
+	if (!own.text.ready)
+		own.open(debug::getFile(std::this_thread::get_id(), std::string(function)));
+	if (own.shared)
+		line.insert(0, thread_tag());
+	if (!write_async(line, own.text.path))
+		own.write(line);
+}
+
+/*
+	Binary log layout, all integers in native byte order (see tools/log_decoder.cpp)
+
+	file    : "ENHBLOG1", then records
+	record  : u8 tag, then by tag
+		thread (1) : str thread id, str first logging function
+		site   (2) : u32 site id, u32 line, str file, str function, str variable
+		line   (3) : u32 site id, i64 time
+		desc   (4) : u32 site id, i64 time, str description
+		value  (5) : u32 site id, i64 time, u8 type, value
+		text   (6) : i64 time, str preformatted line
+		trace  (7) : u32 site id, i64 time, u8 phase letter, u64 flow id
+		sample (8) : u32 calls the next record stands for, only if more 
+					 than 1
+	str     : u32 length, bytes
+	time    : nanoseconds since the system clock epoch
+	value   : by type, string (0) str, signed (1) i64, unsigned (2) u64, 
+			  floating (3) f64, bool (4) u8
+
+	Flight recorder file (.ring), written in place through a memory map
+
+	header  : "ENHRING1", u64 site region size, u64 ring size, u64 site bytes
+			  used, u64 head, u64 tail, 16 reserved bytes
+	sites   : the thread record then site records, never overwritten
+	ring    : frames of u32 length, record; head and tail count bytes since 
+			  the start (index is position modulo ring size), tail is the 
+			  oldest frame kept
+
+	Index of a binary file (<file>.idx), appended as the file is written
+
+	file    : "ENHBIDX1", then entries
+	entry   : u8 kind, then by kind
+		run   (1) : u64 offset of a thread record, site ids start over
+		site  (2) : u32 site id, u64 offset of its site record
+		block (3) : u64 offset of the first record, i64 first time, i64 last
+					time, u32 timed records, u32 count, count u32 ids of the 
+					sites logged
+	Entries are in the order written, a block entry comes after the site 
+	entries of its records. A block covers the records up to the offset of
+	the next block or run (or the end of the file), records after the last
+	block are not indexed yet.
+*/
+enum record_tag : std::uint8_t { tag_thread = 1, tag_site, tag_line, tag_desc, tag_value, tag_text, tag_trace, tag_sample };
+
+enum value_type : std::uint8_t { value_string = 0, value_signed, value_unsigned, value_floating, value_bool };
+
+enum index_kind : std::uint8_t { index_run = 1, index_site, index_block };
+
+// what the index needs of the records of this thread being encoded
+thread_local index_note recordNote;
+
+template<class T>
+void put(std::string& buff, T val)
+{
+	buff.append(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+void put_str(std::string& buff, const char* str, std::size_t len)
+{
+	put<std::uint32_t>(buff, static_cast<std::uint32_t>(len));
+	buff.append(str, len);
+}
+
+void put_str(std::string& buff, std::string_view str)
+{
+	put_str(buff, str.data(), str.size());
+}
+
+void segment_index::open(const std::filesystem::path& log)
+{
+	close();
+	every = indexEvery.load(std::memory_order_relaxed);
+	if (every == 0 || compression().active.load())
+		return;
+	std::error_code ec;
+	offset = std::filesystem::file_size(log, ec);
+	if (ec)
+		offset = 0;
+	std::filesystem::path file = index_path(log);
+	bool fresh = !std::filesystem::exists(file, ec);
+	out.open(file, std::ios::binary | std::ios::app | std::ios::out);
+	if (fresh)
+		out.write("ENHBIDX1", 8);
+	records = 0;
+	sites.clear();
+}
+
+void segment_index::end_block()
+{
+	if (records == 0)
+		return;
+	std::sort(sites.begin(), sites.end());
+	sites.erase(std::unique(sites.begin(), sites.end()), sites.end());
+	entry.clear();
+	put<std::uint8_t>(entry, index_block);
+	put<std::uint64_t>(entry, start);
+	put<std::int64_t>(entry, first);
+	put<std::int64_t>(entry, last);
+	put<std::uint32_t>(entry, records);
+	put<std::uint32_t>(entry, static_cast<std::uint32_t>(sites.size()));
+	for (std::uint32_t id : sites)
+		put<std::uint32_t>(entry, id);
+	out.write(entry.data(), static_cast<std::streamsize>(entry.size()));
+	records = 0;
+	sites.clear();
+}
+
+void segment_index::add(const std::string& chunk, const index_note& note)
+{
+	if (!out.is_open())
+		return;
+	// a block starts at a record, after the magic of a new file
+	std::uint64_t begin = offset + static_cast<std::uint64_t>(std::max(note.threadAt, 0));
+	if (note.threadAt >= 0)
+	{
+		end_block();
+		entry.clear();
+		put<std::uint8_t>(entry, index_run);
+		put<std::uint64_t>(entry, begin);
+		out.write(entry.data(), static_cast<std::streamsize>(entry.size()));
+	}
+	if (note.siteAt >= 0)
+	{
+		entry.clear();
+		put<std::uint8_t>(entry, index_site);
+		put<std::uint32_t>(entry, note.site);
+		put<std::uint64_t>(entry, offset + static_cast<std::uint64_t>(note.siteAt));
+		out.write(entry.data(), static_cast<std::streamsize>(entry.size()));
+	}
+	if (note.time != 0)
+	{
+		if (records == 0)
+		{
+			start = begin;
+			first = note.time;
+		}
+		last = note.time;
+		if (note.site != 0)
+			sites.push_back(note.site);
+		if (++records >= every)
+			end_block();
+	}
+	offset += chunk.size();
+}
+
+void put_time(std::string& buff)
+{
+	recordNote.time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+	put<std::int64_t>(buff, recordNote.time);
+}
+
+std::atomic<std::uint32_t> siteCount{ 0 };
+
+// Every site given an id, for debug::writeSiteDictionary, sites are static
+// so pointers to them stay valid
+class site_table
+{
+	std::mutex mtx;
+	std::vector<const debug::call_site*> sites;
+
+public:
+	void add(const debug::call_site* site)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		sites.push_back(site);
+	}
+
+	std::vector<const debug::call_site*> list()
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		return sites;
+	}
+};
+
+site_table& known_sites()
+{
+	static site_table instance;
+	return instance;
+}
+
+// the id of site in binary files, given out on first use starting at 1
+std::uint32_t site_id(const debug::call_site& site)
+{
+	std::uint32_t id = site.state->id.load(std::memory_order_relaxed);
+	if (id != 0)
+		return id;
+	std::uint32_t fresh = ++siteCount;
+	if (!site.state->id.compare_exchange_strong(id, fresh))
+		return id;
+	known_sites().add(&site);
+	return fresh;
+}
+
+inline bool is_binary()
+{
+	return format.load(std::memory_order_relaxed) == debug::log_format::binary
+		|| recorderSize.load(std::memory_order_relaxed) != 0;
+}
+
+std::atomic<bool> deferred{ false };
+
+// pushes the raw value for the writer thread to format, if deferred formatting applies
+bool log_deferred(const debug::call_site& site, const void* val, std::size_t size, debug::value_formatter fmt)
+{
+	if (!deferred.load(std::memory_order_relaxed) || !asyncActive.load() || is_binary() || single().active.load())
+		return false;
+	if (!own.text.ready)
+		own.open(debug::getFile(std::this_thread::get_id(), std::string(site.function)));
+	site_id(site);
+	++asyncPushing;
+	bool pushed = asyncActive.load();
+	if (pushed)
+		sink().push(log_record{ own.text.path, std::string(static_cast<const char*>(val), size), false, {}, &site, fmt, take_weight() });
+	--asyncPushing;
+	return pushed;
+}
+
+// per thread scratch buffer for encoding, keeps its capacity
+thread_local std::string scratch;
+
+// where the record in scratch goes
+enum class record_target { file, recorder, none };
+
+thread_local record_target recordTarget = record_target::file;
+
+// per thread buffer for records of the site region
+thread_local std::string siteScratch;
+
+// starts a record of this thread, opening the binary file (or flight recorder)
+// and describing the site if needed
+std::string& begin_binary(const debug::call_site* site, std::string_view function)
+{
+	scratch.clear();
+	recordNote = index_note{};
+	std::size_t ringSize = recorderSize.load(std::memory_order_relaxed);
+	recordTarget = ringSize ? record_target::recorder : record_target::file;
+	if (ringSize ? !own.recorder.ready() : !own.binary.ready)
+	{
+		bool setup = false;
+		std::filesystem::path file = thread_path(std::this_thread::get_id(), std::string(function), setup);
+		std::ostringstream id;
+		id << std::this_thread::get_id();
+		std::string& thread = ringSize ? siteScratch : scratch;
+		thread.clear();
+		if (!ringSize)
+		{
+			file.replace_extension(".blog");
+			if (!std::filesystem::exists(stored_path(file)))
+				scratch.append("ENHBLOG1");
+			own.open_binary(file);
+			recordNote.threadAt = static_cast<std::int32_t>(scratch.size());
+		}
+		put<std::uint8_t>(thread, tag_thread);
+		put_str(thread, id.str());
+		put_str(thread, Register(setup, std::string(function)));
+		if (ringSize)
+		{
+			file.replace_extension(".ring");
+			own.open_recorder(file, ringSize, siteScratch);
+			if (!own.recorder.ready())
+				recordTarget = record_target::none;
+		}
+	}
+	if (site && recordTarget != record_target::none)
+	{
+		std::uint32_t id = site_id(*site);
+		std::vector<bool>& written = ringSize ? own.recorderSites : own.sitesWritten;
+		if (written.size() <= id)
+			written.resize(id + 1, false);
+		if (!written[id])
+		{
+			std::string& out = ringSize ? siteScratch : scratch;
+			if (ringSize)
+				out.clear();
+			else
+			{
+				recordNote.site = id;
+				recordNote.siteAt = static_cast<std::int32_t>(scratch.size());
+			}
+			put<std::uint8_t>(out, tag_site);
+			put<std::uint32_t>(out, id);
+			put<std::uint32_t>(out, static_cast<std::uint32_t>(site->line));
+			put_str(out, site->file);
+			put_str(out, site->function);
+			put_str(out, site->var);
+			// a point that does not fit in the site region is not recorded
+			if (ringSize && !own.recorder.add_site(siteScratch))
+				recordTarget = record_target::none;
+			else
+				written[id] = true;
+		}
+	}
+	return scratch;
+}
+
+void begin_event(std::string& buff, record_tag tag, const debug::call_site& site)
+{
+	if (std::uint32_t weight = take_weight(); weight > 1)
+	{
+		put<std::uint8_t>(buff, tag_sample);
+		put<std::uint32_t>(buff, weight);
+	}
+	put<std::uint8_t>(buff, tag);
+	recordNote.site = site_id(site);
+	put<std::uint32_t>(buff, recordNote.site);
+	put_time(buff);
+}
+
+void end_binary(std::string& buff)
+{
+	if (recordTarget == record_target::recorder)
+		own.record(buff);
+	else if (recordTarget == record_target::file && !write_async(buff, own.binary.path, true, recordNote))
+		own.write_raw(buff, recordNote);
+}
+
+// stops the sink once no log call is pushing, writes out what is queued
+void stop_async()
+{
+	if (!asyncActive.exchange(false))
+		return;
+	while (asyncPushing.load() != 0)
+		std::this_thread::yield();
+	sink().stop();
+}
+
+void debug::setAsync(bool enable, overflow_policy overflow)
+{
+	if (!enable)
+	{
+		stop_async();
+		return;
+	}
+	// lines buffered by threads go out before the sink starts writing
+	registry().flush();
+	sink().overflow = overflow;
+	sink().start();
+	if (!asyncActive.exchange(true))
+	{
+		// registered after sink is constructed, so it runs before the sink
+		// is destroyed and later log calls write synchronously.
+		static bool registered = (std::atexit(stop_async) == 0);
+		(void)registered;
+	}
+}
+
+std::size_t debug::droppedLogs()
+{
+	return sink().dropped.load();
+}
+
+bool debug::setWriteBackend(write_backend with, bool direct)
+{
+#ifdef ENH_LOG_URING
+	if (with == write_backend::uring && !uring_usable())
+		return false;
+#else
+	if (with == write_backend::uring)
+		return false;
+#endif
+	directIO = direct;
+	backend = with;
+	return true;
+}
+
+void debug::flush()
+{
+	registry().flush();
+	if (asyncActive.load())
+		sink().flush();
+}
+
+std::vector<std::pair<std::thread::id, std::string>> debug::registeredThreads()
+{
+	return threads().list();
+}
+
+void debug::setFormat(log_format fmt)
+{
+	format = fmt;
+}
+
+void debug::setIndexInterval(std::uint32_t records)
+{
+	indexEvery = records;
+}
+
+#if !defined(_WIN32)
+// The signals of setFlightRecorder and the actions they had before it
+constexpr int crashSignals[] = { SIGSEGV, SIGBUS, SIGABRT, SIGFPE, SIGILL };
+constexpr std::size_t crash_signal_count = sizeof(crashSignals) / sizeof(crashSignals[0]);
+struct sigaction previousActions[crash_signal_count];
+std::atomic<bool> crashInstalled{ false };
+std::atomic<bool> crashDumped{ false };
+
+extern "C" void dump_on_signal(int sig, siginfo_t* info, void* context)
+{
+	// no lock and no allocation, a crash inside malloc or a logging call
+	// still dumps
+	int savedErrno = errno;
+	if (!crashDumped.exchange(true))
+		for (auto& slot : crashRings)
+			if (const flight_recorder* rec = slot.load())
+				rec->crash_dump();
+	errno = savedErrno;
+	for (std::size_t i = 0; i < crash_signal_count; ++i)
+	{
+		if (crashSignals[i] != sig)
+			continue;
+		const struct sigaction& prev = previousActions[i];
+		if (prev.sa_flags & SA_SIGINFO)
+		{
+			prev.sa_sigaction(sig, info, context);
+			return;
+		}
+		if (prev.sa_handler != SIG_DFL && prev.sa_handler != SIG_IGN)
+		{
+			prev.sa_handler(sig);
+			return;
+		}
+	}
+	// the default action, ignoring a fault would only repeat it
+	struct sigaction fallback{};
+	fallback.sa_handler = SIG_DFL;
+	sigemptyset(&fallback.sa_mask);
+	sigaction(sig, &fallback, nullptr);
+	raise(sig);
+}
+#endif
+
+void debug::setFlightRecorder(std::size_t bytes, bool dumpOnCrash)
+{
+	recorderSize = bytes;
+#if !defined(_WIN32)
+	if (bytes == 0 || !dumpOnCrash || crashInstalled.exchange(true))
+		return;
+	struct sigaction action{};
+	action.sa_sigaction = dump_on_signal;
+	action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+	sigemptyset(&action.sa_mask);
+	for (std::size_t i = 0; i < crash_signal_count; ++i)
+		sigaction(crashSignals[i], &action, &previousActions[i]);
+#else
+	// the .ring files are mapped and keep their contents, nothing to install
+	(void)dumpOnCrash;
+#endif
+}
+
+void debug::dump()
+{
+	registry().dump();
+}
+
+// the rule of setSiteEnabled and setSiteSampling for a site
+struct site_rule
+{
+	bool enabled = true;
+	std::uint32_t every = 0;
+	std::uint32_t perSecond = 0;
+};
+
+// rules by site hash, generation counts their changes
+std::mutex mtxRules;
+std::unordered_map<std::uint64_t, site_rule> siteRules;
+std::atomic<std::uint32_t> ruleGeneration{ 0 };
+
+void debug::setSiteEnabled(std::string_view file, unsigned long line, bool enable)
+{
+	std::lock_guard<std::mutex> lock(mtxRules);
+	siteRules[site_hash(file, line)].enabled = enable;
+	++ruleGeneration;
+}
+
+void debug::setSiteSampling(std::string_view file, unsigned long line, std::uint32_t every, std::uint32_t perSecond)
+{
+	std::lock_guard<std::mutex> lock(mtxRules);
+	site_rule& rule = siteRules[site_hash(file, line)];
+	rule.every = every;
+	rule.perSecond = perSecond;
+	++ruleGeneration;
+}
+
+void debug::clearSiteRules()
+{
+	std::lock_guard<std::mutex> lock(mtxRules);
+	siteRules.clear();
+	++ruleGeneration;
+}
+
+bool debug::isEnabled(const call_site& site)
+{
+	std::uint32_t current = ruleGeneration.load(std::memory_order_acquire);
+	if (site.state->generation.load(std::memory_order_acquire) == current)
+		return site.state->enabled.load(std::memory_order_relaxed);
+	site_rule rule;
+	{
+		std::lock_guard<std::mutex> lock(mtxRules);
+		current = ruleGeneration.load(std::memory_order_relaxed);
+		auto it = siteRules.find(site.hash);
+		if (it != siteRules.end())
+			rule = it->second;
+	}
+	site.state->enabled.store(rule.enabled, std::memory_order_relaxed);
+	site.state->every.store(rule.every, std::memory_order_relaxed);
+	site.state->perSecond.store(rule.perSecond, std::memory_order_relaxed);
+	site.state->generation.store(current, std::memory_order_release);
+	return rule.enabled;
+}
+
+// counts a record against the per second limit of a site
+bool within_rate(debug::site_state& state, std::uint32_t limit)
+{
+	std::int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	std::int64_t window = state.window.load(std::memory_order_relaxed);
+	if (window != now && state.window.compare_exchange_strong(window, now, std::memory_order_relaxed))
+		state.inWindow.store(0, std::memory_order_relaxed);
+	return state.inWindow.fetch_add(1, std::memory_order_relaxed) < limit;
+}
+
+bool debug::isSampled(const call_site& site, site_sample& sample)
+{
+	if (!isEnabled(site))
+		return false;
+	std::uint32_t every = site.state->every.load(std::memory_order_relaxed);
+	std::uint32_t limit = site.state->perSecond.load(std::memory_order_relaxed);
+	if (every <= 1 && limit == 0 && sample.carry == 0)
+	{
+		sample.countdown = 0;
+		sample.span = 0;
+		return true;
+	}
+	// the skipped calls of the last countdown and this one
+	std::uint64_t calls = sample.carry + (sample.span ? sample.span : 1);
+	sample.span = every > 1 ? every : 1;
+	sample.countdown = sample.span;
+	if (limit != 0 && !within_rate(*site.state, limit))
+	{
+		sample.carry = calls;
+		return false;
+	}
+	sample.carry = 0;
+	sampleWeight = static_cast<std::uint32_t>(std::min<std::uint64_t>(calls, UINT32_MAX));
+	return true;
+}
+
+void debug::Log(const call_site& site)
+{
+	if (is_binary())
+	{
+		std::string& buff = begin_binary(&site, site.function);
+		begin_event(buff, tag_line, site);
+		end_binary(buff);
+		return;
+	}
+	log_text(format_site(site), site.function);
+}
+
+void debug::LogDesc(const call_site& site, const std::string& descr)
+{
+	if (is_binary())
+	{
+		std::string& buff = begin_binary(&site, site.function);
+		begin_event(buff, tag_desc, site);
+		put_str(buff, descr.data(), descr.size());
+		end_binary(buff);
+		return;
+	}
+	log_text(format_site(site) + " ::   " + descr, site.function);
+}
+
+void debug::LogTrace(const call_site& site, trace_phase phase, std::uint64_t id)
+{
+	if (is_binary())
+	{
+		std::string& buff = begin_binary(&site, site.function);
+		begin_event(buff, tag_trace, site);
+		put<std::uint8_t>(buff, static_cast<std::uint8_t>(phase));
+		put<std::uint64_t>(buff, id);
+		end_binary(buff);
+		return;
+	}
+	log_text(format_site(site) + " ::   trace "
+		+ static_cast<char>(phase) + " " + std::string(site.var) + " "
+		+ std::to_string(id), site.function);
+}
+
+void debug::LogValue(const call_site& site, std::string_view val)
+{
+	if (is_binary())
+	{
+		std::string& buff = begin_binary(&site, site.function);
+		begin_event(buff, tag_value, site);
+		put<std::uint8_t>(buff, value_string);
+		put_str(buff, val.data(), val.size());
+		end_binary(buff);
+		return;
+	}
+	log_text(value_prefix(site).append(val), site.function);
+}
+
+template<class T>
+void log_number(const debug::call_site& site, T val, value_type type)
+{
+	if (is_binary())
+	{
+		std::string& buff = begin_binary(&site, site.function);
+		begin_event(buff, tag_value, site);
+		put<std::uint8_t>(buff, type);
+		put<T>(buff, val);
+		end_binary(buff);
+		return;
+	}
+	if (log_deferred(site, &val, sizeof(T), &debug::format_raw<T>))
+		return;
+	std::ostringstream out;
+	out << value_prefix(site) << val;
+	log_text(out.str(), site.function);
+}
+
+void debug::LogValue(const call_site& site, long long val)
+{
+	log_number<std::int64_t>(site, val, value_signed);
+}
+
+void debug::LogValue(const call_site& site, unsigned long long val)
+{
+	log_number<std::uint64_t>(site, val, value_unsigned);
+}
+
+void debug::LogValue(const call_site& site, double val)
+{
+	log_number<double>(site, val, value_floating);
+}
+
+void debug::LogValue(const call_site& site, bool val)
+{
+	if (is_binary())
+	{
+		std::string& buff = begin_binary(&site, site.function);
+		begin_event(buff, tag_value, site);
+		put<std::uint8_t>(buff, value_bool);
+		put<std::uint8_t>(buff, val ? 1 : 0);
+		end_binary(buff);
+		return;
+	}
+	if (log_deferred(site, &val, sizeof(bool), &debug::format_raw<bool>))
+		return;
+	log_text(value_prefix(site) + (val ? "1" : "0"), site.function);
+}
+
+void debug::setRotation(const rotation_policy& policy)
+{
+	rotation().set(policy);
+}
+
+void debug::setSingleFile(std::filesystem::path file)
+{
+	single().set(std::move(file));
+}
+
+bool debug::setCompression(const compression_policy& policy)
+{
+	auto setup = std::make_shared<compression_setup>();
+	setup->method = policy.method;
+	setup->level = policy.level;
+	switch (policy.method)
+	{
+	case log_compression::none:
+		break;
+	case log_compression::zstd:
+#ifdef ENH_LOG_ZSTD
+		if (!policy.dictionary.empty())
+		{
+			std::ifstream in(policy.dictionary, std::ios::binary);
+			if (!in)
+				return false;
+			std::vector<char> dict((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+			setup->dict = ZSTD_createCDict(dict.data(), dict.size(), policy.level);
+			if (!setup->dict)
+				return false;
+		}
+		break;
+#else
+		return false;
+#endif
+	}
+	compression().set(std::move(setup));
+	return true;
+}
+
+bool debug::writeSiteDictionary(const std::filesystem::path& file)
+{
+	std::string dict;
+	for (const call_site* site : known_sites().list())
+	{
+		// zstd matches best against the end of a raw dictionary, text goes last
+		put<std::uint8_t>(dict, tag_site);
+		put<std::uint32_t>(dict, site_id(*site));
+		put<std::uint32_t>(dict, static_cast<std::uint32_t>(site->line));
+		put_str(dict, site->file);
+		put_str(dict, site->function);
+		put_str(dict, site->var);
+	}
+	for (const call_site* site : known_sites().list())
+		dict.append(value_prefix(*site)).push_back('\n');
+	std::ofstream out(file, std::ios::binary | std::ios::trunc | std::ios::out);
+	out.write(dict.data(), static_cast<std::streamsize>(dict.size()));
+	return static_cast<bool>(out);
+}
+
+void debug::setDeferredFormatting(bool enable)
+{
+	deferred = enable;
+}
+
+void debug::LogDeferred(const call_site& site, const void* val, std::size_t size, value_formatter format)
+{
+	if (log_deferred(site, val, size, format))
+		return;
+	std::ostringstream out;
+	format(out, val);
+	LogValue(site, out.str());
+}
+
+void debug::setOptimisation(int level)
+{
+	runtimeOptimisation.store(std::clamp(level, 0, 5), std::memory_order_relaxed);
+}
+
+int debug::getOptimisation()
+{
+	return runtimeOptimisation.load(std::memory_order_relaxed);
+}
+
+// the starting level from ENH_LOG_OPTIMISATION, read before main
+const bool optimisationFromEnv = []() {
+	const char* level = std::getenv("ENH_LOG_OPTIMISATION");
+	if (level && *level)
+		debug::setOptimisation(std::atoi(level));
+	return true;
+}();
+
+void debug::setFlushInterval(std::chrono::milliseconds interval)
+{
+	flushInterval = std::chrono::nanoseconds(interval).count();
+}
+
+std::filesystem::path debug::getFile(std::thread::id id, std::string function)
+{
+	if (own.text.ready && id == std::this_thread::get_id())
+		return own.text.path;
+	bool setup = false;
+	std::filesystem::path file = thread_path(id, function, setup);
+	if (single().active.load())
+		file = single().file();
+	if (setup && !is_binary())
+		write(thread_header(id, function), file);
+	return file;
+}
+
+void debug::Log(std::string lg, std::string function)
+{
+	if (is_binary())
+	{
+		std::string& buff = begin_binary(nullptr, function.c_str());
+		put<std::uint8_t>(buff, tag_text);
+		put_time(buff);
+		put_str(buff, lg.data(), lg.size());
+		end_binary(buff);
+		return;
+	}
+	log_text(std::move(lg), function.c_str());
 }
 
 void debug::Log(std::string file, std::string function, unsigned long line)
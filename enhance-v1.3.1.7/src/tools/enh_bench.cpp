@@ -0,0 +1,418 @@
+/** ***************************************************************************
+	\file enh_bench.cpp
+
+	\brief The microbenchmarks of the library, with results as JSON lines
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	<h3> How To Use</h3>
+
+	- Compile this file with `logger.cpp` as a program (C++17, optimised,
+	with `-DENH_DEBUG_CONTROL=true -DENH_OPTIMISATION=0` so the logging
+	benchmarks have something to measure), the headers in `Header` on the
+	include path as `header/` and as is.
+
+	- Run `enh_bench [-f filter] [-t tag] [-m seconds]`. Each benchmark
+	whose name contains filter is run for at least seconds (0.2 by default)
+	and one JSON object per line is written to the standard output:
+
+	`{"tag":..., "name":..., "params":{...}, "iterations":..., "ns_per_op":
+	..., "ops_per_sec":..., "p50_ns":..., "p99_ns":..., "p999_ns":...}`
+
+	The percentiles are present for benchmarks that time each operation.
+	Give the library version being measured as tag, so runs of two
+	versions can be joined on name and params and compared.
+
+	- Log files of the logging benchmarks are written to the working
+	directory.
+
+******************************************************************************/
+
+#include "confined.enh.h"
+#include "date_time.enh.h"
+#include "histogram.enh.h"
+#include "logger.enh.h"
+#include "queued_process.enh.h"
+#include "timer.enh.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using bench_clock = std::chrono::steady_clock;
+
+	struct options
+	{
+		std::string filter;
+		std::string tag = "enhance-v1.3.1.7";
+		double minSeconds = 0.2;
+	} opt;
+
+	volatile std::uint64_t sink = 0;
+
+	// keeps the compiler from dropping the computation of v
+	template<class T>
+	inline void keep(const T& v)
+	{
+		if constexpr (std::is_arithmetic_v<T>)
+			sink = sink + static_cast<std::uint64_t>(v);
+		else
+		{
+			sink = sink + reinterpret_cast<std::uintptr_t>(&v);
+			std::atomic_signal_fence(std::memory_order_seq_cst);
+		}
+	}
+
+	std::uint64_t nanos_since(bench_clock::time_point start)
+	{
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<
+			std::chrono::nanoseconds>(bench_clock::now() - start).count());
+	}
+
+	std::string json_escape(const std::string& in)
+	{
+		std::string out;
+		for (char c : in)
+		{
+			if (c == '"' || c == '\\')
+				out += '\\';
+			out += c;
+		}
+		return out;
+	}
+
+	// the parameters of a benchmark, written as a JSON object
+	class params
+	{
+		std::vector<std::pair<std::string, std::string>> items;
+
+	public:
+
+		params& add(const std::string& key, const std::string& value)
+		{
+			items.emplace_back(key, "\"" + json_escape(value) + "\"");
+			return *this;
+		}
+
+		params& add(const std::string& key, long long value)
+		{
+			items.emplace_back(key, std::to_string(value));
+			return *this;
+		}
+
+		std::string json() const
+		{
+			std::string out = "{";
+			for (std::size_t i = 0; i < items.size(); ++i)
+				out += (i ? ",\"" : "\"") + items[i].first + "\":" + items[i].second;
+			return out + "}";
+		}
+	};
+
+	bool selected(const std::string& name)
+	{
+		return opt.filter.empty() || name.find(opt.filter) != std::string::npos;
+	}
+
+	void report(const std::string& name, const params& p, std::uint64_t iterations,
+		std::uint64_t totalNanos, const enh::histogram_snapshot* latency = nullptr)
+	{
+		std::ostringstream out;
+		out.precision(6);
+		double perOp = iterations ? static_cast<double>(totalNanos) / iterations : 0.0;
+		out << "{\"tag\":\"" << json_escape(opt.tag) << "\",\"name\":\"" << name
+			<< "\",\"params\":" << p.json() << ",\"iterations\":" << iterations
+			<< ",\"ns_per_op\":" << std::fixed << perOp
+			<< ",\"ops_per_sec\":" << (perOp > 0 ? 1e9 / perOp : 0.0);
+		if (latency && latency->count)
+			out << ",\"p50_ns\":" << latency->percentile(0.5)
+				<< ",\"p99_ns\":" << latency->percentile(0.99)
+				<< ",\"p999_ns\":" << latency->percentile(0.999)
+				<< ",\"max_ns\":" << latency->max;
+		out << "}\n";
+		std::cout << out.str() << std::flush;
+	}
+
+	// runs body(n) with n doubling till it takes minSeconds, reports the
+	// last run
+	template<class Fn>
+	void measure(const std::string& name, const params& p, Fn&& body)
+	{
+		if (!selected(name))
+			return;
+		std::uint64_t n = 1;
+		auto limit = static_cast<std::uint64_t>(opt.minSeconds * 1e9);
+		while (true)
+		{
+			auto start = bench_clock::now();
+			body(n);
+			std::uint64_t took = nanos_since(start);
+			if (took >= limit || n >= (1ULL << 40))
+			{
+				report(name, p, n, took);
+				return;
+			}
+			std::uint64_t next = (took > 0) ? n * limit / took + n / 2 : n * 100;
+			n = (next > n * 100) ? n * 100 : ((next > n) ? next : n * 2);
+		}
+	}
+
+	// post -> process latency of each message by one producer
+	template<class policy>
+	void queue_latency(const std::string& policyName)
+	{
+		std::string name = "queued_process/latency";
+		if (!selected(name))
+			return;
+		enh::log_histogram latency;
+		std::atomic<std::uint64_t> done{ 0 };
+		enh::queued_process<bench_clock::time_point, policy> q(
+			[&](bench_clock::time_point posted) {
+				latency.record(nanos_since(posted));
+				done.fetch_add(1, std::memory_order_relaxed);
+				return enh::tristate::GOOD;
+			});
+		q.start_queue_process();
+		std::uint64_t count = 0;
+		auto start = bench_clock::now();
+		auto limit = static_cast<std::uint64_t>(opt.minSeconds * 1e9);
+		while (nanos_since(start) < limit)
+		{
+			q.postMessage(bench_clock::now());
+			++count;
+			// paced, so the latency is not only the time waiting in a
+			// backlog
+			while (done.load(std::memory_order_relaxed) + 64 < count)
+				std::this_thread::yield();
+		}
+		q.safe_join(std::chrono::nanoseconds(0));
+		std::uint64_t took = nanos_since(start);
+		enh::histogram_snapshot snap = latency.snapshot();
+		report(name, params().add("policy", policyName), count, took, &snap);
+	}
+
+	// messages per second posted by producers threads till processed
+	template<class policy>
+	void queue_throughput(const std::string& policyName, unsigned producers)
+	{
+		measure("queued_process/throughput",
+			params().add("policy", policyName).add("producers", producers),
+			[producers](std::uint64_t n) {
+				std::atomic<std::uint64_t> processed{ 0 };
+				enh::queued_process<std::uint64_t, policy> q([&](std::uint64_t v) {
+					processed.fetch_add(1, std::memory_order_relaxed);
+					keep(v);
+					return enh::tristate::GOOD;
+				});
+				q.start_queue_process();
+				std::vector<std::thread> threads;
+				for (unsigned t = 0; t < producers; ++t)
+					threads.emplace_back([&q, n, producers, t]() {
+						for (std::uint64_t i = t; i < n; i += producers)
+							q.postMessage(i);
+					});
+				for (auto& th : threads)
+					th.join();
+				q.safe_join(std::chrono::nanoseconds(0));
+			});
+	}
+
+	void logging()
+	{
+		const char* formats[] = { "text", "binary" };
+		for (int format = 0; format < 2; ++format)
+		{
+			debug::setFormat(format ? debug::log_format::binary : debug::log_format::text);
+			for (int async = 0; async < 2; ++async)
+			{
+				debug::setAsync(async != 0);
+				for (int level = 0; level <= 5; ++level)
+				{
+					debug::setOptimisation(level);
+					params p;
+					p.add("format", formats[format]).add("async", async).add("runtime_level", level);
+					measure("debug/O3_LOG_LINE", p, [](std::uint64_t n) {
+						for (std::uint64_t i = 0; i < n; ++i)
+							O3_LOG_LINE;
+					});
+					measure("debug/O3_LOG_VAL", p, [](std::uint64_t n) {
+						for (std::uint64_t i = 0; i < n; ++i)
+							O3_LOG_VAL(i);
+					});
+				}
+				debug::flush();
+			}
+		}
+		debug::setAsync(false);
+		debug::setOptimisation(0);
+		debug::setFormat(debug::log_format::text);
+	}
+
+	// lateness of each wake of a thread waiting on a timer
+	template<unsigned period>
+	void timer_jitter()
+	{
+		std::string name = "timer/wake_jitter";
+		if (!selected(name))
+			return;
+		enh::millis<period> tm;
+		enh::log_histogram jitter;
+		tm.wait();
+		auto last = bench_clock::now();
+		auto start = last;
+		std::uint64_t wakes = 0;
+		auto limit = static_cast<std::uint64_t>(opt.minSeconds * 1e9);
+		while (nanos_since(start) < limit || wakes < 20)
+		{
+			tm.wait();
+			auto now = bench_clock::now();
+			auto gap = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+			long long off = gap - static_cast<long long>(period) * 1000000LL;
+			jitter.record(static_cast<std::uint64_t>(off < 0 ? -off : off));
+			last = now;
+			++wakes;
+		}
+		std::uint64_t took = nanos_since(start);
+		enh::histogram_snapshot snap = jitter.snapshot();
+		report(name, params().add("period_ms", period), wakes, took, &snap);
+	}
+
+	void confined()
+	{
+		using fn_confined = enh::confined_base<int>;
+		using inline_confined = enh::confined_base<int,
+			enh::confined_at_most<enh::confined_constant<59>>,
+			enh::confined_at_least<enh::confined_constant<0>>,
+			enh::confined_constant<59>, enh::confined_constant<0>>;
+		measure("confined_base/add_sub", params().add("bounds", "std::function"),
+			[](std::uint64_t n) {
+				fn_confined c([](long long v) { return v <= 59; },
+					[](long long v) { return v >= 0; },
+					[]() { return 59; }, []() { return 0; }, 0);
+				for (std::uint64_t i = 0; i < n; ++i)
+				{
+					keep(c.add(static_cast<unsigned long long>(i & 127)));
+					keep(c.sub(static_cast<unsigned long long>(i & 63)));
+				}
+			});
+		measure("confined_base/add_sub", params().add("bounds", "inline"),
+			[](std::uint64_t n) {
+				inline_confined c({}, {}, {}, {}, 0);
+				for (std::uint64_t i = 0; i < n; ++i)
+				{
+					keep(c.add(static_cast<unsigned long long>(i & 127)));
+					keep(c.sub(static_cast<unsigned long long>(i & 63)));
+				}
+			});
+		measure("static_confined/add_sub", params(), [](std::uint64_t n) {
+			enh::static_confined<int, 0, 59> c(0);
+			for (std::uint64_t i = 0; i < n; ++i)
+			{
+				keep(c.add(static_cast<unsigned long long>(i & 127)));
+				keep(c.sub(static_cast<unsigned long long>(i & 63)));
+			}
+		});
+	}
+
+	void dates()
+	{
+		for (long long span : { 1LL, 31LL, 366LL, 36525LL, 3652425LL })
+			measure("date/addDay", params().add("days", span), [span](std::uint64_t n) {
+				enh::date d(1, 0, 2000, 6, 0);
+				for (std::uint64_t i = 0; i < n; ++i)
+				{
+					d.addDay(static_cast<unsigned long long>(span));
+					d.subDay(static_cast<unsigned long long>(span - 1));
+				}
+				keep(d.getDaysSinceEpoch());
+			});
+	}
+
+	void formatting()
+	{
+		enh::DateTime dt(5, 2, 2024, 2, 64, 7, 8, 9, 123456789);
+		measure("DateTime/getStringDateTime", params(), [&dt](std::uint64_t n) {
+			for (std::uint64_t i = 0; i < n; ++i)
+			{
+				std::string s = dt.getStringDateTime();
+				keep(s.size());
+			}
+		});
+		measure("DateTime/getStringDateTime", params().add("format", "custom"),
+			[&dt](std::uint64_t n) {
+				for (std::uint64_t i = 0; i < n; ++i)
+				{
+					std::string s = dt.getStringDateTime("hour:min:sec ; dd/mm/yyyy");
+					keep(s.size());
+				}
+			});
+		measure("DateTime/format_to", params(), [&dt](std::uint64_t n) {
+			char buf[enh::DateTime::max_string_size];
+			for (std::uint64_t i = 0; i < n; ++i)
+				keep(dt.format_to(buf, buf + sizeof(buf)) - buf);
+		});
+		measure("DateTime/format_iso_to", params().add("digits", 9), [&dt](std::uint64_t n) {
+			char buf[64];
+			for (std::uint64_t i = 0; i < n; ++i)
+				keep(dt.format_iso_to(buf, buf + sizeof(buf), 9) - buf);
+		});
+	}
+}
+
+int main(int argc, char** argv)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "-f" && i + 1 < argc)
+			opt.filter = argv[++i];
+		else if (arg == "-t" && i + 1 < argc)
+			opt.tag = argv[++i];
+		else if (arg == "-m" && i + 1 < argc)
+			opt.minSeconds = std::stod(argv[++i]);
+		else
+		{
+			std::cerr << "usage : enh_bench [-f filter] [-t tag] [-m seconds]\n";
+			return 1;
+		}
+	}
+
+	queue_latency<enh::unbounded_queue>("unbounded_queue");
+	queue_latency<enh::bounded_ring<1024>>("bounded_ring");
+	for (unsigned producers : { 1U, 2U, 4U, 8U })
+	{
+		queue_throughput<enh::unbounded_queue>("unbounded_queue", producers);
+		queue_throughput<enh::bounded_ring<1024>>("bounded_ring", producers);
+	}
+	logging();
+	timer_jitter<5>();
+	timer_jitter<50>();
+	confined();
+	dates();
+	formatting();
+	return 0;
+}
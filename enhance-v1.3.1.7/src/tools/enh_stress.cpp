@@ -0,0 +1,712 @@
+/** ***************************************************************************
+	\file enh_stress.cpp
+
+	\brief The stress test of queued_process and timer under contention,
+	with results as JSON lines
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	<h3> How To Use</h3>
+
+	- Compile this file with `logger.cpp` as a program (C++17, optimised),
+	the headers in `Header` on the include path as `header/` and as is.
+
+	- Run `enh_stress [-d seconds] [-p producers] [-w waiters] [-s seed]
+	[-t tag]`. Rounds run till seconds (60 by default) pass, alternating
+	between the queue policies and the timer.
+
+	- A queue round starts producers (twice the cores by default) against
+	one queued_process with random wait strategy and batch limit, some
+	bursting and some posting sparsely, then ends in a random way :
+	safe_join after the producers stop, or stopQueue, force_join or
+	WaitForQueueStop while they are still posting. Every message is
+	checked to be processed at most once, and all must be processed on a
+	safe_join. A sparse post not processed within a second is a lost
+	wakeup of the processing thread.
+
+	- A timer round starts waiters (16 by default) on one millis<5>, each
+	with wait, wait_for or wait_until at random, while the round cancels
+	and resets an event they wait on. A wait_until that times out after
+	its cycle was reached is a lost wakeup, one whose cycle never came is a
+	stall.
+
+	- Before the rounds, fixed edge cases are checked once (like a queue
+	restarted after its handler failed), each written as a JSON object of
+	kind check.
+
+	- One JSON object per round is written to the standard output, with
+	p50 / p99 / p99.9 / max of the time producers spent in postMessage,
+	of post to process latency, of time mtxQueue was held (from
+	with_stats), of waiter wake error and of timer lateness. The last line
+	is a summary, the exit status is 1 if any round failed.
+
+	- Give the seed printed in the summary to repeat a run.
+
+******************************************************************************/
+
+#include "histogram.enh.h"
+#include "queued_process.enh.h"
+#include "rate_limiter.enh.h"
+#include "timer.enh.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include "shared_queue.enh.h"
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	using stress_clock = std::chrono::steady_clock;
+
+	struct options
+	{
+		double seconds = 60.0;
+		unsigned producers = 0;
+		unsigned waiters = 16;
+		std::uint64_t seed = 0;
+		std::string tag = "enhance-v1.3.1.7";
+	} opt;
+
+	// messages a round can post at most, each is checked by id
+	constexpr std::uint64_t round_capacity = 1ULL << 21;
+
+	std::uint64_t nanos(stress_clock::duration d)
+	{
+		auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+		return ns < 0 ? 0 : static_cast<std::uint64_t>(ns);
+	}
+
+	void write_histogram(std::ostringstream& out, const char* key,
+		const enh::histogram_snapshot& h)
+	{
+		out << ",\"" << key << "\":{\"count\":" << h.count
+			<< ",\"p50\":" << h.percentile(0.5) << ",\"p99\":" << h.percentile(0.99)
+			<< ",\"p999\":" << h.percentile(0.999) << ",\"max\":" << h.max << "}";
+	}
+
+	const char* strategy_name(enh::wait_strategy w)
+	{
+		switch (w)
+		{
+		case enh::wait_strategy::spin_park:
+			return "spin_park";
+		case enh::wait_strategy::spin_yield:
+			return "spin_yield";
+		case enh::wait_strategy::busy_spin:
+			return "busy_spin";
+		default:
+			return "park";
+		}
+	}
+
+	enum class ending
+	{
+		safe_join,
+		stop_queue,
+		force_join,
+		wait_stop
+	};
+
+	const char* ending_name(ending e)
+	{
+		switch (e)
+		{
+		case ending::stop_queue:
+			return "stopQueue";
+		case ending::force_join:
+			return "force_join";
+		case ending::wait_stop:
+			return "WaitForQueueStop";
+		default:
+			return "safe_join";
+		}
+	}
+
+	// the state of one queue round shared by every thread
+	struct queue_round
+	{
+		std::vector<std::atomic<std::uint8_t>> seen;
+		std::atomic<std::uint64_t> nextId{ 0 };
+		std::atomic<std::uint64_t> posted{ 0 };
+		std::atomic<std::uint64_t> processed{ 0 };
+		std::atomic<std::uint64_t> duplicates{ 0 };
+		std::atomic<std::uint64_t> lostWakeups{ 0 };
+		std::atomic<bool> stopPosting{ false };
+		std::atomic<bool> stopping{ false };
+		enh::log_histogram postTime;
+
+		queue_round() : seen(round_capacity) {}
+	};
+
+	template<class policy>
+	bool run_queue_round(const char* policyName, std::mt19937_64& rng,
+		unsigned round)
+	{
+		auto state = std::make_unique<queue_round>();
+		queue_round& r = *state;
+		using queue_type = enh::queued_process<std::uint64_t, enh::with_stats<policy>>;
+		queue_type q([&r](std::uint64_t id) {
+			if (r.seen[id].fetch_add(1, std::memory_order_relaxed) != 0)
+				r.duplicates.fetch_add(1, std::memory_order_relaxed);
+			r.processed.fetch_add(1, std::memory_order_relaxed);
+			return enh::tristate::GOOD;
+		});
+
+		static const enh::wait_strategy strategies[] = { enh::wait_strategy::park,
+			enh::wait_strategy::spin_park, enh::wait_strategy::spin_yield };
+		enh::wait_strategy strategy = strategies[rng() % 3];
+		std::size_t batchLimit = (rng() % 3 == 0) ? 1 + rng() % 128 : 1;
+		ending end = static_cast<ending>(rng() % 4);
+		auto length = std::chrono::milliseconds(50 + rng() % 450);
+		q.setWaitStrategy(strategy, 1 + rng() % 8192);
+		q.setBatchLimit(batchLimit);
+		q.start_queue_process();
+
+		unsigned producers = opt.producers;
+		std::vector<std::thread> threads;
+		for (unsigned t = 0; t < producers; ++t)
+		{
+			std::uint64_t threadSeed = rng();
+			// a quarter post sparsely, so the processing thread goes back to
+			// sleep between messages
+			bool sparse = (t % 4 == 3);
+			threads.emplace_back([&r, &q, threadSeed, sparse]() {
+				std::mt19937_64 local(threadSeed);
+				while (!r.stopPosting.load(std::memory_order_relaxed))
+				{
+					std::uint64_t id = r.nextId.fetch_add(1, std::memory_order_relaxed);
+					if (id >= round_capacity)
+						return;
+					auto start = stress_clock::now();
+					q.postMessage(id);
+					r.postTime.record(nanos(stress_clock::now() - start));
+					r.posted.fetch_add(1, std::memory_order_relaxed);
+					if (sparse)
+					{
+						// a running queue that processes nothing for a second
+						// while this message waits has lost its wakeup
+						auto limit = stress_clock::now() + std::chrono::seconds(1);
+						std::uint64_t before = r.processed.load();
+						while (r.seen[id].load() == 0 && !r.stopping.load())
+						{
+							if (stress_clock::now() > limit)
+							{
+								if (r.processed.load() == before && !r.stopping.load())
+									r.lostWakeups.fetch_add(1, std::memory_order_relaxed);
+								break;
+							}
+							std::this_thread::sleep_for(std::chrono::microseconds(50));
+						}
+						std::this_thread::sleep_for(std::chrono::microseconds(local() % 200));
+					}
+					else if (local() % 64 == 0)
+						std::this_thread::yield();
+				}
+			});
+		}
+
+		std::this_thread::sleep_for(length);
+		r.stopping = true;
+		bool drained = true;
+		switch (end)
+		{
+		case ending::safe_join:
+			r.stopPosting = true;
+			for (auto& th : threads)
+				th.join();
+			drained = q.safe_join(stress_clock::now() + std::chrono::seconds(10));
+			break;
+		case ending::stop_queue:
+			q.stopQueue();
+			std::this_thread::sleep_for(std::chrono::milliseconds(rng() % 5));
+			r.stopPosting = true;
+			q.WaitForQueueStop();
+			break;
+		case ending::force_join:
+			q.force_join();
+			r.stopPosting = true;
+			break;
+		case ending::wait_stop:
+			q.stopQueue();
+			q.WaitForQueueStop();
+			r.stopPosting = true;
+			break;
+		}
+		for (auto& th : threads)
+			if (th.joinable())
+				th.join();
+		enh::queue_stats_snapshot stats = q.getStats();
+		q.force_join();
+
+		std::uint64_t posted = r.posted.load();
+		std::uint64_t processed = r.processed.load();
+		bool lost = (end == ending::safe_join) && (!drained || processed != posted);
+		bool failed = lost || r.duplicates.load() != 0 || processed > posted
+			|| r.lostWakeups.load() != 0;
+
+		std::ostringstream out;
+		out << "{\"tag\":\"" << opt.tag << "\",\"round\":" << round
+			<< ",\"kind\":\"queue\",\"policy\":\"" << policyName
+			<< "\",\"wait_strategy\":\"" << strategy_name(strategy)
+			<< "\",\"batch_limit\":" << batchLimit << ",\"ending\":\"" << ending_name(end)
+			<< "\",\"producers\":" << producers << ",\"posted\":" << posted
+			<< ",\"processed\":" << processed << ",\"duplicates\":" << r.duplicates.load()
+			<< ",\"lost_messages\":" << (lost ? posted - processed : 0)
+			<< ",\"lost_wakeups\":" << r.lostWakeups.load()
+			<< ",\"high_water\":" << stats.high_water;
+		write_histogram(out, "post_ns", r.postTime.snapshot());
+		write_histogram(out, "latency_ns", stats.wait_ns);
+		write_histogram(out, "lock_hold_ns", stats.lock_hold_ns);
+		out << ",\"failed\":" << (failed ? "true" : "false") << "}\n";
+		std::cout << out.str() << std::flush;
+		return !failed;
+	}
+
+	// writes the result of a check run once before the rounds
+	bool report_check(const char* name, bool ok)
+	{
+		std::cout << "{\"tag\":\"" << opt.tag << "\",\"kind\":\"check\",\"name\":\""
+			<< name << "\",\"failed\":" << (ok ? "false" : "true") << "}\n" << std::flush;
+		return ok;
+	}
+
+	// an executor running each task on a thread of its own
+	struct thread_executor
+	{
+		std::mutex mtx;
+		std::vector<std::thread> threads;
+
+		void post(std::function<void()> task)
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			threads.emplace_back(std::move(task));
+		}
+
+		// tasks may post more while joined
+		void join()
+		{
+			for (;;)
+			{
+				std::vector<std::thread> running;
+				{
+					std::lock_guard<std::mutex> lock(mtx);
+					running.swap(threads);
+				}
+				if (running.empty())
+					return;
+				for (auto& th : running)
+					th.join();
+			}
+		}
+	};
+
+	// waits till done() or a second passes
+	template<class test>
+	bool wait_till(test done)
+	{
+		auto limit = stress_clock::now() + std::chrono::seconds(1);
+		while (!done())
+		{
+			if (stress_clock::now() > limit)
+				return false;
+			std::this_thread::sleep_for(std::chrono::microseconds(100));
+		}
+		return true;
+	}
+
+	// a queue on an executor whose handler failed drains again once 
+	// restarted
+	bool check_restart_after_error()
+	{
+		std::atomic<bool> fail{ true };
+		std::atomic<unsigned> drained{ 0 };
+		thread_executor pool;
+		auto exec = [&pool](std::function<void()> task) { pool.post(std::move(task)); };
+		enh::queued_process<int> q([&](int) {
+			if (fail.exchange(false))
+				return enh::tristate::ERROR;
+			drained.fetch_add(1);
+			return enh::tristate::GOOD;
+		});
+		q.start_queue_process(exec, 4);
+		q.postMessage(0);
+		bool ok = wait_till([&q]() { return q.isQueueExited(); });
+		q.WaitForQueueStop();
+		q.start_queue_process(exec, 4);
+		for (int i = 0; i < 3; ++i)
+			q.postMessage(i);
+		ok = wait_till([&drained]() { return drained.load() == 3; }) && ok;
+		q.force_join();
+		pool.join();
+		return report_check("restart_after_error", ok);
+	}
+
+	// a message whose copy throws while armed, moves never throw
+	struct throwing_message
+	{
+		static inline std::atomic<bool> armed{ false };
+		int value = 0;
+
+		explicit throwing_message(int v) noexcept : value(v) {}
+
+		throwing_message(const throwing_message& other) : value(other.value)
+		{
+			if (armed.exchange(false))
+				throw std::runtime_error("copy failed");
+		}
+
+		throwing_message(throwing_message&& other) noexcept = default;
+	};
+
+	// a post whose message copy throws leaves the ring usable
+	template<class policy>
+	bool check_throwing_post(const char* name)
+	{
+		std::atomic<int> sum{ 0 };
+		enh::queued_process<throwing_message, policy> q([&sum](throwing_message m) {
+			sum.fetch_add(m.value);
+			return enh::tristate::GOOD;
+		});
+		q.start_queue_process();
+		throwing_message one(1);
+		bool thrown = false;
+		throwing_message::armed = true;
+		try
+		{
+			q.postMessage(one);
+		}
+		catch (const std::runtime_error&)
+		{
+			thrown = true;
+		}
+		for (int i = 0; i < 3; ++i)
+			q.postMessage(one);
+		bool drained = q.safe_join(stress_clock::now() + std::chrono::seconds(1));
+		q.force_join();
+		return report_check(name, thrown && drained && sum.load() == 3);
+	}
+
+#if defined(__unix__) || defined(__APPLE__)
+	// a message of the shared ring built from a source that may throw
+	struct shm_message
+	{
+		int value;
+
+		explicit shm_message(int v) noexcept : value(v) {}
+
+		explicit shm_message(const throwing_message& source) : value(0)
+		{
+			throwing_message copy(source);
+			value = copy.value;
+		}
+	};
+
+	// a shared ring post whose message constructor throws leaves it usable
+	bool check_throwing_shared_post()
+	{
+		std::string name = "/enh_stress_check_" + std::to_string(::getpid());
+		std::atomic<int> sum{ 0 };
+		bool thrown = false;
+		bool drained = false;
+		{
+			enh::queued_process<shm_message, enh::shared_ring<16>> q(
+				[&sum](shm_message m) {
+					sum.fetch_add(m.value);
+					return enh::tristate::GOOD;
+				}, enh::shm_config{ name, true });
+			q.start_queue_process();
+			throwing_message one(1);
+			throwing_message::armed = true;
+			try
+			{
+				q.emplaceMessage(one);
+			}
+			catch (const std::runtime_error&)
+			{
+				thrown = true;
+			}
+			for (int i = 0; i < 3; ++i)
+				q.emplaceMessage(one);
+			drained = q.safe_join(stress_clock::now() + std::chrono::seconds(1));
+			q.force_join();
+		}
+		return report_check("throwing_post_shared", thrown && drained && sum.load() == 3);
+	}
+
+	// a region whose creator died while setting it up fails to open
+	bool check_shared_setup_timeout()
+	{
+		std::string name = "/enh_stress_setup_" + std::to_string(::getpid());
+		int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		bool ok = fd >= 0 && ::ftruncate(fd, 4096) == 0;
+		if (ok)
+		{
+			void* at = ::mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			ok = at != MAP_FAILED;
+			if (ok)
+			{
+				// the state word after the 8 byte magic, left at setting up
+				std::uint32_t settingUp = 1;
+				std::memcpy(static_cast<char*>(at) + 8, &settingUp, sizeof(settingUp));
+				::munmap(at, 4096);
+			}
+		}
+		if (fd >= 0)
+			::close(fd);
+		bool failed = false;
+		if (ok)
+		{
+			enh::shm_config cfg{ name, true };
+			cfg.setupTimeout = std::chrono::milliseconds(50);
+			try
+			{
+				enh::shm_ring<shm_message, 16> ring(cfg);
+			}
+			catch (const std::runtime_error&)
+			{
+				failed = true;
+			}
+		}
+		enh::shm_ring<shm_message, 16>::remove(name);
+		return report_check("shared_setup_timeout", ok && failed);
+	}
+#endif
+
+	// rate_limiter at the limits of its arithmetic and of the clock, 
+	// nothing here may block
+	bool check_rate_limits()
+	{
+		auto start = stress_clock::now();
+		// a token takes longer than the clock can count
+		enh::rate_limiter slow(1e-15, 4);
+		bool ok = slow.try_acquire() && !slow.try_acquire() && !slow.acquire(1);
+		enh::rate_limiter fast(1000.0, 10);
+		ok = ok && !fast.try_acquire(UINT64_MAX) && !fast.acquire(UINT64_MAX)
+			&& fast.acquire_for(1, std::chrono::nanoseconds::max())
+			&& fast.acquire_for(1, std::chrono::hours::max())
+			&& fast.acquire_for(1, std::chrono::duration<double>::max())
+			&& fast.acquire_for(1, std::chrono::nanoseconds::min())
+			&& fast.acquire(1, enh::time_pt::max());
+		ok = ok && stress_clock::now() - start < std::chrono::seconds(1);
+		return report_check("rate_limits", ok);
+	}
+
+	unsigned run_checks()
+	{
+		unsigned failures = 0;
+		failures += check_restart_after_error() ? 0 : 1;
+		failures += check_rate_limits() ? 0 : 1;
+		failures += check_throwing_post<enh::bounded_ring<16>>("throwing_post_ring") ? 0 : 1;
+		failures += check_throwing_post<enh::with_stats<enh::bounded_ring<16>>>(
+			"throwing_post_ring_stats") ? 0 : 1;
+#if defined(__unix__) || defined(__APPLE__)
+		failures += check_throwing_shared_post() ? 0 : 1;
+		failures += check_shared_setup_timeout() ? 0 : 1;
+#endif
+		return failures;
+	}
+
+	bool run_timer_round(std::mt19937_64& rng, unsigned round)
+	{
+		constexpr unsigned period = 5;
+		constexpr auto period_ns = static_cast<long long>(period) * 1000000LL;
+		enh::millis<period> tm;
+		enh::cancel_event cancel;
+		enh::log_histogram wakeError;
+		enh::log_histogram cancelDelay;
+		std::atomic<std::uint64_t> wakes{ 0 };
+		std::atomic<std::uint64_t> lostWakeups{ 0 };
+		std::atomic<std::uint64_t> stalls{ 0 };
+		std::atomic<bool> done{ false };
+		std::atomic<stress_clock::rep> cancelledAt{ 0 };
+		// raised before each cancel, so a waiter can tell a cancel it woke
+		// for from a timeout even after the event was reset
+		std::atomic<std::uint64_t> cancelCount{ 0 };
+		auto length = std::chrono::milliseconds(200 + rng() % 800);
+		tm.start_timer();
+		// the timer notifies at about base + cycle * period
+		auto base = stress_clock::now();
+
+		std::vector<std::thread> threads;
+		for (unsigned w = 0; w < opt.waiters; ++w)
+		{
+			std::uint64_t threadSeed = rng();
+			threads.emplace_back([&, threadSeed]() {
+				std::mt19937_64 local(threadSeed);
+				while (!done.load())
+				{
+					unsigned cycles = 1 + static_cast<unsigned>(local() % 4);
+					unsigned long long expected = tm.elapsed() + cycles;
+					std::uint64_t cancelsBefore = cancelCount.load();
+					long long over = 0;
+					switch (local() % 3)
+					{
+					case 0:
+						over = static_cast<long long>(tm.wait(expected));
+						break;
+					case 1:
+						// polls each cycle, only counted
+						tm.wait_for(cycles, [&done]() { return !done.load(); });
+						wakes.fetch_add(1, std::memory_order_relaxed);
+						continue;
+					default:
+					{
+						enh::time_pt limit = enh::high_res::now() + std::chrono::nanoseconds(period_ns * cycles)
+							+ std::chrono::milliseconds(250);
+						over = tm.wait_until(expected, cancel, limit);
+						bool wasCancelled = cancel.isCancelled()
+							|| cancelCount.load() != cancelsBefore;
+						if (over < 0 && !wasCancelled)
+						{
+							if (tm.elapsed() >= expected)
+								lostWakeups.fetch_add(1, std::memory_order_relaxed);
+							else if (!done.load())
+								stalls.fetch_add(1, std::memory_order_relaxed);
+						}
+						else if (over < 0)
+						{
+							auto at = cancelledAt.load();
+							auto now = stress_clock::now().time_since_epoch().count();
+							if (at && now > at)
+								cancelDelay.record(nanos(stress_clock::duration(now - at)));
+							std::this_thread::sleep_for(std::chrono::milliseconds(1));
+							continue;
+						}
+						break;
+					}
+					}
+					auto due = base + std::chrono::nanoseconds(period_ns
+						* static_cast<long long>(expected + static_cast<unsigned long long>(over)));
+					wakeError.record(nanos(stress_clock::now() - due));
+					wakes.fetch_add(1, std::memory_order_relaxed);
+				}
+			});
+		}
+
+		auto stop = stress_clock::now() + length;
+		while (stress_clock::now() < stop)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(10 + rng() % 40));
+			cancelCount.fetch_add(1);
+			cancelledAt = stress_clock::now().time_since_epoch().count();
+			cancel.cancel();
+			std::this_thread::sleep_for(std::chrono::milliseconds(rng() % 3));
+			cancel.reset();
+		}
+		done = true;
+		cancelCount.fetch_add(1);
+		cancel.cancel();
+		for (auto& th : threads)
+			th.join();
+		bool joined = rng() % 2 == 0;
+		if (joined)
+		{
+			tm.stop();
+			tm.join();
+		}
+		else
+			tm.force_join();
+		enh::timer_stats stats = tm.stats();
+
+		bool failed = lostWakeups.load() != 0 || stalls.load() != 0;
+		std::ostringstream out;
+		out << "{\"tag\":\"" << opt.tag << "\",\"round\":" << round
+			<< ",\"kind\":\"timer\",\"period_ms\":" << period
+			<< ",\"waiters\":" << opt.waiters << ",\"ending\":\""
+			<< (joined ? "join" : "force_join") << "\",\"wakes\":" << wakes.load()
+			<< ",\"lost_wakeups\":" << lostWakeups.load() << ",\"stalls\":" << stalls.load()
+			<< ",\"missed_ticks\":" << stats.missed;
+		write_histogram(out, "wake_error_ns", wakeError.snapshot());
+		write_histogram(out, "cancel_delay_ns", cancelDelay.snapshot());
+		write_histogram(out, "lateness_ns", stats.lateness);
+		out << ",\"failed\":" << (failed ? "true" : "false") << "}\n";
+		std::cout << out.str() << std::flush;
+		return !failed;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	opt.seed = std::random_device{}();
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "-d" && i + 1 < argc)
+			opt.seconds = std::stod(argv[++i]);
+		else if (arg == "-p" && i + 1 < argc)
+			opt.producers = static_cast<unsigned>(std::stoul(argv[++i]));
+		else if (arg == "-w" && i + 1 < argc)
+			opt.waiters = static_cast<unsigned>(std::stoul(argv[++i]));
+		else if (arg == "-s" && i + 1 < argc)
+			opt.seed = std::stoull(argv[++i]);
+		else if (arg == "-t" && i + 1 < argc)
+			opt.tag = argv[++i];
+		else
+		{
+			std::cerr << "usage : enh_stress [-d seconds] [-p producers] "
+				"[-w waiters] [-s seed] [-t tag]\n";
+			return 1;
+		}
+	}
+	if (opt.producers == 0)
+	{
+		unsigned cores = std::thread::hardware_concurrency();
+		opt.producers = cores ? 2 * cores : 8;
+	}
+
+	std::mt19937_64 rng(opt.seed);
+	auto end = stress_clock::now() + std::chrono::duration_cast<stress_clock::duration>(
+		std::chrono::duration<double>(opt.seconds));
+	unsigned rounds = 0;
+	unsigned failures = run_checks();
+	while (stress_clock::now() < end)
+	{
+		bool ok = true;
+		switch (rounds % 3)
+		{
+		case 0:
+			ok = run_queue_round<enh::unbounded_queue>("unbounded_queue", rng, rounds);
+			break;
+		case 1:
+			ok = run_queue_round<enh::bounded_ring<1024>>("bounded_ring", rng, rounds);
+			break;
+		default:
+			ok = run_timer_round(rng, rounds);
+			break;
+		}
+		failures += ok ? 0 : 1;
+		++rounds;
+	}
+	std::cout << "{\"tag\":\"" << opt.tag << "\",\"kind\":\"summary\",\"seed\":" << opt.seed
+		<< ",\"rounds\":" << rounds << ",\"failures\":" << failures << "}\n";
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,826 @@
+/** ***************************************************************************
+	\file log_decoder.cpp
+
+	\brief The tool to turn binary log files back into text
+
+	Created 14 October 2026
+
+	This file is part of project Enhance C++ Libraries.
+
+	Copyright 2020 Harith Manoj <harithpub@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	<h3> How To Use</h3>
+
+	- Compile this file alone as a program (C++17).
+
+	- Run `log_decoder [-t] file.blog...`, the records are written to the
+	standard output in the layout of the text `.log` files. With `-t` each
+	line starts with its time stamp, nanoseconds since the system clock
+	epoch.
+
+	- Flight recorder files (`.ring`) are read the same way, even if the 
+	program that wrote them died.
+
+	- Built with ENH_LOG_ZSTD defined (link libzstd), compressed files 
+	(`.blog.zst`, see `debug::setCompression`) are read too, pass 
+	`-D dictionary` before them if they were written with a dictionary. Only
+	whole zstd frames are decoded, so a file cut short is read up to its 
+	last full frame.
+
+	- Run `log_decoder -q from until file.blog...` to write only the records
+	logged from time from to time until (nanoseconds since the system clock
+	epoch, as printed by `-t`). The index beside each file (`.blog.idx`, 
+	see `debug::setIndexInterval`) is binary searched for the window and 
+	only the blocks in it are read from the mapped file; files without an 
+	index are read whole. Add `-p file:line` (repeatable) to keep only the
+	records of those logging points, blocks without them are skipped.
+
+	- Run `log_decoder -c file.blog... > trace.json` to write the trace 
+	events (see `debug::setTracing`) of all files as one Chrome trace event 
+	JSON file, to open in chrome://tracing or https://ui.perfetto.dev. Each
+	thread record of the files is one track.
+
+	The layout of binary files is described in `logger.cpp`.
+
+******************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef ENH_LOG_ZSTD
+#include <zstd.h>
+#endif
+
+namespace
+{
+	enum record_tag : std::uint8_t { tag_thread = 1, tag_site, tag_line, tag_desc, tag_value, tag_text, tag_trace, tag_sample };
+
+	enum value_type : std::uint8_t { value_string = 0, value_signed, value_unsigned, value_floating, value_bool };
+
+	struct site
+	{
+		std::uint32_t line = 0;
+		std::string file;
+		std::string function;
+		std::string var;
+	};
+
+	// a logging point asked for with -p, file matches the end of the path
+	struct point
+	{
+		std::string file;
+		std::uint32_t line = 0;
+	};
+
+	struct options
+	{
+		bool stamps = false;
+		std::vector<char> dict;
+		// -q, the window of record times and the index is used
+		bool query = false;
+		std::int64_t from = std::numeric_limits<std::int64_t>::min();
+		std::int64_t until = std::numeric_limits<std::int64_t>::max();
+		std::vector<point> points;
+
+		bool in_window(std::int64_t time) const { return time >= from && time <= until; }
+
+		bool matches(const site& s) const
+		{
+			if (points.empty())
+				return true;
+			for (const point& p : points)
+				if (s.line == p.line && s.file.size() >= p.file.size()
+					&& s.file.compare(s.file.size() - p.file.size(), p.file.size(), p.file) == 0)
+					return true;
+			return false;
+		}
+	};
+
+	class reader
+	{
+		const char* data;
+		std::size_t size;
+		std::size_t pos = 0;
+
+	public:
+		explicit reader(const std::vector<char>& in) : data(in.data()), size(in.size()) {}
+
+		reader(const char* in, std::size_t length, std::size_t at = 0) : data(in), size(length), pos(at) {}
+
+		bool done() const { return pos >= size; }
+
+		std::size_t position() const { return pos; }
+
+		bool skip_magic(const char* magic = "ENHBLOG1")
+		{
+			if (size >= 8 && std::memcmp(data, magic, 8) == 0)
+			{
+				pos = 8;
+				return true;
+			}
+			return false;
+		}
+
+		template<class T>
+		bool get(T& val)
+		{
+			if (size - pos < sizeof(T))
+				return false;
+			std::memcpy(&val, data + pos, sizeof(T));
+			pos += sizeof(T);
+			return true;
+		}
+
+		bool get_str(std::string& str)
+		{
+			std::uint32_t len = 0;
+			if (!get(len) || size - pos < len)
+				return false;
+			str.assign(data + pos, len);
+			pos += len;
+			return true;
+		}
+	};
+
+	template<class T>
+	T read_at(const std::vector<char>& data, std::size_t pos)
+	{
+		T val;
+		std::memcpy(&val, data.data() + pos, sizeof(T));
+		return val;
+	}
+
+	// turns a flight recorder file into the records of a binary log
+	bool unwrap_ring(std::vector<char>& data)
+	{
+		const std::size_t header = 64;
+		if (data.size() < header || std::memcmp(data.data(), "ENHRING1", 8) != 0)
+			return false;
+		std::uint64_t siteCapacity = read_at<std::uint64_t>(data, 8);
+		std::uint64_t capacity = read_at<std::uint64_t>(data, 16);
+		std::uint64_t siteUsed = read_at<std::uint64_t>(data, 24);
+		std::uint64_t head = read_at<std::uint64_t>(data, 32);
+		std::uint64_t tail = read_at<std::uint64_t>(data, 40);
+		if (capacity == 0 || data.size() < header + siteCapacity + capacity || siteUsed > siteCapacity 
+			|| tail > head || head - tail > capacity)
+			return false;
+		const char* ring = data.data() + header + siteCapacity;
+		auto copy = [&](std::uint64_t pos, char* dst, std::size_t size) {
+			for (std::size_t i = 0; i < size; ++i)
+				dst[i] = ring[(pos + i) % capacity];
+		};
+		std::vector<char> out(data.begin(), data.begin() + 8);
+		std::memcpy(out.data(), "ENHBLOG1", 8);
+		out.insert(out.end(), data.begin() + header, data.begin() + header + siteUsed);
+		for (std::uint64_t pos = tail; pos < head;)
+		{
+			std::uint32_t size;
+			copy(pos, reinterpret_cast<char*>(&size), sizeof(size));
+			if (pos + sizeof(size) + size > head)
+				break;
+			std::size_t at = out.size();
+			out.resize(at + size);
+			copy(pos + sizeof(size), out.data() + at, size);
+			pos += sizeof(size) + size;
+		}
+		data.swap(out);
+		return true;
+	}
+
+	struct trace_event
+	{
+		std::int64_t time = 0;
+		std::uint32_t track = 0;
+		char phase = 0;
+		std::uint64_t id = 0;
+		std::string name;
+	};
+
+	// the trace events of all files, written by write_chrome
+	struct trace_log
+	{
+		std::vector<trace_event> events;
+		std::vector<std::string> tracks;
+	};
+
+	void put_json(std::ostream& out, const std::string& str)
+	{
+		out << '"';
+		for (char c : str)
+		{
+			if (c == '"' || c == '\\')
+				out << '\\' << c;
+			else if (static_cast<unsigned char>(c) < 0x20)
+				out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+			else
+				out << c;
+		}
+		out << '"';
+	}
+
+	void write_chrome(const trace_log& log, std::ostream& out)
+	{
+		std::int64_t first = 0;
+		for (const trace_event& ev : log.events)
+			if (first == 0 || ev.time < first)
+				first = ev.time;
+		out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		const char* sep = "\n";
+		for (std::size_t i = 0; i < log.tracks.size(); ++i)
+		{
+			out << sep << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i + 1 << ",\"args\":{\"name\":";
+			put_json(out, log.tracks[i]);
+			out << "}}";
+			sep = ",\n";
+		}
+		for (const trace_event& ev : log.events)
+		{
+			std::int64_t ns = ev.time - first;
+			out << sep << "{\"name\":";
+			put_json(out, ev.name);
+			out << ",\"ph\":\"" << ev.phase << "\",\"pid\":1,\"tid\":" << ev.track + 1 << ",\"ts\":" << ns / 1000 
+				<< '.' << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+			if (ev.phase == 'i')
+				out << ",\"s\":\"t\"";
+			else if (ev.phase == 's' || ev.phase == 'f')
+				out << ",\"cat\":\"flow\",\"id\":" << ev.id;
+			if (ev.phase == 'f')
+				out << ",\"bp\":\"e\"";
+			out << "}";
+			sep = ",\n";
+		}
+		out << "\n]}\n";
+	}
+
+	// same layout as debug::Log
+	std::string format_site(const site& s)
+	{
+		std::ostringstream out;
+		out << std::setw(80) << s.file << " : " << std::setw(6) << s.line << "   " << std::setw(15) << s.function;
+		return out.str();
+	}
+
+#ifdef ENH_LOG_ZSTD
+	// decompresses the whole zstd frames of data, dropping a last frame cut short
+	bool inflate(std::vector<char>& data, const std::vector<char>& dict)
+	{
+		ZSTD_DCtx* ctx = ZSTD_createDCtx();
+		if (!ctx)
+			return false;
+		if (!dict.empty())
+			ZSTD_DCtx_loadDictionary(ctx, dict.data(), dict.size());
+		std::vector<char> plain;
+		std::size_t whole = 0;
+		std::vector<char> chunk(ZSTD_DStreamOutSize());
+		ZSTD_inBuffer in{ data.data(), data.size(), 0 };
+		bool good = true;
+		while (in.pos < in.size)
+		{
+			ZSTD_outBuffer out{ chunk.data(), chunk.size(), 0 };
+			std::size_t left = ZSTD_decompressStream(ctx, &out, &in);
+			if (ZSTD_isError(left))
+			{
+				good = false;
+				break;
+			}
+			plain.insert(plain.end(), chunk.data(), chunk.data() + out.pos);
+			if (left == 0)
+				whole = plain.size();
+		}
+		ZSTD_freeDCtx(ctx);
+		plain.resize(whole);
+		data.swap(plain);
+		return good;
+	}
+#endif
+
+	// writes the records of the binary log in data to out, or only collects
+	// its trace events to trace if not null
+	bool decode_data(const char* path, const std::vector<char>& data, const options& opt, std::ostream& out, trace_log* trace)
+	{
+		const bool stamps = opt.stamps;
+		reader rd(data);
+		if (!rd.skip_magic())
+		{
+			std::cerr << path << " : not a binary log\n";
+			return false;
+		}
+		std::unordered_map<std::uint32_t, site> sites;
+		// calls the next record stands for, from a sample record
+		std::uint32_t weight = 1;
+		auto note_weight = [&weight](std::ostream& line) {
+			if (weight > 1)
+				line << "  [x " << weight << "]";
+			weight = 1;
+		};
+		while (!rd.done())
+		{
+			std::uint8_t tag = 0;
+			std::uint32_t id = 0;
+			std::int64_t time = 0;
+			bool good = rd.get(tag);
+			if (good && tag == tag_thread)
+			{
+				// a new run of the program, site ids start over
+				std::string thread, function;
+				good = rd.get_str(thread) && rd.get_str(function);
+				if (good && trace)
+				{
+					sites.clear();
+					trace->tracks.push_back(thread);
+				}
+				else if (good)
+				{
+					sites.clear();
+					out << "Thread id : " << thread << "\n\t\tthread first logging function " << function << "\n";
+				}
+			}
+			else if (good && tag == tag_site)
+			{
+				site s;
+				good = rd.get(id) && rd.get(s.line) && rd.get_str(s.file) && rd.get_str(s.function) && rd.get_str(s.var);
+				if (good)
+					sites[id] = std::move(s);
+			}
+			else if (good && tag == tag_sample)
+				good = rd.get(weight);
+			else if (good && tag == tag_text)
+			{
+				std::string line;
+				good = rd.get(time) && rd.get_str(line);
+				if (good && (!opt.in_window(time) || !opt.points.empty()))
+					weight = 1;
+				else if (good && !trace)
+				{
+					if (stamps)
+						out << time << " ";
+					out << line;
+					note_weight(out);
+					out << "\n";
+				}
+			}
+			else if (good && tag == tag_trace)
+			{
+				std::uint8_t phase = 0;
+				std::uint64_t flow = 0;
+				good = rd.get(id) && rd.get(time) && rd.get(phase) && rd.get(flow);
+				auto it = sites.find(id);
+				if (good && it == sites.end())
+				{
+					std::cerr << path << " : record for unknown site " << id << "\n";
+					return false;
+				}
+				if (good && (!opt.in_window(time) || !opt.matches(it->second)))
+					weight = 1;
+				else if (good && trace)
+				{
+					trace_event ev;
+					ev.time = time;
+					ev.track = trace->tracks.empty() ? 0 : static_cast<std::uint32_t>(trace->tracks.size() - 1);
+					ev.phase = static_cast<char>(phase);
+					ev.id = flow;
+					ev.name = it->second.var;
+					trace->events.push_back(std::move(ev));
+				}
+				else if (good)
+				{
+					if (stamps)
+						out << time << " ";
+					out << format_site(it->second) << " ::   trace " << static_cast<char>(phase) << " " 
+						<< it->second.var << " " << flow;
+					note_weight(out);
+					out << "\n";
+				}
+			}
+			else if (good && tag >= tag_line && tag <= tag_value)
+			{
+				good = rd.get(id) && rd.get(time);
+				auto it = sites.find(id);
+				if (good && it == sites.end())
+				{
+					std::cerr << path << " : record for unknown site " << id << "\n";
+					return false;
+				}
+				std::ostringstream line;
+				if (good)
+				{
+					if (stamps)
+						line << time << " ";
+					line << format_site(it->second);
+				}
+				if (good && tag == tag_desc)
+				{
+					std::string descr;
+					good = rd.get_str(descr);
+					line << " ::   " << descr;
+				}
+				else if (good && tag == tag_value)
+				{
+					std::uint8_t type = 0;
+					good = rd.get(type);
+					line << "  " << it->second.var << " = ";
+					if (good && type == value_string)
+					{
+						std::string val;
+						good = rd.get_str(val);
+						line << val;
+					}
+					else if (good && type == value_signed)
+					{
+						std::int64_t val = 0;
+						good = rd.get(val);
+						line << val;
+					}
+					else if (good && type == value_unsigned)
+					{
+						std::uint64_t val = 0;
+						good = rd.get(val);
+						line << val;
+					}
+					else if (good && type == value_floating)
+					{
+						double val = 0;
+						good = rd.get(val);
+						line << val;
+					}
+					else if (good && type == value_bool)
+					{
+						std::uint8_t val = 0;
+						good = rd.get(val);
+						line << (val ? 1 : 0);
+					}
+					else
+						good = false;
+				}
+				note_weight(line);
+				if (good && !trace && opt.in_window(time) && opt.matches(it->second))
+					out << line.str() << "\n";
+			}
+			else
+				good = false;
+			if (!good)
+			{
+				std::cerr << path << " : truncated or corrupt record\n";
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// reads path, inflating a compressed file and unwrapping a ring
+	bool load(const char* path, const options& opt, std::vector<char>& data)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+		{
+			std::cerr << path << " : cannot open\n";
+			return false;
+		}
+		data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		std::string_view name(path);
+		if (name.size() > 4 && name.substr(name.size() - 4) == ".zst")
+		{
+#ifdef ENH_LOG_ZSTD
+			if (!inflate(data, opt.dict))
+				std::cerr << path << " : corrupt zstd frame, reading the frames before it\n";
+#else
+			(void)opt;
+			std::cerr << path << " : compressed, build log_decoder with ENH_LOG_ZSTD\n";
+			return false;
+#endif
+		}
+		unwrap_ring(data);
+		return true;
+	}
+
+	bool decode(const char* path, const options& opt, std::ostream& out, trace_log* trace)
+	{
+		std::vector<char> data;
+		return load(path, opt, data) && decode_data(path, data, opt, out, trace);
+	}
+
+	// A file mapped read only, or read into memory where mmap is missing
+	class mapped_file
+	{
+		const char* bytes = nullptr;
+		std::size_t length = 0;
+#if defined(__unix__) || defined(__APPLE__)
+		void* map = nullptr;
+#endif
+		std::vector<char> copy;
+
+	public:
+		explicit mapped_file(const char* path)
+		{
+#if defined(__unix__) || defined(__APPLE__)
+			int fd = open(path, O_RDONLY);
+			if (fd < 0)
+				return;
+			struct stat info;
+			if (fstat(fd, &info) == 0 && info.st_size > 0)
+			{
+				map = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+				if (map == MAP_FAILED)
+					map = nullptr;
+				else
+				{
+					bytes = static_cast<const char*>(map);
+					length = static_cast<std::size_t>(info.st_size);
+				}
+			}
+			close(fd);
+#else
+			std::ifstream in(path, std::ios::binary);
+			copy.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+			bytes = copy.data();
+			length = copy.size();
+#endif
+		}
+
+		mapped_file(const mapped_file&) = delete;
+
+		~mapped_file()
+		{
+#if defined(__unix__) || defined(__APPLE__)
+			if (map)
+				munmap(map, length);
+#endif
+		}
+
+		const char* data() const { return bytes; }
+
+		std::size_t size() const { return length; }
+	};
+
+	enum index_kind : std::uint8_t { kind_run = 1, kind_site, kind_block };
+
+	struct index_block
+	{
+		std::uint64_t start = 0;
+		std::uint64_t end = 0;
+		std::int64_t first = 0;
+		std::int64_t last = 0;
+		std::size_t run = 0;
+		std::vector<std::uint32_t> sites;
+	};
+
+	struct index_run
+	{
+		std::uint64_t at = 0;
+		std::vector<std::uint64_t> siteRecords;
+	};
+
+	// reads the index of a binary log of size bytes, see the layout in logger.cpp
+	bool read_index(const std::string& path, std::uint64_t size, std::vector<index_run>& runs, std::vector<index_block>& blocks)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+			return false;
+		std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		reader rd(data);
+		if (!rd.skip_magic("ENHBIDX1"))
+			return false;
+		while (!rd.done())
+		{
+			std::uint8_t kind = 0;
+			bool good = rd.get(kind);
+			if (good && kind == kind_run)
+			{
+				index_run run;
+				good = rd.get(run.at);
+				if (good)
+					runs.push_back(std::move(run));
+			}
+			else if (good && kind == kind_site)
+			{
+				std::uint32_t id = 0;
+				std::uint64_t at = 0;
+				good = rd.get(id) && rd.get(at) && !runs.empty();
+				if (good)
+					runs.back().siteRecords.push_back(at);
+			}
+			else if (good && kind == kind_block)
+			{
+				index_block block;
+				std::uint32_t records = 0, count = 0;
+				good = rd.get(block.start) && rd.get(block.first) && rd.get(block.last) && rd.get(records)
+					&& rd.get(count) && !runs.empty();
+				for (std::uint32_t i = 0; good && i < count; ++i)
+				{
+					std::uint32_t id = 0;
+					good = rd.get(id);
+					block.sites.push_back(id);
+				}
+				block.run = runs.size() - 1;
+				if (good)
+					blocks.push_back(std::move(block));
+			}
+			else
+				good = false;
+			// an index cut short keeps the entries before
+			if (!good)
+				break;
+		}
+		// a run cut short before its first block, found by the times around it
+		for (std::size_t r = 0; r < runs.size(); ++r)
+		{
+			auto it = std::find_if(blocks.begin(), blocks.end(), [r](const index_block& b) { return b.run >= r; });
+			if (it != blocks.end() && it->run == r)
+				continue;
+			index_block block;
+			block.start = runs[r].at;
+			block.run = r;
+			block.first = block.last = it == blocks.begin() ? std::numeric_limits<std::int64_t>::min() : std::prev(it)->last;
+			blocks.insert(it, std::move(block));
+		}
+		// a block ends where the next block or run starts, the last at the end
+		for (std::size_t i = 0; i < blocks.size(); ++i)
+		{
+			std::uint64_t end = i + 1 < blocks.size() ? blocks[i + 1].start : size;
+			if (blocks[i].run + 1 < runs.size())
+				end = std::min(end, runs[blocks[i].run + 1].at);
+			blocks[i].end = std::min<std::uint64_t>(end, size);
+		}
+		// records after the last block are not indexed, its last time is open
+		if (!blocks.empty())
+			blocks.back().last = std::numeric_limits<std::int64_t>::max();
+		return !runs.empty();
+	}
+
+	// the size of the thread or site record at pos, 0 if it is not one
+	std::size_t record_size(const char* data, std::size_t size, std::uint64_t pos, record_tag tag)
+	{
+		if (pos >= size)
+			return 0;
+		reader rd(data, size, static_cast<std::size_t>(pos));
+		std::uint8_t got = 0;
+		std::uint32_t id = 0, line = 0;
+		std::string a, b, c;
+		bool good = rd.get(got) && got == tag;
+		if (good && tag == tag_thread)
+			good = rd.get_str(a) && rd.get_str(b);
+		else if (good)
+			good = rd.get(id) && rd.get(line) && rd.get_str(a) && rd.get_str(b) && rd.get_str(c);
+		return good ? rd.position() - static_cast<std::size_t>(pos) : 0;
+	}
+
+	// decodes the records of path in the window of opt, reading only the blocks
+	// its index places in the window (and holding the points asked for)
+	bool query(const char* path, const options& opt, std::ostream& out, trace_log* trace)
+	{
+		std::string_view name(path);
+		std::vector<index_run> runs;
+		std::vector<index_block> blocks;
+		mapped_file log(path);
+		if ((name.size() > 4 && name.substr(name.size() - 4) == ".zst") || log.size() < 8
+			|| !read_index(std::string(path) + ".idx", log.size(), runs, blocks))
+			return decode(path, opt, out, trace);
+		const char* data = log.data();
+		std::size_t size = log.size();
+		// the first block that may hold records at or after from
+		auto it = std::partition_point(blocks.begin(), blocks.end(),
+			[&opt](const index_block& b) { return b.last < opt.from; });
+		std::vector<char> picked(data, data + 8);
+		std::size_t run = runs.size();
+		std::vector<std::uint32_t> wanted;
+		for (; it != blocks.end() && it->first <= opt.until; ++it)
+		{
+			if (it->run != run)
+			{
+				// the thread record and every point described in the run
+				run = it->run;
+				std::size_t thread = record_size(data, size, runs[run].at, tag_thread);
+				if (thread == 0)
+				{
+					std::cerr << path << " : index does not match the file, decoding all of it\n";
+					return decode(path, opt, out, trace);
+				}
+				picked.insert(picked.end(), data + runs[run].at, data + runs[run].at + thread);
+				wanted.clear();
+				for (std::uint64_t at : runs[run].siteRecords)
+				{
+					std::size_t length = record_size(data, size, at, tag_site);
+					if (length == 0)
+						continue;
+					picked.insert(picked.end(), data + at, data + at + length);
+					site s;
+					std::uint32_t id = 0;
+					reader rd(data, size, static_cast<std::size_t>(at) + 1);
+					if (rd.get(id) && rd.get(s.line) && rd.get_str(s.file) && opt.matches(s))
+						wanted.push_back(id);
+				}
+			}
+			if (!opt.points.empty() && !it->sites.empty() && std::none_of(it->sites.begin(), it->sites.end(),
+				[&wanted](std::uint32_t id) { return std::find(wanted.begin(), wanted.end(), id) != wanted.end(); }))
+				continue;
+			std::uint64_t start = it->start;
+			if (start < size && (data[start] < tag_thread || data[start] > tag_sample))
+			{
+				std::cerr << path << " : index does not match the file, decoding all of it\n";
+				return decode(path, opt, out, trace);
+			}
+			// the thread record of a run is already in
+			if (start == runs[run].at)
+				start += record_size(data, size, start, tag_thread);
+			if (start < it->end)
+				picked.insert(picked.end(), data + start, data + it->end);
+		}
+		return decode_data(path, picked, opt, out, trace);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	options opt;
+	bool chrome = false;
+	bool good = true;
+	trace_log trace;
+	int files = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "-t") == 0)
+		{
+			opt.stamps = true;
+			continue;
+		}
+		if (std::strcmp(argv[i], "-c") == 0)
+		{
+			chrome = true;
+			continue;
+		}
+		if (std::strcmp(argv[i], "-D") == 0 && i + 1 < argc)
+		{
+			std::ifstream in(argv[++i], std::ios::binary);
+			if (!in)
+			{
+				std::cerr << argv[i] << " : cannot open\n";
+				return 2;
+			}
+			opt.dict.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+			continue;
+		}
+		if (std::strcmp(argv[i], "-q") == 0 && i + 2 < argc)
+		{
+			opt.query = true;
+			opt.from = std::strtoll(argv[i + 1], nullptr, 10);
+			opt.until = std::strtoll(argv[i + 2], nullptr, 10);
+			i += 2;
+			continue;
+		}
+		if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+		{
+			std::string_view at(argv[++i]);
+			std::size_t colon = at.rfind(':');
+			if (colon == std::string_view::npos)
+			{
+				std::cerr << at << " : expected file:line\n";
+				return 2;
+			}
+			opt.query = true;
+			opt.points.push_back({ std::string(at.substr(0, colon)),
+				static_cast<std::uint32_t>(std::strtoul(argv[i] + colon + 1, nullptr, 10)) });
+			continue;
+		}
+		++files;
+		good = (opt.query ? query(argv[i], opt, std::cout, chrome ? &trace : nullptr)
+			: decode(argv[i], opt, std::cout, chrome ? &trace : nullptr)) && good;
+	}
+	if (files == 0)
+	{
+		std::cerr << "usage : log_decoder [-t | -c] [-D dictionary] [-q from until] [-p file:line] "
+			"file.blog/.ring/.blog.zst...\n";
+		return 2;
+	}
+	if (chrome)
+		write_chrome(trace, std::cout);
+	return good ? 0 : 1;
+}